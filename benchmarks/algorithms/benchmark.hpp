@@ -0,0 +1,7 @@
+#pragma once
+#include <bench_runner.hpp>
+
+namespace benchmarks::algorithms {
+void run_ktl(runner& br);
+void run_std(runner& br);
+}  // namespace benchmarks::algorithms
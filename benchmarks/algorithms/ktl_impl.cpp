@@ -0,0 +1,133 @@
+#include "benchmark.hpp"
+
+#include <algorithm.hpp>
+#include <char_traits.hpp>
+#include <cpu_features.hpp>
+#include <crc32c.hpp>
+#include <hash.hpp>
+#include <vector.hpp>
+
+using namespace ktl;
+
+namespace benchmarks::algorithms {
+namespace details {
+using value_vector = vector<uint32_t>;
+using byte_vector = vector<uint8_t>;
+using text_vector = vector<char>;
+
+static constexpr implementation IMPL{implementation::ktl};
+
+static value_vector make_values(size_t size) {
+  random_generator gen;
+  value_vector values;
+  values.reserve(size);
+  for (size_t idx = 0; idx < size; ++idx) {
+    values.push_back(static_cast<uint32_t>(gen()));
+  }
+  return values;
+}
+
+// A null-terminated text ending with the only 'Z'
+static text_vector make_text(size_t size) {
+  random_generator gen;
+  text_vector text(size + 1);
+  fill_text(text.data(), size, gen);
+  text[size - 1] = 'Z';
+  text[size] = '\0';
+  return text;
+}
+
+static void run_hash_and_traits(runner& br, size_t size) {
+  const auto text{make_text(size)};
+  const auto other{text};
+  br.measure("hash_bytes", IMPL, size, [&] {
+    do_not_optimize(hash_bytes(text.data(), size));
+  });
+  br.measure("char_traits::length", IMPL, size, [&] {
+    do_not_optimize(char_traits<char>::length(text.data()));
+  });
+  br.measure("char_traits::find", IMPL, size, [&] {
+    do_not_optimize(char_traits<char>::find(text.data(), size, 'Z'));
+  });
+  br.measure("char_traits::compare", IMPL, size, [&] {
+    do_not_optimize(
+        char_traits<char>::compare(text.data(), other.data(), size));
+  });
+}
+
+// Both versions are measured: crc32c() runs the fastest one of the CPU
+static void run_checksums(runner& br, size_t size) {
+  random_generator gen;
+  byte_vector bytes(size);
+  for (auto& value : bytes) {
+    value = static_cast<uint8_t>(gen());
+  }
+  br.measure("crc32c_generic", IMPL, size, [&] {
+    do_not_optimize(crc::details::crc32c_generic(0, bytes.data(), size));
+  });
+  if (cpu::has<cpu_feature::sse42>()) {
+    br.measure("crc32c_sse42", IMPL, size, [&] {
+      do_not_optimize(crc::details::crc32c_sse42(0, bytes.data(), size));
+    });
+  }
+}
+
+static void run_non_modifying(runner& br, size_t size) {
+  auto values{make_values(size)};
+  values.back() = 0;  // The random values are almost never zero
+  const auto other{values};
+  br.measure("find", IMPL, size, [&] {
+    do_not_optimize(find(values.begin(), values.end(), 0u));
+  });
+  br.measure("equal", IMPL, size, [&] {
+    do_not_optimize(equal(values.begin(), values.end(), other.begin()));
+  });
+  byte_vector bytes(size);
+  for (size_t idx = 0; idx < size; ++idx) {
+    bytes[idx] = static_cast<uint8_t>(values[idx]);
+  }
+  auto greater_bytes{bytes};
+  ++greater_bytes.back();
+  br.measure("lexicographical_compare", IMPL, size, [&] {
+    do_not_optimize(lexicographical_compare(bytes.begin(), bytes.end(),
+                                            greater_bytes.begin(),
+                                            greater_bytes.end()));
+  });
+}
+
+static void run_modifying(runner& br, size_t size) {
+  auto values{make_values(size)};
+  value_vector dst(size);
+  br.measure("copy", IMPL, size, [&] {
+    do_not_optimize(copy(values.begin(), values.end(), dst.begin()));
+  });
+  br.measure("fill", IMPL, size, [&] {
+    fill(dst.begin(), dst.end(), 42u);
+    do_not_optimize(dst.data());
+  });
+  br.measure("reverse", IMPL, size, [&] {
+    reverse(values.begin(), values.end());
+    do_not_optimize(values.data());
+  });
+  br.measure("rotate", IMPL, size, [&] {
+    do_not_optimize(
+        rotate(values.begin(), values.begin() + size / 3, values.end()));
+  });
+  br.measure("transform", IMPL, size, [&] {
+    do_not_optimize(transform(values.begin(), values.end(), dst.begin(),
+                              [](uint32_t value) { return value * 3 + 1; }));
+  });
+}
+}  // namespace details
+
+void run_ktl(runner& br) {
+  using namespace details;
+
+  for (const auto size : SIZES) {
+    run_hash_and_traits(br, size);
+    run_checksums(br, size);
+    run_non_modifying(br, size);
+    run_modifying(br, size);
+  }
+}
+}  // namespace benchmarks::algorithms
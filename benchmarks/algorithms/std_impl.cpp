@@ -0,0 +1,113 @@
+#include "benchmark.hpp"
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace benchmarks::algorithms {
+namespace details {
+using value_vector = std::vector<uint32_t>;
+using byte_vector = std::vector<uint8_t>;
+using text_vector = std::vector<char>;
+
+static constexpr implementation IMPL{implementation::std};
+
+static value_vector make_values(size_t size) {
+  random_generator gen;
+  value_vector values;
+  values.reserve(size);
+  for (size_t idx = 0; idx < size; ++idx) {
+    values.push_back(static_cast<uint32_t>(gen()));
+  }
+  return values;
+}
+
+static text_vector make_text(size_t size) {
+  random_generator gen;
+  text_vector text(size + 1);
+  fill_text(text.data(), size, gen);
+  text[size - 1] = 'Z';
+  text[size] = '\0';
+  return text;
+}
+
+static void run_hash_and_traits(runner& br, size_t size) {
+  using traits_type = std::char_traits<char>;
+
+  const auto text{make_text(size)};
+  const auto other{text};
+  br.measure("hash_bytes", IMPL, size, [&] {
+    do_not_optimize(
+        std::hash<std::string_view>{}(std::string_view{text.data(), size}));
+  });
+  br.measure("char_traits::length", IMPL, size, [&] {
+    do_not_optimize(traits_type::length(text.data()));
+  });
+  br.measure("char_traits::find", IMPL, size, [&] {
+    do_not_optimize(traits_type::find(text.data(), size, 'Z'));
+  });
+  br.measure("char_traits::compare", IMPL, size, [&] {
+    do_not_optimize(traits_type::compare(text.data(), other.data(), size));
+  });
+}
+
+static void run_non_modifying(runner& br, size_t size) {
+  auto values{make_values(size)};
+  values.back() = 0;
+  const auto other{values};
+  br.measure("find", IMPL, size, [&] {
+    do_not_optimize(std::find(values.begin(), values.end(), 0u));
+  });
+  br.measure("equal", IMPL, size, [&] {
+    do_not_optimize(std::equal(values.begin(), values.end(), other.begin()));
+  });
+  byte_vector bytes(size);
+  for (size_t idx = 0; idx < size; ++idx) {
+    bytes[idx] = static_cast<uint8_t>(values[idx]);
+  }
+  auto greater_bytes{bytes};
+  ++greater_bytes.back();
+  br.measure("lexicographical_compare", IMPL, size, [&] {
+    do_not_optimize(std::lexicographical_compare(bytes.begin(), bytes.end(),
+                                                 greater_bytes.begin(),
+                                                 greater_bytes.end()));
+  });
+}
+
+static void run_modifying(runner& br, size_t size) {
+  auto values{make_values(size)};
+  value_vector dst(size);
+  br.measure("copy", IMPL, size, [&] {
+    do_not_optimize(std::copy(values.begin(), values.end(), dst.begin()));
+  });
+  br.measure("fill", IMPL, size, [&] {
+    std::fill(dst.begin(), dst.end(), 42u);
+    do_not_optimize(dst.data());
+  });
+  br.measure("reverse", IMPL, size, [&] {
+    std::reverse(values.begin(), values.end());
+    do_not_optimize(values.data());
+  });
+  br.measure("rotate", IMPL, size, [&] {
+    do_not_optimize(
+        std::rotate(values.begin(), values.begin() + size / 3, values.end()));
+  });
+  br.measure("transform", IMPL, size, [&] {
+    do_not_optimize(
+        std::transform(values.begin(), values.end(), dst.begin(),
+                       [](uint32_t value) { return value * 3 + 1; }));
+  });
+}
+}  // namespace details
+
+void run_std(runner& br) {
+  using namespace details;
+
+  for (const auto size : SIZES) {
+    run_hash_and_traits(br, size);
+    run_non_modifying(br, size);
+    run_modifying(br, size);
+  }
+}
+}  // namespace benchmarks::algorithms
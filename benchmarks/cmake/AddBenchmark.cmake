@@ -0,0 +1,58 @@
+# Redistribution and use is allowed under the MIT license.
+# Copyright (c) 2021 Dmitry Bolshakov. All rights reserved.
+
+# The benchmark cases are built as static libraries. The KTL_SOURCES are built
+# over KTL, the STD_SOURCES are the baselines built over the C++ standard
+# library of the host, so the same translation unit never includes both
+macro(KTL_ADD_BENCHMARK_IMPL BENCH_NAME RUNNER_NAME)
+	cmake_parse_arguments(KTL "" "" "KTL_SOURCES;STD_SOURCES" ${ARGN})
+	set(TARGET_NAME ${BENCH_NAME}_benchmark)
+
+	wdk_add_library(
+		${TARGET_NAME} STATIC
+			EXTENDED_CPP_FEATURES
+			WINVER ${TARGET_WINVER}
+			${KTL_UNPARSED_ARGUMENTS}
+			${KTL_KTL_SOURCES}
+			${KTL_STD_SOURCES}
+	)
+	add_library(benchmarks::${BENCH_NAME} ALIAS ${TARGET_NAME})
+
+	target_include_directories(
+		${TARGET_NAME} PUBLIC
+			${KTL_DIR}
+			${CMAKE_CURRENT_SOURCE_DIR}
+	)
+
+	set_source_files_properties(
+		${KTL_KTL_SOURCES} PROPERTIES
+			COMPILE_DEFINITIONS "KTL_NO_CXX_STANDARD_LIBRARY;${FMT_COMPILE_DEFINITIONS}"
+	)
+	# The definition comes with the interface of the runtime
+	set_source_files_properties(
+		${KTL_STD_SOURCES} PROPERTIES
+			COMPILE_OPTIONS -UKTL_NO_CXX_STANDARD_LIBRARY
+	)
+	target_compile_features(${TARGET_NAME} PRIVATE cxx_std_17)
+	# The measurements of the unoptimized code are useless
+	target_compile_options(
+		${TARGET_NAME} PRIVATE
+			${BASIC_COMPILE_OPTIONS}
+			${RELEASE_COMPILE_OPTIONS}
+			$<$<CONFIG:Release>:${LTO_COMPILE_OPTIONS}>
+	)
+	target_link_libraries(
+		${TARGET_NAME} PUBLIC
+			basic_runtime
+			cpp_runtime
+			${RUNNER_NAME}
+	)
+endmacro()
+
+function(ktl_add_benchmark bench_name)
+	KTL_ADD_BENCHMARK_IMPL(${bench_name} "" ${ARGN})
+endfunction()
+
+function(ktl_add_benchmark_with_runner bench_name)
+	KTL_ADD_BENCHMARK_IMPL(${bench_name} benchmarks::runner ${ARGN})
+endfunction()
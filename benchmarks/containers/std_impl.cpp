@@ -0,0 +1,131 @@
+#include "benchmark.hpp"
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace benchmarks::containers {
+namespace details {
+using value_vector = std::vector<uint64_t>;
+
+static constexpr implementation IMPL{implementation::std};
+static constexpr size_t CHUNK_SIZE{16};
+
+static value_vector make_keys(size_t size, uint64_t parity) {
+  random_generator gen;
+  value_vector keys;
+  keys.reserve(size);
+  for (size_t idx = 0; idx < size; ++idx) {
+    keys.push_back((gen() & ~uint64_t{1}) | parity);
+  }
+  return keys;
+}
+
+static std::string make_text(size_t size) {
+  random_generator gen;
+  std::string text(size, 'a');
+  fill_text(text.data(), size, gen);
+  text[size - 3] = 'X';
+  text[size - 2] = 'Y';
+  text[size - 1] = 'Z';
+  return text;
+}
+
+static void run_vector(runner& br, size_t size) {
+  const auto values{make_keys(size, 0)};
+  br.measure("vector::push_back", IMPL, size, [&] {
+    value_vector vec;
+    for (const auto value : values) {
+      vec.push_back(value);
+    }
+    do_not_optimize(vec.data());
+  });
+  br.measure("vector::copy", IMPL, size, [&] {
+    value_vector copy{values};
+    do_not_optimize(copy.data());
+  });
+  br.measure("vector::iterate", IMPL, size, [&] {
+    uint64_t sum{0};
+    for (const auto value : values) {
+      sum += value;
+    }
+    do_not_optimize(sum);
+  });
+}
+
+static void run_string(runner& br, size_t size) {
+  const auto text{make_text(size)};
+  br.measure("string::push_back", IMPL, size, [&] {
+    std::string str;
+    for (const char ch : text) {
+      str.push_back(ch);
+    }
+    do_not_optimize(str.data());
+  });
+  br.measure("string::append", IMPL, size, [&] {
+    std::string str;
+    for (size_t offset = 0; offset < size; offset += CHUNK_SIZE) {
+      str.append(text.data() + offset, CHUNK_SIZE);
+    }
+    do_not_optimize(str.data());
+  });
+  br.measure("string::find", IMPL, size, [&] {
+    do_not_optimize(text.find("XYZ", 0, 3));
+  });
+  const auto other{text};
+  br.measure("string::compare", IMPL, size, [&] {
+    do_not_optimize(text.compare(other));
+  });
+}
+
+static void run_unordered(runner& br, size_t size) {
+  const auto keys{make_keys(size, 0)};
+  const auto missing_keys{make_keys(size, 1)};
+  br.measure("unordered_map::insert", IMPL, size, [&] {
+    std::unordered_map<uint64_t, uint64_t> map;
+    for (const auto key : keys) {
+      map.emplace(key, key);
+    }
+    do_not_optimize(map.size());
+  });
+  std::unordered_map<uint64_t, uint64_t> map;
+  for (const auto key : keys) {
+    map.emplace(key, key);
+  }
+  br.measure("unordered_map::find_hit", IMPL, size, [&] {
+    size_t found{0};
+    for (const auto key : keys) {
+      found += map.find(key) != map.end();
+    }
+    do_not_optimize(found);
+  });
+  br.measure("unordered_map::find_miss", IMPL, size, [&] {
+    size_t found{0};
+    for (const auto key : missing_keys) {
+      found += map.find(key) != map.end();
+    }
+    do_not_optimize(found);
+  });
+  br.measure("unordered_set::insert", IMPL, size, [&] {
+    std::unordered_set<uint64_t> set;
+    for (const auto key : keys) {
+      set.insert(key);
+    }
+    do_not_optimize(set.size());
+  });
+}
+}  // namespace details
+
+void run_std(runner& br) {
+  using namespace details;
+
+  for (const auto size : SIZES) {
+    run_vector(br, size);
+    run_unordered(br, size);
+  }
+  for (const auto size : STRING_SIZES) {
+    run_string(br, size);
+  }
+}
+}  // namespace benchmarks::containers
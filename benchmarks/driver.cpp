@@ -0,0 +1,57 @@
+#include "algorithms/benchmark.hpp"
+#include "containers/benchmark.hpp"
+#include "locks/benchmark.hpp"
+#include "runner/bench_runner.hpp"
+#include "runner/report.hpp"
+
+#include <smart_pointer.hpp>
+#include <string_view.hpp>
+
+#include <ntddk.h>
+
+using namespace ktl;
+
+void RunBenchmarks();
+
+EXTERN_C NTSTATUS
+DriverEntry([[maybe_unused]] DRIVER_OBJECT* driver_object,
+            [[maybe_unused]] UNICODE_STRING* registry_path) noexcept {
+  try {
+    RunBenchmarks();
+  } catch (const exception& exc) {
+    DbgPrint("Unhandled exception caught: %s with code %x\n", exc.what(),
+             exc.code());
+    return exc.code();
+  }
+  return STATUS_SUCCESS;
+}
+
+void RunBenchmarks() {
+  using namespace benchmarks;
+
+  static constexpr auto JSON_REPORT_PATH{
+      L"\\SystemRoot\\Temp\\ktl_bench.json"_usv};
+  static constexpr auto CSV_REPORT_PATH{
+      L"\\SystemRoot\\Temp\\ktl_bench.csv"_usv};
+  static constexpr auto CONTENTION_CSV_REPORT_PATH{
+      L"\\SystemRoot\\Temp\\ktl_bench_contention.csv"_usv};
+
+  auto br{make_unique<runner>()};  // Too large for the stack
+
+  br->begin_suite("containers");
+  containers::run_ktl(*br);
+  containers::run_std(*br);
+
+  br->begin_suite("algorithms");
+  algorithms::run_ktl(*br);
+  algorithms::run_std(*br);
+
+  br->begin_suite("locks");
+  locks::run_ktl(*br);
+  locks::run_std(*br);
+
+  print_results(*br);
+  write_report(*br, JSON_REPORT_PATH, report_format::json);
+  write_report(*br, CSV_REPORT_PATH, report_format::csv);
+  write_report(*br, CONTENTION_CSV_REPORT_PATH, report_format::contention_csv);
+}
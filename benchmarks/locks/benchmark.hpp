@@ -0,0 +1,48 @@
+#pragma once
+#include <bench_runner.hpp>
+
+namespace benchmarks::locks {
+inline constexpr uint32_t THREAD_COUNTS[]{1, 2, 4, 8};
+inline constexpr uint32_t CRITICAL_SECTIONS[]{1, 16, 256};
+inline constexpr uint32_t READ_PERCENTS[]{0, 50, 90};
+
+// The exclusive locks are measured with the writers only
+inline constexpr uint32_t EXCLUSIVE_READ_PERCENTS[]{0};
+
+inline constexpr uint32_t MAX_THREAD_COUNT{8};
+inline constexpr uint64_t RUN_MS{20};
+
+// The counters of the threads don't share the cache lines
+struct alignas(64) thread_counter {
+  uint64_t acquisitions;
+  uint64_t writes;
+};
+
+/**
+ * @class shared_data
+ * @brief The data guarded by the lock: the writers increment the value in
+ * the critical section, the readers read it the same number of times
+ */
+class shared_data {
+ public:
+  void write(uint32_t critical_section) noexcept {
+    for (uint32_t idx = 0; idx < critical_section; ++idx) {
+      m_value = m_value + 1;
+    }
+  }
+
+  void read(uint32_t critical_section) const noexcept {
+    for (uint32_t idx = 0; idx < critical_section; ++idx) {
+      do_not_optimize(uint64_t{m_value});
+    }
+  }
+
+  [[nodiscard]] uint64_t get() const noexcept { return m_value; }
+
+ private:
+  volatile uint64_t m_value{0};
+};
+
+void run_ktl(runner& br);
+void run_std(runner& br);
+}  // namespace benchmarks::locks
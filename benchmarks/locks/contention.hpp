@@ -0,0 +1,124 @@
+#pragma once
+#include "benchmark.hpp"
+
+#include <atomic.hpp>
+#include <chrono.hpp>
+#include <mutex.hpp>
+#include <new_delete.hpp>
+#include <smart_pointer.hpp>
+#include <thread.hpp>
+
+/*
+ * The harness over KTL is shared by ktl_bench and the locks suite of
+ * ktl_test, so the hosted and the kernel locks are measured the same way
+ */
+namespace benchmarks::locks {
+// The readers take the lock exclusively
+template <class Mutex>
+class exclusive_case {
+ public:
+  void write(shared_data& data, uint32_t critical_section) {
+    ktl::lock_guard guard{m_mtx};
+    data.write(critical_section);
+  }
+
+  void read(shared_data& data, uint32_t critical_section) {
+    ktl::lock_guard guard{m_mtx};
+    data.read(critical_section);
+  }
+
+ private:
+  Mutex m_mtx;
+};
+
+template <class Mutex>
+class shared_case {
+ public:
+  void write(shared_data& data, uint32_t critical_section) {
+    ktl::lock_guard guard{m_mtx};
+    data.write(critical_section);
+  }
+
+  void read(shared_data& data, uint32_t critical_section) {
+    m_mtx.lock_shared();
+    data.read(critical_section);
+    m_mtx.unlock_shared();
+  }
+
+ private:
+  Mutex m_mtx;
+};
+
+struct contention_run {
+  uint64_t acquisitions[MAX_THREAD_COUNT];  // Of each thread
+  uint64_t elapsed_ns;
+  bool excluded;  // The writers have never overlapped
+};
+
+/**
+ * @fn run_contention
+ * @brief Runs params.thread_count threads taking the lock for the given
+ * time. Each thread reads with the probability of params.read_percent and
+ * writes otherwise
+ */
+template <class Case>
+contention_run run_contention(const contention_params& params,
+                              uint64_t run_ms = RUN_MS) {
+  using namespace ktl;
+
+  // The spin locks and ERESOURCE must be resident
+  unique_ptr<Case> target{new (non_paged_new) Case{}};
+  shared_data data;
+  thread_counter counters[MAX_THREAD_COUNT]{};
+  atomic<uint32_t> ready{0};
+  atomic<bool> started{false};
+  atomic<bool> stopped{false};
+
+  auto run{[&](uint32_t idx) {
+    random_generator gen{SEED + idx};
+    ready.fetch_add(1);
+    while (!started.load<memory_order_acquire>()) {
+      this_thread::yield();
+    }
+    uint64_t acquisitions{0};
+    uint64_t writes{0};
+    while (!stopped.load<memory_order_relaxed>()) {
+      if (params.read_percent && gen(100) < params.read_percent) {
+        target->read(data, params.critical_section);
+      } else {
+        target->write(data, params.critical_section);
+        ++writes;
+      }
+      ++acquisitions;
+    }
+    counters[idx] = {acquisitions, writes};
+  }};
+
+  system_thread threads[MAX_THREAD_COUNT];
+  for (uint32_t idx = 0; idx < params.thread_count; ++idx) {
+    threads[idx] = system_thread{run, idx};
+  }
+  while (ready.load<memory_order_acquire>() != params.thread_count) {
+    this_thread::yield();
+  }
+  const auto start{chrono::steady_clock::now()};
+  started.store<memory_order_release>(true);
+  this_thread::sleep_for(chrono::milliseconds{run_ms});
+  stopped.store<memory_order_relaxed>(true);
+  const auto elapsed{chrono::steady_clock::now() - start};
+  for (uint32_t idx = 0; idx < params.thread_count; ++idx) {
+    threads[idx].join();
+  }
+
+  contention_run result{};
+  result.elapsed_ns = static_cast<uint64_t>(
+      chrono::duration_cast<chrono::nanoseconds>(elapsed).count());
+  uint64_t writes{0};
+  for (uint32_t idx = 0; idx < params.thread_count; ++idx) {
+    result.acquisitions[idx] = counters[idx].acquisitions;
+    writes += counters[idx].writes;
+  }
+  result.excluded = data.get() == writes * params.critical_section;
+  return result;
+}
+}  // namespace benchmarks::locks
@@ -0,0 +1,46 @@
+#include "contention.hpp"
+
+using namespace ktl;
+
+namespace benchmarks::locks {
+namespace details {
+static constexpr implementation IMPL{implementation::ktl};
+
+// The benchmarks run over the hosted layer, which emulates the queued spin
+// locks as the plain spin locks and the push locks as CAS + sched_yield().
+// tests::locks measures the real kernel locks when ktl_test runs as a driver
+static constexpr bool EMULATED{true};
+
+template <class Case, size_t N>
+static void run_case(runner& br,
+                     const char* name,
+                     const uint32_t (&read_percents)[N]) {
+  for (const auto thread_count : THREAD_COUNTS) {
+    for (const auto critical_section : CRITICAL_SECTIONS) {
+      for (const auto read_percent : read_percents) {
+        const contention_params params{thread_count, critical_section,
+                                       read_percent};
+        const auto run{run_contention<Case>(params)};
+        br.add_contention(name, IMPL, EMULATED, params, run.acquisitions,
+                          run.elapsed_ns);
+      }
+    }
+  }
+}
+}  // namespace details
+
+void run_ktl(runner& br) {
+  using namespace details;
+
+  run_case<exclusive_case<spin_lock<>>>(br, "spin_lock",
+                                        EXCLUSIVE_READ_PERCENTS);
+  run_case<exclusive_case<queued_spin_lock<>>>(br, "queued_spin_lock",
+                                               EXCLUSIVE_READ_PERCENTS);
+  run_case<exclusive_case<fast_mutex>>(br, "fast_mutex",
+                                       EXCLUSIVE_READ_PERCENTS);
+  run_case<exclusive_case<recursive_mutex>>(br, "recursive_mutex",
+                                            EXCLUSIVE_READ_PERCENTS);
+  run_case<shared_case<push_lock>>(br, "push_lock", READ_PERCENTS);
+  run_case<shared_case<shared_mutex>>(br, "shared_mutex", READ_PERCENTS);
+}
+}  // namespace benchmarks::locks
@@ -0,0 +1,124 @@
+#include "benchmark.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+
+namespace benchmarks::locks {
+namespace details {
+static constexpr implementation IMPL{implementation::std};
+
+template <class Mutex>
+class exclusive_case {
+ public:
+  void write(shared_data& data, uint32_t critical_section) {
+    std::lock_guard guard{m_mtx};
+    data.write(critical_section);
+  }
+
+  void read(shared_data& data, uint32_t critical_section) {
+    std::lock_guard guard{m_mtx};
+    data.read(critical_section);
+  }
+
+ private:
+  Mutex m_mtx;
+};
+
+template <class Mutex>
+class shared_case {
+ public:
+  void write(shared_data& data, uint32_t critical_section) {
+    std::lock_guard guard{m_mtx};
+    data.write(critical_section);
+  }
+
+  void read(shared_data& data, uint32_t critical_section) {
+    std::shared_lock guard{m_mtx};
+    data.read(critical_section);
+  }
+
+ private:
+  Mutex m_mtx;
+};
+
+template <class Case>
+static void measure(runner& br,
+                    const char* name,
+                    const contention_params& params) {
+  auto target{std::make_unique<Case>()};
+  shared_data data;
+  thread_counter counters[MAX_THREAD_COUNT]{};
+  std::atomic<uint32_t> ready{0};
+  std::atomic<bool> started{false};
+  std::atomic<bool> stopped{false};
+
+  auto run{[&](uint32_t idx) {
+    random_generator gen{SEED + idx};
+    ready.fetch_add(1);
+    while (!started.load(std::memory_order_acquire)) {
+      std::this_thread::yield();
+    }
+    uint64_t acquisitions{0};
+    while (!stopped.load(std::memory_order_relaxed)) {
+      if (params.read_percent && gen(100) < params.read_percent) {
+        target->read(data, params.critical_section);
+      } else {
+        target->write(data, params.critical_section);
+      }
+      ++acquisitions;
+    }
+    counters[idx].acquisitions = acquisitions;
+  }};
+
+  std::thread threads[MAX_THREAD_COUNT];
+  for (uint32_t idx = 0; idx < params.thread_count; ++idx) {
+    threads[idx] = std::thread{run, idx};
+  }
+  while (ready.load(std::memory_order_acquire) != params.thread_count) {
+    std::this_thread::yield();
+  }
+  const uint64_t start{get_time_ns()};
+  started.store(true, std::memory_order_release);
+  std::this_thread::sleep_for(std::chrono::milliseconds{RUN_MS});
+  stopped.store(true, std::memory_order_relaxed);
+  const uint64_t elapsed{get_time_ns() - start};
+  for (uint32_t idx = 0; idx < params.thread_count; ++idx) {
+    threads[idx].join();
+  }
+
+  uint64_t acquisitions[MAX_THREAD_COUNT];
+  for (uint32_t idx = 0; idx < params.thread_count; ++idx) {
+    acquisitions[idx] = counters[idx].acquisitions;
+  }
+  br.add_contention(name, IMPL, false, params, acquisitions, elapsed);
+}
+
+template <class Case, size_t N>
+static void run_case(runner& br,
+                     const char* name,
+                     const uint32_t (&read_percents)[N]) {
+  for (const auto thread_count : THREAD_COUNTS) {
+    for (const auto critical_section : CRITICAL_SECTIONS) {
+      for (const auto read_percent : read_percents) {
+        measure<Case>(br, name, {thread_count, critical_section, read_percent});
+      }
+    }
+  }
+}
+}  // namespace details
+
+// The host has no spin locks or push locks, so the blocking mutexes only
+void run_std(runner& br) {
+  using namespace details;
+
+  run_case<exclusive_case<std::mutex>>(br, "mutex", EXCLUSIVE_READ_PERCENTS);
+  run_case<exclusive_case<std::recursive_mutex>>(br, "recursive_mutex",
+                                                 EXCLUSIVE_READ_PERCENTS);
+  run_case<shared_case<std::shared_mutex>>(br, "shared_mutex",
+                                           READ_PERCENTS);
+}
+}  // namespace benchmarks::locks
@@ -0,0 +1,250 @@
+#include "bench_runner.hpp"
+#include "report.hpp"
+
+#include <algorithm.hpp>
+#include <chrono.hpp>
+#include <ktlexcept.hpp>
+#include <vector.hpp>
+
+#include <modules/fmt/compile.hpp>
+
+#include <ntddk.h>
+
+using namespace ktl;
+
+namespace benchmarks {
+namespace details {
+using text_buffer = vector<char, basic_paged_allocator<char> >;
+
+static const char* get_name(implementation impl) noexcept {
+  return impl == implementation::ktl ? "ktl" : "std";
+}
+
+// The floating point isn't used, so the time is formatted as a fixed point
+struct fixed_point {
+  uint64_t integral;
+  uint64_t fractional;  // Thousandths
+};
+
+static fixed_point get_ns_per_op(uint64_t batch_ns, uint64_t ops) noexcept {
+  const uint64_t ps{batch_ns * 1000 / ops};
+  return {ps / 1000, ps % 1000};
+}
+
+static uint64_t get_square_root(uint64_t value) noexcept {
+  uint64_t root{0};
+  uint64_t bit{uint64_t{1} << 62};
+  while (bit > value) {
+    bit >>= 2;
+  }
+  for (; bit; bit >>= 2) {
+    if (value >= root + bit) {
+      value -= root + bit;
+      root = (root >> 1) + bit;
+    } else {
+      root >>= 1;
+    }
+  }
+  return root;
+}
+
+static void append_json(text_buffer& buffer, const runner& br) {
+  auto out{back_inserter(buffer)};
+  out = format_to(out, FMT_COMPILE("{{\n  \"seed\": {},\n  \"results\": ["),
+                  SEED);
+  bool first{true};
+  // The names are identifiers, so they aren't escaped
+  for (const auto& res : br) {
+    const auto median{get_ns_per_op(res.median_ns, res.ops_per_batch)};
+    const auto fastest{get_ns_per_op(res.min_ns, res.ops_per_batch)};
+    out = format_to(
+        out,
+        FMT_COMPILE("{}\n    {{\"suite\": \"{}\", \"name\": \"{}\", "
+                    "\"impl\": \"{}\", \"size\": {}, \"ops_per_batch\": {}, "
+                    "\"ns_per_op\": {}.{:03}, \"min_ns_per_op\": {}.{:03}}}"),
+        first ? "" : ",", res.suite, res.name, get_name(res.impl), res.size,
+        res.ops_per_batch, median.integral, median.fractional,
+        fastest.integral, fastest.fractional);
+    first = false;
+  }
+  out = format_to(out, FMT_COMPILE("\n  ],\n  \"contention\": ["));
+  first = true;
+  for (const auto& res : br.contention_results()) {
+    out = format_to(
+        out,
+        FMT_COMPILE("{}\n    {{\"suite\": \"{}\", \"name\": \"{}\", "
+                    "\"impl\": \"{}\", \"emulated\": {}, \"threads\": {}, "
+                    "\"critical_section\": {}, \"read_percent\": {}, "
+                    "\"acquisitions_per_sec\": {}, \"min_acquisitions\": {}, "
+                    "\"max_acquisitions\": {}, \"variation_per_mille\": {}}}"),
+        first ? "" : ",", res.suite, res.name, get_name(res.impl),
+        res.emulated, res.params.thread_count, res.params.critical_section,
+        res.params.read_percent, res.acquisitions_per_sec,
+        res.min_acquisitions, res.max_acquisitions, res.variation_per_mille);
+    first = false;
+  }
+  format_to(out, FMT_COMPILE("\n  ]\n}}\n"));
+}
+
+static void append_csv(text_buffer& buffer, const runner& br) {
+  auto out{back_inserter(buffer)};
+  out = format_to(out, FMT_COMPILE("suite,name,impl,size,ops_per_batch,"
+                                   "ns_per_op,min_ns_per_op\n"));
+  for (const auto& res : br) {
+    const auto median{get_ns_per_op(res.median_ns, res.ops_per_batch)};
+    const auto fastest{get_ns_per_op(res.min_ns, res.ops_per_batch)};
+    out = format_to(out, FMT_COMPILE("{},{},{},{},{},{}.{:03},{}.{:03}\n"),
+                    res.suite, res.name, get_name(res.impl), res.size,
+                    res.ops_per_batch, median.integral, median.fractional,
+                    fastest.integral, fastest.fractional);
+  }
+}
+
+static void append_contention_csv(text_buffer& buffer, const runner& br) {
+  auto out{back_inserter(buffer)};
+  out = format_to(out, FMT_COMPILE("suite,name,impl,emulated,threads,"
+                                   "critical_section,"
+                                   "read_percent,acquisitions_per_sec,"
+                                   "min_acquisitions,max_acquisitions,"
+                                   "variation_per_mille\n"));
+  for (const auto& res : br.contention_results()) {
+    out = format_to(out, FMT_COMPILE("{},{},{},{},{},{},{},{},{},{},{}\n"),
+                    res.suite, res.name, get_name(res.impl), res.emulated,
+                    res.params.thread_count, res.params.critical_section,
+                    res.params.read_percent, res.acquisitions_per_sec,
+                    res.min_acquisitions, res.max_acquisitions,
+                    res.variation_per_mille);
+  }
+}
+
+static NTSTATUS write_file(unicode_string_view path,
+                           const text_buffer& buffer) noexcept {
+  OBJECT_ATTRIBUTES attributes;
+  InitializeObjectAttributes(
+      addressof(attributes), const_cast<UNICODE_STRING*>(path.raw_str()),
+      OBJ_KERNEL_HANDLE | OBJ_CASE_INSENSITIVE, nullptr, nullptr);
+  HANDLE file;
+  IO_STATUS_BLOCK io_status;
+  NTSTATUS status{ZwCreateFile(
+      addressof(file), FILE_WRITE_DATA | SYNCHRONIZE, addressof(attributes),
+      addressof(io_status), nullptr, FILE_ATTRIBUTE_NORMAL, 0,
+      FILE_OVERWRITE_IF,
+      FILE_NON_DIRECTORY_FILE | FILE_SYNCHRONOUS_IO_NONALERT, nullptr, 0)};
+  if (!NT_SUCCESS(status)) {
+    return status;
+  }
+  status = ZwWriteFile(file, nullptr, nullptr, nullptr, addressof(io_status),
+                       const_cast<char*>(buffer.data()),
+                       static_cast<ULONG>(buffer.size()), nullptr, nullptr);
+  ZwClose(file);
+  return status;
+}
+}  // namespace details
+
+uint64_t get_time_ns() noexcept {
+  const auto now{chrono::steady_clock::now().time_since_epoch()};
+  return static_cast<uint64_t>(
+      chrono::duration_cast<chrono::nanoseconds>(now).count());
+}
+
+void runner::add(const char* name,
+                 implementation impl,
+                 size_t size,
+                 uint64_t ops,
+                 uint64_t (&batches)[BATCH_COUNT]) noexcept {
+  if (m_count == MAX_RESULT_COUNT) {
+    DbgPrint("*** Too many results, %s is dropped\n", name);
+    return;
+  }
+  for (size_t idx = 1; idx < BATCH_COUNT; ++idx) {
+    const uint64_t elapsed{batches[idx]};
+    size_t pos{idx};
+    for (; pos > 0 && batches[pos - 1] > elapsed; --pos) {
+      batches[pos] = batches[pos - 1];
+    }
+    batches[pos] = elapsed;
+  }
+  m_results[m_count++] = {m_suite, name, impl, size, ops,
+                          batches[BATCH_COUNT / 2], batches[0]};
+}
+
+void runner::add_contention(const char* name,
+                            implementation impl,
+                            bool emulated,
+                            const contention_params& params,
+                            const uint64_t* acquisitions,
+                            uint64_t elapsed_ns) noexcept {
+  if (m_contention_count == MAX_CONTENTION_RESULT_COUNT) {
+    DbgPrint("*** Too many contention results, %s is dropped\n", name);
+    return;
+  }
+  const uint32_t thread_count{params.thread_count};
+  uint64_t total{0};
+  uint64_t min_acquisitions{~uint64_t{0}};
+  uint64_t max_acquisitions{0};
+  for (uint32_t idx = 0; idx < thread_count; ++idx) {
+    const uint64_t count{acquisitions[idx]};
+    total += count;
+    min_acquisitions = (min)(min_acquisitions, count);
+    max_acquisitions = (max)(max_acquisitions, count);
+  }
+  const uint64_t mean{total / thread_count};
+  uint64_t squared_deviations{0};
+  for (uint32_t idx = 0; idx < thread_count; ++idx) {
+    const uint64_t count{acquisitions[idx]};
+    const uint64_t deviation{count > mean ? count - mean : mean - count};
+    squared_deviations += deviation * deviation;
+  }
+  const uint64_t deviation{
+      details::get_square_root(squared_deviations / thread_count)};
+  m_contention_results[m_contention_count++] = {
+      m_suite,
+      name,
+      impl,
+      emulated,
+      params,
+      elapsed_ns ? total * 1'000'000'000 / elapsed_ns : 0,
+      min_acquisitions,
+      max_acquisitions,
+      mean ? deviation * 1000 / mean : 0};
+}
+
+void write_report(const runner& br,
+                  unicode_string_view path,
+                  report_format format) {
+  details::text_buffer buffer;
+  if (format == report_format::json) {
+    details::append_json(buffer, br);
+  } else if (format == report_format::csv) {
+    details::append_csv(buffer, br);
+  } else {
+    details::append_contention_csv(buffer, br);
+  }
+  const NTSTATUS status{details::write_file(path, buffer)};
+  throw_exception_if_not<kernel_error>(NT_SUCCESS(status), status,
+                                       "unable to write the report");
+}
+
+void print_results(const runner& br) noexcept {
+  for (const auto& res : br) {
+    const auto median{
+        details::get_ns_per_op(res.median_ns, res.ops_per_batch)};
+    DbgPrint("%s %s/%llu [%s]: %llu.%03llu ns per op\n", res.suite, res.name,
+             static_cast<unsigned long long>(res.size),
+             details::get_name(res.impl),
+             static_cast<unsigned long long>(median.integral),
+             static_cast<unsigned long long>(median.fractional));
+  }
+  for (const auto& res : br.contention_results()) {
+    DbgPrint(
+        "%s %s/%u threads/%u iterations/%u%% reads [%s%s]: "
+        "%llu acquisitions per second, %llu.%llu%% variation\n",
+        res.suite, res.name, res.params.thread_count,
+        res.params.critical_section, res.params.read_percent,
+        details::get_name(res.impl), res.emulated ? ", emulated" : "",
+        static_cast<unsigned long long>(res.acquisitions_per_sec),
+        static_cast<unsigned long long>(res.variation_per_mille / 10),
+        static_cast<unsigned long long>(res.variation_per_mille % 10));
+  }
+}
+}  // namespace benchmarks
@@ -0,0 +1,200 @@
+#pragma once
+#include <basic_types.hpp>
+
+/*
+ * The runner is shared by the cases built over KTL and the baselines built
+ * over the C++ standard library, so nothing but the basic types is used here
+ */
+namespace benchmarks {
+enum class implementation { ktl, std };
+
+// The data of every run is the same, so the results of the commits compare
+inline constexpr uint64_t SEED{0x9E3779B97F4A7C15ull};
+
+inline constexpr size_t SIZES[]{16, 256, 4096, 65536};
+
+// The length of the native strings is limited by USHORT
+inline constexpr size_t STRING_SIZES[]{16, 256, 4096};
+
+/**
+ * @class random_generator
+ * @brief SplitMix64 generator, gives the same sequence on every platform
+ */
+class random_generator {
+ public:
+  explicit constexpr random_generator(uint64_t seed = SEED) noexcept
+      : m_state{seed} {}
+
+  constexpr uint64_t operator()() noexcept {
+    uint64_t value{m_state += 0x9E3779B97F4A7C15ull};
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+  }
+
+  constexpr uint64_t operator()(uint64_t bound) noexcept {
+    return (*this)() % bound;
+  }
+
+ private:
+  uint64_t m_state;
+};
+
+// Lowercase letters, so an uppercase one may be used as a unique marker
+inline void fill_text(char* first, size_t count, random_generator& gen) {
+  for (size_t idx = 0; idx < count; ++idx) {
+    first[idx] = static_cast<char>('a' + gen(26));
+  }
+}
+
+/**
+ * @fn do_not_optimize
+ * @brief Makes the compiler believe that the value is used
+ */
+template <class Ty>
+inline void do_not_optimize(const Ty& value) noexcept {
+#if defined(__GNUC__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static_cast<void>(*reinterpret_cast<const volatile char*>(&value));
+#endif
+}
+
+struct result {
+  const char* suite;
+  const char* name;
+  implementation impl;
+  size_t size;
+  uint64_t ops_per_batch;
+  uint64_t median_ns;  // Of a batch
+  uint64_t min_ns;
+};
+
+struct contention_params {
+  uint32_t thread_count;
+  uint32_t critical_section;  // Iterations under the lock
+  uint32_t read_percent;      // Of the acquisitions in the shared mode
+};
+
+/**
+ * @brief Acquisitions of a lock by the concurrent threads during a run. The
+ * unfairness is the coefficient of variation of the per-thread acquisitions:
+ * zero if every thread has got the lock equally often
+ */
+struct contention_result {
+  const char* suite;
+  const char* name;
+  implementation impl;
+  bool emulated;  // The lock is emulated by the hosted platform layer
+  contention_params params;
+  uint64_t acquisitions_per_sec;
+  uint64_t min_acquisitions;  // Of a thread
+  uint64_t max_acquisitions;
+  uint64_t variation_per_mille;
+};
+
+template <class Ty>
+class result_range {
+ public:
+  constexpr result_range(const Ty* first, const Ty* last) noexcept
+      : m_first{first}, m_last{last} {}
+
+  [[nodiscard]] constexpr const Ty* begin() const noexcept { return m_first; }
+  [[nodiscard]] constexpr const Ty* end() const noexcept { return m_last; }
+
+ private:
+  const Ty* m_first;
+  const Ty* m_last;
+};
+
+uint64_t get_time_ns() noexcept;
+
+class runner {
+ public:
+  static constexpr size_t MAX_RESULT_COUNT{512};
+  static constexpr size_t MAX_CONTENTION_RESULT_COUNT{256};
+  static constexpr size_t BATCH_COUNT{7};
+  static constexpr uint64_t MIN_BATCH_NS{5'000'000};
+  static constexpr uint64_t MAX_OPS_PER_BATCH{uint64_t{1} << 30};
+
+ public:
+  runner() noexcept = default;
+  runner(const runner&) = delete;
+  runner& operator=(const runner&) = delete;
+  ~runner() noexcept = default;
+
+  void begin_suite(const char* name) noexcept { m_suite = name; }
+
+  /**
+   * @fn runner::measure
+   * @brief Calls fn() in the batches lasting MIN_BATCH_NS at least and
+   * records the median and the fastest batch
+   */
+  template <class Fn>
+  void measure(const char* name, implementation impl, size_t size, Fn&& fn) {
+    const uint64_t ops{calibrate(fn)};
+    uint64_t batches[BATCH_COUNT];
+    for (auto& elapsed : batches) {
+      elapsed = run_batch(fn, ops);
+    }
+    add(name, impl, size, ops, batches);
+  }
+
+  [[nodiscard]] const result* begin() const noexcept { return m_results; }
+  [[nodiscard]] const result* end() const noexcept {
+    return m_results + m_count;
+  }
+  [[nodiscard]] size_t size() const noexcept { return m_count; }
+
+  /**
+   * @fn runner::add_contention
+   * @brief Records a run of params.thread_count threads lasting elapsed_ns
+   * with the given number of the acquisitions made by each thread. The
+   * emulated results don't describe the kernel locks and are labeled so
+   */
+  void add_contention(const char* name,
+                      implementation impl,
+                      bool emulated,
+                      const contention_params& params,
+                      const uint64_t* acquisitions,
+                      uint64_t elapsed_ns) noexcept;
+
+  [[nodiscard]] result_range<contention_result> contention_results()
+      const noexcept {
+    return {m_contention_results,
+            m_contention_results + m_contention_count};
+  }
+
+ private:
+  template <class Fn>
+  static uint64_t run_batch(Fn& fn, uint64_t ops) {
+    const uint64_t start{get_time_ns()};
+    for (uint64_t idx = 0; idx < ops; ++idx) {
+      fn();
+    }
+    return get_time_ns() - start;
+  }
+
+  template <class Fn>
+  static uint64_t calibrate(Fn& fn) {
+    uint64_t ops{1};
+    while (ops < MAX_OPS_PER_BATCH && run_batch(fn, ops) < MIN_BATCH_NS) {
+      ops *= 2;
+    }
+    return ops;
+  }
+
+  void add(const char* name,
+           implementation impl,
+           size_t size,
+           uint64_t ops,
+           uint64_t (&batches)[BATCH_COUNT]) noexcept;
+
+ private:
+  const char* m_suite{""};
+  result m_results[MAX_RESULT_COUNT]{};
+  size_t m_count{0};
+  contention_result m_contention_results[MAX_CONTENTION_RESULT_COUNT]{};
+  size_t m_contention_count{0};
+};
+}  // namespace benchmarks
@@ -0,0 +1,21 @@
+#pragma once
+#include "bench_runner.hpp"
+
+#include <string_view.hpp>
+
+namespace benchmarks {
+// The CSV reports hold the timings and the contention results separately
+enum class report_format { json, csv, contention_csv };
+
+/**
+ * @fn write_report
+ * @brief Writes the results to the file replacing it
+ * @throw kernel_error if the file can't be written, bad_alloc
+ */
+void write_report(const runner& br,
+                  ktl::unicode_string_view path,
+                  report_format format);
+
+// Human-readable results for the debug output
+void print_results(const runner& br) noexcept;
+}  // namespace benchmarks
@@ -9,6 +9,7 @@ using std::allocator_traits;
 }  // namespace ktl
 #else
 #include <heap.hpp>
+#include <limits_impl.hpp>
 #include <memory_impl.hpp>
 #include <memory_type_traits.hpp>
 #include <new_delete.hpp>
@@ -316,6 +317,144 @@ struct allocator_traits {
   static void in_place_destroy(pointer ptr) { destroy_at(ptr); }
 };
 
+struct allocation_counters {
+  size_t allocation_count{0};
+  size_t deallocation_count{0};
+  size_t allocated_bytes{0};
+  size_t deallocated_bytes{0};
+
+  [[nodiscard]] constexpr size_t get_live_bytes() const noexcept {
+    return allocated_bytes - deallocated_bytes;
+  }
+};
+
+/**
+ * @class counting_allocator
+ * @brief Forwards the requests to Alloc and counts them into the counters
+ * shared by all of the copies. The counters aren't synchronized; a default
+ * constructed allocator (e.g. the one a node-based unordered container
+ * creates on copying) counts nothing
+ */
+template <class Alloc>
+class counting_allocator {
+  using allocator_traits_type = allocator_traits<Alloc>;
+
+ public:
+  using allocator_type = Alloc;
+  using value_type = typename allocator_traits_type::value_type;
+  using pointer = typename allocator_traits_type::pointer;
+  using size_type = typename allocator_traits_type::size_type;
+  using difference_type = typename allocator_traits_type::difference_type;
+  using propagate_on_container_copy_assignment = true_type;
+  using propagate_on_container_move_assignment = true_type;
+  using propagate_on_container_swap = true_type;
+  using is_always_equal = false_type;
+  using enable_delete_null = typename allocator_traits_type::enable_delete_null;
+
+ public:
+  constexpr counting_allocator() = default;
+
+  template <class OtherAlloc = Alloc>
+  constexpr explicit counting_allocator(
+      allocation_counters& counters,
+      OtherAlloc&& alloc =
+          OtherAlloc{}) noexcept(is_nothrow_constructible_v<Alloc,
+                                                            OtherAlloc>)
+      : m_alc{forward<OtherAlloc>(alloc)}, m_counters{addressof(counters)} {}
+
+  pointer allocate(size_type object_count) {
+    pointer ptr{allocator_traits_type::allocate(m_alc, object_count)};
+    on_allocation(object_count * sizeof(value_type));
+    return ptr;
+  }
+
+  template <class OtherAlloc = Alloc,
+            enable_if_t<mm::details::has_allocate_single_object_v<OtherAlloc>,
+                        int> = 0>
+  pointer allocate() {
+    pointer ptr{allocator_traits_type::allocate_single_object(m_alc)};
+    on_allocation(sizeof(value_type));
+    return ptr;
+  }
+
+  pointer allocate_bytes(size_type bytes_count) {
+    pointer ptr{allocator_traits_type::allocate_bytes(m_alc, bytes_count)};
+    on_allocation(bytes_count);
+    return ptr;
+  }
+
+  void deallocate(pointer ptr, size_type object_count) noexcept {
+    on_deallocation(ptr, object_count * sizeof(value_type));
+    allocator_traits_type::deallocate(m_alc, ptr, object_count);
+  }
+
+  template <class OtherAlloc = Alloc,
+            enable_if_t<mm::details::has_deallocate_single_object_v<OtherAlloc,
+                                                                     pointer>,
+                        int> = 0>
+  void deallocate(pointer ptr) noexcept {
+    on_deallocation(ptr, sizeof(value_type));
+    allocator_traits_type::deallocate_single_object(m_alc, ptr);
+  }
+
+  void deallocate_bytes(pointer ptr, size_type bytes_count) noexcept {
+    on_deallocation(ptr, bytes_count);
+    allocator_traits_type::deallocate_bytes(m_alc, ptr, bytes_count);
+  }
+
+  void swap(counting_allocator& other) noexcept {
+    using ktl::swap;
+    swap(m_alc, other.m_alc);
+    swap(m_counters, other.m_counters);
+  }
+
+  [[nodiscard]] constexpr const allocator_type& get_allocator() const noexcept {
+    return m_alc;
+  }
+
+  [[nodiscard]] constexpr allocation_counters* get_counters() const noexcept {
+    return m_counters;
+  }
+
+ private:
+  void on_allocation(size_t bytes_count) noexcept {
+    if (m_counters) {
+      ++m_counters->allocation_count;
+      m_counters->allocated_bytes += bytes_count;
+    }
+  }
+
+  void on_deallocation(pointer ptr, size_t bytes_count) noexcept {
+    if (m_counters && ptr) {  // Deleting nullptr isn't counted
+      ++m_counters->deallocation_count;
+      m_counters->deallocated_bytes += bytes_count;
+    }
+  }
+
+ private:
+  Alloc m_alc{};
+  allocation_counters* m_counters{nullptr};
+};
+
+template <class Alloc>
+constexpr bool operator==(const counting_allocator<Alloc>& lhs,
+                          const counting_allocator<Alloc>& rhs) noexcept {
+  return lhs.get_counters() == rhs.get_counters() &&
+         lhs.get_allocator() == rhs.get_allocator();
+}
+
+template <class Alloc>
+constexpr bool operator!=(const counting_allocator<Alloc>& lhs,
+                          const counting_allocator<Alloc>& rhs) noexcept {
+  return !(lhs == rhs);
+}
+
+template <class Alloc>
+void swap(counting_allocator<Alloc>& lhs,
+          counting_allocator<Alloc>& rhs) noexcept {
+  lhs.swap(rhs);
+}
+
 namespace alc::details {
 template <class Allocator>
 constexpr bool allocators_are_equal(
@@ -0,0 +1,127 @@
+#pragma once
+#include <algorithm.hpp>
+#include <basic_types.hpp>
+#include <span.hpp>
+
+#ifdef KTL_COROUTINES
+#include <coroutine.hpp>
+#endif
+
+#include <ntddk.h>
+
+namespace ktl {
+struct io_result {
+  NTSTATUS status;
+  size_t transferred;
+};
+
+namespace io::details {
+enum class io_direction { read, write };
+
+// Enough for IO_WORKITEM: IoSizeofWorkItem() is checked on submission
+inline constexpr size_t WORK_ITEM_STORAGE_SIZE{16 * sizeof(void*)};
+
+struct io_request {
+  using resume_fn = void (*)(void* context) noexcept;
+
+  FILE_OBJECT* file;
+  uint64_t offset;
+  void* buffer;
+  uint32_t size;
+  io_direction direction;
+  io_result result;
+  resume_fn on_resume;
+  void* context;
+  // Initialized by submit(), so the completion needs no allocation
+  alignas(void*) byte work_item[WORK_ITEM_STORAGE_SIZE];
+};
+
+/**
+ * @fn submit
+ * @brief Sends the request to the file system in an IRP completed without an
+ * APC. When the IRP completes, on_resume is called on a system worker thread
+ * @return false if the request has failed at once and on_resume won't be
+ * called; the result is set
+ */
+bool submit(io_request& request) noexcept;
+}  // namespace io::details
+
+#ifdef KTL_COROUTINES
+/**
+ * @class io_operation
+ * @brief Awaitable read or write of the file. The awaiting coroutine is
+ * resumed on a system worker thread once the I/O completes, so the thread
+ * which has started it is free to issue more requests meanwhile
+ */
+class [[nodiscard]] io_operation : non_relocatable {
+ public:
+  io_operation(io::details::io_direction direction,
+               FILE_OBJECT* file,
+               uint64_t offset,
+               void* buffer,
+               size_t size) noexcept
+      : m_request{file,
+                  offset,
+                  buffer,
+                  static_cast<uint32_t>(size),
+                  direction,
+                  {},
+                  &resume,
+                  nullptr,
+                  {}} {}
+
+  [[nodiscard]] bool await_ready() const noexcept {
+    return m_request.size == 0;
+  }
+
+  bool await_suspend(coroutine_handle<> awaiting) noexcept {
+    m_request.context = awaiting.address();
+    // The coroutine may be resumed on another thread before submit() returns
+    return io::details::submit(m_request);
+  }
+
+  [[nodiscard]] io_result await_resume() const noexcept {
+    return m_request.size == 0 ? io_result{STATUS_SUCCESS, 0}
+                               : m_request.result;
+  }
+
+ private:
+  static void resume(void* context) noexcept {
+    coroutine_handle<>::from_address(context).resume();
+  }
+
+ private:
+  io::details::io_request m_request;
+};
+
+/**
+ * @fn async_read
+ * @param[in] file File object opened for the asynchronous I/O, i.e. without
+ * FILE_SYNCHRONOUS_IO_ALERT and FILE_SYNCHRONOUS_IO_NONALERT
+ * @param[in] buffer Non-paged memory alive until the operation completes.
+ * Up to 4 GiB - 1 bytes are transferred at once
+ * @return Awaitable producing the status and the number of bytes read.
+ * Reads beyond the end of the file end with STATUS_END_OF_FILE
+ */
+inline io_operation async_read(FILE_OBJECT* file,
+                               uint64_t offset,
+                               span<byte> buffer) noexcept {
+  return {io::details::io_direction::read, file, offset, buffer.data(),
+          (min)(buffer.size(), size_t{MAXULONG})};
+}
+
+/**
+ * @fn async_write
+ * @param[in] file File object opened for the asynchronous I/O
+ * @param[in] buffer Non-paged memory alive until the operation completes
+ * @return Awaitable producing the status and the number of bytes written
+ */
+inline io_operation async_write(FILE_OBJECT* file,
+                                uint64_t offset,
+                                span<const byte> buffer) noexcept {
+  return {io::details::io_direction::write, file, offset,
+          const_cast<byte*>(buffer.data()),
+          (min)(buffer.size(), size_t{MAXULONG})};
+}
+#endif
+}  // namespace ktl
@@ -90,9 +90,9 @@ inline void atomic_thread_fence<memory_order_relaxed>() noexcept {}
 
 template <>
 inline void atomic_thread_fence<memory_order_seq_cst>() noexcept {
-  volatile long guard;  // Not initialized to avoid an unnecessary operation;
+  volatile LONG guard;  // Not initialized to avoid an unnecessary operation;
   [[maybe_unused]] auto value{
-      InterlockedIncrement(atomic_address_as<long>(guard))};
+      InterlockedIncrement(atomic_address_as<LONG>(guard))};
 }
 
 EXTERN_C inline void atomic_thread_fence(const memory_order order) noexcept {
@@ -160,18 +160,20 @@ struct load_memory_order_checker<memory_order::acq_rel>
 
 template <memory_order on_success, memory_order on_failure>
 [[nodiscard]] constexpr memory_order combine_cas_memory_orders() noexcept {
-  // Finds upper bound of a compare/exchange memory order
-  // pair, according to the following partial order:
-  //     seq_cst
-  //        |
-  //     acq_rel
-  //     /     \
-  // acquire  release
-  //    |       |
-  // consume    |
-  //     \     /
-  //     relaxed
-  static constexpr memory_order COMBINED[6][6] = {
+  /*
+   * Finds upper bound of a compare/exchange memory order
+   * pair, according to the following partial order:
+   *     seq_cst
+   *        |
+   *     acq_rel
+   *     /     \
+   * acquire  release
+   *    |       |
+   * consume    |
+   *     \     /
+   *     relaxed
+   */
+  constexpr memory_order COMBINED[6][6] = {
       {memory_order_relaxed, memory_order_consume, memory_order_acquire,
        memory_order_release, memory_order_acq_rel, memory_order_seq_cst},
       {memory_order_consume, memory_order_consume, memory_order_acquire,
@@ -186,7 +188,7 @@ template <memory_order on_success, memory_order on_failure>
        memory_order_seq_cst, memory_order_seq_cst, memory_order_seq_cst}};
 
   // We don't need check on_success
-  load_memory_order_checker<on_failure> mem_order_checker{};
+  [[maybe_unused]] load_memory_order_checker<on_failure> mem_order_checker{};
   return COMBINED[static_cast<underlying_type_t<memory_order>>(on_success)]
                  [static_cast<underlying_type_t<memory_order>>(on_failure)];
 }
@@ -207,7 +209,7 @@ template <class IntegralTy, class Ty>
 
 template <memory_order order>
 void make_load_barrier() noexcept {
-  load_memory_order_checker<order> mem_order_checker{};
+  [[maybe_unused]] load_memory_order_checker<order> mem_order_checker{};
   if constexpr (order != memory_order::relaxed) {
     KeMemoryBarrierWithoutFence();
   }
@@ -215,7 +217,7 @@ void make_load_barrier() noexcept {
 
 template <memory_order order>
 void make_store_barrier() noexcept {
-  store_memory_order_checker<order> mem_order_checker{};
+  [[maybe_unused]] store_memory_order_checker<order> mem_order_checker{};
   if constexpr (order != memory_order::relaxed) {
     KeMemoryBarrierWithoutFence();
   }
@@ -341,7 +343,7 @@ class interlocked_storage {
 
   template <memory_order order = memory_order_seq_cst>
   void store(const value_type value) noexcept {
-    if constexpr (is_same_v<order, memory_order_seq_cst>) {
+    if constexpr (order == memory_order_seq_cst) {
       [[maybe_unused]] auto old_value{exchange(value)};
     } else {
       const auto source{atomic_reinterpret_as<internal_value_type>(value)};
@@ -396,15 +398,15 @@ struct interlocked_policy;
 
 template <>
 struct interlocked_policy<32> {
-  using value_type = long;
+  using value_type = LONG;
 
-  static long exchange(volatile long* place, long new_value) noexcept {
+  static LONG exchange(volatile LONG* place, LONG new_value) noexcept {
     return InterlockedExchange(place, new_value);
   }
 
-  static long compare_exchange_strong(volatile long* place,
-                                      long desired,
-                                      long expected) noexcept {
+  static LONG compare_exchange_strong(volatile LONG* place,
+                                      LONG desired,
+                                      LONG expected) noexcept {
     return InterlockedCompareExchange(place, desired, expected);
   }
 };
@@ -416,13 +418,13 @@ struct interlocked_policy<32> {
                                                                               \
     static type exchange(volatile type* place,                                \
                          value_type new_value) noexcept {                     \
-      return InterlockedExchange##bitness##(place, new_value);                \
+      return InterlockedExchange##bitness(place, new_value);                  \
     }                                                                         \
                                                                               \
     static type compare_exchange_strong(volatile type* place,                 \
                                         type desired,                         \
                                         type expected) noexcept {             \
-      return InterlockedCompareExchange##bitness##(place, desired, expected); \
+      return InterlockedCompareExchange##bitness(place, desired, expected);   \
     }                                                                         \
   };
 
@@ -474,7 +476,7 @@ class interlocked_integral : public atomic_storage<Ty> {
 
   template <memory_order order = memory_order_seq_cst>
   value_type fetch_add(const value_type operand) noexcept {
-    return static_cast<value_type>(IntegralPolicy::add(
+    return static_cast<value_type>(IntegralPolicy::add_op(
         get_storage(), static_cast<internal_value_type>(operand)));
   }
 
@@ -525,37 +527,37 @@ struct integral_policy;
 
 template <>
 struct integral_policy<32> {
-  using value_type = long;
+  using value_type = LONG;
 
-  static long add_op(volatile long* addend, long value) noexcept {
+  static LONG add_op(volatile LONG* addend, LONG value) noexcept {
     return InterlockedAdd(addend, value) - value;
   }
 
-  static long and_op(volatile long* place, long value) noexcept {
+  static LONG and_op(volatile LONG* place, LONG value) noexcept {
     return InterlockedAnd(place, value);
   }
 
-  static long or_op(volatile long* place, long value) noexcept {
+  static LONG or_op(volatile LONG* place, LONG value) noexcept {
     return InterlockedOr(place, value);
   }
 
-  static long xor_op(volatile long* place, long value) noexcept {
+  static LONG xor_op(volatile LONG* place, LONG value) noexcept {
     return InterlockedXor(place, value);
   }
 
-  static long pre_increment(volatile long* addend) noexcept {
+  static LONG pre_increment(volatile LONG* addend) noexcept {
     return InterlockedIncrement(addend);
   }
 
-  static long post_increment(volatile long* addend) noexcept {
+  static LONG post_increment(volatile LONG* addend) noexcept {
     return InterlockedIncrement(addend) - 1;
   }
 
-  static long pre_decrement(volatile long* addend) noexcept {
+  static LONG pre_decrement(volatile LONG* addend) noexcept {
     return InterlockedDecrement(addend);
   }
 
-  static long post_decrement(volatile long* addend) noexcept {
+  static LONG post_decrement(volatile LONG* addend) noexcept {
     return InterlockedDecrement(addend) + 1;
   }
 };
@@ -565,7 +567,7 @@ struct integral_policy<32> {
   struct integral_policy<bitness> {                                 \
     using value_type = type;                                        \
                                                                     \
-    static type add(volatile type* addend, type value) noexcept {   \
+    static type add_op(volatile type* addend, type value) noexcept {\
       return InterlockedAdd##bitness(addend, value) - value;        \
     }                                                               \
                                                                     \
@@ -797,7 +799,7 @@ struct atomic_pointer : integral_storage<Ty, sizeof(uintptr_t)> {
 
   template <memory_order order = memory_order_seq_cst>
   Ty fetch_add(const ptrdiff_t offset) noexcept {
-    return reinterpret_cast<Ty>(MyBase::fetch_add<order>(offset));
+    return reinterpret_cast<Ty>(MyBase::template fetch_add<order>(offset));
   }
 
   Ty fetch_add(const ptrdiff_t offset) volatile noexcept {
@@ -914,7 +916,7 @@ class atomic : public atomic_base_t<Ty>,
   using MyBase::MyBase;
 
   [[nodiscard]] bool is_lock_free() const volatile noexcept {
-    return is_always_lock_free_v<Ty>;
+    return th::details::is_always_lock_free_v<Ty>;
   }
 
   [[nodiscard]] bool is_lock_free() const noexcept {
@@ -939,7 +941,7 @@ class atomic : public atomic_base_t<Ty>,
 
   template <memory_order order>
   void store(const Ty value) volatile noexcept {
-    const_cast<atomic*>(this)->MyBase::store<order>(value);
+    const_cast<atomic*>(this)->MyBase::template store<order>(value);
   }
 
   using MyBase::load;
@@ -949,7 +951,7 @@ class atomic : public atomic_base_t<Ty>,
 
   template <memory_order order>
   [[nodiscard]] Ty load() const volatile noexcept {
-    return const_cast<const atomic*>(this)->MyBase::load<order>();
+    return const_cast<const atomic*>(this)->MyBase::template load<order>();
   }
 
   using MyBase::exchange;
@@ -959,7 +961,7 @@ class atomic : public atomic_base_t<Ty>,
 
   template <memory_order order>
   Ty exchange(const Ty value) volatile noexcept {
-    return const_cast<atomic*>(this)->MyBase::exchange<order>(value);
+    return const_cast<atomic*>(this)->MyBase::template exchange<order>(value);
   }
 
   using MyBase::compare_exchange_strong;
@@ -973,20 +975,22 @@ class atomic : public atomic_base_t<Ty>,
   template <memory_order order>
   bool compare_exchange_strong(Ty& expected,
                                const Ty desired) volatile noexcept {
-    return const_cast<atomic*>(this)->MyBase::compare_exchange_strong<order>(
-        expected, desired);
+    return const_cast<atomic*>(this)
+        ->MyBase::template compare_exchange_strong<order>(expected, desired);
   }
 
   template <memory_order on_success, memory_order on_failure>
   bool compare_exchange_strong(Ty& expected,
                                const Ty desired) volatile noexcept {
-    return MyBase::compare_exchange_strong<
+    using th::details::combine_cas_memory_orders;
+    return MyBase::template compare_exchange_strong<
         combine_cas_memory_orders<on_success, on_failure>()>(expected, desired);
   }
 
   template <memory_order on_success, memory_order on_failure>
   bool compare_exchange_strong(Ty& expected, const Ty desired) noexcept {
-    return MyBase::compare_exchange_strong<
+    using th::details::combine_cas_memory_orders;
+    return MyBase::template compare_exchange_strong<
         combine_cas_memory_orders<on_success, on_failure>()>(expected, desired);
   }
 
@@ -1003,23 +1007,25 @@ class atomic : public atomic_base_t<Ty>,
 
   template <memory_order order>
   bool compare_exchange_weak(Ty& expected, const Ty desired) volatile noexcept {
-    return MyBase::compare_exchange_strong<order>(expected, desired);
+    return MyBase::template compare_exchange_strong<order>(expected, desired);
   }
 
   template <memory_order order>
   bool compare_exchange_weak(Ty& expected, const Ty desired) noexcept {
-    return MyBase::compare_exchange_strong<order>(expected, desired);
+    return MyBase::template compare_exchange_strong<order>(expected, desired);
   }
 
   template <memory_order on_success, memory_order on_failure>
   bool compare_exchange_weak(Ty& expected, const Ty desired) volatile noexcept {
-    return MyBase::compare_exchange_strong<
+    using th::details::combine_cas_memory_orders;
+    return MyBase::template compare_exchange_strong<
         combine_cas_memory_orders<on_success, on_failure>()>(expected, desired);
   }
 
   template <memory_order on_success, memory_order on_failure>
   bool compare_exchange_weak(Ty& expected, const Ty desired) noexcept {
-    return MyBase::compare_exchange_strong<
+    using th::details::combine_cas_memory_orders;
+    return MyBase::template compare_exchange_strong<
         combine_cas_memory_orders<on_success, on_failure>()>(expected, desired);
   }
 
@@ -0,0 +1,230 @@
+#pragma once
+#include <allocator.hpp>
+#include <atomic.hpp>
+#include <basic_types.hpp>
+#include <io_buffer_pool.hpp>
+#include <smart_pointer.hpp>
+#include <span.hpp>
+#include <utility.hpp>
+#include <vector.hpp>
+
+namespace ktl {
+namespace mm::details {
+struct slice_storage {
+  using destroy_fn = void (*)(slice_storage*) noexcept;
+
+  atomic<uint32_t> refs{1};
+  destroy_fn destroy;
+};
+
+inline void intrusive_ptr_add_ref(slice_storage* storage) noexcept {
+  storage->refs.fetch_add<memory_order_relaxed>(1);
+}
+
+inline void intrusive_ptr_release(slice_storage* storage) noexcept {
+  if (storage->refs.fetch_sub(1) == 1) {
+    storage->destroy(storage);
+  }
+}
+}  // namespace mm::details
+
+/**
+ * @class buffer_slice
+ * @brief Range of bytes in the reference-counted storage. Copies of the slice
+ * and its subslices share the storage, which is freed with the last of them
+ */
+class buffer_slice {
+ public:
+  buffer_slice() noexcept = default;
+
+  /**
+   * @fn buffer_slice::allocate
+   * @brief Allocates the storage from the non-paged pool. Its content may be
+   * filled with writable_data() until the slice is copied
+   * @throw bad_alloc
+   */
+  static buffer_slice allocate(size_t size);
+
+  /**
+   * @fn buffer_slice::copy_of
+   * @throw bad_alloc
+   */
+  static buffer_slice copy_of(span<const byte> data);
+
+  /**
+   * @fn buffer_slice::borrow
+   * @brief Refers to the memory without owning it. The memory must outlive
+   * all of the slices and chains referring to it
+   */
+  static buffer_slice borrow(span<const byte> data) noexcept {
+    return buffer_slice{nullptr, data.data(), data.size()};
+  }
+
+  /**
+   * @fn buffer_slice::adopt
+   * @brief Takes the buffer of io_buffer_pool, which is returned to the pool
+   * with the last slice referring to it
+   * @param[in] buffer Non-empty buffer
+   * @param[in] size Bytes in use from the beginning of the buffer
+   * @throw bad_alloc
+   */
+  static buffer_slice adopt(io_buffer&& buffer, size_t size);
+
+  [[nodiscard]] span<const byte> data() const noexcept {
+    return {m_data, m_size};
+  }
+
+  /**
+   * @fn buffer_slice::writable_data
+   * @return Content of the slice which owns its storage exclusively
+   */
+  [[nodiscard]] span<byte> writable_data() const noexcept {
+    assert(is_unique());
+    return {const_cast<byte*>(m_data), m_size};
+  }
+
+  [[nodiscard]] size_t size() const noexcept { return m_size; }
+  [[nodiscard]] bool empty() const noexcept { return m_size == 0; }
+
+  /**
+   * @fn buffer_slice::is_unique
+   * @return true if no other slice shares the storage
+   */
+  [[nodiscard]] bool is_unique() const noexcept {
+    return m_storage && m_storage->refs.load<memory_order_acquire>() == 1;
+  }
+
+  [[nodiscard]] buffer_slice subslice(
+      size_t offset,
+      size_t count = static_cast<size_t>(-1)) const noexcept {
+    assert(offset <= m_size);
+    const size_t available{m_size - offset};
+    return buffer_slice{m_storage, m_data + offset,
+                        count < available ? count : available};
+  }
+
+  void remove_prefix(size_t count) noexcept {
+    assert(count <= m_size);
+    m_data += count;
+    m_size -= count;
+  }
+
+  void remove_suffix(size_t count) noexcept {
+    assert(count <= m_size);
+    m_size -= count;
+  }
+
+ private:
+  using storage_ptr = intrusive_ptr<mm::details::slice_storage>;
+
+  buffer_slice(storage_ptr storage, const byte* data, size_t size) noexcept
+      : m_storage{move(storage)}, m_data{data}, m_size{size} {}
+
+ private:
+  storage_ptr m_storage;
+  const byte* m_data{nullptr};
+  size_t m_size{0};
+};
+
+/**
+ * @class buffer_chain
+ * @brief Sequence of slices forming a single message without copying them
+ * into a contiguous buffer
+ * @details A message is composed of the slices of its parts, e.g. a header,
+ * a path and a payload, and is copied to the destination once with copy_to().
+ * Checksums are computed over the segments with for_each_segment(). The
+ * segments are merged only on demand with coalesce().
+ */
+class buffer_chain {
+ public:
+  using segment_list =
+      vector<buffer_slice, basic_non_paged_allocator<buffer_slice> >;
+
+ public:
+  buffer_chain() noexcept = default;
+  explicit buffer_chain(buffer_slice slice) { append(move(slice)); }
+
+  /**
+   * @fn buffer_chain::append
+   * @brief Adds the bytes to the end. Empty slices are skipped
+   * @throw bad_alloc
+   */
+  void append(buffer_slice slice);
+  void append(buffer_chain&& other);
+
+  /**
+   * @fn buffer_chain::prepend
+   * @brief Adds the bytes to the beginning, e.g. a header built after the
+   * payload. Empty slices are skipped
+   * @throw bad_alloc
+   */
+  void prepend(buffer_slice slice);
+  void prepend(buffer_chain&& other);
+
+  /**
+   * @fn buffer_chain::split
+   * @brief Detaches the leading bytes. The segment containing the boundary is
+   * shared by both chains
+   * @param[in] offset Number of bytes to detach
+   * @return Chain of the detached bytes
+   * @throw out_of_range if offset is greater than size(), bad_alloc
+   */
+  buffer_chain split(size_t offset);
+
+  /**
+   * @fn buffer_chain::coalesce
+   * @brief Merges the segments into a newly allocated one unless there is
+   * only one segment already
+   * @return Contiguous content of the chain
+   * @throw bad_alloc
+   */
+  span<const byte> coalesce();
+
+  /**
+   * @fn buffer_chain::copy_to
+   * @param[out] destination Receives the bytes starting at offset
+   * @param[in] offset Position in the chain
+   * @return Number of the bytes copied, which is less than the size of
+   * destination if the chain ends earlier
+   */
+  size_t copy_to(span<byte> destination, size_t offset = 0) const noexcept;
+
+  /**
+   * @fn buffer_chain::hash
+   * @return FNV-1a hash of the content, which doesn't depend on how the bytes
+   * are split into the segments
+   */
+  [[nodiscard]] uint64_t hash() const noexcept;
+
+  /**
+   * @fn buffer_chain::for_each_segment
+   * @brief Passes each segment as span<const byte> in order
+   */
+  template <class Fn>
+  void for_each_segment(Fn&& fn) const {
+    for (const auto& segment : m_segments) {
+      fn(segment.data());
+    }
+  }
+
+  [[nodiscard]] size_t size() const noexcept { return m_size; }
+  [[nodiscard]] bool empty() const noexcept { return m_size == 0; }
+
+  [[nodiscard]] size_t segment_count() const noexcept {
+    return m_segments.size();
+  }
+
+  [[nodiscard]] const segment_list& segments() const noexcept {
+    return m_segments;
+  }
+
+  void clear() noexcept {
+    m_segments.clear();
+    m_size = 0;
+  }
+
+ private:
+  segment_list m_segments;
+  size_t m_size{0};
+};
+}  // namespace ktl
@@ -0,0 +1,293 @@
+#pragma once
+#include <atomic.hpp>
+#include <basic_types.hpp>
+#include <heap.hpp>
+#include <memory.hpp>
+#include <mutex.hpp>
+#include <per_cpu.hpp>
+
+#include <ntddk.h>
+
+namespace ktl {
+namespace cb::details {
+/**
+ * @class reader_epoch
+ * @brief Sleepable read-side critical sections with two alternating epochs
+ * @details Readers count their entries and exits in the per-processor
+ * counters of the current epoch, and synchronize() waits until every reader
+ * which may have seen the old data has left. The entries and exits are
+ * counted separately, since a reader below DISPATCH_LEVEL may exit on
+ * another processor
+ */
+class reader_epoch : non_relocatable {
+ public:
+  reader_epoch() = default;
+
+  /**
+   * @fn reader_epoch::lock
+   * @return Epoch index to pass to unlock(). May be called at any IRQL
+   */
+  uint32_t lock() noexcept {
+    const uint32_t idx{m_epoch.load<memory_order_relaxed>() & 1};
+    // Full barrier: the data is read after the entry is counted
+    m_counters.local().entries[idx].fetch_add(1);
+    return idx;
+  }
+
+  void unlock(uint32_t idx) noexcept {
+    m_counters.local().exits[idx].fetch_add(1);
+  }
+
+  /**
+   * @fn reader_epoch::synchronize
+   * @brief Waits for the readers which have entered before the call. Must be
+   * called at IRQL <= APC_LEVEL, not concurrently with itself and not from
+   * within a read-side critical section
+   */
+  void synchronize() noexcept;
+
+ private:
+  struct counters {
+    counters() noexcept {
+      for (uint32_t idx = 0; idx < 2; ++idx) {
+        entries[idx].store<memory_order_relaxed>(0);
+        exits[idx].store<memory_order_relaxed>(0);
+      }
+    }
+
+    atomic<uint64_t> entries[2];
+    atomic<uint64_t> exits[2];
+  };
+
+  bool has_readers(uint32_t idx) const noexcept;
+  void wait_for_readers(uint32_t idx) const noexcept;
+
+ private:
+  per_cpu<counters> m_counters;
+  atomic<uint32_t> m_epoch{0};
+};
+}  // namespace cb::details
+
+template <class Sig>
+class callback_list;
+
+/**
+ * @class callback_list
+ * @brief Observers notified in the order of their registration, e.g. the
+ * modules interested in the process, thread and image notifications
+ * @details invoke() takes no locks and allocates nothing: it iterates over an
+ * immutable array published by the last add() or remove(). These copy the
+ * array under a mutex, publish the new one and free the old one after the
+ * readers which may still see it have left, so remove() also guarantees that
+ * the callback isn't running anymore. invoke() may be called at IRQL <=
+ * DISPATCH_LEVEL, the callbacks run at the IRQL of the caller
+ */
+template <class... Args>
+class callback_list<void(Args...)> : non_relocatable {
+ public:
+  using callback_type = void (*)(void* context, Args...);
+  using cookie_type = uint64_t;
+
+ private:
+  struct entry {
+    entry(callback_type fn, void* ctx, cookie_type id) noexcept
+        : callback{fn}, context{ctx}, cookie{id} {}
+
+    callback_type callback;
+    void* context;
+    cookie_type cookie;
+    atomic<bool> removed{false};  // When a smaller array can't be allocated
+  };
+
+  struct snapshot {
+    size_t size;
+    size_t capacity;
+
+    entry* begin() noexcept { return reinterpret_cast<entry*>(this + 1); }
+    entry* end() noexcept { return begin() + size; }
+  };
+
+  static_assert(sizeof(snapshot) % alignof(entry) == 0);
+
+  class read_guard : non_relocatable {
+   public:
+    explicit read_guard(cb::details::reader_epoch& epoch) noexcept
+        : m_epoch{epoch}, m_idx{epoch.lock()} {}
+    ~read_guard() noexcept { m_epoch.unlock(m_idx); }
+
+   private:
+    cb::details::reader_epoch& m_epoch;
+    uint32_t m_idx;
+  };
+
+ public:
+  callback_list() = default;
+
+  /**
+   * @fn callback_list::~callback_list
+   * @brief Must not be called concurrently with invoke()
+   */
+  ~callback_list() noexcept {
+    if (auto* current = m_current.template load<memory_order_relaxed>();
+        current) {
+      free_snapshot(current);
+    }
+  }
+
+  /**
+   * @fn callback_list::add
+   * @brief Must be called at IRQL <= APC_LEVEL and not from the callbacks
+   * @return Cookie which identifies the registration in remove()
+   * @throw bad_alloc
+   */
+  cookie_type add(callback_type callback, void* context = nullptr) {
+    lock_guard guard{m_lock};
+    auto* current{m_current.template load<memory_order_relaxed>()};
+    auto* next{allocate_snapshot<OnAllocationFailure::ThrowException>(
+        m_size.load<memory_order_relaxed>() + 1)};
+    entry* last{copy_alive(current, next)};
+    const cookie_type cookie{++m_last_cookie};
+    construct_at(last, callback, context, cookie);
+    ++next->size;
+    replace(current, next);
+    return cookie;
+  }
+
+  /**
+   * @fn callback_list::add
+   * @brief Registers the observer which is called as observer(args...). It
+   * must outlive the registration
+   */
+  template <class Ty>
+  cookie_type add(Ty& observer) {
+    return add(
+        [](void* context, Args... args) {
+          (*static_cast<Ty*>(context))(args...);
+        },
+        addressof(observer));
+  }
+
+  /**
+   * @fn callback_list::remove
+   * @brief Must be called at IRQL <= APC_LEVEL and not from the callbacks.
+   * The callback won't be called once it returns, even if the memory is
+   * low
+   * @return false if the cookie isn't registered
+   */
+  bool remove(cookie_type cookie) noexcept {
+    lock_guard guard{m_lock};
+    auto* current{m_current.template load<memory_order_relaxed>()};
+    entry* target{find_alive(current, cookie)};
+    if (!target) {
+      return false;
+    }
+    target->removed.template store<memory_order_relaxed>(true);
+    const size_t alive{m_size.load<memory_order_relaxed>() - 1};
+    if (alive == 0) {
+      replace(current, nullptr);
+    } else if (auto* next =
+                   allocate_snapshot<OnAllocationFailure::DoNothing>(alive);
+               next) {
+      copy_alive(current, next);
+      replace(current, next);
+    } else {
+      // The entry is skipped by the new readers and stays in the array
+      m_size.store<memory_order_relaxed>(alive);
+      m_epoch.synchronize();
+    }
+    return true;
+  }
+
+  /**
+   * @fn callback_list::invoke
+   * @brief Calls every callback registered when the iteration reaches it
+   */
+  void invoke(Args... args) {
+    read_guard guard{m_epoch};
+    auto* current{m_current.template load<memory_order_acquire>()};
+    if (!current) {
+      return;
+    }
+    for (auto& target : *current) {
+      if (!target.removed.template load<memory_order_relaxed>()) {
+        target.callback(target.context, args...);
+      }
+    }
+  }
+
+  [[nodiscard]] size_t size() const noexcept {
+    return m_size.load<memory_order_relaxed>();
+  }
+
+  [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+ private:
+  template <OnAllocationFailure OnFailure>
+  static snapshot* allocate_snapshot(size_t capacity) noexcept(
+      OnFailure != OnAllocationFailure::ThrowException) {
+    auto* target{static_cast<snapshot*>(allocate_memory<OnFailure>(
+        alloc_request_builder{get_snapshot_size(capacity), NonPagedPool}
+            .set_pool_tag(crt::DEFAULT_HEAP_TAG)
+            .build()))};
+    if (target) {
+      target->size = 0;
+      target->capacity = capacity;
+    }
+    return target;
+  }
+
+  static void free_snapshot(snapshot* target) noexcept {
+    const size_t bytes{get_snapshot_size(target->capacity)};
+    deallocate_memory(free_request_builder{target, bytes}
+                          .set_pool_tag(crt::DEFAULT_HEAP_TAG)
+                          .build());
+  }
+
+  static constexpr size_t get_snapshot_size(size_t capacity) noexcept {
+    return sizeof(snapshot) + capacity * sizeof(entry);
+  }
+
+  // Returns the end of the copied entries
+  static entry* copy_alive(snapshot* source, snapshot* target) noexcept {
+    entry* last{target->begin()};
+    if (source) {
+      for (auto& from : *source) {
+        if (!from.removed.template load<memory_order_relaxed>()) {
+          construct_at(last++, from.callback, from.context, from.cookie);
+          ++target->size;
+        }
+      }
+    }
+    return last;
+  }
+
+  static entry* find_alive(snapshot* source, cookie_type cookie) noexcept {
+    if (source) {
+      for (auto& target : *source) {
+        if (target.cookie == cookie &&
+            !target.removed.template load<memory_order_relaxed>()) {
+          return addressof(target);
+        }
+      }
+    }
+    return nullptr;
+  }
+
+  void replace(snapshot* current, snapshot* next) noexcept {
+    // An empty array isn't allocated, so next may be nullptr after remove()
+    m_current.template store<memory_order_release>(next);
+    m_size.store<memory_order_relaxed>(next ? next->size : 0);
+    m_epoch.synchronize();
+    if (current) {
+      free_snapshot(current);
+    }
+  }
+
+ private:
+  mutex m_lock;
+  cookie_type m_last_cookie{0};
+  atomic<snapshot*> m_current{nullptr};
+  atomic<size_t> m_size{0};
+  cb::details::reader_epoch m_epoch;
+};
+}  // namespace ktl
@@ -684,8 +684,8 @@ round(const time_point<Clock, duration>& time) noexcept(
 struct system_clock {  // KeQuerySystemTimePrecise (Win8+)/KeQuerySystemTime
   using rep = long long;
   using period = ratio<1, rat::details::pow10(8)>;  // 100 nanoseconds
-  using duration = duration<rep, period>;
-  using time_point = time_point<system_clock>;
+  using duration = chrono::duration<rep, period>;
+  using time_point = chrono::time_point<system_clock>;
   static constexpr bool is_steady = false;
 
   [[nodiscard]] static time_point now() noexcept {  // get current time
@@ -707,7 +707,7 @@ struct steady_clock {  // KeQueryPerformanceCounter
   using rep = long long;
   using period = nano;
   using duration = nanoseconds;
-  using time_point = time_point<steady_clock>;
+  using time_point = chrono::time_point<steady_clock>;
   static constexpr bool is_steady = true;
 
   [[nodiscard]] static time_point now() noexcept {  // get current time
@@ -725,6 +725,20 @@ struct steady_clock {  // KeQueryPerformanceCounter
 
 using high_resolution_clock = steady_clock;
 
+// KeQueryInterruptTime: much cheaper than steady_clock, but only advances on
+// the clock interrupts (every 15.6 ms by default)
+struct coarse_steady_clock {
+  using rep = long long;
+  using period = ratio<1, rat::details::pow10(7)>;  // 100 nanoseconds
+  using duration = chrono::duration<rep, period>;
+  using time_point = chrono::time_point<coarse_steady_clock>;
+  static constexpr bool is_steady = true;
+
+  [[nodiscard]] static time_point now() noexcept {
+    return time_point{duration{query_interrupt_time()}};
+  }
+};
+
 #define IF_PERIOD_RETURN_SUFFIX_ELSE(type, suffix) \
   if constexpr (is_same_v<Period, type>) {         \
     if constexpr (is_same_v<CharT, char>) {        \
@@ -150,6 +150,21 @@ struct hash<coroutine_handle<Promise> > {
 
 struct noop_coroutine_promise {};
 
+#if defined(__GNUC__) && !defined(__clang__)
+namespace coro::details {
+// GCC has no builtin for the no-op coroutine, so the frame is made by hand
+struct noop_frame {
+  static void resume_or_destroy() noexcept {}
+
+  void (*resume)() noexcept {resume_or_destroy};
+  void (*destroy)() noexcept {resume_or_destroy};
+  noop_coroutine_promise promise;
+};
+
+inline noop_frame NOOP_FRAME{};
+}  // namespace coro::details
+#endif
+
 template <>
 struct coroutine_handle<noop_coroutine_promise> {
   friend coroutine_handle noop_coroutine() noexcept;
@@ -175,8 +190,13 @@ struct coroutine_handle<noop_coroutine_promise> {
  private:
   coroutine_handle() noexcept = default;
 
+#if defined(__GNUC__) && !defined(__clang__)
+ private:
+  void* m_ptr{&coro::details::NOOP_FRAME};
+#else
  private:
   void* m_ptr{__builtin_coro_noop()};
+#endif
 };
 
 using noop_coroutine_handle = coroutine_handle<noop_coroutine_promise>;
@@ -0,0 +1,49 @@
+#pragma once
+#include <basic_types.hpp>
+#include <span.hpp>
+
+namespace ktl {
+/**
+ * @fn uint32_t crc32c_update(uint32_t crc, const void* data, size_t size);
+ * @brief Continues CRC-32C (Castagnoli) computation. Uses the SSE4.2 crc32
+ * instruction with 3 interleaved streams if the CPU supports it and the
+ * slice-by-8 tables otherwise
+ * @param[in] crc Checksum of the preceding data or 0
+ * @return Checksum of the preceding data followed by [data, data + size)
+ */
+uint32_t crc32c_update(uint32_t crc, const void* data, size_t size) noexcept;
+
+inline uint32_t crc32c_update(uint32_t crc, span<const byte> data) noexcept {
+  return crc32c_update(crc, data.data(), data.size());
+}
+
+inline uint32_t crc32c(const void* data, size_t size) noexcept {
+  return crc32c_update(0, data, size);
+}
+
+inline uint32_t crc32c(span<const byte> data) noexcept {
+  return crc32c_update(0, data.data(), data.size());
+}
+
+/**
+ * @fn uint32_t crc32c_combine(uint32_t crc1, uint32_t crc2, size_t size2);
+ * @brief Computes the checksum of two concatenated blocks from their own
+ * checksums in O(log(size2)) without touching the data, e.g. to merge the
+ * checksums of the blocks processed in parallel
+ * @param[in] crc1 Checksum of the first block
+ * @param[in] crc2 Checksum of the second block
+ * @param[in] size2 Size of the second block
+ */
+uint32_t crc32c_combine(uint32_t crc1, uint32_t crc2, size_t size2) noexcept;
+
+namespace crc::details {
+/**
+ * @fn uint32_t crc::details::crc32c_generic(uint32_t, const byte*, size_t);
+ * @fn uint32_t crc::details::crc32c_sse42(uint32_t, const byte*, size_t);
+ * @brief Versions of crc32c_update() exposed for testing and benchmarking.
+ * crc32c_sse42() must be called only if cpu_feature::sse42 is supported
+ */
+uint32_t crc32c_generic(uint32_t crc, const byte* data, size_t size) noexcept;
+uint32_t crc32c_sse42(uint32_t crc, const byte* data, size_t size) noexcept;
+}  // namespace crc::details
+}  // namespace ktl
@@ -63,7 +63,8 @@ namespace ktl {
 namespace un::details {
 // Allocates bulks of memory for objects of type Ty. This deallocates the memory
 // in the destructor, and keeps a linked list of the allocated memory around.
-// Overhead per allocation is the size of a pointer.
+// Overhead per allocation is the size of a pointer and the size of the bulk,
+// which is passed back to the bytes allocator.
 template <class Ty,
           class BytesAllocator,
           size_t MinNumAllocs = 4,
@@ -118,9 +119,10 @@ class BulkPoolAllocator {
   // Deallocates all allocated memory.
   void reset() noexcept {
     while (mListForFree) {
-      Ty* tmp = *mListForFree;
-      AlBytesTraits::deallocate_bytes(m_bytes_alc, mListForFree, ALIGNED_SIZE);
-      mListForFree = reinterpret_cast_no_cast_align_warning<Ty**>(tmp);
+      BlockHeader* next = mListForFree->next;
+      AlBytesTraits::deallocate_bytes(m_bytes_alc, mListForFree,
+                                      mListForFree->numBytes);
+      mListForFree = next;
     }
     mHead = nullptr;
   }
@@ -165,7 +167,7 @@ class BulkPoolAllocator {
   // Otherwise it is reused and freed in the destructor.
   void addOrFree(void* ptr, size_t numBytes) noexcept {
     // calculate number of available elements in ptr
-    if (numBytes < ALIGNMENT + ALIGNED_SIZE) {
+    if (numBytes < HEADER_SIZE + ALIGNED_SIZE) {
       // not enough data for at least one element. Free and return.
       deallocate_bytes(ptr, numBytes);
     } else {
@@ -191,28 +193,24 @@ class BulkPoolAllocator {
     size_t numAllocs = MinNumAllocs;
 
     while (numAllocs * 2 <= MaxNumAllocs && tmp) {
-      auto x = reinterpret_cast<Ty***>(tmp);
-      tmp = *x;
+      tmp = tmp->next;
       numAllocs *= 2;
     }
 
     return numAllocs;
   }
 
-  // WARNING: Underflow if numBytes < ALIGNMENT! This is guarded in addOrFree().
+  // WARNING: Underflow if numBytes < HEADER_SIZE! This is guarded in
+  // addOrFree().
   void add(void* ptr, const size_t numBytes) noexcept {
-    const size_t numElements = (numBytes - ALIGNMENT) / ALIGNED_SIZE;
-
-    auto data = reinterpret_cast<Ty**>(ptr);
+    const size_t numElements = (numBytes - HEADER_SIZE) / ALIGNED_SIZE;
 
     // link free list
-    auto x = reinterpret_cast<Ty***>(data);
-    *x = mListForFree;
-    mListForFree = data;
+    mListForFree = ::new (ptr) BlockHeader{mListForFree, numBytes};
 
     // create linked list for newly allocated data
     auto* const headT = reinterpret_cast_no_cast_align_warning<Ty*>(
-        reinterpret_cast<char*>(ptr) + ALIGNMENT);
+        reinterpret_cast<char*>(ptr) + HEADER_SIZE);
 
     auto* const head = reinterpret_cast<char*>(headT);
 
@@ -234,8 +232,8 @@ class BulkPoolAllocator {
   NOINLINE Ty* performAllocation() {
     size_t const numElementsToAlloc = calcNumElementsToAlloc();
 
-    // alloc new memory: [prev |Ty, Ty, ... Ty]
-    size_t const bytes = ALIGNMENT + ALIGNED_SIZE * numElementsToAlloc;
+    // alloc new memory: [prev, size |Ty, Ty, ... Ty]
+    size_t const bytes = HEADER_SIZE + ALIGNED_SIZE * numElementsToAlloc;
     add(allocate_bytes(bytes), bytes);
     return mHead;
   }
@@ -246,6 +244,15 @@ class BulkPoolAllocator {
   static constexpr size_t ALIGNED_SIZE =
       ((sizeof(Ty) - 1) / ALIGNMENT + 1) * ALIGNMENT;
 
+  // Precedes the elements of each bulk
+  struct BlockHeader {
+    BlockHeader* next;
+    size_t numBytes;
+  };
+
+  static constexpr size_t HEADER_SIZE =
+      ((sizeof(BlockHeader) - 1) / ALIGNMENT + 1) * ALIGNMENT;
+
   static_assert(MinNumAllocs >= 1, "MinNumAllocs");
   static_assert(MaxNumAllocs >= MinNumAllocs, "MaxNumAllocs");
   static_assert(ALIGNED_SIZE >= sizeof(Ty*), "ALIGNED_SIZE");
@@ -255,7 +262,7 @@ class BulkPoolAllocator {
  private:
   allocator_type m_bytes_alc;
   Ty* mHead{nullptr};
-  Ty** mListForFree{nullptr};
+  BlockHeader* mListForFree{nullptr};
 };
 
 template <class Ty,
@@ -304,7 +311,10 @@ class NodeAllocator<Ty, BytesAllocator, MinSize, MaxSize, true> {
 
 template <class Ty, class BytesAllocator, size_t MinSize, size_t MaxSize>
 struct NodeAllocator<Ty, BytesAllocator, MinSize, MaxSize, false>
-    : public BulkPoolAllocator<Ty, BytesAllocator, MinSize, MaxSize> {};
+    : public BulkPoolAllocator<Ty, BytesAllocator, MinSize, MaxSize> {
+  using BulkPoolAllocator<Ty, BytesAllocator, MinSize, MaxSize>::
+      BulkPoolAllocator;
+};
 
 // dummy hash, unsed as mixer when robin_hood::hash is already used
 template <typename Ty>
@@ -408,7 +418,7 @@ class Table
   using key_type = Key;
   using mapped_type = Ty;
   using value_type =
-      typename conditional_t<is_set,
+      conditional_t<is_set,
                              Key,
                              pair<conditional_t<is_flat, Key, const Key>, Ty>>;
   using size_type = size_t;
@@ -990,7 +1000,7 @@ class Table
         const Hash& h = Hash{},
         const KeyEqual& equal = KeyEqual{},
         BytesAlloc&& alloc = BytesAlloc{})
-      : WHash(h), WKeyEqual(equal), NodeAllocator(forward<BytesAlloc>(alloc)) {
+      : WHash(h), WKeyEqual(equal), DataPool(forward<BytesAlloc>(alloc)) {
     insert(first, last);
   }
 
@@ -1115,7 +1125,7 @@ class Table
       // realloc.
       if (0 != mMask) {
         // only deallocate if we actually have data!
-        deallocate_bytes(mKeyVals, mNumElements * sizeof(Node));
+        deallocate_bytes(mKeyVals, calcNumBytesAllocated());
       }
 
       auto const numElementsWithBuffer = calcNumElementsWithBuffer(o.mMask + 1);
@@ -1140,7 +1150,7 @@ class Table
   }
 
   // Swaps everything between the two maps.
-  void swap(Table& o) { swap(o, *this); }
+  void swap(Table& o) { ktl::swap(o, *this); }
 
   // Clears all data, without resizing.
   void clear() {
@@ -1526,6 +1536,11 @@ class Table
 #endif
   }
 
+  // the size of the current allocation, the sized deallocation needs it
+  [[nodiscard]] size_t calcNumBytesAllocated() const {
+    return calcNumBytesTotal(calcNumElementsWithBuffer(mMask + 1));
+  }
+
  private:
   template <typename Q = mapped_type>
   [[nodiscard]] typename enable_if<!is_void<Q>::value, bool>::type has(
@@ -1621,12 +1636,13 @@ class Table
 
     auto const numElementsWithBuffer = calcNumElementsWithBuffer(max_elements);
 
-    // calloc also zeroes everything
     auto const numBytesTotal = calcNumBytesTotal(numElementsWithBuffer);
     mKeyVals = reinterpret_cast<Node*>(this->allocate_bytes(numBytesTotal));
-    memset(mKeyVals, 0, numBytesTotal);
     mInfo = reinterpret_cast<uint8_t*>(mKeyVals + numElementsWithBuffer);
 
+    // nodes are constructed on insertion, so only the info bytes are cleared
+    memset(mInfo, 0, numBytesTotal - numElementsWithBuffer * sizeof(Node));
+
     // set sentinel
     mInfo[numElementsWithBuffer] = 1;
 
@@ -1806,7 +1822,7 @@ class Table
     // non-heap object 'fm'
     // [-Werror=free-nonheap-object]
     if (mKeyVals != reinterpret_cast_no_cast_align_warning<Node*>(&mMask)) {
-      this->deallocate_bytes(mKeyVals, mNumElements * sizeof(Node));
+      this->deallocate_bytes(mKeyVals, calcNumBytesAllocated());
     }
   }
 
@@ -1,6 +1,13 @@
 #pragma once
 
 #ifdef KTL_NO_CXX_STANDARD_LIBRARY
+#ifdef KTL_HOSTED
+#include <initializer_list>  // The layout is defined by the compiler
+
+namespace ktl {
+using std::initializer_list;
+}  // namespace ktl
+#else
 namespace ktl {
 template <class Ty>
 class initializer_list {
@@ -51,3 +58,4 @@ using initializer_list = ktl::initializer_list<Ty>;
 #endif
 }  // namespace ktl
 #endif
+#endif
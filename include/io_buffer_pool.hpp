@@ -0,0 +1,210 @@
+#pragma once
+#include <atomic.hpp>
+#include <basic_types.hpp>
+#include <heap.hpp>
+#include <memory.hpp>
+#include <per_cpu.hpp>
+#include <trimmable.hpp>
+#include <type_traits.hpp>
+#include <utility.hpp>
+
+#include <ntddk.h>
+
+namespace ktl {
+class io_buffer_pool;
+
+namespace mm::details {
+struct io_buffer_entry {
+  SLIST_ENTRY link;  // Must be the first member
+  void* data;
+  MDL* mdl;
+  uint32_t size_class;
+};
+}  // namespace mm::details
+
+/**
+ * @class io_buffer
+ * @brief Owns a buffer taken from io_buffer_pool and returns it on
+ * destruction
+ */
+class io_buffer : non_copyable {
+ public:
+  io_buffer() noexcept = default;
+  io_buffer(io_buffer&& other) noexcept
+      : m_pool{exchange(other.m_pool, nullptr)},
+        m_entry{exchange(other.m_entry, nullptr)} {}
+
+  io_buffer& operator=(io_buffer&& other) noexcept {
+    if (this != addressof(other)) {
+      reset();
+      m_pool = exchange(other.m_pool, nullptr);
+      m_entry = exchange(other.m_entry, nullptr);
+    }
+    return *this;
+  }
+
+  ~io_buffer() noexcept { reset(); }
+
+  /**
+   * @fn io_buffer::data
+   * @return Page-aligned non-paged memory of at least the requested size
+   */
+  [[nodiscard]] void* data() const noexcept { return m_entry->data; }
+
+  /**
+   * @fn io_buffer::size
+   * @return Size of the whole buffer which is rounded up to the size class
+   */
+  [[nodiscard]] size_t size() const noexcept;
+
+  /**
+   * @fn io_buffer::mdl
+   * @return MDL describing the whole buffer if the pool has been created with
+   * io_buffer_pool_options::build_mdl, otherwise nullptr. The MDL must not be
+   * freed; partial MDLs may be built on top of it with IoBuildPartialMdl()
+   */
+  [[nodiscard]] MDL* mdl() const noexcept { return m_entry->mdl; }
+
+  explicit operator bool() const noexcept { return m_entry != nullptr; }
+
+  void reset() noexcept;
+
+ private:
+  friend class io_buffer_pool;
+
+  io_buffer(io_buffer_pool* pool, mm::details::io_buffer_entry* entry) noexcept
+      : m_pool{pool}, m_entry{entry} {}
+
+ private:
+  io_buffer_pool* m_pool{nullptr};
+  mm::details::io_buffer_entry* m_entry{nullptr};
+};
+
+struct io_buffer_pool_options {
+  bool build_mdl{false};  //!< Prepare an MDL for each buffer once
+  uint32_t cache_depth{8};  //!< Buffers of a size class cached per processor
+  uint16_t shared_depth{64};  //!< Buffers of a size class shared by processors
+  crt::pool_tag_t pool_tag{crt::DEFAULT_HEAP_TAG};
+};
+
+/**
+ * @struct io_buffer_pool_stats
+ * @brief Counters of a size class accumulated since the pool creation
+ */
+struct io_buffer_pool_stats {
+  size_t buffer_size;
+  uint64_t acquired;  //!< Buffers handed out
+  uint64_t created;   //!< Buffers allocated from the system pool
+  uint64_t failed;    //!< Requests failed due to lack of memory
+  size_t in_use;      //!< Buffers handed out and not returned yet
+  size_t high_water;  //!< Maximum of in_use
+};
+
+/**
+ * @class io_buffer_pool
+ * @brief Reuses the page-aligned non-paged buffers of several size classes
+ * instead of allocating them for each request
+ * @details Returned buffers are kept in the cache of the current processor,
+ * which is accessed at DISPATCH_LEVEL without locks. When it's full, they go
+ * to a lock-free list shared by all processors and, when that one is full as
+ * well, back to the system. acquire() and the destruction of io_buffer are
+ * allowed at IRQL <= DISPATCH_LEVEL. All of the buffers must be returned
+ * before the pool is destroyed. The pool may be registered in trim_registry
+ * to give the cached buffers back on memory pressure.
+ */
+class io_buffer_pool : public trimmable, non_relocatable {
+ public:
+  static constexpr size_t MIN_BUFFER_SIZE{crt::MEMORY_PAGE_SIZE};
+  static constexpr uint32_t SIZE_CLASS_COUNT{5};  // Up to 16 pages
+  static constexpr size_t MAX_BUFFER_SIZE{MIN_BUFFER_SIZE
+                                          << (SIZE_CLASS_COUNT - 1)};
+  static constexpr uint32_t MAX_CACHE_DEPTH{16};
+
+ private:
+  using entry_type = mm::details::io_buffer_entry;
+
+  struct cpu_cache {
+    entry_type* entries[SIZE_CLASS_COUNT][MAX_CACHE_DEPTH];
+    uint32_t count[SIZE_CLASS_COUNT];
+  };
+
+  struct alignas(crt::CACHE_LINE_SIZE) size_class_state {
+    SLIST_HEADER shared;
+    atomic<uint64_t> acquired{0};
+    atomic<uint64_t> created{0};
+    atomic<uint64_t> failed{0};
+    atomic<size_t> in_use{0};
+    atomic<size_t> high_water{0};
+  };
+
+ public:
+  /**
+   * @fn io_buffer_pool::io_buffer_pool
+   * @throw bad_alloc if the per-processor caches can't be allocated
+   */
+  explicit io_buffer_pool(const io_buffer_pool_options& options = {});
+  ~io_buffer_pool() noexcept;
+
+  /**
+   * @fn io_buffer_pool::acquire
+   * @param[in] size Required size up to MAX_BUFFER_SIZE
+   * @return Empty handle if the size is too large or memory is low
+   */
+  io_buffer acquire(size_t size) noexcept;
+
+  /**
+   * @fn io_buffer_pool::trim
+   * @brief Frees the buffers shared by the processors. Per-processor caches
+   * are released on destruction only
+   */
+  void trim() noexcept;
+
+  /**
+   * @fn io_buffer_pool::trim
+   * @brief Frees the shared buffers at any level and a part of the
+   * per-processor caches starting from trim_level::moderate
+   * @return Number of the released bytes
+   */
+  size_t trim(trim_level level) noexcept override;
+
+  [[nodiscard]] io_buffer_pool_stats stats(uint32_t size_class) const noexcept;
+
+  static constexpr size_t get_buffer_size(uint32_t size_class) noexcept {
+    return MIN_BUFFER_SIZE << size_class;
+  }
+
+  static constexpr uint32_t get_size_class(size_t size) noexcept {
+    uint32_t size_class{0};
+    while (size_class < SIZE_CLASS_COUNT &&
+           get_buffer_size(size_class) < size) {
+      ++size_class;
+    }
+    return size_class;
+  }
+
+ private:
+  friend class io_buffer;
+
+  void release(entry_type* entry) noexcept;
+  size_t release_shared() noexcept;
+  entry_type* pop_cached(uint32_t size_class) noexcept;
+  entry_type* create_entry(uint32_t size_class) noexcept;
+  void destroy_entry(entry_type* entry) noexcept;
+
+ private:
+  io_buffer_pool_options m_options;
+  per_cpu<cpu_cache> m_caches;
+  size_class_state m_classes[SIZE_CLASS_COUNT];
+};
+
+inline size_t io_buffer::size() const noexcept {
+  return io_buffer_pool::get_buffer_size(m_entry->size_class);
+}
+
+inline void io_buffer::reset() noexcept {
+  if (m_entry) {
+    m_pool->release(exchange(m_entry, nullptr));
+    m_pool = nullptr;
+  }
+}
+}  // namespace ktl
@@ -0,0 +1,195 @@
+#pragma once
+#include <basic_types.hpp>
+#include <span.hpp>
+#include <string_fwd.hpp>
+#include <utility.hpp>
+
+#include <ntddk.h>
+
+namespace ktl {
+class mapped_view;
+
+/**
+ * @class mapped_file
+ * @brief Read-only section of a file. The views of it are mapped on demand
+ * @details The pages of the views are read by the memory manager, so there
+ * are no copies into the pool buffers. An I/O error while the page is read
+ * raises STATUS_IN_PAGE_ERROR on access, so the views of the files on
+ * removable or network volumes should be read under __try.
+ * Must be used at PASSIVE_LEVEL
+ */
+class mapped_file : non_copyable {
+ public:
+  /**
+   * @fn mapped_file::mapped_file
+   * @param[in] path Full NT path of the file
+   * @throw kernel_error if the file can't be opened or is empty
+   */
+  explicit mapped_file(unicode_string_view path);
+
+  /**
+   * @fn mapped_file::mapped_file
+   * @param[in] file Handle opened with FILE_READ_DATA access. Isn't
+   * closed by mapped_file
+   * @throw kernel_error if the section can't be created or the file is empty
+   */
+  explicit mapped_file(HANDLE file);
+
+  mapped_file(mapped_file&& other) noexcept
+      : m_section{exchange(other.m_section, nullptr)},
+        m_size{exchange(other.m_size, 0)} {}
+
+  mapped_file& operator=(mapped_file&& other) noexcept {
+    if (this != addressof(other)) {
+      close();
+      m_section = exchange(other.m_section, nullptr);
+      m_size = exchange(other.m_size, 0);
+    }
+    return *this;
+  }
+
+  ~mapped_file() noexcept { close(); }
+
+  [[nodiscard]] uint64_t size() const noexcept { return m_size; }
+
+  /**
+   * @fn mapped_file::map
+   * @brief Maps the range of the file into the address space of the current
+   * process. Mapping is cheap: no data is read until it's accessed
+   * @param[in] size Number of bytes, clamped to the end of the file
+   * @throw out_of_range if the offset is beyond the end of the file,
+   * kernel_error if the view can't be mapped
+   */
+  [[nodiscard]] mapped_view map(uint64_t offset, size_t size) const;
+
+ private:
+  NTSTATUS create_section(HANDLE file) noexcept;
+  void close() noexcept;
+
+ private:
+  HANDLE m_section{nullptr};
+  uint64_t m_size{0};
+};
+
+/**
+ * @class mapped_view
+ * @brief Mapped range of the file, unmapped on destruction
+ * @details The view belongs to the address space of the process which has
+ * mapped it, so it must be used and destroyed in the context of that process,
+ * e.g. by a system thread
+ */
+class mapped_view : non_copyable {
+ public:
+  mapped_view() noexcept = default;
+
+  mapped_view(mapped_view&& other) noexcept
+      : m_base{exchange(other.m_base, nullptr)},
+        m_data{exchange(other.m_data, nullptr)},
+        m_size{exchange(other.m_size, 0)},
+        m_offset{exchange(other.m_offset, 0)} {}
+
+  mapped_view& operator=(mapped_view&& other) noexcept {
+    if (this != addressof(other)) {
+      reset();
+      m_base = exchange(other.m_base, nullptr);
+      m_data = exchange(other.m_data, nullptr);
+      m_size = exchange(other.m_size, 0);
+      m_offset = exchange(other.m_offset, 0);
+    }
+    return *this;
+  }
+
+  ~mapped_view() noexcept { reset(); }
+
+  [[nodiscard]] const byte* data() const noexcept { return m_data; }
+  [[nodiscard]] size_t size() const noexcept { return m_size; }
+
+  /**
+   * @fn mapped_view::offset
+   * @return Offset of the view in the file
+   */
+  [[nodiscard]] uint64_t offset() const noexcept { return m_offset; }
+
+  [[nodiscard]] span<const byte> bytes() const noexcept {
+    return {m_data, m_size};
+  }
+
+  explicit operator bool() const noexcept { return m_data != nullptr; }
+
+  /**
+   * @fn mapped_view::prefetch
+   * @brief Asks the memory manager to read the range of the view in
+   * background. Only a hint: does nothing if it isn't supported
+   */
+  void prefetch(size_t offset, size_t size) const noexcept;
+
+  void reset() noexcept;
+
+ private:
+  friend class mapped_file;
+
+  mapped_view(void* base,
+              const byte* data,
+              size_t size,
+              uint64_t offset) noexcept
+      : m_base{base}, m_data{data}, m_size{size}, m_offset{offset} {}
+
+ private:
+  void* m_base{nullptr};  // Aligned to the allocation granularity
+  const byte* m_data{nullptr};
+  size_t m_size{0};
+  uint64_t m_offset{0};
+};
+
+/**
+ * @class mapped_stream_reader
+ * @brief Reads the file sequentially through a window sliding over it, so
+ * huge files don't take the whole address space. The range after the current
+ * window is prefetched, so the reads overlap with the processing
+ */
+class mapped_stream_reader {
+ public:
+  static constexpr size_t DEFAULT_WINDOW_SIZE{1024 * 1024};
+
+ public:
+  /**
+   * @fn mapped_stream_reader::mapped_stream_reader
+   * @param[in] file Must outlive the reader
+   * @param[in] window_size Maximal size of the ranges returned by next()
+   */
+  explicit mapped_stream_reader(
+      const mapped_file& file,
+      size_t window_size = DEFAULT_WINDOW_SIZE) noexcept
+      : m_file{addressof(file)}, m_window_size{window_size} {}
+
+  /**
+   * @fn mapped_stream_reader::next
+   * @brief Unmaps the current window and maps the next one
+   * @return Bytes of the window or an empty span at the end of the file
+   * @throw kernel_error if the view can't be mapped
+   */
+  span<const byte> next();
+
+  /**
+   * @fn mapped_stream_reader::seek
+   * @brief Sets the offset of the window returned by the next call of next()
+   */
+  void seek(uint64_t position) noexcept;
+
+  /**
+   * @fn mapped_stream_reader::position
+   * @return Offset of the data following the current window
+   */
+  [[nodiscard]] uint64_t position() const noexcept { return m_position; }
+
+  [[nodiscard]] bool eof() const noexcept {
+    return m_position >= m_file->size();
+  }
+
+ private:
+  const mapped_file* m_file;
+  size_t m_window_size;
+  uint64_t m_position{0};
+  mapped_view m_view;
+};
+}  // namespace ktl
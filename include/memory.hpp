@@ -264,7 +264,7 @@ NoThrowForwardIt uninitialized_copy_non_trivial_impl(InputIt first,
                                                      InputIt last,
                                                      NoThrowForwardIt dest,
                                                      Allocator&... allocs) {
-  EmplaceHelper<NoThrowForwardIt, Allocator> uemph(dest, allocs...);
+  EmplaceHelper<NoThrowForwardIt, Allocator...> uemph(dest, allocs...);
   uemph.emplace_range(first, last);
   return uemph.release();
 }
@@ -0,0 +1,230 @@
+#pragma once
+#include <atomic.hpp>
+#include <basic_types.hpp>
+#include <intrinsic.hpp>
+#include <per_cpu.hpp>
+#include <smart_pointer.hpp>
+#include <span.hpp>
+#include <string_view.hpp>
+#include <vector.hpp>
+
+#include <ntddk.h>
+
+namespace ktl {
+/*********************************************************************************
+ * Layout of the snapshot shared with the user-mode collectors. All of the
+ * fields are little-endian and each entry starts at a multiple of 8 bytes:
+ *
+ * snapshot_header
+ * snapshot_entry, name padded to 8 bytes, value_count of uint64_t values
+ * ...
+ *
+ * Counter and gauge have a single value (the gauge one is int64_t).
+ * Histogram values are the count, the sum and the buckets without the
+ * trailing empty ones; bucket 0 counts zeroes and bucket N > 0 the values
+ * in [2^(N-1), 2^N).
+ *********************************************************************************/
+namespace metrics {
+inline constexpr uint32_t SNAPSHOT_MAGIC{0x4D4C544B};  // "KTLM"
+inline constexpr uint32_t SNAPSHOT_VERSION{1};
+
+enum class metric_type : uint8_t {
+  counter = 1,
+  gauge,
+  histogram,
+};
+
+struct snapshot_header {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t size;  //!< Including the header
+  uint32_t entry_count;
+};
+
+struct snapshot_entry {
+  uint32_t id;
+  metric_type type;
+  uint8_t reserved;
+  uint16_t name_size;  //!< In bytes, without the padding
+  uint32_t value_count;
+  uint32_t reserved2;
+};
+
+static_assert(sizeof(snapshot_header) == 16 && sizeof(snapshot_entry) == 16);
+
+namespace details {
+class metric : non_relocatable {
+ public:
+  static constexpr uint32_t MAX_VALUE_COUNT{67};
+
+ public:
+  virtual ~metric() = default;
+
+  // Writes up to MAX_VALUE_COUNT values, returns their number
+  virtual uint32_t collect(uint64_t* values) const noexcept = 0;
+};
+}  // namespace details
+}  // namespace metrics
+
+/**
+ * @class per_cpu_counter
+ * @brief Monotonic counter which is incremented on the cache line of the
+ * current processor, so the hot paths of different processors don't
+ * contend. May be used at any IRQL
+ */
+class per_cpu_counter : public metrics::details::metric {
+ public:
+  per_cpu_counter() : m_values{uint64_t{0}} {}
+
+  void add(uint64_t value = 1) noexcept {
+    m_values.local().fetch_add<memory_order_relaxed>(value);
+  }
+
+  /**
+   * @fn per_cpu_counter::value
+   * @return Sum of the values of all processors. Increments made concurrently
+   * may be missing
+   */
+  [[nodiscard]] uint64_t value() const noexcept;
+
+  uint32_t collect(uint64_t* values) const noexcept override;
+
+ private:
+  per_cpu<atomic<uint64_t> > m_values;
+};
+
+/**
+ * @class gauge
+ * @brief Current level of something, e.g. the number of the open handles.
+ * May be used at any IRQL
+ */
+class gauge : public metrics::details::metric {
+ public:
+  void set(int64_t value) noexcept {
+    m_value.store<memory_order_relaxed>(value);
+  }
+
+  void add(int64_t value = 1) noexcept {
+    m_value.fetch_add<memory_order_relaxed>(value);
+  }
+
+  void sub(int64_t value = 1) noexcept { add(-value); }
+
+  [[nodiscard]] int64_t value() const noexcept {
+    return m_value.load<memory_order_relaxed>();
+  }
+
+  uint32_t collect(uint64_t* values) const noexcept override;
+
+ private:
+  atomic<int64_t> m_value{0};
+};
+
+/**
+ * @class histogram
+ * @brief Distribution of the recorded values over the power-of-2 buckets,
+ * e.g. the latencies in microseconds. Like per_cpu_counter, the buckets are
+ * kept per processor. May be used at any IRQL
+ */
+class histogram : public metrics::details::metric {
+ public:
+  static constexpr uint32_t BUCKET_COUNT{65};
+
+ private:
+  struct cells {
+    cells() noexcept {
+      for (auto& bucket : buckets) {
+        bucket.store<memory_order_relaxed>(0);
+      }
+    }
+
+    atomic<uint64_t> buckets[BUCKET_COUNT];
+    atomic<uint64_t> sum{0};
+  };
+
+ public:
+  static uint32_t get_bucket(uint64_t value) noexcept {
+    unsigned long index;
+    if (_BitScanReverse(&index, static_cast<unsigned long>(value >> 32))) {
+      return index + 33;
+    }
+    return _BitScanReverse(&index, static_cast<unsigned long>(value))
+               ? index + 1
+               : 0;
+  }
+
+  void record(uint64_t value) noexcept {
+    auto& local{m_cells.local()};
+    local.buckets[get_bucket(value)].fetch_add<memory_order_relaxed>(1);
+    local.sum.fetch_add<memory_order_relaxed>(value);
+  }
+
+  [[nodiscard]] uint64_t count() const noexcept;
+  [[nodiscard]] uint64_t sum() const noexcept;
+
+  uint32_t collect(uint64_t* values) const noexcept override;
+
+ private:
+  per_cpu<cells> m_cells;
+};
+
+static_assert(histogram::BUCKET_COUNT + 2 ==
+              metrics::details::metric::MAX_VALUE_COUNT);
+
+/**
+ * @class metrics_registry
+ * @brief Named metrics of a driver which are exported at once with
+ * snapshot(), e.g. in response to an IOCTL
+ * @details The metrics are expected to be added during the initialization:
+ * add_*() must not be called concurrently with each other or with
+ * snapshot(). The returned references stay valid until the registry is
+ * destroyed and may be used concurrently at any IRQL. The names aren't
+ * copied and must outlive the registry, usually they are string literals.
+ */
+class metrics_registry : non_relocatable {
+ public:
+  /**
+   * @fn metrics_registry::add_counter
+   * @param[in] id Identifier the collectors rely on, it must not change
+   * between the driver versions
+   * @throw invalid_argument if the ID is already used, bad_alloc
+   */
+  per_cpu_counter& add_counter(uint32_t id, ansi_string_view name);
+  gauge& add_gauge(uint32_t id, ansi_string_view name);
+  histogram& add_histogram(uint32_t id, ansi_string_view name);
+
+  [[nodiscard]] size_t size() const noexcept { return m_entries.size(); }
+
+  /**
+   * @fn metrics_registry::max_snapshot_size
+   * @return Size of the buffer the snapshot always fits
+   */
+  [[nodiscard]] size_t max_snapshot_size() const noexcept;
+
+  /**
+   * @fn metrics_registry::snapshot
+   * @brief Serializes the current values of all metrics in the order of
+   * their registration. Allowed at IRQL <= DISPATCH_LEVEL
+   * @param[out] buffer Receives the snapshot if it's large enough, otherwise
+   * its content is unspecified
+   * @return Size of the snapshot. If it's greater than the buffer size, the
+   * driver should fail the request with STATUS_BUFFER_OVERFLOW or retry with
+   * a buffer of max_snapshot_size() bytes
+   */
+  size_t snapshot(span<byte> buffer) const noexcept;
+
+ private:
+  struct entry {
+    uint32_t id;
+    metrics::metric_type type;
+    ansi_string_view name;
+    unique_ptr<metrics::details::metric> metric;
+  };
+
+  template <class Metric>
+  Metric& add(uint32_t id, ansi_string_view name, metrics::metric_type type);
+
+ private:
+  vector<entry, basic_non_paged_allocator<entry> > m_entries;
+};
+}  // namespace ktl
@@ -419,12 +419,12 @@ class non_trivial_optional_base : public common_optional_base<Ty> {
   }
 
  protected:
-  template <class Ty>
-  void assign_or_emplace(Ty&& value) noexcept {
+  template <class U>
+  void assign_or_emplace(U&& value) noexcept {
     if (has_value()) {
-      MyBase::get_ref() = forward<Ty>(value);
+      MyBase::get_ref() = forward<U>(value);
     } else {
-      MyBase::construct_from_args(forward<Ty>(value));
+      MyBase::construct_from_args(forward<U>(value));
     }
   }
 
@@ -0,0 +1,301 @@
+#pragma once
+#include <allocator.hpp>
+#include <basic_types.hpp>
+#include <ktlexcept.hpp>
+#include <span.hpp>
+#include <type_traits.hpp>
+#include <vector.hpp>
+
+namespace ktl {
+namespace pv::details {
+using word_vector = vector<uint64_t, basic_non_paged_allocator<uint64_t> >;
+
+inline constexpr uint32_t WORD_BITS{64};
+
+constexpr uint64_t get_mask(uint32_t bits) noexcept {
+  return bits ? ~uint64_t{0} >> (WORD_BITS - bits) : 0;
+}
+
+// Number of the words keeping `count` values of `bits` bits. The last word
+// is padding, so a value is read from two words without a branch
+constexpr size_t get_word_count(size_t count, uint32_t bits) noexcept {
+  return (static_cast<uint64_t>(count) * bits + WORD_BITS - 1) / WORD_BITS +
+         1;
+}
+
+inline uint64_t read_bits(const uint64_t* words,
+                          uint64_t pos,
+                          uint32_t bits) noexcept {
+  const uint64_t* word{words + pos / WORD_BITS};
+  const uint32_t offset{static_cast<uint32_t>(pos % WORD_BITS)};
+  return ((word[0] >> offset) | ((word[1] << 1) << (WORD_BITS - 1 - offset))) &
+         get_mask(bits);
+}
+
+inline void write_bits(uint64_t* words,
+                       uint64_t pos,
+                       uint32_t bits,
+                       uint64_t value) noexcept {
+  uint64_t* word{words + pos / WORD_BITS};
+  const uint32_t offset{static_cast<uint32_t>(pos % WORD_BITS)};
+  const uint64_t mask{get_mask(bits)};
+  value &= mask;
+  word[0] = (word[0] & ~(mask << offset)) | (value << offset);
+  if (offset + bits > WORD_BITS) {
+    const uint32_t shift{WORD_BITS - offset};
+    word[1] = (word[1] & ~(mask >> shift)) | (value >> shift);
+  }
+}
+
+/**
+ * @fn pv::details::write_bits_atomic
+ * @brief Like write_bits(), but each of the words is updated with a CAS, so
+ * the neighbouring values written concurrently aren't lost
+ */
+void write_bits_atomic(uint64_t* words,
+                       uint64_t pos,
+                       uint32_t bits,
+                       uint64_t value) noexcept;
+
+/**
+ * @fn pv::details::unpack
+ * @brief Writes `count` values of `bits` <= 32 bits starting from `first` to
+ * `out`. Uses SSSE3 shuffles and SSE4.1 multiplications as variable shifts
+ * for 4 values at a time if `bits` <= 25 and the CPU supports them
+ * @param[in] word_count Size of the storage including the padding word
+ */
+void unpack(const uint64_t* words,
+            size_t word_count,
+            uint64_t first,
+            uint32_t bits,
+            uint32_t* out,
+            size_t count) noexcept;
+
+/**
+ * @fn pv::details::unpack_generic
+ * @fn pv::details::unpack_sse41
+ * @brief Versions of unpack() exposed for testing and benchmarking.
+ * unpack_sse41() must be called only if cpu_feature::ssse3 and
+ * cpu_feature::sse41 are supported
+ */
+void unpack_generic(const uint64_t* words,
+                    size_t word_count,
+                    uint64_t first,
+                    uint32_t bits,
+                    uint32_t* out,
+                    size_t count) noexcept;
+void unpack_sse41(const uint64_t* words,
+                  size_t word_count,
+                  uint64_t first,
+                  uint32_t bits,
+                  uint32_t* out,
+                  size_t count) noexcept;
+}  // namespace pv::details
+
+/**
+ * @class packed_vector
+ * @brief Array of the unsigned integers of Bits bits each stored back to back
+ * in 64-bit words, e.g. 4 bits per state code instead of 32
+ * @details get() and set() take constant time: a value spans at most two
+ * words. Values written with set() are truncated to Bits bits. The storage is
+ * allocated from the non-paged pool
+ */
+template <uint32_t Bits>
+class packed_vector {
+  static_assert(Bits > 0 && Bits <= pv::details::WORD_BITS,
+                "Bits must be in [1, 64]");
+
+ public:
+  using value_type = conditional_t<Bits <= 32, uint32_t, uint64_t>;
+  using size_type = size_t;
+
+  static constexpr uint32_t BITS{Bits};
+  static constexpr value_type MAX_VALUE{
+      static_cast<value_type>(pv::details::get_mask(Bits))};
+
+ public:
+  packed_vector() = default;
+
+  /**
+   * @fn packed_vector::packed_vector
+   * @brief Creates `count` zeroes
+   * @throw bad_alloc
+   */
+  explicit packed_vector(size_type count)
+      : m_words(pv::details::get_word_count(count, Bits), uint64_t{0}),
+        m_size{count} {}
+
+  [[nodiscard]] size_type size() const noexcept { return m_size; }
+  [[nodiscard]] bool empty() const noexcept { return m_size == 0; }
+
+  /**
+   * @fn packed_vector::size_in_bytes
+   * @return Size of the storage
+   */
+  [[nodiscard]] size_t size_in_bytes() const noexcept {
+    return m_words.size() * sizeof(uint64_t);
+  }
+
+  [[nodiscard]] value_type get(size_type idx) const noexcept {
+    return static_cast<value_type>(
+        pv::details::read_bits(m_words.data(), get_position(idx), Bits));
+  }
+
+  [[nodiscard]] value_type operator[](size_type idx) const noexcept {
+    return get(idx);
+  }
+
+  /**
+   * @fn packed_vector::at
+   * @throw out_of_range
+   */
+  [[nodiscard]] value_type at(size_type idx) const {
+    throw_exception_if_not<out_of_range>(idx < m_size, "index is out of range");
+    return get(idx);
+  }
+
+  void set(size_type idx, value_type value) noexcept {
+    pv::details::write_bits(m_words.data(), get_position(idx), Bits, value);
+  }
+
+  /**
+   * @fn packed_vector::set_atomic
+   * @brief Version of set() which may be called concurrently with set_atomic()
+   * of the other values and with get(). A value crossing a word boundary may
+   * be read half-written unless 64 is a multiple of Bits
+   */
+  void set_atomic(size_type idx, value_type value) noexcept {
+    pv::details::write_bits_atomic(m_words.data(), get_position(idx), Bits,
+                                   value);
+  }
+
+  /**
+   * @fn packed_vector::push_back
+   * @throw bad_alloc
+   */
+  void push_back(value_type value) {
+    resize(m_size + 1);
+    set(m_size - 1, value);
+  }
+
+  /**
+   * @fn packed_vector::resize
+   * @brief New values are zeroes
+   * @throw bad_alloc
+   */
+  void resize(size_type count) {
+    const size_t word_count{pv::details::get_word_count(count, Bits)};
+    if (count < m_size) {
+      m_words.resize(word_count);
+      // The bits of the removed values become the zeroes of the new ones
+      const uint64_t used{static_cast<uint64_t>(count) * Bits};
+      m_words[used / pv::details::WORD_BITS] &=
+          pv::details::get_mask(used % pv::details::WORD_BITS);
+      m_words.back() = 0;
+    } else {
+      m_words.resize(word_count, uint64_t{0});
+    }
+    m_size = count;
+  }
+
+  /**
+   * @fn packed_vector::unpack
+   * @brief Copies out.size() values starting from `first` into out, using
+   * SIMD when possible. Much faster than get() in a loop
+   * @throw out_of_range if the range exceeds size()
+   */
+  void unpack(size_type first, span<value_type> out) const {
+    throw_exception_if_not<out_of_range>(
+        first <= m_size && out.size() <= m_size - first,
+        "range is out of bounds");
+    if constexpr (Bits <= 32) {
+      pv::details::unpack(m_words.data(), m_words.size(), first, Bits,
+                          out.data(), out.size());
+    } else {
+      for (size_type idx = 0; idx < out.size(); ++idx) {
+        out[idx] = get(first + idx);
+      }
+    }
+  }
+
+ private:
+  static constexpr uint64_t get_position(size_type idx) noexcept {
+    return static_cast<uint64_t>(idx) * Bits;
+  }
+
+ private:
+  pv::details::word_vector m_words;
+  size_type m_size{0};
+};
+
+/**
+ * @class monotone_vector
+ * @brief Immutable non-decreasing sequence in the Elias-Fano encoding, which
+ * takes about 2 + log2(max / size) bits per value
+ * @details The low bits of each value are kept in a packed array and the high
+ * ones in unary, as gaps between the ones of a bit array. select() and
+ * lower_bound() jump to a sample taken every SAMPLE_RATE ones or zeroes and
+ * then scan a few words with popcount
+ */
+class monotone_vector {
+ public:
+  using value_type = uint64_t;
+  using size_type = size_t;
+
+  static constexpr size_t SAMPLE_RATE{256};
+
+ public:
+  monotone_vector() = default;
+
+  /**
+   * @fn monotone_vector::monotone_vector
+   * @throw invalid_argument if the values aren't sorted, bad_alloc
+   */
+  explicit monotone_vector(span<const value_type> values);
+
+  [[nodiscard]] size_type size() const noexcept { return m_size; }
+  [[nodiscard]] bool empty() const noexcept { return m_size == 0; }
+  [[nodiscard]] size_t size_in_bytes() const noexcept;
+
+  /**
+   * @fn monotone_vector::select
+   * @return Value at idx, which must be less than size()
+   */
+  [[nodiscard]] value_type select(size_type idx) const noexcept;
+
+  [[nodiscard]] value_type operator[](size_type idx) const noexcept {
+    return select(idx);
+  }
+
+  /**
+   * @fn monotone_vector::lower_bound
+   * @return Index of the first value which isn't less than `value` or size()
+   */
+  [[nodiscard]] size_type lower_bound(value_type value) const noexcept;
+
+ private:
+  uint64_t get_low(size_type idx) const noexcept {
+    return pv::details::read_bits(
+        m_low.data(), static_cast<uint64_t>(idx) * m_low_bits, m_low_bits);
+  }
+
+  bool test_high(uint64_t pos) const noexcept {
+    return (m_high[pos / pv::details::WORD_BITS] >>
+            (pos % pv::details::WORD_BITS)) &
+           1;
+  }
+
+  uint64_t select_one(size_type rank) const noexcept;
+  uint64_t select_zero(uint64_t rank) const noexcept;
+  void sample_zeroes(uint64_t bit_count);
+
+ private:
+  pv::details::word_vector m_low;
+  pv::details::word_vector m_high;
+  pv::details::word_vector m_one_samples;
+  pv::details::word_vector m_zero_samples;
+  size_type m_size{0};
+  uint32_t m_low_bits{0};
+  value_type m_max{0};
+};
+}  // namespace ktl
@@ -0,0 +1,157 @@
+#pragma once
+#include <basic_types.hpp>
+#include <heap.hpp>
+#include <irql.hpp>
+#include <memory.hpp>
+#include <type_traits.hpp>
+#include <utility.hpp>
+
+#include <ntddk.h>
+
+namespace ktl {
+/**
+ * @fn uint32_t max_processor_count();
+ * @return Maximum number of the processors in all of the groups, including
+ * the ones which may be hot-added later
+ */
+uint32_t max_processor_count() noexcept;
+
+/**
+ * @fn uint32_t current_processor_index();
+ * @return System-wide index of the current processor less than
+ * max_processor_count()
+ */
+uint32_t current_processor_index() noexcept;
+
+/**
+ * @class per_cpu
+ * @brief Instance of Ty for each processor, every one on its own cache line
+ * @details local() returns the instance of the current processor. The thread
+ * may be moved to another processor unless the IRQL is DISPATCH_LEVEL or
+ * higher, so the instance must either be used at DISPATCH_LEVEL or tolerate
+ * concurrent access. Instances are allocated from the non-paged pool.
+ */
+template <class Ty>
+class per_cpu : non_relocatable {
+ public:
+  using value_type = Ty;
+  using size_type = uint32_t;
+
+ private:
+  struct alignas(crt::CACHE_LINE_SIZE) slot {
+    Ty value;
+  };
+
+  static constexpr auto SLOT_ALIGNMENT{
+      static_cast<align_val_t>(alignof(slot))};
+
+ public:
+  /**
+   * @fn per_cpu::per_cpu
+   * @param[in] args Arguments passed to the constructor of each instance
+   * @throw bad_alloc or any exception thrown by the constructor of Ty
+   */
+  template <class... Types>
+  explicit per_cpu(const Types&... args) : m_size{max_processor_count()} {
+    m_slots = static_cast<slot*>(
+        allocate_memory<OnAllocationFailure::ThrowException>(
+            alloc_request_builder{sizeof(slot) * m_size, NonPagedPool}
+                .set_alignment(SLOT_ALIGNMENT)
+                .set_pool_tag(crt::DEFAULT_HEAP_TAG)
+                .build()));
+    size_type constructed{0};
+    try {
+      for (; constructed < m_size; ++constructed) {
+        construct_at(addressof(m_slots[constructed].value), args...);
+      }
+    } catch (...) {
+      destroy(constructed);
+      throw;
+    }
+  }
+
+  ~per_cpu() noexcept { destroy(m_size); }
+
+  Ty& local() noexcept { return m_slots[current_processor_index()].value; }
+
+  Ty& operator[](size_type idx) noexcept { return m_slots[idx].value; }
+  const Ty& operator[](size_type idx) const noexcept {
+    return m_slots[idx].value;
+  }
+
+  [[nodiscard]] size_type size() const noexcept { return m_size; }
+
+  /**
+   * @fn per_cpu::for_each
+   * @brief Visits the instances of all of the processors. Doesn't
+   * synchronize with the concurrent users of local()
+   */
+  template <class Fn>
+  void for_each(Fn&& fn) {
+    for (size_type idx = 0; idx < m_size; ++idx) {
+      fn(m_slots[idx].value);
+    }
+  }
+
+  template <class Fn>
+  void for_each(Fn&& fn) const {
+    for (size_type idx = 0; idx < m_size; ++idx) {
+      fn(m_slots[idx].value);
+    }
+  }
+
+ private:
+  void destroy(size_type constructed) noexcept {
+    for (size_type idx = 0; idx < constructed; ++idx) {
+      destroy_at(addressof(m_slots[idx].value));
+    }
+    deallocate_memory(free_request_builder{m_slots, sizeof(slot) * m_size}
+                          .set_alignment(SLOT_ALIGNMENT)
+                          .set_pool_tag(crt::DEFAULT_HEAP_TAG)
+                          .build());
+  }
+
+ private:
+  size_type m_size;
+  slot* m_slots{nullptr};
+};
+
+namespace cpu::details {
+using processor_callback_t = void (*)(void*);
+
+void run_on_each_processor(processor_callback_t callback,
+                           void* context) noexcept;
+}  // namespace cpu::details
+
+/**
+ * @fn run_on_each_processor
+ * @brief Calls fn on each active processor in turn at DISPATCH_LEVEL by
+ * switching the affinity of the current thread. When it returns, every
+ * processor has left the code which was running at DISPATCH_LEVEL or higher
+ * before the call, so it also serves as a grace period for the data read at
+ * DISPATCH_LEVEL. Must be called at IRQL <= APC_LEVEL
+ */
+template <class Fn>
+void run_on_each_processor(Fn&& fn) noexcept {
+  cpu::details::run_on_each_processor(
+      [](void* context) {
+        auto& target{*static_cast<remove_reference_t<Fn>*>(context)};
+        target();
+      },
+      const_cast<void*>(static_cast<const void*>(addressof(fn))));
+}
+
+/**
+ * @class dispatch_level_guard
+ * @brief Raises the IRQL to DISPATCH_LEVEL, so the thread stays on the
+ * current processor until the guard is destroyed
+ */
+class dispatch_level_guard : non_relocatable {
+ public:
+  dispatch_level_guard() noexcept : m_prev_irql{raise_irql(DISPATCH_LEVEL)} {}
+  ~dispatch_level_guard() noexcept { lower_irql(m_prev_irql); }
+
+ private:
+  irql_t m_prev_irql;
+};
+}  // namespace ktl
@@ -103,7 +103,7 @@ struct ratio_add_impl {  // add two ratios
   static constexpr intmax_t NxRhs = RxRhs::num;
   static constexpr intmax_t DxRhs = RxRhs::den;
 
-  static constexpr intmax_t _Gx = _Gcd<DxLhs, DxRhs>::value;
+  static constexpr intmax_t _Gx = gcd<DxLhs, DxRhs>::value;
 
   // typename ratio<>::type is necessary here
   using type =
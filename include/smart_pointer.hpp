@@ -653,7 +653,7 @@ struct DestroyItselfAndDeallocateAll {
 template <class Ty, class ConcretePtr>  // CRTP
 class refcounted_ptr_base {
  public:
-  using ref_counter_base = ref_counter_base;
+  using ref_counter_base = mm::details::ref_counter_base;
   using element_type = remove_extent_t<Ty>;
 
  public:
@@ -0,0 +1,547 @@
+#pragma once
+#include <allocator.hpp>
+#include <basic_types.hpp>
+#include <ktlexcept.hpp>
+#include <limits.hpp>
+#include <span.hpp>
+#include <string_view.hpp>
+#include <utility.hpp>
+#include <vector.hpp>
+
+namespace ktl {
+/*********************************************************************************
+ * Image of a sorted string table, which may be saved to a file and mapped
+ * back. All of the fields are little-endian:
+ *
+ * image_header
+ * uint32_t offset of each block from the beginning of the data
+ * data: blocks of block_size strings (the last one may be shorter)
+ *
+ * The first string of a block is stored in full: its length and characters.
+ * The next ones are front-coded against the previous string: the length of
+ * the shared prefix, the length of the rest and the characters of the rest.
+ * The lengths are in characters, encoded as LEB128 varints, and the
+ * characters aren't aligned.
+ *********************************************************************************/
+namespace sst {
+inline constexpr uint32_t IMAGE_MAGIC{0x534C544B};  // "KTLS"
+inline constexpr uint16_t IMAGE_VERSION{1};
+
+struct image_header {
+  uint32_t magic;
+  uint16_t version;
+  uint8_t char_size;
+  uint8_t reserved;
+  uint32_t block_size;  //!< Strings per block
+  uint32_t string_count;
+  uint32_t max_length;  //!< Of all of the strings, in characters
+  uint32_t data_size;   //!< In bytes
+};
+
+static_assert(sizeof(image_header) == 24);
+
+namespace details {
+using byte_vector = vector<byte, basic_non_paged_allocator<byte> >;
+
+inline void append_varint(byte_vector& target, uint32_t value) {
+  for (; value >= 0x80; value >>= 7) {
+    target.push_back(static_cast<byte>(value | 0x80));
+  }
+  target.push_back(static_cast<byte>(value));
+}
+
+// The image has been validated, so the varint is known to be complete
+inline uint32_t read_varint(const byte*& pos) noexcept {
+  uint32_t value{0};
+  for (uint32_t shift = 0;; shift += 7) {
+    const auto current{static_cast<uint32_t>(*pos++)};
+    value |= (current & 0x7F) << shift;
+    if (!(current & 0x80)) {
+      return value;
+    }
+  }
+}
+
+inline bool read_varint_checked(const byte*& pos,
+                                const byte* end,
+                                uint32_t& value) noexcept {
+  value = 0;
+  for (uint32_t shift = 0; shift < 35 && pos != end; shift += 7) {
+    const auto current{static_cast<uint32_t>(*pos++)};
+    value |= (current & 0x7F) << shift;
+    if (!(current & 0x80)) {
+      return true;
+    }
+  }
+  return false;
+}
+
+template <class Ty>
+Ty load(const byte* pos) noexcept {
+  Ty value;
+  memcpy(addressof(value), pos, sizeof(Ty));
+  return value;
+}
+}  // namespace details
+}  // namespace sst
+
+/**
+ * @class basic_sorted_string_table
+ * @brief Immutable sorted set of strings sharing long prefixes, e.g. paths
+ * @details The strings are front-coded in blocks of block_size ones and the
+ * offsets of the blocks form a sparse index. A lookup does a binary search
+ * over the first strings of the blocks and then scans one block, comparing
+ * only the new characters of each string, so it doesn't decode anything and
+ * allocates nothing. The table either owns an image built from a sorted range
+ * or uses an external one, e.g. a mapped file. Lookups may be used
+ * concurrently at any IRQL the memory of the image is accessible at
+ */
+template <class CharT, class Traits = char_traits<CharT> >
+class basic_sorted_string_table : non_copyable {
+ public:
+  using char_type = CharT;
+  using traits_type = Traits;
+  using string_view_type = basic_winnt_string_view<CharT, Traits>;
+  using size_type = size_t;
+  using byte_vector = sst::details::byte_vector;
+
+  static constexpr auto npos{static_cast<size_type>(-1)};
+  static constexpr uint32_t DEFAULT_BLOCK_SIZE{16};
+
+ private:
+  using header_type = sst::image_header;
+
+  enum class search_mode {
+    lower_bound,  // The first string which isn't less than the query
+    prefix_end,   // The first string which is greater and doesn't start with it
+  };
+
+  struct search_result {
+    size_type idx;
+    bool equal;
+  };
+
+ public:
+  /**
+   * @class basic_sorted_string_table::cursor
+   * @brief Decodes the strings one by one into its own buffer, so the views
+   * returned by value() are valid until the next call of next()
+   */
+  class cursor : non_copyable {
+   public:
+    [[nodiscard]] bool valid() const noexcept {
+      return m_idx < m_table->size();
+    }
+
+    [[nodiscard]] size_type index() const noexcept { return m_idx; }
+
+    [[nodiscard]] string_view_type value() const noexcept {
+      using length_type = typename string_view_type::size_type;
+      return {m_buffer.data(), static_cast<length_type>(m_length)};
+    }
+
+    void next() noexcept {
+      if (++m_idx < m_table->size()) {
+        decode();
+      }
+    }
+
+   private:
+    friend class basic_sorted_string_table;
+
+    cursor(const basic_sorted_string_table& table, size_type idx)
+        : m_table{addressof(table)},
+          m_buffer(table.m_header.max_length),
+          m_idx{idx} {
+      if (idx >= table.size()) {
+        m_idx = table.size();
+        return;
+      }
+      const size_type block_size{table.m_header.block_size};
+      m_idx = idx - idx % block_size;
+      m_pos = table.get_block(m_idx / block_size);
+      decode();
+      while (m_idx != idx) {
+        next();
+      }
+    }
+
+    void decode() noexcept {
+      uint32_t shared{0};
+      if (m_idx % m_table->m_header.block_size != 0) {
+        shared = sst::details::read_varint(m_pos);
+      }
+      const uint32_t rest{sst::details::read_varint(m_pos)};
+      memcpy(m_buffer.data() + shared, m_pos, rest * sizeof(CharT));
+      m_pos += rest * sizeof(CharT);
+      m_length = shared + rest;
+    }
+
+   private:
+    const basic_sorted_string_table* m_table;
+    vector<CharT, basic_non_paged_allocator<CharT> > m_buffer;
+    const byte* m_pos{nullptr};
+    size_type m_idx;
+    uint32_t m_length{0};
+  };
+
+ public:
+  basic_sorted_string_table() noexcept = default;
+
+  /**
+   * @fn basic_sorted_string_table::basic_sorted_string_table
+   * @brief Uses the image, which must outlive the table. The whole image is
+   * validated once, so a damaged one can't make the lookups read out of it
+   * @param[in] image May be larger than the image, e.g. a mapped view
+   * @throw invalid_argument if the image is damaged or has another format
+   */
+  explicit basic_sorted_string_table(span<const byte> image) { attach(image); }
+
+  /**
+   * @fn basic_sorted_string_table::basic_sorted_string_table
+   * @brief Builds an own image, see build()
+   * @throw invalid_argument, length_error, bad_alloc
+   */
+  template <class ForwardIt>
+  basic_sorted_string_table(ForwardIt first,
+                            ForwardIt last,
+                            uint32_t block_size = DEFAULT_BLOCK_SIZE)
+      : m_storage{build(first, last, block_size)} {
+    attach(span<const byte>{m_storage});
+  }
+
+  basic_sorted_string_table(basic_sorted_string_table&& other) noexcept =
+      default;
+  basic_sorted_string_table& operator=(
+      basic_sorted_string_table&& other) noexcept = default;
+
+  /**
+   * @fn basic_sorted_string_table::build
+   * @brief Encodes the strings of [first, last), which must be sorted and
+   * stay valid while they are iterated
+   * @param[in] block_size The larger the blocks are, the less memory the
+   * index takes and the longer a lookup scans
+   * @return Image which may be saved and passed to the constructor
+   * @throw invalid_argument if the strings aren't sorted or block_size is 0,
+   * length_error if the image exceeds 4 GB, bad_alloc
+   */
+  template <class ForwardIt>
+  static byte_vector build(ForwardIt first,
+                           ForwardIt last,
+                           uint32_t block_size = DEFAULT_BLOCK_SIZE);
+
+  [[nodiscard]] size_type size() const noexcept {
+    return m_header.string_count;
+  }
+
+  [[nodiscard]] bool empty() const noexcept { return size() == 0; }
+
+  /**
+   * @fn basic_sorted_string_table::image
+   * @return The image the table uses
+   */
+  [[nodiscard]] span<const byte> image() const noexcept { return m_image; }
+
+  /**
+   * @fn basic_sorted_string_table::lower_bound
+   * @return Index of the first string which isn't less than str or size()
+   */
+  [[nodiscard]] size_type lower_bound(string_view_type str) const noexcept {
+    return search(str, search_mode::lower_bound).idx;
+  }
+
+  /**
+   * @fn basic_sorted_string_table::find
+   * @return Index of str or npos
+   */
+  [[nodiscard]] size_type find(string_view_type str) const noexcept {
+    const auto result{search(str, search_mode::lower_bound)};
+    return result.equal ? result.idx : npos;
+  }
+
+  [[nodiscard]] bool contains(string_view_type str) const noexcept {
+    return search(str, search_mode::lower_bound).equal;
+  }
+
+  /**
+   * @fn basic_sorted_string_table::prefix_range
+   * @return Indices [first, second) of the strings starting with prefix
+   */
+  [[nodiscard]] pair<size_type, size_type> prefix_range(
+      string_view_type prefix) const noexcept {
+    return {search(prefix, search_mode::lower_bound).idx,
+            search(prefix, search_mode::prefix_end).idx};
+  }
+
+  /**
+   * @fn basic_sorted_string_table::make_cursor
+   * @return Cursor at the string with the index or past the end
+   * @throw bad_alloc
+   */
+  [[nodiscard]] cursor make_cursor(size_type idx = 0) const {
+    return cursor{*this, idx};
+  }
+
+  /**
+   * @fn basic_sorted_string_table::for_each
+   * @brief Calls fn(string_view_type) for the strings with the indices in
+   * [first, last) in order
+   * @throw bad_alloc or any exception thrown by fn
+   */
+  template <class Fn>
+  void for_each(size_type first, size_type last, Fn&& fn) const {
+    for (auto current = make_cursor(first); current.index() < last;
+         current.next()) {
+      fn(current.value());
+    }
+  }
+
+  template <class Fn>
+  void for_each(Fn&& fn) const {
+    for_each(0, size(), forward<Fn>(fn));
+  }
+
+ private:
+  static size_t get_block_count(const header_type& header) noexcept {
+    return header.string_count
+               ? (size_t{header.string_count} - 1) / header.block_size + 1
+               : 0;
+  }
+
+  static void append_chars(byte_vector& target,
+                           const CharT* chars,
+                           size_t count) {
+    const size_t offset{target.size()};
+    target.resize(offset + count * sizeof(CharT));
+    memcpy(target.data() + offset, chars, count * sizeof(CharT));
+  }
+
+  static CharT get_char(const byte* chars, size_t idx) noexcept {
+    return sst::details::load<CharT>(chars + idx * sizeof(CharT));
+  }
+
+  // Extends the common prefix of the encoded string and the query
+  static uint32_t match(const byte* chars,
+                        uint32_t first,
+                        uint32_t length,
+                        string_view_type query) noexcept {
+    const size_t end{(min)(size_t{length}, size_t{query.size()})};
+    size_t matched{first};
+    while (matched < end &&
+           Traits::eq(get_char(chars, matched - first), query[matched])) {
+      ++matched;
+    }
+    return static_cast<uint32_t>(matched);
+  }
+
+  // Whether the string goes before the position searched for
+  static bool precedes(const byte* chars,
+                       uint32_t first,
+                       uint32_t length,
+                       uint32_t matched,
+                       string_view_type query,
+                       search_mode mode) noexcept {
+    if (matched == query.size()) {
+      return mode == search_mode::prefix_end;
+    }
+    if (matched == length) {
+      return true;  // A proper prefix of the query
+    }
+    return Traits::lt(get_char(chars, matched - first), query[matched]);
+  }
+
+  const byte* get_block(size_t idx) const noexcept {
+    return m_data + sst::details::load<uint32_t>(m_offsets +
+                                                 idx * sizeof(uint32_t));
+  }
+
+  bool block_precedes(size_t block,
+                      string_view_type query,
+                      search_mode mode) const noexcept {
+    const byte* pos{get_block(block)};
+    const uint32_t length{sst::details::read_varint(pos)};
+    const uint32_t matched{match(pos, 0, length, query)};
+    return precedes(pos, 0, length, matched, query, mode);
+  }
+
+  static bool is_equal(const byte* pos, string_view_type query) noexcept {
+    const uint32_t length{sst::details::read_varint(pos)};
+    return length == query.size() &&
+           match(pos, 0, length, query) == query.size();
+  }
+
+  search_result search(string_view_type query,
+                       search_mode mode) const noexcept;
+
+  void attach(span<const byte> image);
+
+ private:
+  byte_vector m_storage;
+  span<const byte> m_image;
+  header_type m_header{};
+  const byte* m_offsets{nullptr};
+  const byte* m_data{nullptr};
+};
+
+template <class CharT, class Traits>
+template <class ForwardIt>
+auto basic_sorted_string_table<CharT, Traits>::build(ForwardIt first,
+                                                     ForwardIt last,
+                                                     uint32_t block_size)
+    -> byte_vector {
+  throw_exception_if_not<invalid_argument>(block_size != 0,
+                                           "block size must not be zero");
+  byte_vector data;
+  vector<uint32_t, basic_non_paged_allocator<uint32_t> > offsets;
+  header_type header{sst::IMAGE_MAGIC, sst::IMAGE_VERSION,
+                     sizeof(CharT),    0,
+                     block_size,       0,
+                     0,                0};
+  string_view_type prev;
+  for (size_t idx = 0; first != last; ++first, ++idx) {
+    const string_view_type current{*first};
+    const uint32_t length{current.size()};
+    // Checked across the block boundaries too, as the blocks are searched
+    // by their first strings
+    throw_exception_if_not<invalid_argument>(
+        idx == 0 || prev.compare(current) <= 0, "strings must be sorted");
+    if (idx % block_size == 0) {
+      offsets.push_back(static_cast<uint32_t>(data.size()));
+      sst::details::append_varint(data, length);
+      append_chars(data, current.data(), length);
+    } else {
+      uint32_t shared{0};
+      while (shared < prev.size() && shared < length &&
+             Traits::eq(prev[shared], current[shared])) {
+        ++shared;
+      }
+      sst::details::append_varint(data, shared);
+      sst::details::append_varint(data, length - shared);
+      append_chars(data, current.data() + shared, length - shared);
+    }
+    header.max_length = (max)(header.max_length, length);
+    ++header.string_count;
+    prev = current;
+  }
+  throw_exception_if_not<length_error>(
+      data.size() <= (numeric_limits<uint32_t>::max)(), "table is too large");
+  header.data_size = static_cast<uint32_t>(data.size());
+
+  byte_vector image(sizeof(header_type) + offsets.size() * sizeof(uint32_t) +
+                    data.size());
+  byte* pos{image.data()};
+  memcpy(pos, addressof(header), sizeof(header_type));
+  pos += sizeof(header_type);
+  memcpy(pos, offsets.data(), offsets.size() * sizeof(uint32_t));
+  pos += offsets.size() * sizeof(uint32_t);
+  memcpy(pos, data.data(), data.size());
+  return image;
+}
+
+template <class CharT, class Traits>
+auto basic_sorted_string_table<CharT, Traits>::search(
+    string_view_type query,
+    search_mode mode) const noexcept -> search_result {
+  const size_t block_count{get_block_count(m_header)};
+  if (!block_count) {
+    return {0, false};
+  }
+  // The last block whose first string precedes the query or the first one
+  size_t first{0};
+  size_t count{block_count};
+  while (count) {
+    const size_t step{count / 2};
+    if (block_precedes(first + step, query, mode)) {
+      first += step + 1;
+      count -= step + 1;
+    } else {
+      count = step;
+    }
+  }
+  const size_t block{first ? first - 1 : 0};
+
+  const byte* pos{get_block(block)};
+  size_type idx{block * m_header.block_size};
+  const size_type end{(min)(idx + m_header.block_size, size())};
+  uint32_t length{sst::details::read_varint(pos)};
+  uint32_t matched{match(pos, 0, length, query)};
+  if (!precedes(pos, 0, length, matched, query, mode)) {
+    return {idx, matched == query.size() && length == query.size()};
+  }
+  pos += length * sizeof(CharT);
+  // The previous string precedes the query and has `matched` characters in
+  // common with it, so only the shared prefix of the next one tells where
+  // it goes unless they are equal
+  for (++idx; idx < end; ++idx) {
+    const uint32_t shared{sst::details::read_varint(pos)};
+    const uint32_t rest{sst::details::read_varint(pos)};
+    length = shared + rest;
+    if (shared < matched) {
+      return {idx, false};  // Greater than the previous one at `shared`
+    }
+    if (shared == matched) {
+      matched = match(pos, shared, length, query);
+      if (!precedes(pos, shared, length, matched, query, mode)) {
+        return {idx, matched == query.size() && length == query.size()};
+      }
+    }
+    pos += rest * sizeof(CharT);
+  }
+  // The first string of the next block doesn't precede the query
+  return {idx, idx < size() && is_equal(get_block(block + 1), query)};
+}
+
+template <class CharT, class Traits>
+void basic_sorted_string_table<CharT, Traits>::attach(span<const byte> image) {
+  throw_exception_if_not<invalid_argument>(image.size() >= sizeof(header_type),
+                                           "image is too small");
+  header_type header;
+  memcpy(addressof(header), image.data(), sizeof(header_type));
+  throw_exception_if_not<invalid_argument>(
+      header.magic == sst::IMAGE_MAGIC &&
+          header.version == sst::IMAGE_VERSION &&
+          header.char_size == sizeof(CharT) && header.block_size != 0,
+      "unsupported image format");
+  const size_t block_count{get_block_count(header)};
+  const size_t offsets_size{block_count * sizeof(uint32_t)};
+  const size_t image_size{sizeof(header_type) + offsets_size +
+                          header.data_size};
+  throw_exception_if_not<invalid_argument>(image.size() >= image_size,
+                                           "image is truncated");
+  const byte* offsets{image.data() + sizeof(header_type)};
+  const byte* data{offsets + offsets_size};
+  const byte* end{data + header.data_size};
+
+  // Walks all of the strings, so the lookups don't check the bounds
+  const byte* pos{data};
+  uint32_t prev_length{0};
+  for (size_t idx = 0; idx < header.string_count; ++idx) {
+    bool valid{true};
+    uint32_t shared{0};
+    uint32_t rest;
+    if (idx % header.block_size == 0) {
+      const auto offset{sst::details::load<uint32_t>(
+          offsets + idx / header.block_size * sizeof(uint32_t))};
+      valid = pos == data + offset;
+    } else {
+      valid = sst::details::read_varint_checked(pos, end, shared) &&
+              shared <= prev_length;
+    }
+    valid = valid && sst::details::read_varint_checked(pos, end, rest) &&
+            rest <= header.max_length - shared &&
+            rest <= static_cast<size_t>(end - pos) / sizeof(CharT);
+    throw_exception_if_not<invalid_argument>(valid, "image is damaged");
+    pos += rest * sizeof(CharT);
+    prev_length = shared + rest;
+  }
+  throw_exception_if_not<invalid_argument>(pos == end, "image is damaged");
+
+  m_image = image.first(image_size);
+  m_header = header;
+  m_offsets = offsets;
+  m_data = data;
+}
+
+using ansi_sorted_string_table = basic_sorted_string_table<char>;
+using sorted_string_table = basic_sorted_string_table<wchar_t>;
+}  // namespace ktl
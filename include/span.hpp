@@ -0,0 +1,120 @@
+#pragma once
+#include <assert.hpp>
+#include <basic_types.hpp>
+#include <container_helpers.hpp>
+#include <type_traits.hpp>
+
+namespace ktl {
+/**
+ * @class span
+ * @brief Non-owning view of a contiguous sequence, like std::span with
+ * dynamic extent. C++17 has no std::span, so it's available in both modes
+ */
+template <class Ty>
+class span {
+ public:
+  using element_type = Ty;
+  using value_type = remove_cv_t<Ty>;
+  using size_type = size_t;
+  using difference_type = ptrdiff_t;
+  using pointer = Ty*;
+  using const_pointer = const Ty*;
+  using reference = Ty&;
+  using const_reference = const Ty&;
+  using iterator = pointer;
+
+ public:
+  constexpr span() noexcept = default;
+
+  constexpr span(pointer data, size_type size) noexcept
+      : m_data{data}, m_size{size} {}
+
+  constexpr span(pointer first, pointer last) noexcept
+      : m_data{first}, m_size{static_cast<size_type>(last - first)} {}
+
+  template <size_t N>
+  constexpr span(element_type (&arr)[N]) noexcept : m_data{arr}, m_size{N} {}
+
+  template <
+      class Container,
+      enable_if_t<
+          is_convertible_v<decltype(declval<Container&>().data()), pointer>,
+          int> = 0>
+  constexpr span(Container& cont) noexcept
+      : m_data{cont.data()}, m_size{static_cast<size_type>(cont.size())} {}
+
+  template <class U,
+            enable_if_t<is_convertible_v<U (*)[], element_type (*)[]>, int> = 0>
+  constexpr span(const span<U>& other) noexcept
+      : m_data{other.data()}, m_size{other.size()} {}
+
+ public:
+  constexpr iterator begin() const noexcept { return m_data; }
+  constexpr iterator end() const noexcept { return m_data + m_size; }
+
+  constexpr reference front() const noexcept {
+    assert(!empty());
+    return m_data[0];
+  }
+
+  constexpr reference back() const noexcept {
+    assert(!empty());
+    return m_data[m_size - 1];
+  }
+
+  constexpr reference operator[](size_type idx) const noexcept {
+    assert(idx < m_size);
+    return m_data[idx];
+  }
+
+  reference at(size_type idx) const {
+    return cont::details::at_index_verified(m_data, idx, m_size);
+  }
+
+  constexpr pointer data() const noexcept { return m_data; }
+  constexpr size_type size() const noexcept { return m_size; }
+  constexpr size_type size_bytes() const noexcept {
+    return m_size * sizeof(element_type);
+  }
+  [[nodiscard]] constexpr bool empty() const noexcept { return m_size == 0; }
+
+  constexpr span first(size_type count) const noexcept {
+    assert(count <= m_size);
+    return {m_data, count};
+  }
+
+  constexpr span last(size_type count) const noexcept {
+    assert(count <= m_size);
+    return {m_data + (m_size - count), count};
+  }
+
+  constexpr span subspan(size_type offset,
+                         size_type count = static_cast<size_type>(-1)) const
+      noexcept {
+    assert(offset <= m_size);
+    const size_type available{m_size - offset};
+    return {m_data + offset, count < available ? count : available};
+  }
+
+ private:
+  pointer m_data{nullptr};
+  size_type m_size{0};
+};
+
+template <class Ty, size_t N>
+span(Ty (&)[N]) -> span<Ty>;
+
+template <class Container>
+span(Container&)
+    -> span<remove_pointer_t<decltype(declval<Container&>().data())> >;
+
+template <class Ty>
+span<const byte> as_bytes(span<Ty> source) noexcept {
+  return {reinterpret_cast<const byte*>(source.data()), source.size_bytes()};
+}
+
+template <class Ty, enable_if_t<!is_const_v<Ty>, int> = 0>
+span<byte> as_writable_bytes(span<Ty> source) noexcept {
+  return {reinterpret_cast<byte*>(source.data()), source.size_bytes()};
+}
+}  // namespace ktl
@@ -58,7 +58,7 @@ class basic_winnt_string {
         !is_convertible_v<const Ty&, native_string_type>;
   };
 
-  template <typename CharT, size_t BufferSize, class ChTraits, class ChAlloc>
+  template <typename ChT, size_t BufferSize, class ChTraits, class ChAlloc>
   friend class basic_winnt_string;
 
   using internal_buffer_type = array<value_type, SsoBufferChCount>;
@@ -292,10 +292,10 @@ class basic_winnt_string {
 
   basic_winnt_string& operator=(basic_winnt_string&& other) noexcept(
       is_same_v<typename allocator_traits_type::is_always_equal, true_type> ||
-      is_same_v<typename allocator_traits_type::
-                    propagate_on_container_move_assignment,
-                true_type> &&
-          is_nothrow_move_assignable_v<allocator_type>) {
+      (is_same_v<typename allocator_traits_type::
+                     propagate_on_container_move_assignment,
+                 true_type> &&
+       is_nothrow_move_assignable_v<allocator_type>)) {
     using propagate_on_move_assignment_t =
         typename allocator_traits_type::propagate_on_container_move_assignment;
     constexpr bool move_alloc{
@@ -1009,7 +1009,8 @@ class basic_winnt_string {
     if constexpr (is_pointer_v<RandomAccessIt>) {
       concat(make_copy_helper(), range_length, first);
     } else {
-      concat(make_copy_range_helper(), range_length, first, last);
+      concat(make_copy_range_helper<RandomAccessIt>(), range_length, first,
+             last);
     }
   }
 
@@ -1042,7 +1043,8 @@ class basic_winnt_string {
     if constexpr (is_pointer_v<RandomAccessIt>) {
       insert_impl(index, make_copy_helper(), range_length, first);
     } else {
-      insert_impl(index, make_copy_range_helper(), range_length, first, last);
+      insert_impl(index, make_copy_range_helper<RandomAccessIt>(),
+                  range_length, first, last);
     }
   }
 
@@ -1055,8 +1057,8 @@ class basic_winnt_string {
     if constexpr (is_pointer_v<RandomAccessIt>) {
       concat_with_optimal_growth(make_copy_helper(), range_length, first);
     } else {
-      concat_with_optimal_growth(make_copy_range_helper(), range_length, first,
-                                 last);
+      concat_with_optimal_growth(make_copy_range_helper<RandomAccessIt>(),
+                                 range_length, first, last);
     }
   }
 
@@ -1202,7 +1204,7 @@ class basic_winnt_string {
                                : allocate_buffer(alc, new_capacity)};
     const size_type new_size{
         transfer_handler(new_buffer, old_size, old_buffer)};
-    if (!is_small()) {
+    if (old_buffer != get_sso_buffer()) {
       deallocate_buffer(alc, old_buffer, capacity());
     }
     native_string_traits_type::set_buffer(get_native_str(), new_buffer);
@@ -1238,7 +1240,8 @@ class basic_winnt_string {
                                                                    count,
                                                                    src))) {
     handler(dst, bounds.first, src);
-    handler(dst + bounds.second, count - bounds.first, src + bounds.first);
+    handler(dst + bounds.first + bounds.second, count - bounds.first,
+            src + bounds.first);
   }
 
   template <class Handler>
@@ -1250,7 +1253,7 @@ class basic_winnt_string {
             const value_type* src) noexcept(noexcept(handler(dst, count, src)))
             -> size_type {
           shift_right_helper(handler, dst, src, count, bounds);
-          return count + (bounds.second - bounds.first);
+          return count + bounds.second;
         };
   }
 
@@ -1276,8 +1279,9 @@ class basic_winnt_string {
 
   template <class InputIt>
   static constexpr auto make_copy_range_helper() noexcept {
-    return [](value_type* dst, InputIt first, InputIt last) {
-      for (; first != last; first = next(last), ++dst) {
+    return [](value_type* dst, [[maybe_unused]] size_type count,
+              InputIt first, InputIt last) {
+      for (; first != last; ++first, ++dst) {
         traits_type::assign(*dst, *first);
       }
     };
@@ -1359,8 +1363,7 @@ auto operator+(
 
 template <typename CharT, size_t BufferSize, class ChTraits, class ChAlloc>
 auto operator+(
-    const basic_winnt_string<typename CharT, BufferSize, ChTraits, ChAlloc>&
-        lhs,
+    const basic_winnt_string<CharT, BufferSize, ChTraits, ChAlloc>& lhs,
     const CharT* null_terminated_str) {
   basic_winnt_string<CharT, BufferSize, ChTraits, ChAlloc> str{lhs};
   str += null_terminated_str;
@@ -120,7 +120,7 @@ class basic_winnt_string_view {
   }
 
   constexpr void swap(basic_winnt_string_view& other) noexcept {
-    using ::swap;
+    using ktl::swap;
     swap(m_str, other.m_str);
   }
 
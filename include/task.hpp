@@ -0,0 +1,253 @@
+#pragma once
+#include <atomic.hpp>
+#include <basic_types.hpp>
+#include <bugcheck.hpp>
+#include <coroutine.hpp>
+#include <new_delete.hpp>
+#include <optional.hpp>
+#include <span.hpp>
+#include <type_traits.hpp>
+#include <utility.hpp>
+
+#include <ntddk.h>
+
+namespace ktl {
+template <class Ty = void>
+class task;
+
+namespace coro::details {
+struct final_awaiter {
+  [[nodiscard]] bool await_ready() const noexcept { return false; }
+
+  template <class Promise>
+  coroutine_handle<> await_suspend(coroutine_handle<Promise> self) noexcept {
+    return self.promise().continuation;  // Symmetric transfer, no recursion
+  }
+
+  void await_resume() const noexcept {}
+};
+
+// The frames hold the I/O requests which the completion routines write at
+// DISPATCH_LEVEL, so they are allocated from the non-paged pool
+struct non_paged_promise {
+  static void* operator new(size_t bytes) {
+    return ::operator new(bytes, non_paged_new);
+  }
+
+  static void operator delete(void* ptr, size_t bytes) noexcept {
+    ::operator delete(ptr, bytes, non_paged_new);
+  }
+};
+
+struct task_promise_base : non_paged_promise {
+  suspend_always initial_suspend() const noexcept { return {}; }
+  final_awaiter final_suspend() const noexcept { return {}; }
+
+  // There is no exception_ptr to carry the exception to the awaiting
+  // coroutine, so it mustn't leave the task
+  void unhandled_exception() const noexcept { terminate(); }
+
+  // Set when the task is awaited, which is the only way to start it
+  coroutine_handle<> continuation;
+};
+
+template <class Ty>
+struct task_promise : task_promise_base {
+  task<Ty> get_return_object() noexcept;
+
+  template <class U>
+  void return_value(U&& value) noexcept(is_nothrow_constructible_v<Ty, U>) {
+    result.emplace(forward<U>(value));
+  }
+
+  optional<Ty> result;
+};
+
+template <>
+struct task_promise<void> : task_promise_base {
+  task<void> get_return_object() noexcept;
+
+  void return_void() const noexcept {}
+};
+}  // namespace coro::details
+
+/**
+ * @class task
+ * @brief Lazily started coroutine returning a value of type Ty. It starts
+ * when it's awaited and resumes the awaiting coroutine when it finishes
+ * @details The frame is allocated from the non-paged pool by the promise.
+ * The task is resumed by whatever has completed the operation it awaits, e.g.
+ * by a system worker thread
+ */
+template <class Ty>
+class [[nodiscard]] task : non_copyable {
+ public:
+  using promise_type = coro::details::task_promise<Ty>;
+  using handle_type = coroutine_handle<promise_type>;
+
+ private:
+  struct awaiter {
+    [[nodiscard]] bool await_ready() const noexcept {
+      return !handle || handle.done();
+    }
+
+    coroutine_handle<> await_suspend(coroutine_handle<> awaiting) noexcept {
+      handle.promise().continuation = awaiting;
+      return handle;
+    }
+
+    Ty await_resume() {
+      if constexpr (!is_void_v<Ty>) {
+        return move(*handle.promise().result);
+      }
+    }
+
+    handle_type handle;
+  };
+
+ public:
+  task() noexcept = default;
+  explicit task(handle_type handle) noexcept : m_handle{handle} {}
+
+  task(task&& other) noexcept : m_handle{exchange(other.m_handle, nullptr)} {}
+
+  task& operator=(task&& other) noexcept {
+    if (this != addressof(other)) {
+      destroy();
+      m_handle = exchange(other.m_handle, nullptr);
+    }
+    return *this;
+  }
+
+  ~task() noexcept { destroy(); }
+
+  awaiter operator co_await() && noexcept { return awaiter{m_handle}; }
+
+  [[nodiscard]] bool done() const noexcept {
+    return !m_handle || m_handle.done();
+  }
+
+ private:
+  void destroy() noexcept {
+    if (m_handle) {
+      m_handle.destroy();
+    }
+  }
+
+ private:
+  handle_type m_handle;
+};
+
+namespace coro::details {
+template <class Ty>
+task<Ty> task_promise<Ty>::get_return_object() noexcept {
+  return task<Ty>{coroutine_handle<task_promise>::from_promise(*this)};
+}
+
+inline task<void> task_promise<void>::get_return_object() noexcept {
+  return task<void>{coroutine_handle<task_promise>::from_promise(*this)};
+}
+
+struct wait_latch {
+  explicit wait_latch(size_t count) noexcept : pending{count} {
+    KeInitializeEvent(addressof(event), NotificationEvent, false);
+  }
+
+  void count_down() noexcept {
+    if (pending.fetch_sub(1) == 1) {
+      KeSetEvent(addressof(event), IO_NO_INCREMENT, false);
+    }
+  }
+
+  void wait() noexcept {
+    KeWaitForSingleObject(addressof(event), Executive, KernelMode, false,
+                          nullptr);
+  }
+
+  atomic<size_t> pending;
+  KEVENT event;
+};
+
+// Awaits the task and counts the latch down. Destroys itself at the end, so
+// the waiting thread doesn't touch the frame
+class sync_wait_task {
+ public:
+  struct promise_type : non_paged_promise {
+    sync_wait_task get_return_object() noexcept {
+      return sync_wait_task{
+          coroutine_handle<promise_type>::from_promise(*this)};
+    }
+
+    suspend_always initial_suspend() const noexcept { return {}; }
+
+    suspend_never final_suspend() const noexcept {
+      latch->count_down();
+      return {};
+    }
+
+    void return_void() const noexcept {}
+    void unhandled_exception() const noexcept { terminate(); }
+
+    wait_latch* latch{nullptr};
+  };
+
+ public:
+  void start(wait_latch& latch) && noexcept {
+    m_handle.promise().latch = addressof(latch);
+    m_handle.resume();
+  }
+
+ private:
+  explicit sync_wait_task(coroutine_handle<promise_type> handle) noexcept
+      : m_handle{handle} {}
+
+ private:
+  coroutine_handle<promise_type> m_handle;
+};
+
+template <class Ty>
+sync_wait_task await_and_store(task<Ty>& target, optional<Ty>& result) {
+  result.emplace(co_await move(target));
+}
+
+inline sync_wait_task await_void(task<void>& target) {
+  co_await move(target);
+}
+}  // namespace coro::details
+
+/**
+ * @fn sync_wait
+ * @brief Runs the task and blocks the current thread until it finishes.
+ * Must be called at PASSIVE_LEVEL
+ * @return Result of the task
+ */
+template <class Ty>
+Ty sync_wait(task<Ty>&& target) {
+  coro::details::wait_latch latch{1};
+  if constexpr (is_void_v<Ty>) {
+    coro::details::await_void(target).start(latch);
+    latch.wait();
+  } else {
+    optional<Ty> result;
+    coro::details::await_and_store(target, result).start(latch);
+    latch.wait();
+    return move(*result);
+  }
+}
+
+/**
+ * @fn sync_wait_all
+ * @brief Runs the tasks and blocks the current thread until all of them
+ * finish. Each task runs on the current thread until it suspends, so their
+ * I/O operations are in flight at the same time. Must be called at
+ * PASSIVE_LEVEL
+ */
+inline void sync_wait_all(span<task<void> > targets) {
+  coro::details::wait_latch latch{targets.size() + 1};
+  for (auto& target : targets) {
+    coro::details::await_void(target).start(latch);
+  }
+  latch.count_down();  // The tasks may finish before all of them are started
+  latch.wait();
+}
+}  // namespace ktl
@@ -20,7 +20,7 @@ constexpr NTSTATUS wait_for_impl(
     AwaitHandler await_handler) noexcept {
   if (constexpr auto zero = chrono::duration<Rep, Period>::zero();
       wait_duration < zero ||
-      Policy == ZeroWaitPolicy::Cancel && wait_duration == zero) {
+      (Policy == ZeroWaitPolicy::Cancel && wait_duration == zero)) {
     return STATUS_CANCELLED;
   }
 
@@ -0,0 +1,125 @@
+#pragma once
+#include <atomic.hpp>
+#include <basic_types.hpp>
+#include <chrono.hpp>
+#include <per_cpu.hpp>
+
+#include <ntddk.h>
+
+namespace ktl {
+/**
+ * @class token_bucket
+ * @brief Lock-free rate limiter allowing bursts of up to `burst` tokens
+ * refilled at `rate` tokens per second
+ * @details The whole state is a single 64-bit word: the time when the bucket
+ * becomes full again, so the tokens and the refill time stamp are updated
+ * with one CAS and a rejected request costs one load only. The time is taken
+ * from coarse_steady_clock, so the tokens are refilled at the clock
+ * interrupts; to reach the rate, the burst should cover at least one clock
+ * interval. May be used at any IRQL
+ */
+class token_bucket : non_relocatable {
+ public:
+  //! The time is counted in fractions of a nanosecond, so the interval between
+  //! the tokens is within 0.1% of 1/rate even at 10^9 tokens per second
+  static constexpr uint64_t TICKS_PER_NANOSECOND{1024};
+
+ public:
+  /**
+   * @fn token_bucket::token_bucket
+   * @param[in] rate Tokens per second, up to 10^9
+   * @param[in] burst Capacity of the bucket, which is full initially
+   * @throw invalid_argument if any of the values is zero or the rate is too
+   * high
+   */
+  token_bucket(uint64_t rate, uint64_t burst);
+
+  /**
+   * @fn token_bucket::try_acquire
+   * @return true if the tokens have been taken, otherwise the bucket isn't
+   * changed
+   */
+  bool try_acquire(uint64_t count = 1) noexcept {
+    if (count > m_burst) {
+      return false;
+    }
+    const uint64_t now{current_time()};
+    const uint64_t cost{count * m_interval};
+    uint64_t full_at{m_full_at.load<memory_order_relaxed>()};
+    for (;;) {
+      // There are (now + capacity - full_at) / interval tokens. The ticks
+      // wrap around, so the past full_at is the one beyond the capacity
+      const uint64_t pending{full_at - now};
+      const uint64_t next{(pending <= m_capacity ? full_at : now) + cost};
+      if (next - now > m_capacity) {
+        return false;
+      }
+      if (m_full_at.compare_exchange_strong(full_at, next)) {
+        return true;
+      }
+    }
+  }
+
+  /**
+   * @fn token_bucket::available
+   * @return Number of the tokens which may be acquired now. Concurrent
+   * acquires may already have taken them
+   */
+  [[nodiscard]] uint64_t available() const noexcept;
+
+  [[nodiscard]] uint64_t rate() const noexcept { return m_rate; }
+  [[nodiscard]] uint64_t burst() const noexcept { return m_burst; }
+
+ private:
+  static uint64_t current_time() noexcept {  // In ticks
+    return static_cast<uint64_t>(
+               chrono::duration_cast<chrono::nanoseconds>(
+                   chrono::coarse_steady_clock::now().time_since_epoch())
+                   .count()) *
+           TICKS_PER_NANOSECOND;
+  }
+
+ private:
+  uint64_t m_rate;
+  uint64_t m_burst;
+  uint64_t m_interval;  // Ticks per token
+  uint64_t m_capacity;  // Ticks to refill the whole bucket
+  atomic<uint64_t> m_full_at;
+};
+
+/**
+ * @class sharded_token_bucket
+ * @brief token_bucket split between the processors for the rates at which a
+ * single CAS location becomes the bottleneck
+ * @details Each processor has a bucket with its share of the rate and burst.
+ * When the local one is empty, the buckets of the other processors are
+ * tried, so a single busy processor still gets the whole rate, but the
+ * rejections are more expensive than with token_bucket
+ */
+class sharded_token_bucket : non_relocatable {
+ public:
+  /**
+   * @fn sharded_token_bucket::sharded_token_bucket
+   * @param[in] rate Total tokens per second. The shares are rounded up, so
+   * the rate and burst should be much greater than the number of processors
+   * @throw invalid_argument, bad_alloc
+   */
+  sharded_token_bucket(uint64_t rate, uint64_t burst);
+
+  bool try_acquire(uint64_t count = 1) noexcept {
+    const uint32_t local{current_processor_index()};
+    if (m_buckets[local].try_acquire(count)) {
+      return true;
+    }
+    return try_acquire_remote(local, count);
+  }
+
+  [[nodiscard]] uint64_t available() const noexcept;
+
+ private:
+  bool try_acquire_remote(uint32_t local, uint64_t count) noexcept;
+
+ private:
+  per_cpu<token_bucket> m_buckets;
+};
+}  // namespace ktl
@@ -0,0 +1,198 @@
+#pragma once
+#include <atomic.hpp>
+#include <basic_types.hpp>
+#include <heap.hpp>
+#include <intrinsic.hpp>
+#include <per_cpu.hpp>
+#include <type_traits.hpp>
+#include <utility.hpp>
+
+#include <ntddk.h>
+
+namespace ktl {
+/**
+ * @struct trace_record
+ * @brief Fixed-size binary trace record. The payload is interpreted by the
+ * consumer according to the event ID
+ */
+struct trace_record {
+  static constexpr size_t PAYLOAD_SIZE{40};
+
+  uint64_t timestamp;  //!< Time stamp counter of the writing processor
+  uint32_t event_id;
+  uint16_t cpu;
+  uint16_t payload_size;
+  byte payload[PAYLOAD_SIZE];
+};
+
+enum class trace_mode {
+  overwrite,  //!< The newest records replace the oldest unconsumed ones
+  stop,       //!< The records are dropped while the buffer is full
+};
+
+struct trace_stats {
+  uint64_t written;
+  uint64_t dropped;  //!< Not written because the buffer was full
+  uint64_t lost;     //!< Overwritten before they were consumed
+};
+
+namespace trace::details {
+// Exactly one cache line, so each write touches a single line
+struct alignas(crt::CACHE_LINE_SIZE) trace_slot {
+  atomic<uint64_t> sequence;  // Index + 1 of the committed record or 0
+  trace_record record;
+};
+
+static_assert(sizeof(trace_slot) == crt::CACHE_LINE_SIZE);
+
+struct cpu_ring : non_relocatable {
+  explicit cpu_ring(uint32_t capacity);
+  ~cpu_ring() noexcept;
+
+  atomic<uint64_t> head{0};  // Index of the next record to write
+  atomic<uint64_t> tail{0};  // Index of the next record to consume
+  atomic<uint64_t> dropped{0};
+  uint32_t capacity;
+  trace_slot* slots;
+};
+
+struct merge_cursor {
+  trace_record record;
+  uint64_t limit;  // Head of the ring when consume() has been called
+  bool valid;
+};
+}  // namespace trace::details
+
+/**
+ * @class trace_buffer
+ * @brief Per-processor lock-free rings of trace records
+ * @details write() is wait-free in the overwrite mode and may be called at
+ * any IRQL, including from the ISRs and the IPI routines: the record is
+ * reserved with a single atomic increment on the ring of the current
+ * processor and published with its sequence number. Writers interrupted on
+ * the same processor reserve the next records, so the nested writes never
+ * block each other. There is a single consumer which merges the processor
+ * streams by the time stamps; the records reserved by interrupted writers
+ * may be slightly out of order within a stream.
+ */
+class trace_buffer : non_relocatable {
+ public:
+  /**
+   * @fn trace_buffer::trace_buffer
+   * @param[in] records_per_cpu Capacity of each ring, a power of 2. Each
+   * record takes a cache line
+   * @throw invalid_argument if the capacity isn't a power of 2, bad_alloc
+   * if the rings can't be allocated
+   */
+  explicit trace_buffer(uint32_t records_per_cpu,
+                        trace_mode mode = trace_mode::overwrite);
+
+  ~trace_buffer() noexcept;
+
+  /**
+   * @fn trace_buffer::write
+   * @brief Writes the record to the ring of the current processor at any IRQL
+   * @param[in] size Up to trace_record::PAYLOAD_SIZE bytes, the rest is
+   * truncated
+   * @return false if the record has been dropped in the stop mode
+   */
+  bool write(uint32_t event_id, const void* payload, size_t size) noexcept {
+    using trace::details::trace_slot;
+
+    const uint32_t cpu{current_processor_index()};
+    auto& ring{m_rings[cpu]};
+    uint64_t index;
+    if (m_mode == trace_mode::overwrite) {
+      index = ring.head.fetch_add<memory_order_relaxed>(1);
+    } else if (!try_reserve(ring, index)) {
+      return false;
+    }
+
+    trace_slot& slot{ring.slots[index & m_mask]};
+    if (m_mode == trace_mode::overwrite) {
+      // The reader may be copying the previous lap, so the slot is
+      // invalidated before the record is changed
+      slot.sequence.exchange(0);
+    }
+    auto& record{slot.record};
+    record.timestamp = ReadTimeStampCounter();
+    record.event_id = event_id;
+    record.cpu = static_cast<uint16_t>(cpu);
+    record.payload_size = static_cast<uint16_t>(
+        size < trace_record::PAYLOAD_SIZE ? size : trace_record::PAYLOAD_SIZE);
+    if (record.payload_size) {
+      memcpy(record.payload, payload, record.payload_size);
+    }
+    slot.sequence.store<memory_order_release>(index + 1);
+    return true;
+  }
+
+  template <class Ty>
+  bool write(uint32_t event_id, const Ty& payload) noexcept {
+    static_assert(is_trivially_copyable_v<Ty> &&
+                      sizeof(Ty) <= trace_record::PAYLOAD_SIZE,
+                  "payload must be trivially copyable and fit the record");
+    return write(event_id, addressof(payload), sizeof(Ty));
+  }
+
+  bool write(uint32_t event_id) noexcept {
+    return write(event_id, nullptr, 0);
+  }
+
+  /**
+   * @fn trace_buffer::consume
+   * @brief Passes the records written before the call to fn in the order of
+   * their time stamps and removes them from the rings. Only one thread may
+   * consume the records at a time
+   * @return Number of the consumed records
+   */
+  template <class Fn>
+  size_t consume(Fn&& fn) {
+    const uint32_t cpu_count{m_rings.size()};
+    for (uint32_t cpu = 0; cpu < cpu_count; ++cpu) {
+      auto& cursor{m_cursors[cpu]};
+      cursor.limit = m_rings[cpu].head.load<memory_order_acquire>();
+      cursor.valid = fetch(cpu, cursor);
+    }
+    size_t consumed{0};
+    for (;;) {
+      uint32_t oldest{cpu_count};
+      for (uint32_t cpu = 0; cpu < cpu_count; ++cpu) {
+        const auto& cursor{m_cursors[cpu]};
+        if (cursor.valid &&
+            (oldest == cpu_count || cursor.record.timestamp <
+                                        m_cursors[oldest].record.timestamp)) {
+          oldest = cpu;
+        }
+      }
+      if (oldest == cpu_count) {
+        return consumed;
+      }
+      fn(static_cast<const trace_record&>(m_cursors[oldest].record));
+      ++consumed;
+      m_cursors[oldest].valid = fetch(oldest, m_cursors[oldest]);
+    }
+  }
+
+  [[nodiscard]] trace_mode mode() const noexcept { return m_mode; }
+
+  [[nodiscard]] trace_stats stats() const noexcept;
+
+ private:
+  using cursor_type = trace::details::merge_cursor;
+
+  static uint32_t verify_capacity(uint32_t capacity);
+
+  bool try_reserve(trace::details::cpu_ring& ring, uint64_t& index) noexcept;
+
+  // Copies the next committed record of the processor into the cursor
+  bool fetch(uint32_t cpu, cursor_type& cursor) noexcept;
+
+ private:
+  trace_mode m_mode;
+  uint64_t m_mask;
+  per_cpu<trace::details::cpu_ring> m_rings;
+  cursor_type* m_cursors;  // Used by the consumer only
+  atomic<uint64_t> m_lost{0};
+};
+}  // namespace ktl
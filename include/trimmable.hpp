@@ -0,0 +1,166 @@
+#pragma once
+#include <atomic.hpp>
+#include <basic_types.hpp>
+#include <mutex.hpp>
+#include <thread.hpp>
+#include <vector.hpp>
+
+#include <ntddk.h>
+
+namespace ktl {
+/**
+ * @enum trim_level
+ * @brief How much of the cached memory should be given back. The levels are
+ * tried in order while the memory stays low
+ */
+enum class trim_level : uint8_t {
+  light,       //!< About a half of the cache
+  moderate,    //!< Most of the cache
+  aggressive,  //!< Everything which isn't in use
+};
+
+inline constexpr uint32_t TRIM_LEVEL_COUNT{3};
+
+/**
+ * @fn get_trim_count
+ * @return Number of the cached objects to release at the level
+ */
+constexpr size_t get_trim_count(size_t cached, trim_level level) noexcept {
+  switch (level) {
+    case trim_level::light:
+      return (cached + 1) / 2;
+    case trim_level::moderate:
+      return cached - cached / 4;
+    default:
+      return cached;
+  }
+}
+
+/**
+ * @class trimmable
+ * @brief Interface of the caches and pools which are able to give the
+ * memory they keep for the future use back to the system
+ */
+class trimmable {
+ public:
+  /**
+   * @fn trimmable::trim
+   * @brief Called at IRQL <= APC_LEVEL, possibly concurrently with the other
+   * operations on the object
+   * @return Approximate number of the released bytes
+   */
+  virtual size_t trim(trim_level level) noexcept = 0;
+
+ protected:
+  ~trimmable() = default;
+};
+
+/**
+ * @class trim_registry
+ * @brief Set of the trimmable objects released together on memory pressure
+ * @details The objects must be removed before they are destroyed. All of the
+ * methods must be called at IRQL <= APC_LEVEL
+ */
+class trim_registry : non_relocatable {
+ public:
+  /**
+   * @fn trim_registry::add
+   * @throw bad_alloc
+   */
+  void add(trimmable& target);
+  void remove(trimmable& target) noexcept;
+
+  /**
+   * @fn trim_registry::trim
+   * @brief Trims all of the registered objects
+   * @return Approximate number of the released bytes
+   */
+  size_t trim(trim_level level) noexcept;
+
+  /**
+   * @fn trim_registry::trim_until_released
+   * @brief Tries the levels starting from the lightest one until some memory
+   * has been released
+   * @return Approximate number of the released bytes
+   */
+  size_t trim_until_released() noexcept;
+
+ private:
+  push_lock m_lock;
+  vector<trimmable*, basic_non_paged_allocator<trimmable*> > m_targets;
+};
+
+/**
+ * @fn set_trim_new_handler
+ * @brief Installs a new_handler which calls trim_until_released() when
+ * operator new fails, so the allocation is retried after the caches have
+ * been trimmed. When nothing can be released or the IRQL is above
+ * APC_LEVEL, bad_alloc is thrown (the nothrow versions return nullptr)
+ * @param[in] registry Must stay alive until the handler is removed with
+ * nullptr
+ */
+void set_trim_new_handler(trim_registry* registry) noexcept;
+
+/**
+ * @struct memory_condition_events
+ * @brief Notification events which are signaled while the memory is low
+ */
+struct memory_condition_events {
+  KEVENT* low_non_paged_pool;
+  KEVENT* low_memory;
+};
+
+/**
+ * @class low_memory_watcher
+ * @brief Trims the registry from a dedicated thread while the memory is low
+ * @details The registry is trimmed at trim_level::light as soon as any of
+ * the conditions is signaled and at the next levels every
+ * ESCALATION_INTERVAL while it stays signaled. The level is reset when the
+ * conditions are cleared
+ */
+class low_memory_watcher : non_relocatable {
+ public:
+  static constexpr chrono::milliseconds ESCALATION_INTERVAL{1000};
+
+ public:
+  /**
+   * @fn low_memory_watcher::low_memory_watcher
+   * @brief Watches \KernelObjects\LowNonPagedPoolCondition and
+   * \KernelObjects\LowMemoryCondition
+   * @throw kernel_error if the events can't be opened, bad_alloc
+   */
+  explicit low_memory_watcher(trim_registry& registry);
+
+  /**
+   * @fn low_memory_watcher::low_memory_watcher
+   * @brief Watches the events provided by the caller, e.g. the stand-ins
+   * signaled by the tests. The events must outlive the watcher
+   */
+  low_memory_watcher(trim_registry& registry, memory_condition_events events);
+
+  ~low_memory_watcher() noexcept;
+
+  /**
+   * @fn low_memory_watcher::trim_count
+   * @return Number of the times the registry has been trimmed
+   */
+  [[nodiscard]] uint64_t trim_count() const noexcept {
+    return m_trim_count.load<memory_order_relaxed>();
+  }
+
+ private:
+  static KEVENT* open_event(const UNICODE_STRING& name);
+
+  void start();
+  void run() noexcept;
+  bool is_memory_low() const noexcept;
+
+ private:
+  trim_registry& m_registry;
+  memory_condition_events m_events;
+  bool m_system_events;  // Referenced by the watcher
+  notify_event m_stop;
+  atomic<uint64_t> m_trim_count{0};
+  system_thread m_thread;
+};
+}  // namespace ktl
@@ -116,16 +116,18 @@ class tuple_base<index_sequence<Indices...>, Types...>
       : MyElementBase<Indices, Types>{forward<OtherTypes>(args)}... {}
 
   template <class... OtherTypes,
-            enable_if_t<sizeof...(OtherTypes) == sizeof...(Types) &&
-                            conjunction<is_constructible<Types, OtherTypes>...>,
-                        int> = 0>
+            enable_if_t<
+                sizeof...(OtherTypes) == sizeof...(Types) &&
+                    conjunction_v<is_constructible<Types, OtherTypes>...>,
+                int> = 0>
   constexpr tuple_base(const tuple_base<OtherTypes...>& other)
       : MyElementBase<Indices, Types>{get_value<Indices>(other)}... {}
 
   template <class... OtherTypes,
-            enable_if_t<sizeof...(OtherTypes) == sizeof...(Types) &&
-                            conjunction<is_constructible<Types, OtherTypes>...>,
-                        int> = 0>
+            enable_if_t<
+                sizeof...(OtherTypes) == sizeof...(Types) &&
+                    conjunction_v<is_constructible<Types, OtherTypes>...>,
+                int> = 0>
   constexpr tuple_base(tuple_base<OtherTypes...>&& other)
       : MyElementBase<Indices, Types>{move(get_value<Indices>(other))}... {}
 
@@ -176,18 +178,18 @@ class tuple_base<index_sequence<Indices...>, Types...>
 
   constexpr void swap(tuple_base& other) noexcept(
       conjunction_v<is_nothrow_swappable<Types>...>) {
-    ((::swap(get_value<Indices>(*this), get_value<Indices>(other))), ...);
+    ((ktl::swap(get_value<Indices>(*this), get_value<Indices>(other))), ...);
   }
 
  private:
-  template <size_t... Indices, class... Types>
-  tuple_base& assign(index_sequence<Indices...>, Types&&... args) {
-    return assign_impl<Indices...>(forward<Types>(args)...);
+  template <size_t... Idxs, class... Args>
+  tuple_base& assign(index_sequence<Idxs...>, Args&&... args) {
+    return assign_impl<Idxs...>(forward<Args>(args)...);
   }
 
-  template <size_t... Indices, class... Types>
-  tuple_base& assign_impl(Types&&... args) {
-    ((get_value<Indices>(*this) = forward<Types>(args)), ...);
+  template <size_t... Idxs, class... Args>
+  tuple_base& assign_impl(Args&&... args) {
+    ((get_value<Idxs>(*this) = forward<Args>(args)), ...);
     return *this;
   }
 };
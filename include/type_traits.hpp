@@ -112,6 +112,31 @@ struct make_unsigned<long long> {
   using type = unsigned long long;
 };
 
+template <>
+struct make_unsigned<unsigned char> {
+  using type = unsigned char;
+};
+
+template <>
+struct make_unsigned<unsigned short> {
+  using type = unsigned short;
+};
+
+template <>
+struct make_unsigned<unsigned int> {
+  using type = unsigned int;
+};
+
+template <>
+struct make_unsigned<unsigned long> {
+  using type = unsigned long;
+};
+
+template <>
+struct make_unsigned<unsigned long long> {
+  using type = unsigned long long;
+};
+
 template <class IntegralTy>
 using make_unsigned_t = typename make_unsigned<IntegralTy>::type;
 
@@ -61,6 +61,9 @@ inline constexpr piecewise_construct_t piecewise_construct{};
 template <class...>
 class tuple;
 
+template <size_t Idx, class... Types>
+constexpr decltype(auto) get(tuple<Types...>& target) noexcept;
+
 // A custom pair implementation
 template <typename Ty1, typename Ty2>
 struct pair {
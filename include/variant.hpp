@@ -0,0 +1,716 @@
+#pragma once
+#include <basic_types.hpp>
+#include <functional.hpp>
+#include <ktlexcept.hpp>
+#include <memory_impl.hpp>
+#include <type_traits.hpp>
+#include <utility.hpp>
+
+namespace ktl {
+struct bad_variant_access : exception {
+  using MyBase = exception;
+
+  constexpr bad_variant_access() noexcept
+      : MyBase{"variant holds another alternative"} {}
+
+  [[nodiscard]] NTSTATUS code() const noexcept final {
+    return STATUS_OBJECT_TYPE_MISMATCH;
+  }
+};
+
+/**
+ * @struct monostate
+ * @brief Empty alternative of a variant which should be default-constructible
+ * even though its first meaningful alternative isn't
+ */
+struct monostate {};
+
+constexpr bool operator==(monostate, monostate) noexcept {
+  return true;
+}
+
+constexpr bool operator!=(monostate, monostate) noexcept {
+  return false;
+}
+
+inline constexpr size_t variant_npos{static_cast<size_t>(-1)};
+
+template <class... Types>
+class variant;
+
+template <class Ty>
+struct variant_size;
+
+template <class... Types>
+struct variant_size<variant<Types...>>
+    : integral_constant<size_t, sizeof...(Types)> {};
+
+template <class Ty>
+struct variant_size<const Ty> : variant_size<Ty> {};
+
+template <class Ty>
+inline constexpr size_t variant_size_v = variant_size<Ty>::value;
+
+template <size_t Idx, class Ty>
+struct variant_alternative;
+
+template <size_t Idx, class Ty, class... Types>
+struct variant_alternative<Idx, variant<Ty, Types...>>
+    : variant_alternative<Idx - 1, variant<Types...>> {};
+
+template <class Ty, class... Types>
+struct variant_alternative<0, variant<Ty, Types...>> {
+  using type = Ty;
+};
+
+template <size_t Idx, class Ty>
+struct variant_alternative<Idx, const Ty> {
+  using type = add_const_t<typename variant_alternative<Idx, Ty>::type>;
+};
+
+template <size_t Idx, class Ty>
+using variant_alternative_t = typename variant_alternative<Idx, Ty>::type;
+
+namespace var::details {
+struct non_trivial_dummy_type {
+  /*
+   * This default constructor is user-provided to avoid zero-initialization
+   * when objects are value-initialized
+   */
+  constexpr non_trivial_dummy_type() noexcept {}
+};
+
+// The index of a valueless variant is the maximum of the type
+template <size_t Count>
+using index_type_t =
+    conditional_t<(Count < 0xFF),
+                  uint8_t,
+                  conditional_t<(Count < 0xFFFF), uint16_t, uint32_t>>;
+
+template <class Ty, class... Types>
+struct find_type {
+  static constexpr size_t get() noexcept {
+    constexpr bool matches[]{is_same_v<Ty, Types>...};
+    size_t found{variant_npos};
+    for (size_t idx = 0; idx < sizeof...(Types); ++idx) {
+      if (matches[idx]) {
+        if (found != variant_npos) {
+          return variant_npos;  // Ambiguous
+        }
+        found = idx;
+      }
+    }
+    return found;
+  }
+
+  static constexpr size_t value{get()};
+};
+
+template <class Ty, class... Types>
+inline constexpr size_t find_type_v = find_type<Ty, Types...>::value;
+
+template <class Ty>
+struct is_in_place_tag : false_type {};
+
+template <class Ty>
+struct is_in_place_tag<in_place_type_t<Ty>> : true_type {};
+
+template <size_t Idx>
+struct is_in_place_tag<in_place_index_t<Idx>> : true_type {};
+
+template <class Ty>
+struct single_element_array {
+  Ty value[1];
+};
+
+/*
+ * The alternative selected by the converting constructor and assignment is
+ * the one which overload resolution picks among F(Types)... for the argument.
+ * As in C++20, narrowing conversions aren't considered, so a pointer doesn't
+ * select bool
+ */
+template <size_t Idx>
+struct no_overload {};
+
+template <size_t Idx, class Ty, class U, class = void>
+struct overload_entry {
+  void operator()(no_overload<Idx>) const;
+};
+
+template <size_t Idx, class Ty, class U>
+struct overload_entry<
+    Idx,
+    Ty,
+    U,
+    void_t<decltype(single_element_array<Ty>{{declval<U>()}})>> {
+  integral_constant<size_t, Idx> operator()(Ty) const;
+};
+
+template <class U, class Indices, class... Types>
+struct overload_set;
+
+template <class U, size_t... Indices, class... Types>
+struct overload_set<U, index_sequence<Indices...>, Types...>
+    : overload_entry<Indices, Types, U>... {
+  using overload_entry<Indices, Types, U>::operator()...;
+};
+
+template <class U, class... Types>
+using best_match_t =
+    decltype(overload_set<U, index_sequence_for<Types...>, Types...>{}(
+        declval<U>()));
+
+template <bool TriviallyDestructible, class... Types>
+union variadic_union {};
+
+#define VARIADIC_UNION_CONSTRUCTOR_SET                                    \
+  constexpr variadic_union() noexcept : m_dummy{} {}                      \
+                                                                          \
+  template <class... Args>                                                \
+  constexpr explicit variadic_union(in_place_index_t<0>, Args&&... args) \
+      : m_head(forward<Args>(args)...) {}                                 \
+                                                                          \
+  template <size_t Idx, class... Args>                                    \
+  constexpr explicit variadic_union(in_place_index_t<Idx>,                \
+                                    Args&&... args)                       \
+      : m_tail(in_place_index<Idx - 1>, forward<Args>(args)...) {}
+
+template <class Ty, class... Types>
+union variadic_union<true, Ty, Types...> {
+  VARIADIC_UNION_CONSTRUCTOR_SET
+  ~variadic_union() noexcept = default;
+
+  non_trivial_dummy_type m_dummy;
+  Ty m_head;
+  variadic_union<true, Types...> m_tail;
+};
+
+template <class Ty, class... Types>
+union variadic_union<false, Ty, Types...> {
+  VARIADIC_UNION_CONSTRUCTOR_SET
+  // The active alternative is destroyed by the variant
+  ~variadic_union() noexcept {}
+
+  non_trivial_dummy_type m_dummy;
+  Ty m_head;
+  variadic_union<false, Types...> m_tail;
+};
+
+#undef VARIADIC_UNION_CONSTRUCTOR_SET
+
+template <size_t Idx, class Union>
+constexpr decltype(auto) get_alternative(Union&& storage) noexcept {
+  if constexpr (Idx == 0) {
+    return (forward<Union>(storage).m_head);
+  } else {
+    return get_alternative<Idx - 1>(forward<Union>(storage).m_tail);
+  }
+}
+
+/*
+ * Calls fn(integral_constant<size_t, Idx>{}) for a run-time index through an
+ * array of function pointers, so the dispatch is a single indirect call
+ * whatever the number of the alternatives is
+ */
+template <class Ret, class Fn, class Indices>
+struct index_table;
+
+template <class Ret, class Fn, size_t... Indices>
+struct index_table<Ret, Fn, index_sequence<Indices...>> {
+  template <size_t Idx>
+  static constexpr Ret call(Fn&& fn) {
+    return forward<Fn>(fn)(integral_constant<size_t, Idx>{});
+  }
+
+  static constexpr Ret (*TABLE[])(Fn&&){&call<Indices>...};
+};
+
+template <class Ret, size_t Count, class Fn>
+constexpr Ret dispatch(size_t idx, Fn&& fn) {
+  return index_table<Ret, Fn, make_index_sequence<Count>>::TABLE[idx](
+      forward<Fn>(fn));
+}
+
+template <class... Types>
+class variant_storage_base {
+ public:
+  using index_type = index_type_t<sizeof...(Types)>;
+
+  static constexpr auto VALUELESS{static_cast<index_type>(-1)};
+  static constexpr bool TRIVIALLY_DESTRUCTIBLE{
+      conjunction_v<is_trivially_destructible<Types>...>};
+
+ public:
+  constexpr variant_storage_base() noexcept = default;
+
+  template <size_t Idx, class... Args>
+  constexpr explicit variant_storage_base(in_place_index_t<Idx> tag,
+                                          Args&&... args)
+      : m_storage(tag, forward<Args>(args)...),
+        m_index{static_cast<index_type>(Idx)} {}
+
+  [[nodiscard]] constexpr size_t index() const noexcept {
+    return m_index == VALUELESS ? variant_npos : m_index;
+  }
+
+  [[nodiscard]] constexpr bool valueless_by_exception() const noexcept {
+    return m_index == VALUELESS;
+  }
+
+ protected:
+  template <size_t Idx, class... Args>
+  void construct_alternative(Args&&... args) {
+    construct_at(addressof(get_alternative<Idx>(m_storage)),
+                 forward<Args>(args)...);
+    m_index = static_cast<index_type>(Idx);
+  }
+
+  // Construction with the same alternative as in other, which must be a
+  // variant_storage_base<Types...> and have a value
+  template <class Other>
+  void construct_from(Other&& other) {
+    dispatch<void, sizeof...(Types)>(other.m_index, [&](auto idx) {
+      construct_alternative<idx>(
+          get_alternative<idx>(forward<Other>(other).m_storage));
+    });
+  }
+
+  template <class Other>
+  void assign_from(Other&& other) {
+    if (other.m_index == VALUELESS) {
+      reset();
+    } else if (m_index == other.m_index) {
+      dispatch<void, sizeof...(Types)>(m_index, [&](auto idx) {
+        get_alternative<idx>(m_storage) =
+            get_alternative<idx>(forward<Other>(other).m_storage);
+      });
+    } else {
+      reset();
+      construct_from(forward<Other>(other));
+    }
+  }
+
+  constexpr void reset() noexcept {
+    if constexpr (!TRIVIALLY_DESTRUCTIBLE) {
+      if (m_index != VALUELESS) {
+        dispatch<void, sizeof...(Types)>(m_index, [this](auto idx) {
+          destroy_at(addressof(get_alternative<idx>(m_storage)));
+        });
+      }
+    }
+    m_index = VALUELESS;
+  }
+
+ protected:
+  variadic_union<TRIVIALLY_DESTRUCTIBLE, Types...> m_storage;
+  index_type m_index{VALUELESS};
+};
+
+template <bool TriviallyDestructible, class... Types>
+class variant_destructor_base : public variant_storage_base<Types...> {
+ private:
+  using MyBase = variant_storage_base<Types...>;
+
+ public:
+  using MyBase::MyBase;
+};
+
+template <class... Types>
+class variant_destructor_base<false, Types...>
+    : public variant_storage_base<Types...> {
+ private:
+  using MyBase = variant_storage_base<Types...>;
+
+ public:
+  using MyBase::MyBase;
+
+  variant_destructor_base() = default;
+  variant_destructor_base(const variant_destructor_base&) = default;
+  variant_destructor_base(variant_destructor_base&&) = default;
+  variant_destructor_base& operator=(const variant_destructor_base&) = default;
+  variant_destructor_base& operator=(variant_destructor_base&&) = default;
+
+  ~variant_destructor_base() noexcept { MyBase::reset(); }
+};
+
+template <class... Types>
+using variant_destructor_base_t =
+    variant_destructor_base<conjunction_v<is_trivially_destructible<Types>...>,
+                            Types...>;
+
+template <bool TriviallyCopyable, class... Types>
+class variant_copy_base : public variant_destructor_base_t<Types...> {
+ private:
+  using MyBase = variant_destructor_base_t<Types...>;
+
+ public:
+  using MyBase::MyBase;
+};
+
+template <class... Types>
+class variant_copy_base<false, Types...>
+    : public variant_destructor_base_t<Types...> {
+ private:
+  using MyBase = variant_destructor_base_t<Types...>;
+
+ public:
+  using MyBase::MyBase;
+
+  variant_copy_base() = default;
+
+  variant_copy_base(const variant_copy_base& other) noexcept(
+      conjunction_v<is_nothrow_copy_constructible<Types>...>) {
+    if (!other.valueless_by_exception()) {
+      MyBase::construct_from(other);
+    }
+  }
+
+  variant_copy_base(variant_copy_base&& other) noexcept(
+      conjunction_v<is_nothrow_move_constructible<Types>...>) {
+    if (!other.valueless_by_exception()) {
+      MyBase::construct_from(move(other));
+    }
+  }
+
+  variant_copy_base& operator=(const variant_copy_base& other) {
+    if (addressof(other) != this) {
+      MyBase::assign_from(other);
+    }
+    return *this;
+  }
+
+  variant_copy_base& operator=(variant_copy_base&& other) noexcept(
+      conjunction_v<is_nothrow_move_constructible<Types>...,
+                    is_nothrow_move_assignable<Types>...>) {
+    if (addressof(other) != this) {
+      MyBase::assign_from(move(other));
+    }
+    return *this;
+  }
+};
+
+template <class... Types>
+using variant_copy_base_t =
+    variant_copy_base<conjunction_v<is_trivially_copyable<Types>...>,
+                      Types...>;
+
+struct variant_access {
+  template <size_t Idx, class Variant>
+  static constexpr decltype(auto) get(Variant&& target) noexcept {
+    return get_alternative<Idx>(forward<Variant>(target).m_storage);
+  }
+};
+
+template <class Fn, class Combinations, class... Variants>
+struct visit_table;
+
+/*
+ * Entry `flat` of the table handles the combination of the alternatives in
+ * which the index of the last variant changes the fastest
+ */
+template <class Fn, size_t... Flat, class... Variants>
+struct visit_table<Fn, index_sequence<Flat...>, Variants...> {
+  static constexpr size_t SIZES[]{
+      variant_size_v<remove_reference_t<Variants>>...};
+
+  using result_type =
+      invoke_result_t<Fn,
+                      decltype(variant_access::get<0>(declval<Variants>()))...>;
+
+  static constexpr size_t get_index(size_t flat, size_t pos) noexcept {
+    for (size_t next = sizeof...(Variants); next > pos + 1; --next) {
+      flat /= SIZES[next - 1];
+    }
+    return flat % SIZES[pos];
+  }
+
+  static constexpr size_t get_flat_index(const Variants&... targets) noexcept {
+    size_t flat{0};
+    ((flat = flat * variant_size_v<remove_reference_t<Variants>> +
+             targets.index()),
+     ...);
+    return flat;
+  }
+
+  template <size_t Idx, size_t... Positions>
+  static constexpr result_type call_alternatives(index_sequence<Positions...>,
+                                                 Fn&& fn,
+                                                 Variants&&... targets) {
+    return invoke(forward<Fn>(fn),
+                  variant_access::get<get_index(Idx, Positions)>(
+                      forward<Variants>(targets))...);
+  }
+
+  template <size_t Idx>
+  static constexpr result_type call(Fn&& fn, Variants&&... targets) {
+    return call_alternatives<Idx>(index_sequence_for<Variants...>{},
+                                  forward<Fn>(fn),
+                                  forward<Variants>(targets)...);
+  }
+
+  static constexpr result_type (*TABLE[])(Fn&&, Variants&&...){
+      &call<Flat>...};
+};
+
+template <class Fn, class... Variants>
+using visit_table_t = visit_table<
+    Fn,
+    make_index_sequence<(variant_size_v<remove_reference_t<Variants>> * ... *
+                         1)>,
+    Variants...>;
+}  // namespace var::details
+
+/**
+ * @class variant
+ * @brief Type-safe union holding one of Types, e.g. the body of a message
+ * instead of a tag field with a union or a hierarchy allocated on the heap
+ * @details The index is kept in the smallest unsigned type fitting
+ * sizeof...(Types) alternatives, so variant<uint32_t, float> takes 8 bytes.
+ * The variant is trivially copyable and destructible if all of the
+ * alternatives are. visit() and the internal dispatch use a table of function
+ * pointers instead of a chain of comparisons. If constructing a new
+ * alternative throws, the variant becomes valueless_by_exception()
+ */
+template <class... Types>
+class variant : public var::details::variant_copy_base_t<Types...> {
+  static_assert(sizeof...(Types) > 0, "variant must have an alternative");
+  static_assert(
+      conjunction_v<negation<is_reference<Types>>...,
+                    negation<is_array<Types>>...,
+                    negation<is_void<Types>>...>,
+      "alternatives must be object types");
+
+ private:
+  using MyBase = var::details::variant_copy_base_t<Types...>;
+
+  template <class Ty>
+  static constexpr size_t INDEX_OF{var::details::find_type_v<Ty, Types...>};
+
+  template <size_t Idx>
+  using alternative_type = variant_alternative_t<Idx, variant>;
+
+  friend struct var::details::variant_access;
+
+ public:
+  using index_type = typename MyBase::index_type;
+
+ public:
+  /**
+   * @fn variant::variant
+   * @brief Value-initializes the first alternative
+   */
+  template <class Ty = alternative_type<0>,
+            enable_if_t<is_default_constructible_v<Ty>, int> = 0>
+  constexpr variant() noexcept(is_nothrow_default_constructible_v<Ty>)
+      : MyBase(in_place_index<0>) {}
+
+  /**
+   * @fn variant::variant
+   * @brief Holds the alternative selected by the overload resolution among
+   * F(Types)... for `value`
+   */
+  template <
+      class U,
+      enable_if_t<!is_same_v<remove_cvref_t<U>, variant> &&
+                      !var::details::is_in_place_tag<remove_cvref_t<U>>::value,
+                  int> = 0,
+      class Match = var::details::best_match_t<U, Types...>>
+  constexpr variant(U&& value) noexcept(
+      is_nothrow_constructible_v<alternative_type<Match::value>, U>)
+      : MyBase(in_place_index<Match::value>, forward<U>(value)) {}
+
+  template <size_t Idx,
+            class... Args,
+            enable_if_t<(Idx < sizeof...(Types)), int> = 0>
+  constexpr explicit variant(in_place_index_t<Idx> tag, Args&&... args)
+      : MyBase(tag, forward<Args>(args)...) {}
+
+  template <class Ty,
+            class... Args,
+            size_t Idx = INDEX_OF<Ty>,
+            enable_if_t<Idx != variant_npos, int> = 0>
+  constexpr explicit variant(in_place_type_t<Ty>, Args&&... args)
+      : MyBase(in_place_index<Idx>, forward<Args>(args)...) {}
+
+  template <
+      class U,
+      enable_if_t<!is_same_v<remove_cvref_t<U>, variant>, int> = 0,
+      class Match = var::details::best_match_t<U, Types...>>
+  variant& operator=(U&& value) {
+    constexpr size_t idx{Match::value};
+    if (this->m_index == idx) {
+      var::details::get_alternative<idx>(this->m_storage) = forward<U>(value);
+    } else {
+      emplace<idx>(forward<U>(value));
+    }
+    return *this;
+  }
+
+  using MyBase::index;
+  using MyBase::valueless_by_exception;
+
+  /**
+   * @fn variant::emplace
+   * @brief Destroys the current alternative and constructs the new one
+   * @throw Any exception thrown by the constructor of the alternative, in
+   * which case the variant becomes valueless
+   */
+  template <size_t Idx, class... Args>
+  alternative_type<Idx>& emplace(Args&&... args) {
+    static_assert(Idx < sizeof...(Types), "index is out of range");
+    MyBase::reset();
+    MyBase::template construct_alternative<Idx>(forward<Args>(args)...);
+    return var::details::get_alternative<Idx>(this->m_storage);
+  }
+
+  template <class Ty, class... Args>
+  Ty& emplace(Args&&... args) {
+    static_assert(INDEX_OF<Ty> != variant_npos,
+                  "type must occur exactly once in Types");
+    return emplace<INDEX_OF<Ty>>(forward<Args>(args)...);
+  }
+
+  void swap(variant& other) noexcept(
+      conjunction_v<is_nothrow_move_constructible<Types>...,
+                    is_nothrow_swappable<Types>...>) {
+    if (this->m_index == other.m_index) {
+      if (!valueless_by_exception()) {
+        var::details::dispatch<void, sizeof...(Types)>(
+            this->m_index, [&](auto idx) {
+              ktl::swap(var::details::get_alternative<idx>(this->m_storage),
+                        var::details::get_alternative<idx>(other.m_storage));
+            });
+      }
+    } else {
+      variant tmp{move(other)};
+      other = move(*this);
+      *this = move(tmp);
+    }
+  }
+};
+
+template <class Ty, class... Types>
+constexpr bool holds_alternative(const variant<Types...>& target) noexcept {
+  constexpr size_t idx{var::details::find_type_v<Ty, Types...>};
+  static_assert(idx != variant_npos, "type must occur exactly once in Types");
+  return target.index() == idx;
+}
+
+/**
+ * @fn get
+ * @throw bad_variant_access if the variant holds another alternative
+ */
+template <size_t Idx, class... Types>
+constexpr variant_alternative_t<Idx, variant<Types...>>& get(
+    variant<Types...>& target) {
+  throw_exception_if_not<bad_variant_access>(target.index() == Idx);
+  return var::details::variant_access::get<Idx>(target);
+}
+
+template <size_t Idx, class... Types>
+constexpr const variant_alternative_t<Idx, variant<Types...>>& get(
+    const variant<Types...>& target) {
+  throw_exception_if_not<bad_variant_access>(target.index() == Idx);
+  return var::details::variant_access::get<Idx>(target);
+}
+
+template <size_t Idx, class... Types>
+constexpr variant_alternative_t<Idx, variant<Types...>>&& get(
+    variant<Types...>&& target) {
+  throw_exception_if_not<bad_variant_access>(target.index() == Idx);
+  return var::details::variant_access::get<Idx>(move(target));
+}
+
+template <class Ty, class... Types>
+constexpr Ty& get(variant<Types...>& target) {
+  return get<var::details::find_type_v<Ty, Types...>>(target);
+}
+
+template <class Ty, class... Types>
+constexpr const Ty& get(const variant<Types...>& target) {
+  return get<var::details::find_type_v<Ty, Types...>>(target);
+}
+
+template <class Ty, class... Types>
+constexpr Ty&& get(variant<Types...>&& target) {
+  return get<var::details::find_type_v<Ty, Types...>>(move(target));
+}
+
+/**
+ * @fn get_if
+ * @return Pointer to the alternative or nullptr if the variant holds another
+ * one
+ */
+template <size_t Idx, class... Types>
+constexpr add_pointer_t<variant_alternative_t<Idx, variant<Types...>>> get_if(
+    variant<Types...>* target) noexcept {
+  if (!target || target->index() != Idx) {
+    return nullptr;
+  }
+  return addressof(var::details::variant_access::get<Idx>(*target));
+}
+
+template <size_t Idx, class... Types>
+constexpr add_pointer_t<const variant_alternative_t<Idx, variant<Types...>>>
+get_if(const variant<Types...>* target) noexcept {
+  if (!target || target->index() != Idx) {
+    return nullptr;
+  }
+  return addressof(var::details::variant_access::get<Idx>(*target));
+}
+
+template <class Ty, class... Types>
+constexpr add_pointer_t<Ty> get_if(variant<Types...>* target) noexcept {
+  return get_if<var::details::find_type_v<Ty, Types...>>(target);
+}
+
+template <class Ty, class... Types>
+constexpr add_pointer_t<const Ty> get_if(
+    const variant<Types...>* target) noexcept {
+  return get_if<var::details::find_type_v<Ty, Types...>>(target);
+}
+
+/**
+ * @fn visit
+ * @brief Calls fn with the alternatives held by the variants. The call is
+ * made through a table of function pointers with an entry for each
+ * combination of the alternatives
+ * @throw bad_variant_access if any of the variants is valueless
+ */
+template <class Fn, class... Variants>
+constexpr decltype(auto) visit(Fn&& fn, Variants&&... targets) {
+  using table_type = var::details::visit_table_t<Fn, Variants...>;
+  throw_exception_if<bad_variant_access>(
+      (targets.valueless_by_exception() || ... || false));
+  return table_type::TABLE[table_type::get_flat_index(targets...)](
+      forward<Fn>(fn), forward<Variants>(targets)...);
+}
+
+template <class... Types>
+void swap(variant<Types...>& lhs, variant<Types...>& rhs) noexcept(
+    noexcept(lhs.swap(rhs))) {
+  lhs.swap(rhs);
+}
+
+template <class... Types>
+constexpr bool operator==(const variant<Types...>& lhs,
+                          const variant<Types...>& rhs) {
+  if (lhs.index() != rhs.index()) {
+    return false;
+  }
+  if (lhs.valueless_by_exception()) {
+    return true;
+  }
+  return var::details::dispatch<bool, sizeof...(Types)>(
+      lhs.index(), [&](auto idx) {
+        return var::details::variant_access::get<idx>(lhs) ==
+               var::details::variant_access::get<idx>(rhs);
+      });
+}
+
+template <class... Types>
+constexpr bool operator!=(const variant<Types...>& lhs,
+                          const variant<Types...>& rhs) {
+  return !(lhs == rhs);
+}
+}  // namespace ktl
@@ -678,13 +678,13 @@ class vector {
   }
 
   void swap_impl(vector& other, true_type) noexcept {
-    ::swap(m_impl, other.m_impl);
+    ktl::swap(m_impl, other.m_impl);
   }
 
   void swap_impl(vector& other, false_type) noexcept(
       allocator_traits_type::is_always_equal::value) {
     if (alc::details::allocators_are_equal(get_alloc(), other.get_alloc())) {
-      ::swap(m_impl.get_second(), other.m_impl.get_second());
+      ktl::swap(m_impl.get_second(), other.m_impl.get_second());
     }
     assert_with_msg(get_alloc() == other.get_alloc(),
                     "vectors are not swappable due to incompatible allocators");
@@ -0,0 +1,323 @@
+#pragma once
+/*
+ * LZ4 block format compatible compressor and decompressor. Both work on the
+ * caller's buffers and never allocate: the compressor's hash table is either
+ * placed on the stack or preallocated by the caller and reused. The header
+ * is self-contained, so the user-mode code may include it without KTL.
+ *
+ * A block is a sequence of:
+ *   token        literal length (high nibble), match length - 4 (low nibble)
+ *   [length]     255-bytes continuation of the literal length if it's >= 15
+ *   literals
+ *   offset       2 bytes, little-endian, 1..65535
+ *   [length]     continuation of the match length if it's >= 15 + 4
+ * The last sequence has literals only. The last match starts at least 12 bytes
+ * before the end of the input and the last 5 bytes are always literals.
+ */
+#ifdef KTL_NO_CXX_STANDARD_LIBRARY
+#include <basic_types.hpp>
+#include <intrinsic.hpp>
+#else
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#endif
+
+namespace ktl::lz4 {
+inline constexpr size_t MAX_INPUT_SIZE{0x7e000000};
+inline constexpr size_t INVALID_SIZE{static_cast<size_t>(-1)};
+inline constexpr uint32_t DEFAULT_HASH_LOG{12};
+
+/**
+ * @fn lz4::compress_bound
+ * @return Size of the destination which always fits the compressed block
+ */
+constexpr size_t compress_bound(size_t size) noexcept {
+  return size + size / 255 + 16;
+}
+
+/**
+ * @struct hash_table
+ * @brief Positions of the recently seen 4-byte sequences. 2^HashLog * 4 bytes,
+ * so the default 16 KiB table must not be placed on the kernel stack
+ */
+template <uint32_t HashLog = DEFAULT_HASH_LOG>
+struct hash_table {
+  static_assert(HashLog >= 8 && HashLog <= 16, "HashLog must be in [8, 16]");
+
+  static constexpr uint32_t SIZE{1u << HashLog};
+
+  uint32_t positions[SIZE];
+};
+
+namespace details {
+inline constexpr size_t MIN_MATCH{4};
+inline constexpr size_t LAST_LITERALS{5};
+inline constexpr size_t MF_LIMIT{12};
+inline constexpr size_t MAX_DISTANCE{65535};
+inline constexpr uint32_t SKIP_TRIGGER{6};
+inline constexpr uint32_t RUN_MASK{15};
+
+inline uint32_t read32(const unsigned char* ptr) noexcept {
+  uint32_t value;
+  memcpy(&value, ptr, sizeof(value));
+  return value;
+}
+
+inline uint64_t read64(const unsigned char* ptr) noexcept {
+  uint64_t value;
+  memcpy(&value, ptr, sizeof(value));
+  return value;
+}
+
+template <uint32_t HashLog>
+uint32_t hash_sequence(uint32_t sequence) noexcept {
+  return (sequence * 2654435761u) >> (32 - HashLog);
+}
+
+inline unsigned char* write_length(unsigned char* out, size_t length) noexcept {
+  for (; length >= 255; length -= 255) {
+    *out++ = 255;
+  }
+  *out++ = static_cast<unsigned char>(length);
+  return out;
+}
+
+// Number of the equal bytes at ptr and match, not reaching limit
+inline size_t count_match(const unsigned char* ptr,
+                          const unsigned char* match,
+                          const unsigned char* limit) noexcept {
+  const unsigned char* const start{ptr};
+  while (ptr + sizeof(uint64_t) <= limit) {
+    const uint64_t diff{read64(ptr) ^ read64(match)};
+    if (diff) {
+      for (uint64_t mask = 0xff; !(diff & mask); mask <<= 8) {
+        ++ptr;
+      }
+      return static_cast<size_t>(ptr - start);
+    }
+    ptr += sizeof(uint64_t);
+    match += sizeof(uint64_t);
+  }
+  while (ptr < limit && *ptr == *match) {
+    ++ptr;
+    ++match;
+  }
+  return static_cast<size_t>(ptr - start);
+}
+
+// Token and literals. Returns nullptr if they don't fit into the destination
+// along with the reserved bytes
+inline unsigned char* write_literals(unsigned char* out,
+                                     const unsigned char* out_end,
+                                     const unsigned char* literals,
+                                     size_t length,
+                                     size_t reserved,
+                                     unsigned char*& token) noexcept {
+  if (static_cast<size_t>(out_end - out) <
+      1 + length / 255 + 1 + length + reserved) {
+    return nullptr;
+  }
+  token = out++;
+  if (length >= RUN_MASK) {
+    *token = static_cast<unsigned char>(RUN_MASK << 4);
+    out = write_length(out, length - RUN_MASK);
+  } else {
+    *token = static_cast<unsigned char>(length << 4);
+  }
+  if (length) {
+    memcpy(out, literals, length);
+  }
+  return out + length;
+}
+}  // namespace details
+
+/**
+ * @fn lz4::compress_block
+ * @brief Compresses the data into a single LZ4 block
+ * @param[in] table Scratch space, its previous content doesn't matter
+ * @return Size of the block or 0 if it doesn't fit into the destination
+ * or the source is larger than MAX_INPUT_SIZE
+ */
+template <uint32_t HashLog>
+size_t compress_block(const void* source,
+                      size_t source_size,
+                      void* destination,
+                      size_t capacity,
+                      hash_table<HashLog>& table) noexcept {
+  using namespace details;
+
+  if (source_size > MAX_INPUT_SIZE) {
+    return 0;
+  }
+  const auto* const base{static_cast<const unsigned char*>(source)};
+  const unsigned char* const in_end{base + source_size};
+  const unsigned char* anchor{base};
+  auto* const out_begin{static_cast<unsigned char*>(destination)};
+  unsigned char* const out_end{out_begin + capacity};
+  unsigned char* out{out_begin};
+
+  if (source_size >= MF_LIMIT + 1) {
+    const unsigned char* const match_start_limit{in_end - MF_LIMIT};
+    const unsigned char* const match_end_limit{in_end - LAST_LITERALS};
+    memset(table.positions, 0, sizeof(table.positions));
+
+    const unsigned char* in{base + 1};
+    for (;;) {
+      // Stale positions only cost a comparison, so the table isn't verified
+      const unsigned char* match;
+      uint32_t attempts{1u << SKIP_TRIGGER};
+      for (;;) {
+        if (in > match_start_limit) {
+          goto last_literals;
+        }
+        const uint32_t hash{hash_sequence<HashLog>(read32(in))};
+        match = base + table.positions[hash];
+        table.positions[hash] = static_cast<uint32_t>(in - base);
+        if (match < in && static_cast<size_t>(in - match) <= MAX_DISTANCE &&
+            read32(match) == read32(in)) {
+          break;
+        }
+        in += attempts++ >> SKIP_TRIGGER;  // Accelerates over random data
+      }
+      while (in > anchor && match > base && in[-1] == match[-1]) {
+        --in;
+        --match;
+      }
+
+      unsigned char* token;
+      out = write_literals(out, out_end, anchor,
+                           static_cast<size_t>(in - anchor),
+                           2 + 1 + LAST_LITERALS, token);
+      if (!out) {
+        return 0;
+      }
+      const auto offset{static_cast<uint32_t>(in - match)};
+      *out++ = static_cast<unsigned char>(offset);
+      *out++ = static_cast<unsigned char>(offset >> 8);
+
+      const size_t match_length{
+          count_match(in + MIN_MATCH, match + MIN_MATCH, match_end_limit)};
+      in += MIN_MATCH + match_length;
+      if (match_length >= RUN_MASK) {
+        if (static_cast<size_t>(out_end - out) <
+            match_length / 255 + 1 + LAST_LITERALS) {
+          return 0;
+        }
+        *token |= static_cast<unsigned char>(RUN_MASK);
+        out = write_length(out, match_length - RUN_MASK);
+      } else {
+        *token |= static_cast<unsigned char>(match_length);
+      }
+      anchor = in;
+
+      if (in > match_start_limit) {
+        break;
+      }
+      const uint32_t hash{hash_sequence<HashLog>(read32(in - 2))};
+      table.positions[hash] = static_cast<uint32_t>(in - 2 - base);
+    }
+  }
+
+last_literals:
+  unsigned char* token;
+  out = write_literals(out, out_end, anchor,
+                       static_cast<size_t>(in_end - anchor), 0, token);
+  return out ? static_cast<size_t>(out - out_begin) : 0;
+}
+
+/**
+ * @fn lz4::compress_block
+ * @brief Compresses the data with a 4 KiB hash table on the stack. Suitable
+ * for the small inputs, the larger tables find more matches
+ */
+inline size_t compress_block(const void* source,
+                             size_t source_size,
+                             void* destination,
+                             size_t capacity) noexcept {
+  hash_table<10> table;
+  return compress_block(source, source_size, destination, capacity, table);
+}
+
+/**
+ * @fn lz4::decompress_block
+ * @brief Decompresses a single LZ4 block. Malformed input is detected and
+ * never causes reads or writes outside of the buffers
+ * @return Size of the decompressed data or INVALID_SIZE if the block is
+ * malformed or doesn't fit into the destination
+ */
+inline size_t decompress_block(const void* source,
+                               size_t source_size,
+                               void* destination,
+                               size_t capacity) noexcept {
+  using namespace details;
+
+  const auto* in{static_cast<const unsigned char*>(source)};
+  const unsigned char* const in_end{in + source_size};
+  auto* const out_begin{static_cast<unsigned char*>(destination)};
+  unsigned char* const out_end{out_begin + capacity};
+  unsigned char* out{out_begin};
+
+  const auto read_length{[&in, in_end](size_t& length) noexcept {
+    unsigned char next;
+    do {
+      if (in == in_end) {
+        return false;
+      }
+      next = *in++;
+      length += next;
+    } while (next == 255);
+    return true;
+  }};
+
+  for (;;) {
+    if (in == in_end) {
+      return INVALID_SIZE;
+    }
+    const unsigned char token{*in++};
+    size_t literal_length{static_cast<size_t>(token >> 4)};
+    if (literal_length == RUN_MASK && !read_length(literal_length)) {
+      return INVALID_SIZE;
+    }
+    if (literal_length > static_cast<size_t>(in_end - in) ||
+        literal_length > static_cast<size_t>(out_end - out)) {
+      return INVALID_SIZE;
+    }
+    if (literal_length) {
+      memcpy(out, in, literal_length);
+    }
+    in += literal_length;
+    out += literal_length;
+    if (in == in_end) {
+      break;  // The last sequence
+    }
+
+    if (in_end - in < 2) {
+      return INVALID_SIZE;
+    }
+    const size_t offset{static_cast<size_t>(in[0] | in[1] << 8)};
+    in += 2;
+    if (offset == 0 || offset > static_cast<size_t>(out - out_begin)) {
+      return INVALID_SIZE;
+    }
+    size_t match_length{static_cast<size_t>(token & RUN_MASK)};
+    if (match_length == RUN_MASK && !read_length(match_length)) {
+      return INVALID_SIZE;
+    }
+    match_length += MIN_MATCH;
+    if (match_length > static_cast<size_t>(out_end - out)) {
+      return INVALID_SIZE;
+    }
+    const unsigned char* match{out - offset};
+    if (offset >= match_length) {
+      memcpy(out, match, match_length);
+      out += match_length;
+    } else {  // Overlapping copy repeats the pattern
+      for (const unsigned char* end = out + match_length; out < end;) {
+        *out++ = *match++;
+      }
+    }
+  }
+  return static_cast<size_t>(out - out_begin);
+}
+}  // namespace ktl::lz4
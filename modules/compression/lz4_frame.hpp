@@ -0,0 +1,364 @@
+#pragma once
+/*
+ * LZ4 frame format (the format of the .lz4 files) on top of the blocks:
+ *
+ *   magic        0x184d2204, little-endian
+ *   FLG, BD      version, flags and the maximal block size
+ *   [size]       8 bytes of the content size if FLG has it
+ *   HC           (XXH32 of FLG..size >> 8) & 0xff
+ *   blocks       4 bytes of the size (the high bit marks an uncompressed
+ *                block), the data and optional 4 bytes of its XXH32
+ *   end mark     4 zero bytes
+ *   [checksum]   XXH32 of the content if FLG has it
+ *
+ * The writer produces independent blocks, so each of them is decompressed on
+ * its own and the reader needs no history. Dictionaries aren't supported.
+ */
+// With " " instead of <> there is no need to add compression/ to include path
+#include "lz4_block.hpp"
+#include "xxhash32.hpp"
+
+namespace ktl::lz4 {
+inline constexpr uint32_t FRAME_MAGIC{0x184d2204};
+inline constexpr size_t MAX_FRAME_HEADER_SIZE{4 + 2 + 8 + 1};
+inline constexpr size_t MAX_FRAME_END_SIZE{4 + 4};
+
+enum class block_size_id : uint8_t {
+  max_64kb = 4,
+  max_256kb = 5,
+  max_1mb = 6,
+  max_4mb = 7,
+};
+
+constexpr size_t get_block_size(block_size_id id) noexcept {
+  return size_t{1} << (8 + 2 * static_cast<uint32_t>(id));
+}
+
+struct frame_options {
+  block_size_id block_size{block_size_id::max_64kb};
+  bool block_checksum{false};
+  bool content_checksum{true};
+  uint64_t content_size{0};  //!< Stored in the header unless it's 0
+};
+
+namespace details {
+inline constexpr unsigned char FLG_VERSION{0x40};
+inline constexpr unsigned char FLG_VERSION_MASK{0xc0};
+inline constexpr unsigned char FLG_BLOCK_INDEPENDENCE{0x20};
+inline constexpr unsigned char FLG_BLOCK_CHECKSUM{0x10};
+inline constexpr unsigned char FLG_CONTENT_SIZE{0x08};
+inline constexpr unsigned char FLG_CONTENT_CHECKSUM{0x04};
+inline constexpr unsigned char FLG_RESERVED{0x02};
+inline constexpr unsigned char FLG_DICTIONARY_ID{0x01};
+inline constexpr uint32_t UNCOMPRESSED_BLOCK{0x80000000};
+
+inline unsigned char header_checksum(const unsigned char* descriptor,
+                                     size_t size) noexcept {
+  return static_cast<unsigned char>(
+      compression::xxhash32::compute(descriptor, size) >> 8);
+}
+}  // namespace details
+
+/**
+ * @class frame_writer
+ * @brief Produces an LZ4 frame block by block into the caller's buffers.
+ * The hash table is a member, so the writer should be allocated once and
+ * reused rather than placed on the kernel stack
+ */
+template <uint32_t HashLog = DEFAULT_HASH_LOG>
+class frame_writer {
+ public:
+  explicit frame_writer(const frame_options& options = {}) noexcept
+      : m_options{options} {}
+
+  [[nodiscard]] size_t block_size() const noexcept {
+    return get_block_size(m_options.block_size);
+  }
+
+  /**
+   * @fn frame_writer::block_bound
+   * @return Size of the destination which always fits the block of the
+   * given size
+   */
+  [[nodiscard]] size_t block_bound(size_t size) const noexcept {
+    return 4 + size + (m_options.block_checksum ? 4 : 0);
+  }
+
+  /**
+   * @fn frame_writer::write_header
+   * @brief Starts a new frame
+   * @return Size of the header or 0 if the destination is too small
+   */
+  size_t write_header(void* destination, size_t capacity) noexcept {
+    using namespace details;
+    using compression::details::write_le32;
+
+    const size_t header_size{4 + 2 + (m_options.content_size ? 8u : 0u) + 1};
+    if (capacity < header_size) {
+      return 0;
+    }
+    auto* out{static_cast<unsigned char*>(destination)};
+    write_le32(out, FRAME_MAGIC);
+    unsigned char flags{FLG_VERSION | FLG_BLOCK_INDEPENDENCE};
+    if (m_options.block_checksum) {
+      flags |= FLG_BLOCK_CHECKSUM;
+    }
+    if (m_options.content_size) {
+      flags |= FLG_CONTENT_SIZE;
+    }
+    if (m_options.content_checksum) {
+      flags |= FLG_CONTENT_CHECKSUM;
+    }
+    out[4] = flags;
+    out[5] = static_cast<unsigned char>(
+        static_cast<uint32_t>(m_options.block_size) << 4);
+    if (m_options.content_size) {
+      write_le32(out + 6, static_cast<uint32_t>(m_options.content_size));
+      write_le32(out + 10, static_cast<uint32_t>(m_options.content_size >> 32));
+    }
+    out[header_size - 1] = header_checksum(out + 4, header_size - 5);
+    m_content_hash.reset();
+    return header_size;
+  }
+
+  /**
+   * @fn frame_writer::write_block
+   * @brief Compresses the data into the next block. Stores it as is if it
+   * doesn't shrink
+   * @param[in] size Up to block_size() bytes
+   * @param[in] capacity At least block_bound(size) bytes
+   * @return Size of the block or 0 if the arguments are invalid
+   */
+  size_t write_block(const void* source,
+                     size_t size,
+                     void* destination,
+                     size_t capacity) noexcept {
+    using namespace details;
+    using compression::details::write_le32;
+
+    if (size == 0 || size > block_size() || capacity < block_bound(size)) {
+      return 0;
+    }
+    auto* out{static_cast<unsigned char*>(destination)};
+    size_t stored_size{
+        compress_block(source, size, out + 4, size - 1, m_table)};
+    if (stored_size) {
+      write_le32(out, static_cast<uint32_t>(stored_size));
+    } else {
+      memcpy(out + 4, source, size);
+      stored_size = size;
+      write_le32(out, static_cast<uint32_t>(size) | UNCOMPRESSED_BLOCK);
+    }
+    if (m_options.block_checksum) {
+      write_le32(out + 4 + stored_size,
+                 compression::xxhash32::compute(out + 4, stored_size));
+    }
+    if (m_options.content_checksum) {
+      m_content_hash.update(source, size);
+    }
+    return block_bound(stored_size);
+  }
+
+  /**
+   * @fn frame_writer::write_end
+   * @brief Finishes the frame
+   * @return Size of the end mark and the checksum or 0 if the destination is
+   * too small
+   */
+  size_t write_end(void* destination, size_t capacity) noexcept {
+    using compression::details::write_le32;
+
+    const size_t end_size{4 + size_t{m_options.content_checksum ? 4u : 0u}};
+    if (capacity < end_size) {
+      return 0;
+    }
+    auto* out{static_cast<unsigned char*>(destination)};
+    write_le32(out, 0);
+    if (m_options.content_checksum) {
+      write_le32(out + 4, m_content_hash.digest());
+    }
+    return end_size;
+  }
+
+ private:
+  frame_options m_options;
+  hash_table<HashLog> m_table;
+  compression::xxhash32 m_content_hash;
+};
+
+enum class frame_status {
+  ok,
+  need_more_input,   //!< The next header or block isn't complete
+  output_too_small,  //!< The destination is less than block_size()
+  finished,
+  corrupted,
+  unsupported,  //!< The blocks are linked: only the independent ones are read
+};
+
+struct frame_result {
+  frame_status status;
+  size_t consumed;
+  size_t produced;
+};
+
+/**
+ * @class frame_reader
+ * @brief Decodes an LZ4 frame from the caller's buffers
+ * @details Each read() processes the header, one block or the end of the
+ * frame if it's completely available and reports the consumed and produced
+ * bytes. Otherwise it consumes nothing and asks for more input, so the caller
+ * appends the next data to the unconsumed bytes and repeats. The blocks must
+ * be independent: a frame of the linked ones is reported as unsupported.
+ */
+class frame_reader {
+ public:
+  /**
+   * @fn frame_reader::block_size
+   * @return Maximal size of the decompressed block, valid after the header
+   */
+  [[nodiscard]] size_t block_size() const noexcept { return m_block_size; }
+
+  [[nodiscard]] bool finished() const noexcept {
+    return m_stage == stage::finished;
+  }
+
+  void reset() noexcept { *this = frame_reader{}; }
+
+  frame_result read(const void* source,
+                    size_t size,
+                    void* destination,
+                    size_t capacity) noexcept {
+    const auto* in{static_cast<const unsigned char*>(source)};
+    switch (m_stage) {
+      case stage::header:
+        return read_header(in, size);
+      case stage::blocks:
+        return read_block(in, size, static_cast<unsigned char*>(destination),
+                          capacity);
+      default:
+        return {frame_status::finished, 0, 0};
+    }
+  }
+
+ private:
+  enum class stage { header, blocks, finished };
+
+  frame_result read_header(const unsigned char* in, size_t size) noexcept {
+    using namespace details;
+    using compression::details::read_le32;
+
+    if (size < 7) {
+      return {frame_status::need_more_input, 0, 0};
+    }
+    const unsigned char flags{in[4]};
+    const unsigned char block_descriptor{in[5]};
+    const uint32_t size_id{static_cast<uint32_t>(block_descriptor >> 4) & 7};
+    if (read_le32(in) != FRAME_MAGIC ||
+        (flags & FLG_VERSION_MASK) != FLG_VERSION ||
+        (flags & (FLG_RESERVED | FLG_DICTIONARY_ID)) ||
+        (block_descriptor & 0x8f) || size_id < 4) {
+      return {frame_status::corrupted, 0, 0};
+    }
+    const bool has_content_size{(flags & FLG_CONTENT_SIZE) != 0};
+    const size_t header_size{4 + 2 + (has_content_size ? 8u : 0u) + 1};
+    if (size < header_size) {
+      return {frame_status::need_more_input, 0, 0};
+    }
+    if (in[header_size - 1] != header_checksum(in + 4, header_size - 5)) {
+      return {frame_status::corrupted, 0, 0};
+    }
+    if (!(flags & FLG_BLOCK_INDEPENDENCE)) {
+      return {frame_status::unsupported, 0, 0};
+    }
+    m_block_size = get_block_size(static_cast<block_size_id>(size_id));
+    m_block_checksum = (flags & FLG_BLOCK_CHECKSUM) != 0;
+    m_content_checksum = (flags & FLG_CONTENT_CHECKSUM) != 0;
+    m_has_content_size = has_content_size;
+    if (has_content_size) {
+      m_content_size = read_le32(in + 6) |
+                       static_cast<uint64_t>(read_le32(in + 10)) << 32;
+    }
+    m_stage = stage::blocks;
+    return {frame_status::ok, header_size, 0};
+  }
+
+  frame_result read_block(const unsigned char* in,
+                          size_t size,
+                          unsigned char* out,
+                          size_t capacity) noexcept {
+    using namespace details;
+    using compression::details::read_le32;
+    using compression::xxhash32;
+
+    if (size < 4) {
+      return {frame_status::need_more_input, 0, 0};
+    }
+    const uint32_t block_header{read_le32(in)};
+    if (block_header == 0) {
+      return read_end(in, size);
+    }
+    const size_t stored_size{block_header & ~UNCOMPRESSED_BLOCK};
+    if (stored_size > m_block_size) {
+      return {frame_status::corrupted, 0, 0};
+    }
+    const size_t total_size{4 + stored_size + (m_block_checksum ? 4u : 0u)};
+    if (size < total_size) {
+      return {frame_status::need_more_input, 0, 0};
+    }
+    const unsigned char* data{in + 4};
+    if (m_block_checksum &&
+        read_le32(data + stored_size) !=
+            xxhash32::compute(data, stored_size)) {
+      return {frame_status::corrupted, 0, 0};
+    }
+
+    size_t produced;
+    if (block_header & UNCOMPRESSED_BLOCK) {
+      if (capacity < stored_size) {
+        return {frame_status::output_too_small, 0, 0};
+      }
+      memcpy(out, data, stored_size);
+      produced = stored_size;
+    } else {
+      if (capacity < m_block_size) {
+        return {frame_status::output_too_small, 0, 0};
+      }
+      produced = decompress_block(data, stored_size, out, m_block_size);
+      if (produced == INVALID_SIZE) {
+        return {frame_status::corrupted, 0, 0};
+      }
+    }
+    if (m_content_checksum) {
+      m_content_hash.update(out, produced);
+    }
+    m_produced += produced;
+    return {frame_status::ok, total_size, produced};
+  }
+
+  frame_result read_end(const unsigned char* in, size_t size) noexcept {
+    using compression::details::read_le32;
+
+    const size_t end_size{4 + size_t{m_content_checksum ? 4u : 0u}};
+    if (size < end_size) {
+      return {frame_status::need_more_input, 0, 0};
+    }
+    if ((m_content_checksum &&
+         read_le32(in + 4) != m_content_hash.digest()) ||
+        (m_has_content_size && m_produced != m_content_size)) {
+      return {frame_status::corrupted, 0, 0};
+    }
+    m_stage = stage::finished;
+    return {frame_status::finished, end_size, 0};
+  }
+
+ private:
+  stage m_stage{stage::header};
+  size_t m_block_size{0};
+  bool m_block_checksum{false};
+  bool m_content_checksum{false};
+  bool m_has_content_size{false};
+  uint64_t m_content_size{0};
+  uint64_t m_produced{0};
+  compression::xxhash32 m_content_hash;
+};
+}  // namespace ktl::lz4
@@ -0,0 +1,144 @@
+#pragma once
+/*
+ * XXH32 non-cryptographic hash used by the LZ4 frame format for the header,
+ * block and content checksums. Self-contained, so the user-mode code may
+ * include it without KTL.
+ */
+#ifdef KTL_NO_CXX_STANDARD_LIBRARY
+#include <basic_types.hpp>
+#include <intrinsic.hpp>
+#else
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#endif
+
+namespace ktl::compression {
+namespace details {
+inline constexpr uint32_t XXH_PRIME32_1{0x9e3779b1u};
+inline constexpr uint32_t XXH_PRIME32_2{0x85ebca77u};
+inline constexpr uint32_t XXH_PRIME32_3{0xc2b2ae3du};
+inline constexpr uint32_t XXH_PRIME32_4{0x27d4eb2fu};
+inline constexpr uint32_t XXH_PRIME32_5{0x165667b1u};
+
+constexpr uint32_t rotl32(uint32_t value, int count) noexcept {
+  return (value << count) | (value >> (32 - count));
+}
+
+inline uint32_t read_le32(const unsigned char* ptr) noexcept {
+  return static_cast<uint32_t>(ptr[0]) |
+         static_cast<uint32_t>(ptr[1]) << 8 |
+         static_cast<uint32_t>(ptr[2]) << 16 |
+         static_cast<uint32_t>(ptr[3]) << 24;
+}
+
+inline void write_le32(unsigned char* ptr, uint32_t value) noexcept {
+  ptr[0] = static_cast<unsigned char>(value);
+  ptr[1] = static_cast<unsigned char>(value >> 8);
+  ptr[2] = static_cast<unsigned char>(value >> 16);
+  ptr[3] = static_cast<unsigned char>(value >> 24);
+}
+
+constexpr uint32_t xxh32_round(uint32_t acc, uint32_t input) noexcept {
+  return rotl32(acc + input * XXH_PRIME32_2, 13) * XXH_PRIME32_1;
+}
+}  // namespace details
+
+/**
+ * @class xxhash32
+ * @brief Incremental XXH32. update() may be called with the pieces of any
+ * size; digest() doesn't change the state
+ */
+class xxhash32 {
+ public:
+  explicit xxhash32(uint32_t seed = 0) noexcept { reset(seed); }
+
+  void reset(uint32_t seed = 0) noexcept {
+    using namespace details;
+    m_acc[0] = seed + XXH_PRIME32_1 + XXH_PRIME32_2;
+    m_acc[1] = seed + XXH_PRIME32_2;
+    m_acc[2] = seed;
+    m_acc[3] = seed - XXH_PRIME32_1;
+    m_seed = seed;
+    m_total_size = 0;
+    m_buffered = 0;
+  }
+
+  void update(const void* data, size_t size) noexcept {
+    const auto* input{static_cast<const unsigned char*>(data)};
+    m_total_size += size;
+    if (m_buffered + size < STRIPE_SIZE) {
+      if (size) {
+        memcpy(m_buffer + m_buffered, input, size);
+      }
+      m_buffered += static_cast<uint32_t>(size);
+      return;
+    }
+    if (m_buffered) {
+      const size_t head{STRIPE_SIZE - m_buffered};
+      memcpy(m_buffer + m_buffered, input, head);
+      consume_stripe(m_buffer);
+      input += head;
+      size -= head;
+      m_buffered = 0;
+    }
+    for (; size >= STRIPE_SIZE; size -= STRIPE_SIZE, input += STRIPE_SIZE) {
+      consume_stripe(input);
+    }
+    if (size) {
+      memcpy(m_buffer, input, size);
+      m_buffered = static_cast<uint32_t>(size);
+    }
+  }
+
+  [[nodiscard]] uint32_t digest() const noexcept {
+    using namespace details;
+    uint32_t hash{m_total_size >= STRIPE_SIZE
+                      ? rotl32(m_acc[0], 1) + rotl32(m_acc[1], 7) +
+                            rotl32(m_acc[2], 12) + rotl32(m_acc[3], 18)
+                      : m_seed + XXH_PRIME32_5};
+    hash += static_cast<uint32_t>(m_total_size);
+
+    const unsigned char* tail{m_buffer};
+    uint32_t remaining{m_buffered};
+    for (; remaining >= 4; remaining -= 4, tail += 4) {
+      hash = rotl32(hash + read_le32(tail) * XXH_PRIME32_3, 17) *
+             XXH_PRIME32_4;
+    }
+    for (; remaining; --remaining, ++tail) {
+      hash = rotl32(hash + *tail * XXH_PRIME32_5, 11) * XXH_PRIME32_1;
+    }
+    hash ^= hash >> 15;
+    hash *= XXH_PRIME32_2;
+    hash ^= hash >> 13;
+    hash *= XXH_PRIME32_3;
+    hash ^= hash >> 16;
+    return hash;
+  }
+
+  static uint32_t compute(const void* data,
+                          size_t size,
+                          uint32_t seed = 0) noexcept {
+    xxhash32 hasher{seed};
+    hasher.update(data, size);
+    return hasher.digest();
+  }
+
+ private:
+  static constexpr uint32_t STRIPE_SIZE{16};
+
+  void consume_stripe(const unsigned char* stripe) noexcept {
+    using namespace details;
+    for (int lane = 0; lane < 4; ++lane) {
+      m_acc[lane] = xxh32_round(m_acc[lane], read_le32(stripe + 4 * lane));
+    }
+  }
+
+ private:
+  uint32_t m_acc[4];
+  uint32_t m_seed;
+  uint64_t m_total_size;
+  unsigned char m_buffer[STRIPE_SIZE];
+  uint32_t m_buffered;
+};
+}  // namespace ktl::compression
@@ -0,0 +1,177 @@
+#pragma once
+/*
+ * Layout of the event ring shared between the kernel-mode writer and the
+ * user-mode reader. The header is self-contained, so the user-mode code may
+ * include it without KTL:
+ *
+ *   +---------------------+  0
+ *   | ring_header         |  Identification, producer and consumer lines
+ *   +---------------------+  RING_HEADER_SIZE
+ *   | data                |  data_size bytes (a power of 2) of the records
+ *   +---------------------+
+ *
+ * Each record begins with record_header and is aligned to RECORD_ALIGNMENT.
+ * Positions are 64-bit byte counters which never wrap; the offset of a record
+ * is its position modulo data_size. A record never wraps around the end of the
+ * data area: the writer fills the remainder with a padding record instead.
+ *
+ * Protocol:
+ * - The writer reserves a record by writing its header with RECORD_BUSY set
+ *   and advancing producer_pos (release). Then it fills the payload and clears
+ *   RECORD_BUSY (release). Records are consumed in order, so a busy record
+ *   blocks the reader until the writer commits it.
+ * - The reader consumes the committed records in [consumer_pos, producer_pos)
+ *   and advances consumer_pos (release) to free the space.
+ * - Before sleeping the reader sets consumer_waiting and re-checks the ring.
+ *   After a commit the writer resets consumer_waiting and signals the reader's
+ *   event only if it was set, so a busy reader is never woken up.
+ */
+#ifdef KTL_NO_CXX_STANDARD_LIBRARY
+#include <basic_types.hpp>
+#else
+#include <cstddef>
+#include <cstdint>
+#endif
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+namespace ktl::event_ring {
+inline constexpr uint32_t RING_MAGIC{0x474E5252};  // 'RRNG'
+inline constexpr uint16_t RING_VERSION{1};
+inline constexpr uint32_t RING_HEADER_SIZE{192};
+inline constexpr uint32_t RING_LINE_SIZE{64};
+
+inline constexpr uint32_t RECORD_ALIGNMENT{8};
+inline constexpr uint32_t RECORD_BUSY{0x80000000};     // Not committed yet
+inline constexpr uint32_t RECORD_PADDING{0x40000000};  // Skipped by the reader
+inline constexpr uint32_t RECORD_LENGTH_MASK{0x3FFFFFFF};
+
+enum ring_flags : uint32_t {
+  ring_multi_producer = 1,  //!< Records are reserved under a lock
+};
+
+/**
+ * @struct ring_header
+ * @brief Control block at the beginning of the shared view. The producer and
+ * consumer fields live on separate cache lines
+ */
+struct alignas(RING_LINE_SIZE) ring_header {
+  // Written once by the writer
+  uint32_t magic;
+  uint16_t version;
+  uint16_t header_size;  //!< Offset of the data area
+  uint32_t data_size;    //!< Size of the data area, a power of 2
+  uint32_t flags;        //!< Combination of ring_flags
+  uint8_t reserved0[RING_LINE_SIZE - 16];
+
+  // Written by the writer
+  alignas(RING_LINE_SIZE) uint64_t producer_pos;
+  uint64_t dropped;  //!< Records lost because the ring was full
+  uint8_t reserved1[RING_LINE_SIZE - 16];
+
+  // Written by the reader
+  alignas(RING_LINE_SIZE) uint64_t consumer_pos;
+  uint32_t consumer_waiting;  //!< Non-zero if the reader is going to sleep
+  uint8_t reserved2[RING_LINE_SIZE - 12];
+};
+
+static_assert(sizeof(ring_header) == RING_HEADER_SIZE,
+              "Layout of the ring header must not change");
+
+/**
+ * @struct record_header
+ * @brief Precedes the payload of each record
+ */
+struct record_header {
+  uint32_t length;  //!< Payload length combined with RECORD_BUSY/PADDING
+  uint16_t type;    //!< Defined by the driver
+  uint16_t reserved;
+};
+
+static_assert(sizeof(record_header) == RECORD_ALIGNMENT,
+              "Layout of the record header must not change");
+
+/**
+ * @fn record_size
+ * @return Space taken by the record with the payload of the given length
+ */
+constexpr uint64_t record_size(uint32_t length) noexcept {
+  return (sizeof(record_header) + uint64_t{length} + RECORD_ALIGNMENT - 1) &
+         ~uint64_t{RECORD_ALIGNMENT - 1};
+}
+
+constexpr bool is_valid_data_size(uint64_t data_size) noexcept {
+  return data_size >= 2 * RING_LINE_SIZE && data_size <= RECORD_LENGTH_MASK &&
+         (data_size & (data_size - 1)) == 0;
+}
+
+namespace details {
+/*
+ * Both sides access the shared fields only through these functions: the
+ * reader can't rely on KTL atomics and the writer can't rely on <atomic>
+ */
+#if defined(_MSC_VER) && !defined(__clang__)
+#if !defined(_M_AMD64) && !defined(_M_IX86)
+#error Unsupported platform
+#endif
+// x86 loads have acquire and stores have release semantics
+template <class Ty>
+inline Ty load_acquire(const volatile Ty* place) noexcept {
+#ifdef _M_IX86
+  if constexpr (sizeof(Ty) == sizeof(long long)) {
+    return static_cast<Ty>(_InterlockedCompareExchange64(
+        reinterpret_cast<volatile long long*>(const_cast<volatile Ty*>(place)),
+        0, 0));
+  }
+#endif
+  const Ty value{*place};
+  _ReadWriteBarrier();
+  return value;
+}
+
+template <class Ty>
+inline void store_release(volatile Ty* place, Ty value) noexcept {
+#ifdef _M_IX86
+  if constexpr (sizeof(Ty) == sizeof(long long)) {
+    _InterlockedExchange64(reinterpret_cast<volatile long long*>(place),
+                           static_cast<long long>(value));
+    return;
+  }
+#endif
+  _ReadWriteBarrier();
+  *place = value;
+}
+
+inline uint32_t exchange(volatile uint32_t* place, uint32_t value) noexcept {
+  return static_cast<uint32_t>(
+      _InterlockedExchange(reinterpret_cast<volatile long*>(place),
+                           static_cast<long>(value)));
+}
+
+inline void full_fence() noexcept {
+  volatile long guard{0};
+  _InterlockedOr(&guard, 0);
+}
+#else
+template <class Ty>
+inline Ty load_acquire(const volatile Ty* place) noexcept {
+  return __atomic_load_n(place, __ATOMIC_ACQUIRE);
+}
+
+template <class Ty>
+inline void store_release(volatile Ty* place, Ty value) noexcept {
+  __atomic_store_n(place, value, __ATOMIC_RELEASE);
+}
+
+inline uint32_t exchange(volatile uint32_t* place, uint32_t value) noexcept {
+  return __atomic_exchange_n(place, value, __ATOMIC_SEQ_CST);
+}
+
+inline void full_fence() noexcept {
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+#endif
+}  // namespace details
+}  // namespace ktl::event_ring
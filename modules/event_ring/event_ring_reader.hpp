@@ -0,0 +1,136 @@
+#pragma once
+// With " " instead of <> there is no need to add event_ring/ to include path
+#include "event_ring_format.hpp"
+
+namespace ktl::event_ring {
+/**
+ * @class reader
+ * @brief Consumes the records from the view of the ring mapped into the
+ * process. Header-only and independent of KTL, so it's used as is by the
+ * user-mode service
+ * @details Payloads are passed to the callback in place, without copying;
+ * the space is returned to the writer after the callback. A single thread
+ * must read the ring. Typical loop:
+ *
+ *   for (;;) {
+ *     if (ring.consume(callback) == 0 && ring.prepare_wait()) {
+ *       WaitForSingleObject(event, INFINITE);
+ *     }
+ *   }
+ */
+class reader {
+ public:
+  reader() noexcept = default;
+
+  /**
+   * @fn reader::reader
+   * @param[in] view Base of the mapped ring
+   * @param[in] view_size Size of the mapping
+   */
+  reader(void* view, size_t view_size) noexcept { attach(view, view_size); }
+
+  /**
+   * @fn reader::attach
+   * @brief Validates the ring header
+   * @return false if the view doesn't contain a compatible ring
+   */
+  bool attach(void* view, size_t view_size) noexcept {
+    m_header = nullptr;
+    if (!view || view_size < RING_HEADER_SIZE) {
+      return false;
+    }
+    auto* header{static_cast<ring_header*>(view)};
+    if (header->magic != RING_MAGIC || header->version != RING_VERSION ||
+        header->header_size != RING_HEADER_SIZE ||
+        !is_valid_data_size(header->data_size) ||
+        view_size - RING_HEADER_SIZE < header->data_size) {
+      return false;
+    }
+    m_header = header;
+    m_data = static_cast<unsigned char*>(view) + RING_HEADER_SIZE;
+    m_mask = header->data_size - 1;
+    m_position = details::load_acquire(&header->consumer_pos);
+    return true;
+  }
+
+  [[nodiscard]] bool attached() const noexcept { return m_header != nullptr; }
+
+  /**
+   * @fn reader::consume
+   * @brief Passes the committed records to the callback
+   * @param[in] callback Callable accepting (uint16_t type, const void* payload,
+   * uint32_t length)
+   * @param[in] max_records Upper bound of the records to consume
+   * @return Number of the records consumed
+   */
+  template <class Callback>
+  size_t consume(Callback&& callback,
+                 size_t max_records = static_cast<size_t>(-1)) {
+    size_t count{0};
+    const uint64_t producer_pos{
+        details::load_acquire(&m_header->producer_pos)};
+    uint64_t position{m_position};
+    while (count < max_records && position < producer_pos) {
+      const auto* record{get_record(position)};
+      const uint32_t length{details::load_acquire(&record->length)};
+      if (length & RECORD_BUSY) {
+        break;
+      }
+      const uint32_t payload_length{length & RECORD_LENGTH_MASK};
+      const uint64_t size{record_size(payload_length)};
+      if (size > producer_pos - position) {
+        break;  // Corrupted ring
+      }
+      if (!(length & RECORD_PADDING)) {
+        callback(record->type, record + 1, payload_length);
+        ++count;
+      }
+      position += size;
+    }
+    if (position != m_position) {
+      m_position = position;
+      details::store_release(&m_header->consumer_pos, position);
+    }
+    return count;
+  }
+
+  /**
+   * @fn reader::prepare_wait
+   * @brief Asks the writer to signal the event on the next commit
+   * @return false if the records have arrived and the reader must not sleep
+   */
+  bool prepare_wait() noexcept {
+    details::store_release(&m_header->consumer_waiting, uint32_t{1});
+    details::full_fence();  // Pairs with the fence in writer::commit()
+    if (has_records()) {
+      details::store_release(&m_header->consumer_waiting, uint32_t{0});
+      return false;
+    }
+    return true;
+  }
+
+  [[nodiscard]] bool has_records() const noexcept {
+    if (m_position >= details::load_acquire(&m_header->producer_pos)) {
+      return false;
+    }
+    return !(details::load_acquire(&get_record(m_position)->length) &
+             RECORD_BUSY);
+  }
+
+  [[nodiscard]] uint64_t dropped() const noexcept {
+    return details::load_acquire(&m_header->dropped);
+  }
+
+ private:
+  const record_header* get_record(uint64_t position) const noexcept {
+    return reinterpret_cast<const record_header*>(m_data +
+                                                  (position & m_mask));
+  }
+
+ private:
+  ring_header* m_header{nullptr};
+  unsigned char* m_data{nullptr};
+  uint64_t m_mask{0};
+  uint64_t m_position{0};
+};
+}  // namespace ktl::event_ring
@@ -0,0 +1,211 @@
+#pragma once
+// With " " instead of <> there is no need to add event_ring/ to include path
+#include "event_ring_format.hpp"
+
+#include <atomic.hpp>
+#include <basic_types.hpp>
+#include <ktlexcept.hpp>
+#include <mutex.hpp>
+#include <type_traits.hpp>
+#include <utility.hpp>
+
+namespace ktl::event_ring {
+namespace details {
+struct no_lock {
+  void lock() noexcept {}
+  void unlock() noexcept {}
+};
+}  // namespace details
+
+/**
+ * @class writer
+ * @brief Produces the records into the memory shared with the reader
+ * @details Records are written in place: reserve() returns the space inside
+ * the ring and commit() publishes it, so an event is copied once at most.
+ * If MultiProducer is true, reservations are serialized by a spin lock and
+ * the writer may be used concurrently at IRQL <= DISPATCH_LEVEL; otherwise
+ * the caller must serialize the producers. Notifier::operator()() is called
+ * after a commit only if the reader has announced it's going to sleep.
+ * Fields written by the reader are never trusted: all of the offsets are
+ * taken modulo the data size, and an inconsistent consumer position makes
+ * the ring look full.
+ */
+template <class Notifier, bool MultiProducer = true>
+class writer : non_relocatable {
+ public:
+  using notifier_type = Notifier;
+  using lock_type =
+      conditional_t<MultiProducer, spin_lock<>, details::no_lock>;
+
+  /**
+   * @class reservation
+   * @brief Space of a record which isn't visible to the reader until it's
+   * committed or discarded
+   */
+  class reservation {
+   public:
+    reservation() noexcept = default;
+
+    [[nodiscard]] void* data() const noexcept { return m_record + 1; }
+    [[nodiscard]] uint32_t size() const noexcept { return m_length; }
+
+    explicit operator bool() const noexcept { return m_record != nullptr; }
+
+   private:
+    friend class writer;
+
+    reservation(record_header* record, uint32_t length) noexcept
+        : m_record{record}, m_length{length} {}
+
+   private:
+    record_header* m_record{nullptr};
+    uint32_t m_length{0};
+  };
+
+ public:
+  static constexpr size_t view_size_for(uint32_t data_size) noexcept {
+    return RING_HEADER_SIZE + data_size;
+  }
+
+  /**
+   * @fn writer::writer
+   * @brief Formats the ring in the view. The reader must not be attached yet
+   * @param[in] view Kernel address of the shared memory aligned to
+   * RING_LINE_SIZE at least view_size_for(data_size) bytes long
+   * @param[in] data_size Size of the data area, a power of 2
+   * @throw kernel_error if the size is invalid
+   */
+  writer(void* view, uint32_t data_size, Notifier notifier = Notifier{})
+      : m_header{validate_view(view, data_size)},
+        m_data{static_cast<unsigned char*>(view) + RING_HEADER_SIZE},
+        m_mask{data_size - 1},
+        m_notifier(move(notifier)) {
+    memset(m_header, 0, sizeof(ring_header));
+    m_header->version = RING_VERSION;
+    m_header->header_size = RING_HEADER_SIZE;
+    m_header->data_size = data_size;
+    m_header->flags = MultiProducer ? ring_multi_producer : 0;
+    details::store_release(&m_header->magic, RING_MAGIC);
+  }
+
+  [[nodiscard]] uint32_t data_size() const noexcept {
+    return static_cast<uint32_t>(m_mask + 1);
+  }
+
+  /**
+   * @fn writer::max_record_length
+   * @return Longest payload accepted by reserve(). Limited to a half of the
+   * data area, so a record always fits after the padding
+   */
+  [[nodiscard]] uint32_t max_record_length() const noexcept {
+    return data_size() / 2 - static_cast<uint32_t>(sizeof(record_header));
+  }
+
+  /**
+   * @fn writer::reserve
+   * @param[in] type Type of the record defined by the driver
+   * @param[in] length Length of the payload
+   * @return Empty reservation if the ring is full or the payload is too long;
+   * the record is counted as dropped
+   */
+  reservation reserve(uint16_t type, uint32_t length) noexcept {
+    const uint64_t size{record_size(length)};
+    lock_guard guard{m_lock};
+    const uint64_t position{m_position};
+    const uint64_t consumer_pos{
+        details::load_acquire(&m_header->consumer_pos)};
+    const uint64_t offset{position & m_mask};
+    const uint64_t padding{offset + size > m_mask + 1 ? m_mask + 1 - offset
+                                                      : 0};
+    if (length > max_record_length() ||
+        position - consumer_pos > m_mask + 1 ||
+        position + padding + size - consumer_pos > m_mask + 1) {
+      details::store_release(&m_header->dropped,
+                             m_dropped.fetch_add<memory_order_relaxed>(1) + 1);
+      return reservation{};
+    }
+    if (padding != 0) {
+      auto* filler{get_record(position)};
+      filler->type = 0;
+      filler->reserved = 0;
+      filler->length =
+          static_cast<uint32_t>(padding - sizeof(record_header)) |
+          RECORD_PADDING;
+    }
+    auto* record{get_record(position + padding)};
+    record->type = type;
+    record->reserved = 0;
+    record->length = length | RECORD_BUSY;
+    m_position = position + padding + size;
+    details::store_release(&m_header->producer_pos, m_position);
+    return reservation{record, length};
+  }
+
+  /**
+   * @fn writer::commit
+   * @brief Makes the record visible to the reader and wakes it up if needed
+   */
+  void commit(const reservation& target) noexcept {
+    publish(target, target.m_length);
+  }
+
+  /**
+   * @fn writer::discard
+   * @brief Turns the reserved record into padding skipped by the reader
+   */
+  void discard(const reservation& target) noexcept {
+    publish(target, target.m_length | RECORD_PADDING);
+  }
+
+  /**
+   * @fn writer::write
+   * @brief Copies the payload into a new record
+   * @return false if the record has been dropped
+   */
+  bool write(uint16_t type, const void* payload, uint32_t length) noexcept {
+    const auto target{reserve(type, length)};
+    if (!target) {
+      return false;
+    }
+    memcpy(target.data(), payload, length);
+    commit(target);
+    return true;
+  }
+
+  [[nodiscard]] uint64_t dropped() const noexcept {
+    return m_dropped.load<memory_order_relaxed>();
+  }
+
+  Notifier& get_notifier() noexcept { return m_notifier; }
+
+ private:
+  static ring_header* validate_view(void* view, uint32_t data_size) {
+    throw_exception_if_not<kernel_error>(
+        view && is_valid_data_size(data_size), STATUS_INVALID_PARAMETER,
+        "invalid event ring view");
+    return static_cast<ring_header*>(view);
+  }
+
+  record_header* get_record(uint64_t position) const noexcept {
+    return reinterpret_cast<record_header*>(m_data + (position & m_mask));
+  }
+
+  void publish(const reservation& target, uint32_t length) noexcept {
+    details::store_release(&target.m_record->length, length);
+    details::full_fence();  // Pairs with the fence in reader::prepare_wait()
+    if (details::load_acquire(&m_header->consumer_waiting) != 0 &&
+        details::exchange(&m_header->consumer_waiting, 0) != 0) {
+      m_notifier();
+    }
+  }
+
+ private:
+  ring_header* m_header;
+  unsigned char* m_data;
+  const uint64_t m_mask;
+  uint64_t m_position{0};  // Guarded by m_lock
+  lock_type m_lock;
+  atomic<uint64_t> m_dropped{0};
+  Notifier m_notifier;
+};
+}  // namespace ktl::event_ring
@@ -0,0 +1,209 @@
+#pragma once
+// With " " instead of <> there is no need to add event_ring/ to include path
+#include "event_ring_writer.hpp"
+
+#include <atomic.hpp>
+#include <basic_types.hpp>
+#include <ktlexcept.hpp>
+#include <utility.hpp>
+
+#include <ntddk.h>
+
+namespace ktl::event_ring {
+/**
+ * @struct kevent_notifier
+ * @brief Signals the event passed by the reader, if any
+ */
+struct kevent_notifier {
+  void operator()() const noexcept {
+    if (auto* target = event->load<memory_order_acquire>(); target) {
+      KeSetEvent(target, IO_NO_INCREMENT, false);
+    }
+  }
+
+  const atomic<KEVENT*>* event;
+};
+
+namespace details {
+inline NTSTATUS lock_view_pages(MDL* mdl) noexcept {
+  __try {
+    MmProbeAndLockPages(mdl, KernelMode, IoWriteAccess);
+  } __except (EXCEPTION_EXECUTE_HANDLER) {
+    return GetExceptionCode();
+  }
+  return STATUS_SUCCESS;
+}
+}  // namespace details
+
+/**
+ * @class shared_event_ring
+ * @brief Event ring in a pagefile-backed section mapped both into the system
+ * space and into the reader's process
+ * @details The system view is locked, so the records may be written at
+ * IRQL <= DISPATCH_LEVEL. Views mapped into a process go away with the
+ * process, so a crashed reader doesn't leave the locked pages behind.
+ * The reader attaches the ring at the address returned by
+ * map_to_current_process() with reader::attach() and passes an auto-reset
+ * event to set_consumer_event().
+ */
+template <bool MultiProducer = true>
+class shared_event_ring : non_relocatable {
+ public:
+  using writer_type = event_ring::writer<kevent_notifier, MultiProducer>;
+
+ public:
+  /**
+   * @fn shared_event_ring::shared_event_ring
+   * @param[in] data_size Size of the data area, a power of 2
+   * @throw kernel_error if the section can't be created or mapped.
+   * Must be called at PASSIVE_LEVEL
+   */
+  explicit shared_event_ring(uint32_t data_size)
+      : m_writer{map_system_view(data_size), data_size,
+                 kevent_notifier{addressof(m_consumer_event)}} {}
+
+  ~shared_event_ring() noexcept {
+    set_consumer_event(nullptr, KernelMode);
+    release();
+  }
+
+  writer_type& get_writer() noexcept { return m_writer; }
+
+  [[nodiscard]] size_t view_size() const noexcept { return m_view_size; }
+
+  /**
+   * @fn shared_event_ring::map_to_current_process
+   * @brief Maps the ring into the address space of the calling process, e.g.
+   * from the handler of the reader's connection request
+   * @return User-mode address of the view
+   * @throw kernel_error if the view can't be mapped
+   */
+  void* map_to_current_process() {
+    void* base{nullptr};
+    SIZE_T size{m_view_size};
+    const NTSTATUS status{ZwMapViewOfSection(
+        m_section, ZwCurrentProcess(), addressof(base), 0, 0, nullptr,
+        addressof(size), ViewUnmap, 0, PAGE_READWRITE)};
+    throw_exception_if_not<kernel_error>(NT_SUCCESS(status), status,
+                                         "unable to map the event ring");
+    return base;
+  }
+
+  /**
+   * @fn shared_event_ring::unmap_from_current_process
+   * @brief Must be called in the context of the process which has mapped the
+   * view if it's still alive
+   */
+  void unmap_from_current_process(void* base) noexcept {
+    ZwUnmapViewOfSection(ZwCurrentProcess(), base);
+  }
+
+  /**
+   * @fn shared_event_ring::set_consumer_event
+   * @brief Replaces the event signaled when the records arrive to the idle
+   * reader. The previous event is dereferenced at once, so the producers must
+   * be stopped before it's replaced
+   * @param[in] event Handle of the event or nullptr to detach it
+   * @param[in] access_mode Mode the handle has been received from
+   * @throw kernel_error if the handle is invalid
+   */
+  void set_consumer_event(HANDLE event, KPROCESSOR_MODE access_mode) {
+    KEVENT* target{nullptr};
+    if (event) {
+      const NTSTATUS status{ObReferenceObjectByHandle(
+          event, EVENT_MODIFY_STATE, *ExEventObjectType, access_mode,
+          reinterpret_cast<void**>(addressof(target)), nullptr)};
+      throw_exception_if_not<kernel_error>(NT_SUCCESS(status), status,
+                                           "invalid consumer event");
+    }
+    if (auto* previous = m_consumer_event.exchange(target); previous) {
+      ObDereferenceObject(previous);
+    }
+  }
+
+ private:
+  void* map_system_view(uint32_t data_size) {
+    const NTSTATUS status{create(data_size)};
+    if (!NT_SUCCESS(status)) {
+      release();  // The destructor won't be called
+      throw_exception<kernel_error>(status,
+                                    "unable to create the event ring section");
+    }
+    return m_view;
+  }
+
+  NTSTATUS create(uint32_t data_size) noexcept {
+    if (!is_valid_data_size(data_size)) {
+      return STATUS_INVALID_PARAMETER;
+    }
+    m_view_size = ROUND_TO_PAGES(writer_type::view_size_for(data_size));
+
+    OBJECT_ATTRIBUTES attributes;
+    InitializeObjectAttributes(addressof(attributes), nullptr,
+                               OBJ_KERNEL_HANDLE, nullptr, nullptr);
+    LARGE_INTEGER max_size;
+    max_size.QuadPart = static_cast<LONGLONG>(m_view_size);
+    NTSTATUS status{ZwCreateSection(
+        addressof(m_section), SECTION_MAP_READ | SECTION_MAP_WRITE,
+        addressof(attributes), addressof(max_size), PAGE_READWRITE, SEC_COMMIT,
+        nullptr)};
+    if (!NT_SUCCESS(status)) {
+      return status;
+    }
+    status = ObReferenceObjectByHandle(m_section,
+                                       SECTION_MAP_READ | SECTION_MAP_WRITE,
+                                       nullptr, KernelMode,
+                                       addressof(m_section_object), nullptr);
+    if (!NT_SUCCESS(status)) {
+      return status;
+    }
+    SIZE_T system_view_size{m_view_size};
+    status = MmMapViewInSystemSpace(m_section_object, addressof(m_system_view),
+                                    addressof(system_view_size));
+    if (!NT_SUCCESS(status)) {
+      return status;
+    }
+    // The system view is pageable, so the writer uses the locked pages
+    m_mdl = IoAllocateMdl(m_system_view, static_cast<ULONG>(m_view_size),
+                          false, false, nullptr);
+    if (!m_mdl) {
+      return STATUS_INSUFFICIENT_RESOURCES;
+    }
+    status = details::lock_view_pages(m_mdl);
+    if (!NT_SUCCESS(status)) {
+      IoFreeMdl(m_mdl);
+      m_mdl = nullptr;
+      return status;
+    }
+    m_view = MmGetSystemAddressForMdlSafe(
+        m_mdl, NormalPagePriority | MdlMappingNoExecute);
+    return m_view ? STATUS_SUCCESS : STATUS_INSUFFICIENT_RESOURCES;
+  }
+
+  void release() noexcept {
+    if (m_mdl) {
+      MmUnlockPages(m_mdl);  // Unmaps m_view as well
+      IoFreeMdl(m_mdl);
+    }
+    if (m_system_view) {
+      MmUnmapViewInSystemSpace(m_system_view);
+    }
+    if (m_section_object) {
+      ObDereferenceObject(m_section_object);
+    }
+    if (m_section) {
+      ZwClose(m_section);
+    }
+  }
+
+ private:
+  HANDLE m_section{nullptr};
+  void* m_section_object{nullptr};
+  void* m_system_view{nullptr};
+  MDL* m_mdl{nullptr};
+  void* m_view{nullptr};
+  size_t m_view_size{0};
+  atomic<KEVENT*> m_consumer_event{nullptr};
+  writer_type m_writer;
+};
+}  // namespace ktl::event_ring
@@ -287,6 +287,8 @@ constexpr void ignore_unused(const T&...) {}
 constexpr inline auto is_constant_evaluated() noexcept -> bool {
 #ifdef __cpp_lib_is_constant_evaluated
   return ktl::is_constant_evaluated();
+#elif FMT_GCC_VERSION >= 900
+  return __builtin_is_constant_evaluated();
 #else
   return false;
 #endif
@@ -2167,7 +2169,7 @@ constexpr auto parse_align(const Char* begin,
       if (p != begin) {
         auto c = *begin;
         if (c == '{')
-          handler.on_error("invalid fill character '{'"), begin;
+          return handler.on_error("invalid fill character '{'"), begin;
         handler.on_fill(
             basic_winnt_string_view<Char>(begin, to_unsigned(p - begin)));
         begin = p + 1;
@@ -2262,7 +2264,7 @@ constexpr auto parse_width(const Char* begin,
     if (begin != end)
       begin = parse_arg_id(begin, end, width_adapter{handler});
     if (begin == end || *begin != '}')
-      handler.on_error("invalid format string"), begin;
+      return handler.on_error("invalid format string"), begin;
     ++begin;
   }
   return begin;
@@ -2301,9 +2303,9 @@ constexpr auto parse_precision(const Char* begin,
     if (begin != end)
       begin = parse_arg_id(begin, end, precision_adapter{handler});
     if (begin == end || *begin++ != '}')
-      handler.on_error("invalid format string"), begin;
+      return handler.on_error("invalid format string"), begin;
   } else {
-    handler.on_error("missing precision specifier"), begin;
+    return handler.on_error("missing precision specifier"), begin;
   }
   handler.end_precision();
   return begin;
@@ -2405,7 +2407,7 @@ constexpr auto parse_replacement_field(const Char* begin,
 
   ++begin;
   if (begin == end)
-    handler.on_error("invalid format string"), end;
+    return handler.on_error("invalid format string"), end;
   if (*begin == '}') {
     handler.on_replacement_field(handler.on_arg_id(), begin);
   } else if (*begin == '{') {
@@ -2419,9 +2421,9 @@ constexpr auto parse_replacement_field(const Char* begin,
     } else if (c == ':') {
       begin = handler.on_format_specs(adapter.arg_id, begin + 1, end);
       if (begin == end || *begin != '}')
-        handler.on_error("unknown format specifier"), end;
+        return handler.on_error("unknown format specifier"), end;
     } else {
-      handler.on_error("missing '}' in format string"), end;
+      return handler.on_error("missing '}' in format string"), end;
     }
   }
   return begin + 1;
@@ -3074,7 +3076,6 @@ FMT_API void vprint(string_view fmt, format_args args);
 //}
 
 FMT_MODULE_EXPORT_END
-FMT_GCC_PRAGMA("GCC pop_options")
 FMT_END_NAMESPACE
 
 #ifdef FMT_HEADER_ONLY
@@ -130,10 +130,6 @@ FMT_FUNC Char decimal_point_impl(locale_ref) {
 #endif
 }  // namespace detail
 
-#if !FMT_MSC_VER
-FMT_API FMT_FUNC format_error::~format_error() noexcept = default;
-#endif
-
 // TODO: system_error
 // FMT_FUNC ktl::system_error vsystem_error(int error_code, string_view
 // format_str,
@@ -2199,6 +2199,7 @@ class width_checker {
   template <typename T, FMT_ENABLE_IF(!is_integer<T>::value)>
   constexpr auto operator()(T) -> unsigned long long {
     handler_.on_error("width is not integer");
+    return 0;
   }
 
  private:
@@ -2220,6 +2221,7 @@ class precision_checker {
   template <typename T, FMT_ENABLE_IF(!is_integer<T>::value)>
   constexpr auto operator()(T) -> unsigned long long {
     handler_.on_error("precision is not integer");
+    return 0;
   }
 
  private:
@@ -0,0 +1,152 @@
+#pragma once
+#include <atomic.hpp>
+#include <basic_types.hpp>
+#include <heap.hpp>
+#include <memory.hpp>
+#include <type_traits.hpp>
+#include <utility.hpp>
+
+namespace ktl::lockfree {
+/**
+ * @class mpmc_bounded_queue
+ * @brief Multi-producer, multi-consumer queue on a fixed-size ring buffer.
+ * @details Every cell has a sequence number telling the producers and the
+ * consumers whose turn it is, so both sides claim a cell with a single CAS on
+ * their position and never touch each other's counter (D. Vyukov's bounded
+ * MPMC queue). Unlike mpmc_queue it never allocates, so it may be used at any
+ * IRQL if Ty is in non-paged memory. The queue isn't linearizable: a stalled
+ * producer may hide the elements pushed after it from the consumers until it
+ * completes the push.
+ */
+template <class Ty, size_t Capacity>
+class mpmc_bounded_queue : non_relocatable {
+  static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                "Capacity must be a power of 2");
+
+ public:
+  using value_type = Ty;
+  using size_type = size_t;
+
+ private:
+  static constexpr size_t INDEX_MASK{Capacity - 1};
+
+  struct cell {
+    atomic<size_t> sequence;
+    aligned_storage_t<sizeof(Ty), alignof(Ty)> storage;
+
+    Ty* get_value() noexcept {
+      return reinterpret_cast<Ty*>(addressof(storage));
+    }
+  };
+
+ public:
+  mpmc_bounded_queue() noexcept {
+    for (size_t idx = 0; idx < Capacity; ++idx) {
+      m_cells[idx].sequence.template store<memory_order_relaxed>(idx);
+    }
+  }
+
+  ~mpmc_bounded_queue() noexcept {
+    if constexpr (!is_trivially_destructible_v<Ty>) {
+      const size_t tail{m_enqueue_pos.load<memory_order_relaxed>()};
+      for (size_t pos = m_dequeue_pos.load<memory_order_relaxed>(); pos != tail;
+           ++pos) {
+        destroy_at(m_cells[pos & INDEX_MASK].get_value());
+      }
+    }
+  }
+
+  static constexpr size_type capacity() noexcept { return Capacity; }
+
+  /**
+   * @fn mpmc_bounded_queue::try_emplace
+   * @brief Constructs an element in the next free cell
+   * @return false if the queue is full
+   */
+  template <class... Types>
+  bool try_emplace(Types&&... args) noexcept(
+      is_nothrow_constructible_v<Ty, Types...>) {
+    cell* target;
+    size_t pos{m_enqueue_pos.load<memory_order_relaxed>()};
+    for (;;) {
+      target = addressof(m_cells[pos & INDEX_MASK]);
+      const size_t sequence{
+          target->sequence.template load<memory_order_acquire>()};
+      const auto diff{static_cast<ptrdiff_t>(sequence - pos)};
+      if (diff == 0) {
+        if (m_enqueue_pos.compare_exchange_weak<memory_order_relaxed>(
+                pos, pos + 1)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;  // The cell is still occupied by the previous lap
+      } else {
+        pos = m_enqueue_pos.load<memory_order_relaxed>();
+      }
+    }
+    construct_at(target->get_value(), forward<Types>(args)...);
+    target->sequence.template store<memory_order_release>(pos + 1);
+    return true;
+  }
+
+  bool try_push(const Ty& value) noexcept(
+      is_nothrow_copy_constructible_v<Ty>) {
+    return try_emplace(value);
+  }
+
+  bool try_push(Ty&& value) noexcept(is_nothrow_move_constructible_v<Ty>) {
+    return try_emplace(move(value));
+  }
+
+  /**
+   * @fn mpmc_bounded_queue::try_pop
+   * @param[out] value Receives the oldest element
+   * @return false if the queue is empty
+   */
+  bool try_pop(Ty& value) noexcept(is_nothrow_move_assignable_v<Ty>) {
+    cell* target;
+    size_t pos{m_dequeue_pos.load<memory_order_relaxed>()};
+    for (;;) {
+      target = addressof(m_cells[pos & INDEX_MASK]);
+      const size_t sequence{
+          target->sequence.template load<memory_order_acquire>()};
+      const auto diff{static_cast<ptrdiff_t>(sequence - (pos + 1))};
+      if (diff == 0) {
+        if (m_dequeue_pos.compare_exchange_weak<memory_order_relaxed>(
+                pos, pos + 1)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = m_dequeue_pos.load<memory_order_relaxed>();
+      }
+    }
+    Ty* place{target->get_value()};
+    value = move(*place);
+    destroy_at(place);
+    target->sequence.template store<memory_order_release>(pos + Capacity);
+    return true;
+  }
+
+  /**
+   * @fn mpmc_bounded_queue::size_approx
+   * @return Number of the elements which may be stale by the time it's used
+   */
+  [[nodiscard]] size_type size_approx() const noexcept {
+    const size_t head{m_dequeue_pos.load<memory_order_relaxed>()};
+    const size_t tail{m_enqueue_pos.load<memory_order_relaxed>()};
+    const auto diff{static_cast<ptrdiff_t>(tail - head)};
+    return diff > 0 ? static_cast<size_type>(diff) : 0;
+  }
+
+  [[nodiscard]] bool empty_approx() const noexcept {
+    return size_approx() == 0;
+  }
+
+ private:
+  cell m_cells[Capacity];
+  alignas(crt::CACHE_LINE_SIZE) atomic<size_t> m_enqueue_pos{0};
+  alignas(crt::CACHE_LINE_SIZE) atomic<size_t> m_dequeue_pos{0};
+};
+}  // namespace ktl::lockfree
@@ -7,17 +7,36 @@
 #include <algorithm.hpp>
 #include <allocator.hpp>
 #include <atomic.hpp>
+#include <irql.hpp>
+#include <per_cpu.hpp>
+#include <trimmable.hpp>
 #include <type_traits.hpp>
 #include <utility.hpp>
 
 #include <ntddk.h>
 
 namespace ktl::lockfree {
+namespace details {
+struct untrimmable {};
+}  // namespace details
+
+/**
+ * @class node_allocator
+ * @brief Lock-free free list of the nodes of the same size
+ * @details The nodes are kept until destruction. If Trimmable is true, the
+ * allocator implements trimmable and may also free them in trim(); to wait
+ * for the concurrent allocations reading the freed nodes, each of them runs
+ * at DISPATCH_LEVEL then. The nodes must not be accessed after deallocate()
+ * if the allocator is trimmed, so the allocators of the containers relying on
+ * type-stable memory, e.g. mpmc_queue, are never trimmable
+ */
 template <class Ty,
           align_val_t Align,
           template <typename, align_val_t>
-          class BasicNodeAllocator>
-class node_allocator {
+          class BasicNodeAllocator,
+          bool Trimmable = false>
+class node_allocator
+    : public conditional_t<Trimmable, trimmable, details::untrimmable> {
  public:
   using value_type = Ty;
   using size_type = size_t;
@@ -90,31 +109,64 @@ class node_allocator {
   }
 
   Ty* allocate() {
-    auto& head{get_head()};
-    auto old_top_value{head.load<memory_order_consume>()};
+    Ty* ptr{pop()};
+    return ptr ? ptr : create_memory_block();
+  }
 
-    Ty* ptr{nullptr};
-    while (!ptr) {
-      auto old_top{node_pointer{old_top_value}};
+  /**
+   * @fn node_allocator::trim
+   * @brief Frees a part of the cached nodes. Waits until the concurrent
+   * allocate() calls stop reading the freed nodes, so it does nothing at
+   * IRQL > APC_LEVEL
+   * @return Number of the released bytes
+   */
+  size_t trim(trim_level level) noexcept {  // Overrides trimmable::trim()
+    static_assert(Trimmable, "the allocations don't wait for trim()");
+    if (!irql_less_or_equal(APC_LEVEL)) {
+      return 0;
+    }
+    auto& head{get_head()};
+    auto old_top_value{head.template load<memory_order_relaxed>()};
+    node_pointer detached;
+    for (;;) {
+      node_pointer old_top{old_top_value};
       if (!old_top) {
-        ptr = create_memory_block();
+        return 0;
+      }
+      const node_pointer empty{nullptr, old_top.get_next_tag()};
+      // old_top_value may be rewritten
+      if (head.compare_exchange_weak(old_top_value, empty.get_value())) {
+        detached = old_top;
+        break;
+      }
+    }
+    // The pops which have read the detached nodes are running at
+    // DISPATCH_LEVEL, so they have finished when every processor is visited
+    run_on_each_processor([] {});
+
+    size_type cached{0};
+    for (node_pointer node{detached}; node;
+         node = node_pointer{
+             node->next.template load<memory_order_relaxed>()}) {
+      ++cached;
+    }
+    const size_type released{get_trim_count(cached, level)};
+    node_pointer node{detached};
+    for (size_type idx = 0; idx < cached; ++idx) {
+      auto* target{reinterpret_cast<Ty*>(node.get_pointer())};
+      node = node_pointer{node->next.template load<memory_order_relaxed>()};
+      if (idx < released) {
+        destroy_memory_block(target);
       } else {
-        memory_block_header* new_top_ptr =
-            node_pointer{old_top->next}.get_pointer();
-        node_pointer new_pool{new_top_ptr, old_top.get_next_tag()};
-
-        // old_top_value may be rewritten
-        if (head.compare_exchange_weak(old_top_value, new_pool.get_value())) {
-          ptr = reinterpret_cast<Ty*>(old_top.get_pointer());
-        }
+        deallocate(target);
       }
     }
-    return ptr;
+    return released * sizeof(memory_block);
   }
 
   void deallocate(Ty* ptr) noexcept {
     auto& head{get_head()};
-    auto old_top_value{head.load<memory_order_consume>()};
+    auto old_top_value{head.template load<memory_order_consume>()};
 
     auto* new_top_ptr = reinterpret_cast<memory_block_header*>(ptr);
 
@@ -130,6 +182,42 @@ class node_allocator {
   }
 
  private:
+  // Runs at DISPATCH_LEVEL at least if the allocator is trimmable, see trim()
+  Ty* pop() noexcept {
+    if constexpr (Trimmable) {
+      const irql_t prev_irql{raise_irql(
+          (max)(get_current_irql(), static_cast<irql_t>(DISPATCH_LEVEL)))};
+      Ty* ptr{pop_impl()};
+      lower_irql(prev_irql);
+      return ptr;
+    } else {
+      return pop_impl();
+    }
+  }
+
+  Ty* pop_impl() noexcept {
+    auto& head{get_head()};
+    auto old_top_value{head.template load<memory_order_consume>()};
+
+    Ty* ptr{nullptr};
+    for (;;) {
+      auto old_top{node_pointer{old_top_value}};
+      if (!old_top) {
+        break;
+      }
+      memory_block_header* new_top_ptr =
+          node_pointer{old_top->next}.get_pointer();
+      node_pointer new_pool{new_top_ptr, old_top.get_next_tag()};
+
+      // old_top_value may be rewritten
+      if (head.compare_exchange_weak(old_top_value, new_pool.get_value())) {
+        ptr = reinterpret_cast<Ty*>(old_top.get_pointer());
+        break;
+      }
+    }
+    return ptr;
+  }
+
   Ty* create_memory_block() {
     return reinterpret_cast<Ty*>(
         allocator_traits_type::allocate(get_alloc(), 1));
@@ -142,14 +230,14 @@ class node_allocator {
 
   Ty* pop_unsafe_without_allocation() {
     auto& head{get_head()};
-    auto old_top{node_pointer{head.load<memory_order_relaxed>()}};
+    auto old_top{node_pointer{head.template load<memory_order_relaxed>()}};
 
     Ty* ptr{nullptr};
     if (old_top) {
       memory_block_header* new_top_ptr =
           node_pointer{old_top->next}.get_pointer();
       node_pointer new_top{new_top_ptr, old_top.get_next_tag()};
-      head.store<memory_order_relaxed>(new_top.get_value());
+      head.template store<memory_order_relaxed>(new_top.get_value());
       ptr = reinterpret_cast<Ty*>(old_top.get_pointer());
     }
     return ptr;
@@ -158,11 +246,11 @@ class node_allocator {
   void push_unsafe(Ty* ptr) {
     auto& head{get_head()};
     auto* new_top_ptr = reinterpret_cast<memory_block_header*>(ptr);
-    node_pointer current_head{head.load<memory_order_relaxed>()};
+    node_pointer current_head{head.template load<memory_order_relaxed>()};
     node_pointer new_top{new_top_ptr, current_head.get_tag()};
-    new_top->next.store<memory_order_relaxed>(
+    new_top->next.template store<memory_order_relaxed>(
         node_pointer{current_head.get_pointer()}.get_value());
-    head.store<memory_order_relaxed>(new_top.get_value());
+    head.template store<memory_order_relaxed>(new_top.get_value());
   }
 
   allocator_type& get_alloc() noexcept { return m_freelist.get_first(); }
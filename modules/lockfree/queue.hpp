@@ -32,21 +32,21 @@ class mpmc_queue : public non_relocatable {  // multi-producer, multi-consumer
   using node_pointer_holder = atomic<typename node_pointer::placeholder_type>;
 
   struct node {
-    node() noexcept(is_nothrow_default_constructible_v<Ty>) = default;
+    node() noexcept(is_nothrow_default_constructible_v<Ty>) : next{0} {}
 
     node(node_pointer next_) noexcept : next{next_.value()} {}
 
-    node(const Ty& value_) noexcept : value(value_) {
-      // increment tag to avoid ABA problem
-      next.store<memory_order_release>(
-          node_pointer(nullptr, node_pointer{next}.get_next_tag()).get_value());
-    }
+    // The tag is the next one after the tag of the reused node to avoid
+    // the ABA problem: otherwise a stale push may link its node to the
+    // reused one before it's published
+    node(const Ty& value_, typename node_pointer::tag_type tag) noexcept
+        : value(value_), next{node_pointer{nullptr, tag}.get_value()} {}
 
     Ty value;  // No default construction
-    node_pointer_holder next{0};
+    node_pointer_holder next;
   };
 
-  ALIGN(NODE_ALIGNMENT) struct aligned_node_pointer_holder {
+  struct ALIGN(NODE_ALIGNMENT) aligned_node_pointer_holder {
     node_pointer_holder& get_ptr() noexcept { return ptr; }
     const node_pointer_holder& get_ptr() const noexcept { return ptr; }
 
@@ -79,7 +79,8 @@ class mpmc_queue : public non_relocatable {  // multi-producer, multi-consumer
     Ty dummy;
     while (unsynchronized_pop_impl<false>(dummy))
       ;
-    destroy_node(node_pointer{m_head.get_ptr().load<memory_order_relaxed>()});
+    destroy_node(node_pointer{
+        m_head.get_ptr().template load<memory_order_relaxed>()});
   }
 
   // OtherTy имеет право бросить исключение при конвертации в Ty
@@ -104,11 +105,14 @@ class mpmc_queue : public non_relocatable {  // multi-producer, multi-consumer
     auto* new_node{create_data_node(value)};
 
     for (;;) {
-      auto tail{node_pointer{m_tail.get_ptr().load<memory_order_acquire>()}};
+      auto tail{node_pointer{
+          m_tail.get_ptr().template load<memory_order_acquire>()}};
       node* tail_ptr{tail.get_pointer()};
-      auto next{node_pointer{tail_ptr->next.load<memory_order_acquire>()}};
+      auto next{node_pointer{
+          tail_ptr->next.template load<memory_order_acquire>()}};
 
-      node_pointer current_tail{m_tail.get_ptr().load<memory_order_acquire>()};
+      node_pointer current_tail{
+          m_tail.get_ptr().template load<memory_order_acquire>()};
       if (tail == current_tail) {
         if (!next) {
           node_pointer new_tail_next{new_node, next.get_next_tag()};
@@ -132,14 +136,18 @@ class mpmc_queue : public non_relocatable {  // multi-producer, multi-consumer
                         int> = 0>
   bool pop(OtherTy& value) {
     for (;;) {
-      auto head{node_pointer{m_head.get_ptr().load<memory_order_acquire>()}};
+      auto head{node_pointer{
+          m_head.get_ptr().template load<memory_order_acquire>()}};
       node* head_ptr{head.get_pointer()};
 
-      auto tail{node_pointer{m_tail.get_ptr().load<memory_order_acquire>()}};
-      auto next{node_pointer{head_ptr->next.load<memory_order_acquire>()}};
+      auto tail{node_pointer{
+          m_tail.get_ptr().template load<memory_order_acquire>()}};
+      auto next{node_pointer{
+          head_ptr->next.template load<memory_order_acquire>()}};
       node* next_ptr = next.get_pointer();
 
-      node_pointer current_head{m_head.get_ptr().load<memory_order_acquire>()};
+      node_pointer current_head{
+          m_head.get_ptr().template load<memory_order_acquire>()};
       if (head == current_head) {
         if (head == tail) {
           if (!next) {
@@ -179,8 +187,10 @@ class mpmc_queue : public non_relocatable {  // multi-producer, multi-consumer
                   "Ty must be trivially destructible");
 
     node_pointer dummy_node_ptr{create_empty_node(), 0};
-    m_head.get_ptr().store<memory_order_relaxed>(dummy_node_ptr.get_value());
-    m_tail.get_ptr().store<memory_order_release>(dummy_node_ptr.get_value());
+    m_head.get_ptr().template store<memory_order_relaxed>(
+        dummy_node_ptr.get_value());
+    m_tail.get_ptr().template store<memory_order_release>(
+        dummy_node_ptr.get_value());
   }
 
   node* create_empty_node() {
@@ -191,7 +201,14 @@ class mpmc_queue : public non_relocatable {  // multi-producer, multi-consumer
 
   node* create_data_node(const Ty& value) {
     auto* node{allocator_traits_type::allocate_single_object(m_alc)};
-    return allocator_traits_type::construct(m_alc, node, value);
+    // The nodes aren't destroyed before deallocation, so the storage still
+    // keeps the tag of the previous node. It must be read before the
+    // construction: the value of a member of an object being constructed is
+    // indeterminate
+    const auto tag{
+        node_pointer{node->next.template load<memory_order_relaxed>()}
+            .get_next_tag()};
+    return allocator_traits_type::construct(m_alc, node, value, tag);
   }
 
   void destroy_node(node_pointer target) {
@@ -205,17 +222,18 @@ class mpmc_queue : public non_relocatable {  // multi-producer, multi-consumer
     auto new_node{create_data_node(value)};
 
     for (;;) {
-      auto tail{node_pointer{m_tail.get_ptr().load<memory_order_relaxed>()}};
-      auto next{node_pointer{tail->next.load<memory_order_relaxed>()}};
+      auto tail{node_pointer{
+          m_tail.get_ptr().template load<memory_order_relaxed>()}};
+      auto next{node_pointer{tail->next.template load<memory_order_relaxed>()}};
 
       if (!next) {
-        tail->next.store<memory_order_relaxed>(
+        tail->next.template store<memory_order_relaxed>(
             node_pointer{new_node, next.get_next_tag()}.get_value());
-        m_tail.get_ptr().store<memory_order_relaxed>(
+        m_tail.get_ptr().template store<memory_order_relaxed>(
             node_pointer{new_node, tail.get_next_tag()}.get_value());
         return true;
       }
-      m_tail.get_ptr().store<memory_order_relaxed>(
+      m_tail.get_ptr().template store<memory_order_relaxed>(
           node_pointer{next.get_pointer(), tail.get_next_tag()}.get_value());
     }
   }
@@ -223,18 +241,20 @@ class mpmc_queue : public non_relocatable {  // multi-producer, multi-consumer
   template <bool CopyToOutput, typename OtherTy>
   bool unsynchronized_pop_impl(OtherTy& value) {
     for (;;) {
-      auto head{node_pointer{m_head.get_ptr().load<memory_order_relaxed>()}};
+      auto head{node_pointer{
+          m_head.get_ptr().template load<memory_order_relaxed>()}};
       auto* head_ptr{head.get_pointer()};
       node_pointer next{head_ptr->next};
 
-      if (auto tail =
-              node_pointer{m_tail.get_ptr().load<memory_order_relaxed>()};
+      if (auto tail = node_pointer{
+              m_tail.get_ptr().template load<memory_order_relaxed>()};
           head == tail) {
         if (!next) {
           return false;
         }
         node_pointer new_tail{next.get_pointer(), tail.get_next_tag()};
-        m_tail.get_ptr().store<memory_order_release>(new_tail.get_value());
+        m_tail.get_ptr().template store<memory_order_release>(
+            new_tail.get_value());
 
       } else {
         if (!next) {
@@ -252,7 +272,8 @@ class mpmc_queue : public non_relocatable {  // multi-producer, multi-consumer
           value = next_ptr->value;  // aligned load
         }
         node_pointer new_head{next_ptr, head.get_next_tag()};
-        m_head.get_ptr().store<memory_order_release>(new_head.get_value());
+        m_head.get_ptr().template store<memory_order_release>(
+            new_head.get_value());
         destroy_node(head);
 
         return true;
@@ -14,8 +14,13 @@ class tagged_pointer {
 
  private:
   static constexpr size_t POINTER_WIDTH{48}, TAG_WIDTH{16};
+#ifdef KTL_HOSTED
+  // The upper bits of the user-mode addresses are zeroes
+  static constexpr placeholder_type KERNEL_MODE_ADDRESS_MASK{0};
+#else
   static constexpr placeholder_type KERNEL_MODE_ADDRESS_MASK{
       0xFFFF'0000'0000'0000ull};
+#endif
 
  private:
   struct compressed_pointer {
@@ -81,7 +86,9 @@ class tagged_pointer {
   }
 
   static constexpr placeholder_type to_number(compressed_pointer ptr) noexcept {
-    return ptr.address | (ptr.tag << POINTER_WIDTH);
+    // The narrow bit-fields are promoted to int by GCC
+    return ptr.address |
+           (static_cast<placeholder_type>(ptr.tag) << POINTER_WIDTH);
   }
 
  private:
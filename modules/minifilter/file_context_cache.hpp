@@ -0,0 +1,419 @@
+#pragma once
+#include <atomic.hpp>
+#include <basic_types.hpp>
+#include <hash.hpp>
+#include <heap.hpp>
+#include <mutex.hpp>
+#include <smart_pointer.hpp>
+#include <type_traits.hpp>
+#include <unordered_map.hpp>
+#include <utility.hpp>
+
+#include <fltkernel.h>
+
+namespace ktl::mf {
+/**
+ * @class file_context
+ * @brief Base class of the per-file state kept in file_context_cache.
+ * The object is reference counted and deleted when the last intrusive_ptr
+ * to it is gone, so a callback may keep using the state after eviction
+ */
+class file_context : non_relocatable {
+ protected:
+  file_context() noexcept = default;
+  virtual ~file_context() = default;
+
+ private:
+  friend void intrusive_ptr_add_ref(file_context* ctx) noexcept {
+    ++ctx->m_refs;
+  }
+
+  friend void intrusive_ptr_release(file_context* ctx) noexcept {
+    if (--ctx->m_refs == 0) {
+      delete ctx;
+    }
+  }
+
+ private:
+  atomic<uint32_t> m_refs{0};
+};
+
+/**
+ * @struct stream_key
+ * @brief Identifies a stream by the FsContext shared by all of its file
+ * objects
+ */
+struct stream_key {
+  const void* fs_context;
+};
+
+constexpr bool operator==(stream_key lhs, stream_key rhs) noexcept {
+  return lhs.fs_context == rhs.fs_context;
+}
+
+/**
+ * @struct file_object_key
+ * @brief Identifies an opened file object. Unlike stream_key it tells the
+ * handles opened by the different hard links apart
+ */
+struct file_object_key {
+  const void* file_object;
+};
+
+constexpr bool operator==(file_object_key lhs, file_object_key rhs) noexcept {
+  return lhs.file_object == rhs.file_object;
+}
+
+/**
+ * @struct file_id_key
+ * @brief Identifies a file by the volume and the file system's FileId. Unlike
+ * stream_key it survives the file being closed and reopened
+ */
+struct file_id_key {
+  const void* volume;
+  int64_t file_id;
+};
+
+constexpr bool operator==(const file_id_key& lhs,
+                          const file_id_key& rhs) noexcept {
+  return lhs.volume == rhs.volume && lhs.file_id == rhs.file_id;
+}
+}  // namespace ktl::mf
+
+namespace ktl {
+template <>
+struct hash<mf::stream_key> {
+  size_t operator()(mf::stream_key key) const noexcept {
+    return hash<const void*>{}(key.fs_context);
+  }
+};
+
+template <>
+struct hash<mf::file_object_key> {
+  size_t operator()(mf::file_object_key key) const noexcept {
+    return hash<const void*>{}(key.file_object);
+  }
+};
+
+template <>
+struct hash<mf::file_id_key> {
+  size_t operator()(const mf::file_id_key& key) const noexcept {
+    return hash_int(reinterpret_cast<size_t>(key.volume) ^
+                    static_cast<uint64_t>(key.file_id));
+  }
+};
+}  // namespace ktl
+
+namespace ktl::mf {
+/**
+ * @enum eviction_point
+ * @brief Notification which drops the cached state of a file
+ */
+enum class eviction_point : uint8_t {
+  cleanup,  //!< The last handle is closed (IRP_MJ_CLEANUP)
+  close,    //!< The file object is torn down (IRP_MJ_CLOSE)
+};
+
+// The keys are shared by all of the file objects of a stream (or a file), so
+// the state is evicted when the last of the counted ones reaches the eviction
+// point. A key which wasn't counted with on_open() is evicted at once
+
+// The key backends give no key for a file object which isn't opened yet
+// (FsContext is NULL in the pre-create callback): the create may still fail,
+// and then no IRP_MJ_CLOSE would evict the state
+
+/**
+ * @struct flt_stream_backend
+ * @brief Extracts stream_key from the objects passed to the callbacks
+ */
+struct flt_stream_backend {
+  using key_type = stream_key;
+  static constexpr bool is_per_file_object{false};
+
+  static bool get_key(key_type& key,
+                      [[maybe_unused]] const FLT_CALLBACK_DATA& data,
+                      const FLT_RELATED_OBJECTS& objects) noexcept {
+    const auto* file_object{objects.FileObject};
+    if (!file_object || !file_object->FsContext) {
+      return false;
+    }
+    key = key_type{file_object->FsContext};
+    return true;
+  }
+};
+
+/**
+ * @struct flt_file_id_backend
+ * @brief Queries file_id_key with FltQueryInformationFile().
+ * Must be called at PASSIVE_LEVEL
+ */
+struct flt_file_id_backend {
+  using key_type = file_id_key;
+  static constexpr bool is_per_file_object{false};
+
+  static bool get_key(key_type& key,
+                      [[maybe_unused]] const FLT_CALLBACK_DATA& data,
+                      const FLT_RELATED_OBJECTS& objects) noexcept {
+    const auto* file_object{objects.FileObject};
+    if (!file_object || !file_object->FsContext || !objects.Volume) {
+      return false;
+    }
+    FILE_INTERNAL_INFORMATION info;
+    const NTSTATUS status{FltQueryInformationFile(
+        objects.Instance, objects.FileObject, addressof(info), sizeof(info),
+        FileInternalInformation, nullptr)};
+    if (!NT_SUCCESS(status)) {
+      return false;
+    }
+    key = key_type{objects.Volume, info.IndexNumber.QuadPart};
+    return true;
+  }
+};
+
+/**
+ * @struct flt_file_object_backend
+ * @brief Extracts file_object_key from the objects passed to the callbacks
+ */
+struct flt_file_object_backend {
+  using key_type = file_object_key;
+  static constexpr bool is_per_file_object{true};
+
+  static bool get_key(key_type& key,
+                      [[maybe_unused]] const FLT_CALLBACK_DATA& data,
+                      const FLT_RELATED_OBJECTS& objects) noexcept {
+    const auto* file_object{objects.FileObject};
+    if (!file_object || !file_object->FsContext) {
+      return false;
+    }
+    key = key_type{file_object};
+    return true;
+  }
+};
+
+/**
+ * @class file_context_cache
+ * @brief Concurrent map from a file to its per-file state
+ * @details The map is split into the shards protected by their own locks, so
+ * the callbacks processing unrelated files don't contend. Backend extracts the
+ * key from the callback parameters: flt_stream_backend, flt_file_id_backend and
+ * flt_file_object_backend call the filter manager, tests pass a stand-in with
+ * the same interface.
+ * Methods allocate memory and take a push lock, so they must be called at
+ * IRQL <= APC_LEVEL. The file objects opened with on_open() are counted per
+ * key, so closing one of the handles doesn't evict the state the others use.
+ */
+template <class Ty,
+          class Backend = flt_stream_backend,
+          size_t ShardCount = 16,
+          class Hash = hash<typename Backend::key_type>,
+          class Mutex = push_lock>
+class file_context_cache : non_relocatable {
+  static_assert(is_base_of_v<file_context, Ty>,
+                "Ty must be derived from file_context");
+  static_assert(ShardCount > 0 && (ShardCount & (ShardCount - 1)) == 0,
+                "ShardCount must be a power of 2");
+
+ public:
+  using key_type = typename Backend::key_type;
+  using value_type = Ty;
+  using pointer = intrusive_ptr<Ty>;
+  using backend_type = Backend;
+  using hasher = Hash;
+
+ private:
+  using map_type = unordered_map<key_type, pointer, hasher>;
+  using open_count_map = unordered_map<key_type, uint32_t, hasher>;
+
+  struct alignas(crt::CACHE_LINE_SIZE) shard {
+    map_type map;
+    open_count_map open_counts;
+    mutable Mutex lock;
+  };
+
+ public:
+  explicit file_context_cache(
+      eviction_point evict_on = eviction_point::cleanup) noexcept
+      : m_evict_on{evict_on} {}
+
+  /**
+   * @fn file_context_cache::find
+   * @param[in] key Identifier of the file
+   * @return Cached state or an empty pointer
+   */
+  pointer find(const key_type& key) const {
+    const auto& target{get_shard(key)};
+    shared_lock guard{target.lock};
+    if (auto it = target.map.find(key); it != target.map.end()) {
+      return it->second;
+    }
+    return pointer{};
+  }
+
+  /**
+   * @fn file_context_cache::find_or_create
+   * @brief Returns the cached state or caches the one made by the factory.
+   * If two threads race for the same file, the state created by the first one
+   * wins and the other one is discarded
+   * @param[in] key Identifier of the file
+   * @param[in] factory Callable returning pointer; it's invoked without holding
+   * the lock. An empty pointer isn't cached
+   */
+  template <class Factory>
+  pointer find_or_create(const key_type& key, Factory&& factory) {
+    if (auto cached = find(key); cached) {
+      return cached;
+    }
+    pointer created{forward<Factory>(factory)()};
+    if (!created) {
+      return created;
+    }
+    auto& target{get_shard(key)};
+    lock_guard guard{target.lock};
+    return target.map.try_emplace(key, move(created)).first->second;
+  }
+
+  /**
+   * @fn file_context_cache::insert_or_assign
+   * @brief Replaces the cached state of the file
+   */
+  void insert_or_assign(const key_type& key, pointer value) {
+    auto& target{get_shard(key)};
+    lock_guard guard{target.lock};
+    target.map.insert_or_assign(key, move(value));
+  }
+
+  /**
+   * @fn file_context_cache::erase
+   * @return Evicted state which may be finalized outside of the lock
+   */
+  pointer erase(const key_type& key) {
+    pointer evicted;
+    auto& target{get_shard(key)};
+    lock_guard guard{target.lock};
+    if (auto it = target.map.find(key); it != target.map.end()) {
+      evicted = move(it->second);
+      target.map.erase(it);
+    }
+    return evicted;
+  }
+
+  void clear() {
+    for (auto& target : m_shards) {
+      lock_guard guard{target.lock};
+      target.map.clear();
+      target.open_counts.clear();
+    }
+  }
+
+  [[nodiscard]] size_t size() const {
+    size_t count{0};
+    for (const auto& target : m_shards) {
+      shared_lock guard{target.lock};
+      count += target.map.size();
+    }
+    return count;
+  }
+
+  /**
+   * @fn file_context_cache::lookup
+   * @brief Resolves the state of the file the callback is invoked for
+   * @param[in] args Callback parameters accepted by Backend::get_key()
+   */
+  template <class... Types>
+  pointer lookup(Types&&... args) const {
+    key_type key;
+    if (!Backend::get_key(key, forward<Types>(args)...)) {
+      return pointer{};
+    }
+    return find(key);
+  }
+
+  template <class Factory, class... Types>
+  pointer lookup_or_create(Factory&& factory, Types&&... args) {
+    key_type key;
+    if (!Backend::get_key(key, forward<Types>(args)...)) {
+      return pointer{};
+    }
+    return find_or_create(key, forward<Factory>(factory));
+  }
+
+  /**
+   * @fn file_context_cache::on_open
+   * @brief Should be called from the IRP_MJ_CREATE post-callback once the
+   * file object is opened successfully. Counts the file object, so the state
+   * stays cached until all of the counted ones reach the eviction point
+   */
+  template <class... Types>
+  void on_open(Types&&... args) {
+    key_type key;
+    if (Backend::get_key(key, forward<Types>(args)...)) {
+      auto& target{get_shard(key)};
+      lock_guard guard{target.lock};
+      ++target.open_counts[key];
+    }
+  }
+
+  /**
+   * @fn file_context_cache::on_cleanup
+   * @brief Should be called from the IRP_MJ_CLEANUP callback
+   */
+  template <class... Types>
+  void on_cleanup(Types&&... args) {
+    if (m_evict_on == eviction_point::cleanup) {
+      release(forward<Types>(args)...);
+    }
+  }
+
+  /**
+   * @fn file_context_cache::on_close
+   * @brief Should be called from the IRP_MJ_CLOSE callback
+   */
+  template <class... Types>
+  void on_close(Types&&... args) {
+    if (m_evict_on == eviction_point::close) {
+      release(forward<Types>(args)...);
+    }
+  }
+
+ private:
+  template <class... Types>
+  void release(Types&&... args) {
+    key_type key;
+    if (!Backend::get_key(key, forward<Types>(args)...)) {
+      return;
+    }
+    pointer evicted;  // Released unlocked
+    auto& target{get_shard(key)};
+    lock_guard guard{target.lock};
+    if (auto it = target.open_counts.find(key);
+        it != target.open_counts.end()) {
+      if (--it->second != 0) {
+        return;  // The other file objects of the stream are still open
+      }
+      target.open_counts.erase(it);
+    }
+    if (auto it = target.map.find(key); it != target.map.end()) {
+      evicted = move(it->second);
+      target.map.erase(it);
+    }
+  }
+
+  shard& get_shard(const key_type& key) noexcept {
+    return m_shards[get_shard_index(key)];
+  }
+
+  const shard& get_shard(const key_type& key) const noexcept {
+    return m_shards[get_shard_index(key)];
+  }
+
+  static size_t get_shard_index(const key_type& key) noexcept {
+    // Upper bits are used since the map itself relies on the lower ones
+    const size_t hash_value{hash_int(hasher{}(key))};
+    return (hash_value >> (sizeof(size_t) * CHAR_BIT / 2)) & (ShardCount - 1);
+  }
+
+ private:
+  shard m_shards[ShardCount];
+  eviction_point m_evict_on;
+};
+}  // namespace ktl::mf
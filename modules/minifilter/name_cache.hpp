@@ -0,0 +1,554 @@
+#pragma once
+// With " " instead of <> there is no need to add minifilter/ to include path
+#include "file_context_cache.hpp"
+
+#include <atomic.hpp>
+#include <basic_types.hpp>
+#include <hash.hpp>
+#include <heap.hpp>
+#include <mutex.hpp>
+#include <smart_pointer.hpp>
+#include <string.hpp>
+#include <string_view.hpp>
+#include <unordered_map.hpp>
+#include <utility.hpp>
+
+#include <fltkernel.h>
+
+namespace ktl::mf {
+/**
+ * @struct name_components
+ * @brief Location of the parsed name parts inside the full name as (offset,
+ * length) pairs in characters
+ */
+struct name_components {
+  struct range {
+    uint16_t offset;
+    uint16_t length;
+  };
+
+  range volume;
+  range share;
+  range parent_dir;
+  range final_component;
+  range extension;
+  range stream;
+};
+
+/**
+ * @class file_name_info
+ * @brief Immutable normalized name split into components once. It's shared
+ * between the cache and all of the callbacks using the name, so a hit costs
+ * a reference count increment instead of a copy of the string
+ */
+class file_name_info final : public file_context {
+ public:
+  using string_type = unicode_string;
+  using string_view_type = unicode_string_view;
+
+ public:
+  file_name_info(string_view_type name, const name_components& components)
+      : m_name(name), m_components{components} {}
+
+  [[nodiscard]] string_view_type name() const noexcept { return m_name; }
+
+  [[nodiscard]] string_view_type volume() const noexcept {
+    return get(m_components.volume);
+  }
+
+  [[nodiscard]] string_view_type share() const noexcept {
+    return get(m_components.share);
+  }
+
+  [[nodiscard]] string_view_type parent_dir() const noexcept {
+    return get(m_components.parent_dir);
+  }
+
+  [[nodiscard]] string_view_type final_component() const noexcept {
+    return get(m_components.final_component);
+  }
+
+  [[nodiscard]] string_view_type extension() const noexcept {
+    return get(m_components.extension);
+  }
+
+  [[nodiscard]] string_view_type stream() const noexcept {
+    return get(m_components.stream);
+  }
+
+ private:
+  string_view_type get(name_components::range range) const noexcept {
+    return string_view_type{m_name.data() + range.offset, range.length};
+  }
+
+ private:
+  string_type m_name;
+  name_components m_components;
+};
+
+/**
+ * @enum name_change
+ * @brief Effect of an operation on the cached names
+ */
+enum class name_change : uint8_t {
+  none,  //!< Names are unaffected
+  file,  //!< Name of the target file has changed
+  tree,  //!< Names of the target directory and all its descendants changed
+};
+
+/**
+ * @struct opened_name
+ * @brief Path passed to IRP_MJ_CREATE and the volume it's opened on
+ */
+struct opened_name {
+  const void* volume;
+  unicode_string_view path;
+};
+
+/**
+ * @struct opened_name_key
+ * @brief Identifies an opened name by the volume and the hash of the path.
+ * The path itself is kept in the cache entry, so a collision is a miss
+ */
+struct opened_name_key {
+  const void* volume;
+  size_t path_hash;
+};
+
+constexpr bool operator==(const opened_name_key& lhs,
+                          const opened_name_key& rhs) noexcept {
+  return lhs.volume == rhs.volume && lhs.path_hash == rhs.path_hash;
+}
+}  // namespace ktl::mf
+
+namespace ktl {
+template <>
+struct hash<mf::opened_name_key> {
+  size_t operator()(const mf::opened_name_key& key) const noexcept {
+    return hash_int(reinterpret_cast<size_t>(key.volume) ^ key.path_hash);
+  }
+};
+}  // namespace ktl
+
+namespace ktl::mf {
+/**
+ * @struct flt_name_backend
+ * @brief Queries names from the filter manager. The names are cached by the
+ * path passed to IRP_MJ_CREATE, which is known in the pre-create callback
+ * already and is different for each hard link, and are attached to the file
+ * objects opened by the path for the later operations
+ */
+struct flt_name_backend {
+  using handle_key_type = file_object_key;
+
+  static bool get_handle_key(handle_key_type& key,
+                             const FLT_CALLBACK_DATA& data,
+                             const FLT_RELATED_OBJECTS& objects) noexcept {
+    return flt_file_object_backend::get_key(key, data, objects);
+  }
+
+  // FILE_OBJECT::FileName is valid only while IRP_MJ_CREATE is processed.
+  // The opens relative to another file object and by FileId give no name:
+  // the former depend on the name of the related file, the latter carry no
+  // path at all. The path is compared case-sensitively, since the case
+  // matters in the case-sensitive directories
+  static bool get_opened_name(opened_name& name,
+                              const FLT_CALLBACK_DATA& data,
+                              const FLT_RELATED_OBJECTS& objects) noexcept {
+    const auto* file_object{objects.FileObject};
+    if (data.Iopb->MajorFunction != IRP_MJ_CREATE || !file_object ||
+        !objects.Volume || file_object->RelatedFileObject ||
+        !file_object->FileName.Length ||
+        (data.Iopb->Parameters.Create.Options & FILE_OPEN_BY_FILE_ID)) {
+      return false;
+    }
+    name = opened_name{objects.Volume,
+                       unicode_string_view{file_object->FileName}};
+    return true;
+  }
+
+  static intrusive_ptr<file_name_info> query_name(
+      FLT_CALLBACK_DATA& data,
+      [[maybe_unused]] const FLT_RELATED_OBJECTS& objects) noexcept {
+    FLT_FILE_NAME_INFORMATION* info{nullptr};
+    NTSTATUS status{FltGetFileNameInformation(
+        addressof(data), FLT_FILE_NAME_NORMALIZED | FLT_FILE_NAME_QUERY_DEFAULT,
+        addressof(info))};
+    if (!NT_SUCCESS(status)) {
+      return {};
+    }
+    intrusive_ptr<file_name_info> name;
+    status = FltParseFileNameInformation(info);
+    if (NT_SUCCESS(status)) {
+      const auto* base{info->Name.Buffer};
+      const auto make_range = [base](const UNICODE_STRING& part) noexcept {
+        return name_components::range{
+            static_cast<uint16_t>(part.Buffer ? part.Buffer - base : 0),
+            static_cast<uint16_t>(part.Length / sizeof(wchar_t))};
+      };
+      const name_components components{
+          make_range(info->Volume),         make_range(info->Share),
+          make_range(info->ParentDir),      make_range(info->FinalComponent),
+          make_range(info->Extension),      make_range(info->Stream)};
+      try {
+        name.reset(
+            new file_name_info{unicode_string_view{info->Name}, components});
+      } catch (...) {  // Out of memory, the name will be queried next time
+      }
+    }
+    FltReleaseFileNameInformation(info);
+    return name;
+  }
+
+  static name_change classify_change(
+      const FLT_CALLBACK_DATA& data,
+      const FLT_RELATED_OBJECTS& objects) noexcept {
+    const auto& params{data.Iopb->Parameters.SetFileInformation};
+    switch (params.FileInformationClass) {
+      case FileRenameInformation:
+      case FileRenameInformationEx:
+        break;
+      case FileLinkInformation:
+      case FileLinkInformationEx:  // A new link doesn't rename the old ones
+      default:
+        return name_change::none;
+    }
+    BOOLEAN is_directory{FALSE};
+    const NTSTATUS status{FltIsDirectory(objects.FileObject, objects.Instance,
+                                         addressof(is_directory))};
+    return NT_SUCCESS(status) && !is_directory ? name_change::file
+                                               : name_change::tree;
+  }
+};
+
+/**
+ * @struct name_cache_stats
+ * @brief Counters accumulated since the cache creation
+ */
+struct name_cache_stats {
+  uint64_t hits;
+  uint64_t misses;
+  uint64_t invalidations;
+};
+
+/**
+ * @class name_cache
+ * @brief Caches parsed file names, so repeated opens of a file and the
+ * operations on its handles don't query the filter manager
+ * @details The names are kept in two maps sharing the parsed names. The first
+ * one is keyed by the opened name given by Backend::get_opened_name() and is
+ * looked up by the creates, including the pre-create callback where the file
+ * isn't opened yet. The second one is keyed by the handle given by
+ * Backend::get_handle_key() and is filled by the post-create callback and the
+ * first operation on a handle. Backend also provides query_name() returning
+ * intrusive_ptr<file_name_info> and classify_change() inspecting
+ * IRP_MJ_SET_INFORMATION. A rename drops only the names of the renamed file
+ * or directory tree, so the other hard links keep theirs. A name queried
+ * concurrently with a rename isn't cached: each shard has a generation counter
+ * bumped by every invalidation, and the result of the query is inserted only
+ * if the generation hasn't changed while it was running. The opened names are
+ * bounded by max_names, the handles are dropped by on_close(). Methods must be
+ * called at IRQL <= APC_LEVEL.
+ */
+template <class Backend = flt_name_backend,
+          size_t ShardCount = 16,
+          class Mutex = push_lock>
+class name_cache : non_relocatable {
+  static_assert(ShardCount > 0 && (ShardCount & (ShardCount - 1)) == 0,
+                "ShardCount must be a power of 2");
+
+ public:
+  using handle_key_type = typename Backend::handle_key_type;
+  using pointer = intrusive_ptr<file_name_info>;
+  using backend_type = Backend;
+
+  static constexpr size_t DEFAULT_MAX_NAMES{4096};
+
+ private:
+  struct opened_entry {
+    unicode_string path;
+    pointer name;
+  };
+
+  using name_map = unordered_map<opened_name_key, opened_entry>;
+  using handle_map = unordered_map<handle_key_type, pointer>;
+
+  struct alignas(crt::CACHE_LINE_SIZE) shard {
+    name_map names;
+    handle_map handles;
+    mutable Mutex lock;
+    uint64_t generation{0};  // Guarded by lock
+    atomic<uint64_t> hits{0};
+    atomic<uint64_t> misses{0};
+  };
+
+ public:
+  explicit name_cache(size_t max_names = DEFAULT_MAX_NAMES) noexcept
+      : m_max_names_per_shard{max_names > ShardCount ? max_names / ShardCount
+                                                     : 1} {}
+
+  /**
+   * @fn name_cache::get
+   * @brief Returns the cached name of the file or queries it with
+   * Backend::query_name(). If the backend gives neither the opened name nor
+   * the handle key (e.g. for a relative open in the pre-create callback) the
+   * name is queried without caching
+   * @param[in] args Callback parameters accepted by the backend
+   * @return Parsed name or an empty pointer if it can't be obtained
+   */
+  template <class... Types>
+  pointer get(Types&&... args) {
+    handle_key_type handle_key;
+    opened_name opened;
+    const bool has_handle{Backend::get_handle_key(handle_key, args...)};
+    const bool has_opened{Backend::get_opened_name(opened, args...)};
+    if (!has_handle && !has_opened) {
+      return Backend::query_name(forward<Types>(args)...);
+    }
+
+    uint64_t handle_generation{0};
+    if (has_handle) {
+      auto& target{get_shard(handle_key)};
+      shared_lock guard{target.lock};
+      if (auto it = target.handles.find(handle_key);
+          it != target.handles.end()) {
+        target.hits.template fetch_add<memory_order_relaxed>(1);
+        return it->second;
+      }
+      handle_generation = target.generation;
+    }
+
+    pointer name;
+    if (has_opened) {
+      const opened_name_key name_key{make_key(opened)};
+      auto& target{get_shard(name_key)};
+      uint64_t name_generation;
+      {
+        shared_lock guard{target.lock};
+        if (auto it = target.names.find(name_key);
+            it != target.names.end() && it->second.path == opened.path) {
+          name = it->second.name;
+        }
+        name_generation = target.generation;
+      }
+      if (name) {
+        target.hits.template fetch_add<memory_order_relaxed>(1);
+      } else {
+        target.misses.template fetch_add<memory_order_relaxed>(1);
+        name = Backend::query_name(forward<Types>(args)...);
+        if (name) {
+          insert_opened(target, name_key, opened.path, name, name_generation);
+        }
+      }
+    } else {
+      get_shard(handle_key).misses.template fetch_add<memory_order_relaxed>(1);
+      name = Backend::query_name(forward<Types>(args)...);
+    }
+
+    if (name && has_handle) {
+      auto& target{get_shard(handle_key)};
+      lock_guard guard{target.lock};
+      if (target.generation == handle_generation) {
+        target.handles.try_emplace(handle_key, name);
+      }
+    }
+    return name;
+  }
+
+  /**
+   * @fn name_cache::on_set_information
+   * @brief Should be called from the IRP_MJ_SET_INFORMATION post-operation
+   * callback. Drops the names changed by rename. The old name is taken from
+   * the handle, so all of the names are dropped if the handle has none cached
+   */
+  template <class... Types>
+  void on_set_information(Types&&... args) {
+    const name_change change{Backend::classify_change(args...)};
+    if (change == name_change::none) {
+      return;
+    }
+    handle_key_type key;
+    pointer old_name;
+    if (Backend::get_handle_key(key, forward<Types>(args)...)) {
+      old_name = find(key);
+    }
+    if (old_name) {
+      invalidate(old_name->name(), change);
+    } else {
+      invalidate_all();
+    }
+  }
+
+  /**
+   * @fn name_cache::on_close
+   * @brief Should be called from the IRP_MJ_CLOSE callback, the handle keys
+   * may be reused afterwards
+   */
+  template <class... Types>
+  void on_close(Types&&... args) {
+    handle_key_type key;
+    if (Backend::get_handle_key(key, forward<Types>(args)...)) {
+      pointer evicted;  // Released unlocked
+      auto& target{get_shard(key)};
+      lock_guard guard{target.lock};
+      ++target.generation;
+      if (auto it = target.handles.find(key); it != target.handles.end()) {
+        evicted = move(it->second);
+        target.handles.erase(it);
+      }
+    }
+  }
+
+  /**
+   * @fn name_cache::invalidate
+   * @brief Drops the names of a renamed file and its streams
+   * (name_change::file) or of a renamed directory and all of its descendants
+   * (name_change::tree). The other hard links of a file keep their names
+   * @param[in] name Normalized name before the rename
+   * @param[in] change Scope of the change
+   */
+  void invalidate(unicode_string_view name, name_change change) {
+    m_invalidations.fetch_add<memory_order_relaxed>(1);
+    const auto is_affected = [name, change](const pointer& cached) noexcept {
+      const auto cached_name{cached->name()};
+      if (!cached_name.starts_with(name)) {
+        return false;
+      }
+      if (cached_name.size() == name.size()) {
+        return true;
+      }
+      const auto separator{cached_name[name.size()]};
+      return separator == L':' ||
+             (change == name_change::tree && separator == L'\\');
+    };
+    for (auto& target : m_shards) {
+      lock_guard guard{target.lock};
+      ++target.generation;
+      for (auto it = target.names.begin(); it != target.names.end();) {
+        it = is_affected(it->second.name) ? target.names.erase(it) : ++it;
+      }
+      for (auto it = target.handles.begin(); it != target.handles.end();) {
+        it = is_affected(it->second) ? target.handles.erase(it) : ++it;
+      }
+    }
+  }
+
+  /**
+   * @fn name_cache::invalidate_all
+   * @brief Drops all of the names. Should be called on the instance teardown
+   * and filter unloading
+   */
+  void invalidate_all() {
+    m_invalidations.fetch_add<memory_order_relaxed>(1);
+    for (auto& target : m_shards) {
+      name_map evicted_names;  // Released unlocked
+      handle_map evicted_handles;
+      {
+        lock_guard guard{target.lock};
+        ++target.generation;
+        evicted_names.swap(target.names);
+        evicted_handles.swap(target.handles);
+      }
+    }
+  }
+
+  /**
+   * @fn name_cache::size
+   * @return Number of the cached opened names
+   */
+  [[nodiscard]] size_t size() const {
+    size_t count{0};
+    for (const auto& target : m_shards) {
+      shared_lock guard{target.lock};
+      count += target.names.size();
+    }
+    return count;
+  }
+
+  /**
+   * @fn name_cache::handle_count
+   * @return Number of the handles with the name attached
+   */
+  [[nodiscard]] size_t handle_count() const {
+    size_t count{0};
+    for (const auto& target : m_shards) {
+      shared_lock guard{target.lock};
+      count += target.handles.size();
+    }
+    return count;
+  }
+
+  [[nodiscard]] name_cache_stats stats() const noexcept {
+    name_cache_stats result{};
+    for (const auto& target : m_shards) {
+      result.hits += target.hits.template load<memory_order_relaxed>();
+      result.misses += target.misses.template load<memory_order_relaxed>();
+    }
+    result.invalidations = m_invalidations.load<memory_order_relaxed>();
+    return result;
+  }
+
+ private:
+  static opened_name_key make_key(const opened_name& opened) noexcept {
+    return opened_name_key{opened.volume,
+                           hash_array(opened.path.data(), opened.path.size())};
+  }
+
+  void insert_opened(shard& target,
+                     const opened_name_key& key,
+                     unicode_string_view path,
+                     const pointer& name,
+                     uint64_t generation) {
+    opened_entry entry{unicode_string{path}, name};
+    opened_entry evicted;  // Released unlocked
+    lock_guard guard{target.lock};
+    if (target.generation != generation) {
+      return;
+    }
+    auto it{target.names.find(key)};
+    if (it == target.names.end() &&
+        target.names.size() >= m_max_names_per_shard) {
+      it = target.names.begin();  // The shard is full, drop any name
+      evicted = move(it->second);
+      target.names.erase(it);
+      it = target.names.end();
+    }
+    if (it != target.names.end()) {
+      evicted = move(it->second);  // Collision, the newest path wins
+      it->second = move(entry);
+    } else {
+      target.names.try_emplace(key, move(entry));
+    }
+  }
+
+  pointer find(const handle_key_type& key) const {
+    const auto& target{get_shard(key)};
+    shared_lock guard{target.lock};
+    if (auto it = target.handles.find(key); it != target.handles.end()) {
+      return it->second;
+    }
+    return pointer{};
+  }
+
+  template <class Key>
+  shard& get_shard(const Key& key) noexcept {
+    return m_shards[get_shard_index(key)];
+  }
+
+  template <class Key>
+  const shard& get_shard(const Key& key) const noexcept {
+    return m_shards[get_shard_index(key)];
+  }
+
+  template <class Key>
+  static size_t get_shard_index(const Key& key) noexcept {
+    const size_t hash_value{hash_int(hash<Key>{}(key))};
+    return (hash_value >> (sizeof(size_t) * CHAR_BIT / 2)) & (ShardCount - 1);
+  }
+
+ private:
+  shard m_shards[ShardCount];
+  size_t m_max_names_per_shard;
+  atomic<uint64_t> m_invalidations{0};
+};
+}  // namespace ktl::mf
@@ -0,0 +1,192 @@
+#pragma once
+// With " " instead of <> there is no need to add modules/ to include path
+#include "../lockfree/bounded_queue.hpp"
+
+#include <atomic.hpp>
+#include <basic_types.hpp>
+#include <type_traits.hpp>
+#include <utility.hpp>
+
+namespace ktl::mf {
+/**
+ * @struct offload_stats
+ * @brief Counters accumulated since the pipeline creation
+ */
+struct offload_stats {
+  uint64_t queued;       //!< Items handled by the workers
+  uint64_t synchronous;  //!< Items handled by the submitter
+  uint64_t batches;      //!< Handler calls made by the workers
+};
+
+/**
+ * @class offload_pipeline
+ * @brief Moves items to the worker threads through a bounded lock-free queue
+ * @details The queue is preallocated, so submitting an item never allocates.
+ * Up to max_workers workers are scheduled with Scheduler::schedule(routine,
+ * context); each of them drains the queue in batches of up to BatchSize items
+ * passed to Handler::operator()(Ty* items, size_t count) and exits when the
+ * queue is empty. If the queue is full, submit() handles the item in the
+ * caller's context, throttling the producers instead of growing the backlog.
+ * The same happens if no worker is running and the scheduler can't start one:
+ * the item isn't queued, so the submitter never runs the workers' code path.
+ * The pipeline must outlive all of the scheduled workers: call
+ * wait_for_workers() before destroying it.
+ */
+template <class Ty,
+          class Handler,
+          class Scheduler,
+          size_t Capacity = 256,
+          size_t BatchSize = 16>
+class offload_pipeline : non_relocatable {
+ public:
+  using value_type = Ty;
+  using handler_type = Handler;
+  using scheduler_type = Scheduler;
+
+ public:
+  offload_pipeline(Handler handler,
+                   Scheduler scheduler,
+                   uint32_t max_workers = 1) noexcept
+      : m_handler(move(handler)),
+        m_scheduler(move(scheduler)),
+        m_max_workers{max_workers > 0 ? max_workers : 1} {}
+
+  /**
+   * @fn offload_pipeline::try_submit
+   * @brief Queues the item for a worker
+   * @return false if the queue is full or no worker can drain it; the item is
+   * left untouched
+   */
+  bool try_submit(Ty&& item) {
+    ++m_submitting;  // The running workers don't exit until the item is pushed
+    // Pairs with the fence in run_worker(): either the worker sees the
+    // submission or we see that the worker is gone
+    atomic_thread_fence<memory_order_seq_cst>();
+    const bool queued{acquire_worker() && m_queue.try_push(move(item))};
+    --m_submitting;
+    return queued;
+  }
+
+  /**
+   * @fn offload_pipeline::submit
+   * @brief Queues the item or handles it synchronously if it can't be queued
+   * @return true if the item has been queued
+   */
+  bool submit(Ty item) {
+    if (try_submit(move(item))) {
+      return true;
+    }
+    m_synchronous.fetch_add<memory_order_relaxed>(1);
+    m_handler(addressof(item), 1);
+    return false;
+  }
+
+  /**
+   * @fn offload_pipeline::wait_for_workers
+   * @brief Spins until all of the workers exit. No items must be submitted
+   * concurrently
+   */
+  void wait_for_workers() noexcept {
+    while (m_scheduled_workers.load<memory_order_acquire>() != 0) {
+      YieldProcessor();
+    }
+  }
+
+  [[nodiscard]] size_t size_approx() const noexcept {
+    return m_queue.size_approx();
+  }
+
+  [[nodiscard]] uint32_t active_workers() const noexcept {
+    return m_active_workers.load<memory_order_relaxed>();
+  }
+
+  [[nodiscard]] offload_stats stats() const noexcept {
+    return {m_queued.load<memory_order_relaxed>(),
+            m_synchronous.load<memory_order_relaxed>(),
+            m_batches.load<memory_order_relaxed>()};
+  }
+
+  Handler& get_handler() noexcept { return m_handler; }
+  Scheduler& get_scheduler() noexcept { return m_scheduler; }
+
+ private:
+  /*
+   * Starts one more worker if there is a free slot. Returns false if no
+   * worker is running after that
+   */
+  bool acquire_worker() {
+    uint32_t active{m_active_workers.load<memory_order_relaxed>()};
+    while (active < m_max_workers) {
+      if (m_active_workers.compare_exchange_strong(active, active + 1)) {
+        ++m_scheduled_workers;
+        if (m_scheduler.schedule(&worker_routine, this)) {
+          return true;
+        }
+        --m_scheduled_workers;
+        active = --m_active_workers;
+        break;
+      }
+    }
+    return active > 0;
+  }
+
+  static void worker_routine(void* context) {
+    auto* self{static_cast<offload_pipeline*>(context)};
+    self->run_worker();
+    --self->m_scheduled_workers;  // The last access to the pipeline
+  }
+
+  /*
+   * Must be entered with the worker slot acquired, releases it on exit
+   */
+  void run_worker() {
+    Ty batch[BatchSize];
+    for (;;) {
+      for (size_t count = pop_batch(batch); count > 0;
+           count = pop_batch(batch)) {
+        m_handler(batch, count);
+        m_queued.fetch_add<memory_order_relaxed>(count);
+        m_batches.fetch_add<memory_order_relaxed>(1);
+      }
+      --m_active_workers;
+      atomic_thread_fence<memory_order_seq_cst>();
+      while (m_submitting.load<memory_order_acquire>() != 0) {
+        YieldProcessor();  // The submitter may count on this worker
+      }
+      if (m_queue.empty_approx() || !try_reacquire_worker()) {
+        return;
+      }
+    }
+  }
+
+  bool try_reacquire_worker() noexcept {
+    uint32_t active{m_active_workers.load<memory_order_relaxed>()};
+    while (active < m_max_workers) {
+      if (m_active_workers.compare_exchange_strong(active, active + 1)) {
+        return true;
+      }
+    }
+    return false;  // Other workers will handle the rest
+  }
+
+  size_t pop_batch(Ty (&batch)[BatchSize]) {
+    size_t count{0};
+    while (count < BatchSize && m_queue.try_pop(batch[count])) {
+      ++count;
+    }
+    return count;
+  }
+
+ private:
+  lockfree::mpmc_bounded_queue<Ty, Capacity> m_queue;
+  Handler m_handler;
+  Scheduler m_scheduler;
+  const uint32_t m_max_workers;
+  atomic<uint32_t> m_active_workers{0};     // Draining the queue
+  atomic<uint32_t> m_scheduled_workers{0};  // Not returned yet
+  atomic<uint32_t> m_submitting{0};
+  atomic<uint64_t> m_queued{0};
+  atomic<uint64_t> m_synchronous{0};
+  atomic<uint64_t> m_batches{0};
+};
+}  // namespace ktl::mf
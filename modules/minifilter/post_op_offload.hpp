@@ -0,0 +1,224 @@
+#pragma once
+// With " " instead of <> there is no need to add minifilter/ to include path
+#include "offload_pipeline.hpp"
+
+#include <atomic.hpp>
+#include <basic_types.hpp>
+#include <ktlexcept.hpp>
+#include <utility.hpp>
+
+#include <fltkernel.h>
+
+namespace ktl::mf {
+/**
+ * @class flt_work_item_pool
+ * @brief Generic work items allocated once for the filter and reused for
+ * every scheduled routine, so scheduling never allocates and may be done at
+ * IRQL <= DISPATCH_LEVEL
+ * @details An item is returned to the pool right before the routine is called,
+ * hence at most ItemCount routines are running or queued at a time. The pool
+ * must be destroyed after all of them have exited and before the filter is
+ * unregistered.
+ */
+template <size_t ItemCount>
+class flt_work_item_pool : non_relocatable {
+  static_assert(ItemCount >= 2 && (ItemCount & (ItemCount - 1)) == 0,
+                "ItemCount must be a power of 2");
+
+ public:
+  using routine_type = void (*)(void*);
+
+ private:
+  struct slot {
+    flt_work_item_pool* pool;
+    PFLT_GENERIC_WORKITEM item;
+    routine_type routine;
+    void* context;
+  };
+
+ public:
+  explicit flt_work_item_pool(PFLT_FILTER filter) : m_filter{filter} {
+    for (auto& target : m_slots) {
+      target.pool = this;
+      target.item = FltAllocateGenericWorkItem();
+      if (!target.item) {
+        free_items();
+        throw_exception<kernel_error>(STATUS_INSUFFICIENT_RESOURCES,
+                                      "unable to allocate the work item");
+      }
+      m_free_slots.try_push(addressof(target));
+    }
+  }
+
+  ~flt_work_item_pool() noexcept { free_items(); }
+
+  /**
+   * @fn flt_work_item_pool::schedule
+   * @brief Queues the routine to a system worker thread
+   * @return false if all of the items are in use or the filter is being
+   * unloaded
+   */
+  bool schedule(routine_type routine, void* context) noexcept {
+    slot* target;
+    if (!m_free_slots.try_pop(target)) {
+      return false;
+    }
+    target->routine = routine;
+    target->context = context;
+    const NTSTATUS status{FltQueueGenericWorkItem(
+        target->item, m_filter, &run_routine, DelayedWorkQueue, target)};
+    if (!NT_SUCCESS(status)) {
+      m_free_slots.try_push(target);
+      return false;
+    }
+    return true;
+  }
+
+ private:
+  static void FLTAPI run_routine(
+      [[maybe_unused]] PFLT_GENERIC_WORKITEM item,
+      [[maybe_unused]] PVOID filter_object,
+      PVOID context) noexcept {
+    auto* target{static_cast<slot*>(context)};
+    const routine_type routine{target->routine};
+    void* routine_context{target->context};
+    // Released beforehand since the routine may be the last user of the pool
+    target->pool->m_free_slots.try_push(target);
+    routine(routine_context);
+  }
+
+  void free_items() noexcept {
+    for (auto& target : m_slots) {
+      if (target.item) {
+        FltFreeGenericWorkItem(target.item);
+        target.item = nullptr;
+      }
+    }
+  }
+
+ private:
+  PFLT_FILTER m_filter;
+  slot m_slots[ItemCount]{};
+  lockfree::mpmc_bounded_queue<slot*, ItemCount> m_free_slots;
+};
+
+/**
+ * @struct post_op_item
+ * @brief Post-operation callback parameters saved for the deferred processing.
+ * FLT_RELATED_OBJECTS is valid only during the callback, so the objects are
+ * copied out of it
+ */
+struct post_op_item {
+  PFLT_CALLBACK_DATA data;
+  PFLT_INSTANCE instance;
+  PFILE_OBJECT file_object;
+  void* completion_context;
+};
+
+/**
+ * @class post_op_offload
+ * @brief Completes the post-operation callbacks on the worker threads
+ * @details post_operation() pends the operation and queues it to the
+ * offload_pipeline, so the I/O path doesn't wait for the processing. Workers
+ * call Handler::operator()(post_op_item&, bool deferred) at PASSIVE_LEVEL and
+ * complete the operations with FltCompletePendedPostOperation(). Draining
+ * instances, fast I/O and the operations arriving when the queue is full or
+ * no work item can be queued are handled in the callback's context with
+ * deferred == false, so the handler must tolerate the IRQL of the callback in
+ * that case.
+ */
+template <class Handler,
+          size_t MaxWorkers = 4,
+          size_t Capacity = 256,
+          size_t BatchSize = 16>
+class post_op_offload : non_relocatable {
+ public:
+  using handler_type = Handler;
+
+ private:
+  class batch_handler {
+   public:
+    explicit batch_handler(Handler handler) noexcept
+        : m_handler(move(handler)) {}
+
+    void operator()(post_op_item* items, size_t count) {
+      for (size_t idx = 0; idx < count; ++idx) {
+        m_handler(items[idx], true);
+        FltCompletePendedPostOperation(items[idx].data);
+      }
+    }
+
+    Handler& get() noexcept { return m_handler; }
+
+   private:
+    Handler m_handler;
+  };
+
+  struct pool_scheduler {
+    bool schedule(void (*routine)(void*), void* context) noexcept {
+      return pool->schedule(routine, context);
+    }
+
+    flt_work_item_pool<MaxWorkers>* pool;
+  };
+
+  using pipeline_type = offload_pipeline<post_op_item,
+                                         batch_handler,
+                                         pool_scheduler,
+                                         Capacity,
+                                         BatchSize>;
+
+ public:
+  /**
+   * @fn post_op_offload::post_op_offload
+   * @param[in] filter Filter returned by FltRegisterFilter()
+   * @param[in] handler Callable processing the operations
+   * @throw kernel_error if the work items can't be allocated
+   */
+  post_op_offload(PFLT_FILTER filter, Handler handler)
+      : m_pool{filter},
+        m_pipeline{batch_handler{move(handler)},
+                   pool_scheduler{addressof(m_pool)},
+                   static_cast<uint32_t>(MaxWorkers)} {}
+
+  ~post_op_offload() noexcept { m_pipeline.wait_for_workers(); }
+
+  /**
+   * @fn post_op_offload::post_operation
+   * @brief Should be called from (or used as) the post-operation callback
+   */
+  FLT_POSTOP_CALLBACK_STATUS post_operation(
+      PFLT_CALLBACK_DATA data,
+      PCFLT_RELATED_OBJECTS objects,
+      PVOID completion_context,
+      FLT_POST_OPERATION_FLAGS flags) {
+    post_op_item item{data, objects->Instance, objects->FileObject,
+                      completion_context};
+    if (!FlagOn(flags, FLTFL_POST_OPERATION_DRAINING) &&
+        FLT_IS_IRP_OPERATION(data) && m_pipeline.try_submit(move(item))) {
+      return FLT_POSTOP_MORE_PROCESSING_REQUIRED;
+    }
+    m_synchronous.fetch_add<memory_order_relaxed>(1);
+    m_pipeline.get_handler().get()(item, false);
+    return FLT_POSTOP_FINISHED_PROCESSING;
+  }
+
+  /**
+   * @fn post_op_offload::wait_for_workers
+   * @brief Waits for the pended operations to complete. Should be called
+   * on the filter unloading when no more operations arrive
+   */
+  void wait_for_workers() noexcept { m_pipeline.wait_for_workers(); }
+
+  [[nodiscard]] offload_stats stats() const noexcept {
+    auto result{m_pipeline.stats()};
+    result.synchronous += m_synchronous.load<memory_order_relaxed>();
+    return result;
+  }
+
+ private:
+  flt_work_item_pool<MaxWorkers> m_pool;  // Outlives the pipeline
+  pipeline_type m_pipeline;
+  atomic<uint64_t> m_synchronous{0};
+};
+}  // namespace ktl::mf
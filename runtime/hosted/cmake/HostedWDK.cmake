@@ -0,0 +1,60 @@
+# Redistribution and use is allowed under the MIT license.
+# Copyright (c) 2021 Dmitry Bolshakov. All rights reserved.
+
+# Replacements of the FindWDK functions building the libraries and the drivers
+# as user-mode code. The hosted platform layer (see runtime/hosted) is linked
+# through basic_runtime_interface
+
+set(KTL_HOSTED_PLATFORM_LIB ktl_hosted)
+set(KTL_HOSTED_DRIVER_MAIN "${CMAKE_CURRENT_LIST_DIR}/../src/driver_main.cpp")
+
+set(THREADS_PREFER_PTHREAD_FLAG ON)
+find_package(Threads REQUIRED)
+
+macro(KTL_HOSTED_PARSE_ARGUMENTS)
+	cmake_parse_arguments(
+		WDK
+			"EXTENDED_CPP_FEATURES"
+			"WINVER;KMDF;CUSTOM_ENTRY_POINT"
+			""
+			${ARGN}
+	)
+	if (NOT DEFINED WDK_WINVER)
+		set(WDK_WINVER 0x602)
+	endif()
+endmacro()
+
+function(ktl_hosted_configure_target target_name)
+	target_compile_definitions(
+		${target_name} PRIVATE
+			WINVER=${WDK_WINVER}
+			_WIN32_WINNT=${WDK_WINVER}
+	)
+endfunction()
+
+function(wdk_add_library target_name)
+	KTL_HOSTED_PARSE_ARGUMENTS(${ARGN})
+	add_library(${target_name} ${WDK_UNPARSED_ARGUMENTS})
+	ktl_hosted_configure_target(${target_name})
+endfunction()
+
+function(wdk_add_driver target_name)
+	KTL_HOSTED_PARSE_ARGUMENTS(${ARGN})
+	if (NOT DEFINED WDK_CUSTOM_ENTRY_POINT)
+		set(WDK_CUSTOM_ENTRY_POINT DriverEntry)
+	endif()
+	add_executable(
+		${target_name}
+			${WDK_UNPARSED_ARGUMENTS}
+			${KTL_HOSTED_DRIVER_MAIN}
+	)
+	ktl_hosted_configure_target(${target_name})
+	target_compile_definitions(
+		${target_name} PRIVATE
+			KTL_HOSTED_ENTRY_POINT=${WDK_CUSTOM_ENTRY_POINT}
+	)
+endfunction()
+
+function(wdk_sign_driver)
+	# User-mode executables aren't signed
+endfunction()
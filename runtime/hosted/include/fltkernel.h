@@ -0,0 +1,198 @@
+#pragma once
+/*
+ * The filter manager interface used by KTL. There is no filter manager in the
+ * user mode, so the filters can't be registered and the callbacks are never
+ * invoked: the modules are tested with the fake backends. The generic work
+ * items run on the system worker threads of the hosted layer
+ */
+#include <ntifs.h>
+
+#define FLTAPI
+
+typedef struct _FLT_FILTER* PFLT_FILTER;
+typedef struct _FLT_INSTANCE* PFLT_INSTANCE;
+typedef struct _FLT_VOLUME* PFLT_VOLUME;
+typedef struct _FLT_GENERIC_WORKITEM* PFLT_GENERIC_WORKITEM;
+typedef PVOID PFLT_CONTEXT;
+
+typedef ULONG FLT_FILTER_UNLOAD_FLAGS;
+typedef ULONG FLT_POST_OPERATION_FLAGS;
+typedef ULONG FLT_FILE_NAME_OPTIONS;
+
+#define FLTFL_FILTER_UNLOAD_MANDATORY 0x00000001
+#define FLTFL_POST_OPERATION_DRAINING 0x00000001
+
+#define FLT_FILE_NAME_NORMALIZED 0x01
+#define FLT_FILE_NAME_OPENED 0x02
+#define FLT_FILE_NAME_SHORT 0x03
+#define FLT_FILE_NAME_QUERY_DEFAULT 0x0100
+
+#define FLTFL_CALLBACK_DATA_IRP_OPERATION 0x00000001
+#define FLTFL_CALLBACK_DATA_FAST_IO_OPERATION 0x00000002
+#define FLT_IS_IRP_OPERATION(data) \
+  FlagOn((data)->Flags, FLTFL_CALLBACK_DATA_IRP_OPERATION)
+
+#define FLT_REGISTRATION_VERSION 0x0203
+
+typedef enum _FLT_PREOP_CALLBACK_STATUS {
+  FLT_PREOP_SUCCESS_WITH_CALLBACK,
+  FLT_PREOP_SUCCESS_NO_CALLBACK,
+  FLT_PREOP_PENDING,
+  FLT_PREOP_DISALLOW_FASTIO,
+  FLT_PREOP_COMPLETE,
+  FLT_PREOP_SYNCHRONIZE,
+} FLT_PREOP_CALLBACK_STATUS;
+
+typedef enum _FLT_POSTOP_CALLBACK_STATUS {
+  FLT_POSTOP_FINISHED_PROCESSING,
+  FLT_POSTOP_MORE_PROCESSING_REQUIRED,
+} FLT_POSTOP_CALLBACK_STATUS;
+
+typedef union _FLT_PARAMETERS {
+  struct {
+    PVOID SecurityContext;
+    ULONG Options;
+    USHORT FileAttributes;
+    USHORT ShareAccess;
+    ULONG EaLength;
+    PVOID EaBuffer;
+    LARGE_INTEGER AllocationSize;
+  } Create;
+  struct {
+    ULONG Length;
+    FILE_INFORMATION_CLASS FileInformationClass;
+    PFILE_OBJECT ParentOfTarget;
+    PVOID InfoBuffer;
+  } SetFileInformation;
+  struct {
+    ULONG Length;
+    ULONG Key;
+    LARGE_INTEGER ByteOffset;
+    PVOID ReadBuffer;
+    PMDL MdlAddress;
+  } Read;
+  struct {
+    ULONG Length;
+    ULONG Key;
+    LARGE_INTEGER ByteOffset;
+    PVOID WriteBuffer;
+    PMDL MdlAddress;
+  } Write;
+} FLT_PARAMETERS, *PFLT_PARAMETERS;
+
+typedef struct _FLT_IO_PARAMETER_BLOCK {
+  ULONG IrpFlags;
+  UCHAR MajorFunction;
+  UCHAR MinorFunction;
+  UCHAR OperationFlags;
+  UCHAR Reserved;
+  PFILE_OBJECT TargetFileObject;
+  PFLT_INSTANCE TargetInstance;
+  FLT_PARAMETERS Parameters;
+} FLT_IO_PARAMETER_BLOCK, *PFLT_IO_PARAMETER_BLOCK;
+
+typedef struct _FLT_CALLBACK_DATA {
+  ULONG Flags;
+  PETHREAD Thread;
+  PFLT_IO_PARAMETER_BLOCK Iopb;
+  IO_STATUS_BLOCK IoStatus;
+  KPROCESSOR_MODE RequestorMode;
+} FLT_CALLBACK_DATA, *PFLT_CALLBACK_DATA;
+
+typedef struct _FLT_RELATED_OBJECTS {
+  USHORT Size;
+  USHORT TransactionContext;
+  PFLT_FILTER Filter;
+  PFLT_VOLUME Volume;
+  PFLT_INSTANCE Instance;
+  PFILE_OBJECT FileObject;
+  PVOID Transaction;
+} FLT_RELATED_OBJECTS, *PFLT_RELATED_OBJECTS;
+typedef const FLT_RELATED_OBJECTS* PCFLT_RELATED_OBJECTS;
+
+typedef struct _FLT_FILE_NAME_INFORMATION {
+  USHORT Size;
+  USHORT NamesParsed;
+  FLT_FILE_NAME_OPTIONS Format;
+  UNICODE_STRING Name;
+  UNICODE_STRING Volume;
+  UNICODE_STRING Share;
+  UNICODE_STRING Extension;
+  UNICODE_STRING Stream;
+  UNICODE_STRING FinalComponent;
+  UNICODE_STRING ParentDir;
+} FLT_FILE_NAME_INFORMATION, *PFLT_FILE_NAME_INFORMATION;
+
+typedef FLT_PREOP_CALLBACK_STATUS (*PFLT_PRE_OPERATION_CALLBACK)(
+    PFLT_CALLBACK_DATA data,
+    PCFLT_RELATED_OBJECTS objects,
+    PVOID* completion_context);
+typedef FLT_POSTOP_CALLBACK_STATUS (*PFLT_POST_OPERATION_CALLBACK)(
+    PFLT_CALLBACK_DATA data,
+    PCFLT_RELATED_OBJECTS objects,
+    PVOID completion_context,
+    FLT_POST_OPERATION_FLAGS flags);
+typedef NTSTATUS (*PFLT_FILTER_UNLOAD_CALLBACK)(FLT_FILTER_UNLOAD_FLAGS flags);
+typedef VOID (*PFLT_GENERIC_WORKITEM_ROUTINE)(PFLT_GENERIC_WORKITEM item,
+                                              PVOID filter_object,
+                                              PVOID context);
+
+typedef struct _FLT_OPERATION_REGISTRATION {
+  UCHAR MajorFunction;
+  ULONG Flags;
+  PFLT_PRE_OPERATION_CALLBACK PreOperation;
+  PFLT_POST_OPERATION_CALLBACK PostOperation;
+  PVOID Reserved1;
+} FLT_OPERATION_REGISTRATION, *PFLT_OPERATION_REGISTRATION;
+
+typedef struct _FLT_REGISTRATION {
+  USHORT Size;
+  USHORT Version;
+  ULONG Flags;
+  const PVOID ContextRegistration;
+  const FLT_OPERATION_REGISTRATION* OperationRegistration;
+  PFLT_FILTER_UNLOAD_CALLBACK FilterUnloadCallback;
+  PVOID InstanceSetupCallback;
+  PVOID InstanceQueryTeardownCallback;
+  PVOID InstanceTeardownStartCallback;
+  PVOID InstanceTeardownCompleteCallback;
+  PVOID GenerateFileNameCallback;
+  PVOID NormalizeNameComponentCallback;
+  PVOID NormalizeContextCleanupCallback;
+  PVOID TransactionNotificationCallback;
+  PVOID NormalizeNameComponentExCallback;
+  PVOID SectionNotificationCallback;
+} FLT_REGISTRATION, *PFLT_REGISTRATION;
+
+extern "C" {
+NTSTATUS FltRegisterFilter(PDRIVER_OBJECT driver,
+                           const FLT_REGISTRATION* registration,
+                           PFLT_FILTER* filter);
+NTSTATUS FltStartFiltering(PFLT_FILTER filter);
+VOID FltUnregisterFilter(PFLT_FILTER filter);
+
+NTSTATUS FltGetFileNameInformation(PFLT_CALLBACK_DATA data,
+                                   FLT_FILE_NAME_OPTIONS name_options,
+                                   PFLT_FILE_NAME_INFORMATION* file_name_info);
+NTSTATUS FltParseFileNameInformation(
+    PFLT_FILE_NAME_INFORMATION file_name_info);
+VOID FltReleaseFileNameInformation(PFLT_FILE_NAME_INFORMATION file_name_info);
+NTSTATUS FltIsDirectory(PFILE_OBJECT file_object,
+                        PFLT_INSTANCE instance,
+                        PBOOLEAN is_directory);
+NTSTATUS FltQueryInformationFile(PFLT_INSTANCE instance,
+                                 PFILE_OBJECT file_object,
+                                 PVOID file_information,
+                                 ULONG length,
+                                 FILE_INFORMATION_CLASS file_information_class,
+                                 PULONG length_returned);
+
+PFLT_GENERIC_WORKITEM FltAllocateGenericWorkItem();
+VOID FltFreeGenericWorkItem(PFLT_GENERIC_WORKITEM item);
+NTSTATUS FltQueueGenericWorkItem(PFLT_GENERIC_WORKITEM item,
+                                 PVOID filter_object,
+                                 PFLT_GENERIC_WORKITEM_ROUTINE routine,
+                                 WORK_QUEUE_TYPE queue_type,
+                                 PVOID context);
+VOID FltCompletePendedPostOperation(PFLT_CALLBACK_DATA data);
+}  // extern "C"
@@ -0,0 +1,159 @@
+#pragma once
+/*
+ * The MSVC intrinsics used by KTL, built on the GCC and Clang builtins.
+ * Windows is LLP64, so the intrinsics taking long operate on the 32-bit
+ * values and take int here. The SIMD intrinsics come from <immintrin.h> as in
+ * MSVC, the functions using them must enable the instruction set extensions
+ * with the target attribute (see TARGET_ISA)
+ */
+#include <immintrin.h>
+#include <string.h>
+
+extern "C" {
+inline unsigned char _BitScanForward(unsigned long* index,
+                                     unsigned long mask) {
+  const auto value{static_cast<unsigned int>(mask)};
+  if (!value) {
+    return 0;
+  }
+  *index = static_cast<unsigned long>(__builtin_ctz(value));
+  return 1;
+}
+
+inline unsigned char _BitScanReverse(unsigned long* index,
+                                     unsigned long mask) {
+  const auto value{static_cast<unsigned int>(mask)};
+  if (!value) {
+    return 0;
+  }
+  *index = static_cast<unsigned long>(31 - __builtin_clz(value));
+  return 1;
+}
+
+inline unsigned char _BitScanForward64(unsigned long* index,
+                                       unsigned long long mask) {
+  if (!mask) {
+    return 0;
+  }
+  *index = static_cast<unsigned long>(__builtin_ctzll(mask));
+  return 1;
+}
+
+inline unsigned char _BitScanReverse64(unsigned long* index,
+                                       unsigned long long mask) {
+  if (!mask) {
+    return 0;
+  }
+  *index = static_cast<unsigned long>(63 - __builtin_clzll(mask));
+  return 1;
+}
+
+inline void __cpuidex(int cpu_info[4], int function_id, int subfunction_id) {
+  __asm__ __volatile__("cpuid"
+                       : "=a"(cpu_info[0]), "=b"(cpu_info[1]),
+                         "=c"(cpu_info[2]), "=d"(cpu_info[3])
+                       : "a"(function_id), "c"(subfunction_id));
+}
+
+inline void __cpuid(int cpu_info[4], int function_id) {
+  __cpuidex(cpu_info, function_id, 0);
+}
+
+// GCC provides _xgetbv only for the functions targeting XSAVE
+#define _xgetbv hosted_xgetbv
+
+inline unsigned long long hosted_xgetbv(unsigned int xcr) {
+  unsigned int eax;
+  unsigned int edx;
+  __asm__ __volatile__("xgetbv" : "=a"(eax), "=d"(edx) : "c"(xcr));
+  return (static_cast<unsigned long long>(edx) << 32) | eax;
+}
+
+inline unsigned long long __umulh(unsigned long long lhs,
+                                  unsigned long long rhs) {
+  return static_cast<unsigned long long>(
+      (static_cast<unsigned __int128>(lhs) * rhs) >> 64);
+}
+
+inline unsigned long long _umul128(unsigned long long lhs,
+                                   unsigned long long rhs,
+                                   unsigned long long* high) {
+  const auto product{static_cast<unsigned __int128>(lhs) * rhs};
+  *high = static_cast<unsigned long long>(product >> 64);
+  return static_cast<unsigned long long>(product);
+}
+
+inline void _ReadWriteBarrier() {
+  __atomic_signal_fence(__ATOMIC_SEQ_CST);
+}
+
+inline void __faststorefence() {
+  __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+}  // extern "C"
+
+// Interlocked operations are full barriers
+#define KTL_HOSTED_DEFINE_INTERLOCKED(type, suffix)                     \
+  extern "C" inline type _InterlockedExchange##suffix(                  \
+      volatile type* target, type value) {                              \
+    return __atomic_exchange_n(target, value, __ATOMIC_SEQ_CST);        \
+  }                                                                     \
+  extern "C" inline type _InterlockedCompareExchange##suffix(           \
+      volatile type* target, type desired, type expected) {             \
+    __atomic_compare_exchange_n(target, &expected, desired, false,      \
+                                __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);    \
+    return expected;                                                    \
+  }                                                                     \
+  extern "C" inline type _InterlockedExchangeAdd##suffix(               \
+      volatile type* target, type value) {                              \
+    return __atomic_fetch_add(target, value, __ATOMIC_SEQ_CST);         \
+  }                                                                     \
+  extern "C" inline type _InterlockedAnd##suffix(volatile type* target, \
+                                                 type value) {          \
+    return __atomic_fetch_and(target, value, __ATOMIC_SEQ_CST);         \
+  }                                                                     \
+  extern "C" inline type _InterlockedOr##suffix(volatile type* target,  \
+                                                type value) {           \
+    return __atomic_fetch_or(target, value, __ATOMIC_SEQ_CST);          \
+  }                                                                     \
+  extern "C" inline type _InterlockedXor##suffix(volatile type* target, \
+                                                 type value) {          \
+    return __atomic_fetch_xor(target, value, __ATOMIC_SEQ_CST);         \
+  }
+
+KTL_HOSTED_DEFINE_INTERLOCKED(char, 8)
+KTL_HOSTED_DEFINE_INTERLOCKED(short, 16)
+KTL_HOSTED_DEFINE_INTERLOCKED(int, )
+KTL_HOSTED_DEFINE_INTERLOCKED(long long, 64)
+
+#undef KTL_HOSTED_DEFINE_INTERLOCKED
+
+#define KTL_HOSTED_DEFINE_INTERLOCKED_INCREMENT(type, suffix)            \
+  extern "C" inline type _InterlockedIncrement##suffix(                  \
+      volatile type* target) {                                           \
+    return __atomic_add_fetch(target, 1, __ATOMIC_SEQ_CST);              \
+  }                                                                      \
+  extern "C" inline type _InterlockedDecrement##suffix(                  \
+      volatile type* target) {                                           \
+    return __atomic_sub_fetch(target, 1, __ATOMIC_SEQ_CST);              \
+  }
+
+KTL_HOSTED_DEFINE_INTERLOCKED_INCREMENT(short, 16)
+KTL_HOSTED_DEFINE_INTERLOCKED_INCREMENT(int, )
+KTL_HOSTED_DEFINE_INTERLOCKED_INCREMENT(long long, 64)
+
+#undef KTL_HOSTED_DEFINE_INTERLOCKED_INCREMENT
+
+extern "C" inline void* _InterlockedExchangePointer(void* volatile* target,
+                                                    void* value) {
+  return __atomic_exchange_n(target, value, __ATOMIC_SEQ_CST);
+}
+
+extern "C" inline void* _InterlockedCompareExchangePointer(
+    void* volatile* target,
+    void* desired,
+    void* expected) {
+  __atomic_compare_exchange_n(target, &expected, desired, false,
+                              __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+  return expected;
+}
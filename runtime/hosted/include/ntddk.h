@@ -0,0 +1,1232 @@
+#pragma once
+/*
+ * The subset of the NT kernel API used by KTL, emulated in user mode over the
+ * POSIX primitives. Layouts follow the WDK where KTL touches the fields, the
+ * other members are omitted. The routines are implemented in runtime/hosted/src
+ */
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <wchar.h>
+
+#include <intrin.h>
+
+#if !defined(__x86_64__)
+#error The hosted platform layer supports x86-64 only
+#endif
+
+#define _AMD64_ 1  // NOLINT(bugprone-reserved-identifier)
+
+#define NTAPI
+#define NTSYSAPI
+#define NTKERNELAPI
+#define FASTCALL_NT
+#define FORCEINLINE inline __attribute__((always_inline))
+#define DECLSPEC_ALIGN(x) __attribute__((aligned(x)))
+#define DECLSPEC_NORETURN __attribute__((noreturn))
+#define IN
+#define OUT
+#define OPTIONAL
+#define UNREFERENCED_PARAMETER(P) (void)(P)
+
+#ifndef _WIN32_WINNT_WIN7
+#define _WIN32_WINNT_WIN7 0x0601
+#define _WIN32_WINNT_WIN8 0x0602
+#define _WIN32_WINNT_WINBLUE 0x0603
+#define _WIN32_WINNT_WIN10 0x0A00
+#endif
+
+#ifndef WINVER
+#define WINVER _WIN32_WINNT_WIN8
+#endif
+
+/*
+ * Basic types. LONG and ULONG are 32-bit as on Windows (LLP64), so the code
+ * storing 32-bit values must use them instead of long
+ */
+typedef void VOID, *PVOID;
+typedef const void* PCVOID;
+typedef char CHAR, *PCHAR, *PSTR, CCHAR;
+typedef const char* PCSTR;
+typedef unsigned char UCHAR, *PUCHAR, BOOLEAN, *PBOOLEAN;
+typedef short SHORT, CSHORT;
+typedef unsigned short USHORT, *PUSHORT;
+typedef int32_t LONG, *PLONG;
+typedef uint32_t ULONG, *PULONG, DWORD;
+typedef long long LONG64, LONGLONG, *PLONG64, *PLONGLONG;
+typedef unsigned long long ULONG64, ULONGLONG, DWORD64, *PULONG64, *PULONGLONG;
+typedef intptr_t LONG_PTR;
+typedef uintptr_t ULONG_PTR, *PULONG_PTR, KSPIN_LOCK, *PKSPIN_LOCK;
+typedef size_t SIZE_T, *PSIZE_T;
+typedef wchar_t WCHAR, *PWCH, *PWCHAR, *PWSTR;
+typedef const wchar_t *PCWCH, *PCWSTR;
+typedef void* HANDLE;
+typedef HANDLE* PHANDLE;
+typedef LONG NTSTATUS;
+typedef ULONG ACCESS_MASK;
+typedef UCHAR KIRQL, *PKIRQL;
+typedef LONG KPRIORITY;
+typedef ULONG_PTR KAFFINITY, *PKAFFINITY;
+typedef CCHAR KPROCESSOR_MODE;
+typedef long long __time64_t;  // From the MSVC CRT
+
+#ifndef FALSE
+#define FALSE 0
+#define TRUE 1
+#endif
+
+#define MAXUCHAR 0xFF
+#define MAXUSHORT 0xFFFF
+#define MAXULONG 0xFFFFFFFF
+#define MAXLONGLONG 0x7FFFFFFFFFFFFFFFLL
+
+#define ARRAYSIZE(arr) (sizeof(arr) / sizeof((arr)[0]))
+#define FlagOn(flags, bit) ((flags) & (bit))
+#define CONTAINING_RECORD(address, type, field) \
+  ((type*)((PCHAR)(address) - offsetof(type, field)))
+
+#define HandleToUlong(h) ((ULONG)(ULONG_PTR)(h))
+#define UlongToHandle(ul) ((HANDLE)(ULONG_PTR)(ul))
+
+typedef union _LARGE_INTEGER {
+  struct {
+    ULONG LowPart;
+    LONG HighPart;
+  };
+  struct {
+    ULONG LowPart;
+    LONG HighPart;
+  } u;
+  LONGLONG QuadPart;
+} LARGE_INTEGER, *PLARGE_INTEGER;
+
+typedef union _ULARGE_INTEGER {
+  struct {
+    ULONG LowPart;
+    ULONG HighPart;
+  };
+  ULONGLONG QuadPart;
+} ULARGE_INTEGER, *PULARGE_INTEGER;
+
+typedef struct _UNICODE_STRING {
+  USHORT Length;         // In bytes, without the terminating null
+  USHORT MaximumLength;  // In bytes
+  PWCH Buffer;
+} UNICODE_STRING, *PUNICODE_STRING;
+typedef const UNICODE_STRING* PCUNICODE_STRING;
+
+typedef struct _STRING {
+  USHORT Length;
+  USHORT MaximumLength;
+  PCHAR Buffer;
+} STRING, ANSI_STRING, *PANSI_STRING, OEM_STRING;
+typedef const ANSI_STRING* PCANSI_STRING;
+
+typedef struct _LIST_ENTRY {
+  struct _LIST_ENTRY* Flink;
+  struct _LIST_ENTRY* Blink;
+} LIST_ENTRY, *PLIST_ENTRY;
+
+typedef struct DECLSPEC_ALIGN(16) _SLIST_ENTRY {
+  struct _SLIST_ENTRY* Next;
+} SLIST_ENTRY, *PSLIST_ENTRY;
+
+typedef union DECLSPEC_ALIGN(16) _SLIST_HEADER {
+  struct {
+    PSLIST_ENTRY Next;
+    volatile LONG Lock;
+    USHORT Depth;
+  } HeaderX64;
+  ULONGLONG Alignment[2];
+} SLIST_HEADER, *PSLIST_HEADER;
+
+/*
+ * Structured exception handling. The hardware exceptions terminate the
+ * process in the user mode, so the handlers never run
+ */
+#define EXCEPTION_EXECUTE_HANDLER 1
+#define EXCEPTION_CONTINUE_SEARCH 0
+#define EXCEPTION_CONTINUE_EXECUTION (-1)
+
+#define __try if (true)
+#define __except(filter) else if ((void)(filter), false)
+#define GetExceptionCode() STATUS_UNHANDLED_EXCEPTION
+
+/*
+ * Status codes
+ */
+#define NT_SUCCESS(status) (((NTSTATUS)(status)) >= 0)
+
+#define STATUS_SUCCESS ((NTSTATUS)0x00000000L)
+#define STATUS_WAIT_0 ((NTSTATUS)0x00000000L)
+#define STATUS_ABANDONED_WAIT_0 ((NTSTATUS)0x00000080L)
+#define STATUS_USER_APC ((NTSTATUS)0x000000C0L)
+#define STATUS_ALERTED ((NTSTATUS)0x00000101L)
+#define STATUS_TIMEOUT ((NTSTATUS)0x00000102L)
+#define STATUS_PENDING ((NTSTATUS)0x00000103L)
+#define STATUS_MORE_PROCESSING_REQUIRED ((NTSTATUS)0xC0000016L)
+#define STATUS_BUFFER_OVERFLOW ((NTSTATUS)0x80000005L)
+#define STATUS_UNSUCCESSFUL ((NTSTATUS)0xC0000001L)
+#define STATUS_NOT_IMPLEMENTED ((NTSTATUS)0xC0000002L)
+#define STATUS_INVALID_INFO_CLASS ((NTSTATUS)0xC0000003L)
+#define STATUS_INFO_LENGTH_MISMATCH ((NTSTATUS)0xC0000004L)
+#define STATUS_INVALID_HANDLE ((NTSTATUS)0xC0000008L)
+#define STATUS_INVALID_PARAMETER ((NTSTATUS)0xC000000DL)
+#define STATUS_NO_SUCH_FILE ((NTSTATUS)0xC000000FL)
+#define STATUS_END_OF_FILE ((NTSTATUS)0xC0000011L)
+#define STATUS_NO_MEMORY ((NTSTATUS)0xC0000017L)
+#define STATUS_NOT_MAPPED_VIEW ((NTSTATUS)0xC0000019L)
+#define STATUS_ACCESS_DENIED ((NTSTATUS)0xC0000022L)
+#define STATUS_BUFFER_TOO_SMALL ((NTSTATUS)0xC0000023L)
+#define STATUS_OBJECT_TYPE_MISMATCH ((NTSTATUS)0xC0000024L)
+#define STATUS_OBJECT_NAME_INVALID ((NTSTATUS)0xC0000033L)
+#define STATUS_OBJECT_NAME_NOT_FOUND ((NTSTATUS)0xC0000034L)
+#define STATUS_OBJECT_NAME_COLLISION ((NTSTATUS)0xC0000035L)
+#define STATUS_OBJECT_PATH_NOT_FOUND ((NTSTATUS)0xC000003AL)
+#define STATUS_SHARING_VIOLATION ((NTSTATUS)0xC0000043L)
+#define STATUS_SEMAPHORE_LIMIT_EXCEEDED ((NTSTATUS)0xC0000047L)
+#define STATUS_MUTANT_NOT_OWNED ((NTSTATUS)0xC0000046L)
+#define STATUS_IN_PAGE_ERROR ((NTSTATUS)0xC0000006L)
+#define STATUS_INSUFFICIENT_RESOURCES ((NTSTATUS)0xC000009AL)
+#define STATUS_ARRAY_BOUNDS_EXCEEDED ((NTSTATUS)0xC000008CL)
+#define STATUS_DISK_FULL ((NTSTATUS)0xC000007FL)
+#define STATUS_FILE_IS_A_DIRECTORY ((NTSTATUS)0xC00000BAL)
+#define STATUS_NOT_SUPPORTED ((NTSTATUS)0xC00000BBL)
+#define STATUS_INVALID_DEVICE_REQUEST ((NTSTATUS)0xC0000010L)
+#define STATUS_CANCELLED ((NTSTATUS)0xC0000120L)
+#define STATUS_MAPPED_FILE_SIZE_ZERO ((NTSTATUS)0xC000011EL)
+#define STATUS_UNHANDLED_EXCEPTION ((NTSTATUS)0xC0000144L)
+#define STATUS_BAD_DESCRIPTOR_FORMAT ((NTSTATUS)0xC00000E7L)
+#define STATUS_INVALID_THREAD ((NTSTATUS)0xC000071CL)
+#define STATUS_RANGE_NOT_FOUND ((NTSTATUS)0xC000028CL)
+#define STATUS_NOT_FOUND ((NTSTATUS)0xC0000225L)
+
+/*
+ * IRQL
+ */
+#define PASSIVE_LEVEL 0
+#define LOW_LEVEL 0
+#define APC_LEVEL 1
+#define DISPATCH_LEVEL 2
+#define CMCI_LEVEL 5
+#define CLOCK_LEVEL 13
+#define IPI_LEVEL 14
+#define DRS_LEVEL 14
+#define POWER_LEVEL 14
+#define PROFILE_LEVEL 15
+#define HIGH_LEVEL 15
+
+#define IRQL_NOT_LESS_OR_EQUAL 0x0000000A
+#define KMODE_EXCEPTION_NOT_HANDLED 0x0000001E
+
+#define PAGE_SIZE 0x1000
+#define PAGE_SHIFT 12L
+#define SYSTEM_CACHE_ALIGNMENT_SIZE 64
+#define MEMORY_ALLOCATION_ALIGNMENT 16
+#define PAGE_ALIGN(va) ((PVOID)((ULONG_PTR)(va) & ~(PAGE_SIZE - 1)))
+#define BYTE_OFFSET(va) ((ULONG)((LONG_PTR)(va) & (PAGE_SIZE - 1)))
+#define ROUND_TO_PAGES(size) \
+  (((ULONG_PTR)(size) + PAGE_SIZE - 1) & ~(PAGE_SIZE - 1))
+
+typedef enum _MODE { KernelMode, UserMode, MaximumMode } MODE;
+
+typedef enum _KWAIT_REASON {
+  Executive,
+  FreePage,
+  PageIn,
+  PoolAllocation,
+  DelayExecution,
+  Suspended,
+  UserRequest,
+  WrExecutive,
+} KWAIT_REASON;
+
+typedef enum _WAIT_TYPE { WaitAll, WaitAny } WAIT_TYPE;
+
+typedef enum _EVENT_TYPE { NotificationEvent, SynchronizationEvent } EVENT_TYPE;
+
+#define LOW_PRIORITY 0
+#define LOW_REALTIME_PRIORITY 16
+#define HIGH_PRIORITY 31
+#define MAXIMUM_PRIORITY 32
+
+#define IO_NO_INCREMENT 0
+#define EVENT_INCREMENT 1
+#define SEMAPHORE_INCREMENT 1
+#define MUTANT_INCREMENT 1
+
+#define THREAD_WAIT_OBJECTS 3
+#define MAXIMUM_WAIT_OBJECTS 64
+
+/*
+ * Access rights and object attributes
+ */
+#define DELETE 0x00010000L
+#define READ_CONTROL 0x00020000L
+#define SYNCHRONIZE 0x00100000L
+#define STANDARD_RIGHTS_REQUIRED 0x000F0000L
+#define GENERIC_READ 0x80000000L
+#define GENERIC_WRITE 0x40000000L
+#define GENERIC_ALL 0x10000000L
+
+#define THREAD_ALL_ACCESS (STANDARD_RIGHTS_REQUIRED | SYNCHRONIZE | 0xFFFF)
+#define EVENT_QUERY_STATE 0x0001
+#define EVENT_MODIFY_STATE 0x0002
+#define EVENT_ALL_ACCESS (STANDARD_RIGHTS_REQUIRED | SYNCHRONIZE | 0x3)
+
+#define OBJ_INHERIT 0x00000002L
+#define OBJ_CASE_INSENSITIVE 0x00000040L
+#define OBJ_KERNEL_HANDLE 0x00000200L
+
+typedef struct _OBJECT_ATTRIBUTES {
+  ULONG Length;
+  HANDLE RootDirectory;
+  PUNICODE_STRING ObjectName;
+  ULONG Attributes;
+  PVOID SecurityDescriptor;
+  PVOID SecurityQualityOfService;
+} OBJECT_ATTRIBUTES, *POBJECT_ATTRIBUTES;
+
+#define InitializeObjectAttributes(p, n, a, r, s) \
+  {                                               \
+    (p)->Length = sizeof(OBJECT_ATTRIBUTES);      \
+    (p)->RootDirectory = r;                       \
+    (p)->Attributes = a;                          \
+    (p)->ObjectName = n;                          \
+    (p)->SecurityDescriptor = s;                  \
+    (p)->SecurityQualityOfService = nullptr;      \
+  }
+
+typedef struct _OBJECT_TYPE* POBJECT_TYPE;
+typedef struct _OBJECT_HANDLE_INFORMATION* POBJECT_HANDLE_INFORMATION;
+
+typedef struct _CLIENT_ID {
+  HANDLE UniqueProcess;
+  HANDLE UniqueThread;
+} CLIENT_ID, *PCLIENT_ID;
+
+/*
+ * Dispatcher objects. SignalState is guarded by the dispatcher lock of the
+ * hosted layer, as in the kernel
+ */
+typedef struct _DISPATCHER_HEADER {
+  UCHAR Type;
+  UCHAR Reserved[3];
+  volatile LONG SignalState;
+  LONG PulseCount;  // Releases the threads waiting at the moment of a pulse
+  LIST_ENTRY WaitListHead;
+} DISPATCHER_HEADER;
+
+typedef struct _KEVENT {
+  DISPATCHER_HEADER Header;
+} KEVENT, *PKEVENT, *PRKEVENT;
+
+typedef struct _KMUTANT {
+  DISPATCHER_HEADER Header;
+  struct _KTHREAD* OwnerThread;
+} KMUTANT, *PKMUTANT, KMUTEX, *PKMUTEX, *PRKMUTEX;
+
+typedef struct _KSEMAPHORE {
+  DISPATCHER_HEADER Header;
+  LONG Limit;
+} KSEMAPHORE, *PKSEMAPHORE, *PRKSEMAPHORE;
+
+typedef struct _KWAIT_BLOCK {
+  PVOID Object;
+} KWAIT_BLOCK, *PKWAIT_BLOCK;
+
+// As in <wdm.h>, which doesn't distinguish the executive thread object
+typedef struct _KTHREAD *PKTHREAD, *PRKTHREAD, *PETHREAD;
+typedef struct _EPROCESS *PEPROCESS;
+
+typedef struct _KLOCK_QUEUE_HANDLE {
+  struct {
+    struct _KSPIN_LOCK_QUEUE* Next;
+    PKSPIN_LOCK Lock;
+  } LockQueue;
+  KIRQL OldIrql;
+} KLOCK_QUEUE_HANDLE, *PKLOCK_QUEUE_HANDLE;
+
+typedef struct _FAST_MUTEX {
+  volatile LONG Count;
+  PKTHREAD Owner;
+  ULONG Contention;
+  KEVENT Event;
+  ULONG OldIrql;
+} FAST_MUTEX, *PFAST_MUTEX;
+
+typedef struct _ERESOURCE {
+  DECLSPEC_ALIGN(8) UCHAR Opaque[96];  // Shared-exclusive lock of the host
+} ERESOURCE, *PERESOURCE;
+
+typedef struct _EX_PUSH_LOCK {
+  volatile ULONG_PTR Value;
+} EX_PUSH_LOCK, *PEX_PUSH_LOCK;
+
+/*
+ * Processors
+ */
+#define ALL_PROCESSOR_GROUPS 0xFFFF
+
+typedef struct _PROCESSOR_NUMBER {
+  USHORT Group;
+  UCHAR Number;
+  UCHAR Reserved;
+} PROCESSOR_NUMBER, *PPROCESSOR_NUMBER;
+
+typedef struct _GROUP_AFFINITY {
+  KAFFINITY Mask;
+  USHORT Group;
+  USHORT Reserved[3];
+} GROUP_AFFINITY, *PGROUP_AFFINITY;
+
+typedef ULONG_PTR (*PKIPI_BROADCAST_WORKER)(ULONG_PTR argument);
+
+/*
+ * Extended processor state
+ */
+#define XSTATE_LEGACY_FLOATING_POINT 0
+#define XSTATE_LEGACY_SSE 1
+#define XSTATE_AVX 2
+#define XSTATE_MASK_LEGACY_FLOATING_POINT (1ULL << XSTATE_LEGACY_FLOATING_POINT)
+#define XSTATE_MASK_LEGACY_SSE (1ULL << XSTATE_LEGACY_SSE)
+#define XSTATE_MASK_LEGACY \
+  (XSTATE_MASK_LEGACY_FLOATING_POINT | XSTATE_MASK_LEGACY_SSE)
+#define XSTATE_MASK_AVX (1ULL << XSTATE_AVX)
+#define XSTATE_MASK_AVX512 ((1ULL << 5) | (1ULL << 6) | (1ULL << 7))
+
+typedef struct _XSTATE_SAVE {
+  ULONG64 Mask;
+  PVOID Reserved[4];
+} XSTATE_SAVE, *PXSTATE_SAVE;
+
+/*
+ * Pool
+ */
+typedef enum _POOL_TYPE {
+  NonPagedPool,
+  NonPagedPoolExecute = NonPagedPool,
+  PagedPool,
+  NonPagedPoolMustSucceed = NonPagedPool + 2,
+  DontUseThisType,
+  NonPagedPoolCacheAligned = NonPagedPool + 4,
+  PagedPoolCacheAligned,
+  NonPagedPoolCacheAlignedMustS = NonPagedPool + 6,
+  MaxPoolType,
+  NonPagedPoolBase = 0,
+  NonPagedPoolBaseMustSucceed = NonPagedPoolBase + 2,
+  NonPagedPoolBaseCacheAligned = NonPagedPoolBase + 4,
+  NonPagedPoolBaseCacheAlignedMustS = NonPagedPoolBase + 6,
+  NonPagedPoolSession = 32,
+  PagedPoolSession = NonPagedPoolSession + 1,
+  NonPagedPoolMustSucceedSession = PagedPoolSession + 1,
+  DontUseThisTypeSession = NonPagedPoolMustSucceedSession + 1,
+  NonPagedPoolCacheAlignedSession = DontUseThisTypeSession + 1,
+  PagedPoolCacheAlignedSession = NonPagedPoolCacheAlignedSession + 1,
+  NonPagedPoolCacheAlignedMustSSession = PagedPoolCacheAlignedSession + 1,
+  NonPagedPoolNx = 512,
+  NonPagedPoolNxCacheAligned = NonPagedPoolNx + 4,
+  NonPagedPoolSessionNx = NonPagedPoolNx + 32,
+} POOL_TYPE;
+
+typedef enum _DRIVER_RUNTIME_INIT_FLAGS {
+  DrvRtPoolNxOptIn = 0x00000001
+} DRIVER_RUNTIME_INIT_FLAGS;
+
+/*
+ * I/O
+ */
+typedef struct _IO_STATUS_BLOCK {
+  union {
+    NTSTATUS Status;
+    PVOID Pointer;
+  };
+  ULONG_PTR Information;
+} IO_STATUS_BLOCK, *PIO_STATUS_BLOCK;
+
+typedef VOID (*PIO_APC_ROUTINE)(PVOID context,
+                                PIO_STATUS_BLOCK io_status,
+                                ULONG reserved);
+
+#define MDL_MAPPED_TO_SYSTEM_VA 0x0001
+#define MDL_PAGES_LOCKED 0x0002
+#define MDL_SOURCE_IS_NONPAGED_POOL 0x0004
+#define MDL_PARTIAL 0x0010
+#define MDL_IO_SPACE 0x0800
+
+typedef struct _MDL {
+  struct _MDL* Next;
+  CSHORT Size;
+  CSHORT MdlFlags;
+  PEPROCESS Process;
+  PVOID MappedSystemVa;
+  PVOID StartVa;
+  ULONG ByteCount;
+  ULONG ByteOffset;
+} MDL, *PMDL;
+
+#define MmGetMdlVirtualAddress(mdl) \
+  ((PVOID)((PCHAR)((mdl)->StartVa) + (mdl)->ByteOffset))
+#define MmGetMdlByteCount(mdl) ((mdl)->ByteCount)
+#define MmGetMdlByteOffset(mdl) ((mdl)->ByteOffset)
+
+typedef enum _MM_PAGE_PRIORITY {
+  LowPagePriority,
+  NormalPagePriority = 16,
+  HighPagePriority = 32
+} MM_PAGE_PRIORITY;
+
+#define MdlMappingNoWrite 0x80000000
+#define MdlMappingNoExecute 0x40000000
+
+typedef enum _LOCK_OPERATION {
+  IoReadAccess,
+  IoWriteAccess,
+  IoModifyAccess
+} LOCK_OPERATION;
+
+#define FILE_DEVICE_DISK_FILE_SYSTEM 0x00000008
+#define FILE_DEVICE_UNKNOWN 0x00000022
+
+#define DO_BUFFERED_IO 0x00000004
+#define DO_DIRECT_IO 0x00000010
+#define DO_DEVICE_INITIALIZING 0x00000080
+
+#define IRP_MJ_CREATE 0x00
+#define IRP_MJ_CLOSE 0x02
+#define IRP_MJ_READ 0x03
+#define IRP_MJ_WRITE 0x04
+#define IRP_MJ_QUERY_INFORMATION 0x05
+#define IRP_MJ_SET_INFORMATION 0x06
+#define IRP_MJ_DEVICE_CONTROL 0x0e
+#define IRP_MJ_CLEANUP 0x12
+#define IRP_MJ_MAXIMUM_FUNCTION 0x1b
+
+#define IRP_NOCACHE 0x00000001
+#define IRP_PAGING_IO 0x00000002
+#define IRP_SYNCHRONOUS_API 0x00000004
+#define IRP_READ_OPERATION 0x00000800
+#define IRP_WRITE_OPERATION 0x00000400
+
+#define SL_PENDING_RETURNED 0x01
+#define SL_INVOKE_ON_CANCEL 0x20
+#define SL_INVOKE_ON_SUCCESS 0x40
+#define SL_INVOKE_ON_ERROR 0x80
+
+struct _IRP;
+struct _DEVICE_OBJECT;
+struct _DRIVER_OBJECT;
+
+typedef NTSTATUS (*PIO_COMPLETION_ROUTINE)(struct _DEVICE_OBJECT* device,
+                                           struct _IRP* irp,
+                                           PVOID context);
+typedef NTSTATUS (*PDRIVER_DISPATCH)(struct _DEVICE_OBJECT* device,
+                                     struct _IRP* irp);
+typedef VOID (*PDRIVER_UNLOAD)(struct _DRIVER_OBJECT* driver);
+typedef NTSTATUS (*PDRIVER_INITIALIZE)(struct _DRIVER_OBJECT* driver,
+                                       PUNICODE_STRING registry_path);
+
+typedef struct _DEVICE_OBJECT {
+  CSHORT Type;
+  USHORT Size;
+  LONG ReferenceCount;
+  struct _DRIVER_OBJECT* DriverObject;
+  struct _DEVICE_OBJECT* NextDevice;
+  struct _DEVICE_OBJECT* AttachedDevice;
+  struct _IRP* CurrentIrp;
+  ULONG Flags;
+  ULONG Characteristics;
+  PVOID DeviceExtension;
+  ULONG DeviceType;
+  CCHAR StackSize;
+  ULONG AlignmentRequirement;
+} DEVICE_OBJECT, *PDEVICE_OBJECT;
+
+typedef struct _DRIVER_OBJECT {
+  CSHORT Type;
+  CSHORT Size;
+  PDEVICE_OBJECT DeviceObject;
+  ULONG Flags;
+  PVOID DriverStart;
+  ULONG DriverSize;
+  PVOID DriverSection;
+  PVOID DriverExtension;
+  UNICODE_STRING DriverName;
+  PUNICODE_STRING HardwareDatabase;
+  PVOID FastIoDispatch;
+  PDRIVER_INITIALIZE DriverInit;
+  PVOID DriverStartIo;
+  PDRIVER_UNLOAD DriverUnload;
+  PDRIVER_DISPATCH MajorFunction[IRP_MJ_MAXIMUM_FUNCTION + 1];
+} DRIVER_OBJECT, *PDRIVER_OBJECT;
+
+typedef struct _SECTION_OBJECT_POINTERS {
+  PVOID DataSectionObject;
+  PVOID SharedCacheMap;
+  PVOID ImageSectionObject;
+} SECTION_OBJECT_POINTERS, *PSECTION_OBJECT_POINTERS;
+
+typedef struct _FILE_OBJECT {
+  CSHORT Type;
+  CSHORT Size;
+  PDEVICE_OBJECT DeviceObject;
+  PVOID Vpb;
+  PVOID FsContext;
+  PVOID FsContext2;
+  PSECTION_OBJECT_POINTERS SectionObjectPointer;
+  PVOID PrivateCacheMap;
+  NTSTATUS FinalStatus;
+  struct _FILE_OBJECT* RelatedFileObject;
+  BOOLEAN LockOperation;
+  BOOLEAN DeletePending;
+  BOOLEAN ReadAccess;
+  BOOLEAN WriteAccess;
+  BOOLEAN DeleteAccess;
+  BOOLEAN SharedRead;
+  BOOLEAN SharedWrite;
+  BOOLEAN SharedDelete;
+  ULONG Flags;
+  UNICODE_STRING FileName;
+  LARGE_INTEGER CurrentByteOffset;
+} FILE_OBJECT, *PFILE_OBJECT;
+
+typedef struct _IO_STACK_LOCATION {
+  UCHAR MajorFunction;
+  UCHAR MinorFunction;
+  UCHAR Flags;
+  UCHAR Control;
+  union {
+    struct {
+      ULONG Length;
+      ULONG Key;
+      LARGE_INTEGER ByteOffset;
+    } Read;
+    struct {
+      ULONG Length;
+      ULONG Key;
+      LARGE_INTEGER ByteOffset;
+    } Write;
+    struct {
+      PVOID Argument1;
+      PVOID Argument2;
+      PVOID Argument3;
+      PVOID Argument4;
+    } Others;
+  } Parameters;
+  PDEVICE_OBJECT DeviceObject;
+  PFILE_OBJECT FileObject;
+  PIO_COMPLETION_ROUTINE CompletionRoutine;
+  PVOID Context;
+} IO_STACK_LOCATION, *PIO_STACK_LOCATION;
+
+typedef struct _IRP {
+  CSHORT Type;
+  USHORT Size;
+  PMDL MdlAddress;
+  ULONG Flags;
+  union {
+    struct _IRP* MasterIrp;
+    LONG IrpCount;
+    PVOID SystemBuffer;
+  } AssociatedIrp;
+  LIST_ENTRY ThreadListEntry;
+  IO_STATUS_BLOCK IoStatus;
+  KPROCESSOR_MODE RequestorMode;
+  BOOLEAN PendingReturned;
+  CHAR StackCount;
+  CHAR CurrentLocation;
+  BOOLEAN Cancel;
+  KIRQL CancelIrql;
+  PIO_STATUS_BLOCK UserIosb;
+  PKEVENT UserEvent;
+  PVOID UserBuffer;
+  union {
+    struct {
+      PETHREAD Thread;
+      PCHAR AuxiliaryBuffer;
+      LIST_ENTRY ListEntry;
+      PIO_STACK_LOCATION CurrentStackLocation;
+      PFILE_OBJECT OriginalFileObject;
+    } Overlay;
+  } Tail;
+} IRP, *PIRP;
+
+#define IoGetCurrentIrpStackLocation(irp) \
+  ((irp)->Tail.Overlay.CurrentStackLocation)
+#define IoGetNextIrpStackLocation(irp) \
+  ((irp)->Tail.Overlay.CurrentStackLocation - 1)
+#define IoMarkIrpPending(irp) \
+  (IoGetCurrentIrpStackLocation(irp)->Control |= SL_PENDING_RETURNED)
+
+inline VOID IoSetCompletionRoutine(PIRP irp,
+                                   PIO_COMPLETION_ROUTINE routine,
+                                   PVOID context,
+                                   BOOLEAN invoke_on_success,
+                                   BOOLEAN invoke_on_error,
+                                   BOOLEAN invoke_on_cancel) {
+  PIO_STACK_LOCATION stack{IoGetNextIrpStackLocation(irp)};
+  stack->CompletionRoutine = routine;
+  stack->Context = context;
+  stack->Control = 0;
+  if (invoke_on_success) {
+    stack->Control |= SL_INVOKE_ON_SUCCESS;
+  }
+  if (invoke_on_error) {
+    stack->Control |= SL_INVOKE_ON_ERROR;
+  }
+  if (invoke_on_cancel) {
+    stack->Control |= SL_INVOKE_ON_CANCEL;
+  }
+}
+
+/*
+ * Files and sections
+ */
+#define FILE_READ_DATA 0x0001
+#define FILE_WRITE_DATA 0x0002
+#define FILE_APPEND_DATA 0x0004
+#define FILE_READ_ATTRIBUTES 0x0080
+#define FILE_WRITE_ATTRIBUTES 0x0100
+#define FILE_GENERIC_READ (READ_CONTROL | FILE_READ_DATA | SYNCHRONIZE)
+#define FILE_GENERIC_WRITE (READ_CONTROL | FILE_WRITE_DATA | SYNCHRONIZE)
+
+#define FILE_SHARE_READ 0x00000001
+#define FILE_SHARE_WRITE 0x00000002
+#define FILE_SHARE_DELETE 0x00000004
+
+#define FILE_ATTRIBUTE_READONLY 0x00000001
+#define FILE_ATTRIBUTE_NORMAL 0x00000080
+#define FILE_ATTRIBUTE_TEMPORARY 0x00000100
+
+#define FILE_SUPERSEDE 0x00000000
+#define FILE_OPEN 0x00000001
+#define FILE_CREATE 0x00000002
+#define FILE_OPEN_IF 0x00000003
+#define FILE_OVERWRITE 0x00000004
+#define FILE_OVERWRITE_IF 0x00000005
+
+#define FILE_DIRECTORY_FILE 0x00000001
+#define FILE_WRITE_THROUGH 0x00000002
+#define FILE_SEQUENTIAL_ONLY 0x00000004
+#define FILE_SYNCHRONOUS_IO_ALERT 0x00000010
+#define FILE_SYNCHRONOUS_IO_NONALERT 0x00000020
+#define FILE_NON_DIRECTORY_FILE 0x00000040
+#define FILE_RANDOM_ACCESS 0x00000800
+#define FILE_DELETE_ON_CLOSE 0x00001000
+#define FILE_OPEN_BY_FILE_ID 0x00002000
+
+#define FILE_SUPERSEDED 0x00000000
+#define FILE_OPENED 0x00000001
+#define FILE_CREATED 0x00000002
+#define FILE_OVERWRITTEN 0x00000003
+#define FILE_EXISTS 0x00000004
+#define FILE_DOES_NOT_EXIST 0x00000005
+
+#define FILE_USE_FILE_POINTER_POSITION 0xfffffffe
+
+typedef enum _FILE_INFORMATION_CLASS {
+  FileDirectoryInformation = 1,
+  FileBasicInformation = 4,
+  FileStandardInformation = 5,
+  FileInternalInformation = 6,
+  FileRenameInformation = 10,
+  FileLinkInformation = 11,
+  FilePositionInformation = 14,
+  FileEndOfFileInformation = 20,
+  FileRenameInformationEx = 65,
+  FileLinkInformationEx = 72,
+} FILE_INFORMATION_CLASS;
+
+typedef struct _FILE_STANDARD_INFORMATION {
+  LARGE_INTEGER AllocationSize;
+  LARGE_INTEGER EndOfFile;
+  ULONG NumberOfLinks;
+  BOOLEAN DeletePending;
+  BOOLEAN Directory;
+} FILE_STANDARD_INFORMATION, *PFILE_STANDARD_INFORMATION;
+
+typedef struct _FILE_INTERNAL_INFORMATION {
+  LARGE_INTEGER IndexNumber;
+} FILE_INTERNAL_INFORMATION, *PFILE_INTERNAL_INFORMATION;
+
+typedef struct _FILE_POSITION_INFORMATION {
+  LARGE_INTEGER CurrentByteOffset;
+} FILE_POSITION_INFORMATION, *PFILE_POSITION_INFORMATION;
+
+#define SECTION_QUERY 0x0001
+#define SECTION_MAP_WRITE 0x0002
+#define SECTION_MAP_READ 0x0004
+#define SECTION_MAP_EXECUTE 0x0008
+#define SECTION_ALL_ACCESS (STANDARD_RIGHTS_REQUIRED | 0x001F)
+
+#define PAGE_NOACCESS 0x01
+#define PAGE_READONLY 0x02
+#define PAGE_READWRITE 0x04
+#define PAGE_WRITECOPY 0x08
+
+#define SEC_COMMIT 0x8000000
+#define SEC_RESERVE 0x4000000
+
+typedef enum _SECTION_INHERIT { ViewShare = 1, ViewUnmap = 2 } SECTION_INHERIT;
+
+typedef enum _VIRTUAL_MEMORY_INFORMATION_CLASS {
+  VmPrefetchInformation,
+  VmPagePriorityInformation,
+  VmCfgCallTargetInformation
+} VIRTUAL_MEMORY_INFORMATION_CLASS;
+
+typedef struct _MEMORY_RANGE_ENTRY {
+  PVOID VirtualAddress;
+  SIZE_T NumberOfBytes;
+} MEMORY_RANGE_ENTRY, *PMEMORY_RANGE_ENTRY;
+
+#define NtCurrentProcess() ((HANDLE)(LONG_PTR)-1)
+#define ZwCurrentProcess() NtCurrentProcess()
+
+/*
+ * Work items and threads
+ */
+typedef VOID (*PWORKER_THREAD_ROUTINE)(PVOID parameter);
+typedef VOID (*PKSTART_ROUTINE)(PVOID context);
+
+typedef struct _WORK_QUEUE_ITEM {
+  LIST_ENTRY List;
+  PWORKER_THREAD_ROUTINE WorkerRoutine;
+  PVOID Parameter;
+} WORK_QUEUE_ITEM, *PWORK_QUEUE_ITEM;
+
+typedef enum _WORK_QUEUE_TYPE {
+  CriticalWorkQueue,
+  DelayedWorkQueue,
+  HyperCriticalWorkQueue,
+  NormalWorkQueue,
+  BackgroundWorkQueue,
+  RealTimeWorkQueue,
+  SuperCriticalWorkQueue,
+  MaximumWorkQueue,
+} WORK_QUEUE_TYPE;
+
+#define ExInitializeWorkItem(item, routine, context) \
+  {                                                  \
+    (item)->WorkerRoutine = (routine);               \
+    (item)->Parameter = (context);                   \
+    (item)->List.Flink = nullptr;                    \
+  }
+
+/*
+ * Time and versions
+ */
+typedef struct _TIME_FIELDS {
+  SHORT Year;
+  SHORT Month;
+  SHORT Day;
+  SHORT Hour;
+  SHORT Minute;
+  SHORT Second;
+  SHORT Milliseconds;
+  SHORT Weekday;
+} TIME_FIELDS, *PTIME_FIELDS;
+
+typedef struct _OSVERSIONINFOW {
+  ULONG dwOSVersionInfoSize;
+  ULONG dwMajorVersion;
+  ULONG dwMinorVersion;
+  ULONG dwBuildNumber;
+  ULONG dwPlatformId;
+  WCHAR szCSDVersion[128];
+} OSVERSIONINFOW, RTL_OSVERSIONINFOW, *PRTL_OSVERSIONINFOW;
+
+/*
+ * Debug output
+ */
+#define DPFLTR_ERROR_LEVEL 0
+#define DPFLTR_WARNING_LEVEL 1
+#define DPFLTR_TRACE_LEVEL 2
+#define DPFLTR_INFO_LEVEL 3
+#define DPFLTR_DEFAULT_ID 101
+#define DPFLTR_IHVDRIVER_ID 77
+
+/*
+ * Interlocked operations and barriers, which are the compiler intrinsics
+ */
+#define InterlockedExchange8 _InterlockedExchange8
+#define InterlockedCompareExchange8 _InterlockedCompareExchange8
+#define InterlockedExchangeAdd8 _InterlockedExchangeAdd8
+#define InterlockedAnd8 _InterlockedAnd8
+#define InterlockedOr8 _InterlockedOr8
+#define InterlockedXor8 _InterlockedXor8
+
+#define InterlockedExchange16 _InterlockedExchange16
+#define InterlockedCompareExchange16 _InterlockedCompareExchange16
+#define InterlockedExchangeAdd16 _InterlockedExchangeAdd16
+#define InterlockedAnd16 _InterlockedAnd16
+#define InterlockedOr16 _InterlockedOr16
+#define InterlockedXor16 _InterlockedXor16
+#define InterlockedIncrement16 _InterlockedIncrement16
+#define InterlockedDecrement16 _InterlockedDecrement16
+
+#define InterlockedExchange _InterlockedExchange
+#define InterlockedCompareExchange _InterlockedCompareExchange
+#define InterlockedExchangeAdd _InterlockedExchangeAdd
+#define InterlockedAnd _InterlockedAnd
+#define InterlockedOr _InterlockedOr
+#define InterlockedXor _InterlockedXor
+#define InterlockedIncrement _InterlockedIncrement
+#define InterlockedDecrement _InterlockedDecrement
+#define InterlockedIncrementAcquire _InterlockedIncrement
+#define InterlockedDecrementRelease _InterlockedDecrement
+
+#define InterlockedExchange64 _InterlockedExchange64
+#define InterlockedCompareExchange64 _InterlockedCompareExchange64
+#define InterlockedExchangeAdd64 _InterlockedExchangeAdd64
+#define InterlockedAnd64 _InterlockedAnd64
+#define InterlockedOr64 _InterlockedOr64
+#define InterlockedXor64 _InterlockedXor64
+#define InterlockedIncrement64 _InterlockedIncrement64
+#define InterlockedDecrement64 _InterlockedDecrement64
+
+#define InterlockedExchangePointer _InterlockedExchangePointer
+#define InterlockedCompareExchangePointer _InterlockedCompareExchangePointer
+
+inline LONG InterlockedAdd(LONG volatile* addend, LONG value) {
+  return InterlockedExchangeAdd(addend, value) + value;
+}
+
+inline LONG64 InterlockedAdd64(LONG64 volatile* addend, LONG64 value) {
+  return InterlockedExchangeAdd64(addend, value) + value;
+}
+
+#define KeMemoryBarrier() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define KeMemoryBarrierWithoutFence() _ReadWriteBarrier()
+#define MemoryBarrier() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#define YieldProcessor() _mm_pause()
+#define ReadTimeStampCounter() __rdtsc()
+
+extern "C" {
+/*
+ * Run-time library
+ */
+NTSTATUS RtlGetVersion(PRTL_OSVERSIONINFOW version_info);
+VOID RtlTimeToTimeFields(PLARGE_INTEGER time, PTIME_FIELDS time_fields);
+VOID RtlInitUnicodeString(PUNICODE_STRING target, PCWSTR source);
+NTSTATUS RtlUnicodeToMultiByteSize(PULONG bytes_in_multibyte_string,
+                                   PCWCH unicode_string,
+                                   ULONG bytes_in_unicode_string);
+NTSTATUS RtlUnicodeToMultiByteN(PCHAR multibyte_string,
+                                ULONG max_bytes_in_multibyte_string,
+                                PULONG bytes_in_multibyte_string,
+                                PCWCH unicode_string,
+                                ULONG bytes_in_unicode_string);
+ULONG64 RtlGetEnabledExtendedFeatures(ULONG64 feature_mask);
+
+ULONG DbgPrint(PCSTR format, ...);
+ULONG DbgPrintEx(ULONG component_id, ULONG level, PCSTR format, ...);
+VOID DbgRaiseAssertionFailure();
+DECLSPEC_NORETURN VOID KeBugCheck(ULONG bug_check_code);
+DECLSPEC_NORETURN VOID KeBugCheckEx(ULONG bug_check_code,
+                                    ULONG_PTR parameter1,
+                                    ULONG_PTR parameter2,
+                                    ULONG_PTR parameter3,
+                                    ULONG_PTR parameter4);
+
+/*
+ * Pool
+ */
+VOID ExInitializeDriverRuntime(ULONG runtime_flags);
+PVOID ExAllocatePoolUninitialized(POOL_TYPE pool_type,
+                                  SIZE_T number_of_bytes,
+                                  ULONG tag);
+PVOID ExAllocatePoolWithTag(POOL_TYPE pool_type,
+                            SIZE_T number_of_bytes,
+                            ULONG tag);
+VOID ExFreePoolWithTag(PVOID pool, ULONG tag);
+VOID ExFreePool(PVOID pool);
+
+/*
+ * IRQL and processors. IRQL is a per-thread value; raising it to
+ * DISPATCH_LEVEL or above binds the thread to a virtual processor which no
+ * other thread may use until the IRQL is lowered, so the code at
+ * DISPATCH_LEVEL isn't preempted by the code of the same processor
+ */
+KIRQL KeGetCurrentIrql();
+VOID KeRaiseIrql(KIRQL new_irql, PKIRQL old_irql);
+KIRQL KeRaiseIrqlToDpcLevel();
+VOID KeLowerIrql(KIRQL new_irql);
+VOID KeEnterCriticalRegion();
+VOID KeLeaveCriticalRegion();
+
+ULONG KeQueryActiveProcessorCount(PKAFFINITY active_processors);
+ULONG KeQueryActiveProcessorCountEx(USHORT group_number);
+ULONG KeQueryMaximumProcessorCountEx(USHORT group_number);
+ULONG KeGetCurrentProcessorNumberEx(PPROCESSOR_NUMBER proc_number);
+ULONG KeGetCurrentProcessorIndex();
+NTSTATUS KeGetProcessorNumberFromIndex(ULONG proc_index,
+                                       PPROCESSOR_NUMBER proc_number);
+VOID KeSetSystemGroupAffinityThread(PGROUP_AFFINITY affinity,
+                                    PGROUP_AFFINITY previous_affinity);
+VOID KeRevertToUserGroupAffinityThread(PGROUP_AFFINITY previous_affinity);
+ULONG_PTR KeIpiGenericCall(PKIPI_BROADCAST_WORKER broadcast_function,
+                           ULONG_PTR context);
+
+NTSTATUS KeSaveExtendedProcessorState(ULONG64 mask, PXSTATE_SAVE xstate_save);
+VOID KeRestoreExtendedProcessorState(PXSTATE_SAVE xstate_save);
+
+/*
+ * Time
+ */
+LARGE_INTEGER KeQueryPerformanceCounter(PLARGE_INTEGER performance_frequency);
+ULONGLONG KeQueryInterruptTime();
+VOID KeQuerySystemTime(PLARGE_INTEGER current_time);
+VOID KeQuerySystemTimePrecise(PLARGE_INTEGER current_time);
+VOID KeStallExecutionProcessor(ULONG microseconds);
+NTSTATUS KeDelayExecutionThread(KPROCESSOR_MODE wait_mode,
+                                BOOLEAN alertable,
+                                PLARGE_INTEGER interval);
+
+/*
+ * Spin locks
+ */
+VOID KeInitializeSpinLock(PKSPIN_LOCK spin_lock);
+KIRQL KeAcquireSpinLockRaiseToDpc(PKSPIN_LOCK spin_lock);
+VOID KeReleaseSpinLock(PKSPIN_LOCK spin_lock, KIRQL new_irql);
+VOID KeAcquireSpinLockAtDpcLevel(PKSPIN_LOCK spin_lock);
+VOID KeReleaseSpinLockFromDpcLevel(PKSPIN_LOCK spin_lock);
+BOOLEAN KeTryToAcquireSpinLockAtDpcLevel(PKSPIN_LOCK spin_lock);
+VOID KeAcquireInStackQueuedSpinLock(PKSPIN_LOCK spin_lock,
+                                    PKLOCK_QUEUE_HANDLE lock_handle);
+VOID KeReleaseInStackQueuedSpinLock(PKLOCK_QUEUE_HANDLE lock_handle);
+VOID KeAcquireInStackQueuedSpinLockAtDpcLevel(PKSPIN_LOCK spin_lock,
+                                              PKLOCK_QUEUE_HANDLE lock_handle);
+VOID KeReleaseInStackQueuedSpinLockFromDpcLevel(
+    PKLOCK_QUEUE_HANDLE lock_handle);
+
+#define KeAcquireSpinLock(spin_lock, old_irql) \
+  *(old_irql) = KeAcquireSpinLockRaiseToDpc(spin_lock)
+
+/*
+ * Dispatcher objects
+ */
+VOID KeInitializeEvent(PRKEVENT event, EVENT_TYPE type, BOOLEAN state);
+LONG KeSetEvent(PRKEVENT event, KPRIORITY increment, BOOLEAN wait);
+LONG KeResetEvent(PRKEVENT event);
+VOID KeClearEvent(PRKEVENT event);
+LONG KePulseEvent(PRKEVENT event, KPRIORITY increment, BOOLEAN wait);
+LONG KeReadStateEvent(PRKEVENT event);
+
+VOID KeInitializeMutex(PRKMUTEX mutex, ULONG level);
+LONG KeReleaseMutex(PRKMUTEX mutex, BOOLEAN wait);
+LONG KeReadStateMutex(PRKMUTEX mutex);
+
+VOID KeInitializeSemaphore(PRKSEMAPHORE semaphore, LONG count, LONG limit);
+LONG KeReleaseSemaphore(PRKSEMAPHORE semaphore,
+                        KPRIORITY increment,
+                        LONG adjustment,
+                        BOOLEAN wait);
+LONG KeReadStateSemaphore(PRKSEMAPHORE semaphore);
+
+NTSTATUS KeWaitForSingleObject(PVOID object,
+                               KWAIT_REASON wait_reason,
+                               KPROCESSOR_MODE wait_mode,
+                               BOOLEAN alertable,
+                               PLARGE_INTEGER timeout);
+NTSTATUS KeWaitForMultipleObjects(ULONG count,
+                                  PVOID object[],
+                                  WAIT_TYPE wait_type,
+                                  KWAIT_REASON wait_reason,
+                                  KPROCESSOR_MODE wait_mode,
+                                  BOOLEAN alertable,
+                                  PLARGE_INTEGER timeout,
+                                  PKWAIT_BLOCK wait_block_array);
+
+/*
+ * Executive synchronization
+ */
+VOID ExInitializeFastMutex(PFAST_MUTEX fast_mutex);
+VOID ExAcquireFastMutex(PFAST_MUTEX fast_mutex);
+BOOLEAN ExTryToAcquireFastMutex(PFAST_MUTEX fast_mutex);
+VOID ExReleaseFastMutex(PFAST_MUTEX fast_mutex);
+
+NTSTATUS ExInitializeResourceLite(PERESOURCE resource);
+NTSTATUS ExDeleteResourceLite(PERESOURCE resource);
+PVOID ExEnterCriticalRegionAndAcquireResourceExclusive(PERESOURCE resource);
+PVOID ExEnterCriticalRegionAndAcquireResourceShared(PERESOURCE resource);
+VOID ExReleaseResourceAndLeaveCriticalRegion(PERESOURCE resource);
+
+VOID ExInitializePushLock(PEX_PUSH_LOCK push_lock);
+VOID ExAcquirePushLockExclusive(PEX_PUSH_LOCK push_lock);
+VOID ExAcquirePushLockShared(PEX_PUSH_LOCK push_lock);
+VOID ExReleasePushLockExclusive(PEX_PUSH_LOCK push_lock);
+VOID ExReleasePushLockShared(PEX_PUSH_LOCK push_lock);
+
+VOID InitializeSListHead(PSLIST_HEADER list_head);
+PSLIST_ENTRY InterlockedPushEntrySList(PSLIST_HEADER list_head,
+                                       PSLIST_ENTRY list_entry);
+PSLIST_ENTRY InterlockedPopEntrySList(PSLIST_HEADER list_head);
+PSLIST_ENTRY InterlockedFlushSList(PSLIST_HEADER list_head);
+USHORT ExQueryDepthSList(PSLIST_HEADER list_head);
+
+VOID ExQueueWorkItem(PWORK_QUEUE_ITEM work_item, WORK_QUEUE_TYPE queue_type);
+
+typedef struct _IO_WORKITEM IO_WORKITEM, *PIO_WORKITEM;
+typedef VOID (*PIO_WORKITEM_ROUTINE)(PDEVICE_OBJECT device_object,
+                                     PVOID context);
+
+PIO_WORKITEM IoAllocateWorkItem(PDEVICE_OBJECT device_object);
+VOID IoFreeWorkItem(PIO_WORKITEM io_work_item);
+ULONG IoSizeofWorkItem();
+VOID IoInitializeWorkItem(PVOID io_object, PIO_WORKITEM io_work_item);
+VOID IoUninitializeWorkItem(PIO_WORKITEM io_work_item);
+VOID IoQueueWorkItem(PIO_WORKITEM io_work_item,
+                     PIO_WORKITEM_ROUTINE worker_routine,
+                     WORK_QUEUE_TYPE queue_type,
+                     PVOID context);
+
+/*
+ * Objects and handles
+ */
+extern POBJECT_TYPE* ExEventObjectType;
+extern POBJECT_TYPE* IoFileObjectType;
+extern POBJECT_TYPE* PsThreadType;
+
+NTSTATUS ObReferenceObjectByHandle(HANDLE handle,
+                                   ACCESS_MASK desired_access,
+                                   POBJECT_TYPE object_type,
+                                   KPROCESSOR_MODE access_mode,
+                                   PVOID* object,
+                                   POBJECT_HANDLE_INFORMATION handle_info);
+LONG_PTR ObfReferenceObject(PVOID object);
+LONG_PTR ObfDereferenceObject(PVOID object);
+NTSTATUS ZwClose(HANDLE handle);
+
+#define ObReferenceObject(object) ObfReferenceObject(object)
+#define ObDereferenceObject(object) ObfDereferenceObject(object)
+
+/*
+ * Threads
+ */
+NTSTATUS PsCreateSystemThread(PHANDLE thread_handle,
+                              ULONG desired_access,
+                              POBJECT_ATTRIBUTES object_attributes,
+                              HANDLE process_handle,
+                              PCLIENT_ID client_id,
+                              PKSTART_ROUTINE start_routine,
+                              PVOID start_context);
+NTSTATUS IoCreateSystemThread(PVOID io_object,
+                              PHANDLE thread_handle,
+                              ULONG desired_access,
+                              POBJECT_ATTRIBUTES object_attributes,
+                              HANDLE process_handle,
+                              PCLIENT_ID client_id,
+                              PKSTART_ROUTINE start_routine,
+                              PVOID start_context);
+DECLSPEC_NORETURN NTSTATUS PsTerminateSystemThread(NTSTATUS exit_status);
+PETHREAD PsGetCurrentThread();
+PKTHREAD KeGetCurrentThread();
+HANDLE PsGetCurrentThreadId();
+HANDLE PsGetThreadId(PETHREAD thread);
+KPRIORITY KeQueryPriorityThread(PKTHREAD thread);
+KPRIORITY KeSetPriorityThread(PKTHREAD thread, KPRIORITY priority);
+
+/*
+ * Memory descriptor lists
+ */
+PMDL IoAllocateMdl(PVOID virtual_address,
+                   ULONG length,
+                   BOOLEAN secondary_buffer,
+                   BOOLEAN charge_quota,
+                   PIRP irp);
+VOID IoFreeMdl(PMDL mdl);
+VOID IoBuildPartialMdl(PMDL source_mdl,
+                       PMDL target_mdl,
+                       PVOID virtual_address,
+                       ULONG length);
+VOID MmBuildMdlForNonPagedPool(PMDL mdl);
+VOID MmProbeAndLockPages(PMDL mdl,
+                         KPROCESSOR_MODE access_mode,
+                         LOCK_OPERATION operation);
+VOID MmUnlockPages(PMDL mdl);
+PVOID MmGetSystemAddressForMdlSafe(PMDL mdl, ULONG priority);
+
+/*
+ * I/O requests
+ */
+PIRP IoAllocateIrp(CCHAR stack_size, BOOLEAN charge_quota);
+VOID IoFreeIrp(PIRP irp);
+NTSTATUS IofCallDriver(PDEVICE_OBJECT device, PIRP irp);
+VOID IofCompleteRequest(PIRP irp, CCHAR priority_boost);
+PDEVICE_OBJECT IoGetRelatedDeviceObject(PFILE_OBJECT file_object);
+PKEVENT IoCreateNotificationEvent(PUNICODE_STRING event_name,
+                                  PHANDLE event_handle);
+
+#define IoCallDriver(device, irp) IofCallDriver(device, irp)
+#define IoCompleteRequest(irp, boost) IofCompleteRequest(irp, boost)
+
+/*
+ * Files and sections
+ */
+NTSTATUS ZwCreateFile(PHANDLE file_handle,
+                      ACCESS_MASK desired_access,
+                      POBJECT_ATTRIBUTES object_attributes,
+                      PIO_STATUS_BLOCK io_status_block,
+                      PLARGE_INTEGER allocation_size,
+                      ULONG file_attributes,
+                      ULONG share_access,
+                      ULONG create_disposition,
+                      ULONG create_options,
+                      PVOID ea_buffer,
+                      ULONG ea_length);
+NTSTATUS ZwReadFile(HANDLE file_handle,
+                    HANDLE event,
+                    PIO_APC_ROUTINE apc_routine,
+                    PVOID apc_context,
+                    PIO_STATUS_BLOCK io_status_block,
+                    PVOID buffer,
+                    ULONG length,
+                    PLARGE_INTEGER byte_offset,
+                    PULONG key);
+NTSTATUS ZwWriteFile(HANDLE file_handle,
+                     HANDLE event,
+                     PIO_APC_ROUTINE apc_routine,
+                     PVOID apc_context,
+                     PIO_STATUS_BLOCK io_status_block,
+                     PVOID buffer,
+                     ULONG length,
+                     PLARGE_INTEGER byte_offset,
+                     PULONG key);
+NTSTATUS ZwQueryInformationFile(HANDLE file_handle,
+                                PIO_STATUS_BLOCK io_status_block,
+                                PVOID file_information,
+                                ULONG length,
+                                FILE_INFORMATION_CLASS file_information_class);
+NTSTATUS ZwDeleteFile(POBJECT_ATTRIBUTES object_attributes);
+
+NTSTATUS ZwCreateSection(PHANDLE section_handle,
+                         ACCESS_MASK desired_access,
+                         POBJECT_ATTRIBUTES object_attributes,
+                         PLARGE_INTEGER maximum_size,
+                         ULONG section_page_protection,
+                         ULONG allocation_attributes,
+                         HANDLE file_handle);
+NTSTATUS ZwMapViewOfSection(HANDLE section_handle,
+                            HANDLE process_handle,
+                            PVOID* base_address,
+                            ULONG_PTR zero_bits,
+                            SIZE_T commit_size,
+                            PLARGE_INTEGER section_offset,
+                            PSIZE_T view_size,
+                            SECTION_INHERIT inherit_disposition,
+                            ULONG allocation_type,
+                            ULONG win32_protect);
+NTSTATUS ZwUnmapViewOfSection(HANDLE process_handle, PVOID base_address);
+NTSTATUS MmMapViewInSystemSpace(PVOID section,
+                                PVOID* mapped_base,
+                                PSIZE_T view_size);
+NTSTATUS MmUnmapViewInSystemSpace(PVOID mapped_base);
+NTSTATUS ZwSetInformationVirtualMemory(
+    HANDLE process_handle,
+    VIRTUAL_MEMORY_INFORMATION_CLASS information_class,
+    ULONG_PTR number_of_entries,
+    PMEMORY_RANGE_ENTRY virtual_addresses,
+    PVOID information,
+    ULONG information_length);
+}  // extern "C"
@@ -0,0 +1,6 @@
+#pragma once
+/*
+ * The file system declarations are the part of <ntddk.h> in the hosted
+ * platform layer
+ */
+#include <ntddk.h>
@@ -0,0 +1,400 @@
+#include "platform.hpp"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/utsname.h>
+#include <time.h>
+
+namespace hosted {
+namespace {
+constexpr size_t OUTPUT_BUFFER_SIZE{4096};
+
+struct output_buffer {
+  char data[OUTPUT_BUFFER_SIZE];
+  size_t length{0};
+
+  void append(const char* str, size_t count) noexcept {
+    const size_t available{OUTPUT_BUFFER_SIZE - 1 - length};
+    if (count > available) {
+      count = available;
+    }
+    memcpy(data + length, str, count);
+    length += count;
+  }
+
+  void append(char ch) noexcept { append(&ch, 1); }
+
+  void append_utf8(wchar_t ch) noexcept {
+    const auto code{static_cast<uint32_t>(ch)};
+    char encoded[4];
+    if (code < 0x80) {
+      append(static_cast<char>(code));
+    } else if (code < 0x800) {
+      encoded[0] = static_cast<char>(0xC0 | (code >> 6));
+      encoded[1] = static_cast<char>(0x80 | (code & 0x3F));
+      append(encoded, 2);
+    } else if (code < 0x10000) {
+      encoded[0] = static_cast<char>(0xE0 | (code >> 12));
+      encoded[1] = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+      encoded[2] = static_cast<char>(0x80 | (code & 0x3F));
+      append(encoded, 3);
+    } else {
+      encoded[0] = static_cast<char>(0xF0 | (code >> 18));
+      encoded[1] = static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+      encoded[2] = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+      encoded[3] = static_cast<char>(0x80 | (code & 0x3F));
+      append(encoded, 4);
+    }
+  }
+
+  void append_wide(const wchar_t* str, size_t count) noexcept {
+    for (size_t idx = 0; idx < count; ++idx) {
+      append_utf8(str[idx]);
+    }
+  }
+};
+
+size_t wide_length(const wchar_t* str, int precision) noexcept {
+  size_t length{0};
+  while ((precision < 0 || length < static_cast<size_t>(precision)) &&
+         str[length]) {
+    ++length;
+  }
+  return length;
+}
+
+/*
+ * Formats the string as the kernel debugger does. Unlike the LP64 printf(),
+ * the 'l' size prefix denotes 32-bit integers, 'w' and 'S' denote the wide
+ * strings and 'Z' denotes the counted strings
+ */
+void format(output_buffer& output, const char* fmt, va_list args) noexcept {
+  while (*fmt) {
+    if (*fmt != '%') {
+      output.append(*fmt++);
+      continue;
+    }
+    const char* spec_begin{fmt++};
+    if (*fmt == '%') {
+      output.append(*fmt++);
+      continue;
+    }
+    char spec[32]{'%'};
+    size_t spec_length{1};
+    const auto add_to_spec = [&spec, &spec_length](char ch) {
+      if (spec_length < sizeof(spec) - 4) {
+        spec[spec_length++] = ch;
+      }
+    };
+    while (*fmt && strchr("-+ #0", *fmt)) {
+      add_to_spec(*fmt++);
+    }
+    int width{-1};
+    if (*fmt == '*') {
+      width = va_arg(args, int);
+      ++fmt;
+    } else {
+      for (; *fmt >= '0' && *fmt <= '9'; ++fmt) {
+        width = (width < 0 ? 0 : width * 10) + (*fmt - '0');
+      }
+    }
+    int precision{-1};
+    if (*fmt == '.') {
+      ++fmt;
+      precision = 0;
+      if (*fmt == '*') {
+        precision = va_arg(args, int);
+        ++fmt;
+      } else {
+        for (; *fmt >= '0' && *fmt <= '9'; ++fmt) {
+          precision = precision * 10 + (*fmt - '0');
+        }
+      }
+    }
+    char size{0};  // 'h', 'H' (hh), 'L' (64 bits), 'z' (pointer-sized), 'w'
+    if (!strncmp(fmt, "I64", 3)) {
+      size = 'L';
+      fmt += 3;
+    } else if (!strncmp(fmt, "I32", 3)) {
+      fmt += 3;
+    } else if (*fmt == 'I' || *fmt == 'z') {
+      size = 'z';
+      ++fmt;
+    } else if (!strncmp(fmt, "ll", 2)) {
+      size = 'L';
+      fmt += 2;
+    } else if (!strncmp(fmt, "hh", 2)) {
+      size = 'H';
+      fmt += 2;
+    } else if (*fmt == 'h' || *fmt == 'w') {
+      size = *fmt++;
+    } else if (*fmt == 'l') {
+      size = 'l';  // A 32-bit integer or a wide character
+      ++fmt;
+    }
+    const char conversion{*fmt};
+    if (!conversion) {
+      output.append(spec_begin, static_cast<size_t>(fmt - spec_begin));
+      break;
+    }
+    ++fmt;
+
+    char formatted[512];
+    int formatted_length{0};
+    switch (conversion) {
+      case 'd':
+      case 'i':
+      case 'u':
+      case 'x':
+      case 'X':
+      case 'o': {
+        if (width >= 0) {
+          formatted_length = snprintf(spec + spec_length,
+                                      sizeof(spec) - spec_length, "%d", width);
+          spec_length += static_cast<size_t>(formatted_length);
+        }
+        if (precision >= 0) {
+          formatted_length =
+              snprintf(spec + spec_length, sizeof(spec) - spec_length, ".%d",
+                       precision);
+          spec_length += static_cast<size_t>(formatted_length);
+        }
+        if (size == 'L' || size == 'z') {
+          add_to_spec('l');
+          add_to_spec('l');
+        }
+        add_to_spec(conversion);
+        spec[spec_length] = '\0';
+        if (size == 'L' || size == 'z') {
+          const auto value{size == 'L' ? va_arg(args, long long)
+                                       : va_arg(args, ptrdiff_t)};
+          formatted_length =
+              snprintf(formatted, sizeof(formatted), spec, value);
+        } else {
+          int value{va_arg(args, int)};
+          if (size == 'h') {
+            value = conversion == 'd' || conversion == 'i'
+                        ? static_cast<short>(value)
+                        : static_cast<unsigned short>(value);
+          } else if (size == 'H') {
+            value = conversion == 'd' || conversion == 'i'
+                        ? static_cast<signed char>(value)
+                        : static_cast<unsigned char>(value);
+          }
+          formatted_length =
+              snprintf(formatted, sizeof(formatted), spec, value);
+        }
+        break;
+      }
+      case 'e':
+      case 'E':
+      case 'f':
+      case 'g':
+      case 'G':
+      case 'a':
+      case 'A': {
+        spec[spec_length] = '\0';
+        char float_spec[64];
+        snprintf(float_spec, sizeof(float_spec), "%s*.*%c", spec, conversion);
+        formatted_length =
+            snprintf(formatted, sizeof(formatted), float_spec,
+                     width < 0 ? 0 : width, precision < 0 ? 6 : precision,
+                     va_arg(args, double));
+        break;
+      }
+      case 'p':
+        formatted_length =
+            snprintf(formatted, sizeof(formatted), "%016llX",
+                     static_cast<unsigned long long>(
+                         reinterpret_cast<uintptr_t>(va_arg(args, void*))));
+        break;
+      case 'c':
+      case 'C': {
+        const int value{va_arg(args, int)};
+        if (size == 'w' || size == 'l' || conversion == 'C') {
+          output.append_utf8(static_cast<wchar_t>(value));
+        } else {
+          output.append(static_cast<char>(value));
+        }
+        continue;
+      }
+      case 's':
+      case 'S': {
+        if (size == 'w' || size == 'l' || conversion == 'S') {
+          const auto* str{va_arg(args, const wchar_t*)};
+          if (!str) {
+            output.append("(null)", 6);
+          } else {
+            output.append_wide(str, wide_length(str, precision));
+          }
+        } else {
+          const auto* str{va_arg(args, const char*)};
+          if (!str) {
+            str = "(null)";
+          }
+          output.append(str, precision < 0 ? strlen(str)
+                                           : strnlen(str, precision));
+        }
+        continue;
+      }
+      case 'Z': {
+        if (size == 'w') {
+          const auto* str{va_arg(args, PCUNICODE_STRING)};
+          if (str && str->Buffer) {
+            output.append_wide(str->Buffer, str->Length / sizeof(WCHAR));
+          } else {
+            output.append("(null)", 6);
+          }
+        } else {
+          const auto* str{va_arg(args, PCANSI_STRING)};
+          if (str && str->Buffer) {
+            output.append(str->Buffer, str->Length);
+          } else {
+            output.append("(null)", 6);
+          }
+        }
+        continue;
+      }
+      default:
+        output.append(spec_begin, static_cast<size_t>(fmt - spec_begin));
+        continue;
+    }
+    if (formatted_length > 0) {
+      const auto length{static_cast<size_t>(formatted_length)};
+      output.append(formatted, length < sizeof(formatted)
+                                   ? length
+                                   : sizeof(formatted) - 1);
+    }
+  }
+}
+
+ULONG print(const char* fmt, va_list args) noexcept {
+  output_buffer output;
+  format(output, fmt, args);
+  fwrite(output.data, 1, output.length, stderr);
+  fflush(stderr);
+  return static_cast<ULONG>(STATUS_SUCCESS);
+}
+}  // namespace
+
+void fatal_error(const char* fmt, ...) noexcept {
+  va_list args;
+  va_start(args, fmt);
+  print(fmt, args);
+  va_end(args);
+  abort();
+}
+}  // namespace hosted
+
+extern "C" {
+ULONG DbgPrint(PCSTR format, ...) {
+  va_list args;
+  va_start(args, format);
+  const ULONG result{hosted::print(format, args)};
+  va_end(args);
+  return result;
+}
+
+ULONG DbgPrintEx(ULONG, ULONG, PCSTR format, ...) {
+  va_list args;
+  va_start(args, format);
+  const ULONG result{hosted::print(format, args)};
+  va_end(args);
+  return result;
+}
+
+VOID DbgRaiseAssertionFailure() {
+  hosted::fatal_error("*** Assertion failure\n");
+}
+
+VOID KeBugCheck(ULONG bug_check_code) {
+  KeBugCheckEx(bug_check_code, 0, 0, 0, 0);
+}
+
+VOID KeBugCheckEx(ULONG bug_check_code,
+                  ULONG_PTR parameter1,
+                  ULONG_PTR parameter2,
+                  ULONG_PTR parameter3,
+                  ULONG_PTR parameter4) {
+  hosted::fatal_error(
+      "*** STOP: 0x%08X (0x%p, 0x%p, 0x%p, 0x%p)\n", bug_check_code,
+      reinterpret_cast<void*>(parameter1), reinterpret_cast<void*>(parameter2),
+      reinterpret_cast<void*>(parameter3), reinterpret_cast<void*>(parameter4));
+}
+
+NTSTATUS RtlGetVersion(PRTL_OSVERSIONINFOW version_info) {
+  // The kernel version of the host, such as 6.1.0 for Linux 6.1
+  ULONG version[3]{};
+  utsname name;
+  if (!uname(&name)) {
+    sscanf(name.release, "%u.%u.%u", &version[0], &version[1], &version[2]);
+  }
+  version_info->dwMajorVersion = version[0];
+  version_info->dwMinorVersion = version[1];
+  version_info->dwBuildNumber = version[2];
+  version_info->dwPlatformId = 2;  // VER_PLATFORM_WIN32_NT
+  version_info->szCSDVersion[0] = L'\0';
+  return STATUS_SUCCESS;
+}
+
+VOID RtlTimeToTimeFields(PLARGE_INTEGER time, PTIME_FIELDS time_fields) {
+  constexpr LONGLONG TICKS_PER_SECOND{10'000'000};
+  constexpr LONGLONG EPOCH_SHIFT{11'644'473'600};  // From 1601 to 1970
+  const auto seconds{
+      static_cast<time_t>(time->QuadPart / TICKS_PER_SECOND - EPOCH_SHIFT)};
+  tm fields;
+  gmtime_r(&seconds, &fields);
+  time_fields->Year = static_cast<SHORT>(fields.tm_year + 1900);
+  time_fields->Month = static_cast<SHORT>(fields.tm_mon + 1);
+  time_fields->Day = static_cast<SHORT>(fields.tm_mday);
+  time_fields->Hour = static_cast<SHORT>(fields.tm_hour);
+  time_fields->Minute = static_cast<SHORT>(fields.tm_min);
+  time_fields->Second = static_cast<SHORT>(fields.tm_sec);
+  time_fields->Milliseconds =
+      static_cast<SHORT>(time->QuadPart % TICKS_PER_SECOND / 10'000);
+  time_fields->Weekday = static_cast<SHORT>(fields.tm_wday);
+}
+
+VOID RtlInitUnicodeString(PUNICODE_STRING target, PCWSTR source) {
+  target->Buffer = const_cast<PWCH>(source);
+  if (!source) {
+    target->Length = 0;
+    target->MaximumLength = 0;
+  } else {
+    const size_t length{wcslen(source) * sizeof(WCHAR)};
+    target->Length = static_cast<USHORT>(length);
+    target->MaximumLength = static_cast<USHORT>(length + sizeof(WCHAR));
+  }
+}
+
+// The multibyte strings are UTF-8
+NTSTATUS RtlUnicodeToMultiByteN(PCHAR multibyte_string,
+                                ULONG max_bytes_in_multibyte_string,
+                                PULONG bytes_in_multibyte_string,
+                                PCWCH unicode_string,
+                                ULONG bytes_in_unicode_string) {
+  hosted::output_buffer encoded;
+  encoded.append_wide(unicode_string, bytes_in_unicode_string / sizeof(WCHAR));
+  ULONG length{static_cast<ULONG>(encoded.length)};
+  NTSTATUS status{STATUS_SUCCESS};
+  if (multibyte_string) {
+    if (length > max_bytes_in_multibyte_string) {
+      length = max_bytes_in_multibyte_string;
+      status = STATUS_BUFFER_OVERFLOW;
+    }
+    memcpy(multibyte_string, encoded.data, length);
+  }
+  if (bytes_in_multibyte_string) {
+    *bytes_in_multibyte_string = length;
+  }
+  return status;
+}
+
+NTSTATUS RtlUnicodeToMultiByteSize(PULONG bytes_in_multibyte_string,
+                                   PCWCH unicode_string,
+                                   ULONG bytes_in_unicode_string) {
+  return RtlUnicodeToMultiByteN(nullptr, 0, bytes_in_multibyte_string,
+                                unicode_string, bytes_in_unicode_string);
+}
+}  // extern "C"
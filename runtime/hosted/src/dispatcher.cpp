@@ -0,0 +1,497 @@
+#include "platform.hpp"
+
+#include <sched.h>
+#include <time.h>
+
+namespace hosted {
+namespace {
+pthread_mutex_t dispatcher_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_once_t dispatcher_initialized = PTHREAD_ONCE_INIT;
+pthread_cond_t dispatcher_condition;
+
+void initialize_dispatcher() noexcept {
+  pthread_condattr_t attributes;
+  pthread_condattr_init(&attributes);
+  pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+  pthread_cond_init(&dispatcher_condition, &attributes);
+  pthread_condattr_destroy(&attributes);
+}
+
+void initialize_header(DISPATCHER_HEADER& header,
+                       UCHAR type,
+                       LONG signal_state) noexcept {
+  header.Type = type;
+  header.SignalState = signal_state;
+  header.PulseCount = 0;
+  header.WaitListHead.Flink = &header.WaitListHead;
+  header.WaitListHead.Blink = &header.WaitListHead;
+}
+
+bool is_signaled(DISPATCHER_HEADER& header, PKTHREAD thread) noexcept {
+  if (header.Type == MutantObject) {
+    return header.SignalState > 0 ||
+           reinterpret_cast<PKMUTANT>(&header)->OwnerThread == thread;
+  }
+  return header.SignalState > 0;
+}
+
+// Applies the side effects of the satisfied wait
+void acquire_object(DISPATCHER_HEADER& header, PKTHREAD thread) noexcept {
+  switch (header.Type) {
+    case EventSynchronizationObject:
+      header.SignalState = 0;
+      break;
+    case MutantObject:
+      --header.SignalState;
+      reinterpret_cast<PKMUTANT>(&header)->OwnerThread = thread;
+      break;
+    case SemaphoreObject:
+      --header.SignalState;
+      break;
+    default:
+      break;
+  }
+}
+
+DISPATCHER_HEADER& get_header(PVOID object) noexcept {
+  return *static_cast<DISPATCHER_HEADER*>(object);
+}
+
+bool wait_for_signal(const timespec* deadline) noexcept {
+  if (!deadline) {
+    pthread_cond_wait(&dispatcher_condition, &dispatcher_lock);
+    return true;
+  }
+  return pthread_cond_timedwait(&dispatcher_condition, &dispatcher_lock,
+                                deadline) == 0;
+}
+
+void acquire_spin_lock(PKSPIN_LOCK spin_lock) noexcept {
+  while (__atomic_exchange_n(spin_lock, 1, __ATOMIC_ACQUIRE)) {
+    while (__atomic_load_n(spin_lock, __ATOMIC_RELAXED)) {
+      _mm_pause();
+    }
+  }
+}
+
+void release_spin_lock(PKSPIN_LOCK spin_lock) noexcept {
+  __atomic_store_n(spin_lock, 0, __ATOMIC_RELEASE);
+}
+}  // namespace
+
+void lock_dispatcher() noexcept {
+  pthread_once(&dispatcher_initialized, &initialize_dispatcher);
+  pthread_mutex_lock(&dispatcher_lock);
+}
+
+void unlock_dispatcher() noexcept {
+  pthread_mutex_unlock(&dispatcher_lock);
+}
+
+void signal_dispatcher() noexcept {
+  pthread_cond_broadcast(&dispatcher_condition);
+}
+}  // namespace hosted
+
+extern "C" {
+/*
+ * Dispatcher objects
+ */
+VOID KeInitializeEvent(PRKEVENT event, EVENT_TYPE type, BOOLEAN state) {
+  hosted::initialize_header(event->Header,
+                            type == NotificationEvent
+                                ? EventNotificationObject
+                                : EventSynchronizationObject,
+                            state ? 1 : 0);
+}
+
+LONG KeSetEvent(PRKEVENT event, KPRIORITY, BOOLEAN) {
+  hosted::lock_dispatcher();
+  const LONG previous_state{event->Header.SignalState};
+  event->Header.SignalState = 1;
+  hosted::signal_dispatcher();
+  hosted::unlock_dispatcher();
+  return previous_state;
+}
+
+LONG KeResetEvent(PRKEVENT event) {
+  hosted::lock_dispatcher();
+  const LONG previous_state{event->Header.SignalState};
+  event->Header.SignalState = 0;
+  hosted::unlock_dispatcher();
+  return previous_state;
+}
+
+VOID KeClearEvent(PRKEVENT event) {
+  KeResetEvent(event);
+}
+
+// Releases the current waiters and leaves the event non-signaled
+LONG KePulseEvent(PRKEVENT event, KPRIORITY, BOOLEAN) {
+  hosted::lock_dispatcher();
+  const LONG previous_state{event->Header.SignalState};
+  event->Header.SignalState = 0;
+  ++event->Header.PulseCount;
+  hosted::signal_dispatcher();
+  hosted::unlock_dispatcher();
+  return previous_state;
+}
+
+LONG KeReadStateEvent(PRKEVENT event) {
+  return __atomic_load_n(&event->Header.SignalState, __ATOMIC_ACQUIRE);
+}
+
+VOID KeInitializeMutex(PRKMUTEX mutex, ULONG) {
+  hosted::initialize_header(mutex->Header, MutantObject, 1);
+  mutex->OwnerThread = nullptr;
+}
+
+LONG KeReleaseMutex(PRKMUTEX mutex, BOOLEAN) {
+  PKTHREAD thread{hosted::get_current_thread()};
+  hosted::lock_dispatcher();
+  const LONG previous_state{mutex->Header.SignalState};
+  if (mutex->OwnerThread != thread) {
+    hosted::unlock_dispatcher();
+    KeBugCheckEx(KMODE_EXCEPTION_NOT_HANDLED,
+                 static_cast<ULONG>(STATUS_MUTANT_NOT_OWNED),
+                 reinterpret_cast<ULONG_PTR>(mutex), 0, 0);
+  }
+  if (++mutex->Header.SignalState == 1) {
+    mutex->OwnerThread = nullptr;
+    hosted::signal_dispatcher();
+  }
+  hosted::unlock_dispatcher();
+  return previous_state;
+}
+
+LONG KeReadStateMutex(PRKMUTEX mutex) {
+  return __atomic_load_n(&mutex->Header.SignalState, __ATOMIC_ACQUIRE);
+}
+
+VOID KeInitializeSemaphore(PRKSEMAPHORE semaphore, LONG count, LONG limit) {
+  hosted::initialize_header(semaphore->Header, SemaphoreObject, count);
+  semaphore->Limit = limit;
+}
+
+LONG KeReleaseSemaphore(PRKSEMAPHORE semaphore,
+                        KPRIORITY,
+                        LONG adjustment,
+                        BOOLEAN) {
+  hosted::lock_dispatcher();
+  const LONG previous_state{semaphore->Header.SignalState};
+  if (adjustment <= 0 || previous_state > semaphore->Limit - adjustment) {
+    hosted::unlock_dispatcher();
+    KeBugCheckEx(KMODE_EXCEPTION_NOT_HANDLED,
+                 static_cast<ULONG>(STATUS_SEMAPHORE_LIMIT_EXCEEDED),
+                 reinterpret_cast<ULONG_PTR>(semaphore), 0, 0);
+  }
+  semaphore->Header.SignalState += adjustment;
+  hosted::signal_dispatcher();
+  hosted::unlock_dispatcher();
+  return previous_state;
+}
+
+LONG KeReadStateSemaphore(PRKSEMAPHORE semaphore) {
+  return __atomic_load_n(&semaphore->Header.SignalState, __ATOMIC_ACQUIRE);
+}
+
+NTSTATUS KeWaitForSingleObject(PVOID object,
+                               KWAIT_REASON wait_reason,
+                               KPROCESSOR_MODE wait_mode,
+                               BOOLEAN alertable,
+                               PLARGE_INTEGER timeout) {
+  return KeWaitForMultipleObjects(1, &object, WaitAny, wait_reason, wait_mode,
+                                  alertable, timeout, nullptr);
+}
+
+NTSTATUS KeWaitForMultipleObjects(ULONG count,
+                                  PVOID object[],
+                                  WAIT_TYPE wait_type,
+                                  KWAIT_REASON,
+                                  KPROCESSOR_MODE,
+                                  BOOLEAN,
+                                  PLARGE_INTEGER timeout,
+                                  PKWAIT_BLOCK) {
+  using namespace hosted;
+
+  PKTHREAD thread{get_current_thread()};
+  const bool may_block{!timeout || timeout->QuadPart != 0};
+  if (thread->irql > DISPATCH_LEVEL ||
+      (thread->irql == DISPATCH_LEVEL && may_block)) {
+    KeBugCheckEx(IRQL_NOT_LESS_OR_EQUAL, thread->irql, 0, 0, 0);
+  }
+  timespec deadline;
+  if (timeout) {
+    get_deadline(timeout, deadline);
+  }
+  if (count > MAXIMUM_WAIT_OBJECTS) {
+    KeBugCheckEx(0x0000000C,  // MAXIMUM_WAIT_OBJECTS_EXCEEDED
+                 count, 0, 0, 0);
+  }
+  NTSTATUS status{STATUS_TIMEOUT};
+  LONG pulses[MAXIMUM_WAIT_OBJECTS];
+  lock_dispatcher();
+  for (ULONG idx = 0; idx < count; ++idx) {
+    pulses[idx] = get_header(object[idx]).PulseCount;
+  }
+  for (;;) {
+    if (wait_type == WaitAny) {
+      for (ULONG idx = 0; idx < count; ++idx) {
+        if (get_header(object[idx]).PulseCount != pulses[idx]) {
+          status = static_cast<NTSTATUS>(STATUS_WAIT_0 + idx);
+          break;
+        }
+        if (is_signaled(get_header(object[idx]), thread)) {
+          acquire_object(get_header(object[idx]), thread);
+          status = static_cast<NTSTATUS>(STATUS_WAIT_0 + idx);
+          break;
+        }
+      }
+    } else {
+      ULONG signaled{0};
+      while (signaled < count &&
+             is_signaled(get_header(object[signaled]), thread)) {
+        ++signaled;
+      }
+      if (signaled == count) {
+        for (ULONG idx = 0; idx < count; ++idx) {
+          acquire_object(get_header(object[idx]), thread);
+        }
+        status = STATUS_SUCCESS;
+      }
+    }
+    if (status != STATUS_TIMEOUT ||
+        !wait_for_signal(timeout ? &deadline : nullptr)) {
+      break;
+    }
+  }
+  unlock_dispatcher();
+  return status;
+}
+
+/*
+ * Spin locks
+ */
+VOID KeInitializeSpinLock(PKSPIN_LOCK spin_lock) {
+  *spin_lock = 0;
+}
+
+KIRQL KeAcquireSpinLockRaiseToDpc(PKSPIN_LOCK spin_lock) {
+  const KIRQL old_irql{KeRaiseIrqlToDpcLevel()};
+  hosted::acquire_spin_lock(spin_lock);
+  return old_irql;
+}
+
+VOID KeReleaseSpinLock(PKSPIN_LOCK spin_lock, KIRQL new_irql) {
+  hosted::release_spin_lock(spin_lock);
+  KeLowerIrql(new_irql);
+}
+
+VOID KeAcquireSpinLockAtDpcLevel(PKSPIN_LOCK spin_lock) {
+  hosted::acquire_spin_lock(spin_lock);
+}
+
+VOID KeReleaseSpinLockFromDpcLevel(PKSPIN_LOCK spin_lock) {
+  hosted::release_spin_lock(spin_lock);
+}
+
+BOOLEAN KeTryToAcquireSpinLockAtDpcLevel(PKSPIN_LOCK spin_lock) {
+  return !__atomic_exchange_n(spin_lock, 1, __ATOMIC_ACQUIRE);
+}
+
+VOID KeAcquireInStackQueuedSpinLock(PKSPIN_LOCK spin_lock,
+                                    PKLOCK_QUEUE_HANDLE lock_handle) {
+  lock_handle->OldIrql = KeAcquireSpinLockRaiseToDpc(spin_lock);
+  lock_handle->LockQueue.Lock = spin_lock;
+}
+
+VOID KeReleaseInStackQueuedSpinLock(PKLOCK_QUEUE_HANDLE lock_handle) {
+  KeReleaseSpinLock(lock_handle->LockQueue.Lock, lock_handle->OldIrql);
+}
+
+VOID KeAcquireInStackQueuedSpinLockAtDpcLevel(
+    PKSPIN_LOCK spin_lock,
+    PKLOCK_QUEUE_HANDLE lock_handle) {
+  hosted::acquire_spin_lock(spin_lock);
+  lock_handle->LockQueue.Lock = spin_lock;
+}
+
+VOID KeReleaseInStackQueuedSpinLockFromDpcLevel(
+    PKLOCK_QUEUE_HANDLE lock_handle) {
+  hosted::release_spin_lock(lock_handle->LockQueue.Lock);
+}
+
+/*
+ * Fast mutexes are built on the synchronization event as in the kernel
+ */
+VOID ExInitializeFastMutex(PFAST_MUTEX fast_mutex) {
+  fast_mutex->Count = 1;
+  fast_mutex->Owner = nullptr;
+  fast_mutex->Contention = 0;
+  KeInitializeEvent(&fast_mutex->Event, SynchronizationEvent, false);
+}
+
+VOID ExAcquireFastMutex(PFAST_MUTEX fast_mutex) {
+  KIRQL old_irql;
+  KeRaiseIrql(APC_LEVEL, &old_irql);
+  if (InterlockedDecrement(&fast_mutex->Count) != 0) {
+    ++fast_mutex->Contention;
+    KeWaitForSingleObject(&fast_mutex->Event, Executive, KernelMode, false,
+                          nullptr);
+  }
+  fast_mutex->Owner = KeGetCurrentThread();
+  fast_mutex->OldIrql = old_irql;
+}
+
+BOOLEAN ExTryToAcquireFastMutex(PFAST_MUTEX fast_mutex) {
+  KIRQL old_irql;
+  KeRaiseIrql(APC_LEVEL, &old_irql);
+  if (InterlockedCompareExchange(&fast_mutex->Count, 0, 1) != 1) {
+    KeLowerIrql(old_irql);
+    return false;
+  }
+  fast_mutex->Owner = KeGetCurrentThread();
+  fast_mutex->OldIrql = old_irql;
+  return true;
+}
+
+VOID ExReleaseFastMutex(PFAST_MUTEX fast_mutex) {
+  const auto old_irql{static_cast<KIRQL>(fast_mutex->OldIrql)};
+  fast_mutex->Owner = nullptr;
+  if (InterlockedIncrement(&fast_mutex->Count) != 1) {
+    KeSetEvent(&fast_mutex->Event, 0, false);
+  }
+  KeLowerIrql(old_irql);
+}
+
+/*
+ * Executive resources
+ */
+static_assert(sizeof(pthread_rwlock_t) <= sizeof(ERESOURCE));
+
+static pthread_rwlock_t* get_rwlock(PERESOURCE resource) noexcept {
+  return reinterpret_cast<pthread_rwlock_t*>(resource->Opaque);
+}
+
+NTSTATUS ExInitializeResourceLite(PERESOURCE resource) {
+  pthread_rwlock_init(get_rwlock(resource), nullptr);
+  return STATUS_SUCCESS;
+}
+
+NTSTATUS ExDeleteResourceLite(PERESOURCE resource) {
+  pthread_rwlock_destroy(get_rwlock(resource));
+  return STATUS_SUCCESS;
+}
+
+PVOID ExEnterCriticalRegionAndAcquireResourceExclusive(PERESOURCE resource) {
+  KeEnterCriticalRegion();
+  pthread_rwlock_wrlock(get_rwlock(resource));
+  return KeGetCurrentThread();
+}
+
+PVOID ExEnterCriticalRegionAndAcquireResourceShared(PERESOURCE resource) {
+  KeEnterCriticalRegion();
+  pthread_rwlock_rdlock(get_rwlock(resource));
+  return KeGetCurrentThread();
+}
+
+VOID ExReleaseResourceAndLeaveCriticalRegion(PERESOURCE resource) {
+  pthread_rwlock_unlock(get_rwlock(resource));
+  KeLeaveCriticalRegion();
+}
+
+/*
+ * Push locks. The lowest bit is the exclusive owner, the rest is the number
+ * of the shared owners
+ */
+VOID ExInitializePushLock(PEX_PUSH_LOCK push_lock) {
+  push_lock->Value = 0;
+}
+
+VOID ExAcquirePushLockExclusive(PEX_PUSH_LOCK push_lock) {
+  for (;;) {
+    ULONG_PTR expected{0};
+    if (__atomic_compare_exchange_n(&push_lock->Value, &expected, 1, false,
+                                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+      return;
+    }
+    sched_yield();
+  }
+}
+
+VOID ExAcquirePushLockShared(PEX_PUSH_LOCK push_lock) {
+  ULONG_PTR value{__atomic_load_n(&push_lock->Value, __ATOMIC_RELAXED)};
+  for (;;) {
+    if (value & 1) {
+      sched_yield();
+      value = __atomic_load_n(&push_lock->Value, __ATOMIC_RELAXED);
+    } else if (__atomic_compare_exchange_n(&push_lock->Value, &value,
+                                           value + 2, true, __ATOMIC_ACQUIRE,
+                                           __ATOMIC_RELAXED)) {
+      return;
+    }
+  }
+}
+
+VOID ExReleasePushLockExclusive(PEX_PUSH_LOCK push_lock) {
+  __atomic_store_n(&push_lock->Value, 0, __ATOMIC_RELEASE);
+}
+
+VOID ExReleasePushLockShared(PEX_PUSH_LOCK push_lock) {
+  __atomic_fetch_sub(&push_lock->Value, 2, __ATOMIC_RELEASE);
+}
+
+/*
+ * Sequenced lists are guarded by the lock in the header
+ */
+static void lock_slist(PSLIST_HEADER list_head) noexcept {
+  while (InterlockedExchange(&list_head->HeaderX64.Lock, 1)) {
+    _mm_pause();
+  }
+}
+
+static void unlock_slist(PSLIST_HEADER list_head) noexcept {
+  __atomic_store_n(&list_head->HeaderX64.Lock, 0, __ATOMIC_RELEASE);
+}
+
+VOID InitializeSListHead(PSLIST_HEADER list_head) {
+  list_head->HeaderX64.Next = nullptr;
+  list_head->HeaderX64.Lock = 0;
+  list_head->HeaderX64.Depth = 0;
+}
+
+PSLIST_ENTRY InterlockedPushEntrySList(PSLIST_HEADER list_head,
+                                       PSLIST_ENTRY list_entry) {
+  lock_slist(list_head);
+  PSLIST_ENTRY first{list_head->HeaderX64.Next};
+  list_entry->Next = first;
+  list_head->HeaderX64.Next = list_entry;
+  ++list_head->HeaderX64.Depth;
+  unlock_slist(list_head);
+  return first;
+}
+
+PSLIST_ENTRY InterlockedPopEntrySList(PSLIST_HEADER list_head) {
+  lock_slist(list_head);
+  PSLIST_ENTRY first{list_head->HeaderX64.Next};
+  if (first) {
+    list_head->HeaderX64.Next = first->Next;
+    --list_head->HeaderX64.Depth;
+  }
+  unlock_slist(list_head);
+  return first;
+}
+
+PSLIST_ENTRY InterlockedFlushSList(PSLIST_HEADER list_head) {
+  lock_slist(list_head);
+  PSLIST_ENTRY first{list_head->HeaderX64.Next};
+  list_head->HeaderX64.Next = nullptr;
+  list_head->HeaderX64.Depth = 0;
+  unlock_slist(list_head);
+  return first;
+}
+
+USHORT ExQueryDepthSList(PSLIST_HEADER list_head) {
+  return __atomic_load_n(&list_head->HeaderX64.Depth, __ATOMIC_RELAXED);
+}
+}  // extern "C"
@@ -0,0 +1,56 @@
+/*
+ * Entry point of the drivers built as the user-mode executables. The driver is
+ * loaded into the process, and unloaded before the exit if it has been loaded
+ * successfully. KTL_HOSTED_ENTRY_POINT is defined by wdk_add_driver()
+ */
+#include <ntddk.h>
+
+#include <sys/random.h>
+
+#ifndef KTL_HOSTED_ENTRY_POINT
+#define KTL_HOSTED_ENTRY_POINT DriverEntry
+#endif
+
+extern "C" NTSTATUS KTL_HOSTED_ENTRY_POINT(PDRIVER_OBJECT driver_object,
+                                          PUNICODE_STRING registry_path);
+
+// Initialized by the loader of the kernel images before the entry point
+extern "C" volatile uintptr_t __security_cookie;
+
+namespace {
+void init_security_cookie() noexcept {
+  uintptr_t cookie{0};
+  while (!cookie) {
+    if (getrandom(&cookie, sizeof(cookie), 0) != sizeof(cookie)) {
+      cookie = static_cast<uintptr_t>(__rdtsc());
+    }
+    cookie &= 0x0000FFFF'FFFFFFFFull;  // The same as the kernel loader does
+  }
+  __security_cookie = cookie;
+}
+
+wchar_t DRIVER_NAME[]{L"\\Driver\\KtlHosted"};
+wchar_t REGISTRY_PATH[]{
+    L"\\Registry\\Machine\\System\\CurrentControlSet\\Services\\KtlHosted"};
+}  // namespace
+
+int main() {
+  init_security_cookie();
+
+  static DRIVER_OBJECT driver_object;
+  driver_object.Size = sizeof(DRIVER_OBJECT);
+  RtlInitUnicodeString(&driver_object.DriverName, DRIVER_NAME);
+  UNICODE_STRING registry_path;
+  RtlInitUnicodeString(&registry_path, REGISTRY_PATH);
+
+  const NTSTATUS status{
+      KTL_HOSTED_ENTRY_POINT(&driver_object, &registry_path)};
+  if (!NT_SUCCESS(status)) {
+    DbgPrint("*** Driver initialization failed with status 0x%08X\n", status);
+    return 1;
+  }
+  if (driver_object.DriverUnload) {
+    driver_object.DriverUnload(&driver_object);
+  }
+  return 0;
+}
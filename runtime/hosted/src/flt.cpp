@@ -0,0 +1,89 @@
+#include "platform.hpp"
+
+#include <fltkernel.h>
+
+#include <stdlib.h>
+
+/*
+ * There is no Filter Manager in the user mode, so the filters can't be
+ * registered and the queries fail. The generic work items run on the system
+ * worker threads, so the offloading of the post-operations may be tested
+ */
+struct _FLT_GENERIC_WORKITEM {
+  WORK_QUEUE_ITEM item;
+  PVOID filter_object;
+  PFLT_GENERIC_WORKITEM_ROUTINE routine;
+  PVOID context;
+};
+
+namespace hosted {
+namespace {
+void run_generic_work_item(PVOID parameter) noexcept {
+  auto* item{static_cast<PFLT_GENERIC_WORKITEM>(parameter)};
+  item->routine(item, item->filter_object, item->context);
+}
+}  // namespace
+}  // namespace hosted
+
+extern "C" {
+NTSTATUS FltRegisterFilter(PDRIVER_OBJECT,
+                           const FLT_REGISTRATION*,
+                           PFLT_FILTER*) {
+  return STATUS_NOT_SUPPORTED;
+}
+
+NTSTATUS FltStartFiltering(PFLT_FILTER) {
+  return STATUS_NOT_SUPPORTED;
+}
+
+VOID FltUnregisterFilter(PFLT_FILTER) {}
+
+NTSTATUS FltGetFileNameInformation(PFLT_CALLBACK_DATA,
+                                   FLT_FILE_NAME_OPTIONS,
+                                   PFLT_FILE_NAME_INFORMATION*) {
+  return STATUS_NOT_SUPPORTED;
+}
+
+NTSTATUS FltParseFileNameInformation(PFLT_FILE_NAME_INFORMATION) {
+  return STATUS_NOT_SUPPORTED;
+}
+
+VOID FltReleaseFileNameInformation(PFLT_FILE_NAME_INFORMATION) {}
+
+NTSTATUS FltIsDirectory(PFILE_OBJECT, PFLT_INSTANCE, PBOOLEAN) {
+  return STATUS_NOT_SUPPORTED;
+}
+
+NTSTATUS FltQueryInformationFile(PFLT_INSTANCE,
+                                 PFILE_OBJECT,
+                                 PVOID,
+                                 ULONG,
+                                 FILE_INFORMATION_CLASS,
+                                 PULONG) {
+  return STATUS_NOT_SUPPORTED;
+}
+
+PFLT_GENERIC_WORKITEM FltAllocateGenericWorkItem() {
+  return static_cast<PFLT_GENERIC_WORKITEM>(
+      calloc(1, sizeof(_FLT_GENERIC_WORKITEM)));
+}
+
+VOID FltFreeGenericWorkItem(PFLT_GENERIC_WORKITEM item) {
+  free(item);
+}
+
+NTSTATUS FltQueueGenericWorkItem(PFLT_GENERIC_WORKITEM item,
+                                 PVOID filter_object,
+                                 PFLT_GENERIC_WORKITEM_ROUTINE routine,
+                                 WORK_QUEUE_TYPE queue_type,
+                                 PVOID context) {
+  item->filter_object = filter_object;
+  item->routine = routine;
+  item->context = context;
+  ExInitializeWorkItem(&item->item, &hosted::run_generic_work_item, item);
+  ExQueueWorkItem(&item->item, queue_type);
+  return STATUS_SUCCESS;
+}
+
+VOID FltCompletePendedPostOperation(PFLT_CALLBACK_DATA) {}
+}  // extern "C"
@@ -0,0 +1,919 @@
+#include "platform.hpp"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace hosted {
+namespace {
+/*
+ * Files. The NT paths are mapped into the directory named by the
+ * KTL_HOSTED_ROOT environment variable, e.g. \SystemRoot\Temp\file.tmp is
+ * $KTL_HOSTED_ROOT/SystemRoot/Temp/file.tmp
+ */
+constexpr const char* DEFAULT_ROOT{"/tmp/ktl_hosted"};
+constexpr CSHORT IO_TYPE_FILE{5};
+constexpr CSHORT IO_TYPE_IRP{6};
+
+struct file_object {
+  FILE_OBJECT header;  // Must be the first member
+  int fd;
+  char* delete_path;  // Unlinked on the last close if not null
+};
+
+using host_path = char[PATH_MAX];
+
+NTSTATUS to_status(int error) noexcept {
+  switch (error) {
+    case ENOENT:
+      return STATUS_OBJECT_NAME_NOT_FOUND;
+    case ENOTDIR:
+      return STATUS_OBJECT_PATH_NOT_FOUND;
+    case EEXIST:
+      return STATUS_OBJECT_NAME_COLLISION;
+    case EACCES:
+    case EPERM:
+    case EROFS:
+      return STATUS_ACCESS_DENIED;
+    case EISDIR:
+      return STATUS_FILE_IS_A_DIRECTORY;
+    case ENOSPC:
+      return STATUS_DISK_FULL;
+    case ENOMEM:
+    case EMFILE:
+    case ENFILE:
+      return STATUS_INSUFFICIENT_RESOURCES;
+    case ENAMETOOLONG:
+      return STATUS_OBJECT_NAME_INVALID;
+    case EBADF:
+      return STATUS_INVALID_HANDLE;
+    case EINVAL:
+      return STATUS_INVALID_PARAMETER;
+    default:
+      return STATUS_UNSUCCESSFUL;
+  }
+}
+
+bool append_utf8(host_path& path, size_t& length, wchar_t ch) noexcept {
+  char bytes[4];
+  size_t count;
+  const auto code{static_cast<uint32_t>(ch)};
+  if (code < 0x80) {
+    bytes[0] = static_cast<char>(code);
+    count = 1;
+  } else if (code < 0x800) {
+    bytes[0] = static_cast<char>(0xC0 | (code >> 6));
+    bytes[1] = static_cast<char>(0x80 | (code & 0x3F));
+    count = 2;
+  } else if (code < 0x10000) {
+    bytes[0] = static_cast<char>(0xE0 | (code >> 12));
+    bytes[1] = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+    bytes[2] = static_cast<char>(0x80 | (code & 0x3F));
+    count = 3;
+  } else {
+    bytes[0] = static_cast<char>(0xF0 | (code >> 18));
+    bytes[1] = static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+    bytes[2] = static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+    bytes[3] = static_cast<char>(0x80 | (code & 0x3F));
+    count = 4;
+  }
+  if (length + count >= sizeof(host_path)) {
+    return false;
+  }
+  memcpy(path + length, bytes, count);
+  length += count;
+  return true;
+}
+
+NTSTATUS to_host_path(POBJECT_ATTRIBUTES attributes,
+                      host_path& path) noexcept {
+  if (!attributes || !attributes->ObjectName ||
+      !attributes->ObjectName->Length) {
+    return STATUS_OBJECT_NAME_INVALID;
+  }
+  const char* root{getenv("KTL_HOSTED_ROOT")};
+  if (!root || !*root) {
+    root = DEFAULT_ROOT;
+  }
+  size_t length{strlen(root)};
+  if (length >= sizeof(host_path)) {
+    return STATUS_OBJECT_NAME_INVALID;
+  }
+  memcpy(path, root, length);
+
+  const UNICODE_STRING& name{*attributes->ObjectName};
+  const size_t name_length{name.Length / sizeof(WCHAR)};
+  if (name.Buffer[0] != L'\\') {
+    return STATUS_OBJECT_PATH_NOT_FOUND;  // Relative names aren't supported
+  }
+  for (size_t idx = 0; idx < name_length; ++idx) {
+    const wchar_t ch{name.Buffer[idx]};
+    if (!ch || ch == L'/' ||
+        !append_utf8(path, length, ch == L'\\' ? L'/' : ch)) {
+      return STATUS_OBJECT_NAME_INVALID;
+    }
+  }
+  path[length] = '\0';
+  return STATUS_SUCCESS;
+}
+
+// Creates the missing directories of the path, the errors are reported by
+// open() later
+void create_parent_directories(host_path& path) noexcept {
+  for (char* cur = path + 1; *cur; ++cur) {
+    if (*cur == '/') {
+      *cur = '\0';
+      mkdir(path, 0755);
+      *cur = '/';
+    }
+  }
+}
+
+void close_file(void* body) noexcept {
+  auto* file{static_cast<file_object*>(body)};
+  close(file->fd);
+  if (file->delete_path) {
+    unlink(file->delete_path);
+    free(file->delete_path);
+  }
+}
+
+NTSTATUS reference_file(HANDLE handle, file_object*& file) noexcept {
+  return ObReferenceObjectByHandle(handle, 0, file_type, KernelMode,
+                                   reinterpret_cast<PVOID*>(&file), nullptr);
+}
+
+int get_open_flags(ULONG disposition) noexcept {
+  switch (disposition) {
+    case FILE_SUPERSEDE:
+    case FILE_OVERWRITE_IF:
+      return O_CREAT | O_TRUNC;
+    case FILE_OPEN:
+      return 0;
+    case FILE_CREATE:
+      return O_CREAT | O_EXCL;
+    case FILE_OPEN_IF:
+      return O_CREAT;
+    case FILE_OVERWRITE:
+      return O_TRUNC;
+    default:
+      return -1;
+  }
+}
+
+ULONG_PTR get_create_information(ULONG disposition, bool existed) noexcept {
+  if (!existed) {
+    return FILE_CREATED;
+  }
+  switch (disposition) {
+    case FILE_SUPERSEDE:
+      return FILE_SUPERSEDED;
+    case FILE_OVERWRITE:
+    case FILE_OVERWRITE_IF:
+      return FILE_OVERWRITTEN;
+    default:
+      return FILE_OPENED;
+  }
+}
+
+LONGLONG get_file_offset(file_object& file,
+                         PLARGE_INTEGER byte_offset) noexcept {
+  if (!byte_offset || (byte_offset->LowPart == FILE_USE_FILE_POINTER_POSITION &&
+                       byte_offset->HighPart == -1)) {
+    return file.header.CurrentByteOffset.QuadPart;
+  }
+  return byte_offset->QuadPart;
+}
+
+// The I/O is synchronous, the event and the APC are completed at once
+NTSTATUS transfer(HANDLE file_handle,
+                  HANDLE event,
+                  PIO_STATUS_BLOCK io_status_block,
+                  PVOID buffer,
+                  ULONG length,
+                  PLARGE_INTEGER byte_offset,
+                  bool write) noexcept {
+  file_object* file;
+  NTSTATUS status{reference_file(file_handle, file)};
+  if (!NT_SUCCESS(status)) {
+    return status;
+  }
+  const LONGLONG offset{get_file_offset(*file, byte_offset)};
+  const ssize_t transferred{
+      write ? pwrite(file->fd, buffer, length, offset)
+            : pread(file->fd, buffer, length, offset)};
+  if (transferred < 0) {
+    status = to_status(errno);
+  } else if (!write && !transferred && length) {
+    status = STATUS_END_OF_FILE;
+  } else {
+    file->header.CurrentByteOffset.QuadPart = offset + transferred;
+  }
+  io_status_block->Status = status;
+  io_status_block->Information =
+      transferred > 0 ? static_cast<ULONG_PTR>(transferred) : 0;
+  ObfDereferenceObject(file);
+
+  if (event) {
+    PKEVENT target;
+    if (NT_SUCCESS(ObReferenceObjectByHandle(
+            event, EVENT_MODIFY_STATE, event_type, KernelMode,
+            reinterpret_cast<PVOID*>(&target), nullptr))) {
+      KeSetEvent(target, IO_NO_INCREMENT, false);
+      ObfDereferenceObject(target);
+    }
+  }
+  return status;
+}
+
+/*
+ * Sections. The pagefile-backed sections are anonymous memory files, the
+ * views of all sections are shared mappings
+ */
+struct section_object {
+  int fd;
+  LONGLONG size;
+  bool writable;
+};
+
+constexpr size_t MAX_VIEW_COUNT{4096};
+
+struct mapped_view {
+  void* base;
+  size_t size;
+};
+
+pthread_mutex_t view_table_lock = PTHREAD_MUTEX_INITIALIZER;
+mapped_view view_table[MAX_VIEW_COUNT];
+
+void close_section(void* body) noexcept {
+  close(static_cast<section_object*>(body)->fd);
+}
+
+NTSTATUS map_view(section_object& section,
+                  LONGLONG offset,
+                  PSIZE_T view_size,
+                  PVOID* base_address,
+                  bool writable) noexcept {
+  if (offset < 0 || offset >= section.size || offset % PAGE_SIZE) {
+    return STATUS_INVALID_PARAMETER;
+  }
+  if (writable && !section.writable) {
+    return STATUS_ACCESS_DENIED;
+  }
+  SIZE_T size{*view_size};
+  if (!size) {
+    size = static_cast<SIZE_T>(section.size - offset);
+  } else if (size > static_cast<SIZE_T>(section.size - offset)) {
+    return STATUS_INVALID_PARAMETER;
+  }
+  void* base{mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                  MAP_SHARED, section.fd, offset)};
+  if (base == MAP_FAILED) {
+    return to_status(errno);
+  }
+  pthread_mutex_lock(&view_table_lock);
+  for (auto& view : view_table) {
+    if (!view.base) {
+      view = {base, size};
+      pthread_mutex_unlock(&view_table_lock);
+      *base_address = base;
+      *view_size = size;
+      return STATUS_SUCCESS;
+    }
+  }
+  pthread_mutex_unlock(&view_table_lock);
+  munmap(base, size);
+  return STATUS_INSUFFICIENT_RESOURCES;
+}
+
+NTSTATUS unmap_view(PVOID base) noexcept {
+  pthread_mutex_lock(&view_table_lock);
+  for (auto& view : view_table) {
+    if (view.base == base) {
+      const mapped_view target{view};
+      view = {};
+      pthread_mutex_unlock(&view_table_lock);
+      munmap(target.base, target.size);
+      return STATUS_SUCCESS;
+    }
+  }
+  pthread_mutex_unlock(&view_table_lock);
+  return STATUS_NOT_MAPPED_VIEW;
+}
+
+/*
+ * File system. The files are owned by the single device whose driver
+ * completes the read and write IRPs from the system worker threads, so the
+ * asynchronous I/O goes through the same path as on Windows
+ */
+pthread_once_t file_system_created = PTHREAD_ONCE_INIT;
+DRIVER_OBJECT file_system_driver;
+DEVICE_OBJECT file_system_device;
+
+struct io_work_item {
+  WORK_QUEUE_ITEM item;
+  PIRP irp;
+};
+
+void complete_read_write(PVOID context) noexcept {
+  auto* work_item{static_cast<io_work_item*>(context)};
+  PIRP irp{work_item->irp};
+  free(work_item);
+
+  PIO_STACK_LOCATION stack{IoGetCurrentIrpStackLocation(irp)};
+  auto* file{static_cast<file_object*>(stack->FileObject->FsContext)};
+  PVOID buffer{irp->MdlAddress ? MmGetSystemAddressForMdlSafe(
+                                     irp->MdlAddress, NormalPagePriority)
+                               : irp->UserBuffer};
+  const bool write{stack->MajorFunction == IRP_MJ_WRITE};
+  const ULONG length{write ? stack->Parameters.Write.Length
+                           : stack->Parameters.Read.Length};
+  const LONGLONG offset{write ? stack->Parameters.Write.ByteOffset.QuadPart
+                              : stack->Parameters.Read.ByteOffset.QuadPart};
+  const ssize_t transferred{
+      write ? pwrite(file->fd, buffer, length, offset)
+            : pread(file->fd, buffer, length, offset)};
+  if (transferred < 0) {
+    irp->IoStatus.Status = to_status(errno);
+    irp->IoStatus.Information = 0;
+  } else {
+    irp->IoStatus.Status =
+        !write && !transferred && length ? STATUS_END_OF_FILE : STATUS_SUCCESS;
+    irp->IoStatus.Information = static_cast<ULONG_PTR>(transferred);
+  }
+  IoCompleteRequest(irp, IO_NO_INCREMENT);
+}
+
+NTSTATUS dispatch_read_write(PDEVICE_OBJECT, PIRP irp) noexcept {
+  auto* work_item{static_cast<io_work_item*>(malloc(sizeof(io_work_item)))};
+  if (!work_item) {
+    irp->IoStatus.Status = STATUS_INSUFFICIENT_RESOURCES;
+    irp->IoStatus.Information = 0;
+    IoCompleteRequest(irp, IO_NO_INCREMENT);
+    return STATUS_INSUFFICIENT_RESOURCES;
+  }
+  work_item->irp = irp;
+  IoMarkIrpPending(irp);
+  ExInitializeWorkItem(&work_item->item, &complete_read_write, work_item);
+  ExQueueWorkItem(&work_item->item, DelayedWorkQueue);
+  return STATUS_PENDING;
+}
+
+NTSTATUS dispatch_invalid_request(PDEVICE_OBJECT, PIRP irp) noexcept {
+  irp->IoStatus.Status = STATUS_INVALID_DEVICE_REQUEST;
+  irp->IoStatus.Information = 0;
+  IoCompleteRequest(irp, IO_NO_INCREMENT);
+  return STATUS_INVALID_DEVICE_REQUEST;
+}
+
+void create_file_system() noexcept {
+  for (auto& routine : file_system_driver.MajorFunction) {
+    routine = &dispatch_invalid_request;
+  }
+  file_system_driver.MajorFunction[IRP_MJ_READ] = &dispatch_read_write;
+  file_system_driver.MajorFunction[IRP_MJ_WRITE] = &dispatch_read_write;
+  file_system_driver.DeviceObject = &file_system_device;
+
+  file_system_device.Size = sizeof(DEVICE_OBJECT);
+  file_system_device.DriverObject = &file_system_driver;
+  file_system_device.DeviceType = FILE_DEVICE_DISK_FILE_SYSTEM;
+  file_system_device.StackSize = 1;
+}
+
+/*
+ * Named events
+ */
+struct named_event {
+  named_event* next;
+  PKEVENT event;
+  USHORT length;
+  WCHAR name[1];
+};
+
+pthread_mutex_t named_events_lock = PTHREAD_MUTEX_INITIALIZER;
+named_event* named_events;
+
+bool equals(const named_event& entry, const UNICODE_STRING& name) noexcept {
+  return entry.length == name.Length &&
+         !memcmp(entry.name, name.Buffer, name.Length);
+}
+}  // namespace
+
+PDEVICE_OBJECT get_file_system_device() noexcept {
+  pthread_once(&file_system_created, &create_file_system);
+  return &file_system_device;
+}
+}  // namespace hosted
+
+extern "C" {
+NTSTATUS ZwCreateFile(PHANDLE file_handle,
+                      ACCESS_MASK desired_access,
+                      POBJECT_ATTRIBUTES object_attributes,
+                      PIO_STATUS_BLOCK io_status_block,
+                      PLARGE_INTEGER,
+                      ULONG,
+                      ULONG share_access,
+                      ULONG create_disposition,
+                      ULONG create_options,
+                      PVOID,
+                      ULONG) {
+  using namespace hosted;
+
+  io_status_block->Information = 0;
+  if (create_options & FILE_DIRECTORY_FILE) {
+    return io_status_block->Status = STATUS_NOT_SUPPORTED;
+  }
+  const int disposition_flags{get_open_flags(create_disposition)};
+  if (disposition_flags < 0) {
+    return io_status_block->Status = STATUS_INVALID_PARAMETER;
+  }
+  host_path path;
+  NTSTATUS status{to_host_path(object_attributes, path)};
+  if (!NT_SUCCESS(status)) {
+    return io_status_block->Status = status;
+  }
+  if (disposition_flags & O_CREAT) {
+    create_parent_directories(path);
+  }
+  // The files are opened for reading as well, so they may be mapped
+  constexpr ACCESS_MASK WRITE_ACCESS{FILE_WRITE_DATA | FILE_APPEND_DATA |
+                                     GENERIC_WRITE | GENERIC_ALL};
+  const bool writable{(desired_access & WRITE_ACCESS) != 0};
+  struct stat info;
+  const bool existed{stat(path, &info) == 0};
+  const int fd{open(path,
+                    (writable ? O_RDWR : O_RDONLY) | disposition_flags |
+                        O_CLOEXEC,
+                    0644)};
+  if (fd < 0) {
+    return io_status_block->Status = to_status(errno);
+  }
+  if (fstat(fd, &info) || S_ISDIR(info.st_mode)) {
+    close(fd);
+    return io_status_block->Status = STATUS_FILE_IS_A_DIRECTORY;
+  }
+
+  auto* file{static_cast<file_object*>(
+      allocate_object(sizeof(file_object), file_type, &close_file))};
+  if (!file) {
+    close(fd);
+    return io_status_block->Status = STATUS_INSUFFICIENT_RESOURCES;
+  }
+  file->fd = fd;
+  if (create_options & FILE_DELETE_ON_CLOSE) {
+    file->delete_path = strdup(path);
+    if (!file->delete_path) {
+      ObfDereferenceObject(file);
+      return io_status_block->Status = STATUS_INSUFFICIENT_RESOURCES;
+    }
+  }
+  FILE_OBJECT& header{file->header};
+  header.Type = IO_TYPE_FILE;
+  header.Size = sizeof(FILE_OBJECT);
+  header.DeviceObject = get_file_system_device();
+  header.FsContext = file;
+  header.ReadAccess = !writable || (desired_access & FILE_READ_DATA);
+  header.WriteAccess = writable;
+  header.DeleteAccess = (desired_access & DELETE) != 0;
+  header.SharedRead = (share_access & FILE_SHARE_READ) != 0;
+  header.SharedWrite = (share_access & FILE_SHARE_WRITE) != 0;
+  header.SharedDelete = (share_access & FILE_SHARE_DELETE) != 0;
+
+  status = insert_handle(file, file_handle);
+  if (!NT_SUCCESS(status)) {
+    ObfDereferenceObject(file);
+    return io_status_block->Status = status;
+  }
+  io_status_block->Information =
+      get_create_information(create_disposition, existed);
+  return io_status_block->Status = STATUS_SUCCESS;
+}
+
+NTSTATUS ZwReadFile(HANDLE file_handle,
+                    HANDLE event,
+                    PIO_APC_ROUTINE,
+                    PVOID,
+                    PIO_STATUS_BLOCK io_status_block,
+                    PVOID buffer,
+                    ULONG length,
+                    PLARGE_INTEGER byte_offset,
+                    PULONG) {
+  return hosted::transfer(file_handle, event, io_status_block, buffer, length,
+                          byte_offset, false);
+}
+
+NTSTATUS ZwWriteFile(HANDLE file_handle,
+                     HANDLE event,
+                     PIO_APC_ROUTINE,
+                     PVOID,
+                     PIO_STATUS_BLOCK io_status_block,
+                     PVOID buffer,
+                     ULONG length,
+                     PLARGE_INTEGER byte_offset,
+                     PULONG) {
+  return hosted::transfer(file_handle, event, io_status_block, buffer, length,
+                          byte_offset, true);
+}
+
+NTSTATUS ZwQueryInformationFile(HANDLE file_handle,
+                                PIO_STATUS_BLOCK io_status_block,
+                                PVOID file_information,
+                                ULONG length,
+                                FILE_INFORMATION_CLASS file_information_class) {
+  using namespace hosted;
+
+  file_object* file;
+  NTSTATUS status{reference_file(file_handle, file)};
+  if (!NT_SUCCESS(status)) {
+    return status;
+  }
+  struct stat info;
+  ULONG_PTR written{0};
+  if (fstat(file->fd, &info)) {
+    status = to_status(errno);
+  } else if (file_information_class == FileStandardInformation) {
+    if (length < sizeof(FILE_STANDARD_INFORMATION)) {
+      status = STATUS_INFO_LENGTH_MISMATCH;
+    } else {
+      auto* standard{
+          static_cast<PFILE_STANDARD_INFORMATION>(file_information)};
+      standard->AllocationSize.QuadPart =
+          static_cast<LONGLONG>(info.st_blocks) * 512;
+      standard->EndOfFile.QuadPart = static_cast<LONGLONG>(info.st_size);
+      standard->NumberOfLinks = static_cast<ULONG>(info.st_nlink);
+      standard->DeletePending = file->delete_path != nullptr;
+      standard->Directory = S_ISDIR(info.st_mode);
+      written = sizeof(FILE_STANDARD_INFORMATION);
+    }
+  } else if (file_information_class == FileInternalInformation) {
+    if (length < sizeof(FILE_INTERNAL_INFORMATION)) {
+      status = STATUS_INFO_LENGTH_MISMATCH;
+    } else {
+      static_cast<PFILE_INTERNAL_INFORMATION>(file_information)
+          ->IndexNumber.QuadPart = static_cast<LONGLONG>(info.st_ino);
+      written = sizeof(FILE_INTERNAL_INFORMATION);
+    }
+  } else if (file_information_class == FilePositionInformation) {
+    if (length < sizeof(FILE_POSITION_INFORMATION)) {
+      status = STATUS_INFO_LENGTH_MISMATCH;
+    } else {
+      static_cast<PFILE_POSITION_INFORMATION>(file_information)
+          ->CurrentByteOffset = file->header.CurrentByteOffset;
+      written = sizeof(FILE_POSITION_INFORMATION);
+    }
+  } else {
+    status = STATUS_INVALID_INFO_CLASS;
+  }
+  ObfDereferenceObject(file);
+  io_status_block->Status = status;
+  io_status_block->Information = written;
+  return status;
+}
+
+NTSTATUS ZwDeleteFile(POBJECT_ATTRIBUTES object_attributes) {
+  hosted::host_path path;
+  const NTSTATUS status{hosted::to_host_path(object_attributes, path)};
+  if (!NT_SUCCESS(status)) {
+    return status;
+  }
+  return unlink(path) ? hosted::to_status(errno) : STATUS_SUCCESS;
+}
+
+NTSTATUS ZwCreateSection(PHANDLE section_handle,
+                         ACCESS_MASK,
+                         POBJECT_ATTRIBUTES,
+                         PLARGE_INTEGER maximum_size,
+                         ULONG section_page_protection,
+                         ULONG,
+                         HANDLE file_handle) {
+  using namespace hosted;
+
+  const bool writable{section_page_protection == PAGE_READWRITE};
+  if (!writable && section_page_protection != PAGE_READONLY) {
+    return STATUS_NOT_SUPPORTED;
+  }
+  int fd;
+  LONGLONG size;
+  if (file_handle) {
+    file_object* file;
+    NTSTATUS status{reference_file(file_handle, file)};
+    if (!NT_SUCCESS(status)) {
+      return status;
+    }
+    struct stat info;
+    fd = fstat(file->fd, &info) ? -1 : fcntl(file->fd, F_DUPFD_CLOEXEC, 0);
+    ObfDereferenceObject(file);
+    if (fd < 0) {
+      return to_status(errno);
+    }
+    size = static_cast<LONGLONG>(info.st_size);
+    if (maximum_size && maximum_size->QuadPart > size) {
+      // The file is extended as by the kernel
+      if (!writable || ftruncate(fd, maximum_size->QuadPart)) {
+        close(fd);
+        return writable ? to_status(errno) : STATUS_INVALID_PARAMETER;
+      }
+      size = maximum_size->QuadPart;
+    }
+    if (!size) {
+      close(fd);
+      return STATUS_MAPPED_FILE_SIZE_ZERO;
+    }
+  } else {
+    if (!maximum_size || maximum_size->QuadPart <= 0) {
+      return STATUS_INVALID_PARAMETER;
+    }
+    size = maximum_size->QuadPart;
+    fd = memfd_create("ktl_section", MFD_CLOEXEC);
+    if (fd < 0 || ftruncate(fd, size)) {
+      const NTSTATUS status{to_status(errno)};
+      if (fd >= 0) {
+        close(fd);
+      }
+      return status;
+    }
+  }
+
+  auto* section{static_cast<section_object*>(
+      allocate_object(sizeof(section_object), section_type, &close_section))};
+  if (!section) {
+    close(fd);
+    return STATUS_INSUFFICIENT_RESOURCES;
+  }
+  *section = {fd, size, writable};
+  const NTSTATUS status{insert_handle(section, section_handle)};
+  if (!NT_SUCCESS(status)) {
+    ObfDereferenceObject(section);
+  }
+  return status;
+}
+
+NTSTATUS ZwMapViewOfSection(HANDLE section_handle,
+                            HANDLE,
+                            PVOID* base_address,
+                            ULONG_PTR,
+                            SIZE_T,
+                            PLARGE_INTEGER section_offset,
+                            PSIZE_T view_size,
+                            SECTION_INHERIT,
+                            ULONG,
+                            ULONG win32_protect) {
+  using namespace hosted;
+
+  section_object* section;
+  NTSTATUS status{ObReferenceObjectByHandle(
+      section_handle, SECTION_MAP_READ, section_type, KernelMode,
+      reinterpret_cast<PVOID*>(&section), nullptr)};
+  if (!NT_SUCCESS(status)) {
+    return status;
+  }
+  status = map_view(*section, section_offset ? section_offset->QuadPart : 0,
+                    view_size, base_address, win32_protect == PAGE_READWRITE);
+  ObfDereferenceObject(section);
+  return status;
+}
+
+NTSTATUS ZwUnmapViewOfSection(HANDLE, PVOID base_address) {
+  return hosted::unmap_view(base_address);
+}
+
+NTSTATUS MmMapViewInSystemSpace(PVOID section,
+                                PVOID* mapped_base,
+                                PSIZE_T view_size) {
+  using namespace hosted;
+
+  if (get_object_type(section) != section_type) {
+    return STATUS_OBJECT_TYPE_MISMATCH;
+  }
+  auto& target{*static_cast<section_object*>(section)};
+  return map_view(target, 0, view_size, mapped_base, target.writable);
+}
+
+NTSTATUS MmUnmapViewInSystemSpace(PVOID mapped_base) {
+  return hosted::unmap_view(mapped_base);
+}
+
+NTSTATUS ZwSetInformationVirtualMemory(
+    HANDLE,
+    VIRTUAL_MEMORY_INFORMATION_CLASS information_class,
+    ULONG_PTR number_of_entries,
+    PMEMORY_RANGE_ENTRY virtual_addresses,
+    PVOID,
+    ULONG) {
+  if (information_class != VmPrefetchInformation) {
+    return STATUS_INVALID_INFO_CLASS;
+  }
+  for (ULONG_PTR idx = 0; idx < number_of_entries; ++idx) {
+    const MEMORY_RANGE_ENTRY& range{virtual_addresses[idx]};
+    PVOID start{PAGE_ALIGN(range.VirtualAddress)};
+    const SIZE_T size{BYTE_OFFSET(range.VirtualAddress) + range.NumberOfBytes};
+    madvise(start, size, MADV_WILLNEED);
+  }
+  return STATUS_SUCCESS;
+}
+
+/*
+ * The views of the MDLs are the buffers themselves since the system and the
+ * user address spaces are the same
+ */
+PMDL IoAllocateMdl(PVOID virtual_address,
+                   ULONG length,
+                   BOOLEAN secondary_buffer,
+                   BOOLEAN,
+                   PIRP irp) {
+  auto* mdl{static_cast<PMDL>(calloc(1, sizeof(MDL)))};
+  if (!mdl) {
+    return nullptr;
+  }
+  mdl->Size = sizeof(MDL);
+  mdl->StartVa = PAGE_ALIGN(virtual_address);
+  mdl->ByteOffset = BYTE_OFFSET(virtual_address);
+  mdl->ByteCount = length;
+  if (irp) {
+    if (secondary_buffer && irp->MdlAddress) {
+      PMDL tail{irp->MdlAddress};
+      while (tail->Next) {
+        tail = tail->Next;
+      }
+      tail->Next = mdl;
+    } else {
+      irp->MdlAddress = mdl;
+    }
+  }
+  return mdl;
+}
+
+VOID IoFreeMdl(PMDL mdl) {
+  free(mdl);
+}
+
+VOID IoBuildPartialMdl(PMDL source_mdl,
+                       PMDL target_mdl,
+                       PVOID virtual_address,
+                       ULONG length) {
+  if (!length) {
+    const auto* source_end{static_cast<PUCHAR>(
+                               MmGetMdlVirtualAddress(source_mdl)) +
+                           source_mdl->ByteCount};
+    length = static_cast<ULONG>(source_end -
+                                static_cast<PUCHAR>(virtual_address));
+  }
+  target_mdl->StartVa = PAGE_ALIGN(virtual_address);
+  target_mdl->ByteOffset = BYTE_OFFSET(virtual_address);
+  target_mdl->ByteCount = length;
+  target_mdl->MdlFlags = static_cast<CSHORT>(
+      MDL_PARTIAL | (source_mdl->MdlFlags & MDL_SOURCE_IS_NONPAGED_POOL));
+  target_mdl->MappedSystemVa = virtual_address;
+}
+
+VOID MmBuildMdlForNonPagedPool(PMDL mdl) {
+  mdl->MdlFlags |= MDL_SOURCE_IS_NONPAGED_POOL;
+  mdl->MappedSystemVa = MmGetMdlVirtualAddress(mdl);
+}
+
+VOID MmProbeAndLockPages(PMDL mdl, KPROCESSOR_MODE, LOCK_OPERATION) {
+  mdl->MdlFlags |= MDL_PAGES_LOCKED;
+}
+
+VOID MmUnlockPages(PMDL mdl) {
+  mdl->MdlFlags &= ~(MDL_PAGES_LOCKED | MDL_MAPPED_TO_SYSTEM_VA);
+}
+
+PVOID MmGetSystemAddressForMdlSafe(PMDL mdl, ULONG) {
+  if (!(mdl->MdlFlags &
+        (MDL_MAPPED_TO_SYSTEM_VA | MDL_SOURCE_IS_NONPAGED_POOL))) {
+    mdl->MappedSystemVa = MmGetMdlVirtualAddress(mdl);
+    mdl->MdlFlags |= MDL_MAPPED_TO_SYSTEM_VA;
+  }
+  return mdl->MappedSystemVa;
+}
+
+PIRP IoAllocateIrp(CCHAR stack_size, BOOLEAN) {
+  const size_t size{sizeof(IRP) + static_cast<size_t>(stack_size) *
+                                      sizeof(IO_STACK_LOCATION)};
+  auto* irp{static_cast<PIRP>(calloc(1, size))};
+  if (!irp) {
+    return nullptr;
+  }
+  irp->Type = hosted::IO_TYPE_IRP;
+  irp->Size = static_cast<USHORT>(size);
+  irp->StackCount = stack_size;
+  irp->CurrentLocation = static_cast<CHAR>(stack_size + 1);
+  irp->ThreadListEntry.Flink = &irp->ThreadListEntry;
+  irp->ThreadListEntry.Blink = &irp->ThreadListEntry;
+  irp->Tail.Overlay.CurrentStackLocation =
+      reinterpret_cast<PIO_STACK_LOCATION>(irp + 1) + stack_size;
+  return irp;
+}
+
+VOID IoFreeIrp(PIRP irp) {
+  free(irp);
+}
+
+NTSTATUS IofCallDriver(PDEVICE_OBJECT device, PIRP irp) {
+  --irp->CurrentLocation;
+  if (irp->CurrentLocation <= 0) {
+    KeBugCheckEx(0x00000035,  // NO_MORE_IRP_STACK_LOCATIONS
+                 reinterpret_cast<ULONG_PTR>(irp), 0, 0, 0);
+  }
+  PIO_STACK_LOCATION stack{--irp->Tail.Overlay.CurrentStackLocation};
+  stack->DeviceObject = device;
+  return device->DriverObject->MajorFunction[stack->MajorFunction](device,
+                                                                   irp);
+}
+
+// The completion routines are called from the lowest location upwards until
+// one of them takes the IRP back with STATUS_MORE_PROCESSING_REQUIRED
+VOID IofCompleteRequest(PIRP irp, CCHAR) {
+  if (irp->CurrentLocation > irp->StackCount) {
+    KeBugCheckEx(0x00000044,  // MULTIPLE_IRP_COMPLETE_REQUESTS
+                 reinterpret_cast<ULONG_PTR>(irp), 0, 0, 0);
+  }
+  PIO_STACK_LOCATION stack{IoGetCurrentIrpStackLocation(irp)};
+  for (++irp->CurrentLocation, ++irp->Tail.Overlay.CurrentStackLocation;
+       irp->CurrentLocation <= irp->StackCount + 1;
+       ++stack, ++irp->CurrentLocation,
+       ++irp->Tail.Overlay.CurrentStackLocation) {
+    irp->PendingReturned = (stack->Control & SL_PENDING_RETURNED) != 0;
+    const NTSTATUS status{irp->IoStatus.Status};
+    const bool invoke{
+        (NT_SUCCESS(status) && (stack->Control & SL_INVOKE_ON_SUCCESS)) ||
+        (!NT_SUCCESS(status) && (stack->Control & SL_INVOKE_ON_ERROR)) ||
+        (irp->Cancel && (stack->Control & SL_INVOKE_ON_CANCEL))};
+    if (invoke && stack->CompletionRoutine) {
+      PDEVICE_OBJECT device{irp->CurrentLocation == irp->StackCount + 1
+                                ? nullptr
+                                : IoGetCurrentIrpStackLocation(irp)
+                                      ->DeviceObject};
+      if (stack->CompletionRoutine(device, irp, stack->Context) ==
+          STATUS_MORE_PROCESSING_REQUIRED) {
+        return;
+      }
+    } else if (irp->PendingReturned &&
+               irp->CurrentLocation <= irp->StackCount) {
+      IoMarkIrpPending(irp);
+    }
+  }
+  // The I/O manager finishes the IRP as for the threaded requests
+  if (irp->UserIosb) {
+    *irp->UserIosb = irp->IoStatus;
+  }
+  if (irp->UserEvent) {
+    KeSetEvent(irp->UserEvent, IO_NO_INCREMENT, false);
+  }
+  for (PMDL mdl = irp->MdlAddress; mdl;) {
+    PMDL next{mdl->Next};
+    IoFreeMdl(mdl);
+    mdl = next;
+  }
+  IoFreeIrp(irp);
+}
+
+PDEVICE_OBJECT IoGetRelatedDeviceObject(PFILE_OBJECT file_object) {
+  return file_object->DeviceObject;
+}
+
+// The named events live until the process exits as the system events do.
+// Nothing signals them unless the caller does
+PKEVENT IoCreateNotificationEvent(PUNICODE_STRING event_name,
+                                  PHANDLE event_handle) {
+  using namespace hosted;
+
+  pthread_mutex_lock(&named_events_lock);
+  named_event* entry{named_events};
+  while (entry && !equals(*entry, *event_name)) {
+    entry = entry->next;
+  }
+  if (!entry) {
+    entry = static_cast<named_event*>(
+        malloc(sizeof(named_event) + event_name->Length));
+    PKEVENT event{entry ? static_cast<PKEVENT>(allocate_object(
+                              sizeof(KEVENT), event_type, nullptr))
+                        : nullptr};
+    if (!event) {
+      pthread_mutex_unlock(&named_events_lock);
+      free(entry);
+      return nullptr;
+    }
+    KeInitializeEvent(event, NotificationEvent, false);
+    entry->event = event;
+    entry->length = event_name->Length;
+    memcpy(entry->name, event_name->Buffer, event_name->Length);
+    entry->next = named_events;
+    named_events = entry;
+  }
+  PKEVENT event{entry->event};
+  ObfReferenceObject(event);  // For the handle
+  pthread_mutex_unlock(&named_events_lock);
+  if (!NT_SUCCESS(insert_handle(event, event_handle))) {
+    ObfDereferenceObject(event);
+    return nullptr;
+  }
+  return event;
+}
+}  // extern "C"
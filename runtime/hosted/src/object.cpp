@@ -0,0 +1,134 @@
+#include "platform.hpp"
+
+#include <stdlib.h>
+
+namespace hosted {
+namespace {
+struct alignas(MEMORY_ALLOCATION_ALIGNMENT) object_header {
+  volatile LONG64 references;
+  POBJECT_TYPE type;
+  object_destructor_t destructor;
+};
+
+object_header* get_header(void* body) noexcept {
+  return static_cast<object_header*>(body) - 1;
+}
+
+_OBJECT_TYPE event_type_object{"Event"};
+_OBJECT_TYPE file_type_object{"File"};
+_OBJECT_TYPE section_type_object{"Section"};
+_OBJECT_TYPE thread_type_object{"Thread"};
+
+// Handles are multiples of 4 as in Windows, the zero handle is invalid
+constexpr size_t MAX_HANDLE_COUNT{4096};
+constexpr size_t HANDLE_GRANULARITY{4};
+
+pthread_mutex_t handle_table_lock = PTHREAD_MUTEX_INITIALIZER;
+void* handle_table[MAX_HANDLE_COUNT];
+
+size_t to_index(HANDLE handle) noexcept {
+  return reinterpret_cast<uintptr_t>(handle) / HANDLE_GRANULARITY - 1;
+}
+}  // namespace
+
+POBJECT_TYPE event_type{&event_type_object};
+POBJECT_TYPE file_type{&file_type_object};
+POBJECT_TYPE section_type{&section_type_object};
+POBJECT_TYPE thread_type{&thread_type_object};
+
+void* allocate_object(size_t body_size,
+                      POBJECT_TYPE type,
+                      object_destructor_t destructor) noexcept {
+  auto* header{static_cast<object_header*>(
+      calloc(1, sizeof(object_header) + body_size))};
+  if (!header) {
+    return nullptr;
+  }
+  header->references = 1;
+  header->type = type;
+  header->destructor = destructor;
+  return header + 1;
+}
+
+POBJECT_TYPE get_object_type(void* body) noexcept {
+  return get_header(body)->type;
+}
+
+NTSTATUS insert_handle(void* body, PHANDLE handle) noexcept {
+  pthread_mutex_lock(&handle_table_lock);
+  for (size_t idx = 0; idx < MAX_HANDLE_COUNT; ++idx) {
+    if (!handle_table[idx]) {
+      handle_table[idx] = body;
+      pthread_mutex_unlock(&handle_table_lock);
+      *handle = reinterpret_cast<HANDLE>((idx + 1) * HANDLE_GRANULARITY);
+      return STATUS_SUCCESS;
+    }
+  }
+  pthread_mutex_unlock(&handle_table_lock);
+  return STATUS_INSUFFICIENT_RESOURCES;
+}
+}  // namespace hosted
+
+extern "C" {
+POBJECT_TYPE* ExEventObjectType{&hosted::event_type};
+POBJECT_TYPE* IoFileObjectType{&hosted::file_type};
+POBJECT_TYPE* PsThreadType{&hosted::thread_type};
+
+LONG_PTR ObfReferenceObject(PVOID object) {
+  return static_cast<LONG_PTR>(
+      InterlockedIncrement64(&hosted::get_header(object)->references));
+}
+
+LONG_PTR ObfDereferenceObject(PVOID object) {
+  auto* header{hosted::get_header(object)};
+  const LONG64 references{InterlockedDecrement64(&header->references)};
+  if (!references) {
+    if (header->destructor) {
+      header->destructor(object);
+    }
+    free(header);
+  }
+  return static_cast<LONG_PTR>(references);
+}
+
+NTSTATUS ObReferenceObjectByHandle(HANDLE handle,
+                                   ACCESS_MASK,
+                                   POBJECT_TYPE object_type,
+                                   KPROCESSOR_MODE,
+                                   PVOID* object,
+                                   POBJECT_HANDLE_INFORMATION) {
+  const size_t idx{hosted::to_index(handle)};
+  if (!handle || idx >= hosted::MAX_HANDLE_COUNT) {
+    return STATUS_INVALID_HANDLE;
+  }
+  pthread_mutex_lock(&hosted::handle_table_lock);
+  void* body{hosted::handle_table[idx]};
+  NTSTATUS status{STATUS_SUCCESS};
+  if (!body) {
+    status = STATUS_INVALID_HANDLE;
+  } else if (object_type && hosted::get_object_type(body) != object_type) {
+    status = STATUS_OBJECT_TYPE_MISMATCH;
+  } else {
+    ObfReferenceObject(body);
+    *object = body;
+  }
+  pthread_mutex_unlock(&hosted::handle_table_lock);
+  return status;
+}
+
+NTSTATUS ZwClose(HANDLE handle) {
+  const size_t idx{hosted::to_index(handle)};
+  if (!handle || idx >= hosted::MAX_HANDLE_COUNT) {
+    return STATUS_INVALID_HANDLE;
+  }
+  pthread_mutex_lock(&hosted::handle_table_lock);
+  void* body{hosted::handle_table[idx]};
+  hosted::handle_table[idx] = nullptr;
+  pthread_mutex_unlock(&hosted::handle_table_lock);
+  if (!body) {
+    return STATUS_INVALID_HANDLE;
+  }
+  ObfDereferenceObject(body);
+  return STATUS_SUCCESS;
+}
+}  // extern "C"
@@ -0,0 +1,85 @@
+#pragma once
+/*
+ * Internals of the hosted platform layer shared between its translation units
+ */
+#include <ntddk.h>
+
+#include <pthread.h>
+#include <setjmp.h>
+
+// Dispatcher object types as in the kernel
+enum : UCHAR {
+  EventNotificationObject = 0,
+  EventSynchronizationObject = 1,
+  MutantObject = 2,
+  SemaphoreObject = 5,
+  ThreadObject = 6,
+};
+
+struct _OBJECT_TYPE {
+  const char* name;
+};
+
+struct _KTHREAD {
+  DISPATCHER_HEADER Header;  // Signaled when the thread terminates
+  HANDLE id;
+  KIRQL irql;
+  LONG vcpu;  // Virtual processor owned at IRQL >= DISPATCH_LEVEL or -1
+  KAFFINITY affinity;
+  KPRIORITY priority;
+  LONG critical_region;
+  PKSTART_ROUTINE start_routine;
+  PVOID start_context;
+  bool system_thread;
+  sigjmp_buf exit_point;
+};
+
+namespace hosted {
+/*
+ * Object manager. The body of each object is preceded by the header holding
+ * the reference count, so the objects are passed to the Ob* functions as is
+ */
+using object_destructor_t = void (*)(void* body);
+
+void* allocate_object(size_t body_size,
+                      POBJECT_TYPE type,
+                      object_destructor_t destructor) noexcept;
+POBJECT_TYPE get_object_type(void* body) noexcept;
+NTSTATUS insert_handle(void* body, PHANDLE handle) noexcept;
+
+extern POBJECT_TYPE event_type;
+extern POBJECT_TYPE file_type;
+extern POBJECT_TYPE section_type;
+extern POBJECT_TYPE thread_type;
+
+/*
+ * Dispatcher. All of the dispatcher objects are guarded by the single lock,
+ * the waiters are woken up with the single condition variable
+ */
+void lock_dispatcher() noexcept;
+void unlock_dispatcher() noexcept;
+void signal_dispatcher() noexcept;  // The lock must be held
+
+// Converts the NT timeout into the absolute time of CLOCK_MONOTONIC
+void get_deadline(PLARGE_INTEGER timeout, struct timespec& deadline) noexcept;
+void get_monotonic_time(struct timespec& now) noexcept;
+LONGLONG get_system_time() noexcept;  // 100ns intervals since 1601
+
+/*
+ * Threads and processors
+ */
+PKTHREAD get_current_thread() noexcept;
+ULONG get_processor_count() noexcept;
+void acquire_processor(PKTHREAD thread) noexcept;
+void release_processor(PKTHREAD thread) noexcept;
+
+// Creates a detached thread adopted by the layer as a system thread
+bool start_system_thread(PKSTART_ROUTINE routine, PVOID context) noexcept;
+
+/*
+ * I/O
+ */
+PDEVICE_OBJECT get_file_system_device() noexcept;
+
+[[noreturn]] void fatal_error(const char* format, ...) noexcept;
+}  // namespace hosted
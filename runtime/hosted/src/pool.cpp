@@ -0,0 +1,46 @@
+#include "platform.hpp"
+
+#include <stdlib.h>
+
+/*
+ * The pool is the heap of the process. The cache aligned pool types return
+ * blocks aligned on a cache line and the blocks of a page or more are aligned
+ * on a page as in the kernel
+ */
+extern "C" {
+VOID ExInitializeDriverRuntime(ULONG) {}
+
+PVOID ExAllocatePoolUninitialized(POOL_TYPE pool_type,
+                                  SIZE_T number_of_bytes,
+                                  ULONG) {
+  if (!number_of_bytes) {
+    number_of_bytes = 1;  // The pool returns a unique block as malloc(0) does
+  }
+  size_t alignment{MEMORY_ALLOCATION_ALIGNMENT};
+  if (number_of_bytes >= PAGE_SIZE) {
+    alignment = PAGE_SIZE;
+  } else if ((pool_type & NonPagedPoolCacheAligned) ==
+             NonPagedPoolCacheAligned) {
+    alignment = SYSTEM_CACHE_ALIGNMENT_SIZE;
+  }
+  void* block{nullptr};
+  if (posix_memalign(&block, alignment, number_of_bytes)) {
+    return nullptr;
+  }
+  return block;
+}
+
+PVOID ExAllocatePoolWithTag(POOL_TYPE pool_type,
+                            SIZE_T number_of_bytes,
+                            ULONG tag) {
+  return ExAllocatePoolUninitialized(pool_type, number_of_bytes, tag);
+}
+
+VOID ExFreePoolWithTag(PVOID pool, ULONG) {
+  free(pool);
+}
+
+VOID ExFreePool(PVOID pool) {
+  free(pool);
+}
+}  // extern "C"
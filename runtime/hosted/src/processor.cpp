@@ -0,0 +1,337 @@
+#include "platform.hpp"
+
+#include <errno.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+ * The code at DISPATCH_LEVEL and above owns one of the virtual processors, so
+ * the threads at DISPATCH_LEVEL don't run concurrently on the same processor
+ * as the kernel guarantees. The number of the processors is the number of the
+ * online CPUs unless it's overridden with KTL_HOSTED_PROCESSORS
+ */
+namespace hosted {
+namespace {
+constexpr ULONG MAX_PROCESSOR_COUNT{sizeof(KAFFINITY) * 8};
+constexpr LONGLONG TICKS_PER_SECOND{10'000'000};
+constexpr LONGLONG NANOSECONDS_PER_TICK{100};
+constexpr LONGLONG EPOCH_SHIFT{116'444'736'000'000'000};  // From 1601 to 1970
+
+pthread_once_t processors_initialized = PTHREAD_ONCE_INIT;
+ULONG processor_count;
+pthread_mutex_t processor_locks[MAX_PROCESSOR_COUNT];
+
+void initialize_processors() noexcept {
+  long count{sysconf(_SC_NPROCESSORS_ONLN)};
+  if (const char* value = getenv("KTL_HOSTED_PROCESSORS"); value) {
+    count = strtol(value, nullptr, 10);
+  }
+  if (count < 1) {
+    count = 1;
+  } else if (count > static_cast<long>(MAX_PROCESSOR_COUNT)) {
+    count = MAX_PROCESSOR_COUNT;
+  }
+  processor_count = static_cast<ULONG>(count);
+  for (auto& lock : processor_locks) {
+    pthread_mutex_init(&lock, nullptr);
+  }
+}
+
+ULONG get_preferred_processor(PKTHREAD thread) noexcept {
+  if (thread->vcpu >= 0) {
+    return static_cast<ULONG>(thread->vcpu);
+  }
+  if (thread->affinity) {
+    return static_cast<ULONG>(__builtin_ctzll(thread->affinity)) %
+           get_processor_count();
+  }
+  const int cpu{sched_getcpu()};
+  return static_cast<ULONG>(cpu < 0 ? 0 : cpu) % get_processor_count();
+}
+
+LONGLONG to_ticks(const timespec& time) noexcept {
+  return static_cast<LONGLONG>(time.tv_sec) * TICKS_PER_SECOND +
+         time.tv_nsec / NANOSECONDS_PER_TICK;
+}
+
+struct ipi_request {
+  PKIPI_BROADCAST_WORKER routine;
+  ULONG_PTR context;
+  pthread_barrier_t entered;
+  pthread_barrier_t finished;
+};
+
+struct ipi_target {
+  ipi_request* request;
+  ULONG processor;
+  ULONG_PTR result;
+};
+
+// All of the processors run the routine at IPI_LEVEL at the same time
+ULONG_PTR run_ipi_routine(ipi_request& request) noexcept {
+  KIRQL old_irql;
+  KeRaiseIrql(IPI_LEVEL, &old_irql);
+  pthread_barrier_wait(&request.entered);
+  const ULONG_PTR result{request.routine(request.context)};
+  pthread_barrier_wait(&request.finished);
+  KeLowerIrql(old_irql);
+  return result;
+}
+
+void* run_ipi_target(void* context) noexcept {
+  auto& target{*static_cast<ipi_target*>(context)};
+  get_current_thread()->affinity = KAFFINITY{1} << target.processor;
+  target.result = run_ipi_routine(*target.request);
+  return nullptr;
+}
+}  // namespace
+
+ULONG get_processor_count() noexcept {
+  pthread_once(&processors_initialized, &initialize_processors);
+  return processor_count;
+}
+
+void acquire_processor(PKTHREAD thread) noexcept {
+  const ULONG processor{get_preferred_processor(thread)};
+  pthread_mutex_lock(&processor_locks[processor]);
+  thread->vcpu = static_cast<LONG>(processor);
+}
+
+void release_processor(PKTHREAD thread) noexcept {
+  const LONG processor{thread->vcpu};
+  thread->vcpu = -1;
+  pthread_mutex_unlock(&processor_locks[processor]);
+}
+
+void get_monotonic_time(timespec& now) noexcept {
+  clock_gettime(CLOCK_MONOTONIC, &now);
+}
+
+LONGLONG get_system_time() noexcept {
+  timespec now;
+  clock_gettime(CLOCK_REALTIME, &now);
+  return to_ticks(now) + EPOCH_SHIFT;
+}
+
+void get_deadline(PLARGE_INTEGER timeout, timespec& deadline) noexcept {
+  get_monotonic_time(deadline);
+  LONGLONG interval{0};
+  if (timeout->QuadPart < 0) {
+    interval = -timeout->QuadPart;
+  } else if (timeout->QuadPart > 0) {
+    interval = timeout->QuadPart - get_system_time();
+    if (interval < 0) {
+      interval = 0;
+    }
+  }
+  deadline.tv_sec += static_cast<time_t>(interval / TICKS_PER_SECOND);
+  deadline.tv_nsec +=
+      static_cast<long>(interval % TICKS_PER_SECOND * NANOSECONDS_PER_TICK);
+  if (deadline.tv_nsec >= 1'000'000'000) {
+    deadline.tv_sec += 1;
+    deadline.tv_nsec -= 1'000'000'000;
+  }
+}
+}  // namespace hosted
+
+extern "C" {
+KIRQL KeGetCurrentIrql() {
+  return hosted::get_current_thread()->irql;
+}
+
+VOID KeRaiseIrql(KIRQL new_irql, PKIRQL old_irql) {
+  PKTHREAD thread{hosted::get_current_thread()};
+  const KIRQL current_irql{thread->irql};
+  if (new_irql < current_irql) {
+    KeBugCheckEx(0x00000009,  // IRQL_NOT_GREATER_OR_EQUAL
+                 current_irql, new_irql, 0, 0);
+  }
+  if (current_irql < DISPATCH_LEVEL && new_irql >= DISPATCH_LEVEL) {
+    hosted::acquire_processor(thread);
+  }
+  thread->irql = new_irql;
+  *old_irql = current_irql;
+}
+
+KIRQL KeRaiseIrqlToDpcLevel() {
+  KIRQL old_irql;
+  KeRaiseIrql(DISPATCH_LEVEL, &old_irql);
+  return old_irql;
+}
+
+VOID KeLowerIrql(KIRQL new_irql) {
+  PKTHREAD thread{hosted::get_current_thread()};
+  const KIRQL current_irql{thread->irql};
+  if (new_irql > current_irql) {
+    KeBugCheckEx(IRQL_NOT_LESS_OR_EQUAL, current_irql, new_irql, 0, 0);
+  }
+  if (current_irql >= DISPATCH_LEVEL && new_irql < DISPATCH_LEVEL) {
+    hosted::release_processor(thread);
+  }
+  thread->irql = new_irql;
+}
+
+VOID KeEnterCriticalRegion() {
+  ++hosted::get_current_thread()->critical_region;
+}
+
+VOID KeLeaveCriticalRegion() {
+  --hosted::get_current_thread()->critical_region;
+}
+
+ULONG KeQueryActiveProcessorCount(PKAFFINITY active_processors) {
+  const ULONG count{hosted::get_processor_count()};
+  if (active_processors) {
+    *active_processors = count == hosted::MAX_PROCESSOR_COUNT
+                             ? ~KAFFINITY{0}
+                             : (KAFFINITY{1} << count) - 1;
+  }
+  return count;
+}
+
+ULONG KeQueryActiveProcessorCountEx(USHORT) {
+  return hosted::get_processor_count();
+}
+
+ULONG KeQueryMaximumProcessorCountEx(USHORT) {
+  return hosted::get_processor_count();
+}
+
+ULONG KeGetCurrentProcessorNumberEx(PPROCESSOR_NUMBER proc_number) {
+  const ULONG processor{
+      hosted::get_preferred_processor(hosted::get_current_thread())};
+  if (proc_number) {
+    proc_number->Group = 0;
+    proc_number->Number = static_cast<UCHAR>(processor);
+    proc_number->Reserved = 0;
+  }
+  return processor;
+}
+
+ULONG KeGetCurrentProcessorIndex() {
+  return KeGetCurrentProcessorNumberEx(nullptr);
+}
+
+NTSTATUS KeGetProcessorNumberFromIndex(ULONG proc_index,
+                                       PPROCESSOR_NUMBER proc_number) {
+  if (proc_index >= hosted::get_processor_count()) {
+    return STATUS_INVALID_PARAMETER;
+  }
+  proc_number->Group = 0;
+  proc_number->Number = static_cast<UCHAR>(proc_index);
+  proc_number->Reserved = 0;
+  return STATUS_SUCCESS;
+}
+
+VOID KeSetSystemGroupAffinityThread(PGROUP_AFFINITY affinity,
+                                    PGROUP_AFFINITY previous_affinity) {
+  PKTHREAD thread{hosted::get_current_thread()};
+  if (previous_affinity) {
+    *previous_affinity = GROUP_AFFINITY{};
+    previous_affinity->Mask = thread->affinity;
+  }
+  thread->affinity = affinity->Mask;
+}
+
+VOID KeRevertToUserGroupAffinityThread(PGROUP_AFFINITY previous_affinity) {
+  hosted::get_current_thread()->affinity = previous_affinity->Mask;
+}
+
+ULONG_PTR KeIpiGenericCall(PKIPI_BROADCAST_WORKER broadcast_function,
+                           ULONG_PTR context) {
+  using namespace hosted;
+
+  const ULONG count{get_processor_count()};
+  PKTHREAD caller{get_current_thread()};
+  // The caller at DISPATCH_LEVEL runs the routine on its own processor
+  const LONG own_processor{caller->vcpu};
+
+  ipi_request request{broadcast_function, context, {}, {}};
+  pthread_barrier_init(&request.entered, nullptr, count);
+  pthread_barrier_init(&request.finished, nullptr, count);
+  ipi_target targets[MAX_PROCESSOR_COUNT];
+  pthread_t threads[MAX_PROCESSOR_COUNT];
+  for (ULONG idx = 0; idx < count; ++idx) {
+    targets[idx] = {&request, idx, 0};
+    if (static_cast<LONG>(idx) != own_processor &&
+        pthread_create(&threads[idx], nullptr, &run_ipi_target,
+                       &targets[idx])) {
+      fatal_error("*** Unable to start the IPI thread\n");
+    }
+  }
+  ULONG_PTR result{0};
+  if (own_processor >= 0) {
+    result = run_ipi_routine(request);
+  }
+  for (ULONG idx = 0; idx < count; ++idx) {
+    if (static_cast<LONG>(idx) != own_processor) {
+      pthread_join(threads[idx], nullptr);
+    }
+  }
+  pthread_barrier_destroy(&request.entered);
+  pthread_barrier_destroy(&request.finished);
+  return own_processor >= 0 ? result : targets[0].result;
+}
+
+// The state is saved by the host on a context switch
+NTSTATUS KeSaveExtendedProcessorState(ULONG64 mask, PXSTATE_SAVE xstate_save) {
+  xstate_save->Mask = mask;
+  return STATUS_SUCCESS;
+}
+
+VOID KeRestoreExtendedProcessorState(PXSTATE_SAVE) {}
+
+ULONG64 RtlGetEnabledExtendedFeatures(ULONG64 feature_mask) {
+  constexpr int OSXSAVE_BIT{27};
+  int cpu_info[4];
+  __cpuid(cpu_info, 1);
+  if (!(cpu_info[2] & (1 << OSXSAVE_BIT))) {
+    return feature_mask & XSTATE_MASK_LEGACY;
+  }
+  return feature_mask & _xgetbv(0);
+}
+
+LARGE_INTEGER KeQueryPerformanceCounter(PLARGE_INTEGER performance_frequency) {
+  if (performance_frequency) {
+    performance_frequency->QuadPart = hosted::TICKS_PER_SECOND;
+  }
+  LARGE_INTEGER counter;
+  counter.QuadPart = static_cast<LONGLONG>(KeQueryInterruptTime());
+  return counter;
+}
+
+ULONGLONG KeQueryInterruptTime() {
+  timespec now;
+  hosted::get_monotonic_time(now);
+  return static_cast<ULONGLONG>(hosted::to_ticks(now));
+}
+
+VOID KeQuerySystemTime(PLARGE_INTEGER current_time) {
+  current_time->QuadPart = hosted::get_system_time();
+}
+
+VOID KeQuerySystemTimePrecise(PLARGE_INTEGER current_time) {
+  current_time->QuadPart = hosted::get_system_time();
+}
+
+VOID KeStallExecutionProcessor(ULONG microseconds) {
+  const ULONGLONG deadline{KeQueryInterruptTime() +
+                           ULONGLONG{microseconds} * 10};
+  while (KeQueryInterruptTime() < deadline) {
+    _mm_pause();
+  }
+}
+
+NTSTATUS KeDelayExecutionThread(KPROCESSOR_MODE,
+                                BOOLEAN,
+                                PLARGE_INTEGER interval) {
+  timespec deadline;
+  hosted::get_deadline(interval, deadline);
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) ==
+         EINTR) {
+  }
+  return STATUS_SUCCESS;
+}
+}  // extern "C"
@@ -0,0 +1,291 @@
+#include "platform.hpp"
+
+#include <stdlib.h>
+
+// The device object only identifies the caller: the driver images are never
+// unloaded while the items are queued, so there is nothing to reference
+struct _IO_WORKITEM {
+  WORK_QUEUE_ITEM item;
+  PDEVICE_OBJECT device_object;
+  PIO_WORKITEM_ROUTINE routine;
+  PVOID context;
+};
+
+namespace hosted {
+namespace {
+constexpr KPRIORITY DEFAULT_PRIORITY{8};
+constexpr ULONG MAX_WORKER_COUNT{64};
+
+thread_local PKTHREAD current_thread;
+volatile LONG64 last_thread_id;
+
+// The threads which weren't created by the layer are adopted on the first
+// call and their objects are released on exit
+pthread_once_t adopted_key_created = PTHREAD_ONCE_INIT;
+pthread_key_t adopted_key;
+
+void release_adopted_thread(void* thread) noexcept {
+  ObfDereferenceObject(thread);
+}
+
+void create_adopted_key() noexcept {
+  pthread_key_create(&adopted_key, &release_adopted_thread);
+}
+
+PKTHREAD create_thread_object() noexcept {
+  auto* thread{static_cast<PKTHREAD>(
+      allocate_object(sizeof(_KTHREAD), thread_type, nullptr))};
+  if (!thread) {
+    return nullptr;
+  }
+  thread->Header.Type = ThreadObject;
+  thread->Header.WaitListHead.Flink = &thread->Header.WaitListHead;
+  thread->Header.WaitListHead.Blink = &thread->Header.WaitListHead;
+  // Ids are multiples of 4 as in Windows
+  thread->id = reinterpret_cast<HANDLE>(
+      InterlockedIncrement64(&last_thread_id) * 4);
+  thread->irql = PASSIVE_LEVEL;
+  thread->vcpu = -1;
+  thread->priority = DEFAULT_PRIORITY;
+  return thread;
+}
+
+void* run_system_thread(void* context) noexcept {
+  auto* thread{static_cast<PKTHREAD>(context)};
+  current_thread = thread;
+  if (!sigsetjmp(thread->exit_point, 0)) {
+    thread->start_routine(thread->start_context);
+  }
+  if (thread->vcpu >= 0) {
+    release_processor(thread);
+  }
+  lock_dispatcher();
+  thread->Header.SignalState = 1;
+  signal_dispatcher();
+  unlock_dispatcher();
+  current_thread = nullptr;
+  ObfDereferenceObject(thread);
+  return nullptr;
+}
+
+// The caller owns the reference to the object, the thread holds its own one
+NTSTATUS start_thread(PKTHREAD thread,
+                      PKSTART_ROUTINE start_routine,
+                      PVOID start_context) noexcept {
+  thread->start_routine = start_routine;
+  thread->start_context = start_context;
+  thread->system_thread = true;
+  ObfReferenceObject(thread);
+
+  pthread_attr_t attributes;
+  pthread_attr_init(&attributes);
+  pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+  pthread_t handle;
+  const int error{
+      pthread_create(&handle, &attributes, &run_system_thread, thread)};
+  pthread_attr_destroy(&attributes);
+  if (error) {
+    ObfDereferenceObject(thread);
+    return STATUS_INSUFFICIENT_RESOURCES;
+  }
+  return STATUS_SUCCESS;
+}
+
+/*
+ * System worker threads. A new worker is started when the queued item finds
+ * all of the workers busy, so the items waiting for each other don't deadlock
+ */
+pthread_mutex_t work_queue_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t work_queue_condition = PTHREAD_COND_INITIALIZER;
+LIST_ENTRY work_queue{&work_queue, &work_queue};
+ULONG worker_count;
+ULONG idle_worker_count;
+
+void run_worker(PVOID) noexcept {
+  pthread_mutex_lock(&work_queue_lock);
+  for (;;) {
+    while (work_queue.Flink == &work_queue) {
+      ++idle_worker_count;
+      pthread_cond_wait(&work_queue_condition, &work_queue_lock);
+      --idle_worker_count;
+    }
+    PLIST_ENTRY entry{work_queue.Flink};
+    work_queue.Flink = entry->Flink;
+    entry->Flink->Blink = &work_queue;
+    pthread_mutex_unlock(&work_queue_lock);
+
+    auto* item{CONTAINING_RECORD(entry, WORK_QUEUE_ITEM, List)};
+    item->WorkerRoutine(item->Parameter);
+    if (const KIRQL irql = KeGetCurrentIrql(); irql != PASSIVE_LEVEL) {
+      KeBugCheckEx(0x000000E1,  // WORKER_THREAD_RETURNED_AT_BAD_IRQL
+                   reinterpret_cast<ULONG_PTR>(item->WorkerRoutine), irql,
+                   reinterpret_cast<ULONG_PTR>(item), 0);
+    }
+    pthread_mutex_lock(&work_queue_lock);
+  }
+}
+
+// The routine may free the item
+void run_io_work_item(PVOID parameter) noexcept {
+  auto* item{static_cast<PIO_WORKITEM>(parameter)};
+  item->routine(item->device_object, item->context);
+}
+}  // namespace
+
+PKTHREAD get_current_thread() noexcept {
+  if (current_thread) {
+    return current_thread;
+  }
+  PKTHREAD thread{create_thread_object()};
+  if (!thread) {
+    fatal_error("*** Unable to allocate the thread object\n");
+  }
+  pthread_once(&adopted_key_created, &create_adopted_key);
+  pthread_setspecific(adopted_key, thread);
+  current_thread = thread;
+  return thread;
+}
+
+bool start_system_thread(PKSTART_ROUTINE routine, PVOID context) noexcept {
+  PKTHREAD thread{create_thread_object()};
+  if (!thread) {
+    return false;
+  }
+  const NTSTATUS status{start_thread(thread, routine, context)};
+  ObfDereferenceObject(thread);
+  return NT_SUCCESS(status);
+}
+}  // namespace hosted
+
+extern "C" {
+NTSTATUS PsCreateSystemThread(PHANDLE thread_handle,
+                              ULONG,
+                              POBJECT_ATTRIBUTES,
+                              HANDLE,
+                              PCLIENT_ID client_id,
+                              PKSTART_ROUTINE start_routine,
+                              PVOID start_context) {
+  PKTHREAD thread{hosted::create_thread_object()};
+  if (!thread) {
+    return STATUS_INSUFFICIENT_RESOURCES;
+  }
+  NTSTATUS status{hosted::insert_handle(thread, thread_handle)};
+  if (!NT_SUCCESS(status)) {
+    ObfDereferenceObject(thread);
+    return status;
+  }
+  status = hosted::start_thread(thread, start_routine, start_context);
+  if (!NT_SUCCESS(status)) {
+    ZwClose(*thread_handle);
+    return status;
+  }
+  if (client_id) {
+    client_id->UniqueProcess = nullptr;
+    client_id->UniqueThread = thread->id;
+  }
+  return STATUS_SUCCESS;
+}
+
+NTSTATUS IoCreateSystemThread(PVOID,
+                              PHANDLE thread_handle,
+                              ULONG desired_access,
+                              POBJECT_ATTRIBUTES object_attributes,
+                              HANDLE process_handle,
+                              PCLIENT_ID client_id,
+                              PKSTART_ROUTINE start_routine,
+                              PVOID start_context) {
+  return PsCreateSystemThread(thread_handle, desired_access, object_attributes,
+                              process_handle, client_id, start_routine,
+                              start_context);
+}
+
+NTSTATUS PsTerminateSystemThread(NTSTATUS) {
+  PKTHREAD thread{hosted::get_current_thread()};
+  if (!thread->system_thread) {
+    KeBugCheckEx(KMODE_EXCEPTION_NOT_HANDLED,
+                 static_cast<ULONG>(STATUS_INVALID_PARAMETER), 0, 0, 0);
+  }
+  siglongjmp(thread->exit_point, 1);
+}
+
+PETHREAD PsGetCurrentThread() {
+  return hosted::get_current_thread();
+}
+
+PKTHREAD KeGetCurrentThread() {
+  return hosted::get_current_thread();
+}
+
+HANDLE PsGetCurrentThreadId() {
+  return hosted::get_current_thread()->id;
+}
+
+HANDLE PsGetThreadId(PETHREAD thread) {
+  return thread->id;
+}
+
+// The priorities are only stored, the scheduling policy of the host is kept
+KPRIORITY KeQueryPriorityThread(PKTHREAD thread) {
+  return thread->priority;
+}
+
+KPRIORITY KeSetPriorityThread(PKTHREAD thread, KPRIORITY priority) {
+  return InterlockedExchange(&thread->priority, priority);
+}
+
+VOID ExQueueWorkItem(PWORK_QUEUE_ITEM work_item, WORK_QUEUE_TYPE) {
+  using namespace hosted;
+
+  pthread_mutex_lock(&work_queue_lock);
+  PLIST_ENTRY tail{work_queue.Blink};
+  work_item->List.Flink = &work_queue;
+  work_item->List.Blink = tail;
+  tail->Flink = &work_item->List;
+  work_queue.Blink = &work_item->List;
+  bool start_worker{false};
+  if (idle_worker_count) {
+    pthread_cond_signal(&work_queue_condition);
+  } else if (worker_count < MAX_WORKER_COUNT) {
+    ++worker_count;
+    start_worker = true;
+  }
+  pthread_mutex_unlock(&work_queue_lock);
+  if (start_worker && !start_system_thread(&run_worker, nullptr)) {
+    fatal_error("*** Unable to start the system worker thread\n");
+  }
+}
+
+PIO_WORKITEM IoAllocateWorkItem(PDEVICE_OBJECT device_object) {
+  auto* item{static_cast<PIO_WORKITEM>(calloc(1, sizeof(_IO_WORKITEM)))};
+  if (item) {
+    item->device_object = device_object;
+  }
+  return item;
+}
+
+VOID IoFreeWorkItem(PIO_WORKITEM io_work_item) {
+  free(io_work_item);
+}
+
+ULONG IoSizeofWorkItem() {
+  return sizeof(_IO_WORKITEM);
+}
+
+// The I/O object may be a driver object, so the routine gets no device one
+VOID IoInitializeWorkItem(PVOID, PIO_WORKITEM io_work_item) {
+  *io_work_item = {};
+}
+
+VOID IoUninitializeWorkItem(PIO_WORKITEM) {}
+
+VOID IoQueueWorkItem(PIO_WORKITEM io_work_item,
+                     PIO_WORKITEM_ROUTINE worker_routine,
+                     WORK_QUEUE_TYPE queue_type,
+                     PVOID context) {
+  io_work_item->routine = worker_routine;
+  io_work_item->context = context;
+  ExInitializeWorkItem(&io_work_item->item, &hosted::run_io_work_item,
+                       io_work_item);
+  ExQueueWorkItem(&io_work_item->item, queue_type);
+}
+}  // extern "C"
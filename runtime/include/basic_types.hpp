@@ -1,10 +1,19 @@
 #pragma once
 
 #ifndef KTL_NO_CXX_STANDARD_LIBRARY
+#include <cstddef>
 #include <cstdint>
+#include <new>
 using std::nothrow_t;
 using std::size_t;
 #else
+#ifdef KTL_HOSTED
+// The hosted platform layer is built over the C library of the host, so its
+// fixed width types are used
+#include <stddef.h>
+#include <stdint.h>
+#endif
+
 namespace std {  // NOLINT(cert-dcl58-cpp)
 /*
  * align_val_t is a compiler-predefined type that must be declared in the std::
@@ -12,6 +21,15 @@ namespace std {  // NOLINT(cert-dcl58-cpp)
 enum class align_val_t : size_t {};
 }  // namespace std
 
+#ifdef KTL_HOSTED
+using nullptr_t = decltype(nullptr);
+
+#if defined(__x86_64__)
+#define BITNESS 64  // NOLINT(cppcoreguidelines-macro-usage)
+#else
+#error Unsupported platform
+#endif
+#else
 using int8_t = signed char;
 using int16_t = short;
 using int32_t = int;
@@ -59,9 +77,6 @@ using uintptr_t = unsigned int;
 #error Unsupported platform
 #endif
 
-struct nothrow_t {};
-inline constexpr nothrow_t nothrow;
-
 using max_align_t = double;  // Most aligned type
 
 #define INT8_C(x) (x)  // NOLINT(cppcoreguidelines-macro-usage)
@@ -77,6 +92,10 @@ using max_align_t = double;  // Most aligned type
 #define UINTMAX_C(x) UINT64_C(x)  // NOLINT(cppcoreguidelines-macro-usage)
 #endif
 
+struct nothrow_t {};
+inline constexpr nothrow_t nothrow;
+#endif
+
 namespace ktl {
 using byte = unsigned char;
 using ::nullptr_t;
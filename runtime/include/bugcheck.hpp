@@ -77,7 +77,7 @@ class termination_dispatcher {
 
   termination_context set_context(const termination_context& bsod) noexcept;
 
-  void terminate() const noexcept;
+  [[noreturn]] void terminate() const noexcept;
   [[noreturn]] void abort() const noexcept;
 
  private:
@@ -88,7 +88,7 @@ class termination_dispatcher {
 
  private:
   terminate_handler_t m_handler{nullptr};
-  mutable long m_spin_lock{};
+  mutable LONG m_spin_lock{};
   mutable irql_t m_prev_irql;
   termination_context m_context{BugCheckReason::StdAbort};
 };
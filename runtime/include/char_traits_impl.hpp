@@ -6,6 +6,15 @@
 #include <stdio.h>  // Defines the EOF
 
 namespace ktl {
+namespace tt::details {
+// GCC has neither the wide string builtins nor the constexpr memchr
+#if defined(__GNUC__) && !defined(__clang__)
+inline constexpr bool HAS_STRING_BUILTINS{false};
+#else
+inline constexpr bool HAS_STRING_BUILTINS{true};
+#endif
+}  // namespace tt::details
+
 template <typename CharT, typename IntT>
 struct char_traits_base {
   using char_type = CharT;
@@ -157,7 +166,8 @@ struct narrow_char_traits
                                                        size_t count,
                                                        char_type ch) noexcept {
     // This check is required for char8_t
-    if constexpr (is_same_v<char_type, char>) {
+    if constexpr (is_same_v<char_type, char> &&
+                  tt::details::HAS_STRING_BUILTINS) {
       return __builtin_char_memchr(str, ch, count);
     } else {
       // Not an memchr because it isn't constexpr
@@ -233,7 +243,8 @@ struct wide_char_traits
   static constexpr int compare(const char_type* str1,
                                const char_type* str2,
                                size_t count) noexcept {
-    if constexpr (is_same_v<char_type, wchar_t>) {
+    if constexpr (is_same_v<char_type, wchar_t> &&
+                  tt::details::HAS_STRING_BUILTINS) {
       return __builtin_wmemcmp(str1, str2, count);
     } else {
       // Not an wmemcmp because it isn't constexpr
@@ -242,7 +253,8 @@ struct wide_char_traits
   }
 
   static constexpr size_t length(const char_type* str) noexcept {
-    if constexpr (is_same_v<char_type, wchar_t>) {
+    if constexpr (is_same_v<char_type, wchar_t> &&
+                  tt::details::HAS_STRING_BUILTINS) {
       return __builtin_wcslen(str);
     } else {
       // Not an wcslen because it isn't constexpr
@@ -253,7 +265,8 @@ struct wide_char_traits
   [[nodiscard]] static constexpr const char_type* find(const char_type* str,
                                                        size_t count,
                                                        char_type ch) noexcept {
-    if constexpr (is_same_v<char_type, wchar_t>) {
+    if constexpr (is_same_v<char_type, wchar_t> &&
+                  tt::details::HAS_STRING_BUILTINS) {
       return __builtin_wmemchr(str, ch, count);
     } else {
       // Not an wmemchr because it isn't constexpr
@@ -18,4 +18,6 @@ intmax_t query_system_time();
 
 intmax_t query_performance_counter();
 intmax_t query_performance_counter_frequency();
+
+intmax_t query_interrupt_time() noexcept;
 }  // namespace ktl::chrono
\ No newline at end of file
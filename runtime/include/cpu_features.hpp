@@ -0,0 +1,194 @@
+#pragma once
+#include <basic_types.hpp>
+#include <flag_set.hpp>
+#include <type_traits_impl.hpp>
+#include <utility_impl.hpp>
+
+namespace ktl {
+/**
+ * @enum cpu_feature
+ * @brief Instruction set extensions reported by CPUID. Vector extensions are
+ * reported only if their register state is enabled by the OS
+ */
+enum class cpu_feature : uint64_t {
+  sse2 = 1ull << 0,
+  sse3 = 1ull << 1,
+  ssse3 = 1ull << 2,
+  sse41 = 1ull << 3,
+  sse42 = 1ull << 4,
+  popcnt = 1ull << 5,
+  lzcnt = 1ull << 6,
+  bmi1 = 1ull << 7,
+  bmi2 = 1ull << 8,
+  pclmulqdq = 1ull << 9,
+  aes = 1ull << 10,
+  sha = 1ull << 11,
+  movbe = 1ull << 12,
+  cmpxchg16b = 1ull << 13,
+  rdrand = 1ull << 14,
+  rdtscp = 1ull << 15,
+  invariant_tsc = 1ull << 16,
+  erms = 1ull << 17,  //!< Enhanced REP MOVSB/STOSB
+  fsrm = 1ull << 18,  //!< Fast short REP MOVSB
+  avx = 1ull << 19,
+  avx2 = 1ull << 20,
+  fma = 1ull << 21,
+  avx512f = 1ull << 22,
+  avx512bw = 1ull << 23,
+  avx512vl = 1ull << 24,
+};
+
+using cpu_feature_set = flag_set<cpu_feature>;
+
+namespace cpu {
+/**
+ * @var cpu_feature_set baseline_features
+ * @brief Extensions guaranteed by the target architecture. Queries about them
+ * are folded at compile time
+ */
+#if BITNESS == 64
+inline constexpr cpu_feature_set baseline_features{cpu_feature::sse2};
+#else
+inline constexpr cpu_feature_set baseline_features{};
+#endif
+
+/**
+ * @fn cpu_feature_set cpu::features()
+ * @brief Returns extensions supported by the current CPU. CPUID is executed
+ * once by a preload initializer, so the call is a plain memory read
+ */
+cpu_feature_set features() noexcept;
+
+/**
+ * @fn bool cpu::has(cpu_feature_set required)
+ * @param[in] required Set of the extensions expected by the caller
+ * @return true if all of them are supported
+ */
+inline bool has(cpu_feature_set required) noexcept {
+  return baseline_features.has_all_of(required) ||
+         features().has_all_of(required);
+}
+
+template <cpu_feature... Features>
+bool has() noexcept {
+  constexpr cpu_feature_set required{Features...};
+  if constexpr (baseline_features.has_all_of(required)) {
+    return true;
+  } else {
+    return features().has_all_of(required);
+  }
+}
+
+#ifdef KTL_CPU_FEATURES_OVERRIDE
+/**
+ * @fn void cpu::override_features(cpu_feature_set features)
+ * @brief Replaces the detected extensions and rebinds all of the dispatchers.
+ * Intended for testing of the fallback paths only: the caller is responsible
+ * for not enabling extensions which aren't supported by the CPU and for not
+ * calling dispatched functions concurrently
+ */
+void override_features(cpu_feature_set features) noexcept;
+
+/**
+ * @fn void cpu::reset_features()
+ * @brief Restores the extensions detected at startup
+ */
+void reset_features() noexcept;
+#endif
+
+namespace details {
+class dispatch_entry : non_relocatable {
+ public:
+  virtual void bind(cpu_feature_set features) noexcept = 0;
+
+ protected:
+  dispatch_entry() noexcept = default;
+  ~dispatch_entry() = default;
+
+  /**
+   * @fn void cpu::details::dispatch_entry::register_entry()
+   * @brief Links the entry to the list of dispatchers being rebound after
+   * feature detection. Binds it immediately if detection is already done
+   */
+  void register_entry() noexcept;
+
+ private:
+  friend class dispatch_registry;
+
+  dispatch_entry* m_next{nullptr};
+};
+}  // namespace details
+
+/**
+ * @struct cpu::implementation
+ * @brief One of the versions of a function and the extensions it relies on
+ */
+template <class Fn>
+struct implementation;
+
+template <class Ret, class... Types>
+struct implementation<Ret(Types...)> {
+  using function_type = Ret (*)(Types...);
+
+  cpu_feature_set required;
+  function_type function;
+};
+
+/**
+ * @class cpu::dispatched
+ * @brief Calls the best version of a function supported by the CPU.
+ * @details Versions are ordered from the most to the least demanding one and
+ * the last one must be generic. The choice is made once at startup (or on
+ * construction if the dispatcher is created later), so the call costs a single
+ * indirect jump. Until then the generic version is used. Dispatchers must have
+ * static storage duration.
+ * @code
+ * static constexpr cpu::implementation<uint32_t(const void*, size_t)>
+ *     checksum_versions[]{{cpu_feature::sse42, &checksum_sse42},
+ *                         {{}, &checksum_generic}};
+ * cpu::dispatched checksum{checksum_versions};
+ * @endcode
+ */
+template <class Fn>
+class dispatched;
+
+template <class Ret, class... Types>
+class dispatched<Ret(Types...)> final : public details::dispatch_entry {
+ public:
+  using implementation_type = implementation<Ret(Types...)>;
+  using function_type = typename implementation_type::function_type;
+
+ public:
+  template <size_t N>
+  dispatched(const implementation_type (&versions)[N]) noexcept
+      : m_versions{versions}, m_count{N}, m_function{versions[N - 1].function} {
+    register_entry();
+  }
+
+  Ret operator()(Types... args) const {
+    return m_function(forward<Types>(args)...);
+  }
+
+  [[nodiscard]] function_type get() const noexcept { return m_function; }
+
+  void bind(cpu_feature_set features) noexcept override {
+    for (size_t idx = 0; idx < m_count; ++idx) {
+      if (features.has_all_of(m_versions[idx].required)) {
+        m_function = m_versions[idx].function;
+        return;
+      }
+    }
+    m_function = m_versions[m_count - 1].function;
+  }
+
+ private:
+  const implementation_type* m_versions;
+  size_t m_count;
+  function_type m_function;
+};
+
+template <class Ret, class... Types, size_t N>
+dispatched(const implementation<Ret(Types...)> (&)[N])
+    -> dispatched<Ret(Types...)>;
+}  // namespace cpu
+}  // namespace ktl
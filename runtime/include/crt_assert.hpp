@@ -16,8 +16,7 @@ constexpr void assert_impl(const Cond& cond,
 }
 }  // namespace ktl::crt
 
-#define ASSERT_DESCRIPTION(cond) \
-  CONCAT(CONCAT(STRINGIFY(cond), " "), IN_FILE_ON_LINE)
+#define ASSERT_DESCRIPTION(cond) STRINGIFY(cond) " " IN_FILE_ON_LINE
 
 #define ASSERTION_CHECK(cond) \
   ktl::crt::assert_impl((cond), ASSERT_DESCRIPTION(cond))
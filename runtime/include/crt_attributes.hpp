@@ -13,6 +13,7 @@
 #define FASTCALL
 #endif
 
+#ifdef _MSC_VER
 #ifndef VECTORCALL
 #define VECTORCALL __vectorcall
 #endif
@@ -20,12 +21,26 @@
 #ifndef THISCALL
 #define THISCALL __thiscall
 #endif
+#else
+#define VECTORCALL
+#define THISCALL
+#endif
 
 #define EXTERN_C extern "C"
 
+#ifdef _MSC_VER
 #define ALIGN(align_val) __declspec(align(align_val))
 #define CRTALLOC(x) __declspec(allocate(x))
 #define NOINLINE __declspec(noinline)
+#define TARGET_ISA(...)
+#else
+#define ALIGN(align_val) \
+  __attribute__((aligned(static_cast<unsigned long>(align_val))))
+#define CRTALLOC(x) __attribute__((section(x)))
+#define NOINLINE __attribute__((noinline))
+// GCC and Clang allow the intrinsics only in the functions targeting their ISA
+#define TARGET_ISA(...) __attribute__((target(__VA_ARGS__)))
+#endif
 
 #define CONCAT_IMPL(x, y) x##y
 #define CONCAT(x, y) CONCAT_IMPL(x, y)
@@ -33,8 +48,7 @@
 #define STRINGIFY_IMPL(expr) #expr
 #define STRINGIFY(expr) STRINGIFY_IMPL(expr)
 
-#define IN_FILE_ON_LINE \
-  CONCAT(CONCAT("in file ", __FILE__), CONCAT(" on line ", STRINGIFY(__LINE__)))
+#define IN_FILE_ON_LINE "in file " __FILE__ " on line " STRINGIFY(__LINE__)
 
 #define container_of(ptr, type, member) \
   reinterpret_cast<type*>((uintptr_t)(ptr)-offsetof(type, member))
@@ -15,8 +15,7 @@ class exception_allocator : preload_initializer {
                                                RESERVED_PAGES_COUNT};   //!< Reserved memory amount in bytes
   static constexpr size_t SLOT_COUNT{RESERVED_BYTES_COUNT / SLOT_SIZE}; //!< Buffers count
 
-  // NOLINTNEXTLINE(clang-diagnostic-four-char-constants)
-  static constexpr pool_tag_t ALLOCATION_TAG{'eLTK'};  // KTLe
+  static constexpr pool_tag_t ALLOCATION_TAG{0x654C544B};  // 'eLTK', KTLe
   static constexpr auto SLOT_ALIGNMENT{CACHE_LINE_ALLOCATION_ALIGNMENT};  //!< Default alignment of buffer
   // clang-format on
 
@@ -50,7 +49,13 @@ struct persistent_message_t {
 
 namespace crt {
 class exception_base {
+#ifdef KTL_HOSTED
+  // The string literals aren't aligned by GCC, but the upper bit of the
+  // user-mode addresses is always zero
+  static constexpr size_t SHARED_DATA_MASK{~(~size_t{0} >> 1)};
+#else
   static constexpr size_t SHARED_DATA_MASK{1};
+#endif
   static constexpr auto UNICODE_CONVERSION_FAILED{
       "(unable to convert provided Unicode description to ANSI)"};
 
@@ -28,6 +28,10 @@ struct flag_set {
     return m_value & other.m_value;
   }
 
+  constexpr bool has_all_of(flag_set other) const noexcept {
+    return (m_value & other.m_value) == other.m_value;
+  }
+
   template <Enum... flags>
   constexpr value_type bit_intersection() const noexcept {
     return value() & make_union_mask<flags...>();
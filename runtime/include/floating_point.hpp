@@ -0,0 +1,68 @@
+#pragma once
+#include <basic_types.hpp>
+#include <type_traits_impl.hpp>
+
+#include <ntddk.h>
+
+namespace ktl {
+/**
+ * @enum simd_level
+ * @brief Vector register sets ordered by width. A wider level implies that
+ * all narrower ones are available too
+ */
+enum class simd_level : uint8_t {
+  none,    //!< Vector registers must not be touched
+  sse,     //!< XMM registers: SSE - SSE4.2
+  avx,     //!< YMM registers: AVX, AVX2, FMA
+  avx512,  //!< ZMM and opmask registers: AVX-512
+};
+
+/**
+ * @class simd_scope
+ * @brief RAII guard making the vector registers of the requested level safe to
+ * use in kernel code.
+ * @details On x64 the kernel preserves XMM registers on its own, so a scope
+ * requesting SSE costs nothing. Wider registers (and every SIMD register on
+ * x86) are saved with KeSaveExtendedProcessorState() and restored on
+ * destruction. The scope never fails: if the requested state can't be saved
+ * (feature disabled by OS, IRQL > DISPATCH_LEVEL, allocation failure) it falls
+ * back to the widest level which is still safe, so the callers are expected to
+ * select an implementation by level(). A nested scope constructed from the
+ * enclosing one skips the save if the latter already covers the request
+ */
+class simd_scope : non_relocatable {
+ public:
+  explicit simd_scope(simd_level required = simd_level::avx) noexcept;
+  simd_scope(const simd_scope& parent, simd_level required) noexcept;
+  ~simd_scope() noexcept;
+
+  /**
+   * @fn simd_level simd_scope::level() const
+   * @return The widest vector level which is safe to use within the scope
+   */
+  [[nodiscard]] simd_level level() const noexcept { return m_level; }
+
+  /**
+   * @fn bool simd_scope::allows(simd_level required) const
+   * @param[in] required Vector level expected by the caller
+   * @return true if registers of the required level may be used
+   */
+  [[nodiscard]] bool allows(simd_level required) const noexcept {
+    return required <= m_level;
+  }
+
+ private:
+  void enter(simd_level required) noexcept;
+
+ private:
+  XSTATE_SAVE m_state;
+  simd_level m_level{simd_level::none};
+  bool m_saved{false};
+};
+
+/**
+ * @fn simd_level max_supported_simd_level();
+ * @return The widest vector level whose state is enabled by the OS
+ */
+simd_level max_supported_simd_level() noexcept;
+}  // namespace ktl
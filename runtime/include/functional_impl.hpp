@@ -9,6 +9,7 @@ using std::less;
 }  // namespace ktl
 #else
 #include <type_traits_impl.hpp>
+#include <utility_impl.hpp>
 
 namespace ktl {
 template <class Ty = void>
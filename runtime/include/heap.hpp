@@ -15,8 +15,7 @@ using pool_tag_t = uint32_t;
 using pool_type_t = POOL_TYPE;
 
 // clang-format off
-// NOLINTNEXTLINE(clang-diagnostic-four-char-constants)
-inline constexpr pool_tag_t DEFAULT_HEAP_TAG{'dLTK'};  //!< Reversed 'KTLd'
+inline constexpr pool_tag_t DEFAULT_HEAP_TAG{0x644C544B};  //!< 'dLTK', reversed 'KTLd'
 inline constexpr pool_tag_t KTL_HEAP_TAG{DEFAULT_HEAP_TAG};  //!< For back compatibility
 
 inline constexpr size_t MEMORY_PAGE_SIZE{PAGE_SIZE};
@@ -66,7 +65,7 @@ class heap_request_builder_base {
 };
 }  // namespace heap::details
 
-ALIGN(crt::XMM_ALIGNMENT) struct alloc_request {
+struct ALIGN(crt::XMM_ALIGNMENT) alloc_request {
   size_t bytes_count;
   crt::pool_type_t pool_type;
   std::align_val_t alignment;
@@ -84,8 +83,7 @@ struct alloc_request_builder
       : MyBase({count, pool_type}) {}
 };
 
-ALIGN(crt::XMM_ALIGNMENT)
-struct free_request {
+struct ALIGN(crt::XMM_ALIGNMENT) free_request {
   void* memory_block;
   size_t bytes_count;
   std::align_val_t alignment;
@@ -110,11 +108,51 @@ template <OnAllocationFailure OnFailure = OnAllocationFailure::DoNothing>
 void* allocate_memory(alloc_request) noexcept(
     OnFailure != OnAllocationFailure::ThrowException);
 
-extern template void* allocate_memory<OnAllocationFailure::DoNothing>(
+template <>
+void* allocate_memory<OnAllocationFailure::DoNothing>(
     alloc_request request) noexcept;
 
-extern template void* allocate_memory<OnAllocationFailure::ThrowException>(
+template <>
+void* allocate_memory<OnAllocationFailure::ThrowException>(
     alloc_request request);
 
 void deallocate_memory(free_request request) noexcept;
+
+#ifdef KTL_ALLOCATION_HOOKS
+namespace heap {
+/**
+ * @class allocation_hook
+ * @brief Observes the allocations made by allocate_memory(), including the
+ * ones of operator new. Called before the memory is requested from the pool
+ */
+class allocation_hook {
+ public:
+  virtual void on_allocation(const alloc_request& request) noexcept = 0;
+
+ protected:
+  ~allocation_hook() = default;
+};
+
+/**
+ * @struct allocation_hook_binding
+ * @brief The hook and the thread whose allocations it observes. The hook is
+ * called on that thread only, so it may live on the stack of the thread
+ */
+struct allocation_hook_binding {
+  allocation_hook* hook;
+  PKTHREAD thread;
+};
+
+/**
+ * @fn allocation_hook_binding heap::set_allocation_hook(
+ * allocation_hook_binding binding)
+ * @brief Installs the hook (or removes it if nullptr is passed) and returns
+ * the previous binding. Intended for testing only: the caller is responsible
+ * for chaining to the previous hook, for restoring it and for not installing
+ * the hooks concurrently
+ */
+allocation_hook_binding set_allocation_hook(
+    allocation_hook_binding binding) noexcept;
+}  // namespace heap
+#endif
 }  // namespace ktl
@@ -2,6 +2,9 @@
 #include <basic_types.hpp>
 #include <crt_attributes.hpp>
 
+#ifdef KTL_HOSTED
+#include <intrin.h>  // Emulated by the hosted platform layer
+#else
 EXTERN_C unsigned char _addcarry_u32(unsigned char c_in,
                                      unsigned int src1,
                                      unsigned int src2,
@@ -30,6 +33,35 @@ EXTERN_C unsigned char _BitScanReverse64(unsigned long* index,
                                          unsigned long long mask);
 #pragma intrinsic(_BitScanReverse64)
 
+EXTERN_C void __cpuid(int cpu_info[4], int function_id);
+#pragma intrinsic(__cpuid)
+
+EXTERN_C void __cpuidex(int cpu_info[4], int function_id, int subfunction_id);
+#pragma intrinsic(__cpuidex)
+
+// SSE4.2, the caller must check cpu_feature::sse42
+EXTERN_C unsigned int _mm_crc32_u8(unsigned int crc, unsigned char value);
+EXTERN_C unsigned int _mm_crc32_u32(unsigned int crc, unsigned int value);
+#if (BITNESS == 64)
+EXTERN_C unsigned __int64 _mm_crc32_u64(unsigned __int64 crc,
+                                        unsigned __int64 value);
+#endif
+
+EXTERN_C char _InterlockedExchange8(volatile char* place, char new_value);
+#pragma intrinsic(_InterlockedExchange8)
+
+EXTERN_C char _InterlockedCompareExchange8(volatile char* place,
+                                           char new_value,
+                                           char expected);
+#pragma intrinsic(_InterlockedCompareExchange8)
+
+EXTERN_C char _InterlockedExchangeAdd8(volatile char* place, char append);
+#pragma intrinsic(_InterlockedExchangeAdd8)
+
+EXTERN_C short _InterlockedExchangeAdd16(volatile short* place, short append);
+#pragma intrinsic(_InterlockedExchangeAdd16)
+#endif
+
 #if (BITNESS == 32)
 #define BITSCANFORWARD _BitScanForward
 #define BITSCANREVERSE _BitScanReverse
@@ -38,28 +70,24 @@ EXTERN_C unsigned char _BitScanReverse64(unsigned long* index,
 #define BITSCANREVERSE _BitScanReverse64
 #endif
 
-EXTERN_C char _InterlockedExchange8(volatile char* place, char new_value);
-#pragma intrinsic(_InterlockedExchange8)
 #ifndef InterlockedExchange8
 #define InterlockedExchange8 _InterlockedExchange8
 #endif
 
-EXTERN_C char _InterlockedCompareExchange8(volatile char* place,
-                                           char new_value,
-                                           char expected);
-#pragma intrinsic(_InterlockedCompareExchange8)
 #ifndef InterlockedCompareExchange8
 #define InterlockedCompareExchange8 _InterlockedCompareExchange8
 #endif
 
-EXTERN_C char _InterlockedExchangeAdd8(volatile char* place, char append);
-#pragma intrinsic(_InterlockedExchangeAdd8)
 #ifndef InterlockedExchangeAdd8
 #define InterlockedExchangeAdd8 _InterlockedExchangeAdd8
 #endif
 
+#ifndef InterlockedExchangeAdd16
+#define InterlockedExchangeAdd16 _InterlockedExchangeAdd16
+#endif
+
 EXTERN_C inline char _InterlockedIncrement8(volatile char* target) {
-  return InterlockedExchangeAdd8(target, 1);
+  return static_cast<char>(InterlockedExchangeAdd8(target, 1) + 1);
 }
 
 #ifndef InterlockedIncrement8
@@ -67,27 +95,31 @@ EXTERN_C inline char _InterlockedIncrement8(volatile char* target) {
 #endif
 
 EXTERN_C inline char _InterlockedDecrement8(volatile char* target) {
-  return InterlockedExchangeAdd8(target, -1);
+  return static_cast<char>(InterlockedExchangeAdd8(target, -1) - 1);
 }
 
 #ifndef InterlockedDecrement8
 #define InterlockedDecrement8 _InterlockedDecrement8
 #endif
 
+// Like InterlockedAdd, these return the resulting value
 EXTERN_C inline char _InterlockedAdd8(volatile char* target, char value) {
-  return InterlockedExchangeAdd8(target, value);
+  return static_cast<char>(InterlockedExchangeAdd8(target, value) + value);
 }
 
 #ifndef InterlockedAdd8
 #define InterlockedAdd8 _InterlockedAdd8
 #endif
 
-EXTERN_C inline char _InterlockedAdd16(volatile short* target, short value);
+EXTERN_C inline short _InterlockedAdd16(volatile short* target, short value) {
+  return static_cast<short>(InterlockedExchangeAdd16(target, value) + value);
+}
 
 #ifndef InterlockedAdd16
 #define InterlockedAdd16 _InterlockedAdd16
 #endif
 
+#ifndef KTL_HOSTED
 EXTERN_C void* CRTCALL memcpy(void* dst, const void* src, size_t size);
 #pragma intrinsic(memcpy)
 
@@ -95,4 +127,5 @@ EXTERN_C void* CRTCALL memset(void* lhs, int pattern, size_t size);
 #pragma intrinsic(memset)
 
 EXTERN_C int CRTCALL memcmp(const void* lhs, const void* rhs, size_t size);
-#pragma intrinsic(memcmp)
\ No newline at end of file
+#pragma intrinsic(memcmp)
+#endif
@@ -293,10 +293,9 @@ struct numeric_limits<int> : public numeric_limits_integral {
 
 template <>
 struct numeric_limits<long> : public numeric_limits_integral {
-  static_assert(sizeof(int) == sizeof(long), "LLP64 assumption");
   static constexpr bool is_signed{true};
-  static constexpr int digits{31};
-  static constexpr int digits10{9};
+  static constexpr int digits{sizeof(long) == sizeof(int) ? 31 : 63};  // LP64
+  static constexpr int digits10{sizeof(long) == sizeof(int) ? 9 : 18};
 
   [[nodiscard]] static constexpr long(min)() noexcept { return LONG_MIN; }
   [[nodiscard]] static constexpr long(max)() noexcept { return LONG_MAX; }
@@ -400,11 +399,9 @@ struct numeric_limits<unsigned int> : public numeric_limits_integral {
 
 template <>
 struct numeric_limits<unsigned long> : public numeric_limits_integral {
-  static_assert(sizeof(unsigned int) == sizeof(unsigned long),
-                "LLP64 assumption");
   static constexpr bool is_modulo{true};
-  static constexpr int digits{32};
-  static constexpr int digits10{9};
+  static constexpr int digits{sizeof(long) == sizeof(int) ? 32 : 64};  // LP64
+  static constexpr int digits10{sizeof(long) == sizeof(int) ? 9 : 19};
 
   [[nodiscard]] static constexpr unsigned long(min)() noexcept { return 0; }
 
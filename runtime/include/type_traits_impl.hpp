@@ -287,7 +287,7 @@ using remove_cv_t = typename remove_cv<Ty>::type;
 
 template <class Ty>
 struct remove_cvref {
-  using type = typename remove_cv_t<remove_reference_t<Ty>>;
+  using type = remove_cv_t<remove_reference_t<Ty>>;
 };
 
 template <typename Ty>
@@ -706,7 +706,11 @@ inline constexpr bool is_trivially_copyable_v =
 
 template <class Ty>
 struct is_trivially_destructible {
+#if defined(__GNUC__) && !defined(__clang__)
+  static constexpr bool value = __has_trivial_destructor(Ty);
+#else
   static constexpr bool value = __is_trivially_destructible(Ty);
+#endif
 };
 
 template <class Ty>
@@ -1117,7 +1121,7 @@ template <class Ret, class ClassTy, class... Types>
 struct is_member_function_pointer<Ret (ClassTy::*)(Types..., ...)
                                       const volatile&&> : public true_type {};
 
-#ifndef _M_AMD64
+#ifdef _M_IX86
 template <class Ret, class ClassTy, class... Types>
 struct is_member_function_pointer<Ret (STDCALL ClassTy::*)(Types...)>
     : public true_type {};
@@ -1136,7 +1140,7 @@ template <class Ret, class ClassTy, class... Types>
 struct is_member_function_pointer<Ret (VECTORCALL ClassTy::*)(Types...)>
     : public true_type {};
 
-#ifndef _M_AMD64
+#ifdef _M_IX86
 template <class Ret, class ClassTy, class... Types>
 struct is_member_function_pointer<Ret (STDCALL ClassTy::*)(Types...) const>
     : public true_type {};
@@ -1157,7 +1161,7 @@ struct is_member_function_pointer<Ret (VECTORCALL ClassTy::*)(Types...) const>
 #endif
 
 // volatile:
-#ifndef _M_AMD64
+#ifdef _M_IX86
 template <class Ret, class ClassTy, class... Types>
 struct is_member_function_pointer<Ret (STDCALL ClassTy::*)(Types...) volatile>
     : public true_type {};
@@ -1177,7 +1181,7 @@ struct is_member_function_pointer<Ret (VECTORCALL ClassTy::*)(
     Types...) volatile> : public true_type {};
 #endif
 
-#ifndef _M_AMD64
+#ifdef _M_IX86
 template <class Ret, class ClassTy, class... Types>
 struct is_member_function_pointer<Ret (STDCALL ClassTy::*)(Types...)
                                       const volatile> : public true_type {};
@@ -1198,7 +1202,7 @@ struct is_member_function_pointer<Ret (VECTORCALL ClassTy::*)(Types...)
 #endif
 
 // reference qualified:
-#ifndef _M_AMD64
+#ifdef _M_IX86
 template <class Ret, class ClassTy, class... Types>
 struct is_member_function_pointer<Ret (STDCALL ClassTy::*)(Types...)&>
     : public true_type {};
@@ -1219,7 +1223,7 @@ struct is_member_function_pointer<Ret (VECTORCALL ClassTy::*)(Types...)&>
 #endif
 
 // const:
-#ifndef _M_AMD64
+#ifdef _M_IX86
 template <class Ret, class ClassTy, class... Types>
 struct is_member_function_pointer<Ret (STDCALL ClassTy::*)(Types...) const&>
     : public true_type {};
@@ -1240,7 +1244,7 @@ struct is_member_function_pointer<Ret (VECTORCALL ClassTy::*)(Types...) const&>
 #endif
 
 // volatile:
-#ifndef _M_AMD64
+#ifdef _M_IX86
 template <class Ret, class ClassTy, class... Types>
 struct is_member_function_pointer<Ret (STDCALL ClassTy::*)(Types...) volatile&>
     : public true_type {};
@@ -1260,7 +1264,7 @@ struct is_member_function_pointer<Ret (VECTORCALL ClassTy::*)(
 #endif
 
 // const volatile:
-#ifndef _M_AMD64
+#ifdef _M_IX86
 template <class Ret, class ClassTy, class... Types>
 struct is_member_function_pointer<Ret (STDCALL ClassTy::*)(Types...)
                                       const volatile&> : public true_type {};
@@ -1280,7 +1284,7 @@ struct is_member_function_pointer<Ret (VECTORCALL ClassTy::*)(Types...)
 #endif
 
 // rvalue reference qualified:
-#ifndef _M_AMD64
+#ifdef _M_IX86
 template <class Ret, class ClassTy, class... Types>
 struct is_member_function_pointer<Ret (STDCALL ClassTy::*)(Types...) &&>
     : public true_type {};
@@ -1301,7 +1305,7 @@ struct is_member_function_pointer<Ret (VECTORCALL ClassTy::*)(Types...) &&>
 #endif
 
 // const:
-#ifndef _M_AMD64
+#ifdef _M_IX86
 template <class Ret, class ClassTy, class... Types>
 struct is_member_function_pointer<Ret (STDCALL ClassTy::*)(Types...) const&&>
     : public true_type {};
@@ -1321,7 +1325,7 @@ struct is_member_function_pointer<Ret (VECTORCALL ClassTy::*)(Types...) const&&>
 #endif
 
 // volatile:
-#ifndef _M_AMD64
+#ifdef _M_IX86
 template <class Ret, class ClassTy, class... Types>
 struct is_member_function_pointer<Ret (STDCALL ClassTy::*)(Types...) volatile&&>
     : public true_type {};
@@ -1341,7 +1345,7 @@ struct is_member_function_pointer<Ret (VECTORCALL ClassTy::*)(
 #endif
 
 // const volatile:
-#ifndef _M_AMD64
+#ifdef _M_IX86
 template <class Ret, class ClassTy, class... Types>
 struct is_member_function_pointer<Ret (STDCALL ClassTy::*)(Types...)
                                       const volatile&&> : public true_type {};
@@ -24,6 +24,7 @@ KtlDriverEntry(DRIVER_OBJECT* driver_object,
   using namespace crt;
 
   verify_security_cookie();
+  details::driver_ctx.object = driver_object;
 
   initialize_heap();
   invoke_global_constructors();
@@ -79,7 +79,8 @@ terminate_handler_t termination_dispatcher::set_handler(
     terminate_handler_t handler) noexcept {
   auto* as_volatile{reinterpret_cast<const volatile PVOID*>(&m_handler)};
   auto* handler_ptr{const_cast<volatile PVOID*>(as_volatile)};
-  const auto prev{InterlockedExchangePointer(handler_ptr, handler)};
+  const auto prev{InterlockedExchangePointer(
+      handler_ptr, reinterpret_cast<PVOID>(handler))};
   return reinterpret_cast<terminate_handler_t>(prev);
 }
 
@@ -92,7 +93,7 @@ termination_context termination_dispatcher::set_context(
   return old_context;
 }
 
-void termination_dispatcher::terminate() const noexcept {
+[[noreturn]] void termination_dispatcher::terminate() const noexcept {
   if (const auto terminate_handler = get_terminate(); terminate_handler) {
     terminate_handler();
   }
@@ -106,7 +107,7 @@ void termination_dispatcher::terminate() const noexcept {
 }
 
 void termination_dispatcher::acquire_lock() const noexcept {
-  auto* lock_ptr{reinterpret_cast<volatile long*>(&m_spin_lock)};
+  auto* lock_ptr{const_cast<volatile LONG*>(&m_spin_lock)};
   const irql_t prev_irql{raise_irql(HIGH_LEVEL)};
   while (InterlockedCompareExchange(lock_ptr, 1, 0)) {
     while (*lock_ptr) {
@@ -117,7 +118,7 @@ void termination_dispatcher::acquire_lock() const noexcept {
 }
 
 void termination_dispatcher::release_lock() const noexcept {
-  auto& as_volatile{reinterpret_cast<volatile long&>(m_spin_lock)};
+  auto& as_volatile{const_cast<volatile LONG&>(m_spin_lock)};
   const irql_t prev_irql{m_prev_irql};
   InterlockedExchange(&as_volatile, 0);
   lower_irql(prev_irql);
@@ -65,4 +65,8 @@ intmax_t query_performance_counter() {
 intmax_t query_performance_counter_frequency() {
   return details::perf_counter_info.get_frequency();
 }
+
+intmax_t query_interrupt_time() noexcept {
+  return static_cast<intmax_t>(KeQueryInterruptTime());
+}
 }  // namespace ktl::chrono
\ No newline at end of file
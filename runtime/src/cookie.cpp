@@ -7,7 +7,7 @@
 namespace ktl::crt {
 #if BITNESS == 64
 static constexpr uintptr_t DEFAULT_SECURITY_COOKIE{0x00002B99'2DDFA232ull};
-#elif #if BITNESS == 32
+#elif BITNESS == 32
 static constexpr uintptr_t DEFAULT_SECURITY_COOKIE{0x0BB40E64Eul};
 #else
 #error Unsupported platform
@@ -15,8 +15,10 @@ static constexpr uintptr_t DEFAULT_SECURITY_COOKIE{0x0BB40E64Eul};
 }  // namespace ktl::crt
 
 #pragma data_seg(".KTL_SECURITY")
+extern "C" {
 CRTALLOC(".KTL_SECURITY")
-EXTERN_C volatile uintptr_t __security_cookie{ktl::crt::DEFAULT_SECURITY_COOKIE};
+volatile uintptr_t __security_cookie{ktl::crt::DEFAULT_SECURITY_COOKIE};
+}
 #pragma comment(linker, "/merge:.KTL_SECURITY=.data")
 
 namespace ktl::crt {
@@ -0,0 +1,182 @@
+#include <cpu_features.hpp>
+#include <floating_point.hpp>
+#include <intrinsic.hpp>
+#include <preload_initializer.hpp>
+
+namespace ktl::cpu {
+namespace details {
+enum cpuid_register : uint8_t { eax, ebx, ecx, edx };
+
+struct cpuid_bit {
+  uint32_t leaf;
+  cpuid_register reg;
+  uint8_t bit;
+  cpu_feature feature;
+};
+
+// clang-format off
+static constexpr cpuid_bit FEATURE_BITS[]{
+    {0x00000001, edx, 26, cpu_feature::sse2},
+    {0x00000001, ecx,  0, cpu_feature::sse3},
+    {0x00000001, ecx,  1, cpu_feature::pclmulqdq},
+    {0x00000001, ecx,  9, cpu_feature::ssse3},
+    {0x00000001, ecx, 12, cpu_feature::fma},
+    {0x00000001, ecx, 13, cpu_feature::cmpxchg16b},
+    {0x00000001, ecx, 19, cpu_feature::sse41},
+    {0x00000001, ecx, 20, cpu_feature::sse42},
+    {0x00000001, ecx, 22, cpu_feature::movbe},
+    {0x00000001, ecx, 23, cpu_feature::popcnt},
+    {0x00000001, ecx, 25, cpu_feature::aes},
+    {0x00000001, ecx, 28, cpu_feature::avx},
+    {0x00000001, ecx, 30, cpu_feature::rdrand},
+    {0x00000007, ebx,  3, cpu_feature::bmi1},
+    {0x00000007, ebx,  5, cpu_feature::avx2},
+    {0x00000007, ebx,  8, cpu_feature::bmi2},
+    {0x00000007, ebx,  9, cpu_feature::erms},
+    {0x00000007, ebx, 16, cpu_feature::avx512f},
+    {0x00000007, ebx, 29, cpu_feature::sha},
+    {0x00000007, ebx, 30, cpu_feature::avx512bw},
+    {0x00000007, ebx, 31, cpu_feature::avx512vl},
+    {0x00000007, edx,  4, cpu_feature::fsrm},
+    {0x80000001, ecx,  5, cpu_feature::lzcnt},
+    {0x80000001, edx, 27, cpu_feature::rdtscp},
+    {0x80000007, edx,  8, cpu_feature::invariant_tsc},
+};
+// clang-format on
+
+static constexpr cpu_feature_set AVX_FEATURES{
+    cpu_feature::avx, cpu_feature::avx2, cpu_feature::fma};
+static constexpr cpu_feature_set AVX512_FEATURES{
+    cpu_feature::avx512f, cpu_feature::avx512bw, cpu_feature::avx512vl};
+
+static bool is_leaf_supported(uint32_t leaf) noexcept {
+  int regs[4];
+  __cpuid(regs, static_cast<int>(leaf & 0x80000000));  // Max basic/extended
+  return leaf <= static_cast<uint32_t>(regs[0]);
+}
+
+static cpu_feature_set detect_features() noexcept {
+  uint64_t features{0};
+  uint32_t cached_leaf{0};
+  int regs[4]{};
+  bool leaf_supported{false};
+
+  for (const auto& entry : FEATURE_BITS) {
+    if (entry.leaf != cached_leaf) {
+      cached_leaf = entry.leaf;
+      leaf_supported = is_leaf_supported(entry.leaf);
+      if (leaf_supported) {
+        __cpuidex(regs, static_cast<int>(entry.leaf), 0);
+      }
+    }
+    if (leaf_supported &&
+        (static_cast<unsigned int>(regs[entry.reg]) >> entry.bit) & 1) {
+      features |= static_cast<uint64_t>(entry.feature);
+    }
+  }
+
+  /*
+   * Vector extensions are useless (and fault on use) unless the OS saves
+   * the corresponding register state on context switches
+   */
+  const simd_level os_level{max_supported_simd_level()};
+  if (os_level < simd_level::avx) {
+    features &= ~AVX_FEATURES.value();
+  }
+  if (os_level < simd_level::avx512) {
+    features &= ~AVX512_FEATURES.value();
+  }
+  return cpu_feature_set{features};
+}
+
+class dispatch_registry : non_relocatable {
+ public:
+  static dispatch_registry& get_instance() noexcept {
+    static dispatch_registry registry;
+    return registry;
+  }
+
+  void add(dispatch_entry& entry) noexcept {
+    entry.m_next = m_head;
+    m_head = &entry;
+    if (m_detected) {
+      entry.bind(m_features);
+    }
+  }
+
+  void bind_all(cpu_feature_set features) noexcept {
+    m_features = features;
+    m_detected = true;
+    for (auto* entry = m_head; entry; entry = entry->m_next) {
+      entry->bind(features);
+    }
+  }
+
+  cpu_feature_set get_features() noexcept {
+    if (!m_detected) {  // Queried from a global constructor
+      return detect_features();
+    }
+    return m_features;
+  }
+
+#ifdef KTL_CPU_FEATURES_OVERRIDE
+  void save_detected() noexcept {
+    if (!m_overridden) {
+      m_detected_features = get_features();
+      m_overridden = true;
+    }
+  }
+
+  void restore_detected() noexcept {
+    if (m_overridden) {
+      m_overridden = false;
+      bind_all(m_detected_features);
+    }
+  }
+#endif
+
+ private:
+  dispatch_registry() noexcept = default;
+
+ private:
+  dispatch_entry* m_head{nullptr};
+  cpu_feature_set m_features{};
+  bool m_detected{false};
+#ifdef KTL_CPU_FEATURES_OVERRIDE
+  cpu_feature_set m_detected_features{};
+  bool m_overridden{false};
+#endif
+};
+
+void dispatch_entry::register_entry() noexcept {
+  dispatch_registry::get_instance().add(*this);
+}
+
+class feature_detector : public preload_initializer {
+ public:
+  NTSTATUS run([[maybe_unused]] DRIVER_OBJECT& driver_object,
+               [[maybe_unused]] UNICODE_STRING& registry_path) noexcept final {
+    dispatch_registry::get_instance().bind_all(detect_features());
+    return STATUS_SUCCESS;
+  }
+};
+
+static feature_detector detector;
+}  // namespace details
+
+cpu_feature_set features() noexcept {
+  return details::dispatch_registry::get_instance().get_features();
+}
+
+#ifdef KTL_CPU_FEATURES_OVERRIDE
+void override_features(cpu_feature_set features) noexcept {
+  auto& registry{details::dispatch_registry::get_instance()};
+  registry.save_detected();
+  registry.bind_all(features);
+}
+
+void reset_features() noexcept {
+  details::dispatch_registry::get_instance().restore_detected();
+}
+#endif
+}  // namespace ktl::cpu
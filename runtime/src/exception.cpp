@@ -159,7 +159,7 @@ const char* exception_base::get_message() const noexcept {
 
 bool exception_base::is_shared() const noexcept {
   auto* non_const_ptr{const_cast<void*>(m_data)};
-  return (ptr_to_number(non_const_ptr) & SHARED_DATA_MASK) == 1;
+  return (ptr_to_number(non_const_ptr) & SHARED_DATA_MASK) != 0;
 }
 
 auto exception_base::get_shared() const noexcept -> shared_data* {
@@ -178,9 +178,9 @@ auto exception_base::make_shared_data(const char* msg, size_t msg_length)
 
 auto exception_base::make_shared_data(const wchar_t* msg, size_t msg_length)
     -> masked_ptr_t {
-  unsigned long description_length;
+  ULONG description_length;
   const auto src_length_in_bytes{
-      static_cast<unsigned long>(msg_length * sizeof(wchar_t))};
+      static_cast<ULONG>(msg_length * sizeof(wchar_t))};
   RtlUnicodeToMultiByteSize(&description_length, msg, src_length_in_bytes);
   byte* buffer{details::exc_memory_pool.allocate(sizeof(shared_data) +
                                                  description_length + 1u)};
@@ -1,8 +1,107 @@
+#include <algorithm_impl.hpp>
 #include <crt_attributes.hpp>
+#include <floating_point.hpp>
+#include <irql.hpp>
+#include <utility_impl.hpp>
 
 /**
  * @var extern "C" const int _fltused
  * @brief A dummy variable allowing floating point operations
  * It should be a single underscore since the double one is the mangled name
  */
-EXTERN_C const int _fltused{0};
\ No newline at end of file
+EXTERN_C const int _fltused{0};
+
+namespace ktl {
+namespace fp::details {
+static constexpr uint64_t get_xstate_mask(simd_level level) noexcept {
+  uint64_t mask{0};
+  switch (level) {
+    case simd_level::avx512:
+      mask |= XSTATE_MASK_AVX512;
+      [[fallthrough]];
+    case simd_level::avx:
+      mask |= XSTATE_MASK_AVX;
+      [[fallthrough]];
+    case simd_level::sse:
+#if BITNESS == 32
+      mask |= XSTATE_MASK_LEGACY;  // x86 kernel doesn't preserve any FP state
+#endif
+      break;
+    default:
+      break;
+  }
+  return mask;
+}
+
+static constexpr simd_level get_implicitly_saved_level() noexcept {
+#if BITNESS == 64
+  return simd_level::sse;  // XMM registers are preserved by the kernel itself
+#else
+  return simd_level::none;
+#endif
+}
+
+static constexpr simd_level get_narrower_level(simd_level level) noexcept {
+  return static_cast<simd_level>(static_cast<uint8_t>(level) - 1);
+}
+}  // namespace fp::details
+
+simd_scope::simd_scope(simd_level required) noexcept {
+  enter(required);
+}
+
+simd_scope::simd_scope(const simd_scope& parent, simd_level required) noexcept {
+  if (parent.allows(required)) {
+    m_level = required;  // The state has already been saved by the parent
+  } else {
+    enter(required);
+  }
+}
+
+simd_scope::~simd_scope() noexcept {
+  if (m_saved) {
+    KeRestoreExtendedProcessorState(addressof(m_state));
+  }
+}
+
+void simd_scope::enter(simd_level required) noexcept {
+  using namespace fp::details;
+
+  constexpr simd_level implicit_level{get_implicitly_saved_level()};
+  simd_level target{(min)(required, max_supported_simd_level())};
+
+  /*
+   * KeSaveExtendedProcessorState() allocates a buffer for the state being
+   * saved, so it may fail under memory pressure and is forbidden above
+   * DISPATCH_LEVEL. Try narrower levels before giving up
+   */
+  if (target > implicit_level && irql_less_or_equal(DISPATCH_LEVEL)) {
+    for (; target > implicit_level; target = get_narrower_level(target)) {
+      const NTSTATUS status{KeSaveExtendedProcessorState(
+          get_xstate_mask(target), addressof(m_state))};
+      if (NT_SUCCESS(status)) {
+        m_saved = true;
+        break;
+      }
+    }
+  }
+  m_level = m_saved ? target : (min)(target, implicit_level);
+}
+
+simd_level max_supported_simd_level() noexcept {
+  const auto enabled_features{RtlGetEnabledExtendedFeatures(
+      XSTATE_MASK_LEGACY | XSTATE_MASK_AVX | XSTATE_MASK_AVX512)};
+
+  if ((enabled_features & XSTATE_MASK_AVX512) == XSTATE_MASK_AVX512 &&
+      enabled_features & XSTATE_MASK_AVX) {
+    return simd_level::avx512;
+  }
+  if (enabled_features & XSTATE_MASK_AVX) {
+    return simd_level::avx;
+  }
+  if (enabled_features & XSTATE_MASK_LEGACY_SSE) {
+    return simd_level::sse;
+  }
+  return simd_level::none;
+}
+}  // namespace ktl
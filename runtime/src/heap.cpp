@@ -29,9 +29,24 @@ static constexpr std::align_val_t get_max_alignment_for_pool(
   return max_alignment;
 }
 
+#ifdef KTL_ALLOCATION_HOOKS
+// The hook may be destroyed as soon as its thread removes it, so the other
+// threads compare the owner and never dereference the hook
+static heap::allocation_hook* volatile current_hook;
+static PKTHREAD volatile current_hook_thread;
+#endif
+
 static void* allocate_impl(const alloc_request& request) noexcept {
   const auto [bytes_count, pool_type, alignment, pool_tag]{request};
 
+#ifdef KTL_ALLOCATION_HOOKS
+  if (current_hook_thread == KeGetCurrentThread()) {
+    if (auto* hook = current_hook; hook) {
+      hook->on_allocation(request);
+    }
+  }
+#endif
+
   crt_assert_with_msg(pool_tag != 0, "pool tag must not be equal to zero");
   crt_assert_with_msg(
       get_current_irql() <= DISPATCH_LEVEL,
@@ -79,4 +94,21 @@ void deallocate_memory(free_request request) noexcept {
     crt::deallocate_impl(ptr, request.pool_tag);
   }
 }
+
+#ifdef KTL_ALLOCATION_HOOKS
+namespace heap {
+allocation_hook_binding set_allocation_hook(
+    allocation_hook_binding binding) noexcept {
+  // No thread matches while the hook is being replaced
+  auto* previous_thread{static_cast<PKTHREAD>(InterlockedExchangePointer(
+      reinterpret_cast<void* volatile*>(&crt::current_hook_thread), nullptr))};
+  auto* previous_hook{static_cast<allocation_hook*>(InterlockedExchangePointer(
+      reinterpret_cast<void* volatile*>(&crt::current_hook), binding.hook))};
+  InterlockedExchangePointer(
+      reinterpret_cast<void* volatile*>(&crt::current_hook_thread),
+      binding.thread);
+  return {previous_hook, previous_thread};
+}
+}  // namespace heap
+#endif
 }  // namespace ktl
\ No newline at end of file
@@ -1,11 +1,19 @@
 #include <object_management.hpp>
 
 #include <crt_assert.hpp>
+#ifndef KTL_HOSTED
 #include <crt_runtime.hpp>
+#endif
 
 #include <intrinsic.hpp>
 
 namespace ktl::crt {
+#ifdef KTL_HOSTED
+// The global objects are constructed before main() and destroyed by
+// the C++ runtime of the compiler at the process exit
+void CRTCALL invoke_global_constructors() noexcept {}
+void CRTCALL invoke_global_destructors() noexcept {}
+#else
 namespace details {
 // C++ Standard requires 32 or more
 static constexpr unsigned int MAX_DESTRUCTOR_COUNT{128};  
@@ -33,6 +41,7 @@ void CRTCALL invoke_global_destructors() noexcept {
   }
   dtor_count = 0;
 }
+#endif
 
 void CRTCALL construct_array(void* arr_begin,
                              size_t element_size,
@@ -65,6 +74,7 @@ void CRTCALL destroy_array_in_reversed_order(void* arr_begin,
 }
 }  // namespace ktl::crt
 
+#ifndef KTL_HOSTED
 int CRTCALL atexit(ktl::crt::global_handler_t destructor) {
   using namespace ktl::crt;
 
@@ -83,3 +93,4 @@ int CRTCALL atexit(ktl::crt::global_handler_t destructor) {
   }
   return 1;
 }
+#endif
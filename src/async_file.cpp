@@ -0,0 +1,89 @@
+#include <async_file.hpp>
+#include <basic_runtime.hpp>
+#include <crt_assert.hpp>
+
+#include <ntddk.h>
+
+namespace ktl::io::details {
+namespace {
+IO_WORKITEM* get_work_item(io_request& request) noexcept {
+  return reinterpret_cast<IO_WORKITEM*>(request.work_item);
+}
+
+void resume_on_worker(DEVICE_OBJECT*, void* context) noexcept {
+  auto& request{*static_cast<io_request*>(context)};
+  // The request may be gone after resuming
+  IoUninitializeWorkItem(get_work_item(request));
+  request.on_resume(request.context);
+}
+
+// Called at IRQL <= DISPATCH_LEVEL. The IRP is freed here rather than by the
+// I/O manager, so no APC is queued to the thread which has sent it
+NTSTATUS on_irp_completed(DEVICE_OBJECT*, IRP* irp, void* context) noexcept {
+  auto& request{*static_cast<io_request*>(context)};
+  request.result = {irp->IoStatus.Status, irp->IoStatus.Information};
+  if (irp->MdlAddress) {
+    IoFreeMdl(irp->MdlAddress);
+  }
+  IoFreeIrp(irp);
+
+  IoQueueWorkItem(get_work_item(request), &resume_on_worker, DelayedWorkQueue,
+                  addressof(request));
+  return STATUS_MORE_PROCESSING_REQUIRED;
+}
+}  // namespace
+
+bool submit(io_request& request) noexcept {
+  crt_assert_with_msg(IoSizeofWorkItem() <= sizeof(request.work_item),
+                      "the work item storage is too small");
+  // Initialized beforehand, as the completion routine can't fail. The item
+  // holds a reference to the driver, so it isn't unloaded while the request
+  // is waiting for a worker
+  IoInitializeWorkItem(crt::get_driver_object(), get_work_item(request));
+  DEVICE_OBJECT* device{IoGetRelatedDeviceObject(request.file)};
+  IRP* irp{IoAllocateIrp(device->StackSize, false)};
+  if (!irp) {
+    IoUninitializeWorkItem(get_work_item(request));
+    request.result = {STATUS_INSUFFICIENT_RESOURCES, 0};
+    return false;
+  }
+  if (device->Flags & DO_DIRECT_IO) {
+    // The buffer is non-paged, so the pages needn't be probed and locked
+    MDL* mdl{IoAllocateMdl(request.buffer, request.size, false, false, irp)};
+    if (!mdl) {
+      IoFreeIrp(irp);
+      IoUninitializeWorkItem(get_work_item(request));
+      request.result = {STATUS_INSUFFICIENT_RESOURCES, 0};
+      return false;
+    }
+    MmBuildMdlForNonPagedPool(mdl);
+  } else if (device->Flags & DO_BUFFERED_IO) {
+    irp->AssociatedIrp.SystemBuffer = request.buffer;
+  }
+  irp->UserBuffer = request.buffer;
+  irp->RequestorMode = KernelMode;
+  irp->Tail.Overlay.Thread = PsGetCurrentThread();
+  irp->Tail.Overlay.OriginalFileObject = request.file;
+
+  IO_STACK_LOCATION* stack{IoGetNextIrpStackLocation(irp)};
+  stack->FileObject = request.file;
+  if (request.direction == io_direction::read) {
+    irp->Flags = IRP_READ_OPERATION;
+    stack->MajorFunction = IRP_MJ_READ;
+    stack->Parameters.Read.Length = request.size;
+    stack->Parameters.Read.ByteOffset.QuadPart =
+        static_cast<LONGLONG>(request.offset);
+  } else {
+    irp->Flags = IRP_WRITE_OPERATION;
+    stack->MajorFunction = IRP_MJ_WRITE;
+    stack->Parameters.Write.Length = request.size;
+    stack->Parameters.Write.ByteOffset.QuadPart =
+        static_cast<LONGLONG>(request.offset);
+  }
+  IoSetCompletionRoutine(irp, &on_irp_completed, addressof(request), true,
+                         true, true);
+  // The request may be already completed and resumed when it returns
+  IoCallDriver(device, irp);
+  return true;
+}
+}  // namespace ktl::io::details
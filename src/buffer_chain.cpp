@@ -0,0 +1,176 @@
+#include <buffer_chain.hpp>
+
+#include <heap.hpp>
+#include <ktlexcept.hpp>
+#include <memory.hpp>
+#include <new_delete.hpp>
+
+namespace ktl {
+namespace mm::details {
+namespace {
+struct heap_slice_storage : slice_storage {
+  size_t size;
+
+  byte* bytes() noexcept { return reinterpret_cast<byte*>(this + 1); }
+
+  static void destroy_impl(slice_storage* storage) noexcept {
+    auto* target{static_cast<heap_slice_storage*>(storage)};
+    const size_t bytes_count{sizeof(heap_slice_storage) + target->size};
+    destroy_at(target);
+    deallocate_memory(free_request_builder{target, bytes_count}
+                          .set_pool_tag(crt::DEFAULT_HEAP_TAG)
+                          .build());
+  }
+};
+
+struct io_buffer_slice_storage : slice_storage {
+  io_buffer buffer;
+
+  static void destroy_impl(slice_storage* storage) noexcept {
+    delete static_cast<io_buffer_slice_storage*>(storage);
+  }
+};
+}  // namespace
+}  // namespace mm::details
+
+buffer_slice buffer_slice::allocate(size_t size) {
+  using mm::details::heap_slice_storage;
+
+  void* memory{allocate_memory<OnAllocationFailure::ThrowException>(
+      alloc_request_builder{sizeof(heap_slice_storage) + size, NonPagedPool}
+          .set_pool_tag(crt::DEFAULT_HEAP_TAG)
+          .build())};
+  auto* storage{new (memory) heap_slice_storage{}};
+  storage->destroy = &heap_slice_storage::destroy_impl;
+  storage->size = size;
+  return buffer_slice{storage_ptr{storage, false}, storage->bytes(), size};
+}
+
+buffer_slice buffer_slice::copy_of(span<const byte> data) {
+  auto slice{allocate(data.size())};
+  if (!data.empty()) {
+    memcpy(slice.writable_data().data(), data.data(), data.size());
+  }
+  return slice;
+}
+
+buffer_slice buffer_slice::adopt(io_buffer&& buffer, size_t size) {
+  using mm::details::io_buffer_slice_storage;
+
+  assert(buffer && size <= buffer.size());
+  // Released with the last slice, possibly at DISPATCH_LEVEL
+  auto* storage{new (non_paged_new) io_buffer_slice_storage{}};
+  storage->destroy = &io_buffer_slice_storage::destroy_impl;
+  storage->buffer = move(buffer);
+  return buffer_slice{storage_ptr{storage, false},
+                      static_cast<const byte*>(storage->buffer.data()), size};
+}
+
+void buffer_chain::append(buffer_slice slice) {
+  if (!slice.empty()) {
+    const size_t size{slice.size()};
+    m_segments.push_back(move(slice));
+    m_size += size;
+  }
+}
+
+// The slices are moved only into the reserved space, so a failed allocation
+// leaves both chains intact
+static_assert(is_nothrow_move_constructible_v<buffer_slice>);
+
+void buffer_chain::append(buffer_chain&& other) {
+  m_segments.reserve(m_segments.size() + other.m_segments.size());
+  for (auto& segment : other.m_segments) {
+    m_segments.push_back(move(segment));
+  }
+  m_size += other.m_size;
+  other.clear();
+}
+
+void buffer_chain::prepend(buffer_slice slice) {
+  if (!slice.empty()) {
+    const size_t size{slice.size()};
+    m_segments.insert(m_segments.begin(), move(slice));
+    m_size += size;
+  }
+}
+
+void buffer_chain::prepend(buffer_chain&& other) {
+  other.m_segments.reserve(other.m_segments.size() + m_segments.size());
+  for (auto& segment : m_segments) {
+    other.m_segments.push_back(move(segment));
+  }
+  other.m_size += m_size;
+  m_segments.swap(other.m_segments);
+  m_size = other.m_size;
+  other.clear();
+}
+
+buffer_chain buffer_chain::split(size_t offset) {
+  throw_exception_if<out_of_range>(offset > m_size,
+                                   "split offset is out of range");
+  size_t whole{0};  // Segments moved entirely
+  size_t remainder{offset};
+  while (remainder > 0 && m_segments[whole].size() <= remainder) {
+    remainder -= m_segments[whole].size();
+    ++whole;
+  }
+  buffer_chain head;
+  head.m_segments.reserve(whole + (remainder > 0 ? 1 : 0));
+  for (size_t idx = 0; idx < whole; ++idx) {
+    head.m_segments.push_back(move(m_segments[idx]));
+  }
+  if (remainder > 0) {
+    auto& segment{m_segments[whole]};
+    head.m_segments.push_back(segment.subslice(0, remainder));
+    segment.remove_prefix(remainder);
+  }
+  head.m_size = offset;
+  m_segments.erase(m_segments.begin(), m_segments.begin() + whole);
+  m_size -= offset;
+  return head;
+}
+
+span<const byte> buffer_chain::coalesce() {
+  if (m_segments.size() > 1) {
+    auto merged{buffer_slice::allocate(m_size)};
+    copy_to(merged.writable_data());
+    m_segments.clear();
+    m_segments.push_back(move(merged));
+  }
+  return m_segments.empty() ? span<const byte>{} : m_segments.front().data();
+}
+
+size_t buffer_chain::copy_to(span<byte> destination,
+                             size_t offset) const noexcept {
+  size_t copied{0};
+  for (const auto& segment : m_segments) {
+    if (copied == destination.size()) {
+      break;
+    }
+    if (offset >= segment.size()) {
+      offset -= segment.size();
+      continue;
+    }
+    const auto source{segment.data().subspan(offset,
+                                             destination.size() - copied)};
+    memcpy(destination.data() + copied, source.data(), source.size());
+    copied += source.size();
+    offset = 0;
+  }
+  return copied;
+}
+
+uint64_t buffer_chain::hash() const noexcept {
+  static constexpr uint64_t OFFSET_BASIS{UINT64_C(0xcbf29ce484222325)};
+  static constexpr uint64_t PRIME{UINT64_C(0x100000001b3)};
+
+  uint64_t hash{OFFSET_BASIS};
+  for (const auto& segment : m_segments) {
+    for (const byte value : segment.data()) {
+      hash = (hash ^ value) * PRIME;
+    }
+  }
+  return hash;
+}
+}  // namespace ktl
@@ -0,0 +1,45 @@
+#include <callback_list.hpp>
+
+#include <chrono.hpp>
+#include <thread.hpp>
+
+namespace ktl::cb::details {
+static constexpr uint32_t READER_SPIN_COUNT{16};
+static constexpr chrono::milliseconds READER_POLL_INTERVAL{1};
+
+void reader_epoch::synchronize() noexcept {
+  // The new data is published before the counters are read
+  atomic_thread_fence<memory_order_seq_cst>();
+  const uint32_t epoch{m_epoch.load<memory_order_relaxed>()};
+  // The readers which have taken the inactive index before the previous flip
+  // may still use the old data
+  wait_for_readers((epoch + 1) & 1);
+  m_epoch.store(epoch + 1);
+  wait_for_readers(epoch & 1);
+}
+
+bool reader_epoch::has_readers(uint32_t idx) const noexcept {
+  uint64_t exits{0};
+  m_counters.for_each([idx, &exits](const counters& target) {
+    exits += target.exits[idx].load<memory_order_relaxed>();
+  });
+  // A reader whose exit is in the sum has its entry in the next one, so the
+  // readers which are still inside can't make the sums equal
+  atomic_thread_fence<memory_order_seq_cst>();
+  uint64_t entries{0};
+  m_counters.for_each([idx, &entries](const counters& target) {
+    entries += target.entries[idx].load<memory_order_relaxed>();
+  });
+  return entries != exits;
+}
+
+void reader_epoch::wait_for_readers(uint32_t idx) const noexcept {
+  for (uint32_t attempt = 0; has_readers(idx); ++attempt) {
+    if (attempt < READER_SPIN_COUNT) {
+      this_thread::yield();
+    } else {
+      this_thread::sleep_for(READER_POLL_INTERVAL);
+    }
+  }
+}
+}  // namespace ktl::cb::details
@@ -0,0 +1,204 @@
+#include <crc32c.hpp>
+
+#include <cpu_features.hpp>
+#include <intrinsic.hpp>
+#include <utility.hpp>
+
+namespace ktl {
+namespace crc::details {
+namespace {
+inline constexpr uint32_t POLYNOMIAL{0x82f63b78};  // Reflected 0x1edc6f41
+
+// Blocks processed by the 3 interleaved crc32 streams: the long ones hide the
+// latency of the instruction, the short ones keep the tail fast
+inline constexpr size_t LONG_BLOCK{8192};
+inline constexpr size_t SHORT_BLOCK{256};
+
+// Multiplies polynomials a and b modulo POLYNOMIAL. Bit 31 is x^0
+constexpr uint32_t multiply_mod(uint32_t a, uint32_t b) noexcept {
+  uint32_t mask{1u << 31};
+  uint32_t product{0};
+  for (;;) {
+    if (a & mask) {
+      product ^= b;
+      if ((a & (mask - 1)) == 0) {
+        break;
+      }
+    }
+    mask >>= 1;
+    b = b & 1 ? (b >> 1) ^ POLYNOMIAL : b >> 1;
+  }
+  return product;
+}
+
+struct crc_tables {
+  uint32_t x2n[32];  // x^(2^n) modulo POLYNOMIAL
+  uint32_t slices[8][256];
+  uint32_t long_shift[4][256];
+  uint32_t short_shift[4][256];
+};
+
+// x^(n * 2^k) modulo POLYNOMIAL
+constexpr uint32_t x2n_mod(const uint32_t (&x2n)[32],
+                           size_t n,
+                           uint32_t k) noexcept {
+  uint32_t product{1u << 31};
+  for (; n; n >>= 1, ++k) {
+    if (n & 1) {
+      product = multiply_mod(x2n[k & 31], product);
+    }
+  }
+  return product;
+}
+
+// Tables appending the given number of zero bytes to the crc register. The
+// operator is linear, so the entry for a byte is built from the bits of it
+constexpr void fill_shift_table(uint32_t (&table)[4][256],
+                                const uint32_t (&x2n)[32],
+                                size_t zeros_count) noexcept {
+  const uint32_t op{x2n_mod(x2n, zeros_count, 3)};
+  for (uint32_t slice = 0; slice < 4; ++slice) {
+    table[slice][0] = 0;
+    for (uint32_t value = 1; value < 256; ++value) {
+      const uint32_t low_bit{value & (0u - value)};
+      table[slice][value] =
+          value == low_bit
+              ? multiply_mod(op, low_bit << (8 * slice))
+              : table[slice][value ^ low_bit] ^ table[slice][low_bit];
+    }
+  }
+}
+
+constexpr crc_tables make_tables() noexcept {
+  crc_tables tables{};
+  uint32_t power{1u << 30};  // x^1
+  tables.x2n[0] = power;
+  for (uint32_t n = 1; n < 32; ++n) {
+    power = multiply_mod(power, power);
+    tables.x2n[n] = power;
+  }
+  for (uint32_t value = 0; value < 256; ++value) {
+    uint32_t crc{value};
+    for (int bit = 0; bit < 8; ++bit) {
+      crc = crc & 1 ? (crc >> 1) ^ POLYNOMIAL : crc >> 1;
+    }
+    tables.slices[0][value] = crc;
+  }
+  for (uint32_t value = 0; value < 256; ++value) {
+    uint32_t crc{tables.slices[0][value]};
+    for (uint32_t slice = 1; slice < 8; ++slice) {
+      crc = tables.slices[0][crc & 0xff] ^ (crc >> 8);
+      tables.slices[slice][value] = crc;
+    }
+  }
+  fill_shift_table(tables.long_shift, tables.x2n, LONG_BLOCK);
+  fill_shift_table(tables.short_shift, tables.x2n, SHORT_BLOCK);
+  return tables;
+}
+
+constexpr crc_tables TABLES{make_tables()};
+
+inline uint32_t shift(const uint32_t (&table)[4][256], uint32_t crc) noexcept {
+  return table[0][crc & 0xff] ^ table[1][(crc >> 8) & 0xff] ^
+         table[2][(crc >> 16) & 0xff] ^ table[3][crc >> 24];
+}
+
+#if BITNESS == 64
+using crc_word_t = uint64_t;
+
+TARGET_ISA("sse4.2")
+inline crc_word_t crc32_word(crc_word_t crc, const byte* data) noexcept {
+  return _mm_crc32_u64(crc, unaligned_load<uint64_t>(data));
+}
+#else
+using crc_word_t = uint32_t;
+
+TARGET_ISA("sse4.2")
+inline crc_word_t crc32_word(crc_word_t crc, const byte* data) noexcept {
+  return _mm_crc32_u32(crc, unaligned_load<uint32_t>(data));
+}
+#endif
+
+inline constexpr size_t WORD_SIZE{sizeof(crc_word_t)};
+
+// Processes 3 adjacent blocks at once and merges their crc registers
+TARGET_ISA("sse4.2")
+inline const byte* crc32_interleaved(
+    crc_word_t& crc,
+    const byte* data,
+    size_t block_size,
+    const uint32_t (&shift_table)[4][256]) noexcept {
+  crc_word_t crc1{0};
+  crc_word_t crc2{0};
+  for (const byte* end = data + block_size; data < end; data += WORD_SIZE) {
+    crc = crc32_word(crc, data);
+    crc1 = crc32_word(crc1, data + block_size);
+    crc2 = crc32_word(crc2, data + 2 * block_size);
+  }
+  crc = shift(shift_table, static_cast<uint32_t>(crc)) ^ crc1;
+  crc = shift(shift_table, static_cast<uint32_t>(crc)) ^ crc2;
+  return data + 2 * block_size;
+}
+}  // namespace
+
+uint32_t crc32c_generic(uint32_t crc, const byte* data, size_t size) noexcept {
+  const auto& slices{TABLES.slices};
+  crc = ~crc;
+  for (; size && reinterpret_cast<uintptr_t>(data) & 7; --size) {
+    crc = slices[0][(crc ^ *data++) & 0xff] ^ (crc >> 8);
+  }
+  for (; size >= 8; size -= 8, data += 8) {
+    const uint32_t low{crc ^ unaligned_load<uint32_t>(data)};
+    const uint32_t high{unaligned_load<uint32_t>(data + 4)};
+    crc = slices[7][low & 0xff] ^ slices[6][(low >> 8) & 0xff] ^
+          slices[5][(low >> 16) & 0xff] ^ slices[4][low >> 24] ^
+          slices[3][high & 0xff] ^ slices[2][(high >> 8) & 0xff] ^
+          slices[1][(high >> 16) & 0xff] ^ slices[0][high >> 24];
+  }
+  for (; size; --size) {
+    crc = slices[0][(crc ^ *data++) & 0xff] ^ (crc >> 8);
+  }
+  return ~crc;
+}
+
+TARGET_ISA("sse4.2")
+uint32_t crc32c_sse42(uint32_t crc, const byte* data, size_t size) noexcept {
+  crc_word_t state{~crc};
+  for (; size && reinterpret_cast<uintptr_t>(data) & (WORD_SIZE - 1);
+       --size) {
+    state = _mm_crc32_u8(static_cast<uint32_t>(state), *data++);
+  }
+  for (; size >= 3 * LONG_BLOCK; size -= 3 * LONG_BLOCK) {
+    data = crc32_interleaved(state, data, LONG_BLOCK, TABLES.long_shift);
+  }
+  for (; size >= 3 * SHORT_BLOCK; size -= 3 * SHORT_BLOCK) {
+    data = crc32_interleaved(state, data, SHORT_BLOCK, TABLES.short_shift);
+  }
+  for (; size >= WORD_SIZE; size -= WORD_SIZE, data += WORD_SIZE) {
+    state = crc32_word(state, data);
+  }
+  for (; size; --size) {
+    state = _mm_crc32_u8(static_cast<uint32_t>(state), *data++);
+  }
+  return ~static_cast<uint32_t>(state);
+}
+
+static constexpr cpu::implementation<uint32_t(uint32_t, const byte*, size_t)>
+    CRC32C_VERSIONS[]{{cpu_feature::sse42, &crc32c_sse42},
+                      {{}, &crc32c_generic}};
+
+static cpu::dispatched crc32c_dispatched{CRC32C_VERSIONS};
+}  // namespace crc::details
+
+uint32_t crc32c_update(uint32_t crc, const void* data, size_t size) noexcept {
+  return crc::details::crc32c_dispatched(crc, static_cast<const byte*>(data),
+                                         size);
+}
+
+uint32_t crc32c_combine(uint32_t crc1, uint32_t crc2, size_t size2) noexcept {
+  using crc::details::TABLES;
+  return crc::details::multiply_mod(
+             crc::details::x2n_mod(TABLES.x2n, size2, 3), crc1) ^
+         crc2;
+}
+}  // namespace ktl
@@ -0,0 +1,184 @@
+#include <io_buffer_pool.hpp>
+
+#include <algorithm.hpp>
+
+#include <ntddk.h>
+
+namespace ktl {
+io_buffer_pool::io_buffer_pool(const io_buffer_pool_options& options)
+    : m_options{options}, m_caches{cpu_cache{}} {
+  m_options.cache_depth = (min)(m_options.cache_depth, MAX_CACHE_DEPTH);
+  for (auto& state : m_classes) {
+    InitializeSListHead(addressof(state.shared));
+  }
+}
+
+io_buffer_pool::~io_buffer_pool() noexcept {
+  m_caches.for_each([this](cpu_cache& cache) {
+    for (uint32_t size_class = 0; size_class < SIZE_CLASS_COUNT;
+         ++size_class) {
+      for (uint32_t idx = 0; idx < cache.count[size_class]; ++idx) {
+        destroy_entry(cache.entries[size_class][idx]);
+      }
+      cache.count[size_class] = 0;
+    }
+  });
+  trim();
+}
+
+io_buffer io_buffer_pool::acquire(size_t size) noexcept {
+  const uint32_t size_class{get_size_class(size)};
+  if (size_class == SIZE_CLASS_COUNT) {
+    return io_buffer{};
+  }
+  auto& state{m_classes[size_class]};
+  entry_type* entry{pop_cached(size_class)};
+  if (!entry) {
+    entry = create_entry(size_class);
+    if (!entry) {
+      state.failed.fetch_add<memory_order_relaxed>(1);
+      return io_buffer{};
+    }
+    state.created.fetch_add<memory_order_relaxed>(1);
+  }
+  state.acquired.fetch_add<memory_order_relaxed>(1);
+
+  const size_t in_use{state.in_use.fetch_add<memory_order_relaxed>(1) + 1};
+  size_t high_water{state.high_water.load<memory_order_relaxed>()};
+  while (in_use > high_water &&
+         !state.high_water.compare_exchange_strong(high_water, in_use)) {
+  }
+  return io_buffer{this, entry};
+}
+
+void io_buffer_pool::trim() noexcept {
+  release_shared();
+}
+
+size_t io_buffer_pool::trim(trim_level level) noexcept {
+  size_t released{release_shared()};
+  if (level == trim_level::light) {
+    return released;
+  }
+  run_on_each_processor([this, level, &released] {
+    auto& cache{m_caches.local()};
+    for (uint32_t size_class = 0; size_class < SIZE_CLASS_COUNT;
+         ++size_class) {
+      auto& count{cache.count[size_class]};
+      for (size_t idx = get_trim_count(count, level); idx > 0; --idx) {
+        destroy_entry(cache.entries[size_class][--count]);
+        released += get_buffer_size(size_class);
+      }
+    }
+  });
+  return released;
+}
+
+io_buffer_pool_stats io_buffer_pool::stats(
+    uint32_t size_class) const noexcept {
+  const auto& state{m_classes[size_class]};
+  return {get_buffer_size(size_class),
+          state.acquired.load<memory_order_relaxed>(),
+          state.created.load<memory_order_relaxed>(),
+          state.failed.load<memory_order_relaxed>(),
+          state.in_use.load<memory_order_relaxed>(),
+          state.high_water.load<memory_order_relaxed>()};
+}
+
+void io_buffer_pool::release(entry_type* entry) noexcept {
+  const uint32_t size_class{entry->size_class};
+  auto& state{m_classes[size_class]};
+  state.in_use.fetch_sub(1);
+  if (entry->mdl) {
+    entry->mdl->Next = nullptr;  // Might be chained by the user
+  }
+  {
+    dispatch_level_guard guard;
+    auto& cache{m_caches.local()};
+    if (auto& count = cache.count[size_class]; count < m_options.cache_depth) {
+      cache.entries[size_class][count++] = entry;
+      return;
+    }
+  }
+  if (ExQueryDepthSList(addressof(state.shared)) < m_options.shared_depth) {
+    InterlockedPushEntrySList(addressof(state.shared), addressof(entry->link));
+  } else {
+    destroy_entry(entry);
+  }
+}
+
+size_t io_buffer_pool::release_shared() noexcept {
+  size_t released{0};
+  for (uint32_t size_class = 0; size_class < SIZE_CLASS_COUNT; ++size_class) {
+    auto* list{InterlockedFlushSList(addressof(m_classes[size_class].shared))};
+    while (list) {
+      auto* entry{CONTAINING_RECORD(list, entry_type, link)};
+      list = list->Next;
+      destroy_entry(entry);
+      released += get_buffer_size(size_class);
+    }
+  }
+  return released;
+}
+
+auto io_buffer_pool::pop_cached(uint32_t size_class) noexcept -> entry_type* {
+  {
+    dispatch_level_guard guard;
+    auto& cache{m_caches.local()};
+    if (auto& count = cache.count[size_class]; count > 0) {
+      return cache.entries[size_class][--count];
+    }
+  }
+  auto* link{InterlockedPopEntrySList(addressof(m_classes[size_class].shared))};
+  return link ? CONTAINING_RECORD(link, entry_type, link) : nullptr;
+}
+
+auto io_buffer_pool::create_entry(uint32_t size_class) noexcept
+    -> entry_type* {
+  auto* entry{static_cast<entry_type*>(
+      allocate_memory(alloc_request_builder{sizeof(entry_type), NonPagedPool}
+                          .set_alignment(static_cast<align_val_t>(
+                              MEMORY_ALLOCATION_ALIGNMENT))
+                          .set_pool_tag(m_options.pool_tag)
+                          .build()))};
+  if (!entry) {
+    return nullptr;
+  }
+  const size_t size{get_buffer_size(size_class)};
+  entry->size_class = size_class;
+  entry->mdl = nullptr;
+  entry->data =
+      allocate_memory(alloc_request_builder{size, NonPagedPool}
+                          .set_alignment(crt::MAX_ALLOCATION_ALIGNMENT)
+                          .set_pool_tag(m_options.pool_tag)
+                          .build());
+  if (entry->data && m_options.build_mdl) {
+    entry->mdl = IoAllocateMdl(entry->data, static_cast<ULONG>(size), false,
+                               false, nullptr);
+    if (entry->mdl) {
+      MmBuildMdlForNonPagedPool(entry->mdl);
+    }
+  }
+  if (!entry->data || (m_options.build_mdl && !entry->mdl)) {
+    destroy_entry(entry);
+    return nullptr;
+  }
+  return entry;
+}
+
+void io_buffer_pool::destroy_entry(entry_type* entry) noexcept {
+  if (entry->mdl) {
+    IoFreeMdl(entry->mdl);
+  }
+  deallocate_memory(
+      free_request_builder{entry->data, get_buffer_size(entry->size_class)}
+          .set_alignment(crt::MAX_ALLOCATION_ALIGNMENT)
+          .set_pool_tag(m_options.pool_tag)
+          .build());
+  deallocate_memory(free_request_builder{entry, sizeof(entry_type)}
+                        .set_alignment(static_cast<align_val_t>(
+                            MEMORY_ALLOCATION_ALIGNMENT))
+                        .set_pool_tag(m_options.pool_tag)
+                        .build());
+}
+}  // namespace ktl
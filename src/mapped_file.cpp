@@ -0,0 +1,141 @@
+#include <mapped_file.hpp>
+
+#include <algorithm.hpp>
+#include <ktlexcept.hpp>
+#include <string_view.hpp>
+
+#include <ntddk.h>
+
+namespace ktl {
+namespace mm::details {
+// Offsets of the views must be multiples of the allocation granularity
+inline constexpr uint64_t VIEW_ALIGNMENT{64 * 1024};
+}  // namespace mm::details
+
+mapped_file::mapped_file(unicode_string_view path) {
+  OBJECT_ATTRIBUTES attributes;
+  InitializeObjectAttributes(
+      addressof(attributes), const_cast<UNICODE_STRING*>(path.raw_str()),
+      OBJ_KERNEL_HANDLE | OBJ_CASE_INSENSITIVE, nullptr, nullptr);
+  HANDLE file;
+  IO_STATUS_BLOCK io_status;
+  NTSTATUS status{ZwCreateFile(
+      addressof(file), FILE_READ_DATA | SYNCHRONIZE, addressof(attributes),
+      addressof(io_status), nullptr, FILE_ATTRIBUTE_NORMAL, FILE_SHARE_READ,
+      FILE_OPEN, FILE_NON_DIRECTORY_FILE | FILE_SYNCHRONOUS_IO_NONALERT,
+      nullptr, 0)};
+  throw_exception_if_not<kernel_error>(NT_SUCCESS(status), status,
+                                       "unable to open the file");
+  status = create_section(file);
+  ZwClose(file);  // The section references the file
+  throw_exception_if_not<kernel_error>(NT_SUCCESS(status), status,
+                                       "unable to map the file");
+}
+
+mapped_file::mapped_file(HANDLE file) {
+  const NTSTATUS status{create_section(file)};
+  throw_exception_if_not<kernel_error>(NT_SUCCESS(status), status,
+                                       "unable to map the file");
+}
+
+NTSTATUS mapped_file::create_section(HANDLE file) noexcept {
+  IO_STATUS_BLOCK io_status;
+  FILE_STANDARD_INFORMATION info;
+  NTSTATUS status{ZwQueryInformationFile(file, addressof(io_status),
+                                         addressof(info), sizeof(info),
+                                         FileStandardInformation)};
+  if (!NT_SUCCESS(status)) {
+    return status;
+  }
+  if (info.EndOfFile.QuadPart <= 0) {
+    return STATUS_MAPPED_FILE_SIZE_ZERO;
+  }
+  OBJECT_ATTRIBUTES attributes;
+  InitializeObjectAttributes(addressof(attributes), nullptr, OBJ_KERNEL_HANDLE,
+                             nullptr, nullptr);
+  status = ZwCreateSection(addressof(m_section), SECTION_MAP_READ,
+                           addressof(attributes), nullptr, PAGE_READONLY,
+                           SEC_COMMIT, file);
+  if (NT_SUCCESS(status)) {
+    m_size = static_cast<uint64_t>(info.EndOfFile.QuadPart);
+  }
+  return status;
+}
+
+void mapped_file::close() noexcept {
+  if (m_section) {
+    ZwClose(m_section);
+    m_section = nullptr;
+  }
+  m_size = 0;
+}
+
+mapped_view mapped_file::map(uint64_t offset, size_t size) const {
+  using mm::details::VIEW_ALIGNMENT;
+
+  throw_exception_if_not<out_of_range>(offset < m_size,
+                                       "offset is beyond the end of the file");
+  size = static_cast<size_t>((min)(uint64_t{size}, m_size - offset));
+  if (!size) {
+    return {};
+  }
+  const uint64_t aligned_offset{offset & ~(VIEW_ALIGNMENT - 1)};
+  const auto delta{static_cast<size_t>(offset - aligned_offset)};
+
+  LARGE_INTEGER section_offset;
+  section_offset.QuadPart = static_cast<LONGLONG>(aligned_offset);
+  SIZE_T view_size{delta + size};
+  void* base{nullptr};
+  const NTSTATUS status{ZwMapViewOfSection(
+      m_section, ZwCurrentProcess(), addressof(base), 0, 0,
+      addressof(section_offset), addressof(view_size), ViewUnmap, 0,
+      PAGE_READONLY)};
+  throw_exception_if_not<kernel_error>(NT_SUCCESS(status), status,
+                                       "unable to map the file view");
+  return mapped_view{base, static_cast<const byte*>(base) + delta, size,
+                     offset};
+}
+
+void mapped_view::prefetch([[maybe_unused]] size_t offset,
+                           [[maybe_unused]] size_t size) const noexcept {
+#if WINVER >= _WIN32_WINNT_WINBLUE
+  if (offset >= m_size || !size) {
+    return;
+  }
+  MEMORY_RANGE_ENTRY range;
+  range.VirtualAddress = const_cast<byte*>(m_data + offset);
+  range.NumberOfBytes = (min)(size, m_size - offset);
+  ZwSetInformationVirtualMemory(ZwCurrentProcess(), VmPrefetchInformation, 1,
+                                addressof(range), nullptr, 0);
+#endif
+}
+
+void mapped_view::reset() noexcept {
+  if (m_base) {
+    ZwUnmapViewOfSection(ZwCurrentProcess(), m_base);
+  }
+  m_base = nullptr;
+  m_data = nullptr;
+  m_size = 0;
+  m_offset = 0;
+}
+
+span<const byte> mapped_stream_reader::next() {
+  m_view.reset();
+  if (eof()) {
+    return {};
+  }
+  // The next window is mapped along with the current one to be prefetched
+  // while the caller processes the current window
+  m_view = m_file->map(m_position, 2 * m_window_size);
+  const size_t size{(min)(m_window_size, m_view.size())};
+  m_view.prefetch(size, m_view.size() - size);
+  m_position += size;
+  return m_view.bytes().first(size);
+}
+
+void mapped_stream_reader::seek(uint64_t position) noexcept {
+  m_view.reset();
+  m_position = position;
+}
+}  // namespace ktl
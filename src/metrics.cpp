@@ -0,0 +1,156 @@
+#include <metrics.hpp>
+
+#include <ktlexcept.hpp>
+#include <new_delete.hpp>
+
+namespace ktl {
+namespace metrics::details {
+namespace {
+constexpr size_t align_entry(size_t size) noexcept {
+  return (size + 7) & ~static_cast<size_t>(7);
+}
+
+constexpr size_t get_entry_size(size_t name_size,
+                                uint32_t value_count) noexcept {
+  return sizeof(snapshot_entry) + align_entry(name_size) +
+         sizeof(uint64_t) * value_count;
+}
+}  // namespace
+}  // namespace metrics::details
+
+uint64_t per_cpu_counter::value() const noexcept {
+  uint64_t result{0};
+  m_values.for_each([&result](const atomic<uint64_t>& value) {
+    result += value.load<memory_order_relaxed>();
+  });
+  return result;
+}
+
+uint32_t per_cpu_counter::collect(uint64_t* values) const noexcept {
+  values[0] = value();
+  return 1;
+}
+
+uint32_t gauge::collect(uint64_t* values) const noexcept {
+  values[0] = static_cast<uint64_t>(value());
+  return 1;
+}
+
+uint64_t histogram::count() const noexcept {
+  uint64_t result{0};
+  m_cells.for_each([&result](const cells& local) {
+    for (const auto& bucket : local.buckets) {
+      result += bucket.load<memory_order_relaxed>();
+    }
+  });
+  return result;
+}
+
+uint64_t histogram::sum() const noexcept {
+  uint64_t result{0};
+  m_cells.for_each([&result](const cells& local) {
+    result += local.sum.load<memory_order_relaxed>();
+  });
+  return result;
+}
+
+uint32_t histogram::collect(uint64_t* values) const noexcept {
+  uint64_t* buckets{values + 2};
+  for (uint32_t idx = 0; idx < BUCKET_COUNT; ++idx) {
+    buckets[idx] = 0;
+  }
+  values[0] = 0;
+  values[1] = 0;
+  m_cells.for_each([values, buckets](const cells& local) {
+    for (uint32_t idx = 0; idx < BUCKET_COUNT; ++idx) {
+      const uint64_t count{local.buckets[idx].load<memory_order_relaxed>()};
+      buckets[idx] += count;
+      values[0] += count;
+    }
+    values[1] += local.sum.load<memory_order_relaxed>();
+  });
+
+  uint32_t bucket_count{BUCKET_COUNT};
+  while (bucket_count && !buckets[bucket_count - 1]) {
+    --bucket_count;
+  }
+  return bucket_count + 2;
+}
+
+per_cpu_counter& metrics_registry::add_counter(uint32_t id,
+                                               ansi_string_view name) {
+  return add<per_cpu_counter>(id, name, metrics::metric_type::counter);
+}
+
+gauge& metrics_registry::add_gauge(uint32_t id, ansi_string_view name) {
+  return add<gauge>(id, name, metrics::metric_type::gauge);
+}
+
+histogram& metrics_registry::add_histogram(uint32_t id,
+                                           ansi_string_view name) {
+  return add<histogram>(id, name, metrics::metric_type::histogram);
+}
+
+template <class Metric>
+Metric& metrics_registry::add(uint32_t id,
+                              ansi_string_view name,
+                              metrics::metric_type type) {
+  for (const auto& registered : m_entries) {
+    throw_exception_if_not<invalid_argument>(registered.id != id,
+                                             "metric ID is already used");
+  }
+  // Updated at any IRQL, even by the IPI routines
+  unique_ptr<Metric> metric{new (non_paged_new) Metric{}};
+  Metric& result{*metric};
+  m_entries.push_back(entry{id, type, name, move(metric)});
+  return result;
+}
+
+size_t metrics_registry::max_snapshot_size() const noexcept {
+  size_t size{sizeof(metrics::snapshot_header)};
+  for (const auto& registered : m_entries) {
+    size += metrics::details::get_entry_size(
+        registered.name.size(), metrics::details::metric::MAX_VALUE_COUNT);
+  }
+  return size;
+}
+
+size_t metrics_registry::snapshot(span<byte> buffer) const noexcept {
+  using metrics::details::get_entry_size;
+
+  // The values are collected once, so the size matches the written data
+  // even though the histograms change concurrently
+  uint64_t values[metrics::details::metric::MAX_VALUE_COUNT];
+  byte* const first{buffer.data()};
+  const size_t capacity{buffer.size()};
+
+  size_t size{sizeof(metrics::snapshot_header)};
+  for (const auto& registered : m_entries) {
+    const uint32_t value_count{registered.metric->collect(values)};
+    const size_t name_size{registered.name.size()};
+    const size_t entry_size{get_entry_size(name_size, value_count)};
+    if (size + entry_size <= capacity) {
+      const metrics::snapshot_entry header{
+          registered.id, registered.type, 0, static_cast<uint16_t>(name_size),
+          value_count,   0};
+      byte* position{first + size};
+      memcpy(position, addressof(header), sizeof(header));
+      position += sizeof(header);
+      memcpy(position, registered.name.data(), name_size);
+      memset(position + name_size, 0,
+             metrics::details::align_entry(name_size) - name_size);
+      position += metrics::details::align_entry(name_size);
+      memcpy(position, values, sizeof(uint64_t) * value_count);
+    }
+    size += entry_size;
+  }
+
+  if (size <= capacity) {
+    const metrics::snapshot_header header{
+        metrics::SNAPSHOT_MAGIC, metrics::SNAPSHOT_VERSION,
+        static_cast<uint32_t>(size), static_cast<uint32_t>(m_entries.size())};
+    memcpy(first, addressof(header), sizeof(header));
+  }
+  return size;
+}
+}  // namespace ktl
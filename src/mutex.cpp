@@ -70,26 +70,31 @@ void shared_mutex::unlock_shared() noexcept {
 }
 
 namespace th::details {
+template <>
 void spin_lock_policy<SpinlockType::DpcOnly>::lock(
     KSPIN_LOCK& target) const noexcept {
   KeAcquireSpinLockAtDpcLevel(addressof(target));
 }
 
+template <>
 bool spin_lock_policy<SpinlockType::DpcOnly>::try_lock(
     KSPIN_LOCK& target) const noexcept {
   return KeTryToAcquireSpinLockAtDpcLevel(addressof(target));
 }
 
+template <>
 void spin_lock_policy<SpinlockType::DpcOnly>::unlock(
     KSPIN_LOCK& target) const noexcept {
   KeReleaseSpinLockFromDpcLevel(addressof(target));
 }
 
+template <>
 void spin_lock_policy<SpinlockType::Mixed>::lock(
     KSPIN_LOCK& target) const noexcept {
   m_prev_irql = KeAcquireSpinLockRaiseToDpc(addressof(target));
 }
 
+template <>
 bool spin_lock_policy<SpinlockType::Mixed>::try_lock(
     KSPIN_LOCK& target) const noexcept {
   const irql_t prev_irql{raise_irql(DISPATCH_LEVEL)};
@@ -101,11 +106,13 @@ bool spin_lock_policy<SpinlockType::Mixed>::try_lock(
   return true;
 }
 
+template <>
 void spin_lock_policy<SpinlockType::Mixed>::unlock(
     KSPIN_LOCK& target) const noexcept {
   KeReleaseSpinLock(addressof(target), m_prev_irql);
 }
 
+template <>
 void queued_spin_lock_policy<SpinlockType::DpcOnly>::lock(
     KSPIN_LOCK& target,
     KLOCK_QUEUE_HANDLE& queue_handle) const noexcept {
@@ -113,17 +120,20 @@ void queued_spin_lock_policy<SpinlockType::DpcOnly>::lock(
                                            addressof(queue_handle));
 }
 
+template <>
 void queued_spin_lock_policy<SpinlockType::DpcOnly>::unlock(
     KLOCK_QUEUE_HANDLE& queue_handle) const noexcept {
   KeReleaseInStackQueuedSpinLockFromDpcLevel(addressof(queue_handle));
 }
 
+template <>
 void queued_spin_lock_policy<SpinlockType::Mixed>::lock(
     KSPIN_LOCK& target,
     KLOCK_QUEUE_HANDLE& queue_handle) const noexcept {
   KeAcquireInStackQueuedSpinLock(addressof(target), addressof(queue_handle));
 }
 
+template <>
 void queued_spin_lock_policy<SpinlockType::Mixed>::unlock(
     KLOCK_QUEUE_HANDLE& queue_handle) const noexcept {
   KeReleaseInStackQueuedSpinLock(addressof(queue_handle));
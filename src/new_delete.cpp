@@ -26,10 +26,21 @@ static void* operator_new_impl(
     if (memory) {
       return memory;
     }
-    if (const auto handler = get_new_handler(); handler) {
-      handler();
+    if (const auto handler = get_new_handler(); !handler) {
+      if constexpr (OnFailure == OnAllocationFailure::ThrowException) {
+        throw bad_alloc{};
+      } else {
+        return nullptr;
+      }
     } else if constexpr (OnFailure == OnAllocationFailure::ThrowException) {
-      throw bad_alloc{};
+      handler();
+    } else {
+      // The handler reports that no more memory can be released by throwing
+      try {
+        handler();
+      } catch ([[maybe_unused]] const bad_alloc& exc) {
+        return nullptr;
+      }
     }
   }
 }
@@ -51,14 +62,15 @@ static void operator_delete_impl(void* memory,
 }  // namespace mm::details
 
 new_handler_t get_new_handler() noexcept {
-  return static_cast<new_handler_t>(InterlockedCompareExchangePointer(
+  return reinterpret_cast<new_handler_t>(InterlockedCompareExchangePointer(
       reinterpret_cast<volatile PVOID*>(&mm::details::new_handler), nullptr,
       nullptr));
 }
 
 new_handler_t set_new_handler(new_handler_t new_h) noexcept {
-  return static_cast<new_handler_t>(InterlockedExchangePointer(
-      reinterpret_cast<volatile PVOID*>(&mm::details::new_handler), new_h));
+  return reinterpret_cast<new_handler_t>(InterlockedExchangePointer(
+      reinterpret_cast<volatile PVOID*>(&mm::details::new_handler),
+      reinterpret_cast<PVOID>(new_h)));
 }
 }  // namespace ktl
 
@@ -0,0 +1,273 @@
+#include <packed_vector.hpp>
+
+#include <cpu_features.hpp>
+#include <floating_point.hpp>
+#include <intrinsic.hpp>
+
+#include <smmintrin.h>
+#include <tmmintrin.h>
+
+#include <ntddk.h>
+
+namespace ktl {
+namespace pv::details {
+namespace {
+// Widest value whose 4 bytes starting at any bit offset in [0, 8) hold it
+constexpr uint32_t MAX_SIMD_BITS{25};
+constexpr size_t SIMD_VALUES{4};
+
+void update_word_atomic(uint64_t* word, uint64_t mask, uint64_t value) {
+  auto* target{reinterpret_cast<volatile LONG64*>(word)};
+  LONG64 expected{*target};
+  for (;;) {
+    const auto desired{static_cast<LONG64>(
+        (static_cast<uint64_t>(expected) & ~mask) | value)};
+    const LONG64 prev{
+        InterlockedCompareExchange64(target, desired, expected)};
+    if (prev == expected) {
+      break;
+    }
+    expected = prev;
+  }
+}
+
+struct lane_layout {
+  __m128i shuffle;
+  __m128i multiplier;
+};
+
+// Places the 4 bytes holding each value into its 32-bit lane and prepares
+// the multipliers shifting the value to the top of the lane. The first value
+// starts at bit `offset` < 8 of the loaded bytes
+lane_layout make_layout(uint32_t offset, uint32_t bits) noexcept {
+  alignas(16) uint8_t shuffle[16];
+  alignas(16) uint32_t multiplier[SIMD_VALUES];
+  for (uint32_t lane = 0; lane < SIMD_VALUES; ++lane) {
+    const uint32_t start{offset + lane * bits};
+    for (uint32_t idx = 0; idx < 4; ++idx) {
+      shuffle[lane * 4 + idx] = static_cast<uint8_t>(start / 8 + idx);
+    }
+    multiplier[lane] = 1u << (32 - start % 8 - bits);
+  }
+  return {_mm_load_si128(reinterpret_cast<const __m128i*>(shuffle)),
+          _mm_load_si128(reinterpret_cast<const __m128i*>(multiplier))};
+}
+
+uint32_t count_ones(uint64_t word) noexcept {
+  word -= (word >> 1) & 0x5555555555555555;
+  word = (word & 0x3333333333333333) + ((word >> 2) & 0x3333333333333333);
+  word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0F;
+  return static_cast<uint32_t>((word * 0x0101010101010101) >> 56);
+}
+
+uint32_t count_trailing_zeroes(uint64_t word) noexcept {
+  unsigned long index;
+  if (_BitScanForward(&index, static_cast<unsigned long>(word))) {
+    return index;
+  }
+  _BitScanForward(&index, static_cast<unsigned long>(word >> 32));
+  return index + 32;
+}
+
+// Position of the one with the rank in the word, which must have more ones
+uint32_t select_in_word(uint64_t word, uint64_t rank) noexcept {
+  for (; rank; --rank) {
+    word &= word - 1;
+  }
+  return count_trailing_zeroes(word);
+}
+
+// Position of the bit with the rank among the ones of the words starting from
+// `pos`, which is such a bit itself. Inverted words are scanned for zeroes
+template <bool Ones>
+uint64_t select_from(const uint64_t* words,
+                     uint64_t pos,
+                     uint64_t rank) noexcept {
+  size_t idx{pos / WORD_BITS};
+  uint64_t word{(Ones ? words[idx] : ~words[idx]) &
+                (~uint64_t{0} << (pos % WORD_BITS))};
+  for (;;) {
+    const uint32_t count{count_ones(word)};
+    if (rank < count) {
+      return idx * WORD_BITS + select_in_word(word, rank);
+    }
+    rank -= count;
+    ++idx;
+    word = Ones ? words[idx] : ~words[idx];
+  }
+}
+}  // namespace
+
+void write_bits_atomic(uint64_t* words,
+                       uint64_t pos,
+                       uint32_t bits,
+                       uint64_t value) noexcept {
+  uint64_t* word{words + pos / WORD_BITS};
+  const uint32_t offset{static_cast<uint32_t>(pos % WORD_BITS)};
+  const uint64_t mask{get_mask(bits)};
+  value &= mask;
+  update_word_atomic(word, mask << offset, value << offset);
+  if (offset + bits > WORD_BITS) {
+    const uint32_t shift{WORD_BITS - offset};
+    update_word_atomic(word + 1, mask >> shift, value >> shift);
+  }
+}
+
+void unpack_generic(const uint64_t* words,
+                    [[maybe_unused]] size_t word_count,
+                    uint64_t first,
+                    uint32_t bits,
+                    uint32_t* out,
+                    size_t count) noexcept {
+  uint64_t pos{first * bits};
+  for (size_t idx = 0; idx < count; ++idx, pos += bits) {
+    out[idx] = static_cast<uint32_t>(read_bits(words, pos, bits));
+  }
+}
+
+TARGET_ISA("ssse3,sse4.1")
+void unpack_sse41(const uint64_t* words,
+                  size_t word_count,
+                  uint64_t first,
+                  uint32_t bits,
+                  uint32_t* out,
+                  size_t count) noexcept {
+  simd_scope scope{simd_level::sse};
+  if (bits > MAX_SIMD_BITS || !scope.allows(simd_level::sse)) {
+    return unpack_generic(words, word_count, first, bits, out, count);
+  }
+  // The bit offset of a group of 4 values alternates between two ones
+  const uint64_t first_pos{first * bits};
+  const uint32_t offset{static_cast<uint32_t>(first_pos % 8)};
+  const lane_layout layouts[]{
+      make_layout(offset, bits),
+      make_layout((offset + SIMD_VALUES * bits) % 8, bits)};
+  const auto* data{reinterpret_cast<const byte*>(words)};
+  const uint64_t byte_count{word_count * sizeof(uint64_t)};
+  const __m128i shift{_mm_cvtsi32_si128(static_cast<int>(32 - bits))};
+
+  size_t done{0};
+  for (uint64_t pos = first_pos; count - done >= SIMD_VALUES;
+       done += SIMD_VALUES, pos += SIMD_VALUES * bits) {
+    const uint64_t byte_offset{pos / 8};
+    if (byte_offset + sizeof(__m128i) > byte_count) {
+      break;
+    }
+    const auto& layout{layouts[(done / SIMD_VALUES) % 2]};
+    __m128i values{
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + byte_offset))};
+    values = _mm_shuffle_epi8(values, layout.shuffle);
+    values = _mm_mullo_epi32(values, layout.multiplier);
+    values = _mm_srl_epi32(values, shift);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out + done), values);
+  }
+  unpack_generic(words, word_count, first + done, bits, out + done,
+                 count - done);
+}
+
+static constexpr cpu::implementation<void(
+    const uint64_t*, size_t, uint64_t, uint32_t, uint32_t*, size_t)>
+    UNPACK_VERSIONS[]{
+        {{cpu_feature::ssse3, cpu_feature::sse41}, &unpack_sse41},
+        {{}, &unpack_generic}};
+
+static cpu::dispatched unpack_dispatched{UNPACK_VERSIONS};
+
+void unpack(const uint64_t* words,
+            size_t word_count,
+            uint64_t first,
+            uint32_t bits,
+            uint32_t* out,
+            size_t count) noexcept {
+  unpack_dispatched(words, word_count, first, bits, out, count);
+}
+}  // namespace pv::details
+
+monotone_vector::monotone_vector(span<const value_type> values)
+    : m_size{values.size()} {
+  using namespace pv::details;
+
+  if (values.empty()) {
+    return;
+  }
+  for (size_t idx = 1; idx < m_size; ++idx) {
+    throw_exception_if_not<invalid_argument>(values[idx - 1] <= values[idx],
+                                             "values must be sorted");
+  }
+  m_max = values[m_size - 1];
+  for (uint64_t ratio = m_max / m_size; ratio > 1; ratio >>= 1) {
+    ++m_low_bits;
+  }
+  const uint64_t bit_count{m_size + (m_max >> m_low_bits) + 1};
+  m_low.resize(get_word_count(m_size, m_low_bits), uint64_t{0});
+  m_high.resize(get_word_count(bit_count, 1), uint64_t{0});
+  m_one_samples.reserve((m_size + SAMPLE_RATE - 1) / SAMPLE_RATE);
+
+  for (size_t idx = 0; idx < m_size; ++idx) {
+    const value_type value{values[idx]};
+    write_bits(m_low.data(), static_cast<uint64_t>(idx) * m_low_bits,
+               m_low_bits, value);
+    const uint64_t pos{(value >> m_low_bits) + idx};
+    m_high[pos / WORD_BITS] |= uint64_t{1} << (pos % WORD_BITS);
+    if (idx % SAMPLE_RATE == 0) {
+      m_one_samples.push_back(pos);
+    }
+  }
+  sample_zeroes(bit_count);
+}
+
+size_t monotone_vector::size_in_bytes() const noexcept {
+  return (m_low.size() + m_high.size() + m_one_samples.size() +
+          m_zero_samples.size()) *
+         sizeof(uint64_t);
+}
+
+auto monotone_vector::select(size_type idx) const noexcept -> value_type {
+  const uint64_t high{select_one(idx) - idx};
+  return (high << m_low_bits) | get_low(idx);
+}
+
+auto monotone_vector::lower_bound(value_type value) const noexcept
+    -> size_type {
+  if (m_size == 0 || value > m_max) {
+    return m_size;
+  }
+  // Bucket `high` follows the `high`-th zero
+  const uint64_t high{value >> m_low_bits};
+  uint64_t pos{high ? select_zero(high - 1) + 1 : 0};
+  for (size_type idx = pos - high; idx < m_size; ++idx, ++pos) {
+    if (!test_high(pos) || ((high << m_low_bits) | get_low(idx)) >= value) {
+      return idx;  // The values of the next buckets are greater
+    }
+  }
+  return m_size;
+}
+
+uint64_t monotone_vector::select_one(size_type rank) const noexcept {
+  return pv::details::select_from<true>(
+      m_high.data(), m_one_samples[rank / SAMPLE_RATE], rank % SAMPLE_RATE);
+}
+
+uint64_t monotone_vector::select_zero(uint64_t rank) const noexcept {
+  return pv::details::select_from<false>(
+      m_high.data(), m_zero_samples[rank / SAMPLE_RATE], rank % SAMPLE_RATE);
+}
+
+void monotone_vector::sample_zeroes(uint64_t bit_count) {
+  using namespace pv::details;
+
+  uint64_t rank{0};
+  for (size_t idx = 0; idx * WORD_BITS < bit_count; ++idx) {
+    uint64_t zeroes{~m_high[idx]};
+    if (const uint64_t end = bit_count - idx * WORD_BITS; end < WORD_BITS) {
+      zeroes &= get_mask(static_cast<uint32_t>(end));
+    }
+    for (; zeroes; zeroes &= zeroes - 1, ++rank) {
+      if (rank % SAMPLE_RATE == 0) {
+        m_zero_samples.push_back(idx * WORD_BITS +
+                                 count_trailing_zeroes(zeroes));
+      }
+    }
+  }
+}
+}  // namespace ktl
@@ -0,0 +1,39 @@
+#include <per_cpu.hpp>
+
+namespace ktl {
+uint32_t max_processor_count() noexcept {
+  return KeQueryMaximumProcessorCountEx(ALL_PROCESSOR_GROUPS);
+}
+
+uint32_t current_processor_index() noexcept {
+  return KeGetCurrentProcessorNumberEx(nullptr);
+}
+
+namespace cpu::details {
+void run_on_each_processor(processor_callback_t callback,
+                           void* context) noexcept {
+  const uint32_t processor_count{
+      KeQueryActiveProcessorCountEx(ALL_PROCESSOR_GROUPS)};
+  GROUP_AFFINITY previous_affinity;
+  bool switched{false};
+  for (uint32_t idx = 0; idx < processor_count; ++idx) {
+    PROCESSOR_NUMBER number;
+    if (!NT_SUCCESS(KeGetProcessorNumberFromIndex(idx, &number))) {
+      continue;
+    }
+    GROUP_AFFINITY affinity{};
+    affinity.Group = number.Group;
+    affinity.Mask = KAFFINITY{1} << number.Number;
+    // The thread is moved to the processor before the call returns
+    KeSetSystemGroupAffinityThread(
+        &affinity, switched ? nullptr : &previous_affinity);
+    switched = true;
+    dispatch_level_guard guard;
+    callback(context);
+  }
+  if (switched) {
+    KeRevertToUserGroupAffinityThread(&previous_affinity);
+  }
+}
+}  // namespace cpu::details
+}  // namespace ktl
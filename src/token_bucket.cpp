@@ -0,0 +1,67 @@
+#include <token_bucket.hpp>
+
+#include <ktlexcept.hpp>
+#include <limits.hpp>
+
+namespace ktl {
+namespace {
+constexpr uint64_t NANOSECONDS_PER_SECOND{1'000'000'000};
+constexpr uint64_t TICKS_PER_SECOND{NANOSECONDS_PER_SECOND *
+                                    token_bucket::TICKS_PER_NANOSECOND};
+// Half of the range, so the full_at which has passed is told apart
+constexpr uint64_t MAX_CAPACITY{(numeric_limits<uint64_t>::max)() / 2};
+
+uint64_t verify_rate(uint64_t rate, uint64_t burst) {
+  throw_exception_if_not<invalid_argument>(
+      rate && rate <= NANOSECONDS_PER_SECOND,
+      "rate must be in [1, 10^9] tokens per second");
+  throw_exception_if_not<invalid_argument>(
+      burst && burst <= MAX_CAPACITY / (TICKS_PER_SECOND / rate),
+      "burst must be positive and fit the time range");
+  return rate;
+}
+
+uint64_t get_share(uint64_t total) noexcept {
+  const uint64_t shard_count{max_processor_count()};
+  return (total + shard_count - 1) / shard_count;
+}
+}  // namespace
+
+token_bucket::token_bucket(uint64_t rate, uint64_t burst)
+    : m_rate{verify_rate(rate, burst)},
+      m_burst{burst},
+      m_interval{TICKS_PER_SECOND / rate},
+      m_capacity{m_interval * burst},
+      m_full_at{current_time()} {}
+
+uint64_t token_bucket::available() const noexcept {
+  const uint64_t now{current_time()};
+  const uint64_t pending{m_full_at.load<memory_order_relaxed>() - now};
+  return pending > m_capacity ? m_burst : (m_capacity - pending) / m_interval;
+}
+
+sharded_token_bucket::sharded_token_bucket(uint64_t rate, uint64_t burst)
+    : m_buckets{get_share(verify_rate(rate, burst)), get_share(burst)} {}
+
+uint64_t sharded_token_bucket::available() const noexcept {
+  uint64_t result{0};
+  m_buckets.for_each(
+      [&result](const token_bucket& bucket) { result += bucket.available(); });
+  return result;
+}
+
+bool sharded_token_bucket::try_acquire_remote(uint32_t local,
+                                              uint64_t count) noexcept {
+  const uint32_t shard_count{m_buckets.size()};
+  for (uint32_t offset = 1; offset < shard_count; ++offset) {
+    uint32_t idx{local + offset};
+    if (idx >= shard_count) {
+      idx -= shard_count;
+    }
+    if (m_buckets[idx].try_acquire(count)) {
+      return true;
+    }
+  }
+  return false;
+}
+}  // namespace ktl
@@ -0,0 +1,132 @@
+#include <trace_buffer.hpp>
+
+#include <ktlexcept.hpp>
+
+namespace ktl {
+namespace trace::details {
+namespace {
+constexpr auto SLOT_ALIGNMENT{static_cast<align_val_t>(alignof(trace_slot))};
+
+enum class read_status { ok, not_committed, overwritten };
+
+read_status read_slot(const trace_slot& slot,
+                      uint64_t index,
+                      trace_record& record) noexcept {
+  const uint64_t expected{index + 1};
+  if (const uint64_t sequence = slot.sequence.load<memory_order_acquire>();
+      sequence != expected) {
+    // 0 is a record being written; the ones of the previous laps aren't
+    // committed yet either
+    return sequence > expected ? read_status::overwritten
+                               : read_status::not_committed;
+  }
+  memcpy(addressof(record), addressof(slot.record), sizeof(record));
+  atomic_thread_fence<memory_order_acquire>();
+  // The writer of the next lap invalidates the slot before changing it
+  return slot.sequence.load<memory_order_relaxed>() == expected
+             ? read_status::ok
+             : read_status::overwritten;
+}
+}  // namespace
+
+cpu_ring::cpu_ring(uint32_t capacity) : capacity{capacity} {
+  slots = static_cast<trace_slot*>(
+      allocate_memory<OnAllocationFailure::ThrowException>(
+          alloc_request_builder{sizeof(trace_slot) * capacity, NonPagedPool}
+              .set_alignment(SLOT_ALIGNMENT)
+              .set_pool_tag(crt::DEFAULT_HEAP_TAG)
+              .build()));
+  for (uint32_t idx = 0; idx < capacity; ++idx) {
+    construct_at(addressof(slots[idx].sequence), uint64_t{0});
+  }
+}
+
+cpu_ring::~cpu_ring() noexcept {
+  deallocate_memory(free_request_builder{slots, sizeof(trace_slot) * capacity}
+                        .set_alignment(SLOT_ALIGNMENT)
+                        .set_pool_tag(crt::DEFAULT_HEAP_TAG)
+                        .build());
+}
+}  // namespace trace::details
+
+trace_buffer::trace_buffer(uint32_t records_per_cpu, trace_mode mode)
+    : m_mode{mode},
+      m_mask{verify_capacity(records_per_cpu) - 1u},
+      m_rings{records_per_cpu} {
+  m_cursors = static_cast<cursor_type*>(
+      allocate_memory<OnAllocationFailure::ThrowException>(
+          alloc_request_builder{sizeof(cursor_type) * m_rings.size(),
+                                NonPagedPool}
+              .set_pool_tag(crt::DEFAULT_HEAP_TAG)
+              .build()));
+}
+
+trace_buffer::~trace_buffer() noexcept {
+  deallocate_memory(
+      free_request_builder{m_cursors, sizeof(cursor_type) * m_rings.size()}
+          .set_pool_tag(crt::DEFAULT_HEAP_TAG)
+          .build());
+}
+
+uint32_t trace_buffer::verify_capacity(uint32_t capacity) {
+  throw_exception_if_not<invalid_argument>(
+      capacity && (capacity & (capacity - 1)) == 0,
+      "capacity must be a power of 2");
+  return capacity;
+}
+
+trace_stats trace_buffer::stats() const noexcept {
+  trace_stats result{0, 0, m_lost.load<memory_order_relaxed>()};
+  m_rings.for_each([&result](const trace::details::cpu_ring& ring) {
+    result.written += ring.head.load<memory_order_relaxed>();
+    result.dropped += ring.dropped.load<memory_order_relaxed>();
+  });
+  return result;
+}
+
+bool trace_buffer::try_reserve(trace::details::cpu_ring& ring,
+                               uint64_t& index) noexcept {
+  index = ring.head.load<memory_order_relaxed>();
+  do {
+    if (index - ring.tail.load<memory_order_acquire>() >= ring.capacity) {
+      ring.dropped.fetch_add<memory_order_relaxed>(1);
+      return false;
+    }
+  } while (!ring.head.compare_exchange_strong(index, index + 1));
+  return true;
+}
+
+bool trace_buffer::fetch(uint32_t cpu, cursor_type& cursor) noexcept {
+  using trace::details::read_status;
+
+  auto& ring{m_rings[cpu]};
+  uint64_t index{ring.tail.load<memory_order_relaxed>()};
+  bool fetched{false};
+  while (!fetched && index < cursor.limit) {
+    const uint64_t head{ring.head.load<memory_order_acquire>()};
+    if (head - index > ring.capacity) {  // Only in the overwrite mode
+      m_lost.fetch_add<memory_order_relaxed>(head - ring.capacity - index);
+      index = head - ring.capacity;
+      continue;
+    }
+    switch (trace::details::read_slot(ring.slots[index & m_mask], index,
+                                      cursor.record)) {
+      case read_status::ok:
+        fetched = true;
+        ++index;
+        break;
+      case read_status::overwritten:
+        m_lost.fetch_add<memory_order_relaxed>(1);
+        ++index;
+        break;
+      default:
+        // The writer has been interrupted or is running on another processor,
+        // the record will be consumed next time
+        cursor.limit = index;
+        break;
+    }
+  }
+  ring.tail.store<memory_order_release>(index);
+  return fetched;
+}
+}  // namespace ktl
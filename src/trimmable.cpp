@@ -0,0 +1,142 @@
+#include <trimmable.hpp>
+
+#include <algorithm.hpp>
+#include <irql.hpp>
+#include <ktlexcept.hpp>
+#include <new_delete.hpp>
+#include <string_view.hpp>
+
+#include <ntddk.h>
+
+namespace ktl {
+namespace mm::details {
+static atomic<trim_registry*> trim_handler_registry{nullptr};
+
+static void trim_on_allocation_failure() {
+  auto* registry{trim_handler_registry.load<memory_order_acquire>()};
+  if (registry && irql_less_or_equal(APC_LEVEL) &&
+      registry->trim_until_released()) {
+    return;  // The allocation is retried
+  }
+  throw bad_alloc{};
+}
+}  // namespace mm::details
+
+void trim_registry::add(trimmable& target) {
+  lock_guard guard{m_lock};
+  m_targets.push_back(addressof(target));
+}
+
+void trim_registry::remove(trimmable& target) noexcept {
+  lock_guard guard{m_lock};
+  if (auto it = find(m_targets.begin(), m_targets.end(), addressof(target));
+      it != m_targets.end()) {
+    m_targets.erase(it);
+  }
+}
+
+size_t trim_registry::trim(trim_level level) noexcept {
+  size_t released{0};
+  shared_lock guard{m_lock};
+  for (auto* target : m_targets) {
+    released += target->trim(level);
+  }
+  return released;
+}
+
+size_t trim_registry::trim_until_released() noexcept {
+  for (uint32_t level = 0; level < TRIM_LEVEL_COUNT; ++level) {
+    if (const size_t released = trim(static_cast<trim_level>(level));
+        released) {
+      return released;
+    }
+  }
+  return 0;
+}
+
+void set_trim_new_handler(trim_registry* registry) noexcept {
+  mm::details::trim_handler_registry.store<memory_order_release>(registry);
+  set_new_handler(registry ? &mm::details::trim_on_allocation_failure
+                           : nullptr);
+}
+
+low_memory_watcher::low_memory_watcher(trim_registry& registry)
+    : m_registry{registry}, m_events{}, m_system_events{true} {
+  m_events.low_non_paged_pool =
+      open_event(*L"\\KernelObjects\\LowNonPagedPoolCondition"_usv.raw_str());
+  try {
+    m_events.low_memory =
+        open_event(*L"\\KernelObjects\\LowMemoryCondition"_usv.raw_str());
+    start();
+  } catch (...) {
+    ObDereferenceObject(m_events.low_non_paged_pool);
+    if (m_events.low_memory) {
+      ObDereferenceObject(m_events.low_memory);
+    }
+    throw;
+  }
+}
+
+low_memory_watcher::low_memory_watcher(trim_registry& registry,
+                                       memory_condition_events events)
+    : m_registry{registry}, m_events{events}, m_system_events{false} {
+  start();
+}
+
+low_memory_watcher::~low_memory_watcher() noexcept {
+  m_stop.set();
+  m_thread.join();
+  if (m_system_events) {
+    ObDereferenceObject(m_events.low_non_paged_pool);
+    ObDereferenceObject(m_events.low_memory);
+  }
+}
+
+KEVENT* low_memory_watcher::open_event(const UNICODE_STRING& name) {
+  HANDLE handle;
+  KEVENT* event{
+      IoCreateNotificationEvent(const_cast<UNICODE_STRING*>(&name), &handle)};
+  throw_exception_if_not<kernel_error>(event, STATUS_OBJECT_NAME_NOT_FOUND,
+                                       "unable to open the memory condition");
+  // The handle belongs to the current process, so the watcher keeps a
+  // reference instead
+  ObReferenceObject(event);
+  ZwClose(handle);
+  return event;
+}
+
+void low_memory_watcher::start() {
+  m_thread = system_thread{[this] { run(); }};
+}
+
+void low_memory_watcher::run() noexcept {
+  uint32_t level{0};
+  for (;;) {
+    if (level == 0) {
+      void* objects[]{m_stop.native_handle(), m_events.low_non_paged_pool,
+                      m_events.low_memory};
+      KeWaitForMultipleObjects(ARRAYSIZE(objects), objects, WaitAny,
+                               Executive, KernelMode, false, nullptr, nullptr);
+    } else {
+      // The conditions are notification events which stay signaled, so
+      // only the stop event is waited for until the next level
+      m_stop.wait_for(ESCALATION_INTERVAL);
+    }
+    if (m_stop.is_signaled()) {
+      break;
+    }
+    if (!is_memory_low()) {
+      level = 0;
+    } else {
+      m_registry.trim(static_cast<trim_level>(level));
+      m_trim_count.fetch_add<memory_order_relaxed>(1);
+      level = (min)(level + 1, TRIM_LEVEL_COUNT - 1);
+    }
+  }
+}
+
+bool low_memory_watcher::is_memory_low() const noexcept {
+  return KeReadStateEvent(m_events.low_non_paged_pool) ||
+         KeReadStateEvent(m_events.low_memory);
+}
+}  // namespace ktl
@@ -0,0 +1,151 @@
+#include "test.hpp"
+
+#include <test_runner.hpp>
+
+#include <modules/fmt/compile.hpp>
+
+#include <allocator.hpp>
+#include <atomic.hpp>
+#include <smart_pointer.hpp>
+#include <string_view.hpp>
+#include <thread.hpp>
+#include <unordered_map.hpp>
+#include <vector.hpp>
+
+using namespace ktl;
+
+namespace tests::allocation {
+namespace details {
+using map_type = unordered_flat_map<uint64_t, uint64_t>;
+
+static constexpr uint64_t KEY_COUNT{1000};
+
+static map_type make_map() {
+  map_type map;
+  for (uint64_t key = 0; key < KEY_COUNT; ++key) {
+    map.emplace(key, key * key);
+  }
+  return map;
+}
+}  // namespace details
+
+void count_container_allocations() {
+  allocation_counters counters;
+  {
+    using allocator_type = counting_allocator<basic_paged_allocator<int>>;
+
+    vector<int, allocator_type> vec{allocator_type{counters}};
+    vec.reserve(16);
+    ASSERT_EQ(counters.allocation_count, size_t{1})
+    ASSERT_EQ(counters.allocated_bytes, 16 * sizeof(int))
+    for (int idx = 0; idx < 16; ++idx) {
+      vec.push_back(idx);
+    }
+    ASSERT_EQ(counters.allocation_count, size_t{1})
+    vec.push_back(16);  // Reallocates the storage
+    ASSERT_EQ(counters.allocation_count, size_t{2})
+    ASSERT_EQ(counters.deallocation_count, size_t{1})
+  }
+  ASSERT_EQ(counters.allocation_count, counters.deallocation_count)
+  ASSERT_EQ(counters.get_live_bytes(), size_t{0})
+
+  counters = {};
+  {
+    using allocator_type = counting_allocator<basic_paged_allocator<byte>>;
+
+    using hasher = hash<uint64_t>;
+    using key_equal = equal_to<uint64_t>;
+
+    unordered_flat_map<uint64_t, uint64_t, hasher, key_equal, allocator_type>
+        map{0, hasher{}, key_equal{}, allocator_type{counters}};
+    for (uint64_t key = 0; key < details::KEY_COUNT; ++key) {
+      map.emplace(key, key);
+    }
+    ASSERT_VALUE(counters.allocation_count > 0)
+    ASSERT_VALUE(counters.get_live_bytes() > 0)
+
+    const size_t allocation_count{counters.allocation_count};
+    for (uint64_t key = 0; key < details::KEY_COUNT; ++key) {
+      ASSERT_VALUE(map.find(key) != map.end())
+    }
+    ASSERT_EQ(counters.allocation_count, allocation_count)
+  }
+  ASSERT_EQ(counters.get_live_bytes(), size_t{0})
+
+  // The nodes are allocated in bulks of the growing size
+  counters = {};
+  {
+    using allocator_type = counting_allocator<basic_paged_allocator<byte>>;
+
+    using hasher = hash<uint64_t>;
+    using key_equal = equal_to<uint64_t>;
+
+    unordered_node_map<uint64_t, uint64_t, hasher, key_equal, allocator_type>
+        map{0, hasher{}, key_equal{}, allocator_type{counters}};
+    for (uint64_t key = 0; key < details::KEY_COUNT; ++key) {
+      map.emplace(key, key);
+    }
+    map.clear();
+  }
+  ASSERT_EQ(counters.allocation_count, counters.deallocation_count)
+  ASSERT_EQ(counters.get_live_bytes(), size_t{0})
+}
+
+void catch_forbidden_allocations() {
+#ifdef KTL_ALLOCATION_HOOKS
+  // The thread is created in advance, so the guard observes its allocation
+  // only while the main one doesn't allocate
+  atomic<bool> started{false};
+  system_thread thread{[&started] {
+    while (!started.load<memory_order_acquire>()) {
+      this_thread::yield();
+    }
+    auto value{make_unique<uint64_t>(42)};
+  }};
+
+  no_allocation_guard outer;
+  size_t inner_count;
+  {
+    no_allocation_guard inner;  // Chains to the outer one
+    auto value{make_unique<uint64_t>(42)};
+    inner.release();
+    inner_count = inner.get_allocation_count();
+  }
+  started.store<memory_order_release>(true);
+  thread.join();
+  outer.release();
+
+  auto value{make_unique<uint64_t>(42)};  // Isn't counted after releasing
+  ASSERT_EQ(inner_count, size_t{1})
+  ASSERT_EQ(outer.get_allocation_count(), size_t{1})
+  ASSERT_EQ(outer.get_allocated_bytes(), sizeof(uint64_t))
+#endif
+}
+
+void find_without_allocations() {
+  const auto map{details::make_map()};
+  uint64_t sum{0};
+  ASSERT_NO_ALLOCATIONS({
+    for (uint64_t key = 0; key < 2 * details::KEY_COUNT; ++key) {
+      if (const auto it = map.find(key); it != map.end()) {
+        sum += it->second;
+      }
+    }
+  })
+  ASSERT_EQ(sum, (details::KEY_COUNT - 1) * details::KEY_COUNT *
+                     (2 * details::KEY_COUNT - 1) / 6)
+}
+
+void format_without_allocations() {
+  char buffer[64];
+  char* last{nullptr};
+  ASSERT_NO_ALLOCATIONS(last = format_to(buffer, FMT_COMPILE("{}: {:#x}"),
+                                         "status", 0xC0000001u))
+  ASSERT_EQ(ansi_string_view(buffer, static_cast<uint16_t>(last - buffer)),
+            ansi_string_view("status: 0xc0000001"))
+
+  ASSERT_NO_ALLOCATIONS(last = format_to(buffer, "{} of {}", 7, 42))
+  ASSERT_EQ(ansi_string_view(buffer, static_cast<uint16_t>(last - buffer)),
+            ansi_string_view("7 of 42"))
+}
+}  // namespace tests::allocation
@@ -0,0 +1,8 @@
+#pragma once
+
+namespace tests::allocation {
+void count_container_allocations();
+void catch_forbidden_allocations();
+void find_without_allocations();
+void format_without_allocations();
+}  // namespace tests::allocation
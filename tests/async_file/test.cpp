@@ -0,0 +1,141 @@
+#include "test.hpp"
+
+#include <test_runner.hpp>
+
+#include <async_file.hpp>
+#include <string_view.hpp>
+#include <task.hpp>
+#include <vector.hpp>
+
+#include <ntddk.h>
+
+using namespace ktl;
+
+namespace tests::async_file {
+namespace details {
+using byte_vector = vector<byte, basic_non_paged_allocator<byte> >;
+
+static constexpr auto FILE_PATH{L"\\SystemRoot\\Temp\\ktl_async_file.tmp"_usv};
+static constexpr size_t BLOCK_SIZE{16 * 1024};
+static constexpr size_t BLOCK_COUNT{16};
+
+static byte_vector make_data(size_t size) {
+  byte_vector data(size);
+  uint32_t state{0x0badf00d};
+  for (auto& value : data) {
+    state = state * 1664525 + 1013904223;  // LCG
+    value = static_cast<byte>(state >> 24);
+  }
+  return data;
+}
+
+// Temporary file opened for the asynchronous I/O
+class temp_file : non_copyable {
+ public:
+  temp_file() {
+    OBJECT_ATTRIBUTES attributes;
+    InitializeObjectAttributes(
+        addressof(attributes), const_cast<UNICODE_STRING*>(FILE_PATH.raw_str()),
+        OBJ_KERNEL_HANDLE | OBJ_CASE_INSENSITIVE, nullptr, nullptr);
+    IO_STATUS_BLOCK io_status;
+    NTSTATUS status{ZwCreateFile(
+        addressof(m_handle), FILE_READ_DATA | FILE_WRITE_DATA | DELETE,
+        addressof(attributes), addressof(io_status), nullptr,
+        FILE_ATTRIBUTE_TEMPORARY, 0, FILE_OVERWRITE_IF,
+        FILE_NON_DIRECTORY_FILE | FILE_DELETE_ON_CLOSE, nullptr, 0)};
+    throw_exception_if_not<kernel_error>(NT_SUCCESS(status), status,
+                                         "unable to create the file");
+    status = ObReferenceObjectByHandle(
+        m_handle, 0, *IoFileObjectType, KernelMode,
+        reinterpret_cast<void**>(addressof(m_file)), nullptr);
+    if (!NT_SUCCESS(status)) {
+      ZwClose(m_handle);
+      throw_exception<kernel_error>(status, "unable to reference the file");
+    }
+  }
+
+  ~temp_file() noexcept {
+    ObDereferenceObject(m_file);
+    ZwClose(m_handle);
+  }
+
+  FILE_OBJECT* get() const noexcept { return m_file; }
+
+ private:
+  HANDLE m_handle{nullptr};
+  FILE_OBJECT* m_file{nullptr};
+};
+
+static task<bool> write_blocks(FILE_OBJECT* file, const byte_vector& data) {
+  for (size_t offset = 0; offset < data.size(); offset += BLOCK_SIZE) {
+    const auto result{co_await async_write(
+        file, offset, span{data.data() + offset, BLOCK_SIZE})};
+    if (!NT_SUCCESS(result.status) || result.transferred != BLOCK_SIZE) {
+      co_return false;
+    }
+  }
+  co_return true;
+}
+
+static task<void> read_block(FILE_OBJECT* file,
+                             size_t offset,
+                             span<byte> buffer,
+                             io_result& result) {
+  result = co_await async_read(file, offset, buffer);
+}
+}  // namespace details
+
+void write_and_read_back() {
+  using namespace details;
+
+  temp_file file;
+  const auto data{make_data(BLOCK_SIZE * BLOCK_COUNT)};
+  ASSERT_VALUE(sync_wait(write_blocks(file.get(), data)))
+
+  byte_vector output(data.size());
+  io_result result{};
+  sync_wait(read_block(file.get(), 0, span{output}, result));
+  ASSERT_VALUE(NT_SUCCESS(result.status))
+  ASSERT_EQ(result.transferred, data.size())
+  ASSERT_VALUE(memcmp(output.data(), data.data(), data.size()) == 0)
+}
+
+void read_concurrently() {
+  using namespace details;
+
+  temp_file file;
+  const auto data{make_data(BLOCK_SIZE * BLOCK_COUNT)};
+  ASSERT_VALUE(sync_wait(write_blocks(file.get(), data)))
+
+  // All of the reads are in flight at once, none of them blocks the thread
+  byte_vector output(data.size());
+  io_result results[BLOCK_COUNT]{};
+  task<void> reads[BLOCK_COUNT];
+  for (size_t idx = 0; idx < BLOCK_COUNT; ++idx) {
+    reads[idx] =
+        read_block(file.get(), idx * BLOCK_SIZE,
+                   span{output.data() + idx * BLOCK_SIZE, BLOCK_SIZE},
+                   results[idx]);
+  }
+  sync_wait_all(reads);
+  for (const auto& result : results) {
+    ASSERT_VALUE(NT_SUCCESS(result.status))
+    ASSERT_EQ(result.transferred, BLOCK_SIZE)
+  }
+  ASSERT_VALUE(memcmp(output.data(), data.data(), data.size()) == 0)
+}
+
+void read_past_end() {
+  using namespace details;
+
+  temp_file file;
+  const auto data{make_data(BLOCK_SIZE)};
+  ASSERT_VALUE(sync_wait(write_blocks(file.get(), data)))
+
+  byte_vector output(BLOCK_SIZE);
+  io_result result{};
+  sync_wait(read_block(file.get(), BLOCK_SIZE, span{output}, result));
+  ASSERT_EQ(result.status, STATUS_END_OF_FILE)
+  ASSERT_EQ(result.transferred, size_t{0})
+}
+}  // namespace tests::async_file
@@ -0,0 +1,7 @@
+#pragma once
+
+namespace tests::async_file {
+void write_and_read_back();
+void read_concurrently();
+void read_past_end();
+}  // namespace tests::async_file
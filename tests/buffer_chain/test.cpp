@@ -0,0 +1,121 @@
+#include "test.hpp"
+
+#include <test_runner.hpp>
+
+#include <buffer_chain.hpp>
+#include <io_buffer_pool.hpp>
+#include <ktlexcept.hpp>
+
+using namespace ktl;
+
+namespace tests::buffer_chain {
+namespace details {
+inline constexpr byte HEADER[]{0x01, 0x02, 0x03, 0x04};
+inline constexpr byte PATH[]{'/', 'a', '/', 'b'};
+inline constexpr byte PAYLOAD[]{'p', 'a', 'y', 'l', 'o', 'a', 'd'};
+
+static ktl::buffer_chain make_message() {
+  ktl::buffer_chain message{buffer_slice::borrow(span{PATH})};
+  message.append(buffer_slice::copy_of(span{PAYLOAD}));
+  message.append(buffer_slice{});  // Skipped
+  message.prepend(buffer_slice::copy_of(span{HEADER}));
+  return message;
+}
+
+static bool equals(span<const byte> lhs, span<const byte> rhs) noexcept {
+  return lhs.size() == rhs.size() &&
+         memcmp(lhs.data(), rhs.data(), lhs.size()) == 0;
+}
+}  // namespace details
+
+void compose_message() {
+  using namespace details;
+
+  auto message{make_message()};
+  ASSERT_EQ(message.segment_count(), size_t{3})
+  ASSERT_EQ(message.size(), sizeof(HEADER) + sizeof(PATH) + sizeof(PAYLOAD))
+
+  byte flat[sizeof(HEADER) + sizeof(PATH) + sizeof(PAYLOAD)];
+  ASSERT_EQ(message.copy_to(span{flat}), sizeof(flat))
+  ASSERT_VALUE(equals(span{flat}.first(sizeof(HEADER)), span{HEADER}))
+  ASSERT_VALUE(equals(span{flat}.last(sizeof(PAYLOAD)), span{PAYLOAD}))
+
+  byte tail[5];
+  ASSERT_EQ(message.copy_to(span{tail}, sizeof(flat) - 3), size_t{3})
+  ASSERT_VALUE(equals(span{tail}.first(3), span{PAYLOAD}.last(3)))
+
+  size_t visited{0};
+  message.for_each_segment(
+      [&visited](span<const byte> segment) { visited += segment.size(); });
+  ASSERT_EQ(visited, message.size())
+
+  ktl::buffer_chain contiguous{buffer_slice::borrow(span{flat})};
+  ASSERT_EQ(message.hash(), contiguous.hash())
+}
+
+void split_and_coalesce() {
+  using namespace details;
+
+  auto message{make_message()};
+  const uint64_t hash{message.hash()};
+
+  auto head{message.split(sizeof(HEADER) + 2)};  // In the middle of the path
+  ASSERT_EQ(head.segment_count(), size_t{2})
+  ASSERT_EQ(head.size(), sizeof(HEADER) + 2)
+  ASSERT_EQ(message.segment_count(), size_t{2})
+  ASSERT_VALUE(message.segments()[0].data().data() == PATH + 2)
+
+  head.append(move(message));
+  ASSERT_VALUE(message.empty())
+  ASSERT_EQ(head.hash(), hash)
+
+  const auto merged{head.coalesce()};
+  ASSERT_EQ(head.segment_count(), size_t{1})
+  ASSERT_VALUE(equals(merged.last(sizeof(PAYLOAD)), span{PAYLOAD}))
+  ASSERT_EQ(head.hash(), hash)
+
+  ASSERT_EQ(head.split(0).size(), size_t{0})
+
+  // On the segment boundary nothing is subsliced
+  auto parts{make_message()};
+  auto header{parts.split(sizeof(HEADER))};
+  ASSERT_EQ(header.segment_count(), size_t{1})
+  ASSERT_EQ(parts.segment_count(), size_t{2})
+  parts.prepend(move(header));
+  ASSERT_VALUE(header.empty())
+  ASSERT_EQ(parts.segment_count(), size_t{3})
+  ASSERT_EQ(parts.hash(), hash)
+
+  bool thrown{false};
+  try {
+    head.split(head.size() + 1);
+  } catch ([[maybe_unused]] const out_of_range& exc) {
+    thrown = true;
+  }
+  ASSERT_VALUE(thrown)
+}
+
+void adopt_pooled_buffer() {
+  using namespace details;
+
+  ktl::io_buffer_pool pool;
+  const uint32_t size_class{ktl::io_buffer_pool::get_size_class(1)};
+  {
+    auto buffer{pool.acquire(1)};
+    memcpy(buffer.data(), PAYLOAD, sizeof(PAYLOAD));
+    auto slice{buffer_slice::adopt(move(buffer), sizeof(PAYLOAD))};
+    ASSERT_VALUE(slice.is_unique())
+
+    ktl::buffer_chain message{slice.subslice(1)};
+    ASSERT_VALUE(!slice.is_unique())
+    message.prepend(move(slice));
+    ASSERT_EQ(pool.stats(size_class).in_use, size_t{1})
+
+    auto head{message.split(3)};
+    message.clear();
+    ASSERT_EQ(head.size(), size_t{3})
+    ASSERT_EQ(pool.stats(size_class).in_use, size_t{1})
+  }
+  ASSERT_EQ(pool.stats(size_class).in_use, size_t{0})
+}
+}  // namespace tests::buffer_chain
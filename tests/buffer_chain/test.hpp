@@ -0,0 +1,7 @@
+#pragma once
+
+namespace tests::buffer_chain {
+void compose_message();
+void split_and_coalesce();
+void adopt_pooled_buffer();
+}  // namespace tests::buffer_chain
@@ -0,0 +1,159 @@
+#include "test.hpp"
+
+#include <test_runner.hpp>
+
+#include <atomic.hpp>
+#include <callback_list.hpp>
+#include <chrono.hpp>
+#include <irql.hpp>
+#include <per_cpu.hpp>
+#include <thread.hpp>
+
+#include <ntddk.h>
+
+using namespace ktl;
+
+namespace tests::callback_list {
+namespace details {
+using list_type = ktl::callback_list<void(uint32_t)>;
+
+struct call_log {
+  uint32_t calls[8];
+  uint32_t size{0};
+};
+
+static void log_call(void* context, uint32_t value) {
+  auto& log{*static_cast<call_log*>(context)};
+  log.calls[log.size++] = value;
+}
+
+static void log_call_twice(void* context, uint32_t value) {
+  auto& log{*static_cast<call_log*>(context)};
+  log.calls[log.size++] = value * 2;
+}
+
+struct irql_observer {
+  void operator()(uint32_t) noexcept { irql = get_current_irql(); }
+
+  irql_t irql{PASSIVE_LEVEL};
+};
+
+struct counting_observer {
+  void operator()(uint32_t) noexcept {
+    calls.fetch_add<memory_order_relaxed>(1);
+  }
+
+  atomic<uint64_t> calls{0};
+};
+}  // namespace details
+
+void invoke_in_registration_order() {
+  using namespace details;
+
+  list_type callbacks;
+  ASSERT_VALUE(callbacks.empty())
+  callbacks.invoke(1);
+
+  call_log log;
+  callbacks.add(&log_call, addressof(log));
+  callbacks.add(&log_call_twice, addressof(log));
+  auto observer{[&log](uint32_t value) { log.calls[log.size++] = value + 1; }};
+  callbacks.add(observer);
+  ASSERT_EQ(callbacks.size(), size_t{3})
+
+  callbacks.invoke(10);
+  ASSERT_EQ(log.size, uint32_t{3})
+  ASSERT_EQ(log.calls[0], uint32_t{10})
+  ASSERT_EQ(log.calls[1], uint32_t{20})
+  ASSERT_EQ(log.calls[2], uint32_t{11})
+}
+
+void remove_callbacks() {
+  using namespace details;
+
+  list_type callbacks;
+  call_log log;
+  const auto first{callbacks.add(&log_call, addressof(log))};
+  const auto second{callbacks.add(&log_call_twice, addressof(log))};
+  ASSERT_VALUE(first != second)
+
+  ASSERT_VALUE(callbacks.remove(first))
+  ASSERT_VALUE(!callbacks.remove(first))
+  ASSERT_EQ(callbacks.size(), size_t{1})
+  callbacks.invoke(3);
+  ASSERT_EQ(log.size, uint32_t{1})
+  ASSERT_EQ(log.calls[0], uint32_t{6})
+
+  ASSERT_VALUE(callbacks.remove(second))
+  ASSERT_VALUE(callbacks.empty())
+  callbacks.invoke(3);
+  ASSERT_EQ(log.size, uint32_t{1})
+
+  callbacks.add(&log_call, addressof(log));
+  callbacks.invoke(4);
+  ASSERT_EQ(log.size, uint32_t{2})
+  ASSERT_EQ(log.calls[1], uint32_t{4})
+}
+
+void invoke_at_dispatch_level() {
+  using namespace details;
+
+  list_type callbacks;
+  irql_observer observer;
+  callbacks.add(observer);
+  {
+    dispatch_level_guard guard;
+    callbacks.invoke(0);
+  }
+  ASSERT_EQ(observer.irql, irql_t{DISPATCH_LEVEL})
+}
+
+void replace_while_invoking() {
+  using namespace details;
+
+  constexpr uint32_t READER_COUNT{4};
+  constexpr uint32_t ROUND_COUNT{200};
+
+  list_type callbacks;
+  counting_observer permanent;
+  callbacks.add(permanent);
+
+  atomic<bool> stop{false};
+  auto read{[&callbacks, &stop](bool at_dispatch) {
+    while (!stop.load<memory_order_relaxed>()) {
+      if (at_dispatch) {
+        dispatch_level_guard guard;
+        callbacks.invoke(0);
+      } else {
+        callbacks.invoke(0);
+      }
+    }
+  }};
+
+  system_thread readers[READER_COUNT];
+  for (uint32_t idx = 0; idx < READER_COUNT; ++idx) {
+    readers[idx] = system_thread{read, idx % 2 == 0};
+  }
+
+  uint64_t removed_calls{0};
+  for (uint32_t round = 0; round < ROUND_COUNT; ++round) {
+    counting_observer transient;
+    const auto cookie{callbacks.add(transient)};
+    this_thread::sleep_for(chrono::milliseconds{1});
+    ASSERT_VALUE(callbacks.remove(cookie))
+    // The readers are still running, but none of them may call it anymore
+    const uint64_t calls{transient.calls.load()};
+    this_thread::sleep_for(chrono::milliseconds{1});
+    ASSERT_EQ(transient.calls.load(), calls)
+    removed_calls += calls;
+  }
+
+  stop.store(true);
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  ASSERT_EQ(callbacks.size(), size_t{1})
+  ASSERT_VALUE(permanent.calls.load() > 0)
+  tests::details::print("{} calls of the removed observers\n", removed_calls);
+}
+}  // namespace tests::callback_list
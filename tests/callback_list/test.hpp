@@ -0,0 +1,8 @@
+#pragma once
+
+namespace tests::callback_list {
+void invoke_in_registration_order();
+void remove_callbacks();
+void invoke_at_dispatch_level();
+void replace_while_invoking();
+}  // namespace tests::callback_list
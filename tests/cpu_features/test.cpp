@@ -0,0 +1,60 @@
+#include "test.hpp"
+
+#include <test_runner.hpp>
+
+#include <cpu_features.hpp>
+
+using namespace ktl;
+
+namespace tests::cpu_features {
+namespace details {
+static int version_generic(int value) noexcept {
+  return value;
+}
+
+static int version_sse42(int value) noexcept {
+  return value + 1;
+}
+
+static int version_avx2(int value) noexcept {
+  return value + 2;
+}
+
+static constexpr cpu::implementation<int(int)> VERSIONS[]{
+    {cpu_feature_set{cpu_feature::avx2, cpu_feature::bmi2}, &version_avx2},
+    {cpu_feature::sse42, &version_sse42},
+    {{}, &version_generic}};
+
+static cpu::dispatched dispatched_version{VERSIONS};
+}  // namespace details
+
+void query_baseline() {
+  ASSERT_VALUE(cpu::features().has_all_of(cpu::baseline_features))
+  ASSERT_VALUE(cpu::has(cpu_feature_set{}))
+  ASSERT_VALUE(cpu::has<cpu_feature::sse2>() == cpu::has(cpu_feature::sse2))
+
+  // AVX2 can't be reported without AVX being enabled by the OS
+  if (cpu::has<cpu_feature::avx2>()) {
+    ASSERT_VALUE(cpu::has(cpu_feature::avx))
+  }
+}
+
+void dispatch_by_features() {
+  using details::dispatched_version;
+
+  const int expected{
+      cpu::has<cpu_feature::avx2, cpu_feature::bmi2>() ? 2
+      : cpu::has<cpu_feature::sse42>()                 ? 1
+                                                       : 0};
+  ASSERT_EQ(dispatched_version(40), 40 + expected)
+
+#ifdef KTL_CPU_FEATURES_OVERRIDE
+  cpu::override_features(cpu_feature::sse42);
+  ASSERT_EQ(dispatched_version(40), 41)
+  cpu::override_features(cpu_feature_set{cpu_feature::avx2});  // No BMI2
+  ASSERT_EQ(dispatched_version(40), 40)
+  cpu::reset_features();
+  ASSERT_EQ(dispatched_version(40), 40 + expected)
+#endif
+}
+}  // namespace tests::cpu_features
@@ -0,0 +1,6 @@
+#pragma once
+
+namespace tests::cpu_features {
+void query_baseline();
+void dispatch_by_features();
+}  // namespace tests::cpu_features
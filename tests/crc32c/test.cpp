@@ -0,0 +1,81 @@
+#include "test.hpp"
+
+#include <test_runner.hpp>
+
+#include <algorithm.hpp>
+#include <buffer_chain.hpp>
+#include <cpu_features.hpp>
+#include <crc32c.hpp>
+#include <vector.hpp>
+
+using namespace ktl;
+
+namespace tests::crc32c {
+namespace details {
+using byte_vector = vector<byte, basic_non_paged_allocator<byte> >;
+
+static byte_vector make_data(size_t size) {
+  byte_vector data(size);
+  uint32_t state{0x12345678};
+  for (auto& value : data) {
+    state = state * 1664525 + 1013904223;  // LCG
+    value = static_cast<byte>(state >> 24);
+  }
+  return data;
+}
+}  // namespace details
+
+void compute_known_values() {
+  static constexpr char DIGITS[]{"123456789"};
+  ASSERT_EQ(ktl::crc32c(DIGITS, 9), 0xe3069283u)
+  ASSERT_EQ(ktl::crc32c(DIGITS, 0), 0u)
+
+  byte zeros[32]{};
+  ASSERT_EQ(ktl::crc32c(span{zeros}), 0x8a9136aau)  // RFC 3720, B.4
+}
+
+void match_generic_version() {
+  using namespace details;
+  using crc::details::crc32c_generic;
+  using crc::details::crc32c_sse42;
+
+  const auto data{make_data(3 * 8192 * 2 + 1000)};
+  static constexpr size_t SIZES[]{0,   1,    7,    8,     255,   767,
+                                  768, 3000, 8191, 24576, 24577, 50000};
+  for (size_t offset = 0; offset < 8; ++offset) {
+    for (const size_t size : SIZES) {
+      const uint32_t expected{crc32c_generic(0, data.data() + offset, size)};
+      ASSERT_EQ(ktl::crc32c(data.data() + offset, size), expected)
+      if (cpu::has<cpu_feature::sse42>()) {
+        ASSERT_EQ(crc32c_sse42(0, data.data() + offset, size), expected)
+      }
+    }
+  }
+}
+
+void update_and_combine() {
+  using namespace details;
+
+  const auto data{make_data(10000)};
+  const uint32_t expected{ktl::crc32c(data.data(), data.size())};
+
+  uint32_t crc{0};
+  for (size_t offset = 0; offset < data.size(); offset += 999) {
+    const size_t size{(min)(size_t{999}, data.size() - offset)};
+    crc = crc32c_update(crc, data.data() + offset, size);
+  }
+  ASSERT_EQ(crc, expected)
+
+  const uint32_t head{ktl::crc32c(data.data(), 1234)};
+  const uint32_t tail{ktl::crc32c(data.data() + 1234, data.size() - 1234)};
+  ASSERT_EQ(crc32c_combine(head, tail, data.size() - 1234), expected)
+  ASSERT_EQ(crc32c_combine(expected, ktl::crc32c(nullptr, 0), 0), expected)
+
+  buffer_chain chain{buffer_slice::borrow({data.data(), 1234})};
+  chain.append(buffer_slice::borrow({data.data() + 1234, data.size() - 1234}));
+  crc = 0;
+  chain.for_each_segment(
+      [&crc](span<const byte> segment) { crc = crc32c_update(crc, segment); });
+  ASSERT_EQ(crc, expected)
+}
+}  // namespace tests::crc32c
@@ -0,0 +1,7 @@
+#pragma once
+
+namespace tests::crc32c {
+void compute_known_values();
+void match_generic_version();
+void update_and_combine();
+}  // namespace tests::crc32c
@@ -1,10 +1,31 @@
+#include "allocation/test.hpp"
+#include "async_file/test.hpp"
+#include "buffer_chain/test.hpp"
+#include "callback_list/test.hpp"
+#include "cpu_features/test.hpp"
+#include "crc32c/test.hpp"
 #include "dynamic_init/test.hpp"
+#include "event_ring/test.hpp"
 #include "exception_dispatcher/test.hpp"
 #include "floating_point/test.hpp"
 #include "heap/test.hpp"
+#include "io_buffer_pool/test.hpp"
 #include "irql/test.hpp"
+#include "lockfree/test.hpp"
+#include "locks/test.hpp"
+#include "lz4/test.hpp"
+#include "mapped_file/test.hpp"
+#include "metrics/test.hpp"
+#include "minifilter/test.hpp"
+#include "packed_vector/test.hpp"
 #include "placement_new/test.hpp"
 #include "preload_init/test.hpp"
+#include "sorted_string_table/test.hpp"
+#include "string/test.hpp"
+#include "token_bucket/test.hpp"
+#include "trace_buffer/test.hpp"
+#include "trimmable/test.hpp"
+#include "variant/test.hpp"
 #include "runner/test_runner.hpp"
 
 #include <modules/fmt/compile.hpp>
@@ -39,7 +60,11 @@ DriverEntry([[maybe_unused]] DRIVER_OBJECT* driver_object,
              exc.code());
     return exc.code();
   }
+#ifdef KTL_HOSTED
+  return STATUS_SUCCESS;  // The process exits after the tests anyway
+#else
   return STATUS_UNSUCCESSFUL;
+#endif
 }
 
 TIME_FIELDS GetCurrentTime() noexcept {
@@ -62,8 +87,15 @@ void RunTests() {
   RUN_TEST(tr, tests::placement_new::construct_after_destroying);
   RUN_TEST(tr, tests::placement_new::construct_with_launder);
 
+  RUN_TEST(tr, tests::string::append_iterator_range);
+  RUN_TEST(tr, tests::string::insert_iterator_range);
+
   RUN_TEST(tr, tests::floating_point::validate_fltused);
   RUN_TEST(tr, tests::floating_point::perform_arithmetic_operations);
+  RUN_TEST(tr, tests::floating_point::nest_simd_scopes);
+
+  RUN_TEST(tr, tests::cpu_features::query_baseline);
+  RUN_TEST(tr, tests::cpu_features::dispatch_by_features);
 
   RUN_TEST(tr, tests::heap::alloc_and_free);
   RUN_TEST(tr, tests::heap::alloc_and_free_noexcept);
@@ -72,6 +104,110 @@ void RunTests() {
   RUN_TEST(tr, tests::irql::raise_and_lower);
   RUN_TEST(tr, tests::irql::less_or_equal);
 
+  RUN_TEST(tr, tests::minifilter::cache_file_contexts);
+  RUN_TEST(tr, tests::minifilter::evict_file_contexts);
+  RUN_TEST(tr, tests::minifilter::cache_file_names);
+  RUN_TEST(tr, tests::minifilter::invalidate_file_names);
+  RUN_TEST(tr, tests::minifilter::cache_opened_names);
+  RUN_TEST(tr, tests::minifilter::offload_in_batches);
+  RUN_TEST(tr, tests::minifilter::offload_when_full);
+  RUN_TEST(tr, tests::minifilter::offload_without_workers);
+
+  RUN_TEST(tr, tests::event_ring::deliver_events);
+  RUN_TEST(tr, tests::event_ring::drop_events_when_full);
+  RUN_TEST(tr, tests::event_ring::wake_idle_reader);
+
+  RUN_TEST(tr, tests::io_buffer_pool::visit_per_cpu_instances);
+  RUN_TEST(tr, tests::io_buffer_pool::reuse_buffers);
+  RUN_TEST(tr, tests::io_buffer_pool::track_high_water);
+  RUN_TEST(tr, tests::io_buffer_pool::prepare_mdl);
+
+  RUN_TEST(tr, tests::buffer_chain::compose_message);
+  RUN_TEST(tr, tests::buffer_chain::split_and_coalesce);
+  RUN_TEST(tr, tests::buffer_chain::adopt_pooled_buffer);
+
+  RUN_TEST(tr, tests::crc32c::compute_known_values);
+  RUN_TEST(tr, tests::crc32c::match_generic_version);
+  RUN_TEST(tr, tests::crc32c::update_and_combine);
+
+  RUN_TEST(tr, tests::lz4::round_trip_blocks);
+  RUN_TEST(tr, tests::lz4::reject_malformed_blocks);
+  RUN_TEST(tr, tests::lz4::round_trip_frames);
+  RUN_TEST(tr, tests::lz4::decompress_reference_blocks);
+  RUN_TEST(tr, tests::lz4::read_reference_frames);
+  RUN_TEST(tr, tests::lz4::reject_linked_frames);
+  RUN_TEST(tr, tests::lz4::write_reference_frames);
+  RUN_TEST(tr, tests::lz4::measure_throughput);
+
+  RUN_TEST(tr, tests::mapped_file::map_ranges);
+  RUN_TEST(tr, tests::mapped_file::stream_file);
+  RUN_TEST(tr, tests::mapped_file::measure_throughput);
+
+  RUN_TEST(tr, tests::async_file::write_and_read_back);
+  RUN_TEST(tr, tests::async_file::read_concurrently);
+  RUN_TEST(tr, tests::async_file::read_past_end);
+
+  RUN_TEST(tr, tests::trace_buffer::write_and_consume);
+  RUN_TEST(tr, tests::trace_buffer::stop_and_overwrite_modes);
+  RUN_TEST(tr, tests::trace_buffer::write_from_all_processors);
+  RUN_TEST(tr, tests::trace_buffer::stress_concurrent_writers);
+  RUN_TEST(tr, tests::trace_buffer::measure_write_cost);
+
+  RUN_TEST(tr, tests::metrics::update_metrics);
+  RUN_TEST(tr, tests::metrics::reject_duplicate_ids);
+  RUN_TEST(tr, tests::metrics::parse_snapshot);
+  RUN_TEST(tr, tests::metrics::snapshot_into_small_buffer);
+
+  RUN_TEST(tr, tests::token_bucket::acquire_and_refill);
+  RUN_TEST(tr, tests::token_bucket::refill_at_high_rate);
+  RUN_TEST(tr, tests::token_bucket::reject_invalid_parameters);
+  RUN_TEST(tr, tests::token_bucket::share_between_processors);
+  RUN_TEST(tr, tests::token_bucket::measure_acquire_cost);
+
+  RUN_TEST(tr, tests::trimmable::trim_registered_objects);
+  RUN_TEST(tr, tests::trimmable::trim_node_allocator);
+  RUN_TEST(tr, tests::trimmable::trim_buffer_pool);
+  RUN_TEST(tr, tests::trimmable::watch_stand_in_events);
+  RUN_TEST(tr, tests::trimmable::trim_on_allocation_failure);
+
+  RUN_TEST(tr, tests::callback_list::invoke_in_registration_order);
+  RUN_TEST(tr, tests::callback_list::remove_callbacks);
+  RUN_TEST(tr, tests::callback_list::invoke_at_dispatch_level);
+  RUN_TEST(tr, tests::callback_list::replace_while_invoking);
+
+  RUN_TEST(tr, tests::packed_vector::get_and_set);
+  RUN_TEST(tr, tests::packed_vector::unpack_ranges);
+  RUN_TEST(tr, tests::packed_vector::set_from_all_processors);
+  RUN_TEST(tr, tests::packed_vector::select_and_lower_bound);
+  RUN_TEST(tr, tests::packed_vector::reject_unsorted_values);
+
+  RUN_TEST(tr, tests::sorted_string_table::find_strings);
+  RUN_TEST(tr, tests::sorted_string_table::query_prefix_ranges);
+  RUN_TEST(tr, tests::sorted_string_table::iterate_strings);
+  RUN_TEST(tr, tests::sorted_string_table::map_image);
+  RUN_TEST(tr, tests::sorted_string_table::reject_damaged_image);
+
+  RUN_TEST(tr, tests::variant::hold_alternatives);
+  RUN_TEST(tr, tests::variant::copy_and_assign);
+  RUN_TEST(tr, tests::variant::visit_alternatives);
+  RUN_TEST(tr, tests::variant::become_valueless_on_exception);
+
+  RUN_TEST(tr, tests::lockfree::pack_tagged_pointer);
+  RUN_TEST(tr, tests::lockfree::reuse_freed_nodes);
+  RUN_TEST(tr, tests::lockfree::allocate_nodes_concurrently);
+  RUN_TEST(tr, tests::lockfree::keep_queue_order);
+  RUN_TEST(tr, tests::lockfree::stress_queue);
+  RUN_TEST(tr, tests::lockfree::stress_queue_aba);
+  RUN_TEST(tr, tests::lockfree::stress_bounded_queue);
+
+  RUN_TEST(tr, tests::locks::measure_exclusive_contention);
+  RUN_TEST(tr, tests::locks::measure_shared_contention);
+
+  RUN_TEST(tr, tests::allocation::count_container_allocations);
+  RUN_TEST(tr, tests::allocation::catch_forbidden_allocations);
+  RUN_TEST(tr, tests::allocation::find_without_allocations);
+  RUN_TEST(tr, tests::allocation::format_without_allocations);
+
   RUN_TEST(tr, tests::exception_dispatcher::throw_directly);
   RUN_TEST(tr, tests::exception_dispatcher::throw_in_nested_call);
   RUN_TEST(tr, tests::exception_dispatcher::throw_on_array_init);
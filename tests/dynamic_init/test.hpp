@@ -1,4 +1,5 @@
 #pragma once
+#include <basic_types.hpp>
 
 namespace tests::dynamic_init {
 // Driver Verifier must be enabled to check the destructor
@@ -0,0 +1,151 @@
+#include "test.hpp"
+
+#include <test_runner.hpp>
+
+#include <modules/event_ring/event_ring_reader.hpp>
+#include <modules/event_ring/event_ring_writer.hpp>
+
+#include <smart_pointer.hpp>
+
+using namespace ktl;
+
+namespace tests::event_ring {
+namespace details {
+inline constexpr uint32_t DATA_SIZE{1024};
+
+// Stands in for the section mapped both into the kernel and the reader
+struct alignas(ktl::event_ring::RING_LINE_SIZE) shared_view {
+  unsigned char bytes[ktl::event_ring::RING_HEADER_SIZE + DATA_SIZE];
+};
+
+struct counting_notifier {
+  void operator()() const noexcept { ++*count; }
+
+  int* count;
+};
+
+using ring_writer = ktl::event_ring::writer<counting_notifier>;
+
+static uint32_t get_length(uint32_t index) noexcept {
+  return 1 + index % 100;
+}
+
+static bool write_event(ring_writer& writer, uint32_t index) noexcept {
+  const uint32_t length{get_length(index)};
+  auto target{writer.reserve(static_cast<uint16_t>(index), length)};
+  if (!target) {
+    return false;
+  }
+  memset(target.data(), static_cast<unsigned char>(index), length);
+  writer.commit(target);
+  return true;
+}
+
+struct event_checker {
+  void operator()(uint16_t type, const void* payload, uint32_t length) {
+    const auto* bytes{static_cast<const unsigned char*>(payload)};
+    valid = valid && type == static_cast<uint16_t>(next_index) &&
+            length == get_length(next_index) &&
+            bytes[0] == static_cast<unsigned char>(next_index) &&
+            bytes[length - 1] == static_cast<unsigned char>(next_index);
+    ++next_index;
+  }
+
+  uint32_t next_index{0};
+  bool valid{true};
+};
+}  // namespace details
+
+void deliver_events() {
+  using namespace details;
+
+  int notifications{0};
+  auto view{make_unique<shared_view>()};
+  ring_writer writer{view->bytes, DATA_SIZE,
+                     counting_notifier{addressof(notifications)}};
+  ktl::event_ring::reader reader;
+  ASSERT_VALUE(reader.attach(view->bytes, sizeof(view->bytes)))
+
+  event_checker checker;
+  uint32_t written{0};
+  for (int round = 0; round < 50; ++round) {  // Wraps many times
+    for (int idx = 0; idx < 5; ++idx) {
+      ASSERT_VALUE(write_event(writer, written))
+      ++written;
+    }
+    ASSERT_EQ(reader.consume(checker), size_t{5})
+  }
+  ASSERT_VALUE(checker.valid)
+  ASSERT_EQ(checker.next_index, written)
+
+  // Uncommitted record blocks the following ones
+  auto pending{writer.reserve(1, 16)};
+  ASSERT_VALUE(static_cast<bool>(pending))
+  ASSERT_VALUE(writer.write(2, "event", 6))
+  ASSERT_VALUE(!reader.has_records())
+  writer.discard(pending);
+  uint16_t last_type{0};
+  ASSERT_EQ(reader.consume([&last_type](uint16_t type, const void*, uint32_t) {
+              last_type = type;
+            }),
+            size_t{1})
+  ASSERT_EQ(last_type, uint16_t{2})
+  ASSERT_EQ(notifications, 0)  // The reader has never waited
+}
+
+void drop_events_when_full() {
+  using namespace details;
+
+  int notifications{0};
+  auto view{make_unique<shared_view>()};
+  ring_writer writer{view->bytes, DATA_SIZE,
+                     counting_notifier{addressof(notifications)}};
+  ktl::event_ring::reader reader{view->bytes, sizeof(view->bytes)};
+  ASSERT_VALUE(reader.attached())
+
+  ASSERT_VALUE(!writer.reserve(0, writer.max_record_length() + 1))
+  uint32_t written{0};
+  while (write_event(writer, written)) {
+    ++written;
+  }
+  ASSERT_EQ(writer.dropped(), uint64_t{2})
+  ASSERT_EQ(reader.dropped(), uint64_t{2})
+
+  event_checker checker;
+  ASSERT_EQ(reader.consume(checker), size_t{written})
+  ASSERT_VALUE(checker.valid)
+  ASSERT_VALUE(write_event(writer, written))  // Space is reclaimed
+
+  // The consumer position is written by the user mode and can't be trusted
+  auto* header{reinterpret_cast<ktl::event_ring::ring_header*>(view->bytes)};
+  header->consumer_pos = header->producer_pos + DATA_SIZE;
+  ASSERT_VALUE(!write_event(writer, written + 1))
+}
+
+void wake_idle_reader() {
+  using namespace details;
+
+  int notifications{0};
+  auto view{make_unique<shared_view>()};
+  ring_writer writer{view->bytes, DATA_SIZE,
+                     counting_notifier{addressof(notifications)}};
+  ktl::event_ring::reader reader{view->bytes, sizeof(view->bytes)};
+  event_checker checker;
+
+  ASSERT_VALUE(reader.prepare_wait())
+  ASSERT_VALUE(write_event(writer, 0))
+  ASSERT_VALUE(write_event(writer, 1))
+  ASSERT_EQ(notifications, 1)  // Only the first record wakes the reader up
+
+  ASSERT_VALUE(!reader.prepare_wait())  // The records are already there
+  ASSERT_EQ(reader.consume(checker), size_t{2})
+  ASSERT_VALUE(write_event(writer, 2))
+  ASSERT_EQ(notifications, 1)
+
+  ASSERT_EQ(reader.consume(checker), size_t{1})
+  ASSERT_VALUE(reader.prepare_wait())
+  ASSERT_VALUE(write_event(writer, 3))
+  ASSERT_EQ(notifications, 2)
+  ASSERT_VALUE(checker.valid)
+}
+}  // namespace tests::event_ring
@@ -0,0 +1,7 @@
+#pragma once
+
+namespace tests::event_ring {
+void deliver_events();
+void drop_events_when_full();
+void wake_idle_reader();
+}  // namespace tests::event_ring
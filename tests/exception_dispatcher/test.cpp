@@ -59,7 +59,7 @@ void throw_directly() {
   } catch ([[maybe_unused]] const exception& exc) {
     instance_count = details::g_object_count;
   }
-  ASSERT_EQ(instance_count, 0);
+  ASSERT_EQ(instance_count, size_t{0});
 }
 
 namespace details {
@@ -68,7 +68,7 @@ void do_call(size_t counter);
 
 template <class Ty>
 void do_call_helper(size_t counter) {
-  volatile auto* do_call_ptr{&do_call<Ty>};
+  auto* volatile do_call_ptr{&do_call<Ty>};
   if (counter > 0) {
     do_call_ptr(counter - 1);
   }
@@ -91,11 +91,11 @@ void throw_in_nested_call() {
   } catch ([[maybe_unused]] const exception& exc) {
     instance_count = details::g_object_count;
   }
-  ASSERT_EQ(instance_count, 0);
+  ASSERT_EQ(instance_count, size_t{0});
 }
 
 #define MAKE_MESSAGE(Idx) /* NOLINT(cppcoreguidelines-macro-usage)*/ \
-  CONCAT(__FUNCTION__, #Idx)
+  "throw_on_array_init" #Idx
 
 void throw_on_array_init() {
   static constexpr size_t OBJECT_COUNT{5};
@@ -109,7 +109,7 @@ void throw_on_array_init() {
   } catch ([[maybe_unused]] const exception& exc) {
     instance_count = details::g_object_count;
   }
-  ASSERT_EQ(instance_count, 0);
+  ASSERT_EQ(instance_count, size_t{0});
 }
 
 #undef MAKE_MESSAGE
@@ -123,7 +123,7 @@ void throw_in_new_expression() {
   } catch ([[maybe_unused]] const exception& exc) {
     instance_count = details::g_object_count;
   }
-  ASSERT_EQ(instance_count, 0);
+  ASSERT_EQ(instance_count, size_t{0});
 }
 
 void throw_at_high_irql() {
@@ -139,7 +139,7 @@ void throw_at_high_irql() {
     instance_count = details::g_object_count;
     current_irql = get_current_irql();
   }
-  ASSERT_EQ(instance_count, 0);
+  ASSERT_EQ(instance_count, size_t{0});
   ASSERT_EQ(current_irql, prev_irql);
 }
 
@@ -171,7 +171,14 @@ CatchBlockType catch_impl(const Types&... exc_args) {
   auto catch_block{CatchBlockType::Unknown};
   try {
     [[maybe_unused]] const target_t obj{exc_args...};
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wcatch-value"  // Slicing is tested on purpose
+#endif
   } catch (ExpectedTy exc) {
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif
     if (const auto expected = Exc{exc_args...};
         get_code<ExpectedTy>(exc) == get_code<Exc>(expected) &&
         strcmp(get_what<ExpectedTy>(exc), get_what<Exc>(expected)) == 0) {
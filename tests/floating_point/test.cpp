@@ -3,6 +3,8 @@
 #include <test_runner.hpp>
 
 #include <crt_attributes.hpp>
+#include <floating_point.hpp>
+#include <irql.hpp>
 
 #include <ktlexcept.hpp>
 #include <type_traits.hpp>
@@ -68,4 +70,29 @@ void perform_arithmetic_operations() {
       NT_SUCCESS(status), status,
       "floating point operation failed with SEH exception thrown");
 }
+
+void nest_simd_scopes() {
+  const simd_level max_level{max_supported_simd_level()};
+  {
+    simd_scope outer{simd_level::avx};
+    ASSERT_VALUE(outer.level() <= max_level)
+    ASSERT_VALUE(outer.allows(simd_level::none))
+
+    simd_scope inner{outer, simd_level::sse};
+    ASSERT_VALUE(inner.level() == (outer.allows(simd_level::sse)
+                                       ? simd_level::sse
+                                       : outer.level()))
+
+    if (inner.allows(simd_level::sse)) {
+      details::perform_arithmetic_operations_impl();
+    }
+  }
+  {
+    const irql_t prev_irql{raise_irql(HIGH_LEVEL)};
+    simd_scope scope{simd_level::avx512};
+    const simd_level level{scope.level()};
+    lower_irql(prev_irql);
+    ASSERT_VALUE(level <= simd_level::sse)
+  }
+}
 }  // namespace tests::floating_point
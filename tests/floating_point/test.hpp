@@ -3,6 +3,7 @@
 namespace tests::floating_point {
 void validate_fltused();
 void perform_arithmetic_operations();
+void nest_simd_scopes();
 }
 
 
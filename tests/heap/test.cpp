@@ -63,17 +63,17 @@ auto make_align_checker() {
 #define CHECK_ALLOC_AND_FREE(FailurePolicy)                                  \
   details::alloc_and_free_impl<                                              \
       (numeric_limits<size_t>::max)(), crt::CACHE_LINE_ALLOCATION_ALIGNMENT, \
-      NonPagedPoolNx, OnAllocationFailure::##FailurePolicy, false>(          \
+      NonPagedPoolNx, OnAllocationFailure::FailurePolicy, false>(            \
       [](const void* p) { return p == nullptr; });                           \
                                                                              \
   details::alloc_and_free_impl<128, crt::DEFAULT_ALLOCATION_ALIGNMENT,       \
                                PagedPool,                                    \
-                               OnAllocationFailure::##FailurePolicy, true>(  \
+                               OnAllocationFailure::FailurePolicy, true>(    \
       details::make_align_checker<crt::DEFAULT_ALLOCATION_ALIGNMENT>());     \
                                                                              \
   details::alloc_and_free_impl<128, crt::CACHE_LINE_ALLOCATION_ALIGNMENT,    \
                                PagedPool,                                    \
-                               OnAllocationFailure::##FailurePolicy, true>(  \
+                               OnAllocationFailure::FailurePolicy, true>(    \
       details::make_align_checker<crt::CACHE_LINE_ALLOCATION_ALIGNMENT>());
 
 void alloc_and_free() {
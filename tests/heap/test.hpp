@@ -3,7 +3,7 @@
 #include <heap.hpp>
 
 namespace tests::heap {
-static constexpr ktl::crt::pool_tag_t POOL_TAG{'eHeT'};
+static constexpr ktl::crt::pool_tag_t POOL_TAG{0x65486554};  // 'eHeT'
 
 static_assert(ktl::crt::DEFAULT_HEAP_TAG == ktl::crt::KTL_HEAP_TAG);
 static_assert(ktl::crt::MEMORY_PAGE_SIZE == PAGE_SIZE);
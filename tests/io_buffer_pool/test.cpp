@@ -0,0 +1,100 @@
+#include "test.hpp"
+
+#include <test_runner.hpp>
+
+#include <io_buffer_pool.hpp>
+#include <per_cpu.hpp>
+
+using namespace ktl;
+
+namespace tests::io_buffer_pool {
+namespace details {
+static bool is_page_aligned(const void* ptr) noexcept {
+  return reinterpret_cast<uintptr_t>(ptr) % crt::MEMORY_PAGE_SIZE == 0;
+}
+}  // namespace details
+
+void visit_per_cpu_instances() {
+  per_cpu<uint32_t> counters{0u};
+  ASSERT_EQ(counters.size(), max_processor_count())
+  {
+    dispatch_level_guard guard;
+    ASSERT_VALUE(current_processor_index() < counters.size())
+    ++counters.local();
+    ASSERT_EQ(counters[current_processor_index()], 1u)
+  }
+  uint32_t total{0};
+  counters.for_each([&total](uint32_t value) { total += value; });
+  ASSERT_EQ(total, 1u)
+}
+
+void reuse_buffers() {
+  using namespace details;
+
+  ktl::io_buffer_pool pool;
+  ASSERT_VALUE(!pool.acquire(ktl::io_buffer_pool::MAX_BUFFER_SIZE + 1))
+
+  // The thread mustn't leave the processor whose cache holds the buffer
+  dispatch_level_guard guard;
+  void* data{nullptr};
+  {
+    auto buffer{pool.acquire(5000)};
+    ASSERT_VALUE(static_cast<bool>(buffer))
+    ASSERT_EQ(buffer.size(), size_t{8192})
+    ASSERT_VALUE(is_page_aligned(buffer.data()))
+    ASSERT_VALUE(buffer.mdl() == nullptr)
+    data = buffer.data();
+  }
+  auto buffer{pool.acquire(8192)};
+  ASSERT_VALUE(buffer.data() == data)
+
+  auto moved{move(buffer)};
+  ASSERT_VALUE(!buffer)
+  ASSERT_VALUE(moved.data() == data)
+
+  const auto stats{pool.stats(ktl::io_buffer_pool::get_size_class(8192))};
+  ASSERT_EQ(stats.acquired, uint64_t{2})
+  ASSERT_EQ(stats.created, uint64_t{1})
+  ASSERT_EQ(stats.failed, uint64_t{0})
+}
+
+void track_high_water() {
+  io_buffer_pool_options options;
+  options.cache_depth = 1;
+  options.shared_depth = 1;
+  ktl::io_buffer_pool pool{options};
+
+  io_buffer buffers[4];
+  for (auto& buffer : buffers) {
+    buffer = pool.acquire(1);
+    ASSERT_VALUE(static_cast<bool>(buffer))
+  }
+  for (auto& buffer : buffers) {
+    buffer.reset();
+  }
+  auto stats{pool.stats(0)};
+  ASSERT_EQ(stats.buffer_size, ktl::io_buffer_pool::MIN_BUFFER_SIZE)
+  ASSERT_EQ(stats.in_use, size_t{0})
+  ASSERT_EQ(stats.high_water, size_t{4})
+
+  pool.trim();
+  buffers[0] = pool.acquire(1);
+  stats = pool.stats(0);
+  ASSERT_EQ(stats.in_use, size_t{1})
+  ASSERT_EQ(stats.high_water, size_t{4})
+}
+
+void prepare_mdl() {
+  io_buffer_pool_options options;
+  options.build_mdl = true;
+  ktl::io_buffer_pool pool{options};
+
+  auto buffer{pool.acquire(ktl::io_buffer_pool::MAX_BUFFER_SIZE)};
+  ASSERT_VALUE(static_cast<bool>(buffer))
+  MDL* mdl{buffer.mdl()};
+  ASSERT_VALUE(mdl != nullptr)
+  ASSERT_EQ(MmGetMdlByteCount(mdl), static_cast<ULONG>(buffer.size()))
+  ASSERT_VALUE(MmGetMdlVirtualAddress(mdl) == buffer.data())
+  ASSERT_VALUE((mdl->MdlFlags & MDL_SOURCE_IS_NONPAGED_POOL) != 0)
+}
+}  // namespace tests::io_buffer_pool
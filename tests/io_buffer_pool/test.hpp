@@ -0,0 +1,8 @@
+#pragma once
+
+namespace tests::io_buffer_pool {
+void visit_per_cpu_instances();
+void reuse_buffers();
+void track_high_water();
+void prepare_mdl();
+}  // namespace tests::io_buffer_pool
@@ -0,0 +1,416 @@
+#pragma once
+#include <atomic.hpp>
+#include <basic_types.hpp>
+#include <chrono.hpp>
+#include <ktlexcept.hpp>
+#include <thread.hpp>
+#include <vector.hpp>
+
+#include <ntddk.h>
+
+/*
+ * The harness hammers any lock-free container providing
+ *   bool push(uint64_t value);   // false if a bounded container is full
+ *   bool pop(uint64_t& value);   // false if the container is empty
+ * with the concurrent producers and consumers and validates what the
+ * consumers got: every item is popped exactly once, intact, and, if the
+ * container is FIFO, in the push order of its producer
+ */
+namespace tests::lockfree {
+enum class ordering {
+  none,  // Stacks, maps, etc.
+  fifo   // Each consumer gets the items of a producer in their push order
+};
+
+enum class stress_mode {
+  producer_consumer,  // Dedicated producers and consumers
+  aba  // Each thread pops an item right after pushing its own one, so the
+       // few nodes of the short container are recycled while the preempted
+       // threads still hold the pointers to them
+};
+
+struct stress_options {
+  stress_mode mode{stress_mode::producer_consumer};
+  ordering order{ordering::none};
+  uint32_t producer_count{1};
+  uint32_t consumer_count{1};  // Ignored in the ABA mode
+  uint32_t items_per_producer{10000};
+};
+
+/**
+ * @class latency_histogram
+ * @brief Distribution of the latencies over the log-linear buckets: each
+ * power-of-2 range is split into SUB_BUCKET_COUNT buckets, so a percentile
+ * is within 12.5% of the exact value
+ */
+class latency_histogram {
+ public:
+  static constexpr uint32_t SUB_BUCKET_WIDTH{3};
+  static constexpr uint32_t SUB_BUCKET_COUNT{1u << SUB_BUCKET_WIDTH};
+  static constexpr uint32_t BUCKET_COUNT{(64 - SUB_BUCKET_WIDTH + 1) *
+                                         SUB_BUCKET_COUNT};
+
+ public:
+  void record(uint64_t value) noexcept {
+    ++m_buckets[get_bucket(value)];
+    ++m_count;
+    if (value > m_max) {
+      m_max = value;
+    }
+  }
+
+  void merge(const latency_histogram& other) noexcept {
+    for (uint32_t idx = 0; idx < BUCKET_COUNT; ++idx) {
+      m_buckets[idx] += other.m_buckets[idx];
+    }
+    m_count += other.m_count;
+    if (other.m_max > m_max) {
+      m_max = other.m_max;
+    }
+  }
+
+  // Upper bound of the bucket holding the per_mille-th value
+  [[nodiscard]] uint64_t get_percentile(uint32_t per_mille) const noexcept {
+    const uint64_t rank{(m_count * per_mille + 999) / 1000};
+    uint64_t seen{0};
+    for (uint32_t idx = 0; idx < BUCKET_COUNT; ++idx) {
+      seen += m_buckets[idx];
+      if (seen != 0 && seen >= rank) {
+        const uint64_t bound{get_upper_bound(idx)};
+        return bound < m_max ? bound : m_max;
+      }
+    }
+    return m_max;
+  }
+
+  [[nodiscard]] uint64_t count() const noexcept { return m_count; }
+  [[nodiscard]] uint64_t max() const noexcept { return m_max; }
+
+ private:
+  static uint32_t get_bucket(uint64_t value) noexcept {
+    unsigned long msb;
+    if (value < SUB_BUCKET_COUNT || !_BitScanReverse64(&msb, value)) {
+      return static_cast<uint32_t>(value);
+    }
+    const auto shift{static_cast<uint32_t>(msb) - SUB_BUCKET_WIDTH};
+    const auto sub_bucket{
+        static_cast<uint32_t>(value >> shift) & (SUB_BUCKET_COUNT - 1)};
+    return (shift + 1) * SUB_BUCKET_COUNT + sub_bucket;
+  }
+
+  static uint64_t get_upper_bound(uint32_t bucket) noexcept {
+    if (bucket < SUB_BUCKET_COUNT) {
+      return bucket;
+    }
+    const uint32_t shift{bucket / SUB_BUCKET_COUNT - 1};
+    const uint64_t lower{
+        (uint64_t{SUB_BUCKET_COUNT} + bucket % SUB_BUCKET_COUNT) << shift};
+    return lower + ((uint64_t{1} << shift) - 1);
+  }
+
+ private:
+  uint64_t m_buckets[BUCKET_COUNT]{};
+  uint64_t m_count{0};
+  uint64_t m_max{0};
+};
+
+struct latency_percentiles {  // In nanoseconds
+  uint64_t p50;
+  uint64_t p99;
+  uint64_t p999;
+  uint64_t max;
+};
+
+struct stress_result {
+  [[nodiscard]] bool valid() const noexcept {
+    return lost == 0 && duplicated == 0 && reordered == 0 && corrupted == 0 &&
+           checksum_matches;
+  }
+
+  [[nodiscard]] uint64_t ops_per_second() const noexcept {
+    const uint64_t ops{pushed + popped};
+    return elapsed_ns ? ops * 1'000'000'000 / elapsed_ns : 0;
+  }
+
+  uint64_t pushed{0};
+  uint64_t popped{0};
+  uint64_t lost{0};
+  uint64_t duplicated{0};
+  uint64_t reordered{0};
+  uint64_t corrupted{0};
+  bool checksum_matches{false};
+  uint64_t elapsed_ns{0};
+  latency_percentiles push_latency{};
+  latency_percentiles pop_latency{};
+};
+
+namespace details {
+inline constexpr uint32_t MAX_THREAD_COUNT{64};
+inline constexpr uint32_t SEQUENCE_WIDTH{32}, PRODUCER_WIDTH{16};
+inline constexpr uint64_t CHECK_MASK{0xFFFF};
+
+// The check bits catch the torn values and the stale values of the
+// recycled nodes
+constexpr uint64_t get_check(uint32_t producer, uint32_t sequence) noexcept {
+  return (sequence * 0x9E37ull ^ producer * 0x79B9ull ^ 0xA5A5ull) &
+         CHECK_MASK;
+}
+
+constexpr uint64_t make_item(uint32_t producer, uint32_t sequence) noexcept {
+  return sequence | uint64_t{producer} << SEQUENCE_WIDTH |
+         get_check(producer, sequence) << (SEQUENCE_WIDTH + PRODUCER_WIDTH);
+}
+
+inline uint32_t count_bits(uint64_t word) noexcept {
+  uint32_t count{0};
+  for (; word; word &= word - 1) {
+    ++count;
+  }
+  return count;
+}
+
+struct shared_state {
+  ktl::atomic<uint32_t> ready{0};
+  ktl::atomic<bool> started{false};
+  ktl::atomic<uint32_t> finished_producers{0};
+};
+
+struct thread_context {
+  thread_context(const stress_options& options_, bool consumes)
+      : options{ktl::addressof(options_)},
+        next_sequence(consumes ? options_.producer_count : 0, 0),
+        seen(consumes ? (get_item_count() + 63) / 64 : 0, 0) {}
+
+  uint64_t get_item_count() const noexcept {
+    return uint64_t{options->producer_count} * options->items_per_producer;
+  }
+
+  void consume(uint64_t item) noexcept {
+    ++popped;
+    checksum += item;
+
+    const auto sequence{static_cast<uint32_t>(item)};
+    const auto producer{static_cast<uint32_t>(
+        (item >> SEQUENCE_WIDTH) & ((1ull << PRODUCER_WIDTH) - 1))};
+    const uint64_t check{item >> (SEQUENCE_WIDTH + PRODUCER_WIDTH)};
+    if (producer >= options->producer_count ||
+        sequence >= options->items_per_producer ||
+        check != get_check(producer, sequence)) {
+      ++corrupted;
+      return;
+    }
+
+    const uint64_t index{uint64_t{producer} * options->items_per_producer +
+                         sequence};
+    const uint64_t mask{uint64_t{1} << (index % 64)};
+    auto& word{seen[static_cast<size_t>(index / 64)]};
+    if (word & mask) {
+      ++duplicated;
+    }
+    word |= mask;
+
+    if (options->order == ordering::fifo) {
+      auto& next{next_sequence[producer]};
+      if (sequence < next) {
+        ++reordered;
+      } else {
+        next = sequence + 1;
+      }
+    }
+  }
+
+  // Counts the items seen both by this and by the previous consumers
+  uint64_t merge_seen(ktl::vector<uint64_t>& all_seen) const noexcept {
+    uint64_t overlapped{0};
+    for (size_t idx = 0; idx < seen.size(); ++idx) {
+      overlapped += count_bits(all_seen[idx] & seen[idx]);
+      all_seen[idx] |= seen[idx];
+    }
+    return overlapped;
+  }
+
+  const stress_options* options;
+  ktl::vector<uint32_t> next_sequence;
+  ktl::vector<uint64_t> seen;
+  latency_histogram push_latency;
+  latency_histogram pop_latency;
+  uint64_t pushed{0};
+  uint64_t popped{0};
+  uint64_t checksum{0};
+  uint64_t duplicated{0};
+  uint64_t reordered{0};
+  uint64_t corrupted{0};
+};
+
+template <class Container>
+void pop_item(Container& container, thread_context& ctx) {
+  uint64_t item;
+  for (;;) {
+    const uint64_t started{ReadTimeStampCounter()};
+    if (container.pop(item)) {
+      ctx.pop_latency.record(ReadTimeStampCounter() - started);
+      ctx.consume(item);
+      return;
+    }
+    ktl::this_thread::yield();  // The item is being pushed by other thread
+  }
+}
+
+template <class Container>
+void produce(Container& container,
+             shared_state& state,
+             thread_context& ctx,
+             uint32_t producer) {
+  const auto& options{*ctx.options};
+  for (uint32_t sequence = 0; sequence < options.items_per_producer;
+       ++sequence) {
+    const uint64_t item{make_item(producer, sequence)};
+    const uint64_t started{ReadTimeStampCounter()};
+    while (!container.push(item)) {
+      ktl::this_thread::yield();  // A bounded container is full
+    }
+    ctx.push_latency.record(ReadTimeStampCounter() - started);
+    ++ctx.pushed;
+    if (options.mode == stress_mode::aba) {
+      pop_item(container, ctx);
+    }
+  }
+  state.finished_producers.fetch_add<ktl::memory_order_release>(1);
+}
+
+template <class Container>
+void consume(Container& container,
+             shared_state& state,
+             thread_context& ctx) {
+  const uint32_t producer_count{ctx.options->producer_count};
+  uint64_t item;
+  for (;;) {
+    // The container is drained if it's empty after all of the pushes
+    const bool drained{
+        state.finished_producers.load<ktl::memory_order_acquire>() ==
+        producer_count};
+    const uint64_t started{ReadTimeStampCounter()};
+    if (container.pop(item)) {
+      ctx.pop_latency.record(ReadTimeStampCounter() - started);
+      ctx.consume(item);
+    } else if (drained) {
+      break;
+    } else {
+      ktl::this_thread::yield();
+    }
+  }
+}
+
+inline latency_percentiles to_percentiles(const latency_histogram& histogram,
+                                          uint64_t elapsed_ns,
+                                          uint64_t elapsed_ticks) noexcept {
+  const auto to_ns{[elapsed_ns, elapsed_ticks](uint64_t ticks) {
+    return elapsed_ticks ? ticks * elapsed_ns / elapsed_ticks : 0;
+  }};
+  return {to_ns(histogram.get_percentile(500)),
+          to_ns(histogram.get_percentile(990)),
+          to_ns(histogram.get_percentile(999)), to_ns(histogram.max())};
+}
+}  // namespace details
+
+/**
+ * @brief Runs the producers and the consumers concurrently until all of the
+ * items are popped, then pops the rest of the container in the calling
+ * thread and validates the items. The latencies are measured by the time
+ * stamp counter calibrated against steady_clock during the run
+ */
+template <class Container>
+stress_result run_stress(Container& container, const stress_options& options) {
+  using namespace details;
+
+  const bool aba{options.mode == stress_mode::aba};
+  const uint32_t consumer_count{aba ? 0 : options.consumer_count};
+  const uint32_t thread_count{options.producer_count + consumer_count};
+  ktl::throw_exception_if_not<ktl::invalid_argument>(
+      options.producer_count > 0 && (aba || consumer_count > 0) &&
+          thread_count <= MAX_THREAD_COUNT &&
+          options.producer_count < (1u << PRODUCER_WIDTH),
+      "invalid number of threads");
+
+  shared_state state;
+  ktl::vector<thread_context> contexts;
+  contexts.reserve(thread_count + 1);
+  for (uint32_t idx = 0; idx < thread_count; ++idx) {
+    contexts.emplace_back(options, aba || idx >= options.producer_count);
+  }
+  auto& leftover{contexts.emplace_back(options, true)};
+
+  auto run{[&container, &state, &contexts, &options](uint32_t idx) {
+    state.ready.fetch_add(1);
+    while (!state.started.load<ktl::memory_order_acquire>()) {
+      ktl::this_thread::yield();
+    }
+    if (idx < options.producer_count) {
+      produce(container, state, contexts[idx], idx);
+    } else {
+      consume(container, state, contexts[idx]);
+    }
+  }};
+
+  ktl::vector<ktl::system_thread> threads;
+  threads.reserve(thread_count);
+  for (uint32_t idx = 0; idx < thread_count; ++idx) {
+    threads.emplace_back(run, idx);
+  }
+  while (state.ready.load<ktl::memory_order_acquire>() != thread_count) {
+    ktl::this_thread::yield();
+  }
+  const auto started_at{ktl::chrono::steady_clock::now()};
+  const uint64_t started_ticks{ReadTimeStampCounter()};
+  state.started.store<ktl::memory_order_release>(true);
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  const uint64_t elapsed_ticks{ReadTimeStampCounter() - started_ticks};
+  const auto elapsed{ktl::chrono::duration_cast<ktl::chrono::nanoseconds>(
+      ktl::chrono::steady_clock::now() - started_at)};
+
+  // None of the items may be left behind
+  for (uint64_t item; container.pop(item);) {
+    leftover.consume(item);
+  }
+
+  stress_result result;
+  result.elapsed_ns = static_cast<uint64_t>(elapsed.count());
+  const uint64_t item_count{leftover.get_item_count()};
+  uint64_t expected_checksum{0};
+  for (uint32_t producer = 0; producer < options.producer_count; ++producer) {
+    for (uint32_t sequence = 0; sequence < options.items_per_producer;
+         ++sequence) {
+      expected_checksum += make_item(producer, sequence);
+    }
+  }
+
+  ktl::vector<uint64_t> seen((item_count + 63) / 64, 0);
+  uint64_t checksum{0};
+  for (const auto& ctx : contexts) {
+    result.pushed += ctx.pushed;
+    result.popped += ctx.popped;
+    result.duplicated += ctx.duplicated + ctx.merge_seen(seen);
+    result.reordered += ctx.reordered;
+    result.corrupted += ctx.corrupted;
+    checksum += ctx.checksum;
+    if (ktl::addressof(ctx) != ktl::addressof(leftover)) {
+      // The leftover pops aren't timed, so its histograms collect the rest
+      leftover.push_latency.merge(ctx.push_latency);
+      leftover.pop_latency.merge(ctx.pop_latency);
+    }
+  }
+  uint64_t unique_count{0};
+  for (const auto word : seen) {
+    unique_count += count_bits(word);
+  }
+  result.lost = item_count - unique_count;
+  result.checksum_matches = checksum == expected_checksum;
+  result.push_latency =
+      to_percentiles(leftover.push_latency, result.elapsed_ns, elapsed_ticks);
+  result.pop_latency =
+      to_percentiles(leftover.pop_latency, result.elapsed_ns, elapsed_ticks);
+  return result;
+}
+}  // namespace tests::lockfree
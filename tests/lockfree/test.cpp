@@ -0,0 +1,234 @@
+#include "test.hpp"
+#include "stress.hpp"
+
+#include <test_runner.hpp>
+
+#include <modules/lockfree/bounded_queue.hpp>
+#include <modules/lockfree/node_allocator.hpp>
+#include <modules/lockfree/queue.hpp>
+#include <modules/lockfree/tagged_pointer.hpp>
+
+#include <allocator.hpp>
+#include <atomic.hpp>
+#include <smart_pointer.hpp>
+#include <thread.hpp>
+#include <vector.hpp>
+
+#include <ntddk.h>
+
+using namespace ktl;
+
+namespace tests::lockfree {
+namespace details {
+using queue_type = ktl::lockfree::queue<uint64_t>;
+
+using node_allocator_type =
+    ktl::lockfree::node_allocator<uint64_t,
+                                  static_cast<align_val_t>(alignof(uint64_t)),
+                                  aligned_non_paged_allocator>;
+
+template <size_t Capacity>
+struct bounded_queue_adapter {
+  bool push(uint64_t value) noexcept { return queue.try_push(value); }
+  bool pop(uint64_t& value) noexcept { return queue.try_pop(value); }
+
+  ktl::lockfree::mpmc_bounded_queue<uint64_t, Capacity> queue;
+};
+
+struct thread_counts {
+  uint32_t producers;
+  uint32_t consumers;
+};
+
+static constexpr thread_counts THREAD_COUNTS[]{
+    {1, 1}, {2, 2}, {4, 4}, {1, 4}, {4, 1}};
+static constexpr uint32_t ITEMS_PER_PRODUCER{20000};
+
+static void print_result(const char* name,
+                         const stress_options& options,
+                         const stress_result& result) {
+  const auto& push{result.push_latency};
+  const auto& pop{result.pop_latency};
+  tests::details::print(
+      "{} {}p/{}c: {} ops/s, p50/p99/p99.9/max push {}/{}/{}/{} ns, "
+      "pop {}/{}/{}/{} ns\n",
+      name, options.producer_count,
+      options.mode == stress_mode::aba ? 0 : options.consumer_count,
+      result.ops_per_second(), push.p50, push.p99, push.p999, push.max,
+      pop.p50, pop.p99, pop.p999, pop.max);
+}
+
+static void verify_result(const stress_result& result,
+                          const stress_options& options) {
+  const uint64_t item_count{uint64_t{options.producer_count} *
+                            options.items_per_producer};
+  ASSERT_EQ(result.pushed, item_count)
+  ASSERT_EQ(result.popped, item_count)
+  ASSERT_EQ(result.lost, uint64_t{0})
+  ASSERT_EQ(result.duplicated, uint64_t{0})
+  ASSERT_EQ(result.reordered, uint64_t{0})
+  ASSERT_EQ(result.corrupted, uint64_t{0})
+  ASSERT_VALUE(result.checksum_matches)
+}
+}  // namespace details
+
+void pack_tagged_pointer() {
+  using pointer_type = ktl::lockfree::tagged_pointer<uint64_t>;
+
+  uint64_t value{42};
+  const pointer_type ptr{addressof(value), 0xFFFF};
+  ASSERT_VALUE(ptr.get_pointer() == addressof(value))
+  ASSERT_EQ(ptr.get_tag(), uint16_t{0xFFFF})
+
+  const pointer_type unpacked{ptr.get_value()};
+  ASSERT_VALUE(unpacked.get_pointer() == addressof(value))
+  ASSERT_EQ(unpacked.get_tag(), uint16_t{0xFFFF})
+
+  // The tag wraps around keeping the pointer, and the packed values differ,
+  // so CAS fails on the stale tag though == compares the pointers only
+  const pointer_type next{ptr.get_pointer(), ptr.get_next_tag()};
+  ASSERT_EQ(next.get_tag(), uint16_t{0})
+  ASSERT_VALUE(next.get_pointer() == addressof(value))
+  ASSERT_VALUE(next.get_value() != ptr.get_value())
+  ASSERT_VALUE(next == ptr)
+
+  ASSERT_VALUE(static_cast<bool>(ptr))
+  ASSERT_VALUE(!pointer_type{})
+  ASSERT_VALUE(!pointer_type(nullptr, 1))
+}
+
+void reuse_freed_nodes() {
+  using namespace details;
+
+  node_allocator_type allocator{2};
+  auto* first{allocator.allocate()};
+  auto* second{allocator.allocate()};
+  auto* third{allocator.allocate()};  // The preallocated nodes are exhausted
+  ASSERT_VALUE(first != second && second != third && first != third)
+
+  // The free list is LIFO
+  allocator.deallocate(second);
+  allocator.deallocate(first);
+  ASSERT_VALUE(allocator.allocate() == first)
+  ASSERT_VALUE(allocator.allocate() == second)
+  allocator.deallocate(third);
+  allocator.deallocate(second);
+  allocator.deallocate(first);
+}
+
+void allocate_nodes_concurrently() {
+  using namespace details;
+
+  constexpr uint32_t THREAD_COUNT{8};
+  constexpr uint32_t ROUND_COUNT{20000};
+
+  // The few nodes are reused all the time, so a pop holding a stale top
+  // would hand out a node owned by the other thread
+  node_allocator_type allocator{THREAD_COUNT / 2};
+  atomic<uint32_t> stolen{0};
+  auto allocate{[&allocator, &stolen](uint32_t idx) {
+    for (uint32_t round = 0; round < ROUND_COUNT; ++round) {
+      auto* node{allocator.allocate()};
+      const uint64_t stamp{uint64_t{idx} << 32 | round};
+      *static_cast<volatile uint64_t*>(node) = stamp;
+      if (round % 16 == 0) {
+        this_thread::yield();
+      }
+      if (*static_cast<volatile uint64_t*>(node) != stamp) {
+        stolen.fetch_add<memory_order_relaxed>(1);
+      }
+      allocator.deallocate(node);
+    }
+  }};
+
+  system_thread threads[THREAD_COUNT];
+  for (uint32_t idx = 0; idx < THREAD_COUNT; ++idx) {
+    threads[idx] = system_thread{allocate, idx};
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  ASSERT_EQ(stolen.load(), uint32_t{0})
+}
+
+void keep_queue_order() {
+  using namespace details;
+
+  queue_type queue{4, queue_type::allocator_type{}};
+  uint64_t value;
+  ASSERT_VALUE(!queue.pop(value))
+  for (uint64_t idx = 0; idx < 100; ++idx) {
+    ASSERT_VALUE(queue.push(idx))
+  }
+  for (uint64_t idx = 0; idx < 50; ++idx) {
+    ASSERT_VALUE(queue.pop(value))
+    ASSERT_EQ(value, idx)
+  }
+  ASSERT_VALUE(queue.unsynchronized_push(uint64_t{100}))
+  for (uint64_t idx = 50; idx <= 100; ++idx) {
+    ASSERT_VALUE(queue.unsynchronized_pop(value))
+    ASSERT_EQ(value, idx)
+  }
+  ASSERT_VALUE(!queue.unsynchronized_pop(value))
+
+  // The destructor frees the nodes left in the queue
+  for (uint64_t idx = 0; idx < 10; ++idx) {
+    ASSERT_VALUE(queue.push(idx))
+  }
+}
+
+void stress_queue() {
+  using namespace details;
+
+  for (const auto& counts : THREAD_COUNTS) {
+    stress_options options;
+    options.order = ordering::fifo;
+    options.producer_count = counts.producers;
+    options.consumer_count = counts.consumers;
+    options.items_per_producer = ITEMS_PER_PRODUCER;
+
+    queue_type queue;
+    const auto result{run_stress(queue, options)};
+    print_result("mpmc_queue", options, result);
+    verify_result(result, options);
+  }
+}
+
+void stress_queue_aba() {
+  using namespace details;
+
+  // More threads than processors are preempted in the middle of the CAS
+  // loops, while the tiny pool makes the reused node addresses very likely
+  const uint32_t thread_count{
+      (max)(8u, (min)(2 * system_thread::hardware_concurrency(),
+                      MAX_THREAD_COUNT))};
+  stress_options options;
+  options.mode = stress_mode::aba;
+  options.order = ordering::fifo;
+  options.producer_count = thread_count;
+  options.items_per_producer = ITEMS_PER_PRODUCER;
+
+  queue_type queue{2, queue_type::allocator_type{}};
+  const auto result{run_stress(queue, options)};
+  print_result("mpmc_queue (ABA)", options, result);
+  verify_result(result, options);
+}
+
+void stress_bounded_queue() {
+  using namespace details;
+
+  for (const auto& counts : THREAD_COUNTS) {
+    stress_options options;
+    options.order = ordering::fifo;
+    options.producer_count = counts.producers;
+    options.consumer_count = counts.consumers;
+    options.items_per_producer = ITEMS_PER_PRODUCER;
+
+    // The small capacity makes the producers wait for the consumers
+    auto queue{make_unique<bounded_queue_adapter<64>>()};
+    const auto result{run_stress(*queue, options)};
+    print_result("mpmc_bounded_queue", options, result);
+    verify_result(result, options);
+  }
+}
+}  // namespace tests::lockfree
@@ -0,0 +1,11 @@
+#pragma once
+
+namespace tests::lockfree {
+void pack_tagged_pointer();
+void reuse_freed_nodes();
+void allocate_nodes_concurrently();
+void keep_queue_order();
+void stress_queue();
+void stress_queue_aba();
+void stress_bounded_queue();
+}  // namespace tests::lockfree
@@ -0,0 +1,86 @@
+#include "test.hpp"
+
+#include <test_runner.hpp>
+
+#include <contention.hpp>
+
+#include <algorithm.hpp>
+#include <initializer_list.hpp>
+
+using namespace ktl;
+
+namespace tests::locks {
+namespace details {
+using benchmarks::locks::exclusive_case;
+using benchmarks::locks::shared_case;
+
+inline constexpr uint32_t THREAD_COUNTS[]{1, 2, 4};
+inline constexpr uint32_t CRITICAL_SECTION{16};  // Iterations under the lock
+
+#ifdef KTL_HOSTED
+// The hosted layer emulates the kernel locks over the host threads, so the
+// numbers printed there don't describe the kernel ones
+inline constexpr const char* PLATFORM{"hosted emulation"};
+#else
+inline constexpr const char* PLATFORM{"kernel"};
+#endif
+
+/**
+ * @brief Prints the acquisitions per second and the spread between the
+ * threads (a high one means some of them starve)
+ * @return Whether the writers have been excluded
+ */
+template <class Case>
+bool measure(const char* name, uint32_t thread_count, uint32_t read_percent) {
+  const auto run{benchmarks::locks::run_contention<Case>(
+      {thread_count, CRITICAL_SECTION, read_percent})};
+
+  uint64_t acquisitions{0};
+  uint64_t min_acquisitions{~uint64_t{0}};
+  uint64_t max_acquisitions{0};
+  for (uint32_t idx = 0; idx < thread_count; ++idx) {
+    acquisitions += run.acquisitions[idx];
+    min_acquisitions = (min)(min_acquisitions, run.acquisitions[idx]);
+    max_acquisitions = (max)(max_acquisitions, run.acquisitions[idx]);
+  }
+  tests::details::print(
+      "{} ({}): {} threads, {}% reads: {} acquisitions per second, "
+      "{}..{} per thread\n",
+      name, PLATFORM, thread_count, read_percent,
+      acquisitions * 1'000'000'000 / (run.elapsed_ns + 1), min_acquisitions,
+      max_acquisitions);
+  return run.excluded;
+}
+
+template <class Case>
+bool measure_all(const char* name, uint32_t read_percent) {
+  bool excluded{true};
+  for (const auto thread_count : THREAD_COUNTS) {
+    excluded = measure<Case>(name, thread_count, read_percent) && excluded;
+  }
+  return excluded;
+}
+}  // namespace details
+
+void measure_exclusive_contention() {
+  using namespace details;
+
+  ASSERT_VALUE(measure_all<exclusive_case<spin_lock<>>>("spin_lock", 0))
+  ASSERT_VALUE(
+      measure_all<exclusive_case<queued_spin_lock<>>>("queued_spin_lock", 0))
+  ASSERT_VALUE(measure_all<exclusive_case<fast_mutex>>("fast_mutex", 0))
+  ASSERT_VALUE(
+      measure_all<exclusive_case<recursive_mutex>>("recursive_mutex", 0))
+}
+
+void measure_shared_contention() {
+  using namespace details;
+
+  for (const uint32_t read_percent : {0, 50, 90}) {
+    ASSERT_VALUE(
+        measure_all<shared_case<push_lock>>("push_lock", read_percent))
+    ASSERT_VALUE(
+        measure_all<shared_case<shared_mutex>>("shared_mutex", read_percent))
+  }
+}
+}  // namespace tests::locks
@@ -0,0 +1,6 @@
+#pragma once
+
+namespace tests::locks {
+void measure_exclusive_contention();
+void measure_shared_contention();
+}  // namespace tests::locks
@@ -0,0 +1,446 @@
+#include "test.hpp"
+
+#include <test_runner.hpp>
+
+#include <modules/compression/lz4_block.hpp>
+#include <modules/compression/lz4_frame.hpp>
+
+#include <algorithm.hpp>
+#include <chrono.hpp>
+#include <initializer_list.hpp>
+#include <smart_pointer.hpp>
+#include <vector.hpp>
+
+using namespace ktl;
+
+namespace tests::lz4 {
+namespace details {
+using byte_vector = vector<byte, basic_non_paged_allocator<byte> >;
+
+enum class content { zeros, text, random };
+
+static byte_vector make_data(size_t size, content kind) {
+  static constexpr char WORDS[]{
+      "event file open close read write rename delete path volume "};
+  byte_vector data(size);
+  uint32_t state{0x2545f491};
+  for (size_t idx = 0; idx < size; ++idx) {
+    state = state * 1664525 + 1013904223;  // LCG
+    switch (kind) {
+      case content::zeros:
+        data[idx] = 0;
+        break;
+      case content::text:
+        data[idx] = static_cast<byte>(
+            state >> 28 ? WORDS[idx % (sizeof(WORDS) - 1)] : state >> 20);
+        break;
+      default:
+        data[idx] = static_cast<byte>(state >> 24);
+        break;
+    }
+  }
+  return data;
+}
+
+static bool equals(const byte* lhs, const byte* rhs, size_t size) noexcept {
+  return size == 0 || memcmp(lhs, rhs, size) == 0;
+}
+
+static bool round_trip(const byte_vector& data,
+                       ktl::lz4::hash_table<>& table) {
+  byte_vector compressed(ktl::lz4::compress_bound(data.size()));
+  const size_t compressed_size{ktl::lz4::compress_block(
+      data.data(), data.size(), compressed.data(), compressed.size(), table)};
+  if (compressed_size == 0) {
+    return false;
+  }
+  byte_vector decompressed(data.size() + 1);
+  const size_t decompressed_size{
+      ktl::lz4::decompress_block(compressed.data(), compressed_size,
+                                 decompressed.data(), decompressed.size())};
+  return decompressed_size == data.size() &&
+         equals(decompressed.data(), data.data(), data.size());
+}
+
+static size_t compress_frame(const byte_vector& data,
+                             const ktl::lz4::frame_options& options,
+                             byte_vector& frame) {
+  auto writer{make_unique<ktl::lz4::frame_writer<> >(options)};
+  const size_t block_size{writer->block_size()};
+  const size_t block_count{data.size() / block_size + 1};
+  frame.resize(ktl::lz4::MAX_FRAME_HEADER_SIZE +
+               block_count * writer->block_bound(block_size) +
+               ktl::lz4::MAX_FRAME_END_SIZE);
+  size_t written{writer->write_header(frame.data(), frame.size())};
+  for (size_t offset = 0; offset < data.size(); offset += block_size) {
+    const size_t size{(min)(block_size, data.size() - offset)};
+    written += writer->write_block(data.data() + offset, size,
+                                   frame.data() + written,
+                                   frame.size() - written);
+  }
+  written += writer->write_end(frame.data() + written, frame.size() - written);
+  return written;
+}
+
+// Feeds the frame by the pieces of chunk_size bytes
+static bool decompress_frame(const byte_vector& frame,
+                             size_t frame_size,
+                             size_t chunk_size,
+                             byte_vector& output) {
+  ktl::lz4::frame_reader reader;
+  byte_vector block(get_block_size(ktl::lz4::block_size_id::max_256kb));
+  size_t consumed{0};
+  size_t available{(min)(chunk_size, frame_size)};
+  output.clear();
+  while (!reader.finished()) {
+    const auto result{reader.read(frame.data() + consumed,
+                                  available - consumed, block.data(),
+                                  block.size())};
+    switch (result.status) {
+      case ktl::lz4::frame_status::need_more_input:
+        if (available == frame_size) {
+          return false;
+        }
+        available = (min)(available + chunk_size, frame_size);
+        break;
+      case ktl::lz4::frame_status::ok:
+      case ktl::lz4::frame_status::finished:
+        consumed += result.consumed;
+        output.insert(output.end(), block.data(),
+                      block.data() + result.produced);
+        break;
+      default:
+        return false;
+    }
+  }
+  return consumed == frame_size;
+}
+
+// The reference vectors are produced by liblz4 1.9.4 (python-lz4):
+// lz4.block.compress(data, store_size=False) for the blocks and
+// lz4.frame.compress(data, block_linked=False, ...) for the frames
+
+// "abc" x 14: the match overlaps its own output
+static constexpr byte OVERLAP_BLOCK[]{0x3f, 0x61, 0x62, 0x63, 0x03, 0x00, 0x0f,
+                                      0x50, 0x62, 0x63, 0x61, 0x62, 0x63};
+
+// 0x20..0x47 twice: 40 literals need the extra length byte
+static constexpr byte LONG_LITERALS_BLOCK[]{
+    0xff, 0x19, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26, 0x27, 0x28, 0x29,
+    0x2a, 0x2b, 0x2c, 0x2d, 0x2e, 0x2f, 0x30, 0x31, 0x32, 0x33, 0x34, 0x35,
+    0x36, 0x37, 0x38, 0x39, 0x3a, 0x3b, 0x3c, 0x3d, 0x3e, 0x3f, 0x40, 0x41,
+    0x42, 0x43, 0x44, 0x45, 0x46, 0x47, 0x28, 0x00, 0x10, 0x50, 0x43, 0x44,
+    0x45, 0x46, 0x47};
+
+// 'x' x 1000: the match length takes several 255 bytes
+static constexpr byte LONG_MATCH_BLOCK[]{0x1f, 0x78, 0x01, 0x00, 0xff,
+                                         0xff, 0xff, 0xd2, 0x50, 0x78,
+                                         0x78, 0x78, 0x78, 0x78};
+
+static constexpr byte EMPTY_BLOCK[]{0x00};
+
+// Reference text + noise, content size, block and content checksums
+static constexpr byte CHECKED_FRAME[]{
+    0x04, 0x22, 0x4d, 0x18, 0x7c, 0x40, 0x04, 0x01, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x8e, 0x5a, 0x00, 0x00, 0x00, 0xf0, 0x10, 0x65, 0x76, 0x65,
+    0x6e, 0x74, 0x20, 0x66, 0x69, 0x6c, 0x65, 0x20, 0x6f, 0x70, 0x65, 0x6e,
+    0x20, 0x63, 0x6c, 0x6f, 0x73, 0x65, 0x20, 0x72, 0x65, 0x61, 0x64, 0x20,
+    0x77, 0x72, 0x69, 0x74, 0x0b, 0x00, 0xff, 0x09, 0x6e, 0x61, 0x6d, 0x65,
+    0x20, 0x64, 0x65, 0x6c, 0x65, 0x74, 0x65, 0x20, 0x70, 0x61, 0x74, 0x68,
+    0x20, 0x76, 0x6f, 0x6c, 0x75, 0x6d, 0x65, 0x20, 0x3b, 0x00, 0x9e, 0xf0,
+    0x09, 0x0d, 0xb4, 0x60, 0x0c, 0xb3, 0x5f, 0x0b, 0xb2, 0x5e, 0x0a, 0xb1,
+    0x5d, 0x09, 0xb0, 0x5c, 0x08, 0xaf, 0x5b, 0x07, 0xae, 0x5a, 0x06, 0xad,
+    0x59, 0xdf, 0x26, 0x65, 0xd2, 0x00, 0x00, 0x00, 0x00, 0xf8, 0xc2, 0xf5,
+    0x25};
+
+// Reference noise in an uncompressed block, content checksum
+static constexpr byte STORED_FRAME[]{
+    0x04, 0x22, 0x4d, 0x18, 0x64, 0x40, 0xa7, 0x18, 0x00, 0x00, 0x80,
+    0x0d, 0xb4, 0x60, 0x0c, 0xb3, 0x5f, 0x0b, 0xb2, 0x5e, 0x0a, 0xb1,
+    0x5d, 0x09, 0xb0, 0x5c, 0x08, 0xaf, 0x5b, 0x07, 0xae, 0x5a, 0x06,
+    0xad, 0x59, 0x00, 0x00, 0x00, 0x00, 0xee, 0x2b, 0xdf, 0xac};
+
+// Reference text, content checksum
+static constexpr byte TEXT_FRAME[]{
+    0x04, 0x22, 0x4d, 0x18, 0x64, 0x40, 0xa7, 0x46, 0x00, 0x00, 0x00, 0xf0,
+    0x10, 0x65, 0x76, 0x65, 0x6e, 0x74, 0x20, 0x66, 0x69, 0x6c, 0x65, 0x20,
+    0x6f, 0x70, 0x65, 0x6e, 0x20, 0x63, 0x6c, 0x6f, 0x73, 0x65, 0x20, 0x72,
+    0x65, 0x61, 0x64, 0x20, 0x77, 0x72, 0x69, 0x74, 0x0b, 0x00, 0xff, 0x09,
+    0x6e, 0x61, 0x6d, 0x65, 0x20, 0x64, 0x65, 0x6c, 0x65, 0x74, 0x65, 0x20,
+    0x70, 0x61, 0x74, 0x68, 0x20, 0x76, 0x6f, 0x6c, 0x75, 0x6d, 0x65, 0x20,
+    0x3b, 0x00, 0x99, 0x50, 0x6c, 0x75, 0x6d, 0x65, 0x20, 0x00, 0x00, 0x00,
+    0x00, 0x57, 0x28, 0x81, 0x2c};
+
+// Reference text in two linked blocks (the default of LZ4F): the second one
+// refers to the first
+static constexpr byte LINKED_FRAME[]{
+    0x04, 0x22, 0x4d, 0x18, 0x44, 0x40, 0x5e, 0x46, 0x00, 0x00, 0x00, 0xff,
+    0x2c, 0x65, 0x76, 0x65, 0x6e, 0x74, 0x20, 0x66, 0x69, 0x6c, 0x65, 0x20,
+    0x6f, 0x70, 0x65, 0x6e, 0x20, 0x63, 0x6c, 0x6f, 0x73, 0x65, 0x20, 0x72,
+    0x65, 0x61, 0x64, 0x20, 0x77, 0x72, 0x69, 0x74, 0x65, 0x20, 0x72, 0x65,
+    0x6e, 0x61, 0x6d, 0x65, 0x20, 0x64, 0x65, 0x6c, 0x65, 0x74, 0x65, 0x20,
+    0x70, 0x61, 0x74, 0x68, 0x20, 0x76, 0x6f, 0x6c, 0x75, 0x6d, 0x65, 0x20,
+    0x3b, 0x00, 0x25, 0x50, 0x6d, 0x65, 0x20, 0x65, 0x76, 0x0a, 0x00, 0x00,
+    0x00, 0x0f, 0x76, 0x00, 0x5c, 0x50, 0x6c, 0x75, 0x6d, 0x65, 0x20, 0x00,
+    0x00, 0x00, 0x00, 0x57, 0x28, 0x81, 0x2c};
+
+// Bytes first, first + 1, ..., first + period - 1 repeated
+static byte_vector make_periodic(size_t size, byte first, size_t period) {
+  byte_vector data(size);
+  for (size_t idx = 0; idx < size; ++idx) {
+    data[idx] = static_cast<byte>(first + idx % period);
+  }
+  return data;
+}
+
+// The text of the reference frames
+static byte_vector make_reference_text() {
+  static constexpr char WORDS[]{
+      "event file open close read write rename delete path volume "};
+  byte_vector data;
+  for (int round = 0; round < 4; ++round) {
+    data.insert(data.end(), WORDS, WORDS + sizeof(WORDS) - 1);
+  }
+  return data;
+}
+
+// The incompressible tail of the reference frames
+static byte_vector make_reference_noise() {
+  byte_vector data(24);
+  for (size_t idx = 0; idx < data.size(); ++idx) {
+    data[idx] = static_cast<byte>((idx * 167 + 13) % 251);
+  }
+  return data;
+}
+
+template <size_t N>
+static byte_vector to_vector(const byte (&data)[N]) {
+  return byte_vector(data, data + N);
+}
+
+template <size_t N>
+static bool decompresses_to(const byte (&block)[N],
+                            const byte_vector& expected) {
+  byte_vector output(expected.size() + 16);
+  const size_t size{ktl::lz4::decompress_block(block, N, output.data(),
+                                               output.size())};
+  return size == expected.size() &&
+         equals(output.data(), expected.data(), expected.size());
+}
+
+template <size_t N>
+static bool reads_to(const byte (&reference)[N], const byte_vector& expected) {
+  const auto frame{to_vector(reference)};
+  byte_vector output;
+  for (const size_t chunk_size : {size_t{1}, size_t{7}, N}) {
+    if (!decompress_frame(frame, N, chunk_size, output) ||
+        output.size() != expected.size() ||
+        !equals(output.data(), expected.data(), expected.size())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// The writer's header (with its XXH32 byte) and the end mark with the
+// content XXH32 must match the reference. The blocks may differ: the
+// compressors aren't required to choose the same matches
+template <size_t N>
+static bool writes_like(const byte_vector& data,
+                        const ktl::lz4::frame_options& options,
+                        const byte (&reference)[N],
+                        size_t header_size) {
+  static constexpr size_t END_SIZE{8};
+  byte_vector frame;
+  const size_t frame_size{compress_frame(data, options, frame)};
+  return frame_size > header_size + END_SIZE &&
+         equals(frame.data(), reference, header_size) &&
+         equals(frame.data() + frame_size - END_SIZE, reference + N - END_SIZE,
+                END_SIZE);
+}
+
+static uint64_t get_mb_per_second(size_t bytes,
+                                  chrono::steady_clock::duration elapsed) {
+  const auto ns{static_cast<uint64_t>(
+      chrono::duration_cast<chrono::nanoseconds>(elapsed).count())};
+  return uint64_t{bytes} * 1000 / (ns + 1);
+}
+}  // namespace details
+
+void round_trip_blocks() {
+  using namespace details;
+
+  auto table{make_unique<ktl::lz4::hash_table<> >()};
+  for (const auto kind : {content::zeros, content::text, content::random}) {
+    for (const size_t size : {0, 1, 12, 13, 64, 1000, 65536, 300000}) {
+      ASSERT_VALUE(round_trip(make_data(size, kind), *table))
+    }
+  }
+
+  // Highly compressible data shrinks a lot, random data barely grows
+  const auto zeros{make_data(65536, content::zeros)};
+  byte_vector compressed(ktl::lz4::compress_bound(zeros.size()));
+  const size_t compressed_size{
+      ktl::lz4::compress_block(zeros.data(), zeros.size(), compressed.data(),
+                               compressed.size())};  // Table on the stack
+  ASSERT_VALUE(compressed_size > 0 && compressed_size < 512)
+
+  const auto random{make_data(65536, content::random)};
+  ASSERT_VALUE(ktl::lz4::compress_block(random.data(), random.size(),
+                                        compressed.data(), random.size() / 2,
+                                        *table) == 0)
+}
+
+void reject_malformed_blocks() {
+  using namespace details;
+
+  const auto data{make_data(4096, content::text)};
+  byte_vector compressed(ktl::lz4::compress_bound(data.size()));
+  const size_t compressed_size{
+      ktl::lz4::compress_block(data.data(), data.size(), compressed.data(),
+                               compressed.size())};
+  byte_vector output(data.size());
+
+  ASSERT_EQ(ktl::lz4::decompress_block(compressed.data(), compressed_size,
+                                       output.data(), output.size() - 1),
+            ktl::lz4::INVALID_SIZE)
+  ASSERT_EQ(ktl::lz4::decompress_block(compressed.data(), compressed_size / 2,
+                                       output.data(), output.size()),
+            ktl::lz4::INVALID_SIZE)
+
+  static constexpr byte BAD_OFFSET[]{0x10, 'a', 0x02, 0x00, 0x50, 'b'};
+  ASSERT_EQ(ktl::lz4::decompress_block(BAD_OFFSET, sizeof(BAD_OFFSET),
+                                       output.data(), output.size()),
+            ktl::lz4::INVALID_SIZE)
+
+  // Damaged blocks must never touch the memory outside of the buffers
+  uint32_t state{1};
+  for (int round = 0; round < 1000; ++round) {
+    auto damaged{compressed};
+    for (int idx = 0; idx < 4; ++idx) {
+      state = state * 1664525 + 1013904223;
+      damaged[(state >> 8) % compressed_size] = static_cast<byte>(state);
+    }
+    const size_t size{ktl::lz4::decompress_block(
+        damaged.data(), compressed_size, output.data(), output.size())};
+    ASSERT_VALUE(size == ktl::lz4::INVALID_SIZE || size <= output.size())
+  }
+}
+
+void round_trip_frames() {
+  using namespace details;
+
+  const auto data{make_data(200000, content::text)};
+  byte_vector frame;
+  byte_vector output;
+
+  ktl::lz4::frame_options options;
+  size_t frame_size{compress_frame(data, options, frame)};
+  ASSERT_VALUE(frame_size < data.size() / 2)
+  ASSERT_VALUE(decompress_frame(frame, frame_size, frame_size, output))
+  ASSERT_VALUE(output.size() == data.size() &&
+               equals(output.data(), data.data(), data.size()))
+
+  options.block_size = ktl::lz4::block_size_id::max_256kb;
+  options.block_checksum = true;
+  options.content_size = data.size();
+  frame_size = compress_frame(data, options, frame);
+  ASSERT_VALUE(decompress_frame(frame, frame_size, 1000, output))
+  ASSERT_VALUE(output.size() == data.size() &&
+               equals(output.data(), data.data(), data.size()))
+
+  frame[frame_size / 2] ^= 0x01;
+  ASSERT_VALUE(!decompress_frame(frame, frame_size, frame_size, output))
+}
+
+void decompress_reference_blocks() {
+  using namespace details;
+
+  ASSERT_VALUE(decompresses_to(OVERLAP_BLOCK, make_periodic(42, 'a', 3)))
+  ASSERT_VALUE(
+      decompresses_to(LONG_LITERALS_BLOCK, make_periodic(80, 0x20, 40)))
+  ASSERT_VALUE(decompresses_to(LONG_MATCH_BLOCK, make_periodic(1000, 'x', 1)))
+  ASSERT_VALUE(decompresses_to(EMPTY_BLOCK, byte_vector{}))
+}
+
+void read_reference_frames() {
+  using namespace details;
+
+  const auto text{make_reference_text()};
+  const auto noise{make_reference_noise()};
+  auto text_and_noise{text};
+  text_and_noise.insert(text_and_noise.end(), noise.begin(), noise.end());
+
+  ASSERT_VALUE(reads_to(CHECKED_FRAME, text_and_noise))
+  ASSERT_VALUE(reads_to(STORED_FRAME, noise))
+  ASSERT_VALUE(reads_to(TEXT_FRAME, text))
+}
+
+void reject_linked_frames() {
+  using namespace details;
+
+  ktl::lz4::frame_reader reader;
+  byte output[64];
+  const auto result{reader.read(LINKED_FRAME, sizeof(LINKED_FRAME), output,
+                                sizeof(output))};
+  ASSERT_VALUE(result.status == ktl::lz4::frame_status::unsupported)
+  ASSERT_EQ(result.consumed, size_t{0})
+  ASSERT_VALUE(!reader.finished())
+
+  // The header checksum is verified first
+  auto damaged{to_vector(LINKED_FRAME)};
+  damaged[6] ^= 0x01;
+  reader.reset();
+  ASSERT_VALUE(reader.read(damaged.data(), damaged.size(), output,
+                           sizeof(output))
+                   .status == ktl::lz4::frame_status::corrupted)
+}
+
+void write_reference_frames() {
+  using namespace details;
+
+  const auto text{make_reference_text()};
+  ktl::lz4::frame_options options;
+  ASSERT_VALUE(writes_like(text, options, TEXT_FRAME, 7))
+
+  auto text_and_noise{text};
+  const auto noise{make_reference_noise()};
+  text_and_noise.insert(text_and_noise.end(), noise.begin(), noise.end());
+  options.block_checksum = true;
+  options.content_size = text_and_noise.size();
+  ASSERT_VALUE(writes_like(text_and_noise, options, CHECKED_FRAME, 15))
+}
+
+void measure_throughput() {
+  using namespace details;
+
+  const auto data{make_data(1024 * 1024, content::text)};
+  auto table{make_unique<ktl::lz4::hash_table<> >()};
+  byte_vector compressed(ktl::lz4::compress_bound(data.size()));
+  byte_vector output(data.size());
+  static constexpr int ROUNDS{16};
+
+  size_t compressed_size{0};
+  auto started{chrono::steady_clock::now()};
+  for (int round = 0; round < ROUNDS; ++round) {
+    compressed_size =
+        ktl::lz4::compress_block(data.data(), data.size(), compressed.data(),
+                                 compressed.size(), *table);
+  }
+  const auto compression_time{chrono::steady_clock::now() - started};
+
+  started = chrono::steady_clock::now();
+  for (int round = 0; round < ROUNDS; ++round) {
+    ASSERT_EQ(ktl::lz4::decompress_block(compressed.data(), compressed_size,
+                                         output.data(), output.size()),
+              data.size())
+  }
+  const auto decompression_time{chrono::steady_clock::now() - started};
+
+  tests::details::print(
+      "lz4 ratio {}%, compression: {} MB/s, decompression: {} MB/s\n",
+      compressed_size * 100 / data.size(),
+      get_mb_per_second(data.size() * ROUNDS, compression_time),
+      get_mb_per_second(data.size() * ROUNDS, decompression_time));
+}
+}  // namespace tests::lz4
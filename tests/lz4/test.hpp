@@ -0,0 +1,12 @@
+#pragma once
+
+namespace tests::lz4 {
+void round_trip_blocks();
+void reject_malformed_blocks();
+void round_trip_frames();
+void decompress_reference_blocks();
+void read_reference_frames();
+void reject_linked_frames();
+void write_reference_frames();
+void measure_throughput();
+}  // namespace tests::lz4
@@ -0,0 +1,147 @@
+#include "test.hpp"
+
+#include <test_runner.hpp>
+
+#include <chrono.hpp>
+#include <crc32c.hpp>
+#include <mapped_file.hpp>
+#include <string_view.hpp>
+#include <vector.hpp>
+
+#include <ntddk.h>
+
+using namespace ktl;
+
+namespace tests::mapped_file {
+namespace details {
+using byte_vector = vector<byte, basic_non_paged_allocator<byte> >;
+
+static constexpr auto FILE_PATH{L"\\SystemRoot\\Temp\\ktl_mapped_file.tmp"_usv};
+
+static byte_vector make_data(size_t size) {
+  byte_vector data(size);
+  uint32_t state{0x9e3779b9};
+  for (auto& value : data) {
+    state = state * 1664525 + 1013904223;  // LCG
+    value = static_cast<byte>(state >> 24);
+  }
+  return data;
+}
+
+// Writes the data into FILE_PATH and deletes the file on destruction
+class temp_file : non_copyable {
+ public:
+  explicit temp_file(const byte_vector& data) {
+    HANDLE file;
+    IO_STATUS_BLOCK io_status;
+    NTSTATUS status{ZwCreateFile(
+        addressof(file), FILE_WRITE_DATA | SYNCHRONIZE, get_attributes(),
+        addressof(io_status), nullptr, FILE_ATTRIBUTE_TEMPORARY, 0,
+        FILE_OVERWRITE_IF,
+        FILE_NON_DIRECTORY_FILE | FILE_SYNCHRONOUS_IO_NONALERT, nullptr, 0)};
+    throw_exception_if_not<kernel_error>(NT_SUCCESS(status), status,
+                                         "unable to create the file");
+    status = ZwWriteFile(file, nullptr, nullptr, nullptr, addressof(io_status),
+                         const_cast<byte*>(data.data()),
+                         static_cast<ULONG>(data.size()), nullptr, nullptr);
+    ZwClose(file);
+    throw_exception_if_not<kernel_error>(NT_SUCCESS(status), status,
+                                         "unable to write the file");
+  }
+
+  ~temp_file() noexcept { ZwDeleteFile(get_attributes()); }
+
+ private:
+  OBJECT_ATTRIBUTES* get_attributes() noexcept {
+    InitializeObjectAttributes(addressof(m_attributes),
+                               const_cast<UNICODE_STRING*>(FILE_PATH.raw_str()),
+                               OBJ_KERNEL_HANDLE | OBJ_CASE_INSENSITIVE,
+                               nullptr, nullptr);
+    return addressof(m_attributes);
+  }
+
+ private:
+  OBJECT_ATTRIBUTES m_attributes;
+};
+
+static bool equals(span<const byte> bytes, const byte* expected) noexcept {
+  return memcmp(bytes.data(), expected, bytes.size()) == 0;
+}
+}  // namespace details
+
+void map_ranges() {
+  using namespace details;
+
+  const auto data{make_data(300000)};
+  temp_file file_guard{data};
+  ktl::mapped_file file{FILE_PATH};
+  ASSERT_EQ(file.size(), uint64_t{data.size()})
+
+  // Offsets of the views don't have to be aligned
+  const auto view{file.map(70003, 1000)};
+  ASSERT_VALUE(static_cast<bool>(view))
+  ASSERT_EQ(view.offset(), uint64_t{70003})
+  ASSERT_EQ(view.size(), size_t{1000})
+  ASSERT_VALUE(equals(view.bytes(), data.data() + 70003))
+
+  const auto tail{file.map(data.size() - 10, 100)};
+  ASSERT_EQ(tail.size(), size_t{10})
+  ASSERT_VALUE(equals(tail.bytes(), data.data() + data.size() - 10))
+
+  bool thrown{false};
+  try {
+    [[maybe_unused]] const auto past_end{file.map(data.size(), 1)};
+  } catch ([[maybe_unused]] const out_of_range& exc) {
+    thrown = true;
+  }
+  ASSERT_VALUE(thrown)
+}
+
+void stream_file() {
+  using namespace details;
+
+  const auto data{make_data(1024 * 1024 + 123)};
+  temp_file file_guard{data};
+  ktl::mapped_file file{FILE_PATH};
+
+  mapped_stream_reader reader{file, 100000};
+  uint32_t crc{0};
+  size_t windows{0};
+  for (auto window = reader.next(); !window.empty(); window = reader.next()) {
+    ASSERT_VALUE(window.size() <= 100000)
+    crc = crc32c_update(crc, window);
+    ++windows;
+  }
+  ASSERT_VALUE(reader.eof())
+  ASSERT_EQ(reader.position(), uint64_t{data.size()})
+  ASSERT_EQ(windows, (data.size() + 99999) / 100000)
+  ASSERT_EQ(crc, crc32c(data.data(), data.size()))
+
+  reader.seek(12345);
+  const auto window{reader.next()};
+  ASSERT_EQ(window.size(), size_t{100000})
+  ASSERT_VALUE(equals(window, data.data() + 12345))
+}
+
+void measure_throughput() {
+  using namespace details;
+
+  const auto data{make_data(16 * 1024 * 1024)};
+  temp_file file_guard{data};
+  ktl::mapped_file file{FILE_PATH};
+
+  mapped_stream_reader reader{file};
+  uint32_t crc{0};
+  const auto started{chrono::steady_clock::now()};
+  for (auto window = reader.next(); !window.empty(); window = reader.next()) {
+    crc = crc32c_update(crc, window);
+  }
+  const auto elapsed{chrono::duration_cast<chrono::nanoseconds>(
+      chrono::steady_clock::now() - started)};
+  ASSERT_EQ(crc, crc32c(data.data(), data.size()))
+
+  const auto ns{static_cast<uint64_t>(elapsed.count()) + 1};
+  tests::details::print("mapped_stream_reader with crc32c: {} MB/s\n",
+                        uint64_t{data.size()} * 1000 / ns);
+}
+}  // namespace tests::mapped_file
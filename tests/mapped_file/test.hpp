@@ -0,0 +1,7 @@
+#pragma once
+
+namespace tests::mapped_file {
+void map_ranges();
+void stream_file();
+void measure_throughput();
+}  // namespace tests::mapped_file
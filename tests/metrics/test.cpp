@@ -0,0 +1,169 @@
+#include "test.hpp"
+
+#include <test_runner.hpp>
+
+#include <metrics.hpp>
+#include <string_view.hpp>
+#include <vector.hpp>
+
+#include <ntddk.h>
+
+using namespace ktl;
+
+namespace tests::metrics {
+namespace details {
+using byte_vector = vector<byte, basic_non_paged_allocator<byte> >;
+using ktl::metrics::metric_type;
+using ktl::metrics::snapshot_entry;
+using ktl::metrics::snapshot_header;
+
+enum metric_id : uint32_t {
+  REQUESTS = 10,
+  OPEN_HANDLES = 20,
+  LATENCY = 30,
+};
+
+static ULONG_PTR count_on_processor(ULONG_PTR context) {
+  reinterpret_cast<per_cpu_counter*>(context)->add();
+  return 0;
+}
+
+template <class Ty>
+static Ty read_at(const byte_vector& data, size_t offset) noexcept {
+  Ty value;
+  memcpy(addressof(value), data.data() + offset, sizeof(Ty));
+  return value;
+}
+}  // namespace details
+
+void update_metrics() {
+  using namespace details;
+
+  metrics_registry registry;
+  auto& requests{registry.add_counter(REQUESTS, "requests"_asv)};
+  auto& handles{registry.add_gauge(OPEN_HANDLES, "open_handles"_asv)};
+  auto& latency{registry.add_histogram(LATENCY, "latency_us"_asv)};
+  ASSERT_EQ(registry.size(), size_t{3})
+
+  // Runs on each processor at IPI_LEVEL
+  KeIpiGenericCall(&count_on_processor,
+                   reinterpret_cast<ULONG_PTR>(addressof(requests)));
+  requests.add(5);
+  ASSERT_EQ(requests.value(),
+            uint64_t{KeQueryActiveProcessorCountEx(ALL_PROCESSOR_GROUPS)} + 5)
+
+  handles.add(3);
+  handles.sub(5);
+  ASSERT_EQ(handles.value(), int64_t{-2})
+  handles.set(7);
+  ASSERT_EQ(handles.value(), int64_t{7})
+
+  for (uint64_t value = 0; value < 100; ++value) {
+    latency.record(value);
+  }
+  ASSERT_EQ(latency.count(), uint64_t{100})
+  ASSERT_EQ(latency.sum(), uint64_t{4950})
+
+  ASSERT_EQ(histogram::get_bucket(0), uint32_t{0})
+  ASSERT_EQ(histogram::get_bucket(1), uint32_t{1})
+  ASSERT_EQ(histogram::get_bucket(7), uint32_t{3})
+  ASSERT_EQ(histogram::get_bucket(8), uint32_t{4})
+  ASSERT_EQ(histogram::get_bucket(uint64_t{1} << 40), uint32_t{41})
+  ASSERT_EQ(histogram::get_bucket(~uint64_t{0}), histogram::BUCKET_COUNT - 1)
+}
+
+void reject_duplicate_ids() {
+  using namespace details;
+
+  metrics_registry registry;
+  registry.add_counter(REQUESTS, "requests"_asv);
+  bool thrown{false};
+  try {
+    registry.add_gauge(REQUESTS, "open_handles"_asv);
+  } catch ([[maybe_unused]] const invalid_argument& exc) {
+    thrown = true;
+  }
+  ASSERT_VALUE(thrown)
+  ASSERT_EQ(registry.size(), size_t{1})
+}
+
+void parse_snapshot() {
+  using namespace details;
+
+  metrics_registry registry;
+  registry.add_counter(REQUESTS, "requests"_asv).add(42);
+  registry.add_gauge(OPEN_HANDLES, "open_handles"_asv).set(-3);
+  auto& latency{registry.add_histogram(LATENCY, "latency_us"_asv)};
+  latency.record(0);
+  latency.record(5);
+  latency.record(6);
+
+  byte_vector data(registry.max_snapshot_size());
+  const size_t size{registry.snapshot(span{data})};
+  ASSERT_VALUE(size <= data.size())
+
+  const auto header{read_at<snapshot_header>(data, 0)};
+  ASSERT_EQ(header.magic, ktl::metrics::SNAPSHOT_MAGIC)
+  ASSERT_EQ(header.version, ktl::metrics::SNAPSHOT_VERSION)
+  ASSERT_EQ(size_t{header.size}, size)
+  ASSERT_EQ(header.entry_count, uint32_t{3})
+
+  struct expected_entry {
+    uint32_t id;
+    metric_type type;
+    ansi_string_view name;
+    uint32_t value_count;
+    uint64_t values[6];
+  };
+
+  // Histogram: count, sum and the buckets of 0, [1, 2), [2, 4) and [4, 8)
+  const expected_entry expected[]{
+      {REQUESTS, metric_type::counter, "requests"_asv, 1, {42}},
+      {OPEN_HANDLES,
+       metric_type::gauge,
+       "open_handles"_asv,
+       1,
+       {static_cast<uint64_t>(-3)}},
+      {LATENCY,
+       metric_type::histogram,
+       "latency_us"_asv,
+       6,
+       {3, 11, 1, 0, 0, 2}},
+  };
+
+  size_t offset{sizeof(snapshot_header)};
+  for (const auto& entry : expected) {
+    const auto actual{read_at<snapshot_entry>(data, offset)};
+    ASSERT_EQ(actual.id, entry.id)
+    ASSERT_VALUE(actual.type == entry.type)
+    ASSERT_EQ(size_t{actual.name_size}, size_t{entry.name.size()})
+    ASSERT_EQ(actual.value_count, entry.value_count)
+    offset += sizeof(snapshot_entry);
+    ASSERT_VALUE(memcmp(data.data() + offset, entry.name.data(),
+                        actual.name_size) == 0)
+    offset += (actual.name_size + 7) & ~size_t{7};
+    for (uint32_t idx = 0; idx < actual.value_count; ++idx) {
+      ASSERT_EQ(read_at<uint64_t>(data, offset), entry.values[idx])
+      offset += sizeof(uint64_t);
+    }
+  }
+  ASSERT_EQ(offset, size)
+}
+
+void snapshot_into_small_buffer() {
+  using namespace details;
+
+  metrics_registry registry;
+  registry.add_counter(REQUESTS, "requests"_asv);
+  registry.add_histogram(LATENCY, "latency_us"_asv).record(1000);
+
+  byte_vector data(sizeof(snapshot_header));
+  const size_t size{registry.snapshot(span{data})};
+  ASSERT_VALUE(size > data.size())
+  ASSERT_VALUE(size <= registry.max_snapshot_size())
+
+  data.resize(size);
+  ASSERT_EQ(registry.snapshot(span{data}), size)
+  ASSERT_EQ(read_at<snapshot_header>(data, 0).size, static_cast<uint32_t>(size))
+}
+}  // namespace tests::metrics
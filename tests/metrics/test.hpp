@@ -0,0 +1,8 @@
+#pragma once
+
+namespace tests::metrics {
+void update_metrics();
+void reject_duplicate_ids();
+void parse_snapshot();
+void snapshot_into_small_buffer();
+}  // namespace tests::metrics
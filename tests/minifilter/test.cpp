@@ -0,0 +1,474 @@
+#include "test.hpp"
+
+#include <test_runner.hpp>
+
+#include <algorithm.hpp>
+
+#include <modules/minifilter/file_context_cache.hpp>
+#include <modules/minifilter/name_cache.hpp>
+#include <modules/minifilter/offload_pipeline.hpp>
+
+using namespace ktl;
+
+namespace tests::minifilter {
+namespace details {
+struct fake_file_object {
+  const void* fs_context;
+};
+
+struct fake_stream_backend {
+  using key_type = mf::stream_key;
+
+  static bool get_key(key_type& key, const fake_file_object& file) noexcept {
+    if (!file.fs_context) {
+      return false;
+    }
+    key = key_type{file.fs_context};
+    return true;
+  }
+};
+
+struct counted_context : mf::file_context {
+  explicit counted_context(int value_) noexcept : value{value_} {
+    ++alive_count;
+  }
+  ~counted_context() override { --alive_count; }
+
+  int value;
+  static inline int alive_count{0};
+};
+
+using fake_cache =
+    mf::file_context_cache<counted_context, fake_stream_backend, 4>;
+
+static intrusive_ptr<counted_context> make_context(int value) {
+  return intrusive_ptr<counted_context>{new counted_context{value}};
+}
+
+struct fake_name_backend {
+  using handle_key_type = mf::stream_key;
+
+  static bool get_handle_key(
+      handle_key_type& key,
+      const fake_file_object& file,
+      [[maybe_unused]] mf::name_change change = {}) noexcept {
+    return fake_stream_backend::get_key(key, file);
+  }
+
+  static bool get_opened_name(
+      [[maybe_unused]] mf::opened_name& name,
+      [[maybe_unused]] const fake_file_object& file) noexcept {
+    return false;
+  }
+
+  static intrusive_ptr<mf::file_name_info> query_name(
+      const fake_file_object& file) {
+    ++query_count;
+    if (!file.fs_context) {
+      return {};
+    }
+    // \Device\HarddiskVolume1\dir\file.txt
+    constexpr mf::name_components components{
+        {0, 23}, {0, 0}, {23, 5}, {28, 8}, {33, 3}, {0, 0}};
+    return intrusive_ptr<mf::file_name_info>{new mf::file_name_info{
+        L"\\Device\\HarddiskVolume1\\dir\\file.txt", components}};
+  }
+
+  static mf::name_change classify_change(
+      [[maybe_unused]] const fake_file_object& file,
+      mf::name_change change) noexcept {
+    return change;
+  }
+
+  static inline int query_count{0};
+};
+
+// There is no filter manager in the user mode, so the names are made from the
+// opened paths. The keys are extracted from the callback parameters as usual
+struct opened_path_backend : mf::flt_name_backend {
+  static intrusive_ptr<mf::file_name_info> query_name(
+      FLT_CALLBACK_DATA& data,
+      const FLT_RELATED_OBJECTS& objects) {
+    ++query_count;
+    mf::opened_name opened;
+    if (!get_opened_name(opened, data, objects)) {
+      return {};
+    }
+    unicode_string name{L"\\Device\\HarddiskVolume1"};
+    name.append(opened.path);
+    constexpr mf::name_components components{
+        {0, 23}, {0, 0}, {0, 0}, {0, 0}, {0, 0}, {0, 0}};
+    return intrusive_ptr<mf::file_name_info>{
+        new mf::file_name_info{name, components}};
+  }
+
+  static inline int query_count{0};
+};
+
+struct batch_log {
+  int processed{0};
+  int sum{0};
+  size_t max_batch{0};
+};
+
+struct logging_handler {
+  void operator()(int* items, size_t count) noexcept {
+    log->processed += static_cast<int>(count);
+    log->max_batch = (max)(log->max_batch, count);
+    for (size_t idx = 0; idx < count; ++idx) {
+      log->sum += items[idx];
+    }
+  }
+
+  batch_log* log;
+};
+
+// Keeps the scheduled routines until the test runs them
+struct manual_scheduler {
+  struct task {
+    void (*routine)(void*);
+    void* context;
+  };
+
+  bool schedule(void (*routine)(void*), void* context) noexcept {
+    if (tasks->size == 4 || tasks->failing) {
+      return false;
+    }
+    tasks->items[tasks->size++] = {routine, context};
+    return true;
+  }
+
+  struct task_list {
+    void run_all() {
+      for (size_t idx = 0; idx < size; ++idx) {
+        items[idx].routine(items[idx].context);
+      }
+      size = 0;
+    }
+
+    task items[4]{};
+    size_t size{0};
+    bool failing{false};
+  }* tasks;
+};
+
+template <size_t Capacity, size_t BatchSize>
+using fake_pipeline =
+    mf::offload_pipeline<int, logging_handler, manual_scheduler, Capacity,
+                         BatchSize>;
+}  // namespace details
+
+void cache_file_contexts() {
+  using namespace details;
+
+  int streams[8]{};
+  {
+    fake_cache cache;
+    for (int idx = 0; idx < 8; ++idx) {
+      const fake_file_object file{streams + idx};
+      auto ctx{cache.lookup_or_create([idx] { return make_context(idx); },
+                                      file)};
+      ASSERT_VALUE(static_cast<bool>(ctx))
+      ASSERT_EQ(ctx->value, idx)
+    }
+    ASSERT_EQ(cache.size(), size_t{8})
+    ASSERT_EQ(counted_context::alive_count, 8)
+
+    // Second lookup must return the cached state without creating a new one
+    const fake_file_object second_file{streams + 3};
+    auto cached{cache.lookup_or_create([] { return make_context(-1); },
+                                       second_file)};
+    ASSERT_EQ(cached->value, 3)
+    ASSERT_EQ(counted_context::alive_count, 8)
+    ASSERT_VALUE(cache.lookup(second_file) == cached)
+
+    const fake_file_object unknown_file{nullptr};
+    ASSERT_VALUE(!cache.lookup(unknown_file))
+    ASSERT_VALUE(!cache.lookup_or_create([] { return make_context(-1); },
+                                         unknown_file))
+  }
+  ASSERT_EQ(details::counted_context::alive_count, 0)
+}
+
+void evict_file_contexts() {
+  using namespace details;
+
+  int stream{0};
+  const fake_file_object file{addressof(stream)};
+
+  fake_cache cleanup_cache{mf::eviction_point::cleanup};
+  auto ctx{
+      cleanup_cache.lookup_or_create([] { return make_context(1); }, file)};
+  cleanup_cache.on_cleanup(file);
+  ASSERT_VALUE(!cleanup_cache.lookup(file))
+  ASSERT_EQ(counted_context::alive_count, 1)  // Still referenced by ctx
+  ctx.reset();
+  ASSERT_EQ(counted_context::alive_count, 0)
+
+  fake_cache close_cache{mf::eviction_point::close};
+  close_cache.lookup_or_create([] { return make_context(2); }, file);
+  close_cache.on_cleanup(file);
+  ASSERT_VALUE(static_cast<bool>(close_cache.lookup(file)))
+  close_cache.on_close(file);
+  ASSERT_VALUE(!close_cache.lookup(file))
+  ASSERT_EQ(counted_context::alive_count, 0)
+
+  // Two handles to the same stream: closing one keeps the shared state
+  fake_cache shared_cache{mf::eviction_point::cleanup};
+  shared_cache.on_open(file);
+  shared_cache.on_open(file);
+  shared_cache.lookup_or_create([] { return make_context(3); }, file);
+  shared_cache.on_cleanup(file);
+  shared_cache.on_close(file);
+  ASSERT_VALUE(static_cast<bool>(shared_cache.lookup(file)))
+  shared_cache.on_cleanup(file);
+  ASSERT_VALUE(!shared_cache.lookup(file))
+  ASSERT_EQ(counted_context::alive_count, 0)
+
+  // The stream is reopened after the eviction
+  shared_cache.on_open(file);
+  shared_cache.lookup_or_create([] { return make_context(4); }, file);
+  shared_cache.on_cleanup(file);
+  ASSERT_VALUE(!shared_cache.lookup(file))
+  ASSERT_EQ(counted_context::alive_count, 0)
+}
+
+void cache_file_names() {
+  using namespace details;
+
+  int stream{0};
+  const fake_file_object file{addressof(stream)};
+
+  mf::name_cache<fake_name_backend, 4> cache;
+  const int initial_count{fake_name_backend::query_count};
+  auto name{cache.get(file)};
+  ASSERT_VALUE(static_cast<bool>(name))
+  ASSERT_VALUE(name->name() == L"\\Device\\HarddiskVolume1\\dir\\file.txt")
+  ASSERT_VALUE(name->volume() == L"\\Device\\HarddiskVolume1")
+  ASSERT_VALUE(name->parent_dir() == L"\\dir\\")
+  ASSERT_VALUE(name->final_component() == L"file.txt")
+  ASSERT_VALUE(name->extension() == L"txt")
+  ASSERT_VALUE(name->stream().empty())
+
+  for (int idx = 0; idx < 10; ++idx) {
+    ASSERT_VALUE(cache.get(file) == name)
+  }
+  ASSERT_EQ(fake_name_backend::query_count, initial_count + 1)
+
+  const auto stats{cache.stats()};
+  ASSERT_EQ(stats.hits, uint64_t{10})
+  ASSERT_EQ(stats.misses, uint64_t{1})
+  ASSERT_EQ(cache.handle_count(), size_t{1})
+}
+
+void invalidate_file_names() {
+  using namespace details;
+
+  int stream{0};
+  const fake_file_object file{addressof(stream)};
+
+  mf::name_cache<fake_name_backend, 4> cache;
+  const int initial_count{fake_name_backend::query_count};
+  [[maybe_unused]] auto name{cache.get(file)};
+
+  cache.on_set_information(file, mf::name_change::none);
+  cache.get(file);
+  ASSERT_EQ(fake_name_backend::query_count, initial_count + 1)
+
+  cache.on_set_information(file, mf::name_change::file);
+  ASSERT_EQ(cache.handle_count(), size_t{0})
+  cache.get(file);
+  ASSERT_EQ(fake_name_backend::query_count, initial_count + 2)
+
+  cache.on_set_information(file, mf::name_change::tree);
+  ASSERT_EQ(cache.handle_count(), size_t{0})
+  cache.get(file);
+  cache.on_close(file);
+  ASSERT_EQ(cache.handle_count(), size_t{0})
+
+  // Nothing is cached for the handle, so the rename drops all of the names
+  cache.on_set_information(file, mf::name_change::file);
+  ASSERT_EQ(cache.stats().invalidations, uint64_t{3})
+}
+
+void cache_opened_names() {
+  using namespace details;
+  using backend_type = opened_path_backend;
+
+  int volume{0};
+  int stream{0};  // Shared by the hard links
+  FLT_IO_PARAMETER_BLOCK iopb{};
+  FLT_CALLBACK_DATA data{};
+  data.Iopb = addressof(iopb);
+  FLT_RELATED_OBJECTS objects{};
+  objects.Volume = reinterpret_cast<PFLT_VOLUME>(addressof(volume));
+
+  mf::name_cache<backend_type, 4> cache;
+  const int initial_count{backend_type::query_count};
+
+  // The file object isn't opened in the pre-create callback yet
+  const auto create = [&](FILE_OBJECT& file, const wchar_t* path) {
+    RtlInitUnicodeString(addressof(file.FileName), path);
+    iopb.MajorFunction = IRP_MJ_CREATE;
+    objects.FileObject = addressof(file);
+    auto name{cache.get(data, objects)};
+    file.FsContext = addressof(stream);
+    ASSERT_VALUE(cache.get(data, objects) == name)
+    return name;
+  };
+
+  FILE_OBJECT first{};
+  const auto name{create(first, L"\\dir\\file.txt")};
+  ASSERT_VALUE(static_cast<bool>(name))
+  ASSERT_VALUE(name->name() == L"\\Device\\HarddiskVolume1\\dir\\file.txt")
+  ASSERT_EQ(backend_type::query_count, initial_count + 1)
+
+  // FileName isn't valid after the create, the name is found by the handle
+  iopb.MajorFunction = IRP_MJ_READ;
+  RtlInitUnicodeString(addressof(first.FileName), nullptr);
+  ASSERT_VALUE(cache.get(data, objects) == name)
+
+  // The repeated open hits in the pre-create callback
+  FILE_OBJECT second{};
+  ASSERT_VALUE(create(second, L"\\dir\\file.txt") == name)
+  ASSERT_EQ(backend_type::query_count, initial_count + 1)
+
+  // The hard link shares the stream, but has the name of its own
+  FILE_OBJECT link{};
+  const auto link_name{create(link, L"\\dir\\link.txt")};
+  ASSERT_VALUE(link_name->name() ==
+               L"\\Device\\HarddiskVolume1\\dir\\link.txt")
+  FILE_OBJECT similar{};
+  create(similar, L"\\dir\\file.txt.bak");
+  ASSERT_EQ(backend_type::query_count, initial_count + 3)
+  ASSERT_EQ(cache.size(), size_t{3})
+  ASSERT_EQ(cache.handle_count(), size_t{4})
+
+  // The relative opens and the opens by FileId aren't cached by the path
+  FILE_OBJECT relative{};
+  relative.RelatedFileObject = addressof(first);
+  create(relative, L"file.txt");
+  FILE_OBJECT by_id{};
+  iopb.Parameters.Create.Options = FILE_OPEN_BY_FILE_ID;
+  create(by_id, L"\\dir\\file.txt");
+  iopb.Parameters.Create.Options = 0;
+  ASSERT_EQ(cache.size(), size_t{3})
+
+  // A new link renames nothing, the rename drops only the renamed link
+  iopb.MajorFunction = IRP_MJ_SET_INFORMATION;
+  objects.FileObject = addressof(first);
+  auto& params{iopb.Parameters.SetFileInformation};
+  params.FileInformationClass = FileLinkInformation;
+  cache.on_set_information(data, objects);
+  ASSERT_EQ(cache.size(), size_t{3})
+  params.FileInformationClass = FileRenameInformation;
+  cache.on_set_information(data, objects);
+  ASSERT_EQ(cache.size(), size_t{2})
+  objects.FileObject = addressof(link);
+  iopb.MajorFunction = IRP_MJ_READ;
+  ASSERT_VALUE(cache.get(data, objects) == link_name)
+  objects.FileObject = addressof(second);
+  ASSERT_VALUE(!cache.get(data, objects))  // Dropped with the renamed path
+
+  FILE_OBJECT third{};
+  create(third, L"\\dir\\file.txt");
+  ASSERT_EQ(backend_type::query_count, initial_count + 9)
+
+  iopb.MajorFunction = IRP_MJ_CLOSE;
+  FILE_OBJECT* files[]{&first,    &second, &link, &similar,
+                       &relative, &by_id,  &third};
+  for (auto* file : files) {
+    objects.FileObject = file;
+    cache.on_close(data, objects);
+  }
+  ASSERT_EQ(cache.handle_count(), size_t{0})
+  ASSERT_EQ(cache.size(), size_t{3})
+}
+
+void offload_in_batches() {
+  using namespace details;
+
+  batch_log log;
+  manual_scheduler::task_list tasks;
+  fake_pipeline<64, 8> pipeline{logging_handler{addressof(log)},
+                                manual_scheduler{addressof(tasks)}};
+  for (int idx = 1; idx <= 20; ++idx) {
+    ASSERT_VALUE(pipeline.submit(idx))
+  }
+  ASSERT_EQ(tasks.size, size_t{1})  // A single worker is woken up
+  ASSERT_EQ(pipeline.size_approx(), size_t{20})
+  ASSERT_EQ(log.processed, 0)
+
+  tasks.run_all();
+  pipeline.wait_for_workers();
+  ASSERT_EQ(log.processed, 20)
+  ASSERT_EQ(log.sum, 20 * 21 / 2)
+  ASSERT_EQ(log.max_batch, size_t{8})
+  ASSERT_EQ(pipeline.active_workers(), uint32_t{0})
+
+  const auto stats{pipeline.stats()};
+  ASSERT_EQ(stats.queued, uint64_t{20})
+  ASSERT_EQ(stats.synchronous, uint64_t{0})
+  ASSERT_EQ(stats.batches, uint64_t{3})  // 8 + 8 + 4
+}
+
+void offload_when_full() {
+  using namespace details;
+
+  batch_log log;
+  manual_scheduler::task_list tasks;
+  fake_pipeline<4, 4> pipeline{logging_handler{addressof(log)},
+                               manual_scheduler{addressof(tasks)}};
+  for (int idx = 1; idx <= 6; ++idx) {
+    pipeline.submit(idx);
+  }
+  ASSERT_EQ(log.processed, 2)  // Handled by the submitter
+  ASSERT_EQ(log.sum, 5 + 6)
+  ASSERT_VALUE(!pipeline.try_submit(7))
+
+  tasks.run_all();
+  pipeline.wait_for_workers();
+  ASSERT_EQ(log.processed, 6)
+  ASSERT_EQ(pipeline.stats().synchronous, uint64_t{2})
+
+  // The next submission starts a new worker
+  ASSERT_VALUE(pipeline.submit(8))
+  ASSERT_EQ(tasks.size, size_t{1})
+  tasks.run_all();
+  ASSERT_EQ(log.processed, 7)
+}
+
+void offload_without_workers() {
+  using namespace details;
+
+  batch_log log;
+  manual_scheduler::task_list tasks;
+  tasks.failing = true;
+  fake_pipeline<4, 4> pipeline{logging_handler{addressof(log)},
+                               manual_scheduler{addressof(tasks)}, 2};
+  // Nobody would drain the queue, so the item isn't queued
+  int item{1};
+  ASSERT_VALUE(!pipeline.try_submit(move(item)))
+  ASSERT_EQ(pipeline.size_approx(), size_t{0})
+  ASSERT_EQ(pipeline.active_workers(), uint32_t{0})
+  ASSERT_EQ(log.processed, 0)  // The submitter hasn't run a worker
+
+  ASSERT_VALUE(!pipeline.submit(2))
+  ASSERT_EQ(log.processed, 1)
+  ASSERT_EQ(pipeline.stats().synchronous, uint64_t{1})
+  ASSERT_EQ(pipeline.stats().batches, uint64_t{0})
+
+  // A running worker takes the items the second one can't be started for
+  tasks.failing = false;
+  ASSERT_VALUE(pipeline.submit(3))
+  tasks.failing = true;
+  ASSERT_VALUE(pipeline.submit(4))
+  ASSERT_EQ(tasks.size, size_t{1})
+  ASSERT_EQ(pipeline.active_workers(), uint32_t{1})
+  tasks.run_all();
+  pipeline.wait_for_workers();
+  ASSERT_EQ(log.processed, 3)
+  ASSERT_EQ(log.sum, 2 + 3 + 4)
+  ASSERT_EQ(pipeline.stats().queued, uint64_t{2})
+}
+}  // namespace tests::minifilter
@@ -0,0 +1,12 @@
+#pragma once
+
+namespace tests::minifilter {
+void cache_file_contexts();
+void evict_file_contexts();
+void cache_file_names();
+void invalidate_file_names();
+void cache_opened_names();
+void offload_in_batches();
+void offload_when_full();
+void offload_without_workers();
+}  // namespace tests::minifilter
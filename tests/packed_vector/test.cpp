@@ -0,0 +1,246 @@
+#include "test.hpp"
+
+#include <test_runner.hpp>
+
+#include <algorithm.hpp>
+#include <cpu_features.hpp>
+#include <packed_vector.hpp>
+#include <per_cpu.hpp>
+#include <vector.hpp>
+
+#include <ntddk.h>
+
+using namespace ktl;
+
+namespace tests::packed_vector {
+namespace details {
+template <class Ty>
+using value_vector = vector<Ty, basic_non_paged_allocator<Ty> >;
+
+struct random_generator {
+  uint64_t next() noexcept {
+    state = state * 6364136223846793005 + 1442695040888963407;  // LCG
+    return state >> 11;
+  }
+
+  uint64_t state{0x12345678};
+};
+
+template <uint32_t Bits>
+static void check_get_and_set(size_t count) {
+  using packed_type = ktl::packed_vector<Bits>;
+  using value_type = typename packed_type::value_type;
+
+  random_generator random;
+  packed_type packed(count);
+  value_vector<value_type> expected(count);
+  for (size_t idx = 0; idx < count; ++idx) {
+    expected[idx] = static_cast<value_type>(random.next()) &
+                    packed_type::MAX_VALUE;
+    packed.set(idx, expected[idx]);
+  }
+  for (size_t idx = 0; idx < count; ++idx) {
+    ASSERT_EQ(packed[idx], expected[idx])
+  }
+
+  // The neighbours aren't touched and the extra bits are ignored
+  packed.set(1, static_cast<value_type>(~value_type{0}));
+  ASSERT_EQ(packed[0], expected[0])
+  ASSERT_EQ(packed[1], packed_type::MAX_VALUE)
+  ASSERT_EQ(packed[2], expected[2])
+
+  packed.resize(count / 2);
+  packed.resize(count);
+  ASSERT_EQ(packed[count / 2 - 1], expected[count / 2 - 1])
+  ASSERT_EQ(packed[count / 2], value_type{0})
+  ASSERT_EQ(packed[count - 1], value_type{0})
+}
+
+// Sorted values in [0, max_value] with duplicates
+static value_vector<uint64_t> make_sorted_values(random_generator& random,
+                                                 size_t count,
+                                                 uint64_t max_value) {
+  value_vector<uint64_t> values(count);
+  const uint64_t max_gap{max_value / count};
+  uint64_t value{0};
+  for (auto& target : values) {
+    value += random.next() % (max_gap + 1);
+    target = value;
+  }
+  return values;
+}
+
+static size_t find_lower_bound(const value_vector<uint64_t>& values,
+                               uint64_t value) noexcept {
+  size_t first{0};
+  size_t last{values.size()};
+  while (first < last) {
+    const size_t middle{first + (last - first) / 2};
+    if (values[middle] < value) {
+      first = middle + 1;
+    } else {
+      last = middle;
+    }
+  }
+  return first;
+}
+
+struct processor_slots {
+  ktl::packed_vector<3>* packed;
+  uint32_t slots_per_processor;
+};
+
+static ULONG_PTR set_on_processor(ULONG_PTR context) {
+  const auto& target{*reinterpret_cast<processor_slots*>(context)};
+  // The processors write interleaved values, so they share the words
+  const uint32_t processor_count{
+      KeQueryActiveProcessorCountEx(ALL_PROCESSOR_GROUPS)};
+  const uint32_t current{KeGetCurrentProcessorIndex()};
+  for (uint32_t idx = 0; idx < target.slots_per_processor; ++idx) {
+    target.packed->set_atomic(idx * processor_count + current,
+                              (current + idx) % 8);
+  }
+  return 0;
+}
+}  // namespace details
+
+void get_and_set() {
+  using namespace details;
+
+  check_get_and_set<1>(1000);
+  check_get_and_set<4>(1000);
+  check_get_and_set<12>(1000);
+  check_get_and_set<25>(1000);
+  check_get_and_set<33>(1000);
+  check_get_and_set<64>(1000);
+
+  ktl::packed_vector<12> rules;
+  for (uint32_t idx = 0; idx < 100; ++idx) {
+    rules.push_back(idx * 40);
+  }
+  ASSERT_EQ(rules.size(), size_t{100})
+  ASSERT_EQ(rules[99], uint32_t{3960})
+  ASSERT_VALUE(rules.size_in_bytes() < 100 * sizeof(uint32_t) / 2)
+}
+
+void unpack_ranges() {
+  using namespace details;
+  using pv::details::unpack_generic;
+  using pv::details::unpack_sse41;
+
+  constexpr size_t COUNT{1000};
+  static constexpr uint32_t BITS[]{1, 3, 8, 12, 17, 25, 26, 32};
+  static constexpr size_t FIRSTS[]{0, 1, 3, 7, 500};
+  static constexpr size_t SIZES[]{0, 1, 4, 5, 31, 493};
+
+  random_generator random;
+  value_vector<uint64_t> words(pv::details::get_word_count(COUNT, 32));
+  for (auto& word : words) {
+    word = random.next() << 11 ^ random.next();
+  }
+  value_vector<uint32_t> expected(COUNT);
+  value_vector<uint32_t> actual(COUNT);
+  for (const uint32_t bits : BITS) {
+    const size_t word_count{pv::details::get_word_count(COUNT, bits)};
+    for (const size_t first : FIRSTS) {
+      for (const size_t size : SIZES) {
+        unpack_generic(words.data(), word_count, first, bits, expected.data(),
+                       size);
+        pv::details::unpack(words.data(), word_count, first, bits,
+                            actual.data(), size);
+        ASSERT_VALUE(equal(expected.data(), expected.data() + size,
+                           actual.data()))
+        if (cpu::has<cpu_feature::ssse3, cpu_feature::sse41>()) {
+          unpack_sse41(words.data(), word_count, first, bits, actual.data(),
+                       size);
+          ASSERT_VALUE(equal(expected.data(), expected.data() + size,
+                             actual.data()))
+        }
+      }
+    }
+  }
+
+  ktl::packed_vector<12> packed(COUNT);
+  for (size_t idx = 0; idx < COUNT; ++idx) {
+    packed.set(idx, static_cast<uint32_t>(idx * 7));
+  }
+  packed.unpack(10, span{actual.data(), 100});
+  for (size_t idx = 0; idx < 100; ++idx) {
+    ASSERT_EQ(actual[idx], static_cast<uint32_t>((idx + 10) * 7 % 4096))
+  }
+  bool thrown{false};
+  try {
+    packed.unpack(COUNT - 10, span{actual.data(), 11});
+  } catch ([[maybe_unused]] const out_of_range& exc) {
+    thrown = true;
+  }
+  ASSERT_VALUE(thrown)
+}
+
+void set_from_all_processors() {
+  using namespace details;
+
+  const uint32_t processor_count{
+      KeQueryActiveProcessorCountEx(ALL_PROCESSOR_GROUPS)};
+  constexpr uint32_t SLOTS_PER_PROCESSOR{1000};
+  ktl::packed_vector<3> packed(size_t{SLOTS_PER_PROCESSOR} * processor_count);
+  processor_slots slots{addressof(packed), SLOTS_PER_PROCESSOR};
+  // Runs on each processor at IPI_LEVEL
+  KeIpiGenericCall(&set_on_processor,
+                   reinterpret_cast<ULONG_PTR>(addressof(slots)));
+  for (uint32_t processor = 0; processor < processor_count; ++processor) {
+    for (uint32_t idx = 0; idx < SLOTS_PER_PROCESSOR; ++idx) {
+      ASSERT_EQ(packed[idx * processor_count + processor],
+                (processor + idx) % 8)
+    }
+  }
+}
+
+void select_and_lower_bound() {
+  using namespace details;
+
+  static constexpr uint64_t MAX_VALUES[]{1000, 100000, uint64_t{1} << 40,
+                                         ~uint64_t{0}};
+  random_generator random;
+  for (const uint64_t max_value : MAX_VALUES) {
+    const auto values{make_sorted_values(random, 3000, max_value)};
+    const monotone_vector encoded{span<const uint64_t>{values}};
+    ASSERT_EQ(encoded.size(), values.size())
+    for (size_t idx = 0; idx < values.size(); ++idx) {
+      ASSERT_EQ(encoded.select(idx), values[idx])
+    }
+    for (uint32_t query = 0; query < 1000; ++query) {
+      const uint64_t value{query % 2 ? values[random.next() % values.size()]
+                                     : random.next() % (max_value / 2)};
+      ASSERT_EQ(encoded.lower_bound(value), find_lower_bound(values, value))
+    }
+    ASSERT_EQ(encoded.lower_bound(0), size_t{0})
+    if (values.back() != ~uint64_t{0}) {
+      ASSERT_EQ(encoded.lower_bound(values.back() + 1), values.size())
+    }
+  }
+
+  value_vector<uint64_t> offsets(100000);
+  for (size_t idx = 0; idx < offsets.size(); ++idx) {
+    offsets[idx] = idx * 37;
+  }
+  const monotone_vector encoded{span<const uint64_t>{offsets}};
+  // About 2 + log2(37) bits per value
+  ASSERT_VALUE(encoded.size_in_bytes() * 8 < offsets.size() * 8)
+  tests::details::print("{} bytes for {} offsets\n", encoded.size_in_bytes(),
+                        offsets.size());
+}
+
+void reject_unsorted_values() {
+  static constexpr uint64_t VALUES[]{5, 100, 6};
+  bool thrown{false};
+  try {
+    monotone_vector encoded{span{VALUES}};
+  } catch ([[maybe_unused]] const invalid_argument& exc) {
+    thrown = true;
+  }
+  ASSERT_VALUE(thrown)
+  ASSERT_VALUE(monotone_vector{}.empty())
+  ASSERT_EQ(monotone_vector{}.lower_bound(1), size_t{0})
+}
+}  // namespace tests::packed_vector
@@ -0,0 +1,9 @@
+#pragma once
+
+namespace tests::packed_vector {
+void get_and_set();
+void unpack_ranges();
+void set_from_all_processors();
+void select_and_lower_bound();
+void reject_unsorted_values();
+}  // namespace tests::packed_vector
@@ -1,4 +1,5 @@
 #pragma once
+#include <basic_types.hpp>
 
 namespace tests::preload_init {
 // 1 slot is used by the exception dispatcher
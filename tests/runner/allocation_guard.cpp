@@ -0,0 +1,31 @@
+#include "allocation_guard.hpp"
+
+#ifdef KTL_ALLOCATION_HOOKS
+namespace tests {
+no_allocation_guard::no_allocation_guard() noexcept
+    : m_thread{KeGetCurrentThread()},
+      m_previous{ktl::heap::set_allocation_hook({this, m_thread})} {}
+
+no_allocation_guard::~no_allocation_guard() noexcept {
+  release();
+}
+
+void no_allocation_guard::release() noexcept {
+  if (m_installed) {
+    m_installed = false;
+    ktl::heap::set_allocation_hook(m_previous);
+  }
+}
+
+void no_allocation_guard::on_allocation(
+    const ktl::alloc_request& request) noexcept {
+  // The heap calls the hook on m_thread only
+  ++m_allocation_count;
+  m_allocated_bytes += request.bytes_count;
+  // The hook of another thread may already be destroyed
+  if (m_previous.hook && m_previous.thread == m_thread) {
+    m_previous.hook->on_allocation(request);
+  }
+}
+}  // namespace tests
+#endif
@@ -0,0 +1,43 @@
+#pragma once
+#include <basic_types.hpp>
+#include <heap.hpp>
+#include <type_traits.hpp>
+
+#include <ntddk.h>
+
+namespace tests {
+#ifdef KTL_ALLOCATION_HOOKS
+/**
+ * @class no_allocation_guard
+ * @brief Counts the heap allocations made by the current thread while the
+ * guard is installed. The guards may be nested, but must be released in the
+ * reverse order
+ */
+class no_allocation_guard final : ktl::heap::allocation_hook,
+                                  ktl::non_relocatable {
+ public:
+  no_allocation_guard() noexcept;
+  ~no_allocation_guard() noexcept;
+
+  void release() noexcept;
+
+  [[nodiscard]] size_t get_allocation_count() const noexcept {
+    return m_allocation_count;
+  }
+
+  [[nodiscard]] size_t get_allocated_bytes() const noexcept {
+    return m_allocated_bytes;
+  }
+
+ private:
+  void on_allocation(const ktl::alloc_request& request) noexcept final;
+
+ private:
+  PKTHREAD m_thread;
+  ktl::heap::allocation_hook_binding m_previous;
+  size_t m_allocation_count{0};
+  size_t m_allocated_bytes{0};
+  bool m_installed{true};
+};
+#endif
+}  // namespace tests
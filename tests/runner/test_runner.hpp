@@ -1,4 +1,5 @@
 #pragma once
+#include "allocation_guard.hpp"
 #include "container_traits.hpp"
 
 #include <bugcheck.hpp>
@@ -27,7 +28,6 @@ struct basic_container_formatter {
 }  // namespace tests::details
 
 namespace fmt {
-#define EMPTY_PREFIX
 #define VALUE_CONTAINER_FORMATTER(char_type, prefix)                         \
   template <class Container>                                                 \
   struct formatter<Container, char_type,                                     \
@@ -74,15 +74,14 @@ namespace fmt {
     }                                                                         \
   };
 
-VALUE_CONTAINER_FORMATTER(char, EMPTY_PREFIX)
+VALUE_CONTAINER_FORMATTER(char, /* No prefix */)
 VALUE_CONTAINER_FORMATTER(wchar_t, L)
 
-KV_CONTAINER_FORMATTER(char, EMPTY_PREFIX)
+KV_CONTAINER_FORMATTER(char, /* No prefix */)
 KV_CONTAINER_FORMATTER(wchar_t, L)
 
 #undef KV_CONTAINER_FORMATTER
 #undef VALUE_CONTAINER_FORMATTER
-#undef EMPTY_PREFIX
 }  // namespace fmt
 
 namespace tests {
@@ -93,7 +92,7 @@ template <class... Types>
 ktl::ansi_string_non_paged format_non_paged(ktl::ansi_string_view format,
                                             const Types&... args) {
   ktl::ansi_string_non_paged buffer;
-  ktl::format_to(ktl::back_inserter(buffer), format, args...);
+  ktl::format_to(ktl::back_inserter(buffer), fmt::runtime(format), args...);
   return buffer;
 }
 
@@ -175,4 +174,23 @@ class runner : ktl::non_relocatable {
     tests::check_equal((x), (y), hint);                                        \
   }
 
+#ifdef KTL_ALLOCATION_HOOKS
+// The guard is released before the hint is formatted, so the assertion itself
+// doesn't count
+#define ASSERT_NO_ALLOCATIONS(...)                                             \
+  {                                                                            \
+    tests::no_allocation_guard allocation_guard;                               \
+    __VA_ARGS__;                                                               \
+    allocation_guard.release();                                                \
+    const auto hint{tests::details::format_non_paged(                          \
+        "{} allocates {} bytes, {}: {}", #__VA_ARGS__,                         \
+        allocation_guard.get_allocated_bytes(), __FILE__, __LINE__)};          \
+    tests::check_equal(allocation_guard.get_allocation_count(), size_t{0},     \
+                       hint);                                                  \
+  }
+#else
+#define ASSERT_NO_ALLOCATIONS(...) \
+  { __VA_ARGS__; }
+#endif
+
 #define RUN_TEST(tr, func) tr.execute(func, #func)
@@ -0,0 +1,184 @@
+#include "test.hpp"
+
+#include <test_runner.hpp>
+
+#include <sorted_string_table.hpp>
+#include <string.hpp>
+#include <string_view.hpp>
+#include <vector.hpp>
+
+#include <ntddk.h>
+
+using namespace ktl;
+
+namespace tests::sorted_string_table {
+namespace details {
+using table_type = ktl::sorted_string_table;
+using byte_vector = vector<byte, basic_non_paged_allocator<byte> >;
+
+static const unicode_string_view PATHS[]{
+    L"\\Device\\HarddiskVolume2\\Users\\Public\\desktop.ini"_usv,
+    L"\\Device\\HarddiskVolume3\\Program Files\\Vendor\\agent.exe"_usv,
+    L"\\Device\\HarddiskVolume3\\Program Files\\Vendor\\agent.sys"_usv,
+    L"\\Device\\HarddiskVolume3\\Program Files\\Vendor\\config\\a.json"_usv,
+    L"\\Device\\HarddiskVolume3\\Program Files\\Vendor\\config\\b.json"_usv,
+    L"\\Device\\HarddiskVolume3\\Windows\\System32\\drivers\\disk.sys"_usv,
+    L"\\Device\\HarddiskVolume3\\Windows\\System32\\drivers\\fltmgr.sys"_usv,
+    L"\\Device\\HarddiskVolume3\\Windows\\System32\\kernel32.dll"_usv,
+    L"\\Device\\HarddiskVolume3\\Windows\\System32\\ntdll.dll"_usv,
+    L"\\Device\\HarddiskVolume3\\Windows\\explorer.exe"_usv,
+};
+
+inline constexpr size_t PATH_COUNT{sizeof(PATHS) / sizeof(PATHS[0])};
+
+static table_type make_table(uint32_t block_size) {
+  return table_type{PATHS, PATHS + PATH_COUNT, block_size};
+}
+}  // namespace details
+
+void find_strings() {
+  using namespace details;
+
+  for (uint32_t block_size = 1; block_size <= PATH_COUNT + 1; ++block_size) {
+    const auto table{make_table(block_size)};
+    ASSERT_EQ(table.size(), PATH_COUNT)
+    for (size_t idx = 0; idx < PATH_COUNT; ++idx) {
+      ASSERT_EQ(table.find(PATHS[idx]), idx)
+      ASSERT_EQ(table.lower_bound(PATHS[idx]), idx)
+    }
+    ASSERT_VALUE(!table.contains(L"\\Device"_usv))
+    ASSERT_EQ(table.lower_bound(L"\\Device"_usv), size_t{0})
+    ASSERT_EQ(table.find(L"\\Device\\HarddiskVolume3\\Windows"_usv),
+              table_type::npos)
+    ASSERT_EQ(table.lower_bound(L"\\Device\\HarddiskVolume3\\Windows"_usv),
+              size_t{5})
+    ASSERT_EQ(table.lower_bound(L"\\Device\\HarddiskVolume4"_usv), PATH_COUNT)
+  }
+
+  const table_type empty{PATHS, PATHS};
+  ASSERT_VALUE(empty.empty())
+  ASSERT_EQ(empty.lower_bound(PATHS[0]), size_t{0})
+  ASSERT_VALUE(!empty.contains(PATHS[0]))
+}
+
+void query_prefix_ranges() {
+  using namespace details;
+
+  const auto table{make_table(4)};
+  auto range{table.prefix_range(L"\\Device\\HarddiskVolume3\\Windows\\"_usv)};
+  ASSERT_EQ(range.first, size_t{5})
+  ASSERT_EQ(range.second, size_t{10})
+
+  range = table.prefix_range(
+      L"\\Device\\HarddiskVolume3\\Program Files\\Vendor\\agent"_usv);
+  ASSERT_EQ(range.first, size_t{1})
+  ASSERT_EQ(range.second, size_t{3})
+
+  range = table.prefix_range(L"\\Device\\HarddiskVolume1"_usv);
+  ASSERT_EQ(range.first, range.second)
+
+  range = table.prefix_range(L""_usv);
+  ASSERT_EQ(range.first, size_t{0})
+  ASSERT_EQ(range.second, PATH_COUNT)
+}
+
+void iterate_strings() {
+  using namespace details;
+
+  const auto table{make_table(3)};
+  size_t expected{0};
+  table.for_each([&expected](unicode_string_view path) {
+    ASSERT_VALUE(path == PATHS[expected])
+    ++expected;
+  });
+  ASSERT_EQ(expected, PATH_COUNT)
+
+  auto cursor{table.make_cursor(4)};
+  for (size_t idx = 4; idx < PATH_COUNT; ++idx, cursor.next()) {
+    ASSERT_VALUE(cursor.valid())
+    ASSERT_EQ(cursor.index(), idx)
+    ASSERT_VALUE(cursor.value() == PATHS[idx])
+  }
+  ASSERT_VALUE(!cursor.valid())
+
+  size_t visited{0};
+  table.for_each(5, 7, [&visited](unicode_string_view path) {
+    ASSERT_VALUE(path == PATHS[5 + visited])
+    ++visited;
+  });
+  ASSERT_EQ(visited, size_t{2})
+}
+
+void map_image() {
+  using namespace details;
+
+  const auto image{table_type::build(PATHS, PATHS + PATH_COUNT)};
+  size_t raw_size{0};
+  for (const auto& path : PATHS) {
+    raw_size += path.size() * sizeof(wchar_t);
+  }
+  ASSERT_VALUE(image.size() < raw_size)
+
+  // E.g. a view of a file rounded up to the page size
+  byte_vector view(image.size() + 100);
+  memcpy(view.data(), image.data(), image.size());
+  const table_type table{span<const byte>{view}};
+  ASSERT_EQ(table.size(), PATH_COUNT)
+  ASSERT_EQ(table.image().size(), image.size())
+  for (size_t idx = 0; idx < PATH_COUNT; ++idx) {
+    ASSERT_EQ(table.find(PATHS[idx]), idx)
+  }
+  tests::details::print("{} bytes instead of {}\n", image.size(), raw_size);
+}
+
+void reject_damaged_image() {
+  using namespace details;
+
+  const auto image{table_type::build(PATHS, PATHS + PATH_COUNT, 4)};
+  // The magic, version, string count, data size and first block offset
+  const size_t damaged_offsets[]{0, 4, 12, 20, sizeof(sst::image_header)};
+  for (const size_t offset : damaged_offsets) {
+    byte_vector damaged{image};
+    damaged[offset] ^= 0x40;
+    bool thrown{false};
+    try {
+      const table_type table{span<const byte>{damaged}};
+    } catch ([[maybe_unused]] const invalid_argument& exc) {
+      thrown = true;
+    }
+    ASSERT_VALUE(thrown)
+  }
+
+  bool thrown{false};
+  try {
+    const table_type table{span<const byte>{image.data(), image.size() - 1}};
+  } catch ([[maybe_unused]] const invalid_argument& exc) {
+    thrown = true;
+  }
+  ASSERT_VALUE(thrown)
+
+  const unicode_string_view unsorted[]{L"b"_usv, L"a"_usv};
+  thrown = false;
+  try {
+    const table_type table{unsorted, unsorted + 2};
+  } catch ([[maybe_unused]] const invalid_argument& exc) {
+    thrown = true;
+  }
+  ASSERT_VALUE(thrown)
+
+  // "b" starts a block, so it's compared with the last string of the previous
+  const unicode_string_view unsorted_blocks[]{L"a"_usv, L"c"_usv, L"b"_usv,
+                                              L"d"_usv};
+  const uint32_t block_sizes[]{1, 2};
+  for (const uint32_t block_size : block_sizes) {
+    thrown = false;
+    try {
+      const auto rejected{
+          table_type::build(unsorted_blocks, unsorted_blocks + 4, block_size)};
+    } catch ([[maybe_unused]] const invalid_argument& exc) {
+      thrown = true;
+    }
+    ASSERT_VALUE(thrown)
+  }
+}
+}  // namespace tests::sorted_string_table
@@ -0,0 +1,9 @@
+#pragma once
+
+namespace tests::sorted_string_table {
+void find_strings();
+void query_prefix_ranges();
+void iterate_strings();
+void map_image();
+void reject_damaged_image();
+}  // namespace tests::sorted_string_table
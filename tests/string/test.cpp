@@ -0,0 +1,51 @@
+#include "test.hpp"
+
+#include <test_runner.hpp>
+
+#include <iterator.hpp>
+#include <string.hpp>
+
+using namespace ktl;
+
+namespace tests::string {
+namespace details {
+// Longer than the SSO buffer, so the appends reallocate
+static constexpr char WORDS[]{"C++ in Windows Kernel, "};
+static constexpr size_t WORDS_LENGTH{size(WORDS) - 1};
+
+// move_iterator isn't a pointer, so the range is copied element by element
+inline auto words_begin() noexcept {
+  return make_move_iterator(WORDS + 0);
+}
+
+inline auto words_end() noexcept {
+  return make_move_iterator(WORDS + WORDS_LENGTH);
+}
+}  // namespace details
+
+void append_iterator_range() {
+  using namespace details;
+
+  ansi_string str;
+  str.append(words_begin(), words_end());
+  ASSERT_EQ(str.size(), WORDS_LENGTH)
+  ASSERT_VALUE(str == ansi_string_view{WORDS})
+
+  str.append(words_begin(), words_end());
+  ASSERT_EQ(str.size(), 2 * WORDS_LENGTH)
+  ASSERT_VALUE(str == ansi_string_view{"C++ in Windows Kernel, "
+                                       "C++ in Windows Kernel, "})
+}
+
+void insert_iterator_range() {
+  using namespace details;
+
+  ansi_string str{"[]"};
+  str.insert(str.begin() + 1, words_begin(), words_end());
+  ASSERT_EQ(str.size(), WORDS_LENGTH + 2)
+  ASSERT_VALUE(str == ansi_string_view{"[C++ in Windows Kernel, ]"})
+
+  str.insert(str.begin() + 1, words_begin(), words_begin() + 4);
+  ASSERT_VALUE(str == ansi_string_view{"[C++ C++ in Windows Kernel, ]"})
+}
+}  // namespace tests::string
@@ -0,0 +1,6 @@
+#pragma once
+
+namespace tests::string {
+void append_iterator_range();
+void insert_iterator_range();
+}  // namespace tests::string
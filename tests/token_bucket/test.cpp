@@ -0,0 +1,128 @@
+#include "test.hpp"
+
+#include <test_runner.hpp>
+
+#include <chrono.hpp>
+#include <thread.hpp>
+#include <token_bucket.hpp>
+
+#include <ntddk.h>
+
+using namespace ktl;
+
+namespace tests::token_bucket {
+namespace details {
+static constexpr uint32_t ACQUIRES_PER_PROCESSOR{10000};
+
+template <class Bucket>
+static ULONG_PTR acquire_on_processor(ULONG_PTR context) {
+  auto& bucket{*reinterpret_cast<Bucket*>(context)};
+  for (uint32_t idx = 0; idx < ACQUIRES_PER_PROCESSOR; ++idx) {
+    bucket.try_acquire();
+  }
+  return 0;
+}
+
+// All of the processors hammer the bucket at once
+template <class Bucket>
+static uint64_t measure_cost(Bucket& bucket) {
+  const auto started{chrono::steady_clock::now()};
+  KeIpiGenericCall(&acquire_on_processor<Bucket>,
+                   reinterpret_cast<ULONG_PTR>(addressof(bucket)));
+  const auto elapsed{chrono::duration_cast<chrono::nanoseconds>(
+      chrono::steady_clock::now() - started)};
+  return static_cast<uint64_t>(elapsed.count()) / ACQUIRES_PER_PROCESSOR;
+}
+
+template <class Bucket>
+static bool verify_construction(uint64_t rate, uint64_t burst) {
+  try {
+    Bucket bucket{rate, burst};
+  } catch ([[maybe_unused]] const invalid_argument& exc) {
+    return false;
+  }
+  return true;
+}
+}  // namespace details
+
+void acquire_and_refill() {
+  // The refill is too slow to interfere with the checks
+  ktl::token_bucket bucket{10, 10};
+  ASSERT_EQ(bucket.rate(), uint64_t{10})
+  ASSERT_EQ(bucket.burst(), uint64_t{10})
+  ASSERT_EQ(bucket.available(), uint64_t{10})
+  ASSERT_VALUE(!bucket.try_acquire(11))
+  ASSERT_VALUE(bucket.try_acquire(4))
+  ASSERT_VALUE(!bucket.try_acquire(7))  // Nothing is taken on failure
+  ASSERT_VALUE(bucket.try_acquire(6))
+  ASSERT_VALUE(!bucket.try_acquire())
+
+  // Refilled on the clock interrupts
+  this_thread::sleep_for(chrono::milliseconds{1100});
+  ASSERT_EQ(bucket.available(), uint64_t{10})
+  for (uint32_t idx = 0; idx < 10; ++idx) {
+    ASSERT_VALUE(bucket.try_acquire())
+  }
+  ASSERT_VALUE(!bucket.try_acquire())
+}
+
+void refill_at_high_rate() {
+  // 10^9 / rate isn't an integer, so a nanosecond interval would be truncated
+  // to 1 ns, refilling 10^9 tokens per second instead
+  static constexpr uint64_t RATE{600'000'000};
+  static constexpr uint64_t SLACK_MS{50};  // For the coarse clock lag
+
+  ktl::token_bucket bucket{RATE, RATE};
+  const auto started{chrono::steady_clock::now()};
+  ASSERT_VALUE(bucket.try_acquire(RATE))
+  this_thread::sleep_for(chrono::milliseconds{200});
+  const uint64_t refilled{bucket.available()};
+  const auto elapsed{chrono::duration_cast<chrono::milliseconds>(
+      chrono::steady_clock::now() - started)};
+  const uint64_t elapsed_ms{static_cast<uint64_t>(elapsed.count())};
+  ASSERT_VALUE(refilled <= RATE / 1000 * (elapsed_ms + SLACK_MS))
+  ASSERT_VALUE(refilled >= RATE / 1000 * (200 - SLACK_MS))
+}
+
+void reject_invalid_parameters() {
+  using namespace details;
+
+  ASSERT_VALUE(verify_construction<ktl::token_bucket>(1, 1))
+  ASSERT_VALUE(verify_construction<ktl::token_bucket>(1'000'000'000, 1))
+  ASSERT_VALUE(!verify_construction<ktl::token_bucket>(0, 1))
+  ASSERT_VALUE(!verify_construction<ktl::token_bucket>(1, 0))
+  ASSERT_VALUE(!verify_construction<ktl::token_bucket>(1'000'000'001, 1))
+  ASSERT_VALUE(!verify_construction<ktl::token_bucket>(1, ~uint64_t{0}))
+  ASSERT_VALUE(!verify_construction<sharded_token_bucket>(0, 1))
+}
+
+void share_between_processors() {
+  const uint64_t processor_count{max_processor_count()};
+  sharded_token_bucket bucket{processor_count, processor_count * 10};
+  ASSERT_EQ(bucket.available(), processor_count * 10)
+
+  // A single processor drains the buckets of the other ones as well
+  uint64_t acquired{0};
+  {
+    dispatch_level_guard guard;
+    while (bucket.try_acquire()) {
+      ++acquired;
+    }
+  }
+  ASSERT_EQ(acquired, processor_count * 10)
+  ASSERT_EQ(bucket.available(), uint64_t{0})
+}
+
+void measure_acquire_cost() {
+  using namespace details;
+
+  // Nearly all of the acquires succeed, so each one is a CAS
+  ktl::token_bucket shared{1'000'000'000, 1'000'000'000};
+  sharded_token_bucket sharded{1'000'000'000, 1'000'000'000};
+  tests::details::print(
+      "token_bucket: {} ns per acquire, sharded: {} ns per acquire on {} "
+      "processors\n",
+      measure_cost(shared), measure_cost(sharded),
+      KeQueryActiveProcessorCountEx(ALL_PROCESSOR_GROUPS));
+}
+}  // namespace tests::token_bucket
@@ -0,0 +1,9 @@
+#pragma once
+
+namespace tests::token_bucket {
+void acquire_and_refill();
+void refill_at_high_rate();
+void reject_invalid_parameters();
+void share_between_processors();
+void measure_acquire_cost();
+}  // namespace tests::token_bucket
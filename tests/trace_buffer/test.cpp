@@ -0,0 +1,231 @@
+#include "test.hpp"
+
+#include <test_runner.hpp>
+
+#include <atomic.hpp>
+#include <chrono.hpp>
+#include <per_cpu.hpp>
+#include <thread.hpp>
+#include <trace_buffer.hpp>
+#include <vector.hpp>
+
+#include <ntddk.h>
+
+using namespace ktl;
+
+namespace tests::trace_buffer {
+namespace details {
+struct sample_payload {
+  uint64_t sequence;
+  uint32_t value;
+};
+
+static sample_payload read_payload(const trace_record& record) noexcept {
+  sample_payload payload;
+  memcpy(addressof(payload), record.payload, sizeof(payload));
+  return payload;
+}
+
+static ULONG_PTR write_on_processor(ULONG_PTR context) {
+  auto& buffer{*reinterpret_cast<ktl::trace_buffer*>(context)};
+  buffer.write(2, sample_payload{current_processor_index(), 0});
+  return 0;
+}
+
+static constexpr uint32_t WRITER_COUNT{8};
+static constexpr uint32_t WRITES_PER_WRITER{20000};
+
+// Mixes the whole stamp, so a record assembled from two writes mismatches
+static uint32_t get_check(uint64_t stamp) noexcept {
+  return static_cast<uint32_t>((stamp * UINT64_C(0x9E3779B97F4A7C15)) >> 32);
+}
+
+struct stress_result {
+  uint64_t consumed;
+  uint64_t torn;
+  uint64_t duplicated;
+  trace_stats stats;
+};
+
+// More writers than processors are preempted between the reservation and the
+// commit, while the consumer drains the small rings concurrently
+static stress_result stress_writers(trace_mode mode) {
+  ktl::trace_buffer buffer{64, mode};
+  vector<uint8_t> seen(size_t{WRITER_COUNT} * WRITES_PER_WRITER);
+  atomic<uint32_t> running{WRITER_COUNT};
+  auto write{[&buffer, &running](uint32_t writer) {
+    for (uint32_t idx = 0; idx < WRITES_PER_WRITER; ++idx) {
+      const uint64_t stamp{uint64_t{writer} << 32 | idx};
+      buffer.write(7, sample_payload{stamp, get_check(stamp)});
+      if (idx % 64 == 0) {
+        this_thread::yield();
+      }
+    }
+    running.fetch_sub(1);
+  }};
+
+  stress_result result{};
+  const auto verify{[&seen, &result](const trace_record& record) {
+    const auto payload{read_payload(record)};
+    const uint64_t writer{payload.sequence >> 32};
+    const uint64_t idx{payload.sequence & 0xFFFFFFFF};
+    if (record.event_id != 7 ||
+        record.payload_size != sizeof(sample_payload) ||
+        writer >= WRITER_COUNT || idx >= WRITES_PER_WRITER ||
+        payload.value != get_check(payload.sequence)) {
+      ++result.torn;
+      return;
+    }
+    auto& mark{seen[writer * WRITES_PER_WRITER + idx]};
+    if (mark) {
+      ++result.duplicated;
+    }
+    mark = 1;
+    ++result.consumed;
+  }};
+
+  system_thread threads[WRITER_COUNT];
+  for (uint32_t idx = 0; idx < WRITER_COUNT; ++idx) {
+    threads[idx] = system_thread{write, idx};
+  }
+  while (running.load() != 0) {
+    buffer.consume(verify);
+    this_thread::yield();
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  buffer.consume(verify);
+  result.stats = buffer.stats();
+  return result;
+}
+}  // namespace details
+
+void write_and_consume() {
+  using namespace details;
+
+  ktl::trace_buffer buffer{256};
+  {
+    dispatch_level_guard guard;  // All of the records go to the same ring
+    for (uint32_t idx = 0; idx < 100; ++idx) {
+      ASSERT_VALUE(buffer.write(1, sample_payload{idx, idx * 3}))
+    }
+    ASSERT_VALUE(buffer.write(5))
+  }
+
+  uint64_t expected{0};
+  uint64_t last_timestamp{0};
+  const size_t consumed{buffer.consume([&](const trace_record& record) {
+    ASSERT_VALUE(record.timestamp >= last_timestamp)
+    last_timestamp = record.timestamp;
+    if (expected < 100) {
+      const auto payload{read_payload(record)};
+      ASSERT_EQ(record.event_id, uint32_t{1})
+      ASSERT_EQ(record.payload_size, uint16_t{sizeof(sample_payload)})
+      ASSERT_EQ(payload.sequence, expected)
+      ASSERT_EQ(payload.value, static_cast<uint32_t>(expected * 3))
+    } else {
+      ASSERT_EQ(record.event_id, uint32_t{5})
+      ASSERT_EQ(record.payload_size, uint16_t{0})
+    }
+    ++expected;
+  })};
+  ASSERT_EQ(consumed, size_t{101})
+  ASSERT_EQ(buffer.consume([](const trace_record&) {}), size_t{0})
+}
+
+void stop_and_overwrite_modes() {
+  using namespace details;
+
+  ktl::trace_buffer stopping{8, trace_mode::stop};
+  ktl::trace_buffer overwriting{8, trace_mode::overwrite};
+  {
+    dispatch_level_guard guard;
+    for (uint32_t idx = 0; idx < 20; ++idx) {
+      ASSERT_EQ(stopping.write(1, sample_payload{idx, 0}), idx < 8)
+      ASSERT_VALUE(overwriting.write(1, sample_payload{idx, 0}))
+    }
+  }
+
+  // The stopped buffer keeps the oldest records
+  uint64_t expected{0};
+  ASSERT_EQ(stopping.consume([&expected](const trace_record& record) {
+              ASSERT_EQ(read_payload(record).sequence, expected++)
+            }),
+            size_t{8})
+  auto stats{stopping.stats()};
+  ASSERT_EQ(stats.written, uint64_t{8})
+  ASSERT_EQ(stats.dropped, uint64_t{12})
+  ASSERT_VALUE(stopping.write(1))  // There is free space again
+
+  // The overwritten buffer keeps the newest records
+  expected = 12;
+  ASSERT_EQ(overwriting.consume([&expected](const trace_record& record) {
+              ASSERT_EQ(read_payload(record).sequence, expected++)
+            }),
+            size_t{8})
+  stats = overwriting.stats();
+  ASSERT_EQ(stats.written, uint64_t{20})
+  ASSERT_EQ(stats.lost, uint64_t{12})
+}
+
+void write_from_all_processors() {
+  using namespace details;
+
+  ktl::trace_buffer buffer{16};
+  // Runs on each processor at IPI_LEVEL
+  KeIpiGenericCall(&write_on_processor,
+                   reinterpret_cast<ULONG_PTR>(addressof(buffer)));
+
+  const uint32_t processor_count{
+      KeQueryActiveProcessorCountEx(ALL_PROCESSOR_GROUPS)};
+  uint32_t visited{0};
+  ASSERT_EQ(buffer.consume([&visited](const trace_record& record) {
+              ASSERT_EQ(record.event_id, uint32_t{2})
+              ASSERT_EQ(read_payload(record).sequence, uint64_t{record.cpu})
+              ++visited;
+            }),
+            size_t{processor_count})
+  ASSERT_EQ(visited, processor_count)
+}
+
+void stress_concurrent_writers() {
+  using namespace details;
+
+  static constexpr uint64_t TOTAL{uint64_t{WRITER_COUNT} * WRITES_PER_WRITER};
+
+  // Every record is either consumed once or counted as lost
+  auto result{stress_writers(trace_mode::overwrite)};
+  ASSERT_EQ(result.torn, uint64_t{0})
+  ASSERT_EQ(result.duplicated, uint64_t{0})
+  ASSERT_EQ(result.stats.written, TOTAL)
+  ASSERT_EQ(result.consumed + result.stats.lost, TOTAL)
+
+  // Every record is either consumed once or dropped by the writer
+  result = stress_writers(trace_mode::stop);
+  ASSERT_EQ(result.torn, uint64_t{0})
+  ASSERT_EQ(result.duplicated, uint64_t{0})
+  ASSERT_EQ(result.stats.written, result.consumed)
+  ASSERT_EQ(result.consumed + result.stats.dropped, TOTAL)
+  tests::details::print(
+      "trace_buffer: {} writers on {} processors, {} of {} records consumed "
+      "in the stop mode\n",
+      WRITER_COUNT, KeQueryActiveProcessorCountEx(ALL_PROCESSOR_GROUPS),
+      result.consumed, TOTAL);
+}
+
+void measure_write_cost() {
+  using namespace details;
+
+  ktl::trace_buffer buffer{4096};
+  static constexpr uint32_t WRITES{1000000};
+  const auto started{chrono::steady_clock::now()};
+  for (uint32_t idx = 0; idx < WRITES; ++idx) {
+    buffer.write(3, sample_payload{idx, 0});
+  }
+  const auto elapsed{chrono::duration_cast<chrono::nanoseconds>(
+      chrono::steady_clock::now() - started)};
+  tests::details::print("trace_buffer: {} ns per write\n",
+                        static_cast<uint64_t>(elapsed.count()) / WRITES);
+}
+}  // namespace tests::trace_buffer
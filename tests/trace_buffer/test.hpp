@@ -0,0 +1,9 @@
+#pragma once
+
+namespace tests::trace_buffer {
+void write_and_consume();
+void stop_and_overwrite_modes();
+void write_from_all_processors();
+void stress_concurrent_writers();
+void measure_write_cost();
+}  // namespace tests::trace_buffer
@@ -0,0 +1,169 @@
+#include "test.hpp"
+
+#include <test_runner.hpp>
+
+#include <modules/lockfree/node_allocator.hpp>
+
+#include <allocator.hpp>
+#include <atomic.hpp>
+#include <chrono.hpp>
+#include <io_buffer_pool.hpp>
+#include <mutex.hpp>
+#include <new_delete.hpp>
+#include <per_cpu.hpp>
+#include <thread.hpp>
+#include <trimmable.hpp>
+
+using namespace ktl;
+
+namespace tests::trimmable {
+namespace details {
+// Remembers the levels it has been trimmed at
+class trim_recorder : public ktl::trimmable {
+ public:
+  explicit trim_recorder(size_t released_from_moderate = 0) noexcept
+      : m_released{released_from_moderate} {}
+
+  size_t trim(trim_level level) noexcept override {
+    m_levels.fetch_or<memory_order_relaxed>(1u << static_cast<uint32_t>(level));
+    return level == trim_level::light ? 0 : m_released;
+  }
+
+  bool trimmed_at(trim_level level) const noexcept {
+    return m_levels.load<memory_order_relaxed>() &
+           (1u << static_cast<uint32_t>(level));
+  }
+
+  bool trimmed() const noexcept {
+    return m_levels.load<memory_order_relaxed>() != 0;
+  }
+
+ private:
+  size_t m_released;
+  atomic<uint32_t> m_levels{0};
+};
+
+using node_allocator_type =
+    lockfree::node_allocator<uint64_t,
+                             static_cast<align_val_t>(alignof(uint64_t)),
+                             aligned_non_paged_allocator,
+                             true>;
+}  // namespace details
+
+void trim_registered_objects() {
+  using namespace details;
+
+  trim_registry registry;
+  trim_recorder first, second{100};
+  registry.add(first);
+  registry.add(second);
+  ASSERT_EQ(registry.trim(trim_level::aggressive), size_t{100})
+  ASSERT_VALUE(first.trimmed_at(trim_level::aggressive))
+  ASSERT_VALUE(second.trimmed_at(trim_level::aggressive))
+
+  // Nothing is released at the light level, so the moderate one is tried
+  ASSERT_EQ(registry.trim_until_released(), size_t{100})
+  ASSERT_VALUE(second.trimmed_at(trim_level::light))
+  ASSERT_VALUE(second.trimmed_at(trim_level::moderate))
+
+  registry.remove(second);
+  ASSERT_EQ(registry.trim_until_released(), size_t{0})
+  registry.remove(first);
+}
+
+void trim_node_allocator() {
+  using namespace details;
+
+  node_allocator_type allocator{16};
+  const size_t node_size{allocator.trim(trim_level::light) / 8};
+  ASSERT_VALUE(node_size >= sizeof(uint64_t))
+  ASSERT_EQ(allocator.trim(trim_level::moderate), node_size * 6)
+  ASSERT_EQ(allocator.trim(trim_level::aggressive), node_size * 2)
+  ASSERT_EQ(allocator.trim(trim_level::aggressive), size_t{0})
+
+  // The allocator keeps working after it has been trimmed
+  uint64_t* nodes[4];
+  for (auto*& node : nodes) {
+    node = allocator.allocate();
+    ASSERT_VALUE(node)
+  }
+  for (auto* node : nodes) {
+    allocator.deallocate(node);
+  }
+  ASSERT_EQ(allocator.trim(trim_level::aggressive), node_size * 4)
+}
+
+void trim_buffer_pool() {
+  static constexpr size_t BUFFER_COUNT{4};
+  static constexpr size_t BUFFER_SIZE{ktl::io_buffer_pool::MIN_BUFFER_SIZE};
+
+  // Without the per-processor caches all of the buffers are shared
+  ktl::io_buffer_pool shared_pool{{false, 0}};
+  {
+    io_buffer buffers[BUFFER_COUNT];
+    for (auto& buffer : buffers) {
+      buffer = shared_pool.acquire(BUFFER_SIZE);
+      ASSERT_VALUE(static_cast<bool>(buffer))
+    }
+  }
+  ASSERT_EQ(shared_pool.trim(trim_level::light), BUFFER_COUNT * BUFFER_SIZE)
+
+  // The cached buffers are kept until the memory is low enough
+  ktl::io_buffer_pool cached_pool;
+  {
+    dispatch_level_guard guard;
+    io_buffer buffers[BUFFER_COUNT];
+    for (auto& buffer : buffers) {
+      buffer = cached_pool.acquire(BUFFER_SIZE);
+      ASSERT_VALUE(static_cast<bool>(buffer))
+    }
+  }
+  ASSERT_EQ(cached_pool.trim(trim_level::light), size_t{0})
+  ASSERT_EQ(cached_pool.trim(trim_level::aggressive),
+            BUFFER_COUNT * BUFFER_SIZE)
+}
+
+void watch_stand_in_events() {
+  using namespace details;
+
+  notify_event low_non_paged_pool, low_memory;
+  trim_registry registry;
+  trim_recorder recorder;
+  registry.add(recorder);
+  {
+    low_memory_watcher watcher{
+        registry,
+        {low_non_paged_pool.native_handle(), low_memory.native_handle()}};
+    this_thread::sleep_for(chrono::milliseconds{100});
+    ASSERT_EQ(watcher.trim_count(), uint64_t{0})
+
+    low_memory.set();
+    for (uint32_t attempt = 0; attempt < 100 && !recorder.trimmed();
+         ++attempt) {
+      this_thread::sleep_for(chrono::milliseconds{10});
+    }
+    low_memory.clear();
+    ASSERT_VALUE(recorder.trimmed_at(trim_level::light))
+    ASSERT_VALUE(watcher.trim_count() > 0)
+  }
+  registry.remove(recorder);
+}
+
+void trim_on_allocation_failure() {
+  using namespace details;
+
+  trim_registry registry;
+  trim_recorder recorder;
+  registry.add(recorder);
+  set_trim_new_handler(addressof(registry));
+  // Nothing can be released, so the handler gives up after the last level
+  void* memory{operator new(size_t{1} << 46, nothrow)};
+  set_trim_new_handler(nullptr);
+  registry.remove(recorder);
+
+  ASSERT_VALUE(!memory)
+  ASSERT_VALUE(recorder.trimmed_at(trim_level::light))
+  ASSERT_VALUE(recorder.trimmed_at(trim_level::moderate))
+  ASSERT_VALUE(recorder.trimmed_at(trim_level::aggressive))
+}
+}  // namespace tests::trimmable
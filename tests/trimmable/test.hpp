@@ -0,0 +1,9 @@
+#pragma once
+
+namespace tests::trimmable {
+void trim_registered_objects();
+void trim_node_allocator();
+void trim_buffer_pool();
+void watch_stand_in_events();
+void trim_on_allocation_failure();
+}  // namespace tests::trimmable
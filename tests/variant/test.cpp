@@ -0,0 +1,160 @@
+#include "test.hpp"
+
+#include <test_runner.hpp>
+
+#include <type_traits.hpp>
+#include <variant.hpp>
+
+#include <ntddk.h>
+
+using namespace ktl;
+
+namespace tests::variant {
+namespace details {
+struct tracked {
+  explicit tracked(int val) noexcept : value{val} { ++alive; }
+  tracked(const tracked& other) noexcept : value{other.value} { ++alive; }
+  tracked& operator=(const tracked&) noexcept = default;
+  ~tracked() noexcept { --alive; }
+
+  bool operator==(const tracked& other) const noexcept {
+    return value == other.value;
+  }
+
+  int value;
+  static inline int alive{0};
+};
+
+struct throwing {
+  explicit throwing(int) { throw_exception<invalid_argument>("test"); }
+};
+
+struct request_header {
+  uint32_t id;
+  uint32_t length;
+};
+
+using trivial_type = ktl::variant<uint32_t, float, request_header>;
+using tracking_type = ktl::variant<monostate, int, tracked>;
+
+static_assert(sizeof(trivial_type) == 12);
+static_assert(sizeof(ktl::variant<uint8_t, bool>) == 2);
+static_assert(is_trivially_copyable_v<trivial_type>);
+static_assert(is_trivially_destructible_v<trivial_type>);
+static_assert(!is_trivially_destructible_v<tracking_type>);
+
+struct size_visitor {
+  size_t operator()(uint32_t) const noexcept { return sizeof(uint32_t); }
+  size_t operator()(float) const noexcept { return sizeof(float); }
+  size_t operator()(const request_header& header) const noexcept {
+    return header.length;
+  }
+};
+}  // namespace details
+
+void hold_alternatives() {
+  using namespace details;
+
+  trivial_type value;
+  ASSERT_EQ(value.index(), size_t{0})
+  ASSERT_EQ(get<uint32_t>(value), uint32_t{0})
+
+  value = 1.5f;
+  ASSERT_VALUE(holds_alternative<float>(value))
+  ASSERT_VALUE(get_if<uint32_t>(&value) == nullptr)
+  ASSERT_VALUE(*get_if<1>(&value) == 1.5f)
+
+  value.emplace<request_header>(request_header{7, 64});
+  ASSERT_EQ(value.index(), size_t{2})
+  ASSERT_EQ(get<2>(value).length, uint32_t{64})
+
+  bool thrown{false};
+  try {
+    [[maybe_unused]] const float number{get<float>(value)};
+  } catch ([[maybe_unused]] const bad_variant_access& exc) {
+    thrown = true;
+  }
+  ASSERT_VALUE(thrown)
+
+  constexpr ktl::variant<int, float> number{2.5f};
+  static_assert(number.index() == 1);
+}
+
+void copy_and_assign() {
+  using namespace details;
+  {
+    tracking_type value{in_place_type<tracked>, 5};
+    ASSERT_EQ(tracked::alive, 1)
+
+    tracking_type copy{value};
+    ASSERT_EQ(tracked::alive, 2)
+    ASSERT_VALUE(copy == value)
+
+    value = 3;
+    ASSERT_EQ(tracked::alive, 1)
+    ASSERT_VALUE(copy != value)
+
+    swap(value, copy);
+    ASSERT_EQ(get<tracked>(value).value, 5)
+    ASSERT_EQ(get<int>(copy), 3)
+    ASSERT_EQ(tracked::alive, 1)
+
+    copy = value;
+    ASSERT_EQ(tracked::alive, 2)
+    value = monostate{};
+    ASSERT_EQ(tracked::alive, 1)
+  }
+  ASSERT_EQ(tracked::alive, 0)
+}
+
+void visit_alternatives() {
+  using namespace details;
+
+  const trivial_type messages[]{uint32_t{1}, 2.0f, request_header{1, 100}};
+  size_t total{0};
+  for (const auto& message : messages) {
+    total += visit(size_visitor{}, message);
+  }
+  ASSERT_EQ(total, size_t{108})
+
+  ktl::variant<int, char> lhs{'a'};
+  visit([](auto& target) { ++target; }, lhs);
+  ASSERT_EQ(get<char>(lhs), 'b')
+
+  // The table has an entry for each of the 4 combinations
+  const ktl::variant<int, double> rhs{0.5};
+  const auto sizes{visit(
+      [](auto first, auto second) {
+        return sizeof(first) * 10 + sizeof(second);
+      },
+      lhs, rhs)};
+  ASSERT_EQ(sizes, size_t{18})
+}
+
+void become_valueless_on_exception() {
+  using namespace details;
+
+  ktl::variant<tracked, throwing> value{in_place_index<0>, 1};
+  bool thrown{false};
+  try {
+    value.emplace<throwing>(0);
+  } catch ([[maybe_unused]] const invalid_argument& exc) {
+    thrown = true;
+  }
+  ASSERT_VALUE(thrown)
+  ASSERT_VALUE(value.valueless_by_exception())
+  ASSERT_EQ(value.index(), variant_npos)
+  ASSERT_EQ(tracked::alive, 0)
+
+  thrown = false;
+  try {
+    visit([](const auto&) {}, value);
+  } catch ([[maybe_unused]] const bad_variant_access& exc) {
+    thrown = true;
+  }
+  ASSERT_VALUE(thrown)
+
+  value.emplace<tracked>(2);
+  ASSERT_EQ(get<0>(value).value, 2)
+}
+}  // namespace tests::variant
@@ -0,0 +1,8 @@
+#pragma once
+
+namespace tests::variant {
+void hold_alternatives();
+void copy_and_assign();
+void visit_alternatives();
+void become_valueless_on_exception();
+}  // namespace tests::variant